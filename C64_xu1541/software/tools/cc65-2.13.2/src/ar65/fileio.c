@@ -120,19 +120,29 @@ void WriteData (FILE* F, const void* Data, unsigned Size)
 
 
 
-unsigned Read8 (FILE* F)
+void FileSetPos (FileMap* F, unsigned long Pos)
+/* Seek to the given absolute position, fail on errors */
+{
+    if (Pos > F->Size) {
+ 	Error ("Cannot seek: Position %lu is beyond end of file", Pos);
+    }
+    F->Pos = Pos;
+}
+
+
+
+unsigned Read8 (FileMap* F)
 /* Read an 8 bit value from the file */
 {
-    int C = getc (F);
-    if (C == EOF) {
+    if (F->Pos >= F->Size) {
  	Error ("Read error (file corrupt?)");
     }
-    return C;
+    return F->Data[F->Pos++];
 }
 
 
 
-unsigned Read16 (FILE* F)
+unsigned Read16 (FileMap* F)
 /* Read a 16 bit value from the file */
 {
     unsigned Lo = Read8 (F);
@@ -142,7 +152,7 @@ unsigned Read16 (FILE* F)
 
 
 
-unsigned long Read32 (FILE* F)
+unsigned long Read32 (FileMap* F)
 /* Read a 32 bit value from the file */
 {
     unsigned long Lo = Read16 (F);
@@ -152,7 +162,7 @@ unsigned long Read32 (FILE* F)
 
 
 
-unsigned long ReadVar (FILE* F)
+unsigned long ReadVar (FileMap* F)
 /* Read a variable size value from the file */
 {
     /* The value was written to the file in 7 bit chunks LSB first. If there
@@ -176,7 +186,7 @@ unsigned long ReadVar (FILE* F)
 
 
 
-char* ReadStr (FILE* F)
+char* ReadStr (FileMap* F)
 /* Read a string from the file (the memory will be malloc'ed) */
 {
     /* Read the length */
@@ -193,12 +203,28 @@ char* ReadStr (FILE* F)
 
 
 
-void* ReadData (FILE* F, void* Data, unsigned Size)
+void* ReadData (FileMap* F, void* Data, unsigned Size)
 /* Read data from the file */
 {
-    if (fread (Data, 1, Size, F) != Size) {
+    /* Explicitly allow reading zero bytes */
+    if (Size > 0) {
+	memcpy (Data, MapData (F, Size), Size);
+    }
+    return Data;
+}
+
+
+
+const void* MapData (FileMap* F, unsigned long Size)
+/* Return a pointer to the next Size bytes of the file and skip them. The
+ * pointer is valid as long as the file is open.
+ */
+{
+    const unsigned char* Data = F->Data + F->Pos;
+    if (Size > F->Size - F->Pos) {
 	Error ("Read error (file corrupt?)");
     }
+    F->Pos += Size;
     return Data;
 }
 
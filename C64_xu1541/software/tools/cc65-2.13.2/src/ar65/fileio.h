@@ -40,6 +40,9 @@
 
 #include <stdio.h>
 
+/* common */
+#include "filemap.h"
+
 
 
 /*****************************************************************************/
@@ -66,24 +69,32 @@ void WriteStr (FILE* F, const char* S);
 void WriteData (FILE* F, const void* Data, unsigned Size);
 /* Write data to the file */
 
-unsigned Read8 (FILE* F);
+void FileSetPos (FileMap* F, unsigned long Pos);
+/* Seek to the given absolute position, fail on errors */
+
+unsigned Read8 (FileMap* F);
 /* Read an 8 bit value from the file */
 
-unsigned Read16 (FILE* F);
+unsigned Read16 (FileMap* F);
 /* Read a 16 bit value from the file */
 
-unsigned long Read32 (FILE* F);
+unsigned long Read32 (FileMap* F);
 /* Read a 32 bit value from the file */
 
-unsigned long ReadVar (FILE* F);
+unsigned long ReadVar (FileMap* F);
 /* Read a variable size value from the file */
 
-char* ReadStr (FILE* F);
+char* ReadStr (FileMap* F);
 /* Read a string from the file (the memory will be malloc'ed) */
 
-void* ReadData (FILE* F, void* Data, unsigned Size);
+void* ReadData (FileMap* F, void* Data, unsigned Size);
 /* Read data from the file */
 
+const void* MapData (FileMap* F, unsigned long Size);
+/* Return a pointer to the next Size bytes of the file and skip them. The
+ * pointer is valid as long as the file is open.
+ */
+
 
 
 /* End of fileio.h */
@@ -40,6 +40,7 @@
 /* common */
 #include "bitops.h"
 #include "exprdefs.h"
+#include "filemap.h"
 #include "filepos.h"
 #include "libdefs.h"
 #include "print.h"
@@ -53,6 +54,7 @@
 #include "objdata.h"
 #include "exports.h"
 #include "library.h"
+#include "objfile.h"
 
 
 
@@ -64,7 +66,7 @@
 
 /* File descriptor for the library file */
 FILE*			NewLib = 0;
-static FILE* 		Lib = 0;
+static FileMap*		Lib = 0;
 static const char*	LibName = 0;
 
 /* The library header */
@@ -87,7 +89,7 @@ static void ReadHeader (void)
 /* Read the header of a library file */
 {
     /* Seek to position zero */
-    fseek (Lib, 0, SEEK_SET);
+    FileSetPos (Lib, 0);
 
     /* Read the header fields, checking magic and version */
     Header.Magic   = Read32 (Lib);
@@ -145,7 +147,7 @@ static void ReadIndex (void)
     unsigned Count;
 
     /* Seek to the start of the index */
-    fseek (Lib, Header.IndexOffs, SEEK_SET);
+    FileSetPos (Lib, Header.IndexOffs);
 
     /* Read the object file count and calculate the cross ref size */
     Count = ReadVar (Lib);
@@ -248,7 +250,7 @@ void LibOpen (const char* Name, int MustExist, int NeedTemp)
     LibName = xstrdup (Name);
 
     /* Open the existing library for reading */
-    Lib = fopen (Name, "rb");
+    Lib = FMapOpen (Name);
     if (Lib == 0) {
 
        	/* File does not exist */
@@ -282,23 +284,16 @@ void LibOpen (const char* Name, int MustExist, int NeedTemp)
 
 
 
-unsigned long LibCopyTo (FILE* F, unsigned long Bytes)
-/* Copy data from F to the temp library file, return the start position in
- * the temporary library file.
+unsigned long LibCopyTo (FileMap* F, unsigned long Bytes)
+/* Copy data from the current position of F to the temp library file, return
+ * the start position in the temporary library file.
  */
 {
-    unsigned char Buf [4096];
-
     /* Remember the position */
     unsigned long Pos = ftell (NewLib);
 
-    /* Copy loop */
-    while (Bytes) {
-    	unsigned Count = (Bytes > sizeof (Buf))? sizeof (Buf) : Bytes;
-    	ReadData (F, Buf, Count);
-    	WriteData (NewLib, Buf, Count);
-    	Bytes -= Count;
-    }
+    /* Write the data directly from the mapped file */
+    WriteData (NewLib, MapData (F, Bytes), Bytes);
 
     /* Return the start position */
     return Pos;
@@ -309,18 +304,20 @@ unsigned long LibCopyTo (FILE* F, unsigned long Bytes)
 void LibCopyFrom (unsigned long Pos, unsigned long Bytes, FILE* F)
 /* Copy data from the library file into another file */
 {
-    unsigned char Buf [4096];
-
     /* Seek to the correct position */
-    fseek (Lib, Pos, SEEK_SET);
-
-    /* Copy loop */
-    while (Bytes) {
-    	unsigned Count = (Bytes > sizeof (Buf))? sizeof (Buf) : Bytes;
-    	ReadData (Lib, Buf, Count);
-    	WriteData (F, Buf, Count);
-    	Bytes -= Count;
-    }
+    FileSetPos (Lib, Pos);
+
+    /* Write the data directly from the mapped file */
+    WriteData (F, MapData (Lib, Bytes), Bytes);
+}
+
+
+
+void LibReadObjHeader (unsigned long Pos, ObjHeader* H, const char* Name)
+/* Read the header of the object file at Pos in the library file */
+{
+    FileSetPos (Lib, Pos);
+    ObjReadHeader (Lib, H, Name);
 }
 
 
@@ -451,6 +448,7 @@ void LibClose (void)
 	unsigned I;
 	unsigned char Buf [4096];
 	size_t Count;
+	FILE* Out;
 
 	/* Index the object files and make an array containing the objects */
 	MakeObjPool ();
@@ -470,7 +468,7 @@ void LibClose (void)
 	    /* Copy data if needed */
 	    if ((O->Flags & OBJ_HAVEDATA) == 0) {
 	 	/* Data is still in the old library */
-	 	fseek (Lib, O->Start, SEEK_SET);
+	 	FileSetPos (Lib, O->Start);
 	 	O->Start = ftell (NewLib);
 	 	LibCopyTo (Lib, O->Size);
 	 	O->Flags |= OBJ_HAVEDATA;
@@ -483,14 +481,15 @@ void LibClose (void)
 	/* Write the updated header */
 	WriteHeader ();
 
-	/* Close the file */
-	if (Lib && fclose (Lib) != 0) {
-	    Error ("Error closing library: %s", strerror (errno));
+	/* Unmap the old library, it is overwritten now */
+	if (Lib) {
+	    FMapClose (Lib);
+	    Lib = 0;
 	}
 
 	/* Reopen the library and truncate it */
-	Lib = fopen (LibName, "wb");
-	if (Lib == 0) {
+	Out = fopen (LibName, "wb");
+	if (Out == 0) {
 	    Error ("Cannot open library `%s' for writing: %s",
 		   LibName, strerror (errno));
 	}
@@ -498,15 +497,18 @@ void LibClose (void)
 	/* Copy the new library to the new one */
 	fseek (NewLib, 0, SEEK_SET);
 	while ((Count = fread (Buf, 1, sizeof (Buf), NewLib)) != 0) {
-	    if (fwrite (Buf, 1, Count, Lib) != Count) {
+	    if (fwrite (Buf, 1, Count, Out) != Count) {
 		Error ("Cannot write to `%s': %s", LibName, strerror (errno));
 	    }
 	}
+	if (fclose (Out) != 0) {
+	    Error ("Problem closing `%s': %s", LibName, strerror (errno));
+	}
     }
 
     /* Close both files */
-    if (Lib && fclose (Lib) != 0) {
-     	Error ("Problem closing `%s': %s", LibName, strerror (errno));
+    if (Lib) {
+	FMapClose (Lib);
     }
     if (NewLib && fclose (NewLib) != 0) {
      	Error ("Problem closing temporary library file: %s", strerror (errno));
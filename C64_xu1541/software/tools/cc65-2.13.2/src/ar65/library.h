@@ -40,6 +40,10 @@
 
 #include <stdio.h>
 
+/* common */
+#include "filemap.h"
+#include "objdefs.h"
+
 
 
 /*****************************************************************************/
@@ -65,14 +69,17 @@ void LibOpen (const char* Name, int MustExist, int NeedTemp);
  * is created.
  */
 
-unsigned long LibCopyTo (FILE* F, unsigned long Bytes);
-/* Copy data from F to the temp library file, return the start position in
- * the temporary library file.
+unsigned long LibCopyTo (FileMap* F, unsigned long Bytes);
+/* Copy data from the current position of F to the temp library file, return
+ * the start position in the temporary library file.
  */
 
 void LibCopyFrom (unsigned long Pos, unsigned long Bytes, FILE* F);
 /* Copy data from the library file into another file */
 
+void LibReadObjHeader (unsigned long Pos, ObjHeader* H, const char* Name);
+/* Read the header of the object file at Pos in the library file */
+
 void LibClose (void);  
 /* Write remaining data, close both files and copy the temp file to the old
  * filename
@@ -83,7 +83,7 @@ static const char* GetModule (const char* Name)
 
 
 
-void ObjReadHeader (FILE* Obj, ObjHeader* H, const char* Name)
+void ObjReadHeader (FileMap* Obj, ObjHeader* H, const char* Name)
 /* Read the header of the object file checking the signature */
 {
     H->Magic	  = Read32 (Obj);
@@ -159,7 +159,7 @@ void ObjAdd (const char* Name)
     unsigned I;
 
     /* Open the object file */
-    FILE* Obj = fopen (Name, "rb");
+    FileMap* Obj = FMapOpen (Name);
     if (Obj == 0) {
 	Error ("Could not open `%s': %s", Name, strerror (errno));
     }
@@ -206,13 +206,13 @@ void ObjAdd (const char* Name)
     O->Exports	  = xmalloc (O->ExportSize);
 
     /* Read imports and exports */
-    fseek (Obj, H.ImportOffs, SEEK_SET);
+    FileSetPos (Obj, H.ImportOffs);
     ReadData (Obj, O->Imports, O->ImportSize);
-    fseek (Obj, H.ExportOffs, SEEK_SET);
+    FileSetPos (Obj, H.ExportOffs);
     ReadData (Obj, O->Exports, O->ExportSize);
 
     /* Read the string pool */
-    fseek (Obj, H.StrPoolOffs, SEEK_SET);
+    FileSetPos (Obj, H.StrPoolOffs);
     O->StringCount = ReadVar (Obj);
     O->Strings     = xmalloc (O->StringCount * sizeof (char*));
     for (I = 0; I < O->StringCount; ++I) {
@@ -224,19 +224,19 @@ void ObjAdd (const char* Name)
     fseek (NewLib, OBJ_HDR_SIZE, SEEK_CUR);
 
     /* Copy the remaining sections */
-    fseek (Obj, H.DbgSymOffs, SEEK_SET);
+    FileSetPos (Obj, H.DbgSymOffs);
     H.DbgSymOffs = LibCopyTo (Obj, H.DbgSymSize) - O->Start;
-    fseek (Obj, H.OptionOffs, SEEK_SET);
+    FileSetPos (Obj, H.OptionOffs);
     H.OptionOffs = LibCopyTo (Obj, H.OptionSize) - O->Start;
-    fseek (Obj, H.SegOffs, SEEK_SET);
+    FileSetPos (Obj, H.SegOffs);
     H.SegOffs = LibCopyTo (Obj, H.SegSize) - O->Start;
-    fseek (Obj, H.FileOffs, SEEK_SET);
+    FileSetPos (Obj, H.FileOffs);
     H.FileOffs = LibCopyTo (Obj, H.FileSize) - O->Start;
-    fseek (Obj, H.LineInfoOffs, SEEK_SET);
+    FileSetPos (Obj, H.LineInfoOffs);
     H.LineInfoOffs = LibCopyTo (Obj, H.LineInfoSize) - O->Start;
-    fseek (Obj, H.AssertOffs, SEEK_SET);
+    FileSetPos (Obj, H.AssertOffs);
     H.AssertOffs = LibCopyTo (Obj, H.AssertSize) - O->Start;
-    fseek (Obj, H.ScopeOffs, SEEK_SET);
+    FileSetPos (Obj, H.ScopeOffs);
     H.ScopeOffs = LibCopyTo (Obj, H.ScopeSize) - O->Start;
 
     /* Calculate the amount of data written */
@@ -254,8 +254,8 @@ void ObjAdd (const char* Name)
     /* Now seek again to end of file */
     fseek (NewLib, 0, SEEK_END);
 
-    /* Done, close the file (we read it only, so no error check) */
-    fclose (Obj);
+    /* Done, close the file */
+    FMapClose (Obj);
 }
 
 
@@ -306,9 +306,8 @@ void ObjExtract (const char* Name)
     }
     StrPoolSize = ftell (Obj) - StrPoolStart;
 
-    /* Seek back and read the header */
-    fseek (Obj, 0, SEEK_SET);
-    ObjReadHeader (Obj, &H, Name);
+    /* Read the header from the library */
+    LibReadObjHeader (O->Start, &H, Name);
 
     /* Update the header fields */
     H.ImportOffs  = ImportStart;
@@ -40,6 +40,7 @@
 
 #include <stdio.h>
 
+#include "../common/filemap.h"
 #include "../common/objdefs.h"
 
 
@@ -50,7 +51,7 @@
 
 
 
-void ObjReadHeader (FILE* Obj, ObjHeader* H, const char* Name);
+void ObjReadHeader (FileMap* Obj, ObjHeader* H, const char* Name);
 /* Read the header of the object file checking the signature */
 
 void ObjWriteHeader (FILE* Obj, ObjHeader* H);
@@ -429,33 +429,26 @@ static ExprNode* DoMatch (enum TC EqualityLevel)
 /* Handle the .MATCH and .XMATCH builtin functions */
 {
     int Result;
-    TokNode* Root = 0;
-    TokNode* Last = 0;
-    TokNode* Node;
+    unsigned Index;
+    TokList* List;
 
-    /* A list of tokens follows. Read this list and remember it building a
-     * single linked list of tokens including attributes. The list is
-     * either enclosed in curly braces, or terminated by a comma.
+    /* A list of tokens follows. Read this list and remember it in a token
+     * list including attributes. The list is either enclosed in curly
+     * braces, or terminated by a comma.
      */
     Token Term = GetTokListTerm (TOK_COMMA);
+    List = NewTokList ();
     while (Tok != Term) {
 
     	/* We may not end-of-line of end-of-file here */
     	if (TokIsSep (Tok)) {
     	    Error ("Unexpected end of line");
+	    FreeTokList (List);
     	    return GenLiteral0 ();
     	}
 
-	/* Get a node with this token */
-	Node = NewTokNode ();
-
-	/* Insert the node into the list */
-	if (Last == 0) {
-       	    Root = Node;
-	} else {
-	    Last->Next = Node;
-	}
-	Last = Node;
+	/* Remember the token */
+	AddCurTok (List);
 
 	/* Skip the token */
 	NextTok ();
@@ -475,30 +468,29 @@ static ExprNode* DoMatch (enum TC EqualityLevel)
      */
     Term = GetTokListTerm (TOK_RPAREN);
     Result = 1;
-    Node = Root;
+    Index = 0;
     while (Tok != Term) {
 
     	/* We may not end-of-line of end-of-file here */
     	if (TokIsSep (Tok)) {
     	    Error ("Unexpected end of line");
+	    FreeTokList (List);
     	    return GenLiteral0 ();
     	}
 
        	/* Compare the tokens if the result is not already known */
 	if (Result != 0) {
-	    if (Node == 0) {
+	    if (Index >= List->Count) {
 		/* The second list is larger than the first one */
 		Result = 0;
-	    } else if (TokCmp (Node) < EqualityLevel) {
+	    } else if (TokCmp (List->Tokens + Index) < EqualityLevel) {
 	 	/* Tokens do not match */
 	 	Result = 0;
 	    }
 	}
 
 	/* Next token in first list */
-	if (Node) {
-	    Node = Node->Next;
-	}
+	++Index;
 
        	/* Next token in current list */
 	NextTok ();
@@ -510,16 +502,12 @@ static ExprNode* DoMatch (enum TC EqualityLevel)
     }
 
     /* Check if there are remaining tokens in the first list */
-    if (Node != 0) {
+    if (Index < List->Count) {
 	Result = 0;
     }
 
     /* Free the token list */
-    while (Root) {
-	Node = Root;
-	Root = Root->Next;
-	FreeTokNode (Node);
-    }
+    FreeTokList (List);
 
     /* Done, return the result */
     return GenLiteralExpr (Result);
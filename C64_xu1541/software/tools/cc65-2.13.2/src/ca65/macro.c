@@ -102,9 +102,7 @@ struct Macro {
     IdDesc*  	    Locals;	/* List of local symbols */
     unsigned 	    ParamCount;	/* Parameter count of macro */
     IdDesc*    	    Params;	/* Identifiers of macro parameters */
-    unsigned 	    TokCount;	/* Number of tokens for this macro */
-    TokNode* 	    TokRoot;	/* Root of token list */
-    TokNode* 	    TokLast;	/* Pointer to last token in list */
+    TokList         Toks;       /* Tokens of the macro body */
     unsigned char   Style;	/* Macro style */
     StrBuf          Name;	/* Macro name, dynamically allocated */
 };
@@ -129,12 +127,14 @@ struct MacExp {
     MacExp*  	Next;		/* Pointer to next expansion */
     Macro*   	M;  	  	/* Which macro do we expand? */
     unsigned 	IfSP;		/* .IF stack pointer at start of expansion */
-    TokNode*   	Exp;		/* Pointer to current token */
+    unsigned   	Exp;		/* Index of current token */
     TokNode* 	Final;		/* Pointer to final token */
     unsigned    LocalStart;	/* Start of counter for local symbol names */
     unsigned 	ParamCount;	/* Number of actual parameters */
-    TokNode**	Params;	  	/* List of actual parameters */
-    TokNode* 	ParamExp;	/* Node for expanding parameters */
+    TokList     ParamToks;      /* Tokens of all actual parameters */
+    unsigned*	Params;	  	/* Start of each parameter in ParamToks */
+    unsigned 	ParamExp;	/* Index of next parameter token to expand */
+    unsigned 	ParamEnd;	/* End of the parameter being expanded */
 };
 
 /* Number of active macro expansions */
@@ -224,9 +224,7 @@ static Macro* NewMacro (const StrBuf* Name, unsigned char Style)
     M->Locals     = 0;
     M->ParamCount = 0;
     M->Params     = 0;
-    M->TokCount	  = 0;
-    M->TokRoot    = 0;
-    M->TokLast    = 0;
+    InitTokList (&M->Toks);
     M->Style	  = Style;
     M->Name       = AUTO_STRBUF_INITIALIZER;
     SB_Copy (&M->Name, Name);
@@ -255,14 +253,16 @@ static MacExp* NewMacExp (Macro* M)
     /* Initialize the data */
     E->M       	  = M;
     E->IfSP	  = GetIfStack ();
-    E->Exp     	  = M->TokRoot;
+    E->Exp     	  = 0;
     E->Final	  = 0;
     E->LocalStart = LocalName;
     LocalName    += M->LocalCount;
     E->ParamCount = 0;
-    E->Params     = xmalloc (M->ParamCount * sizeof (TokNode*));
+    InitTokList (&E->ParamToks);
+    E->Params     = xmalloc ((M->ParamCount + 1) * sizeof (unsigned));
     E->ParamExp	  = 0;
-    for (I = 0; I < M->ParamCount; ++I) {
+    E->ParamEnd	  = 0;
+    for (I = 0; I <= M->ParamCount; ++I) {
 	E->Params [I] = 0;
     }
 
@@ -278,27 +278,15 @@ static MacExp* NewMacExp (Macro* M)
 static void FreeMacExp (MacExp* E)
 /* Remove and free the current macro expansion */
 {
-    unsigned I;
-
     /* One macro expansion less */
     --MacExpansions;
 
-    /* Free the parameter lists */
-    for (I = 0; I < E->ParamCount; ++I) {
-        /* Free one parameter list */
-        TokNode* N = E->Params[I];
-        while (N) {
-            TokNode* P = N->Next;
-            FreeTokNode (N);
-            N = P;
-        }
-    }
+    /* Free the parameter tokens */
+    DoneTokList (&E->ParamToks);
     xfree (E->Params);
 
-    /* Free the final token if we have one */
-    if (E->Final) {
-      	FreeTokNode (E->Final);
-    }
+    /* Free the final token */
+    xfree (E->Final);
 
     /* Free the structure itself */
     xfree (E);
@@ -327,6 +315,38 @@ static void MacSkipDef (unsigned Style)
 
 
 
+static void MacResolveLocals (Macro* M)
+/* Search all identifiers of the macro body in the list of local symbols. For
+ * identifiers that are local symbols, store the index of the symbol in the
+ * integer attribute of the token, for all others store -1. This way, the
+ * local symbols are searched once per macro and not once per expansion.
+ */
+{
+    unsigned I;
+    for (I = 0; I < M->Toks.Count; ++I) {
+
+	TokNode* T = M->Toks.Tokens + I;
+	if (T->Tok == TOK_IDENT || T->Tok == TOK_LOCAL_IDENT) {
+
+	    /* Search for the local symbol in the list */
+	    const StrBuf* Name = GetTokStrBuf (T->SVal);
+	    unsigned Index = 0;
+	    IdDesc* L = M->Locals;
+	    T->IVal = -1;
+	    while (L) {
+		if (SB_Compare (Name, &L->Id) == 0) {
+		    T->IVal = Index;
+		    break;
+		}
+		++Index;
+		L = L->Next;
+	    }
+	}
+    }
+}
+
+
+
 void MacDef (unsigned Style)
 /* Parse a macro definition */
 {
@@ -488,8 +508,8 @@ void MacDef (unsigned Style)
      	    continue;
      	}
 
-     	/* Create a token node for the current token */
-     	T = NewTokNode ();
+     	/* Add the current token to the macro body */
+     	T = AddCurTok (&M->Toks);
 
      	/* If the token is an ident, check if it is a local parameter */
      	if (Tok == TOK_IDENT) {
@@ -507,17 +527,6 @@ void MacDef (unsigned Style)
      	    }
      	}
 
-     	/* Insert the new token in the list */
-     	if (M->TokCount == 0) {
-     	    /* First token */
-     	    M->TokRoot = M->TokLast = T;
-     	} else {
-     	    /* We have already tokens */
-     	    M->TokLast->Next = T;
-     	    M->TokLast = T;
-     	}
-     	++M->TokCount;
-
      	/* Read the next token */
      	NextTok ();
     }
@@ -528,6 +537,11 @@ void MacDef (unsigned Style)
     }
 
 Done:
+    /* Resolve the local symbols of the macro body */
+    if (M->LocalCount) {
+	MacResolveLocals (M);
+    }
+
     /* Switch out of raw token mode */
     LeaveRawTokenMode ();
 }
@@ -559,13 +573,10 @@ static int MacExpand (void* Data)
     /* We're expanding a macro. Check if we are expanding one of the
      * macro parameters.
      */
-    if (Mac->ParamExp) {
+    if (Mac->ParamExp < Mac->ParamEnd) {
 
-       	/* Ok, use token from parameter list */
-       	TokSet (Mac->ParamExp);
-
-       	/* Set pointer to next token */
-       	Mac->ParamExp = Mac->ParamExp->Next;
+       	/* Ok, use token from parameter list and skip it */
+       	TokSet (Mac->ParamToks.Tokens + Mac->ParamExp++);
 
        	/* Done */
        	return 1;
@@ -575,13 +586,10 @@ static int MacExpand (void* Data)
     /* We're not expanding macro parameters. Check if we have tokens left from
      * the macro itself.
      */
-    if (Mac->Exp) {
-
-       	/* Use next macro token */
-       	TokSet (Mac->Exp);
+    if (Mac->Exp < Mac->M->Toks.Count) {
 
-       	/* Set pointer to next token */
-       	Mac->Exp = Mac->Exp->Next;
+       	/* Use next macro token and skip it */
+       	TokSet (Mac->M->Toks.Tokens + Mac->Exp++);
 
        	/* Is it a request for actual parameter count? */
        	if (Tok == TOK_PARAMCOUNT) {
@@ -593,43 +601,38 @@ static int MacExpand (void* Data)
        	/* Is it the name of a macro parameter? */
        	if (Tok == TOK_MACPARAM) {
 
-       	    /* Start to expand the parameter token list */
-       	    Mac->ParamExp = Mac->Params [IVal];
+       	    /* Start to expand the parameter token list. Parameters that
+	     * were not given are empty.
+	     */
+	    if (IVal < (long) Mac->ParamCount) {
+		Mac->ParamExp = Mac->Params [IVal];
+		Mac->ParamEnd = Mac->Params [IVal+1];
+	    }
 
        	    /* Recursive call to expand the parameter */
        	    return MacExpand (Mac);
        	}
 
-       	/* If it's an identifier, it may in fact be a local symbol */
-       	if ((Tok == TOK_IDENT || Tok == TOK_LOCAL_IDENT) && Mac->M->LocalCount) {
-       	    /* Search for the local symbol in the list */
-       	    unsigned Index = 0;
-       	    IdDesc* I = Mac->M->Locals;
-       	    while (I) {
-       	       	if (SB_Compare (&SVal, &I->Id) == 0) {
-       	       	    /* This is in fact a local symbol, change the name. Be sure
-                     * to generate a local label name if the original name was
-                     * a local label, and also generate a name that cannot be
-                     * generated by a user.
-                     */
-                    if (SB_At (&I->Id, 0) == LocalStart) {
-                        /* Must generate a local symbol */
-                        SB_Printf (&SVal, "%cLOCAL-MACRO_SYMBOL-%04X",
-                                   LocalStart, Mac->LocalStart + Index);
-                    } else {
-                        /* Global symbol */
-                        SB_Printf (&SVal, "LOCAL-MACRO_SYMBOL-%04X",
-                                   Mac->LocalStart + Index);
-                    }
-       	       	    break;
-       	       	}
-       	       	/* Next symbol */
-       	       	++Index;
-       	       	I = I->Next;
-       	    }
-
-       	    /* Done */
-       	    return 1;
+       	/* If it's an identifier, it may in fact be a local symbol. The index
+	 * of the symbol in the list of locals was stored when the macro was
+	 * defined.
+	 */
+       	if ((Tok == TOK_IDENT || Tok == TOK_LOCAL_IDENT) &&
+	    Mac->M->LocalCount && IVal >= 0) {
+	    /* This is in fact a local symbol, change the name. Be sure
+	     * to generate a local label name if the original name was
+	     * a local label, and also generate a name that cannot be
+	     * generated by a user.
+	     */
+	    unsigned Index = Mac->LocalStart + (unsigned) IVal;
+	    if (SB_At (&SVal, 0) == LocalStart) {
+		/* Must generate a local symbol */
+		SB_Printf (&SVal, "%cLOCAL-MACRO_SYMBOL-%04X",
+			   LocalStart, Index);
+	    } else {
+		/* Global symbol */
+		SB_Printf (&SVal, "LOCAL-MACRO_SYMBOL-%04X", Index);
+	    }
        	}
 
        	/* The token was successfully set */
@@ -642,7 +645,7 @@ static int MacExpand (void* Data)
 
       	/* Set the final token and remove it */
       	TokSet (Mac->Final);
-      	FreeTokNode (Mac->Final);
+      	xfree (Mac->Final);
       	Mac->Final = 0;
 
        	/* The token was successfully set */
@@ -679,8 +682,6 @@ static void StartExpClassic (Macro* M)
     /* Read the actual parameters */
     while (!TokIsSep (Tok)) {
 
-	TokNode* Last;
-
        	/* Check for maximum parameter count */
 	if (E->ParamCount >= M->ParamCount) {
        	    ErrorSkip ("Too many macro parameters");
@@ -691,11 +692,8 @@ static void StartExpClassic (Macro* M)
         Term = GetTokListTerm (TOK_COMMA);
 
        	/* Read tokens for one parameter, accept empty params */
-	Last = 0;
 	while (Tok != Term && Tok != TOK_SEP) {
 
-	    TokNode* T;
-
 	    /* Check for end of file */
 	    if (Tok == TOK_EOF) {
 	     	Error ("Unexpected end of file");
@@ -703,23 +701,15 @@ static void StartExpClassic (Macro* M)
 	     	return;
 	    }
 
-	    /* Get the next token in a node */
-	    T = NewTokNode ();
-
-	    /* Insert it into the list */
-	    if (Last == 0) {
-	      	E->Params [E->ParamCount] = T;
-	    } else {
-	     	Last->Next = T;
-	    }
-	    Last = T;
+	    /* Add the token to the parameter tokens */
+	    AddCurTok (&E->ParamToks);
 
 	    /* And skip it... */
 	    NextTok ();
 	}
 
 	/* One parameter more */
-	++E->ParamCount;
+	E->Params [++E->ParamCount] = E->ParamToks.Count;
 
         /* If the macro argument was enclosed in curly braces, end-of-line
          * is an error. Skip the closing curly brace.
@@ -766,8 +756,6 @@ static void StartExpDefine (Macro* M)
     /* Read the actual parameters */
     while (Count--) {
 
-       	TokNode*   Last;
-
         /* The macro may optionally be enclosed in curly braces */
         Token Term = GetTokListTerm (TOK_COMMA);
 
@@ -779,21 +767,10 @@ static void StartExpDefine (Macro* M)
         }
 
        	/* Read tokens for one parameter */
-       	Last = 0;
        	do {
 
-       	    TokNode* T;
-
-       	    /* Get the next token in a node */
-       	    T = NewTokNode ();
-
-       	    /* Insert it into the list */
-       	    if (Last == 0) {
-       	    	E->Params [E->ParamCount] = T;
-       	    } else {
-       	    	Last->Next = T;
-       	    }
-       	    Last = T;
+       	    /* Add the token to the parameter tokens */
+       	    AddCurTok (&E->ParamToks);
 
 	    /* And skip it... */
 	    NextTok ();
@@ -801,7 +778,7 @@ static void StartExpDefine (Macro* M)
        	} while (Tok != Term && !TokIsSep (Tok));
 
 	/* One parameter more */
-	++E->ParamCount;
+	E->Params [++E->ParamCount] = E->ParamToks.Count;
 
         /* If the macro argument was enclosed in curly braces, end-of-line
          * is an error. Skip the closing curly brace.
@@ -829,7 +806,8 @@ static void StartExpDefine (Macro* M)
      * To avoid it, remember the current token and re-insert it, once macro
      * expansion is done.
      */
-    E->Final = NewTokNode ();
+    E->Final = xmalloc (sizeof (TokNode));
+    TokGet (E->Final);
 
     /* Insert a new token input function */
     PushInput (MacExpand, E, ".DEFINE");
@@ -891,3 +869,11 @@ int InMacExpansion (void)
 
 
 
+void MacPrintStats (void)
+/* Print statistics about the macro table in verbose mode */
+{
+    HT_PrintStats (&MacroTab, "Macros");
+}
+
+
+
@@ -74,6 +74,9 @@ int IsDefine (const StrBuf* Name);
 int InMacExpansion (void);
 /* Return true if we're currently expanding a macro */
 
+void MacPrintStats (void);
+/* Print statistics about the macro table in verbose mode */
+
 
 
 /* End of macro.h */
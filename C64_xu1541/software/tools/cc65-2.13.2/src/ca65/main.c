@@ -968,6 +968,9 @@ int main (int argc, char* argv [])
     /* If we didn't have an errors, index the line infos */
     MakeLineInfoIndex ();
 
+    /* Tell the user how well the macro table did */
+    MacPrintStats ();
+
     /* Dump the data */
     if (Verbosity >= 2) {
         SymDump (stdout);
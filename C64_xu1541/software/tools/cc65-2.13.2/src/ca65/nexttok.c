@@ -377,19 +377,12 @@ static void FuncRight (void)
     /* Read the complete token list */
     List = CollectTokens (0, 9999);
 
-    /* Delete tokens from the list until Count tokens are remaining */
-    while (List->Count > (unsigned) Count) {
-	/* Get the first node */
-	TokNode* T = List->Root;
-
-	/* Remove it from the list */
-	List->Root = List->Root->Next;
-
-	/* Free the node */
-	FreeTokNode (T);
-
-	/* Corrent the token counter */
-	List->Count--;
+    /* Delete tokens from the start of the list until Count tokens remain */
+    if (List->Count > (unsigned) Count) {
+	memmove (List->Tokens,
+		 List->Tokens + (List->Count - Count),
+		 Count * sizeof (TokNode));
+	List->Count = (unsigned) Count;
     }
 
     /* Since we want to insert the list before the now current token, we have
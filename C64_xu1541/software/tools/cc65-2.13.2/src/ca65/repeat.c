@@ -36,7 +36,7 @@
 #include <string.h>
 
 /* common */
-#include "xmalloc.h"
+#include "strbuf.h"
 
 /* ca65 */
 #include "error.h"
@@ -53,7 +53,7 @@
 
 
 
-static TokList* CollectRepeatTokens (void)
+static TokList* CollectRepeatTokens (const StrBuf* Name)
 /* Collect all tokens inside the .REPEAT body in a token list and return
  * this list. In case of errors, NULL is returned.
  */
@@ -65,6 +65,8 @@ static TokList* CollectRepeatTokens (void)
     unsigned Repeats = 0;
     while (Repeats != 0 || Tok != TOK_ENDREP) {
 
+	TokNode* T;
+
      	/* Check for end of input */
        	if (Tok == TOK_EOF) {
      	    Error ("Unexpected end of file");
@@ -72,17 +74,21 @@ static TokList* CollectRepeatTokens (void)
      	    return 0;
      	}
 
+       	/* Collect all tokens in the list */
+	T = AddCurTok (List);
+
 	/* If we find a token that is equal to the repeat counter name,
 	 * replace it by a REPCOUNTER token. This way we have to do strcmps
 	 * only once for each identifier, and not for each expansion.
-	 * Note: This will fail for nested repeats using the same repeat
-	 * counter name, but
+	 * Note: Nested repeats using the same repeat counter name will see
+	 * the counter of the outer repeat, since the tokens of the inner
+	 * body are replaced when the outer body is replayed.
 	 */
-
-
+	if (Tok == TOK_IDENT && Name != 0 && SB_Compare (&SVal, Name) == 0) {
+	    T->Tok = TOK_REPCOUNTER;
+	}
 
        	/* Collect all tokens in the list */
-	AddCurTok (List);
 
      	/* Check for and count nested .REPEATs */
      	if (Tok == TOK_REPEAT) {
@@ -105,11 +111,11 @@ static TokList* CollectRepeatTokens (void)
 
 
 static void RepeatTokenCheck (TokList* L)
-/* Called each time a token from a repeat token list is set. Is used to check
- * for and replace identifiers that are the repeat counter.
+/* Called each time a token from a repeat token list is set. Is used to
+ * replace the repeat counter tokens by the current counter value.
  */
 {
-    if (Tok == TOK_IDENT && L->Data != 0 && SB_CompareStr (&SVal, L->Data) == 0) {
+    if (Tok == TOK_REPCOUNTER) {
  	/* Must replace by the repeat counter */
  	Tok  = TOK_INTCON;
  	IVal = L->RepCount;
@@ -121,7 +127,8 @@ static void RepeatTokenCheck (TokList* L)
 void ParseRepeat (void)
 /* Parse and handle the .REPEAT statement */
 {
-    char* Name;
+    StrBuf Name = AUTO_STRBUF_INITIALIZER;
+    int HaveName;
     TokList* List;
 
     /* Repeat count follows */
@@ -132,7 +139,7 @@ void ParseRepeat (void)
     }
 
     /* Optional there is a comma and a counter variable */
-    Name = 0;
+    HaveName = 0;
     if (Tok == TOK_COMMA) {
 
        	/* Skip the comma */
@@ -143,8 +150,8 @@ void ParseRepeat (void)
        	    ErrorSkip ("Identifier expected");
        	} else {
        	    /* Remember the name and skip it */
-            SB_Terminate (&SVal);
-       	    Name = xstrdup (SB_GetConstBuf (&SVal));
+       	    SB_Copy (&Name, &SVal);
+       	    HaveName = 1;
        	    NextTok ();
        	}
     }
@@ -153,17 +160,18 @@ void ParseRepeat (void)
     ConsumeSep ();
 
     /* Read the token list */
-    List = CollectRepeatTokens ();
+    List = CollectRepeatTokens (HaveName? &Name : 0);
+
+    /* The counter name is no longer needed */
+    SB_Done (&Name);
 
     /* If we had an error, bail out */
     if (List == 0) {
-	xfree (Name);
        	return;
     }
 
     /* Update the token list for replay */
     List->RepMax = (unsigned) RepCount;
-    List->Data   = Name;
     List->Check  = RepeatTokenCheck;
 
     /* If the list is empty, or repeat count zero, there is nothing
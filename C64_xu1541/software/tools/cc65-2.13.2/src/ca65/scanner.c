@@ -38,14 +38,13 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
-#include <sys/types.h>		/* EMX needs this */
-#include <sys/stat.h>
 
 /* common */
 #include "addrsize.h"
 #include "attrib.h"
 #include "chartype.h"
 #include "check.h"
+#include "filecache.h"
 #include "fname.h"
 #include "xmalloc.h"
 
@@ -82,11 +81,12 @@ FilePos	CurPos = { 0, 0, 0 };		/* Name and position in current file */
 /* Struct to handle include files. */
 typedef struct InputFile InputFile;
 struct InputFile {
-    FILE*      	    F;		       	/* Input file descriptor */
+    const CachedFile* F;                /* Contents of the input file */
+    unsigned long   Offs;               /* Offset of the next line */
     FilePos	    Pos;	       	/* Position in file */
     Token           Tok;	       	/* Last token */
     int		    C;			/* Last character */
-    char       	    Line[256];		/* The current input line */
+    StrBuf          Line;               /* The current input line */
     InputFile*	    Next;      	       	/* Linked list of input files */
 };
 
@@ -357,48 +357,59 @@ static void IFMarkStart (CharSource* S)
 static void IFNextChar (CharSource* S)
 /* Read the next character from the input file */
 {
+    InputFile* F = &S->V.File;
+
     /* Check for end of line, read the next line if needed */
-    while (S->V.File.Line [S->V.File.Pos.Col] == '\0') {
+    while (SB_AtUnchecked (&F->Line, F->Pos.Col) == '\0') {
 
+        const char* Data;
+        const char* End;
         unsigned Len, Removed;
 
-        /* End of current line reached, read next line */
-        if (fgets (S->V.File.Line, sizeof (S->V.File.Line), S->V.File.F) == 0) {
+        /* End of current line reached, get the next line */
+        if (F->Offs >= F->F->Size) {
             /* End of file. Add an empty line to the listing. This is a
              * small hack needed to keep the PC output in sync.
              */
-            NewListingLine ("", S->V.File.Pos.Name, FCount);
+            NewListingLine ("", F->Pos.Name, FCount);
             C = EOF;
             return;
         }
+        Data = F->F->Data + F->Offs;
+        End  = memchr (Data, '\n', F->F->Size - F->Offs);
+        End  = End? End + 1 : F->F->Data + F->F->Size;
+        F->Offs += End - Data;
+        SB_CopyBuf (&F->Line, Data, End - Data);
+        SB_Terminate (&F->Line);
 
         /* For better handling of files with unusual line endings (DOS
          * files that are accidently translated on Unix for example),
          * first remove all whitespace at the end, then add a single
-         * newline.
+         * newline. A NUL ends the line.
          */
-        Len = strlen (S->V.File.Line);
+        Len = strlen (SB_GetConstBuf (&F->Line));
         Removed = 0;
-        while (Len > 0 && IsSpace (S->V.File.Line[Len-1])) {
+        while (Len > 0 && IsSpace (SB_AtUnchecked (&F->Line, Len-1))) {
             ++Removed;
             --Len;
         }
+        SB_Cut (&F->Line, Len);
         if (Removed) {
-            S->V.File.Line[Len+0] = '\n';
-            S->V.File.Line[Len+1] = '\0';
+            SB_AppendChar (&F->Line, '\n');
         }
+        SB_Terminate (&F->Line);
 
         /* One more line */
-        S->V.File.Pos.Line++;
-        S->V.File.Pos.Col = 0;
+        F->Pos.Line++;
+        F->Pos.Col = 0;
 
         /* Remember the new line for the listing */
-        NewListingLine (S->V.File.Line, S->V.File.Pos.Name, FCount);
+        NewListingLine (SB_GetConstBuf (&F->Line), F->Pos.Name, FCount);
 
     }
 
     /* Return the next character from the file */
-    C = S->V.File.Line [S->V.File.Pos.Col++];
+    C = SB_AtUnchecked (&F->Line, F->Pos.Col++);
 }
 
 
@@ -414,10 +425,9 @@ void IFDone (CharSource* S)
      */
     CheckOpenIfs ();
 
-    /* Close the input file and decrement the file count. We will ignore
-     * errors here, since we were just reading from the file.
-     */
-    (void) fclose (S->V.File.F);
+    /* Release the contents of the file and decrement the file count */
+    FCacheClose (S->V.File.F);
+    SB_Done (&S->V.File.Line);
     --FCount;
 }
 
@@ -440,8 +450,8 @@ int NewInputFile (const char* Name)
     int RetCode = 0;            /* Return code. Assume an error. */
     char* PathName = 0;
 
-    /* First try to open the file */
-    FILE* F = fopen (Name, "r");
+    /* First try to read the file */
+    const CachedFile* F = FCacheOpen (Name);
     if (F == 0) {
 
      	/* Error (fatal error if this is the main file) */
@@ -453,7 +463,7 @@ int NewInputFile (const char* Name)
      	 * directories.
      	 */
      	PathName = FindInclude (Name);
-       	if (PathName == 0 || (F = fopen (PathName, "r")) == 0) {
+       	if (PathName == 0 || (F = FCacheOpen (PathName)) == 0) {
      	    /* Not found or cannot open, print an error and bail out */
      	    Error ("Cannot open include file `%s': %s", Name, strerror (errno));
             goto ExitPoint;
@@ -470,30 +480,18 @@ int NewInputFile (const char* Name)
      	unsigned        FileIdx;
         CharSource*     S;
 
-     	/* Stat the file and remember the values. There a race condition here,
-         * since we cannot use fileno() (non standard identifier in standard
-         * header file), and therefore not fstat. When using stat with the
-         * file name, there's a risk that the file was deleted and recreated
-         * while it was open. Since mtime and size are only used to check
-         * if a file has changed in the debugger, we will ignore this problem
-         * here.
-         */
-     	struct stat Buf;
-     	if (stat (Name, &Buf) != 0) {
-     	    Fatal ("Cannot stat input file `%s': %s", Name, strerror (errno));
-     	}
-
      	/* Add the file to the input file table and remember the index */
-     	FileIdx = AddFile (SB_InitFromString (&NameBuf, Name), Buf.st_size, Buf.st_mtime);
+     	FileIdx = AddFile (SB_InitFromString (&NameBuf, Name), F->Size, F->MTime);
 
        	/* Create a new input source variable and initialize it */
      	S                   = xmalloc (sizeof (*S));
         S->Func             = &IFFunc;
      	S->V.File.F         = F;
+        S->V.File.Offs      = 0;
      	S->V.File.Pos.Line  = 0;
      	S->V.File.Pos.Col   = 0;
      	S->V.File.Pos.Name  = FileIdx;
-       	S->V.File.Line[0]   = '\0';
+        SB_Terminate (SB_Init (&S->V.File.Line));
 
         /* Count active input files */
        	++FCount;
@@ -37,6 +37,7 @@
 
 /* common */
 #include "check.h"
+#include "strpool.h"
 #include "xmalloc.h"
 
 /* ca65 */
@@ -48,51 +49,58 @@
 
 
 
+/*****************************************************************************/
+/*     	       	    		     Data				     */
+/*****************************************************************************/
+
+
+
+/* String pool for the string attributes of all stored tokens */
+static StringPool TokStrPool = STATIC_STRINGPOOL_INITIALIZER;
+
+
+
 /*****************************************************************************/
 /*     	       	    		     Code	       			     */
 /*****************************************************************************/
 
 
 
-TokNode* NewTokNode (void)
-/* Create and return a token node with the current token value */
+unsigned GetTokStrId (const StrBuf* S)
+/* Return the id of the given string in the token string pool */
 {
-    TokNode* T;
+    return SP_Add (&TokStrPool, S);
+}
 
-    /* Allocate memory */
-    T = xmalloc (sizeof (TokNode));
 
-    /* Initialize the token contents */
-    T->Next   	= 0;
-    T->Tok	= Tok;
-    T->WS 	= WS;
-    T->IVal	= IVal;
-    T->SVal     = AUTO_STRBUF_INITIALIZER;
-    SB_Copy (&T->SVal, &SVal);
 
-    /* Return the node */
-    return T;
+const StrBuf* GetTokStrBuf (unsigned Id)
+/* Return the string with the given id from the token string pool */
+{
+    return SP_Get (&TokStrPool, Id);
 }
 
 
 
-void FreeTokNode (TokNode* T)
-/* Free the given token node */
+void TokGet (TokNode* T)
+/* Store the current scanner token in the given token node */
 {
-    SB_Done (&T->SVal);
-    xfree (T);
+    T->Tok  = Tok;
+    T->WS   = WS;
+    T->IVal = IVal;
+    T->SVal = SP_Add (&TokStrPool, &SVal);
 }
 
 
 
-void TokSet (TokNode* T)
+void TokSet (const TokNode* T)
 /* Set the scanner token from the given token node */
 {
     /* Set the values */
     Tok  = T->Tok;
     WS   = T->WS;
     IVal = T->IVal;
-    SB_Copy (&SVal, &T->SVal);
+    SB_Copy (&SVal, SP_Get (&TokStrPool, T->SVal));
 }
 
 
@@ -107,7 +115,7 @@ enum TC TokCmp (const TokNode* T)
 
     /* If the token has string attribute, check it */
     if (TokHasSVal (T->Tok)) {
-       	if (SB_Compare (&SVal, &T->SVal) != 0) {
+       	if (SB_Compare (&SVal, SP_Get (&TokStrPool, T->SVal)) != 0) {
      	    return tcSameToken;
 	}
     } else if (TokHasIVal (T->Tok)) {
@@ -127,17 +135,29 @@ void InitTokList (TokList* T)
 {
     /* Initialize the fields */
     T->Next	= 0;
-    T->Root	= 0;
-    T->Last	= 0;
+    T->Tokens	= 0;
+    T->Count 	= 0;
+    T->Size	= 0;
+    T->Pos	= 0;
     T->RepCount	= 0;
     T->RepMax	= 1;
-    T->Count 	= 0;
     T->Check	= 0;
     T->Data	= 0;
 }
 
 
 
+void DoneTokList (TokList* T)
+/* Free the tokens and the additional data of a token list, but not the list
+ * structure itself.
+ */
+{
+    xfree (T->Tokens);
+    xfree (T->Data);
+}
+
+
+
 TokList* NewTokList (void)
 /* Create a new, empty token list */
 {
@@ -154,20 +174,10 @@ TokList* NewTokList (void)
 
 
 void FreeTokList (TokList* List)
-/* Delete the token list including all token nodes */
+/* Delete the token list including all tokens */
 {
-    /* Free the token list */
-    TokNode* T = List->Root;
-    while (T) {
-	TokNode* Tmp = T;
-	T = T->Next;
-	FreeTokNode (Tmp);
-    }
-
-    /* If we have associated data, free it */
-    if (List->Data) {
-	xfree (List->Data);
-    }
+    /* Free the tokens and associated data */
+    DoneTokList (List);
 
     /* Free the list structure itself */
     xfree (List);
@@ -191,22 +201,25 @@ enum Token GetTokListTerm (enum Token Term)
 
 
 
-void AddCurTok (TokList* List)
-/* Add the current token to the token list */
+TokNode* AddCurTok (TokList* List)
+/* Add the current token to the token list and return the new token node.
+ * The pointer is valid until the next token is added to the list.
+ */
 {
-    /* Create a token node with the current token value */
-    TokNode* T = NewTokNode ();
+    TokNode* T;
 
-    /* Insert the node into the list */
-    if (List->Root == 0) {
-     	List->Root = T;
-    } else {
-     	List->Last->Next = T;
+    /* Grow the token array if needed */
+    if (List->Count >= List->Size) {
+        List->Size = (List->Size == 0)? 8 : List->Size * 2;
+        List->Tokens = xrealloc (List->Tokens, List->Size * sizeof (TokNode));
     }
-    List->Last = T;
 
-    /* Count nodes */
-    List->Count++;
+    /* Store the current token value */
+    T = List->Tokens + List->Count++;
+    TokGet (T);
+
+    /* Return the new node */
+    return T;
 }
 
 
@@ -220,11 +233,11 @@ static int ReplayTokList (void* List)
     /* Cast the generic pointer to an actual list */
     TokList* L = List;
 
-    /* Last may never be a NULL pointer, otherwise there's a bug in the code */
-    CHECK (L->Last != 0);
+    /* The position must be valid, otherwise there's a bug in the code */
+    CHECK (L->Pos < L->Count);
 
     /* Set the next token from the list */
-    TokSet (L->Last);
+    TokSet (L->Tokens + L->Pos);
 
     /* If a check function is defined, call it, so it may look at the token
      * just set and changed it as apropriate.
@@ -233,20 +246,17 @@ static int ReplayTokList (void* List)
 	L->Check (L);
     }
 
-    /* Set the pointer to the next token */
-    L->Last = L->Last->Next;
-
-    /* If this was the last token, decrement the repeat counter. If it goes
-     * zero, delete the list and remove the function from the stack.
+    /* If this was the last token, increment the repeat counter. If it reaches
+     * the maximum, delete the list and remove the function from the stack.
      */
-    if (L->Last == 0) {
+    if (++L->Pos >= L->Count) {
 	if (++L->RepCount >= L->RepMax) {
 	    /* Done with this list */
 	    FreeTokList (L);
 	    PopInput ();
 	} else {
 	    /* Replay one more time */
-	    L->Last = L->Root;
+	    L->Pos = 0;
 	}
     }
 
@@ -268,8 +278,8 @@ void PushTokList (TokList* List, const char* Desc)
 	return;
     }
 
-    /* Reset the last pointer to the first element */
-    List->Last = List->Root;
+    /* Start replay with the first token */
+    List->Pos = 0;
 
     /* Insert the list specifying our input function */
     PushInput (ReplayTokList, List, Desc);
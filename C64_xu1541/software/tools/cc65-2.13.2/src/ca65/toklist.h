@@ -52,25 +52,28 @@
 
 
 
-/* Struct holding a token */
+/* Struct holding a token. The string attribute is kept in a string pool
+ * private to the token lists, so tokens are small, may be copied without
+ * allocating memory, and string attributes may be compared by id.
+ */
 typedef struct TokNode TokNode;
 struct TokNode {
-    TokNode*	Next;  	      		/* For single linked list */
     Token	Tok;	      		/* Token value */
     int	       	WS;    	      		/* Whitespace before token? */
     long       	IVal;	      		/* Integer token attribute */
-    StrBuf      SVal;                   /* String attribute, dyn. allocated */
+    unsigned    SVal;                   /* String attribute, pool id */
 };
 
 /* Struct holding a token list */
 typedef struct TokList TokList;
 struct TokList {
     TokList*	Next;	      		/* Single linked list (for replay) */
-    TokNode*	Root;	      		/* First node in list */
-    TokNode*	Last;	      		/* Last node in list or replay */
+    TokNode*	Tokens;	      		/* Array of tokens */
+    unsigned	Count;	      		/* Token count */
+    unsigned	Size;	      		/* Allocated size of the token array */
+    unsigned	Pos;	      		/* Current token (used for replay) */
     unsigned   	RepCount;      		/* Repeat counter (used for replay) */
     unsigned	RepMax;			/* Maximum repeat count for replay */
-    unsigned	Count;	      		/* Token count */
     void	(*Check)(TokList*);	/* Token check function */
     void*      	Data;			/* Additional data for check */
 };
@@ -92,13 +95,16 @@ enum TC {
 
 
 
-TokNode* NewTokNode (void);
-/* Create and return a token node with the current token value */
+unsigned GetTokStrId (const StrBuf* S);
+/* Return the id of the given string in the token string pool */
+
+const StrBuf* GetTokStrBuf (unsigned Id);
+/* Return the string with the given id from the token string pool */
 
-void FreeTokNode (TokNode* T);
-/* Free the given token node */
+void TokGet (TokNode* T);
+/* Store the current scanner token in the given token node */
 
-void TokSet (TokNode* T);
+void TokSet (const TokNode* T);
 /* Set the scanner token from the given token node */
 
 enum TC TokCmp (const TokNode* T);
@@ -107,11 +113,16 @@ enum TC TokCmp (const TokNode* T);
 void InitTokList (TokList* T);
 /* Initialize a token list structure for later use */
 
+void DoneTokList (TokList* T);
+/* Free the tokens and the additional data of a token list, but not the list
+ * structure itself.
+ */
+
 TokList* NewTokList (void);
 /* Create a new, empty token list */
 
 void FreeTokList (TokList* T);
-/* Delete the token list including all token nodes */
+/* Delete the token list including all tokens */
 
 Token GetTokListTerm (Token Term);
 /* Determine if the following token list is enclosed in curly braces. This is
@@ -119,8 +130,10 @@ Token GetTokListTerm (Token Term);
  * a closing brace, otherwise return Term.
  */
 
-void AddCurTok (TokList* T);
-/* Add the current token to the token list */
+TokNode* AddCurTok (TokList* T);
+/* Add the current token to the token list and return the new token node.
+ * The pointer is valid until the next token is added to the list.
+ */
 
 void PushTokList (TokList* List, const char* Desc);
 /* Push a token list to be used as input for InputFromStack. This includes
@@ -39,6 +39,7 @@
 #include "chartype.h"
 #include "check.h"
 #include "debugflag.h"
+#include "strpool.h"
 #include "xmalloc.h"
 #include "xsprintf.h"
 
@@ -60,32 +61,34 @@
 
 
 /* Empty argument */
-static char EmptyArg[] = "";
+static const char EmptyArg[] = "";
 
+/* Pool for the arguments of all code entries */
+static StringPool ArgPool = STATIC_STRINGPOOL_INITIALIZER;
 
+/* Count of entries changed in place */
+unsigned CodeEntryChanges = 0;
 
-/*****************************************************************************/
-/*			       Helper functions				     */
-/*****************************************************************************/
+/* Stamps for changes of the code */
+unsigned long CodeChangeStamp = 0;
+unsigned long OPCChangeStamps[OP65_COUNT];
 
 
 
-static void FreeArg (char* Arg)
-/* Free a code entry argument */
-{
-    if (Arg != EmptyArg) {
-	xfree (Arg);
-    }
-}
+/*****************************************************************************/
+/*			       Helper functions				     */
+/*****************************************************************************/
 
 
 
-static char* GetArgCopy (const char* Arg)
-/* Create an argument copy for assignment */
+const char* GetPooledArg (const char* Arg)
+/* Return the copy of Arg in the pool of instruction arguments. Since equal
+ * arguments of code entries are the same string, they may be compared by
+ * address.
+ */
 {
     if (Arg && Arg[0] != '\0') {
-	/* Create a copy */
-	return xstrdup (Arg);
+        return SB_GetConstBuf (SP_Get (&ArgPool, SP_AddStr (&ArgPool, Arg)));
     } else {
 	/* Use the empty argument string */
 	return EmptyArg;
@@ -245,12 +248,13 @@ CodeEntry* NewCodeEntry (opc_t OPC, am_t AM, const char* Arg,
     E->OPC    = D->OPC;
     E->AM     = AM;
     E->Size   = GetInsnSize (E->OPC, E->AM);
-    E->Arg    = GetArgCopy (Arg);
+    E->Arg    = GetPooledArg (Arg);
     E->Flags  = NumArg (E->Arg, &E->Num)? CEF_NUMARG : 0;   /* Needs E->Arg */
     E->Info   = D->Info;
     E->JumpTo = JumpTo;
     E->LI     = UseLineInfo (LI);
     E->RI     = 0;
+    E->Block  = 0;
     SetUseChgInfo (E, D);
     InitCollection (&E->Labels);
 
@@ -268,9 +272,6 @@ CodeEntry* NewCodeEntry (opc_t OPC, am_t AM, const char* Arg,
 void FreeCodeEntry (CodeEntry* E)
 /* Free the given code entry */
 {
-    /* Free the string argument if we have one */
-    FreeArg (E->Arg);
-
     /* Cleanup the collection */
     DoneCollection (&E->Labels);
 
@@ -295,10 +296,23 @@ void CE_ReplaceOPC (CodeEntry* E, opc_t OPC)
     const OPCDesc* D = GetOPCDesc (OPC);
 
     /* Replace the opcode */
+    CE_MarkChanged (E);
     E->OPC  = OPC;
     E->Info = D->Info;
     E->Size = GetInsnSize (E->OPC, E->AM);
     SetUseChgInfo (E, D);
+
+    /* Invalidate cached flow information */
+    ++CodeEntryChanges;
+    CE_MarkChanged (E);
+}
+
+
+
+void CE_MarkChanged (const CodeEntry* E)
+/* Note that the entry has been changed, see CodeChangeStamp */
+{
+    OPCChangeStamps[E->OPC] = ++CodeChangeStamp;
 }
 
 
@@ -316,6 +330,7 @@ void CE_AttachLabel (CodeEntry* E, CodeLabel* L)
 {
     /* Add it to the entries label list */
     CollAppend (&E->Labels, L);
+    CE_MarkChanged (E);
 
     /* Tell the label about it's owner */
     L->Owner = E;
@@ -331,9 +346,9 @@ void CE_ClearJumpTo (CodeEntry* E)
 {
     /* Clear the JumpTo entry */
     E->JumpTo = 0;
+    CE_MarkChanged (E);
 
-    /* Clear the argument and assign the empty one */
-    FreeArg (E->Arg);
+    /* Assign the empty argument */
     E->Arg = EmptyArg;
 }
 
@@ -344,10 +359,12 @@ void CE_MoveLabel (CodeLabel* L, CodeEntry* E)
 {
     /* Delete the label from the owner */
     CollDeleteItem (&L->Owner->Labels, L);
+    CE_MarkChanged (L->Owner);
 
     /* Set the new owner */
     CollAppend (&E->Labels, L);
     L->Owner = E;
+    CE_MarkChanged (E);
 }
 
 
@@ -355,11 +372,9 @@ void CE_MoveLabel (CodeLabel* L, CodeEntry* E)
 void CE_SetArg (CodeEntry* E, const char* Arg)
 /* Replace the argument by the new one. */
 {
-    /* Free the old argument */
-    FreeArg (E->Arg);
-
     /* Assign the new one */
-    E->Arg = GetArgCopy (Arg);
+    E->Arg = GetPooledArg (Arg);
+    CE_MarkChanged (E);
 }
 
 
@@ -69,7 +69,7 @@ struct CodeEntry {
     unsigned char       AM;		/* Adressing mode */
     unsigned char    	Size;		/* Estimated size */
     unsigned char       Flags;		/* Flags */
-    char*      	       	Arg;   	       	/* Argument as string */
+    const char*	       	Arg;   	       	/* Argument, see GetPooledArg */
     unsigned long    	Num;		/* Numeric argument */
     unsigned short      Info;		/* Additional code info */
     unsigned short      Use;		/* Registers used */
@@ -78,8 +78,23 @@ struct CodeEntry {
     Collection	     	Labels;		/* Labels for this instruction */
     LineInfo*           LI;             /* Source line info for this insn */
     RegInfo*            RI;             /* Register info for this insn */
+    unsigned            Block;          /* Basic block, see codeseg.c */
 };
 
+/* Count of entries changed in place by CE_ReplaceOPC. Information about the
+ * code flow that is cached by code segments is outdated if it changes.
+ */
+extern unsigned CodeEntryChanges;
+
+/* Stamps for changes of the code. Whenever an entry is changed, or inserted
+ * into or deleted from a code segment, CodeChangeStamp is incremented and
+ * the new value is remembered for the opcode of the entry and the ones next
+ * to it. The optimizer uses this to find out which kinds of instructions
+ * were involved in changes since some point in time.
+ */
+extern unsigned long CodeChangeStamp;
+extern unsigned long OPCChangeStamps[OP65_COUNT];
+
 
 
 /*****************************************************************************/
@@ -96,6 +111,12 @@ const char* MakeHexArg (unsigned Num);
  * safe).
  */
 
+const char* GetPooledArg (const char* Arg);
+/* Return the copy of Arg in the pool of instruction arguments. Since equal
+ * arguments of code entries are the same string, they may be compared by
+ * address.
+ */
+
 CodeEntry* NewCodeEntry (opc_t OPC, am_t AM, const char* Arg,
    	       	    	 CodeLabel* JumpTo, LineInfo* LI);
 /* Create a new code entry, initialize and return it */
@@ -108,6 +129,9 @@ void CE_ReplaceOPC (CodeEntry* E, opc_t OPC);
  * Size, Use and Chg, but it will NOT update any arguments or labels.
  */
 
+void CE_MarkChanged (const CodeEntry* E);
+/* Note that the entry has been changed, see CodeChangeStamp */
+
 int CodeEntriesAreEqual (const CodeEntry* E1, const CodeEntry* E2);
 /* Check if both code entries are equal */
 
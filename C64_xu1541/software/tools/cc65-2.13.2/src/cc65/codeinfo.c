@@ -502,200 +502,13 @@ const ZPInfo* GetZPInfo (const char* Name)
 
 
 
-static unsigned GetRegInfo2 (CodeSeg* S,
-		      	     CodeEntry* E,
-		    	     int Index,
-		     	     Collection* Visited,
-		     	     unsigned Used,
-		     	     unsigned Unused,
-			     unsigned Wanted)
-/* Recursively called subfunction for GetRegInfo. */
-{
-    /* Follow the instruction flow recording register usage. */
-    while (1) {
-
-	unsigned R;
-
-	/* Check if we have already visited the current code entry. If so,
-	 * bail out.
-	 */
-	if (CE_HasMark (E)) {
-	    break;
-	}
-
-	/* Mark this entry as already visited */
-	CE_SetMark (E);
-	CollAppend (Visited, E);
-
-	/* Evaluate the used registers */
-	R = E->Use;
-	if (E->OPC == OP65_RTS ||
-       	    ((E->Info & OF_UBRA) != 0 && E->JumpTo == 0)) {
-	    /* This instruction will leave the function */
-	    R |= S->ExitRegs;
-	}
-       	if (R != REG_NONE) {
-	    /* We are not interested in the use of any register that has been
-	     * used before.
-	     */
-	    R &= ~Unused;
-	    /* Remember the remaining registers */
-	    Used |= R;
-	}
-
-	/* Evaluate the changed registers */
-       	if ((R = E->Chg) != REG_NONE) {
-	    /* We are not interested in the use of any register that has been
-	     * used before.
-	     */
-	    R &= ~Used;
-	    /* Remember the remaining registers */
-	    Unused |= R;
-	}
-
-       	/* If we know about all registers now, bail out */
-       	if (((Used | Unused) & Wanted) == Wanted) {
-    	    break;
-    	}
-
-	/* If the instruction is an RTS or RTI, we're done */
-       	if ((E->Info & OF_RET) != 0) {
-	    break;
-	}
-
-	/* If we have an unconditional branch, follow this branch if possible,
-	 * otherwise we're done.
-	 */
-	if ((E->Info & OF_UBRA) != 0) {
-
-	    /* Does this jump have a valid target? */
-	    if (E->JumpTo) {
-
-	       	/* Unconditional jump */
- 	       	E     = E->JumpTo->Owner;
-		Index = -1;	     	/* Invalidate */
-
-	    } else {
-	       	/* Jump outside means we're done */
-	       	break;
-	    }
-
-       	/* In case of conditional branches, follow the branch if possible and
-	 * follow the normal flow (branch not taken) afterwards. If we cannot
-	 * follow the branch, we're done.
-	 */
-	} else if ((E->Info & OF_CBRA) != 0) {
-
-            /* Recursively determine register usage at the branch target */
-	    unsigned U1;
-	    unsigned U2;
-
-    	    if (E->JumpTo) {
-
-                /* Jump to internal label */
-		U1 = GetRegInfo2 (S, E->JumpTo->Owner, -1, Visited, Used, Unused, Wanted);
-
-            } else {
-
-                /* Jump to external label. This will effectively exit the
-                 * function, so we use the exitregs information here.
-                 */
-                U1 = S->ExitRegs;
-
-            }
-
-            /* Get the next entry */
-            if (Index < 0) {
-                Index = CS_GetEntryIndex (S, E);
-            }
-            if ((E = CS_GetEntry (S, ++Index)) == 0) {
-                Internal ("GetRegInfo2: No next entry!");
-            }
-
-            /* Follow flow if branch not taken */
-            U2 = GetRegInfo2 (S, E, Index, Visited, Used, Unused, Wanted);
-
-            /* Registers are used if they're use in any of the branches */
-            return U1 | U2;
-
-       	} else {
-
-	    /* Just go to the next instruction */
-	    if (Index < 0) {
-	     	Index = CS_GetEntryIndex (S, E);
-	    }
-	    E = CS_GetEntry (S, ++Index);
-	    if (E == 0) {
-	     	/* No next entry */
-	     	Internal ("GetRegInfo2: No next entry!");
-	    }
-
-	}
-
-    }
-
-    /* Return to the caller the complement of all unused registers */
-    return Used;
-}
-
-
-
-static unsigned GetRegInfo1 (CodeSeg* S,
-		      	     CodeEntry* E,
-		   	     int Index,
-		     	     Collection* Visited,
-		     	     unsigned Used,
-		     	     unsigned Unused,
-			     unsigned Wanted)
-/* Recursively called subfunction for GetRegInfo. */
-{
-    /* Remember the current count of the line collection */
-    unsigned Count = CollCount (Visited);
-
-    /* Call the worker routine */
-    unsigned R = GetRegInfo2 (S, E, Index, Visited, Used, Unused, Wanted);
-
-    /* Restore the old count, unmarking all new entries */
-    unsigned NewCount = CollCount (Visited);
-    while (NewCount-- > Count) {
-	CodeEntry* E = CollAt (Visited, NewCount);
-	CE_ResetMark (E);
-	CollDelete (Visited, NewCount);
-    }
-
-    /* Return the registers used */
-    return R;
-}
-
-
-
 unsigned GetRegInfo (struct CodeSeg* S, unsigned Index, unsigned Wanted)
 /* Determine register usage information for the instructions starting at the
- * given index.
+ * given index. Of the registers in Wanted, return the ones that are used on
+ * at least one path through the code before they're changed.
  */
 {
-    CodeEntry* 	    E;
-    Collection 	    Visited;	/* Visited entries */
-    unsigned        R;
-
-    /* Get the code entry for the given index */
-    if (Index >= CS_GetEntryCount (S)) {
-	/* There is no such code entry */
-	return REG_NONE;
-    }
-    E = CS_GetEntry (S, Index);
-
-    /* Initialize the data structure used to collection information */
-    InitCollection (&Visited);
-
-    /* Call the recursive subfunction */
-    R = GetRegInfo1 (S, E, Index, &Visited, REG_NONE, REG_NONE, Wanted);
-
-    /* Delete the line collection */
-    DoneCollection (&Visited);
-
-    /* Return the registers used */
-    return R;
+    return CS_GetLiveRegs (S, Index, Wanted);
 }
 
 
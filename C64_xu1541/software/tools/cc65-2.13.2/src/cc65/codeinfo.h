@@ -139,7 +139,8 @@ const ZPInfo* GetZPInfo (const char* Name);
 
 unsigned GetRegInfo (struct CodeSeg* S, unsigned Index, unsigned Wanted);
 /* Determine register usage information for the instructions starting at the
- * given index.
+ * given index. Of the registers in Wanted, return the ones that are used on
+ * at least one path through the code before they're changed.
  */
 
 int RegAUsed (struct CodeSeg* S, unsigned Index);
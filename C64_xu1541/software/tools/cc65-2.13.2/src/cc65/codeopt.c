@@ -35,6 +35,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* common */
 #include "abend.h"
@@ -476,12 +477,17 @@ static unsigned OptLoad1 (CodeSeg* S)
     unsigned I;
     unsigned Changes = 0;
 
+    /* Nothing to do without a call to ldaxysp */
+    if (CS_FindCall (S, "ldaxysp", 0) >= CS_GetEntryCount (S)) {
+        return 0;
+    }
+
     /* Generate register info */
     CS_GenRegInfo (S);
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldaxysp */
     I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldaxysp", I)) < CS_GetEntryCount (S)) {
 
      	CodeEntry* E;
 
@@ -489,8 +495,7 @@ static unsigned OptLoad1 (CodeSeg* S)
        	E = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
-       	if (CE_IsCallTo (E, "ldaxysp")          &&
-            RegValIsKnown (E->RI->In.RegY)      &&
+       	if (RegValIsKnown (E->RI->In.RegY)      &&
             !RegXUsed (S, I+1)) {
 
             CodeEntry* X;
@@ -1063,11 +1068,17 @@ struct OptFunc {
     unsigned       (*Func) (CodeSeg*);  /* Optimizer function */
     const char*    Name;                /* Name of the function/group */
     unsigned       CodeSizeFactor;      /* Code size factor for this opt func */
+    const opc_t*   Triggers;            /* Opcodes in the patterns or NULL */
     unsigned long  TotalRuns;		/* Total number of runs */
     unsigned long  LastRuns;            /* Last number of runs */
     unsigned long  TotalChanges;        /* Total number of changes */
     unsigned long  LastChanges;         /* Last number of changes */
     char           Disabled;            /* True if function disabled */
+    unsigned long  TotalSkips;          /* Total number of skipped runs */
+    unsigned long  LastSkips;           /* Last number of skipped runs */
+    double         TotalTime;           /* Total run time in ms */
+    double         LastTime;            /* Last run time in ms */
+    unsigned long  Stamp;               /* CodeChangeStamp when last run */
 };
 
 
@@ -1078,91 +1089,138 @@ struct OptFunc {
 
 
 
+/* Opcodes of the instructions in the patterns of some steps. These steps are
+ * only run again if instructions with one of these opcodes, or next to them,
+ * were changed since they were last run. Other steps depend on more than the
+ * instructions of a pattern, for example on the registers used later, so
+ * they're run again after any change.
+ */
+static const opc_t TOptBoolTrans[] = {
+    OP65_JSR, OP65_BEQ, OP65_BNE, OP65_JEQ, OP65_JNE, OP65_COUNT
+};
+static const opc_t TOptCmp1[] = {
+    OP65_LDX, OP65_STX, OP65_ORA, OP65_COUNT
+};
+static const opc_t TOptCmp2[] = {
+    OP65_STX, OP65_ORA, OP65_COUNT
+};
+static const opc_t TOptCmp3[] = {
+    OP65_ADC, OP65_AND, OP65_ASL, OP65_DEA, OP65_EOR, OP65_INA, OP65_LDA,
+    OP65_LSR, OP65_ORA, OP65_PLA, OP65_SBC, OP65_TXA, OP65_TYA, OP65_CMP,
+    OP65_JSR, OP65_BEQ, OP65_BMI, OP65_BNE, OP65_BPL, OP65_JEQ, OP65_JMI,
+    OP65_JNE, OP65_JPL, OP65_COUNT
+};
+static const opc_t TOptCmp5[] = {
+    OP65_LDY, OP65_JSR, OP65_CPX, OP65_CMP, OP65_BCC, OP65_BCS, OP65_BEQ,
+    OP65_BMI, OP65_BNE, OP65_BPL, OP65_BVC, OP65_BVS, OP65_JCC, OP65_JCS,
+    OP65_JEQ, OP65_JMI, OP65_JNE, OP65_JPL, OP65_JVC, OP65_JVS, OP65_COUNT
+};
+static const opc_t TOptCmp6[] = {
+    OP65_JSR, OP65_BEQ, OP65_BNE, OP65_JEQ, OP65_JNE, OP65_COUNT
+};
+static const opc_t TOptNegA1[] = {
+    OP65_LDX, OP65_LDA, OP65_JSR, OP65_COUNT
+};
+static const opc_t TOptNegA2[] = {
+    OP65_ADC, OP65_AND, OP65_DEA, OP65_EOR, OP65_INA, OP65_LDA, OP65_ORA,
+    OP65_PLA, OP65_SBC, OP65_TXA, OP65_TYA, OP65_JSR, OP65_BEQ, OP65_BNE,
+    OP65_JEQ, OP65_JNE, OP65_COUNT
+};
+static const opc_t TOptRTS[] = {
+    OP65_JSR, OP65_RTS, OP65_COUNT
+};
+static const opc_t TOptStore1[] = {
+    OP65_LDY, OP65_JSR, OP65_COUNT
+};
+static const opc_t TOptSub2[] = {
+    OP65_LDA, OP65_SEC, OP65_STA, OP65_SBC, OP65_COUNT
+};
+
 /* A list of all the function descriptions */
-static OptFunc DOpt65C02BitOps  = { Opt65C02BitOps,  "Opt65C02BitOps",   66, 0, 0, 0, 0, 0 };
-static OptFunc DOpt65C02Ind    	= { Opt65C02Ind,     "Opt65C02Ind",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOpt65C02Stores  = { Opt65C02Stores,  "Opt65C02Stores",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd1	       	= { OptAdd1,   	     "OptAdd1",        	125, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd2	       	= { OptAdd2,   	     "OptAdd2",        	200, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd3	       	= { OptAdd3,   	     "OptAdd3",        	 65, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd4	       	= { OptAdd4,   	     "OptAdd4",        	 90, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd5	       	= { OptAdd5,   	     "OptAdd5",        	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptAdd6	       	= { OptAdd6,   	     "OptAdd6",        	 40, 0, 0, 0, 0, 0 };
-static OptFunc DOptBoolTrans    = { OptBoolTrans,    "OptBoolTrans",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptBranchDist  	= { OptBranchDist,   "OptBranchDist",     0, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp1	       	= { OptCmp1,   	     "OptCmp1",        	 42, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp2	       	= { OptCmp2,   	     "OptCmp2",        	 85, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp3	       	= { OptCmp3,   	     "OptCmp3",        	 75, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp4	       	= { OptCmp4,   	     "OptCmp4",        	 75, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp5	       	= { OptCmp5,   	     "OptCmp5",        	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp6	       	= { OptCmp6,   	     "OptCmp6",        	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp7	       	= { OptCmp7,   	     "OptCmp7",        	 85, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp8	       	= { OptCmp8,   	     "OptCmp8",        	 50, 0, 0, 0, 0, 0 };
-static OptFunc DOptCmp9	       	= { OptCmp9,   	     "OptCmp9",        	 85, 0, 0, 0, 0, 0 };
-static OptFunc DOptCondBranches1= { OptCondBranches1,"OptCondBranches1", 80, 0, 0, 0, 0, 0 };
-static OptFunc DOptCondBranches2= { OptCondBranches2,"OptCondBranches2",  0, 0, 0, 0, 0, 0 };
-static OptFunc DOptDeadCode    	= { OptDeadCode,     "OptDeadCode",    	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptDeadJumps   	= { OptDeadJumps,    "OptDeadJumps",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptDecouple     = { OptDecouple,     "OptDecouple",     100, 0, 0, 0, 0, 0 };
-static OptFunc DOptDupLoads     = { OptDupLoads,     "OptDupLoads",       0, 0, 0, 0, 0, 0 };
-static OptFunc DOptIndLoads1    = { OptIndLoads1,    "OptIndLoads1",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptIndLoads2    = { OptIndLoads2,    "OptIndLoads2",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpCascades	= { OptJumpCascades, "OptJumpCascades", 100, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpTarget1  = { OptJumpTarget1,  "OptJumpTarget1",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptJumpTarget2  = { OptJumpTarget2,  "OptJumpTarget2",  100, 0, 0, 0, 0, 0 };
-static OptFunc DOptLoad1        = { OptLoad1,        "OptLoad1",        100, 0, 0, 0, 0, 0 };
-static OptFunc DOptRTS 	       	= { OptRTS,    	     "OptRTS",         	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptRTSJumps1    = { OptRTSJumps1,    "OptRTSJumps1",   	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptRTSJumps2    = { OptRTSJumps2,    "OptRTSJumps2",   	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegA1       	= { OptNegA1,  	     "OptNegA1",       	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegA2       	= { OptNegA2,  	     "OptNegA2",       	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegAX1      	= { OptNegAX1,       "OptNegAX1",      	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegAX2      	= { OptNegAX2,       "OptNegAX2",      	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegAX3      	= { OptNegAX3,       "OptNegAX3",      	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptNegAX4      	= { OptNegAX4,       "OptNegAX4",      	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPrecalc      = { OptPrecalc,      "OptPrecalc",     	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad1    	= { OptPtrLoad1,     "OptPtrLoad1",    	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad2    	= { OptPtrLoad2,     "OptPtrLoad2",    	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad3    	= { OptPtrLoad3,     "OptPtrLoad3",    	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad4    	= { OptPtrLoad4,     "OptPtrLoad4",    	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad5    	= { OptPtrLoad5,     "OptPtrLoad5",    	 50, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad6    	= { OptPtrLoad6,     "OptPtrLoad6",    	 60, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad7    	= { OptPtrLoad7,     "OptPtrLoad7",    	140, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad11   	= { OptPtrLoad11,    "OptPtrLoad11",     92, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad12   	= { OptPtrLoad12,    "OptPtrLoad12",    50, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad13   	= { OptPtrLoad13,    "OptPtrLoad13",    65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad14   	= { OptPtrLoad14,    "OptPtrLoad14",   	108, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad15   	= { OptPtrLoad15,    "OptPtrLoad15",   	 86, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad16   	= { OptPtrLoad16,    "OptPtrLoad16",   	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrLoad17   	= { OptPtrLoad17,    "OptPtrLoad17",    190, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrStore1   	= { OptPtrStore1,    "OptPtrStore1",    100, 0, 0, 0, 0, 0 };
-static OptFunc DOptPtrStore2   	= { OptPtrStore2,    "OptPtrStore2",     40, 0, 0, 0, 0, 0 };
-static OptFunc DOptPush1       	= { OptPush1,        "OptPush1",         65, 0, 0, 0, 0, 0 };
-static OptFunc DOptPush2       	= { OptPush2,        "OptPush2",         50, 0, 0, 0, 0, 0 };
-static OptFunc DOptPushPop      = { OptPushPop,      "OptPushPop",        0, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift1      	= { OptShift1,       "OptShift1",      	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift2      	= { OptShift2,       "OptShift2",      	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift3      	= { OptShift3,       "OptShift3",      	110, 0, 0, 0, 0, 0 };
-static OptFunc DOptShift4      	= { OptShift4,       "OptShift4",      	200, 0, 0, 0, 0, 0 };
-static OptFunc DOptSize1        = { OptSize1,        "OptSize1",        100, 0, 0, 0, 0, 0 };
-static OptFunc DOptSize2        = { OptSize2,        "OptSize2",        100, 0, 0, 0, 0, 0 };
-static OptFunc DOptStackOps    	= { OptStackOps,     "OptStackOps",    	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore1       = { OptStore1,       "OptStore1",        70, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore2       = { OptStore2,       "OptStore2",       220, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore3       = { OptStore3,       "OptStore3",       120, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore4       = { OptStore4,       "OptStore4",        50, 0, 0, 0, 0, 0 };
-static OptFunc DOptStore5       = { OptStore5,       "OptStore5",       100, 0, 0, 0, 0, 0 };
-static OptFunc DOptStoreLoad   	= { OptStoreLoad,    "OptStoreLoad",      0, 0, 0, 0, 0, 0 };
-static OptFunc DOptSub1	       	= { OptSub1,   	     "OptSub1",        	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptSub2	       	= { OptSub2,   	     "OptSub2",        	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptSub3	       	= { OptSub3,   	     "OptSub3",        	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptTest1       	= { OptTest1,  	     "OptTest1",       	100, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers1  	= { OptTransfers1,   "OptTransfers1",     0, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers2  	= { OptTransfers2,   "OptTransfers2",    60, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers3  	= { OptTransfers3,   "OptTransfers3",    65, 0, 0, 0, 0, 0 };
-static OptFunc DOptTransfers4  	= { OptTransfers4,   "OptTransfers4",    65, 0, 0, 0, 0, 0 };
-static OptFunc DOptUnusedLoads 	= { OptUnusedLoads,  "OptUnusedLoads",    0, 0, 0, 0, 0, 0 };
-static OptFunc DOptUnusedStores	= { OptUnusedStores, "OptUnusedStores",   0, 0, 0, 0, 0, 0 };
+static OptFunc DOpt65C02BitOps  = { Opt65C02BitOps,  "Opt65C02BitOps",   66, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOpt65C02Ind    	= { Opt65C02Ind,     "Opt65C02Ind",     100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOpt65C02Stores  = { Opt65C02Stores,  "Opt65C02Stores",  100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd1	       	= { OptAdd1,   	     "OptAdd1",        	125, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd2	       	= { OptAdd2,   	     "OptAdd2",        	200, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd3	       	= { OptAdd3,   	     "OptAdd3",        	 65, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd4	       	= { OptAdd4,   	     "OptAdd4",        	 90, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd5	       	= { OptAdd5,   	     "OptAdd5",        	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptAdd6	       	= { OptAdd6,   	     "OptAdd6",        	 40, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBoolTrans    = { OptBoolTrans,    "OptBoolTrans",    100, TOptBoolTrans, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptBranchDist  	= { OptBranchDist,   "OptBranchDist",     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp1	       	= { OptCmp1,   	     "OptCmp1",        	 42, TOptCmp1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp2	       	= { OptCmp2,   	     "OptCmp2",        	 85, TOptCmp2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp3	       	= { OptCmp3,   	     "OptCmp3",        	 75, TOptCmp3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp4	       	= { OptCmp4,   	     "OptCmp4",        	 75, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp5	       	= { OptCmp5,   	     "OptCmp5",        	100, TOptCmp5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp6	       	= { OptCmp6,   	     "OptCmp6",        	100, TOptCmp6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp7	       	= { OptCmp7,   	     "OptCmp7",        	 85, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp8	       	= { OptCmp8,   	     "OptCmp8",        	 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCmp9	       	= { OptCmp9,   	     "OptCmp9",        	 85, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCondBranches1= { OptCondBranches1,"OptCondBranches1", 80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptCondBranches2= { OptCondBranches2,"OptCondBranches2",  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDeadCode    	= { OptDeadCode,     "OptDeadCode",    	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDeadJumps   	= { OptDeadJumps,    "OptDeadJumps",    100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDecouple     = { OptDecouple,     "OptDecouple",     100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptDupLoads     = { OptDupLoads,     "OptDupLoads",       0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndLoads1    = { OptIndLoads1,    "OptIndLoads1",      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptIndLoads2    = { OptIndLoads2,    "OptIndLoads2",      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpCascades	= { OptJumpCascades, "OptJumpCascades", 100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpTarget1  = { OptJumpTarget1,  "OptJumpTarget1",  100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptJumpTarget2  = { OptJumpTarget2,  "OptJumpTarget2",  100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptLoad1        = { OptLoad1,        "OptLoad1",        100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptRTS 	       	= { OptRTS,    	     "OptRTS",         	100, TOptRTS, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptRTSJumps1    = { OptRTSJumps1,    "OptRTSJumps1",   	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptRTSJumps2    = { OptRTSJumps2,    "OptRTSJumps2",   	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegA1       	= { OptNegA1,  	     "OptNegA1",       	100, TOptNegA1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegA2       	= { OptNegA2,  	     "OptNegA2",       	100, TOptNegA2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegAX1      	= { OptNegAX1,       "OptNegAX1",      	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegAX2      	= { OptNegAX2,       "OptNegAX2",      	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegAX3      	= { OptNegAX3,       "OptNegAX3",      	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptNegAX4      	= { OptNegAX4,       "OptNegAX4",      	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPrecalc      = { OptPrecalc,      "OptPrecalc",     	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad1    	= { OptPtrLoad1,     "OptPtrLoad1",    	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad2    	= { OptPtrLoad2,     "OptPtrLoad2",    	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad3    	= { OptPtrLoad3,     "OptPtrLoad3",    	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad4    	= { OptPtrLoad4,     "OptPtrLoad4",    	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad5    	= { OptPtrLoad5,     "OptPtrLoad5",    	 50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad6    	= { OptPtrLoad6,     "OptPtrLoad6",    	 60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad7    	= { OptPtrLoad7,     "OptPtrLoad7",    	140, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad11   	= { OptPtrLoad11,    "OptPtrLoad11",     92, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad12   	= { OptPtrLoad12,    "OptPtrLoad12",    50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad13   	= { OptPtrLoad13,    "OptPtrLoad13",    65, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad14   	= { OptPtrLoad14,    "OptPtrLoad14",   	108, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad15   	= { OptPtrLoad15,    "OptPtrLoad15",   	 86, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad16   	= { OptPtrLoad16,    "OptPtrLoad16",   	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrLoad17   	= { OptPtrLoad17,    "OptPtrLoad17",    190, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrStore1   	= { OptPtrStore1,    "OptPtrStore1",    100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPtrStore2   	= { OptPtrStore2,    "OptPtrStore2",     40, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPush1       	= { OptPush1,        "OptPush1",         65, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPush2       	= { OptPush2,        "OptPush2",         50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptPushPop      = { OptPushPop,      "OptPushPop",        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift1      	= { OptShift1,       "OptShift1",      	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift2      	= { OptShift2,       "OptShift2",      	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift3      	= { OptShift3,       "OptShift3",      	110, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptShift4      	= { OptShift4,       "OptShift4",      	200, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSize1        = { OptSize1,        "OptSize1",        100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSize2        = { OptSize2,        "OptSize2",        100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStackOps    	= { OptStackOps,     "OptStackOps",    	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore1       = { OptStore1,       "OptStore1",        70, TOptStore1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore2       = { OptStore2,       "OptStore2",       220, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore3       = { OptStore3,       "OptStore3",       120, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore4       = { OptStore4,       "OptStore4",        50, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStore5       = { OptStore5,       "OptStore5",       100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptStoreLoad   	= { OptStoreLoad,    "OptStoreLoad",      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSub1	       	= { OptSub1,   	     "OptSub1",        	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSub2	       	= { OptSub2,   	     "OptSub2",        	100, TOptSub2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptSub3	       	= { OptSub3,   	     "OptSub3",        	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTest1       	= { OptTest1,  	     "OptTest1",       	100, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers1  	= { OptTransfers1,   "OptTransfers1",     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers2  	= { OptTransfers2,   "OptTransfers2",    60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers3  	= { OptTransfers3,   "OptTransfers3",    65, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptTransfers4  	= { OptTransfers4,   "OptTransfers4",    65, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptUnusedLoads 	= { OptUnusedLoads,  "OptUnusedLoads",    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+static OptFunc DOptUnusedStores	= { OptUnusedStores, "OptUnusedStores",   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 
 /* Table containing all the steps in alphabetical order */
@@ -1254,6 +1312,9 @@ static OptFunc* OptFuncs[] = {
 };
 #define OPTFUNC_COUNT  (sizeof(OptFuncs) / sizeof(OptFuncs[0]))
 
+/* True if statistics are collected */
+static int OptStats = 0;
+
 
 
 static int CmpOptStep (const void* Key, const void* Func)
@@ -1358,6 +1419,8 @@ static void ReadOptStats (const char* Name)
 	char Name[32];
        	unsigned long  TotalRuns;
 	unsigned long  TotalChanges;
+	unsigned long  TotalSkips = 0;
+	double         TotalTime  = 0.0;
 
 	/* Count lines */
 	++Lines;
@@ -1381,7 +1444,8 @@ static void ReadOptStats (const char* Name)
 	}
 
 	/* Parse the line */
-       	if (sscanf (B, "%31s %lu %*u %lu %*u", Name, &TotalRuns, &TotalChanges) != 3) {
+       	if (sscanf (B, "%31s %lu %*u %lu %*u %lu %*u %lf",
+                    Name, &TotalRuns, &TotalChanges, &TotalSkips, &TotalTime) < 3) {
       	    /* Syntax error */
 	    continue;
 	}
@@ -1396,6 +1460,8 @@ static void ReadOptStats (const char* Name)
 	/* Found the step, set the fields */
 	Func->TotalRuns    = TotalRuns;
 	Func->TotalChanges = TotalChanges;
+	Func->TotalSkips   = TotalSkips;
+	Func->TotalTime    = TotalTime;
 
     }
 
@@ -1419,20 +1485,26 @@ static void WriteOptStats (const char* Name)
 
     /* Write a header */
     fprintf (F,
-	     "; Optimizer               Total      Last       Total      Last\n"
-       	     ";   Step                  Runs       Runs        Chg       Chg\n");
+	     "; Optimizer               Total      Last       Total      Last"
+             "       Total      Last       Total      Last\n"
+       	     ";   Step                  Runs       Runs        Chg       Chg"
+             "        Skip      Skip     Time/ms   Time/ms\n");
 
 
     /* Write the data */
     for (I = 0; I < OPTFUNC_COUNT; ++I) {
     	const OptFunc* O = OptFuncs[I];
     	fprintf (F,
-       	       	 "%-20s %10lu %10lu %10lu %10lu\n",
+       	       	 "%-20s %10lu %10lu %10lu %10lu %10lu %10lu %10.3f %10.3f\n",
     		 O->Name,
 		 O->TotalRuns,
       	       	 O->LastRuns,
 	       	 O->TotalChanges,
-		 O->LastChanges);
+		 O->LastChanges,
+                 O->TotalSkips,
+                 O->LastSkips,
+                 O->TotalTime,
+                 O->LastTime);
     }
 
     /* Close the file, ignore errors here. */
@@ -1441,6 +1513,32 @@ static void WriteOptStats (const char* Name)
 
 
 
+static int OptFuncTriggered (const OptFunc* F)
+/* Return true if the code has changed since the function was last run in a
+ * way that may allow it to do more.
+ */
+{
+    const opc_t* T = F->Triggers;
+
+    /* Run the function at least once for each segment */
+    if (F->Stamp == 0) {
+        return 1;
+    }
+
+    /* Check for any change or for changes of the opcodes in the patterns */
+    if (T == 0) {
+        return CodeChangeStamp > F->Stamp;
+    }
+    while (*T != OP65_COUNT) {
+        if (OPCChangeStamps[*T++] > F->Stamp) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
 static unsigned RunOptFunc (CodeSeg* S, OptFunc* F, unsigned Max)
 /* Run one optimizer function Max times or until there are no more changes */
 {
@@ -1453,11 +1551,23 @@ static unsigned RunOptFunc (CodeSeg* S, OptFunc* F, unsigned Max)
     	return 0;
     }
 
+    /* Don't run the function if it cannot find anything new. Since it didn't
+     * find anything when it was last run, the result is the same.
+     */
+    if (!OptFuncTriggered (F)) {
+        ++F->TotalSkips;
+        ++F->LastSkips;
+        return 0;
+    }
+
     /* Run this until there are no more changes */
     Changes = 0;
     do {
 
+        clock_t Start = OptStats? clock () : 0;
+
 	/* Run the function */
+        F->Stamp = CodeChangeStamp;
     	C = F->Func (S);
     	Changes += C;
 
@@ -1466,6 +1576,11 @@ static unsigned RunOptFunc (CodeSeg* S, OptFunc* F, unsigned Max)
     	++F->LastRuns;
     	F->TotalChanges += C;
     	F->LastChanges  += C;
+        if (OptStats) {
+            double Time = (clock () - Start) * 1000.0 / CLOCKS_PER_SEC;
+            F->TotalTime += Time;
+            F->LastTime  += Time;
+        }
 
     } while (--Max && C > 0);
 
@@ -1730,6 +1845,7 @@ void RunOpt (CodeSeg* S)
 /* Run the optimizer */
 {
     const char* StatFileName;
+    unsigned    I;
 
     /* If we shouldn't run the optimizer, bail out */
     if (!S->Optimize) {
@@ -1741,6 +1857,12 @@ void RunOpt (CodeSeg* S)
     if (StatFileName) {
 	ReadOptStats (StatFileName);
     }
+    OptStats = (StatFileName != 0);
+
+    /* All steps have to be run for a new segment */
+    for (I = 0; I < OPTFUNC_COUNT; ++I) {
+        OptFuncs[I]->Stamp = 0;
+    }
 
     /* Print the name of the function we are working on */
     if (S->Func) {
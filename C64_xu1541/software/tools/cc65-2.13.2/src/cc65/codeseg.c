@@ -118,6 +118,22 @@ static void CS_MoveLabelsToPool (CodeSeg* S, CodeEntry* E)
 	CollAppend (&S->Labels, L);
     }
     CollDeleteAll (&E->Labels);
+    CE_MarkChanged (E);
+}
+
+
+
+static void CS_MarkChanged (CodeSeg* S, unsigned Index, unsigned Count)
+/* Mark the entries in the given range and the ones next to it as changed */
+{
+    unsigned First = (Index > 0)? Index - 1 : 0;
+    unsigned Last  = Index + Count;
+    if (Last >= CS_GetEntryCount (S)) {
+        Last = CS_GetEntryCount (S) - 1;
+    }
+    while (First <= Last && First < CS_GetEntryCount (S)) {
+        CE_MarkChanged (CS_GetEntry (S, First++));
+    }
 }
 
 
@@ -183,6 +199,809 @@ static void CS_RemoveLabelFromHash (CodeSeg* S, CodeLabel* L)
 
 
 
+static void CS_MoveAllLabels (CodeSeg* S, CodeEntry* Old, CodeEntry* New)
+/* Move all labels from Old to New. See CS_MoveLabels. */
+{
+    /* Get the number of labels to move */
+    unsigned OldLabelCount = CE_GetLabelCount (Old);
+
+    /* Does the new entry have itself a label? */
+    if (CE_HasLabel (New)) {
+
+	/* The new entry does already have a label - move references */
+	CodeLabel* NewLabel = CE_GetLabel (New, 0);
+	while (OldLabelCount--) {
+
+	    /* Get the next label */
+	    CodeLabel* OldLabel = CE_GetLabel (Old, OldLabelCount);
+
+	    /* Move references */
+	    CL_MoveRefs (OldLabel, NewLabel);
+
+	    /* Delete the label */
+	    CS_DelLabel (S, OldLabel);
+
+     	}
+
+    } else {
+
+	/* The new entry does not have a label, just move them */
+	while (OldLabelCount--) {
+
+	    /* Move the label to the new entry */
+	    CE_MoveLabel (CE_GetLabel (Old, OldLabelCount), New);
+
+	}
+
+    }
+}
+
+
+
+/*****************************************************************************/
+/*		      	 	 Opcode index				     */
+/*****************************************************************************/
+
+
+
+/* The opcodes of all entries are kept in an array in the order of the
+ * entries, so instructions with a given opcode can be found without looking
+ * at all entries. The array is created when first needed and updated while
+ * entries are inserted and deleted.
+ */
+struct OPCIndex {
+    unsigned char*  OPCs;               /* Opcodes of the entries */
+    unsigned        Size;               /* Allocated size of OPCs */
+    unsigned        Changes;            /* CodeEntryChanges when created */
+    unsigned char   Valid;              /* Index is valid */
+};
+
+
+
+static OPCIndex* CS_GetValidIndex (CodeSeg* S)
+/* Return the opcode index if it is valid, otherwise return NULL */
+{
+    OPCIndex* X = S->Index;
+    return (X && X->Valid && X->Changes == CodeEntryChanges)? X : 0;
+}
+
+
+
+static void CS_InvalidateIndex (CodeSeg* S)
+/* Invalidate the opcode index for the segment */
+{
+    if (S->Index) {
+        S->Index->Valid = 0;
+    }
+}
+
+
+
+static void CS_ReserveIndex (OPCIndex* X, unsigned Count)
+/* Make sure there's room for Count opcodes */
+{
+    if (Count > X->Size) {
+        X->Size = X->Size * 2 + Count;
+        X->OPCs = xrealloc (X->OPCs, X->Size);
+    }
+}
+
+
+
+static OPCIndex* CS_BuildIndex (CodeSeg* S)
+/* Return the opcode index for the segment, create it if needed */
+{
+    OPCIndex* X = CS_GetValidIndex (S);
+    if (X == 0) {
+        unsigned Count = CS_GetEntryCount (S);
+        unsigned I;
+        if ((X = S->Index) == 0) {
+            X = S->Index = xmalloc (sizeof (OPCIndex));
+            X->OPCs = 0;
+            X->Size = 0;
+        }
+        CS_ReserveIndex (X, Count);
+        for (I = 0; I < Count; ++I) {
+            X->OPCs[I] = CS_GetEntry (S, I)->OPC;
+        }
+        X->Changes = CodeEntryChanges;
+        X->Valid   = 1;
+    }
+    return X;
+}
+
+
+
+static void CS_IndexInserted (CodeSeg* S, unsigned Index)
+/* Update the opcode index after an entry was inserted at Index */
+{
+    OPCIndex* X = CS_GetValidIndex (S);
+    if (X) {
+        unsigned Count = CS_GetEntryCount (S);
+        CS_ReserveIndex (X, Count);
+        memmove (X->OPCs + Index + 1, X->OPCs + Index, Count - Index - 1);
+        X->OPCs[Index] = CS_GetEntry (S, Index)->OPC;
+    }
+}
+
+
+
+static void CS_IndexDeleting (CodeSeg* S, unsigned Index)
+/* Update the opcode index before the entry at Index is deleted */
+{
+    OPCIndex* X = CS_GetValidIndex (S);
+    if (X) {
+        unsigned Count = CS_GetEntryCount (S);
+        memmove (X->OPCs + Index, X->OPCs + Index + 1, Count - Index - 1);
+    }
+}
+
+
+
+static unsigned CS_FindEntryIndex (CodeSeg* S, const CodeEntry* E)
+/* Return the index of E in the segment or the number of entries if E isn't
+ * part of the segment.
+ */
+{
+    unsigned Count = CS_GetEntryCount (S);
+    unsigned I     = CS_FindOPC (S, E->OPC, 0);
+    while (I < Count && CS_GetEntry (S, I) != E) {
+        I = CS_FindOPC (S, E->OPC, I + 1);
+    }
+    return I;
+}
+
+
+
+/*****************************************************************************/
+/*		      	       Register liveness			     */
+/*****************************************************************************/
+
+
+
+/* The registers that are live at an instruction, that is, used on at least
+ * one path through the code before they're changed, are computed for all
+ * basic blocks of the segment at once, and kept up to date while the code
+ * is changed. Blocks need not be maximal: Every jump target starts a block
+ * and every jump ends one, but deleting code or removing jumps just leaves
+ * smaller blocks behind, which may even be empty. New jumps split blocks if
+ * needed. Since new blocks are added at the end, the blocks are linked in
+ * code order, and the index of their first entry is only updated when it's
+ * needed.
+ */
+#define NO_BLOCK        ((unsigned) -1)
+#define NO_ENTRY        ((unsigned) -1)
+
+typedef struct LiveBlock LiveBlock;
+struct LiveBlock {
+    CodeEntry*      Head;               /* First entry or NULL */
+    CodeEntry*      Tail;               /* Last entry or NULL */
+    unsigned        First;              /* Index of first entry */
+    unsigned        Count;              /* Number of entries */
+    unsigned        Prev;               /* Block in front of this one */
+    unsigned        Next;               /* Block behind this one */
+    unsigned short  Gen;                /* Registers used before changed */
+    unsigned short  Kill;               /* Registers changed */
+    unsigned short  In;                 /* Registers live on entry */
+    unsigned short  Lost;               /* Removed from In, not from preds */
+    unsigned char   Dirty;              /* Gen and Kill need an update */
+    unsigned char   Shrink;             /* In may have to shrink */
+    unsigned char   Queued;             /* In needs an update */
+    unsigned char   Listed;             /* Block is in the changed list */
+};
+
+struct RegLive {
+    LiveBlock*      Blocks;             /* Basic blocks, first one first */
+    unsigned*       Work;               /* Blocks to update, last on top */
+    unsigned*       Drop;               /* Blocks that have lost registers */
+    unsigned*       Changed;            /* Blocks with Dirty or Shrink set */
+    unsigned        Top;                /* Number of blocks in Work */
+    unsigned        ChangeCount;        /* Number of blocks in Changed */
+    unsigned        Count;              /* Number of blocks */
+    unsigned        Size;               /* Number of allocated blocks */
+    unsigned        Changes;            /* CodeEntryChanges when created */
+    unsigned char   Valid;              /* Blocks are valid */
+    unsigned char   Moved;              /* First of the blocks is outdated */
+};
+
+
+
+static RegLive* CS_GetValidLive (CodeSeg* S)
+/* Return the liveness info if it is valid, otherwise return NULL */
+{
+    RegLive* L = S->Live;
+    return (L && L->Valid && L->Changes == CodeEntryChanges)? L : 0;
+}
+
+
+
+static void CS_InvalidateLive (CodeSeg* S)
+/* Invalidate the liveness info for the segment */
+{
+    if (S->Live) {
+        S->Live->Valid = 0;
+    }
+}
+
+
+
+static void CS_ReserveLive (RegLive* L, unsigned Count)
+/* Make sure there's room for Count blocks */
+{
+    if (Count > L->Size) {
+        L->Size    = L->Size * 2 + 16;
+        L->Blocks  = xrealloc (L->Blocks, L->Size * sizeof (LiveBlock));
+        L->Work    = xrealloc (L->Work, L->Size * sizeof (unsigned));
+        L->Drop    = xrealloc (L->Drop, L->Size * sizeof (unsigned));
+        L->Changed = xrealloc (L->Changed, L->Size * sizeof (unsigned));
+    }
+}
+
+
+
+static void CS_InitLiveBlock (LiveBlock* B, unsigned First)
+/* Initialize a new and empty block */
+{
+    B->Head   = 0;
+    B->Tail   = 0;
+    B->First  = First;
+    B->Count  = 0;
+    B->Prev   = NO_BLOCK;
+    B->Next   = NO_BLOCK;
+    B->Gen    = REG_NONE;
+    B->Kill   = REG_NONE;
+    B->In     = REG_NONE;
+    B->Lost   = REG_NONE;
+    B->Dirty  = 0;
+    B->Shrink = 0;
+    B->Queued = 0;
+    B->Listed = 0;
+}
+
+
+
+static void CS_QueueLiveBlock (RegLive* L, unsigned Block)
+/* Put a block on the work list if it isn't already there */
+{
+    LiveBlock* B = L->Blocks + Block;
+    if (!B->Queued) {
+        B->Queued = 1;
+        L->Work[L->Top++] = Block;
+    }
+}
+
+
+
+static void CS_ListLiveBlock (RegLive* L, unsigned Block)
+/* Put a block on the list of changed blocks if it isn't already there */
+{
+    LiveBlock* B = L->Blocks + Block;
+    if (!B->Listed) {
+        B->Listed = 1;
+        L->Changed[L->ChangeCount++] = Block;
+    }
+}
+
+
+
+static void CS_ShrinkLiveBlock (RegLive* L, unsigned Block)
+/* Note that the registers live on entry of a block may have to shrink */
+{
+    CS_ListLiveBlock (L, Block);
+    L->Blocks[Block].Shrink = 1;
+}
+
+
+
+static void CS_LiveFlowChanged (CodeSeg* S, const CodeEntry* E)
+/* Note that the code flow behind E has changed */
+{
+    RegLive* L = CS_GetValidLive (S);
+    if (L) {
+        CS_ShrinkLiveBlock (L, E->Block);
+    }
+}
+
+
+
+static void CS_LiveJumpsChanged (CodeSeg* S, CodeEntry* E)
+/* Note that the jumps to the labels of E went elsewhere before, or will go
+ * elsewhere soon.
+ */
+{
+    unsigned LabelCount = CE_GetLabelCount (E);
+    unsigned I, J;
+    for (I = 0; I < LabelCount; ++I) {
+        CodeLabel* L = CE_GetLabel (E, I);
+        for (J = 0; J < CL_GetRefCount (L); ++J) {
+            CS_LiveFlowChanged (S, CL_GetRef (L, J));
+        }
+    }
+}
+
+
+
+static int CS_EndsLiveBlock (const CodeEntry* E)
+/* Return true if the code flow doesn't continue with the next entry */
+{
+    return (E->Info & (OF_BRA | OF_RET)) != 0;
+}
+
+
+
+static unsigned CS_LiveBefore (const CodeSeg* S, const CodeEntry* E, unsigned Live)
+/* Return the registers live before E, if the ones in Live are live behind it */
+{
+    unsigned Use = E->Use;
+    if (E->OPC == OP65_RTS || ((E->Info & OF_UBRA) != 0 && E->JumpTo == 0)) {
+        /* This instruction will leave the function */
+        Use |= S->ExitRegs;
+    }
+    return Use | (Live & ~E->Chg);
+}
+
+
+
+static unsigned CS_LiveOut (CodeSeg* S, unsigned Block)
+/* Return the registers live at the end of a block */
+{
+    const RegLive*   L   = S->Live;
+    const LiveBlock* B   = L->Blocks + Block;
+    const CodeEntry* E   = B->Tail;
+    unsigned         Out = REG_NONE;
+
+    if (E) {
+        if ((E->Info & OF_BRA) != 0) {
+            /* A jump to an external label leaves the function */
+            if (E->JumpTo && E->JumpTo->Owner) {
+                Out |= L->Blocks[E->JumpTo->Owner->Block].In;
+            } else {
+                Out |= S->ExitRegs;
+            }
+        }
+        if ((E->Info & OF_DEAD) != 0) {
+            return Out;
+        }
+    }
+
+    /* Falling off the end leaves the function */
+    if (B->Next != NO_BLOCK) {
+        Out |= L->Blocks[B->Next].In;
+    } else {
+        Out |= S->ExitRegs;
+    }
+    return Out;
+}
+
+
+
+static void CS_ScanLiveBlock (CodeSeg* S, unsigned Block, unsigned Index,
+                              unsigned Skip, unsigned* Gen, unsigned* Kill)
+/* Find the entries of a block, which must be at Index or in front of it, and
+ * return the registers used and changed by them. The entry at Skip, which is
+ * about to be deleted, is ignored.
+ */
+{
+    LiveBlock* B     = S->Live->Blocks + Block;
+    unsigned   Count = CS_GetEntryCount (S);
+    unsigned   First = Index;
+    unsigned   I     = Index;
+
+    /* Find the end of the block and its start */
+    while (I < Count && CS_GetEntry (S, I)->Block == Block) {
+        ++I;
+    }
+    while (First > 0 && CS_GetEntry (S, First - 1)->Block == Block) {
+        --First;
+    }
+
+    /* Walk over the entries backwards */
+    B->Head  = 0;
+    B->Tail  = 0;
+    B->First = First;
+    B->Count = 0;
+    *Gen     = REG_NONE;
+    *Kill    = REG_NONE;
+    while (I-- > First) {
+        CodeEntry* E = CS_GetEntry (S, I);
+        if (I != Skip) {
+            *Gen   = CS_LiveBefore (S, E, *Gen);
+            *Kill |= E->Chg;
+            if (B->Tail == 0) {
+                B->Tail = E;
+            }
+            B->Head = E;
+            ++B->Count;
+        }
+    }
+}
+
+
+
+static void CS_UpdateLiveBlock (CodeSeg* S, unsigned Block, unsigned Index,
+                                unsigned Skip)
+/* Update the registers used and changed by a block after a change at Index,
+ * see CS_ScanLiveBlock. If the block now uses more registers or changes
+ * fewer, the live registers can only grow, and the solution is updated from
+ * the old one. Otherwise, some may have to be removed.
+ */
+{
+    RegLive*   L = S->Live;
+    LiveBlock* B = L->Blocks + Block;
+    unsigned   Gen;
+    unsigned   Kill;
+
+    CS_ScanLiveBlock (S, Block, Index, Skip, &Gen, &Kill);
+    if ((B->Gen & ~Gen) != 0 || (Kill & ~B->Kill) != 0) {
+        CS_ShrinkLiveBlock (L, Block);
+    } else if (Gen != B->Gen || Kill != B->Kill) {
+        CS_QueueLiveBlock (L, Block);
+    }
+    B->Gen   = (unsigned short) Gen;
+    B->Kill  = (unsigned short) Kill;
+    B->Dirty = 0;
+}
+
+
+
+static void CS_PlaceLiveBlocks (RegLive* L)
+/* Update the index of the first entry of all blocks after entries have been
+ * inserted or deleted.
+ */
+{
+    unsigned Block = 0;
+    unsigned First = 0;
+    if (L->Moved && L->Count > 0) {
+        while (Block != NO_BLOCK) {
+            LiveBlock* B = L->Blocks + Block;
+            B->First = First;
+            First   += B->Count;
+            Block    = B->Next;
+        }
+    }
+    L->Moved = 0;
+}
+
+
+
+static void CS_SplitLiveBlock (CodeSeg* S, unsigned Index)
+/* Start a new block with the entry at Index, which must not be the first one
+ * of its block.
+ */
+{
+    RegLive*   L     = S->Live;
+    unsigned   Block = CS_GetEntry (S, Index)->Block;
+    unsigned   New   = L->Count;
+    unsigned   Count = CS_GetEntryCount (S);
+    LiveBlock* B;
+    LiveBlock* N;
+    unsigned   Gen;
+    unsigned   Kill;
+    unsigned   I;
+
+    /* Changes of the block that are still unaccounted for must be handled
+     * before the block is split.
+     */
+    if (L->Blocks[Block].Dirty) {
+        CS_PlaceLiveBlocks (L);
+        CS_UpdateLiveBlock (S, Block, L->Blocks[Block].First, NO_ENTRY);
+    }
+
+    /* Add the new block and link it behind the old one */
+    CS_ReserveLive (L, L->Count + 1);
+    ++L->Count;
+    B = L->Blocks + Block;
+    N = L->Blocks + New;
+    CS_InitLiveBlock (N, Index);
+    N->Prev = Block;
+    N->Next = B->Next;
+    if (B->Next != NO_BLOCK) {
+        L->Blocks[B->Next].Prev = New;
+    }
+    B->Next = New;
+
+    /* Move the entries */
+    for (I = Index; I < Count && CS_GetEntry (S, I)->Block == Block; ++I) {
+        CS_GetEntry (S, I)->Block = New;
+    }
+
+    /* Splitting the block doesn't change the registers live on entry of the
+     * old block. The ones of the new block follow from the old solution,
+     * and updates pending for the old block are also pending for the new
+     * one.
+     */
+    CS_ScanLiveBlock (S, Block, Index - 1, NO_ENTRY, &Gen, &Kill);
+    B->Gen  = (unsigned short) Gen;
+    B->Kill = (unsigned short) Kill;
+    CS_ScanLiveBlock (S, New, Index, NO_ENTRY, &Gen, &Kill);
+    N->Gen  = (unsigned short) Gen;
+    N->Kill = (unsigned short) Kill;
+    N->In   = (unsigned short) (Gen | (CS_LiveOut (S, New) & ~Kill));
+    if (B->Shrink) {
+        CS_ShrinkLiveBlock (L, New);
+    }
+    if (B->Queued) {
+        CS_QueueLiveBlock (L, New);
+    }
+}
+
+
+
+static void CS_LiveTargetChanged (CodeSeg* S, const CodeLabel* L)
+/* Note that there are new jumps to L. Since they must go to the start of a
+ * block, this may split a block.
+ */
+{
+    RegLive*         Live = CS_GetValidLive (S);
+    const LiveBlock* B;
+    unsigned         I;
+
+    if (Live == 0 || L->Owner == 0) {
+        return;
+    }
+    B = Live->Blocks + L->Owner->Block;
+    if (L->Owner == B->Head) {
+        return;
+    }
+    CS_PlaceLiveBlocks (Live);
+    for (I = B->First; I < B->First + B->Count; ++I) {
+        if (CS_GetEntry (S, I) == L->Owner) {
+            CS_SplitLiveBlock (S, I);
+            return;
+        }
+    }
+
+    /* The label isn't in this segment */
+    CS_InvalidateLive (S);
+}
+
+
+
+static void CS_LiveInserted (CodeSeg* S, unsigned Index)
+/* Update the liveness info after an entry was inserted at Index */
+{
+    RegLive*   L = CS_GetValidLive (S);
+    CodeEntry* E;
+    CodeEntry* P;
+    CodeEntry* N;
+
+    if (L == 0) {
+        return;
+    }
+
+    /* Get the entry and its neighbours */
+    E = CS_GetEntry (S, Index);
+    P = (Index > 0)? CS_GetEntry (S, Index-1) : 0;
+    N = CS_GetNextEntry (S, Index);
+
+    /* There are no blocks if the segment was empty */
+    if (L->Count == 0) {
+        CS_InvalidateLive (S);
+        return;
+    }
+
+    /* Add the entry to the block of its predecessor, or to the first block */
+    E->Block = P? P->Block : 0;
+    L->Moved = 1;
+    CS_UpdateLiveBlock (S, E->Block, Index, NO_ENTRY);
+
+    /* A new block must start at a label or behind a jump, and a jump must
+     * be the last entry of its block.
+     */
+    if (P && (CS_EndsLiveBlock (P) || CE_HasLabel (E))) {
+        CS_SplitLiveBlock (S, Index);
+    }
+    if (CS_EndsLiveBlock (E) && N && N->Block == E->Block) {
+        CS_SplitLiveBlock (S, Index + 1);
+    }
+
+    /* Jumps from or to the entry change the flow */
+    if (CS_EndsLiveBlock (E)) {
+        CS_LiveFlowChanged (S, E);
+        if (E->JumpTo) {
+            CS_LiveTargetChanged (S, E->JumpTo);
+        }
+    }
+    CS_LiveJumpsChanged (S, E);
+}
+
+
+
+static void CS_LiveDeleting (CodeSeg* S, unsigned Index)
+/* Update the liveness info before the entry at Index is deleted */
+{
+    RegLive*   L = CS_GetValidLive (S);
+    CodeEntry* E;
+
+    if (L == 0) {
+        return;
+    }
+
+    /* Remove the entry from its block. This may leave an empty block behind */
+    E = CS_GetEntry (S, Index);
+    L->Moved = 1;
+    CS_UpdateLiveBlock (S, E->Block, Index, Index);
+
+    /* Deleting jumps or jump targets changes the flow */
+    if (CS_EndsLiveBlock (E)) {
+        CS_LiveFlowChanged (S, E);
+    }
+    CS_LiveJumpsChanged (S, E);
+}
+
+
+
+static void CS_BuildLiveBlocks (CodeSeg* S)
+/* Split the segment into basic blocks */
+{
+    RegLive*   L     = S->Live;
+    unsigned   Count = CS_GetEntryCount (S);
+    CodeEntry* P     = 0;
+    unsigned   I;
+
+    /* A block starts at a label or behind a jump */
+    L->Count = 0;
+    for (I = 0; I < Count; ++I) {
+        CodeEntry* E = CS_GetEntry (S, I);
+        if (P == 0 || CE_HasLabel (E) || CS_EndsLiveBlock (P)) {
+            CS_ReserveLive (L, L->Count + 1);
+            CS_InitLiveBlock (L->Blocks + L->Count, I);
+            ++L->Count;
+        }
+        E->Block = L->Count - 1;
+        P = E;
+    }
+    for (I = 1; I < L->Count; ++I) {
+        L->Blocks[I-1].Next = I;
+        L->Blocks[I].Prev   = I-1;
+    }
+
+    /* Get the registers used and changed by the blocks */
+    I = Count;
+    while (I-- > 0) {
+        CodeEntry* E = CS_GetEntry (S, I);
+        LiveBlock* B = L->Blocks + E->Block;
+        if (B->Tail == 0) {
+            B->Tail = E;
+        }
+        B->Head  = E;
+        B->Gen   = (unsigned short) CS_LiveBefore (S, E, B->Gen);
+        B->Kill |= E->Chg;
+        ++B->Count;
+    }
+
+    /* All blocks must be solved. Since the flow mostly goes forward, the
+     * last block is handled first.
+     */
+    for (I = 0; I < L->Count; ++I) {
+        L->Blocks[I].In     = L->Blocks[I].Gen;
+        L->Blocks[I].Queued = 1;
+        L->Work[I] = I;
+    }
+    L->Top         = L->Count;
+    L->ChangeCount = 0;
+    L->Changes     = CodeEntryChanges;
+    L->Valid       = 1;
+    L->Moved       = 0;
+}
+
+
+
+static void CS_QueueLivePreds (CodeSeg* S, unsigned Block)
+/* Put all blocks that may continue with the given one on the work list */
+{
+    RegLive*         L = S->Live;
+    const LiveBlock* B = L->Blocks + Block;
+
+    /* The block in front may fall through */
+    if (B->Prev != NO_BLOCK) {
+        CS_QueueLiveBlock (L, B->Prev);
+    }
+
+    /* All jumps to the labels of the first entry */
+    if (B->Head) {
+        unsigned LabelCount = CE_GetLabelCount (B->Head);
+        unsigned I, J;
+        for (I = 0; I < LabelCount; ++I) {
+            CodeLabel* Label = CE_GetLabel (B->Head, I);
+            for (J = 0; J < CL_GetRefCount (Label); ++J) {
+                CS_QueueLiveBlock (L, CL_GetRef (Label, J)->Block);
+            }
+        }
+    }
+}
+
+
+
+static void CS_DropLive (RegLive* L, unsigned Block, unsigned Regs, unsigned* Top)
+/* Remove registers from the ones live on entry of a block, if they're not
+ * used by the block itself.
+ */
+{
+    LiveBlock* B = L->Blocks + Block;
+    Regs &= B->In & ~B->Gen;
+    if (Regs != REG_NONE) {
+        B->In &= ~Regs;
+        if (B->Lost == REG_NONE) {
+            L->Drop[(*Top)++] = Block;
+        }
+        B->Lost |= Regs;
+    }
+}
+
+
+
+static void CS_SolveLive (CodeSeg* S)
+/* Compute the live registers on entry of all blocks */
+{
+    RegLive* L    = S->Live;
+    unsigned Drop = 0;
+    unsigned I;
+
+    /* Update the blocks that were changed in place */
+    for (I = 0; I < L->ChangeCount; ++I) {
+        unsigned Block = L->Changed[I];
+        if (L->Blocks[Block].Dirty) {
+            CS_PlaceLiveBlocks (L);
+            CS_UpdateLiveBlock (S, Block, L->Blocks[Block].First, NO_ENTRY);
+        }
+    }
+
+    /* Registers that may no longer be live are removed from the blocks
+     * where they were, and from all blocks in front of them where they may
+     * have come from. This removes too many, but the missing ones are added
+     * back below.
+     */
+    for (I = 0; I < L->ChangeCount; ++I) {
+        unsigned Block = L->Changed[I];
+        L->Blocks[Block].Listed = 0;
+        if (L->Blocks[Block].Shrink) {
+            L->Blocks[Block].Shrink = 0;
+            CS_DropLive (L, Block, REG_ALL, &Drop);
+            CS_QueueLiveBlock (L, Block);
+        }
+    }
+    L->ChangeCount = 0;
+    while (Drop > 0) {
+        unsigned   Block = L->Drop[--Drop];
+        LiveBlock* B     = L->Blocks + Block;
+        unsigned   Regs  = B->Lost;
+        B->Lost = REG_NONE;
+        CS_QueueLiveBlock (L, Block);
+        if (B->Prev != NO_BLOCK) {
+            CS_DropLive (L, B->Prev, Regs, &Drop);
+        }
+        if (B->Head) {
+            unsigned LabelCount = CE_GetLabelCount (B->Head);
+            unsigned J, K;
+            for (J = 0; J < LabelCount; ++J) {
+                CodeLabel* Label = CE_GetLabel (B->Head, J);
+                for (K = 0; K < CL_GetRefCount (Label); ++K) {
+                    CS_DropLive (L, CL_GetRef (Label, K)->Block, Regs, &Drop);
+                }
+            }
+        }
+    }
+
+    /* Update blocks until nothing changes. If the registers live on entry of
+     * a block change, so may the ones of the blocks in front of it.
+     */
+    while (L->Top > 0) {
+        LiveBlock* B;
+        unsigned   In;
+        I = L->Work[--L->Top];
+        B = L->Blocks + I;
+        B->Queued = 0;
+        In = B->Gen | (CS_LiveOut (S, I) & ~B->Kill);
+        if (In != B->In) {
+            B->In = (unsigned short) In;
+            CS_QueueLivePreds (S, I);
+        }
+    }
+}
+
+
+
 /*****************************************************************************/
 /*		      Functions for parsing instructions		     */
 /*****************************************************************************/
@@ -464,6 +1283,8 @@ CodeSeg* NewCodeSeg (const char* SegName, SymEntry* Func)
     S->Func	= Func;
     InitCollection (&S->Entries);
     InitCollection (&S->Labels);
+    S->Live     = 0;
+    S->Index    = 0;
     for (I = 0; I < sizeof(S->LabelHash) / sizeof(S->LabelHash[0]); ++I) {
 	S->LabelHash[I] = 0;
     }
@@ -499,6 +1320,9 @@ void CS_AddEntry (CodeSeg* S, struct CodeEntry* E)
 
     /* Add the entry to the list of code entries in this segment */
     CollAppend (&S->Entries, E);
+    CS_InvalidateLive (S);
+    CS_IndexInserted (S, CS_GetEntryCount (S) - 1);
+    CS_MarkChanged (S, CS_GetEntryCount (S) - 1, 1);
 }
 
 
@@ -569,6 +1393,11 @@ void CS_InsertEntry (CodeSeg* S, struct CodeEntry* E, unsigned Index)
 {
     /* Insert the entry into the collection */
     CollInsert (&S->Entries, E, Index);
+    CS_MarkChanged (S, Index, 1);
+
+    /* Update the opcode index and the liveness info */
+    CS_IndexInserted (S, Index);
+    CS_LiveInserted (S, Index);
 }
 
 
@@ -584,6 +1413,9 @@ void CS_DelEntry (CodeSeg* S, unsigned Index)
     /* Get the code entry for the given index */
     CodeEntry* E = CS_GetEntry (S, Index);
 
+    /* Update the liveness info */
+    CS_LiveDeleting (S, Index);
+
     /* If the entry has a labels, we have to move this label to the next insn.
      * If there is no next insn, move the label into the code segement label
      * pool. The operation is further complicated by the fact that the next
@@ -606,8 +1438,10 @@ void CS_DelEntry (CodeSeg* S, unsigned Index)
      	    /* There is a next insn, get it */
      	    CodeEntry* N = CS_GetEntry (S, Index+1);
 
-     	    /* Move labels to the next entry */
-     	    CS_MoveLabels (S, E, N);
+     	    /* Move labels to the next entry. Since N is the start of a block
+             * once E is gone, this doesn't invalidate the liveness info.
+             */
+     	    CS_MoveAllLabels (S, E, N);
 
      	}
     }
@@ -621,6 +1455,8 @@ void CS_DelEntry (CodeSeg* S, unsigned Index)
     }
 
     /* Delete the pointer to the insn */
+    CS_MarkChanged (S, Index, 1);
+    CS_IndexDeleting (S, Index);
     CollDelete (&S->Entries, Index);
 
     /* Delete the instruction itself */
@@ -662,8 +1498,70 @@ void CS_MoveEntries (CodeSeg* S, unsigned Start, unsigned Count, unsigned NewPos
 	CS_MoveLabelsToEntry (S, CS_GetEntry (S, Start));
     }
 
+    /* Moving code changes the code flow */
+    CS_InvalidateLive (S);
+    CS_InvalidateIndex (S);
+
     /* Move the code block to the destination */
+    CS_MarkChanged (S, Start, Count);
     CollMoveMultiple (&S->Entries, Start, Count, NewPos);
+    CS_MarkChanged (S, NewPos, Count);
+}
+
+
+
+void CS_MoveEntry (CodeSeg* S, unsigned OldPos, unsigned NewPos)
+/* Move an entry from one position to another. OldPos is the current position
+ * of the entry, NewPos is the new position of the entry.
+ */
+{
+    CS_LiveDeleting (S, OldPos);
+    CS_IndexDeleting (S, OldPos);
+    CS_MarkChanged (S, OldPos, 1);
+    CollMove (&S->Entries, OldPos, NewPos);
+    if (NewPos > OldPos) {
+        /* The entry was removed before its new position */
+        --NewPos;
+    }
+    CS_MarkChanged (S, NewPos, 1);
+    CS_IndexInserted (S, NewPos);
+    CS_LiveInserted (S, NewPos);
+}
+
+
+
+void CS_ReplaceOPC (CodeSeg* S, struct CodeEntry* E, opc_t OPC)
+/* Replace the opcode of an entry of the segment, see CE_ReplaceOPC. Other
+ * than the latter, this will keep the liveness info of the segment.
+ */
+{
+    RegLive*  L    = CS_GetValidLive (S);
+    OPCIndex* X    = CS_GetValidIndex (S);
+    int       Ends = CS_EndsLiveBlock (E);
+
+    /* Replace the opcode, and in the index if there is one */
+    if (X) {
+        unsigned Index = CS_FindEntryIndex (S, E);
+        CE_ReplaceOPC (E, OPC);
+        if (Index < CS_GetEntryCount (S)) {
+            X->OPCs[Index] = (unsigned char) OPC;
+            X->Changes     = CodeEntryChanges;
+        }
+    } else {
+        CE_ReplaceOPC (E, OPC);
+    }
+
+    /* As long as the block structure is unchanged, only the block of the
+     * entry needs an update.
+     */
+    if (L && CS_EndsLiveBlock (E) == Ends) {
+        L->Changes = CodeEntryChanges;
+        if (Ends) {
+            CS_ShrinkLiveBlock (L, E->Block);
+        }
+        CS_ListLiveBlock (L, E->Block);
+        L->Blocks[E->Block].Dirty = 1;
+    }
 }
 
 
@@ -725,13 +1623,46 @@ int CS_GetEntries (CodeSeg* S, struct CodeEntry** List,
 unsigned CS_GetEntryIndex (CodeSeg* S, struct CodeEntry* E)
 /* Return the index of a code entry */
 {
-    int Index = CollIndex (&S->Entries, E);
-    CHECK (Index >= 0);
+    unsigned Index = CS_FindEntryIndex (S, E);
+    CHECK (Index < CS_GetEntryCount (S));
     return Index;
 }
 
 
 
+unsigned CS_FindOPC (CodeSeg* S, opc_t OPC, unsigned Start)
+/* Return the index of the first entry with the given opcode at Start or
+ * behind it. If there is no such entry, return the number of entries.
+ */
+{
+    unsigned             Count = CS_GetEntryCount (S);
+    const unsigned char* P;
+
+    if (Start >= Count) {
+        return Count;
+    }
+    P = memchr (CS_BuildIndex (S)->OPCs + Start, OPC, Count - Start);
+    return P? (unsigned) (P - S->Index->OPCs) : Count;
+}
+
+
+
+unsigned CS_FindCall (CodeSeg* S, const char* Name, unsigned Start)
+/* Return the index of the first call to the function with the given name at
+ * Start or behind it. If there is no such call, return the number of entries.
+ */
+{
+    unsigned    Count = CS_GetEntryCount (S);
+    const char* Arg   = GetPooledArg (Name);
+    unsigned    I     = CS_FindOPC (S, OP65_JSR, Start);
+    while (I < Count && CS_GetEntry (S, I)->Arg != Arg) {
+        I = CS_FindOPC (S, OP65_JSR, I + 1);
+    }
+    return I;
+}
+
+
+
 int CS_RangeHasLabel (CodeSeg* S, unsigned Start, unsigned Count)
 /* Return true if any of the code entries in the given range has a label
  * attached. If the code segment does not span the given range, check the
@@ -847,6 +1778,7 @@ void CS_DelLabel (CodeSeg* S, CodeLabel* L)
        	CodeEntry* E = CollAt (&L->JumpFrom, I);
        	/* Remove the reference */
        	CE_ClearJumpTo (E);
+        CS_LiveFlowChanged (S, E);
     }
     CollDeleteAll (&L->JumpFrom);
 
@@ -857,6 +1789,7 @@ void CS_DelLabel (CodeSeg* S, CodeLabel* L)
      */
     if (L->Owner) {
        	CollDeleteItem (&L->Owner->Labels, L);
+        CE_MarkChanged (L->Owner);
     }
 
     /* All references removed, delete the label itself */
@@ -873,6 +1806,9 @@ void CS_MergeLabels (CodeSeg* S)
     unsigned I;
     unsigned J;
 
+    /* Moving references changes the code flow */
+    CS_InvalidateLive (S);
+
     /* First, remove all labels from the label symbol table that don't have an
      * owner (this means that they are actually external labels but we didn't
      * know that previously since they may have also been forward references).
@@ -897,6 +1833,7 @@ void CS_MergeLabels (CodeSeg* S)
                      * which is not what we want.
                      */
 		    E->JumpTo = 0;
+                    CE_MarkChanged (E);
 	   	}
 
 		/* Print some debugging output */
@@ -968,37 +1905,12 @@ void CS_MoveLabels (CodeSeg* S, struct CodeEntry* Old, struct CodeEntry* New)
  * afterwards.
  */
 {
-    /* Get the number of labels to move */
-    unsigned OldLabelCount = CE_GetLabelCount (Old);
+    CS_MoveAllLabels (S, Old, New);
 
-    /* Does the new entry have itself a label? */
+    /* The jumps to Old go to New now */
     if (CE_HasLabel (New)) {
-
-	/* The new entry does already have a label - move references */
-	CodeLabel* NewLabel = CE_GetLabel (New, 0);
-	while (OldLabelCount--) {
-
-	    /* Get the next label */
-	    CodeLabel* OldLabel = CE_GetLabel (Old, OldLabelCount);
-
-	    /* Move references */
-	    CL_MoveRefs (OldLabel, NewLabel);
-
-	    /* Delete the label */
-	    CS_DelLabel (S, OldLabel);
-
-     	}
-
-    } else {
-
-	/* The new entry does not have a label, just move them */
-	while (OldLabelCount--) {
-
-	    /* Move the label to the new entry */
-	    CE_MoveLabel (CE_GetLabel (Old, OldLabelCount), New);
-
-	}
-
+        CS_LiveJumpsChanged (S, New);
+        CS_LiveTargetChanged (S, CE_GetLabel (New, 0));
     }
 }
 
@@ -1017,6 +1929,7 @@ void CS_RemoveLabelRef (CodeSeg* S, struct CodeEntry* E)
 
     /* Delete the entry from the label */
     CollDeleteItem (&L->JumpFrom, E);
+    CS_LiveFlowChanged (S, E);
 
     /* The entry jumps no longer to L */
     CE_ClearJumpTo (E);
@@ -1046,6 +1959,7 @@ void CS_MoveLabelRef (CodeSeg* S, struct CodeEntry* E, CodeLabel* L)
 
     /* Use the new label */
     CL_AddRef (L, E);
+    CS_LiveTargetChanged (S, L);
 }
 
 
@@ -1063,6 +1977,10 @@ void CS_DelCodeRange (CodeSeg* S, unsigned First, unsigned Last)
     /* Do some sanity checks */
     CHECK (First <= Last && Last < CS_GetEntryCount (S));
 
+    /* Deleting code blocks changes the code flow */
+    CS_InvalidateLive (S);
+    CS_InvalidateIndex (S);
+
     /* If Last is actually the last insn, call CS_DelCodeAfter instead, which
      * is more flexible in this case.
      */
@@ -1121,6 +2039,7 @@ void CS_DelCodeRange (CodeSeg* S, unsigned First, unsigned Last)
     	CHECK (!CE_HasLabel (E));
 
 	/* Delete the pointer to the entry */
+        CS_MarkChanged (S, I, 1);
 	CollDelete (&S->Entries, I);
 
 	/* Delete the entry itself */
@@ -1136,6 +2055,10 @@ void CS_DelCodeAfter (CodeSeg* S, unsigned Last)
     /* Get the number of entries in this segment */
     unsigned Count = CS_GetEntryCount (S);
 
+    /* Deleting code changes the code flow */
+    CS_InvalidateLive (S);
+    CS_InvalidateIndex (S);
+
     /* First pass: Delete all references to labels. If the reference count
      * for a label drops to zero, delete it.
      */
@@ -1181,6 +2104,7 @@ void CS_DelCodeAfter (CodeSeg* S, unsigned Last)
 	}
 
 	/* Delete the pointer to the entry */
+        CS_MarkChanged (S, C, 1);
 	CollDelete (&S->Entries, C);
 
 	/* Delete the entry itself */
@@ -1678,3 +2602,64 @@ void CS_GenRegInfo (CodeSeg* S)
 
 
 
+unsigned CS_GetLiveRegs (CodeSeg* S, unsigned Index, unsigned Wanted)
+/* Of the registers in Wanted, return the ones that are live at the entry
+ * with the given index, that is, used on at least one path through the code
+ * starting at this entry before they're changed.
+ */
+{
+    unsigned   Count = CS_GetEntryCount (S);
+    unsigned   Used  = REG_NONE;
+    unsigned   Known = REG_NONE;
+    CodeEntry* E;
+    RegLive*   L;
+
+    /* There is nothing behind the last entry */
+    if (Index >= Count) {
+        return REG_NONE;
+    }
+
+    /* Walk the straight code behind the entry. Most of the time, this is
+     * enough to find out about the registers wanted.
+     */
+    while (1) {
+        E = CS_GetEntry (S, Index);
+        Used  |= CS_LiveBefore (S, E, REG_NONE) & ~Known;
+        Known |= E->Use | E->Chg;
+        if ((Wanted & ~Known) == 0) {
+            return Used & Wanted;
+        }
+        if (CS_EndsLiveBlock (E)) {
+            break;
+        }
+        if (++Index == Count) {
+            /* Falling off the end leaves the function */
+            return (Used | (S->ExitRegs & ~Known)) & Wanted;
+        }
+    }
+
+    /* E is the last entry of its block, so the registers live behind it are
+     * the ones live at the end of the block. Create or update the liveness
+     * info if needed.
+     */
+    if ((L = S->Live) == 0) {
+        L = S->Live = xmalloc (sizeof (RegLive));
+        L->Blocks  = 0;
+        L->Work    = 0;
+        L->Drop    = 0;
+        L->Changed = 0;
+        L->Count   = 0;
+        L->Size    = 0;
+        L->Valid   = 0;
+    }
+    if (CS_GetValidLive (S) == 0) {
+        CS_BuildLiveBlocks (S);
+    }
+    if (L->ChangeCount > 0 || L->Top > 0) {
+        CS_SolveLive (S);
+    }
+    return (Used | (CS_LiveOut (S, E->Block) & ~Known)) & Wanted;
+}
+
+
+
@@ -48,6 +48,7 @@
 /* cc65 */
 #include "codelab.h"
 #include "lineinfo.h"
+#include "opcodes.h"
 #include "symentry.h"
 
 
@@ -68,6 +69,12 @@ struct CodeEntry;
 
 
 
+/* Register liveness info, private to codeseg.c */
+typedef struct RegLive RegLive;
+
+/* Opcode index, private to codeseg.c */
+typedef struct OPCIndex OPCIndex;
+
 /* Size of the label hash table */
 #define CS_LABEL_HASH_SIZE	29
 
@@ -80,6 +87,8 @@ struct CodeSeg {
     Collection	    Labels;	  		/* Labels for next insn */
     CodeLabel* 	    LabelHash[CS_LABEL_HASH_SIZE]; /* Label hash table */
     unsigned short  ExitRegs;			/* Register use on exit */
+    RegLive*        Live;                       /* Register liveness */
+    OPCIndex*       Index;                      /* Opcodes of the entries */
 
     /* Optimization settings for this segment */
     unsigned char   Optimize;                   /* On/off switch */
@@ -145,17 +154,15 @@ void CS_MoveEntries (CodeSeg* S, unsigned Start, unsigned Count, unsigned NewPos
  * current code end)
  */
 
-#if defined(HAVE_INLINE)
-INLINE void CS_MoveEntry (CodeSeg* S, unsigned OldPos, unsigned NewPos)
+void CS_MoveEntry (CodeSeg* S, unsigned OldPos, unsigned NewPos);
 /* Move an entry from one position to another. OldPos is the current position
  * of the entry, NewPos is the new position of the entry.
  */
-{
-    CollMove (&S->Entries, OldPos, NewPos);
-}
-#else
-#  define CS_MoveEntry(S, OldPos, NewPos)       CollMove (&(S)->Entries, OldPos, NewPos)
-#endif
+
+void CS_ReplaceOPC (CodeSeg* S, struct CodeEntry* E, opc_t OPC);
+/* Replace the opcode of an entry of the segment, see CE_ReplaceOPC. Other
+ * than the latter, this will keep the liveness info of the segment.
+ */
 
 #if defined(HAVE_INLINE)
 INLINE struct CodeEntry* CS_GetEntry (CodeSeg* S, unsigned Index)
@@ -186,6 +193,16 @@ int CS_GetEntries (CodeSeg* S, struct CodeEntry** List,
 unsigned CS_GetEntryIndex (CodeSeg* S, struct CodeEntry* E);
 /* Return the index of a code entry */
 
+unsigned CS_FindOPC (CodeSeg* S, opc_t OPC, unsigned Start);
+/* Return the index of the first entry with the given opcode at Start or
+ * behind it. If there is no such entry, return the number of entries.
+ */
+
+unsigned CS_FindCall (CodeSeg* S, const char* Name, unsigned Start);
+/* Return the index of the first call to the function with the given name at
+ * Start or behind it. If there is no such call, return the number of entries.
+ */
+
 int CS_RangeHasLabel (CodeSeg* S, unsigned Start, unsigned Count);
 /* Return true if any of the code entries in the given range has a label
  * attached. If the code segment does not span the given range, check the
@@ -294,6 +311,12 @@ void CS_FreeRegInfo (CodeSeg* S);
 void CS_GenRegInfo (CodeSeg* S);
 /* Generate register infos for all instructions */
 
+unsigned CS_GetLiveRegs (CodeSeg* S, unsigned Index, unsigned Wanted);
+/* Of the registers in Wanted, return the ones that are live at the entry
+ * with the given index, that is, used on at least one path through the code
+ * starting at this entry before they're changed.
+ */
+
 
 
 /* End of codeseg.h */
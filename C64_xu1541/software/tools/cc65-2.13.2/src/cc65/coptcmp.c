@@ -87,11 +87,11 @@ static void ReplaceCmp (CodeSeg* S, unsigned I, cmp_t Cond)
     switch (Cond) {
 
 	case CMP_EQ:
-	    CE_ReplaceOPC (E, OP65_JEQ);
+	    CS_ReplaceOPC (S, E, OP65_JEQ);
 	    break;
 
 	case CMP_NE:
-	    CE_ReplaceOPC (E, OP65_JNE);
+	    CS_ReplaceOPC (S, E, OP65_JNE);
 	    break;
 
 	case CMP_GT:
@@ -107,15 +107,15 @@ static void ReplaceCmp (CodeSeg* S, unsigned I, cmp_t Cond)
 	    L = CS_GenLabel (S, N);
 	    N = NewCodeEntry (OP65_BEQ, AM65_BRA, L->Name, L, E->LI);
 	    CS_InsertEntry (S, N, I);
-	    CE_ReplaceOPC (E, OP65_JPL);
+	    CS_ReplaceOPC (S, E, OP65_JPL);
 	    break;
 
 	case CMP_GE:
-	    CE_ReplaceOPC (E, OP65_JPL);
+	    CS_ReplaceOPC (S, E, OP65_JPL);
 	    break;
 
 	case CMP_LT:
-	    CE_ReplaceOPC (E, OP65_JMI);
+	    CS_ReplaceOPC (S, E, OP65_JMI);
 	    break;
 
 	case CMP_LE:
@@ -123,7 +123,7 @@ static void ReplaceCmp (CodeSeg* S, unsigned I, cmp_t Cond)
 	     * 	   jmi Target
 	     *     jeq Target
 	     */
-	    CE_ReplaceOPC (E, OP65_JMI);
+	    CS_ReplaceOPC (S, E, OP65_JMI);
 	    L = E->JumpTo;
 	    N = NewCodeEntry (OP65_JEQ, AM65_BRA, L->Name, L, E->LI);
 	    CS_InsertEntry (S, N, I+1);
@@ -142,15 +142,15 @@ static void ReplaceCmp (CodeSeg* S, unsigned I, cmp_t Cond)
 	    L = CS_GenLabel (S, N);
 	    N = NewCodeEntry (OP65_BEQ, AM65_BRA, L->Name, L, E->LI);
 	    CS_InsertEntry (S, N, I);
-	    CE_ReplaceOPC (E, OP65_JCS);
+	    CS_ReplaceOPC (S, E, OP65_JCS);
 	    break;
 
 	case CMP_UGE:
-	    CE_ReplaceOPC (E, OP65_JCS);
+	    CS_ReplaceOPC (S, E, OP65_JCS);
 	    break;
 
 	case CMP_ULT:
-	    CE_ReplaceOPC (E, OP65_JCC);
+	    CS_ReplaceOPC (S, E, OP65_JCC);
 	    break;
 
 	case CMP_ULE:
@@ -158,7 +158,7 @@ static void ReplaceCmp (CodeSeg* S, unsigned I, cmp_t Cond)
 	     * 	   jcc Target
 	     *     jeq Target
 	     */
-	    CE_ReplaceOPC (E, OP65_JCC);
+	    CS_ReplaceOPC (S, E, OP65_JCC);
 	    L = E->JumpTo;
 	    N = NewCodeEntry (OP65_JEQ, AM65_BRA, L->Name, L, E->LI);
 	    CS_InsertEntry (S, N, I+1);
@@ -531,7 +531,7 @@ unsigned OptCmp4 (CodeSeg* S)
 
       	    if ((L[4]->Info & OF_FBRA) != 0 && L[1]->Num == 0 && L[3]->Num == 0) {
 		/* The value is zero, we may use the simple code version. */
-		CE_ReplaceOPC (L[0], OP65_ORA);
+		CS_ReplaceOPC (S, L[0], OP65_ORA);
 		CS_DelEntries (S, I+2, 3);
        	    } else {
 		/* Move the lda instruction after the first branch. This will
@@ -541,8 +541,8 @@ unsigned OptCmp4 (CodeSeg* S)
 		CS_MoveEntry (S, I, I+4);
 
 		/* We will replace the ldx/cpx by lda/cmp */
-	    	CE_ReplaceOPC (L[0], OP65_LDA);
-		CE_ReplaceOPC (L[1], OP65_CMP);
+	    	CS_ReplaceOPC (S, L[0], OP65_LDA);
+		CS_ReplaceOPC (S, L[1], OP65_CMP);
 
 		/* Beware: If the first LDA instruction had a label, we have
 	     	 * to move this label to the top of the sequence again.
@@ -790,6 +790,14 @@ unsigned OptCmp8 (CodeSeg* S)
     unsigned Changes = 0;
     unsigned I;
 
+    /* Nothing to do without a compare */
+    I = CS_GetEntryCount (S);
+    if (CS_FindOPC (S, OP65_CMP, 0) >= I &&
+        CS_FindOPC (S, OP65_CPX, 0) >= I &&
+        CS_FindOPC (S, OP65_CPY, 0) >= I) {
+        return 0;
+    }
+
     /* Generate register info for this step */
     CS_GenRegInfo (S);
 
@@ -943,8 +951,8 @@ unsigned OptCmp9 (CodeSeg* S)
 
 	    /* Replace the branch condition */
 	    switch (GetBranchCond (L[4]->OPC)) {
-                case BC_CC:     CE_ReplaceOPC (L[4], OP65_JPL); break;
-                case BC_CS:     CE_ReplaceOPC (L[4], OP65_JMI); break;
+                case BC_CC:     CS_ReplaceOPC (S, L[4], OP65_JPL); break;
+                case BC_CS:     CS_ReplaceOPC (S, L[4], OP65_JMI); break;
                 default:        Internal ("Unknown branch condition in OptCmp9");
             }
 
@@ -562,7 +562,7 @@ unsigned OptRTS (CodeSeg* S)
 
 	    /* Change the jsr to a jmp and use the additional info for a jump */
        	    E->AM = AM65_BRA;
-	    CE_ReplaceOPC (E, OP65_JMP);
+	    CS_ReplaceOPC (S, E, OP65_JMP);
 
        	    /* Remember, we had changes */
 	    ++Changes;
@@ -810,7 +810,7 @@ unsigned OptCondBranches1 (CodeSeg* S)
      	    	       (BC == BC_MI && (E->Num & 0x80) != 0)) {
 
      		/* The branch is always taken, replace it by a jump */
-     		CE_ReplaceOPC (N, OP65_JMP);
+     		CS_ReplaceOPC (S, N, OP65_JMP);
 
      		/* Remember, we had changes */
      		++Changes;
@@ -828,7 +828,7 @@ unsigned OptCondBranches1 (CodeSeg* S)
       	    /* Replace the jump by a conditional branch with the inverse branch
       	     * condition than the branch around it.
       	     */
-      	    CE_ReplaceOPC (N, GetInverseBranch (E->OPC));
+      	    CS_ReplaceOPC (S, N, GetInverseBranch (E->OPC));
 
       	    /* Remove the conditional branch */
       	    CS_DelEntry (S, I);
@@ -857,12 +857,17 @@ unsigned OptCondBranches2 (CodeSeg* S)
     unsigned Changes = 0;
     unsigned I;
 
+    /* Nothing to do without a rol */
+    if (CS_FindOPC (S, OP65_ROL, 0) >= CS_GetEntryCount (S)) {
+        return 0;
+    }
+
     /* Generate register info for this step */
     CS_GenRegInfo (S);
 
-    /* Walk over the entries */
+    /* Walk over the rol instructions */
     I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindOPC (S, OP65_ROL, I)) < CS_GetEntryCount (S)) {
 
        	CodeEntry* N;
 
@@ -870,8 +875,7 @@ unsigned OptCondBranches2 (CodeSeg* S)
        	CodeEntry* E = CS_GetEntry (S, I);
 
 	/* Check if it's a rol insn with A in accu and a branch follows */
-       	if (E->OPC == OP65_ROL                  &&
-            E->AM == AM65_ACC                   &&
+       	if (E->AM == AM65_ACC                   &&
             E->RI->In.RegA == 0                 &&
             !CE_HasLabel (E)                    &&
             (N = CS_GetNextEntry (S, I)) != 0   &&
@@ -880,8 +884,8 @@ unsigned OptCondBranches2 (CodeSeg* S)
 
 	    /* Replace the branch condition */
 	    switch (GetBranchCond (N->OPC)) {
-                case BC_EQ:     CE_ReplaceOPC (N, OP65_JCC); break;
-                case BC_NE:     CE_ReplaceOPC (N, OP65_JCS); break;
+                case BC_EQ:     CS_ReplaceOPC (S, N, OP65_JCC); break;
+                case BC_NE:     CS_ReplaceOPC (S, N, OP65_JCS); break;
                 default:        Internal ("Unknown branch condition in OptCondBranches2");
             }
 
@@ -1110,7 +1114,7 @@ unsigned OptDupLoads (CodeSeg* S)
 		    	   E->AM != AM65_ABSY         &&
 		    	   E->AM != AM65_ZPY) {
 	 	    /* Use the A register instead */
-       		    CE_ReplaceOPC (E, OP65_STA);
+       		    CS_ReplaceOPC (S, E, OP65_STA);
 		}
 	        break;
 
@@ -1134,11 +1138,11 @@ unsigned OptDupLoads (CodeSeg* S)
 		 */
        	        } else if (RegValIsKnown (In->RegY)) {
 		    if (In->RegY == In->RegA) {
-       		     	CE_ReplaceOPC (E, OP65_STA);
+       		     	CS_ReplaceOPC (S, E, OP65_STA);
 		    } else if (In->RegY == In->RegX   &&
 		     	       E->AM != AM65_ABSX     &&
 		     	       E->AM != AM65_ZPX) {
-		    	CE_ReplaceOPC (E, OP65_STX);
+		    	CS_ReplaceOPC (S, E, OP65_STX);
 		    }
 		}
 	        break;
@@ -1973,7 +1977,7 @@ unsigned OptPrecalc (CodeSeg* S)
                     Arg = MakeHexArg (Out->RegA);
                 } else if (In->RegA == 0xFF) {
                     /* AND but A contains 0xFF - replace by lda */
-                    CE_ReplaceOPC (E, OP65_LDA);
+                    CS_ReplaceOPC (S, E, OP65_LDA);
                     ++Changes;
                 }
                 break;
@@ -1991,7 +1995,7 @@ unsigned OptPrecalc (CodeSeg* S)
                     Arg = MakeHexArg (Out->RegA);
                 } else if (In->RegA == 0) {
                     /* ORA but A contains 0x00 - replace by lda */
-                    CE_ReplaceOPC (E, OP65_LDA);
+                    CS_ReplaceOPC (S, E, OP65_LDA);
                     ++Changes;
                 }
                 break;
@@ -2052,18 +2056,18 @@ unsigned OptBranchDist (CodeSeg* S)
 		/* Make the branch short/long according to distance */
 	    	if ((E->Info & OF_LBRA) == 0 && !IsShort) {
 		    /* Short branch but long distance */
-		    CE_ReplaceOPC (E, MakeLongBranch (E->OPC));
+		    CS_ReplaceOPC (S, E, MakeLongBranch (E->OPC));
 		    ++Changes;
 		} else if ((E->Info & OF_LBRA) != 0 && IsShort) {
 		    /* Long branch but short distance */
-		    CE_ReplaceOPC (E, MakeShortBranch (E->OPC));
+		    CS_ReplaceOPC (S, E, MakeShortBranch (E->OPC));
 		    ++Changes;
 		}
 
 	    } else if ((E->Info & OF_LBRA) == 0) {
 
 		/* Short branch to external symbol - make it long */
-		CE_ReplaceOPC (E, MakeLongBranch (E->OPC));
+		CS_ReplaceOPC (S, E, MakeLongBranch (E->OPC));
 		++Changes;
 
 	    }
@@ -2074,7 +2078,7 @@ unsigned OptBranchDist (CodeSeg* S)
 		   IsShortDist (GetBranchDist (S, I, E->JumpTo->Owner))) {
 
 	    /* The jump is short and may be replaced by a BRA on the 65C02 CPU */
-	    CE_ReplaceOPC (E, OP65_BRA);
+	    CS_ReplaceOPC (S, E, OP65_BRA);
 	    ++Changes;
 	}
 
@@ -138,7 +138,7 @@ unsigned OptNegA2 (CodeSeg* S)
 	    !CE_HasLabel (L[1])) {
 
 	    /* Invert the branch */
-	    CE_ReplaceOPC (L[1], GetInverseBranch (L[1]->OPC));
+	    CS_ReplaceOPC (S, L[1], GetInverseBranch (L[1]->OPC));
 
 	    /* Delete the subroutine call */
 	    CS_DelEntry (S, I+1);
@@ -261,7 +261,7 @@ unsigned OptNegAX2 (CodeSeg* S)
 	    CS_InsertEntry (S, X, I+3);
 
   	    /* Invert the branch */
-       	    CE_ReplaceOPC (L[3], GetInverseBranch (L[3]->OPC));
+       	    CS_ReplaceOPC (S, L[3], GetInverseBranch (L[3]->OPC));
 
       	    /* Delete the entries no longer needed. */
        	    CS_DelEntries (S, I+4, 2);
@@ -319,10 +319,10 @@ unsigned OptNegAX3 (CodeSeg* S)
 	    !CE_HasLabel (L[2])) {
 
 	    /* ldx --> ora */
-	    CE_ReplaceOPC (L[0], OP65_ORA);
+	    CS_ReplaceOPC (S, L[0], OP65_ORA);
 
 	    /* Invert the branch */
-       	    CE_ReplaceOPC (L[2], GetInverseBranch (L[2]->OPC));
+       	    CS_ReplaceOPC (S, L[2], GetInverseBranch (L[2]->OPC));
 
 	    /* Delete the subroutine call */
        	    CS_DelEntry (S, I+2);
@@ -399,7 +399,7 @@ unsigned OptNegAX4 (CodeSeg* S)
 	    CS_DelEntry (S, I+1);
 
 	    /* Invert the branch */
-       	    CE_ReplaceOPC (L[1], GetInverseBranch (L[1]->OPC));
+       	    CS_ReplaceOPC (S, L[1], GetInverseBranch (L[1]->OPC));
 
 	    /* Remember, we had changes */
 	    ++Changes;
@@ -78,13 +78,14 @@ unsigned OptPtrLoad1 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 8 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 8)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[9];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 8;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -198,13 +199,14 @@ unsigned OptPtrLoad2 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 8 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 8)) < CS_GetEntryCount (S)) {
 
    	CodeEntry* L[9];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 8;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -279,14 +281,15 @@ unsigned OptPtrLoad3 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 7 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 7)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[8];
 	unsigned Len;
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 7;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -376,14 +379,15 @@ unsigned OptPtrLoad4 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 8 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 8)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[9];
 	unsigned Len;
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 8;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -482,13 +486,14 @@ unsigned OptPtrLoad5 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 5 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 5)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[6];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 5;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -571,13 +576,14 @@ unsigned OptPtrLoad6 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 6 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 6)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[7];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 6;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -683,16 +689,22 @@ unsigned OptPtrLoad7 (CodeSeg* S)
     unsigned Changes = 0;
     unsigned I;
 
+    /* Nothing to do without a call to ldaxidx */
+    if (CS_FindCall (S, "ldaxidx", 0) >= CS_GetEntryCount (S)) {
+        return 0;
+    }
+
     /* Generate register info */
     CS_GenRegInfo (S);
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldaxidx, the sequence starts 9 entries before */
     I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldaxidx", I + 9)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[10];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 9;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -863,13 +875,14 @@ unsigned OptPtrLoad11 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 5 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 5)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[6];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 5;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -963,14 +976,15 @@ unsigned OptPtrLoad12 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 13 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 13)) < CS_GetEntryCount (S)) {
 
        	CodeEntry* L[15];
 	unsigned Len;
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 13;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -1091,14 +1105,15 @@ unsigned OptPtrLoad13 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 3 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 3)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[4];
 	unsigned Len;
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 3;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -1165,17 +1180,23 @@ unsigned OptPtrLoad14 (CodeSeg* S)
     unsigned Changes = 0;
     unsigned I;
 
+    /* Nothing to do without a call to ldauidx */
+    if (CS_FindCall (S, "ldauidx", 0) >= CS_GetEntryCount (S)) {
+        return 0;
+    }
+
     /* Generate register info */
     CS_GenRegInfo (S);
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 4 entries before */
     I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 4)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[5];
 	unsigned Len;
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 4;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -1241,14 +1262,15 @@ unsigned OptPtrLoad15 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldaxidx, the sequence starts 3 entries before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldaxidx", I + 3)) < CS_GetEntryCount (S)) {
 
 	CodeEntry* L[4];
 	unsigned Len;
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 3;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -1319,13 +1341,14 @@ unsigned OptPtrLoad16 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldauidx, the sequence starts 1 entry before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldauidx", I + 1)) < CS_GetEntryCount (S)) {
 
     	CodeEntry* L[2];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 1;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
@@ -1399,13 +1422,14 @@ unsigned OptPtrLoad17 (CodeSeg* S)
 {
     unsigned Changes = 0;
 
-    /* Walk over the entries */
+    /* Walk over the calls to ldaxidx, the sequence starts 1 entry before */
     unsigned I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindCall (S, "ldaxidx", I + 1)) < CS_GetEntryCount (S)) {
 
     	CodeEntry* L[2];
 
-      	/* Get next entry */
+      	/* Get the first entry of the sequence */
+       	I -= 1;
        	L[0] = CS_GetEntry (S, I);
 
      	/* Check for the sequence */
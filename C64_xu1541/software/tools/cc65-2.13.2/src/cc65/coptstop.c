@@ -1734,6 +1734,11 @@ unsigned OptStackOps (CodeSeg* S)
     } State = Initialize;
 
 
+    /* Nothing to do without a call to pushax */
+    if (CS_FindCall (S, "pushax", 0) >= CS_GetEntryCount (S)) {
+        return 0;
+    }
+
     /* Generate register info */
     CS_GenRegInfo (S);
 
@@ -153,7 +153,7 @@ unsigned OptSub2 (CodeSeg* S)
 	     * op to SBC.
 	     */
 	    CS_MoveEntry (S, I, I+3);
-	    CE_ReplaceOPC (E, OP65_SBC);
+	    CS_ReplaceOPC (S, E, OP65_SBC);
 
 	    /* If the sequence head had a label, move this label back to the
 	     * head.
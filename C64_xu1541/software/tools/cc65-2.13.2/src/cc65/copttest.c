@@ -70,12 +70,17 @@ unsigned OptTest1 (CodeSeg* S)
     unsigned Changes = 0;
     unsigned I;
 
+    /* Nothing to do without a stx */
+    if (CS_FindOPC (S, OP65_STX, 0) >= CS_GetEntryCount (S)) {
+        return 0;
+    }
+
     /* Generate register info for this step */
     CS_GenRegInfo (S);
 
-    /* Walk over the entries */
+    /* Walk over the stx instructions */
     I = 0;
-    while (I < CS_GetEntryCount (S)) {
+    while ((I = CS_FindOPC (S, OP65_STX, I)) < CS_GetEntryCount (S)) {
 
     	CodeEntry* L[3];
 
@@ -83,8 +88,7 @@ unsigned OptTest1 (CodeSeg* S)
        	L[0] = CS_GetEntry (S, I);
 
     	/* Check if it's the sequence we're searching for */
-    	if (L[0]->OPC == OP65_STX              &&
-    	    CS_GetEntries (S, L+1, I+1, 2)     &&
+    	if (CS_GetEntries (S, L+1, I+1, 2)     &&
     	    !CE_HasLabel (L[1])                &&
     	    L[1]->OPC == OP65_ORA              &&
     	    strcmp (L[0]->Arg, L[1]->Arg) == 0 &&
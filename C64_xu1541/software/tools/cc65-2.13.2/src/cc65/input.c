@@ -36,12 +36,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
-#include <sys/types.h>
-#include <sys/stat.h>
 
 /* common */
 #include "check.h"
 #include "coll.h"
+#include "filecache.h"
 #include "print.h"
 #include "xmalloc.h"
 
@@ -73,9 +72,10 @@ char NextC = '\0';
 /* Struct that describes an active input file */
 typedef struct AFile AFile;
 struct AFile {
-    unsigned	Line; 	 	/* Line number for this file 		*/
-    FILE*   	F;    	 	/* Input file stream 			*/
-    IFile*      Input;          /* Points to corresponding IFile        */
+    unsigned	        Line;   /* Line number for this file 		*/
+    const CachedFile*   F;      /* Contents of the input file           */
+    unsigned long       Pos;    /* Read position in the contents        */
+    IFile*              Input;  /* Points to corresponding IFile        */
 };
 
 /* List of all input files */
@@ -126,7 +126,7 @@ static IFile* NewIFile (const char* Name)
 
 
 
-static AFile* NewAFile (IFile* IF, FILE* F)
+static AFile* NewAFile (IFile* IF, const CachedFile* F)
 /* Create and return a new AFile */
 {
     /* Allocate a AFile structure */
@@ -135,6 +135,7 @@ static AFile* NewAFile (IFile* IF, FILE* F)
     /* Initialize the fields */
     AF->Line  = 0;
     AF->F     = F;
+    AF->Pos   = 0;
     AF->Input = IF;
 
     /* Increment the usage counter of the corresponding IFile. If this
@@ -143,21 +144,9 @@ static AFile* NewAFile (IFile* IF, FILE* F)
      */
     if (IF->Usage++ == 0) {
 
-	/* Get file size and modification time. There a race condition here,
-         * since we cannot use fileno() (non standard identifier in standard
-         * header file), and therefore not fstat. When using stat with the
-         * file name, there's a risk that the file was deleted and recreated
-         * while it was open. Since mtime and size are only used to check
-         * if a file has changed in the debugger, we will ignore this problem
-         * here.
-         */
-	struct stat Buf;
-	if (stat (IF->Name, &Buf) != 0) {
-	    /* Error */
-	    Fatal ("Cannot stat `%s': %s", IF->Name, strerror (errno));
-	}
-       	IF->Size  = (unsigned long) Buf.st_size;
-	IF->MTime = (unsigned long) Buf.st_mtime;
+	/* Remember file size and modification time */
+       	IF->Size  = F->Size;
+	IF->MTime = F->MTime;
 
 	/* Set the debug data */
 	g_fileinfo (IF->Name, IF->Size, IF->MTime);
@@ -218,8 +207,8 @@ void OpenMainFile (const char* Name)
     /* Setup a new IFile structure for the main file */
     IFile* IF = NewIFile (Name);
 
-    /* Open the file for reading */
-    FILE* F = fopen (Name, "r");
+    /* Read the file */
+    const CachedFile* F = FCacheOpen (Name);
     if (F == 0) {
        	/* Cannot open */
        	Fatal ("Cannot open input file `%s': %s", Name, strerror (errno));
@@ -242,9 +231,9 @@ void OpenMainFile (const char* Name)
 void OpenIncludeFile (const char* Name, unsigned DirSpec)
 /* Open an include file and insert it into the tables. */
 {
-    char*  N;
-    FILE*  F;
-    IFile* IF;
+    char*             N;
+    const CachedFile* F;
+    IFile*            IF;
 
     /* Check for the maximum include nesting */
     if (CollCount (&AFiles) > MAX_INC_NESTING) {
@@ -270,8 +259,8 @@ void OpenIncludeFile (const char* Name, unsigned DirSpec)
     /* We don't need N any longer, since we may now use IF->Name */
     xfree (N);
 
-    /* Open the file */
-    F = fopen (IF->Name, "r");
+    /* Read the file. Headers included more than once are read only once. */
+    F = FCacheOpen (IF->Name);
     if (F == 0) {
 	/* Error opening the file */
 	PPError ("Cannot open include file `%s': %s", IF->Name, strerror (errno));
@@ -303,8 +292,8 @@ static void CloseIncludeFile (void)
     /* Get the current active input file */
     Input = (AFile*) CollLast (&AFiles);
 
-    /* Close the current input file (we're just reading so no error check) */
-    fclose (Input->F);
+    /* We don't need the contents of the file any longer */
+    FCacheClose (Input->F);
 
     /* Delete the last active file from the active file collection */
     CollDelete (&AFiles, AFileCount-1);
@@ -418,6 +407,8 @@ int NextLine (void)
 /* Get a line from the current input. Returns 0 on end of file. */
 {
     AFile*     	Input;
+    const char* Data;
+    const char* End;
 
     /* Clear the current line */
     ClearLine ();
@@ -431,11 +422,8 @@ int NextLine (void)
     /* Read characters until we have one complete line */
     while (1) {
 
-        /* Read the next character */
-        int C = fgetc (Input->F);
-
         /* Check for EOF */
-        if (C == EOF) {
+        if (Input->Pos >= Input->F->Size) {
 
             /* Accept files without a newline at the end */
             if (SB_NotEmpty (Line)) {
@@ -456,10 +444,31 @@ int NextLine (void)
             continue;
         }
 
+        /* Add the characters up to the end of the line, ignoring embedded
+         * NULs.
+         */
+        Data = Input->F->Data + Input->Pos;
+        End  = memchr (Data, '\n', Input->F->Size - Input->Pos);
+        if (End == 0) {
+            End = Input->F->Data + Input->F->Size;
+        }
+        Input->Pos += End - Data;
+        if (memchr (Data, '\0', End - Data) == 0) {
+            SB_AppendBuf (Line, Data, End - Data);
+        } else {
+            while (Data < End) {
+                if (*Data != '\0') {
+                    SB_AppendChar (Line, *Data);
+                }
+                ++Data;
+            }
+        }
+
         /* Check for end of line */
-        if (C == '\n') {
+        if (Input->Pos < Input->F->Size) {
 
-            /* We got a new line */
+            /* Skip the newline, we got a new line */
+            ++Input->Pos;
             ++Input->Line;
 
             /* If the \n is preceeded by a \r, remove the \r, so we can read
@@ -478,12 +487,6 @@ int NextLine (void)
             } else {
                 break;
             }
-
-        } else if (C != '\0') {         /* Ignore embedded NULs */
-
-            /* Just some character, add it to the line */
-            SB_AppendChar (Line, C);
-
         }
     }
 
@@ -60,7 +60,7 @@ SymEntry* NewSymEntry (const char* Name, unsigned Flags)
     SymEntry* E = xmalloc (sizeof (SymEntry) + Len);
 
     /* Initialize the entry */
-    E->NextHash	= 0;
+    InitHashNode (&E->Node, E);
     E->PrevSym	= 0;
     E->NextSym	= 0;
     E->Link	= 0;
@@ -41,6 +41,7 @@
 #include <stdio.h>
 
 /* common */
+#include "hashtab.h"
 #include "inline.h"
 
 /* cc65 */
@@ -96,7 +97,7 @@ struct Segments;
 /* Symbol table entry */
 typedef struct SymEntry SymEntry;
 struct SymEntry {
-    SymEntry*  			NextHash; /* Next entry in hash list */
+    HashNode                    Node;     /* Node for the hash table */
     SymEntry*  			PrevSym;  /* Previous symbol in dl list */
     SymEntry*  			NextSym;  /* Next symbol double linked list */
     SymEntry*  	     		Link;  	  /* General purpose single linked list */
@@ -42,6 +42,7 @@
 #include "check.h"
 #include "debugflag.h"
 #include "hashstr.h"
+#include "hashtab.h"
 #include "xmalloc.h"
 
 /* cc65 */
@@ -66,14 +67,33 @@
 
 
 
+/* Hash table functions */
+static unsigned HT_GenHash (const void* Key);
+/* Generate the hash over a key. */
+
+static const void* HT_GetKey (void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the key */
+
+static HashNode* HT_GetHashNode (void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the hash node */
+
+static int HT_Compare (const void* Key1, const void* Key2);
+/* Compare two keys. */
+
+static const HashFunctions HashFunc = {
+    HT_GenHash,
+    HT_GetKey,
+    HT_GetHashNode,
+    HT_Compare
+};
+
 /* An empty symbol table */
 SymTable	EmptySymTab = {
     0, 		/* PrevTab */
     0,		/* SymHead */
     0, 		/* SymTail */
     0,		/* SymCount */
-    1,		/* Size */
-    { 0	}	/* Tab[1] */
+    STATIC_HASHTABLE_INITIALIZER (1, &HashFunc)	/* Tab */
 };
 
 /* Symbol table sizes */
@@ -93,6 +113,47 @@ static SymTable*	LabelTab       	= 0;
 
 
 
+/*****************************************************************************/
+/*                           Hash table functions                            */
+/*****************************************************************************/
+
+
+
+static unsigned HT_GenHash (const void* Key)
+/* Generate the hash over a key. */
+{
+    return HashStr (Key);
+}
+
+
+
+static const void* HT_GetKey (void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the key */
+{
+    return ((SymEntry*) Entry)->Name;
+}
+
+
+
+static HashNode* HT_GetHashNode (void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the hash node */
+{
+    return &((SymEntry*) Entry)->Node;
+}
+
+
+
+static int HT_Compare (const void* Key1, const void* Key2)
+/* Compare two keys. The function must return a value less than zero if
+ * Key1 is smaller than Key2, zero if both are equal, and a value greater
+ * than zero if Key1 is greater then Key2.
+ */
+{
+    return strcmp (Key1, Key2);
+}
+
+
+
 /*****************************************************************************/
 /*	     			struct SymTable				     */
 /*****************************************************************************/
@@ -102,20 +163,15 @@ static SymTable*	LabelTab       	= 0;
 static SymTable* NewSymTable (unsigned Size)
 /* Create and return a symbol table for the given lexical level */
 {
-    unsigned I;
-
     /* Allocate memory for the table */
-    SymTable* S = xmalloc (sizeof (SymTable) + (Size-1) * sizeof (SymEntry*));
+    SymTable* S = xmalloc (sizeof (SymTable));
 
     /* Initialize the symbol table structure */
     S->PrevTab	= 0;
     S->SymHead	= 0;
     S->SymTail	= 0;
     S->SymCount	= 0;
-    S->Size	= Size;
-    for (I = 0; I < Size; ++I) {
-    	S->Tab[I] = 0;
-    }
+    InitHashTable (&S->Tab, Size, &HashFunc);
 
     /* Return the symbol table */
     return S;
@@ -135,6 +191,7 @@ static void FreeSymTable (SymTable* S)
     }
 
     /* Free the table itself */
+    DoneHashTable (&S->Tab);
     xfree (S);
 }
 
@@ -229,6 +286,10 @@ void LeaveGlobalLevel (void)
     /* Check the tables */
     CheckSymTable (SymTab0);
 
+    /* Tell the user how well the hash tables did */
+    HT_PrintStats (&SymTab0->Tab, "Global symbols");
+    HT_PrintStats (&TagTab0->Tab, "Global tags");
+
     /* Dump the tables if requested */
     if (Debug) {
      	PrintSymTable (SymTab0, stdout, "Global symbol table");
@@ -396,20 +457,9 @@ void LeaveStructLevel (void)
 static SymEntry* FindSymInTable (const SymTable* T, const char* Name, unsigned Hash)
 /* Search for an entry in one table */
 {
-    /* Get the start of the hash chain */
-    SymEntry* E = T->Tab [Hash % T->Size];
-    while (E) {
-	/* Compare the name */
-	if (strcmp (E->Name, Name) == 0) {
-	    /* Found */
-	    return E;
-	}
- 	/* Not found, next entry in hash chain */
-	E = E->NextHash;
-    }
-
-    /* Not found */
-    return 0;
+    /* Search the hash table, using the precalculated hash */
+    HashNode* N = HT_FindHash (&T->Tab, Name, Hash);
+    return N? HN_GetEntry (N) : 0;
 }
 
 
@@ -511,9 +561,6 @@ SymEntry* FindStructField (const Type* T, const char* Name)
 static void AddSymEntry (SymTable* T, SymEntry* S)
 /* Add a symbol to a symbol table */
 {
-    /* Get the hash value for the name */
-    unsigned Hash = HashStr (S->Name) % T->Size;
-
     /* Insert the symbol into the list of all symbols in this level */
     if (T->SymTail) {
        	T->SymTail->NextSym = S;
@@ -526,9 +573,8 @@ static void AddSymEntry (SymTable* T, SymEntry* S)
     }
     ++T->SymCount;
 
-    /* Insert the symbol into the hash chain */
-    S->NextHash  = T->Tab[Hash];
-    T->Tab[Hash] = S;
+    /* Insert the symbol into the hash table */
+    HT_Insert (&T->Tab, &S->Node);
 
     /* Tell the symbol in which table it is */
     S->Owner = T;
@@ -58,8 +58,7 @@ struct SymTable {
     SymEntry*  	       	SymHead;	/* Double linked list of symbols */
     SymEntry*  		SymTail;	/* Double linked list of symbols */
     unsigned   	     	SymCount;	/* Count of symbols in this table */
-    unsigned   	     	Size;		/* Size of table */
-    SymEntry*  	     	Tab[1];		/* Actual table, dynamically allocated */
+    HashTable           Tab;            /* Hash table for the symbols */
 };
 
 /* An empty symbol table */
@@ -42,6 +42,13 @@
 #  define NEED_SPAWN   1
 #endif
 
+/* The unix spawn module uses POSIX and XSI functions like kill() and
+ * setitimer().
+ */
+#if defined(NEED_SPAWN) && defined(SPAWN_UNIX) && !defined(_XOPEN_SOURCE)
+#  define _XOPEN_SOURCE 500
+#endif
+
 
 
 #include <stdio.h>
@@ -56,6 +63,7 @@
 /* common */
 #include "attrib.h"
 #include "cmdline.h"
+#include "coll.h"
 #include "filetype.h"
 #include "fname.h"
 #include "mmodel.h"
@@ -101,6 +109,14 @@ static CmdDesc GRC  = { 0, 0, 0, 0, 0, 0, 0 };
 static int DontLink	= 0;
 static int DontAssemble = 0;
 
+/* Pass generated assembler code through a named pipe instead of a temporary
+ * file if the system supports it.
+ */
+static int UsePipe      = 0;
+
+/* Maximum number of files translated in parallel */
+static unsigned MaxJobs = 1;
+
 /* The name of the output file, NULL if none given */
 static const char* OutputName = 0;
 
@@ -377,6 +393,39 @@ static void ExecProgram (CmdDesc* Cmd)
 
 
 
+#if defined(HAVE_SPAWNPIPE)
+
+static void ExecPipe (CmdDesc* Writer, CmdDesc* Reader, const char* Pipe)
+/* Execute two subprocesses concurrently, the first one writing to the named
+ * pipe Pipe, the second one reading from it. Exit on errors.
+ */
+{
+    int Status;
+
+    /* If in debug mode, output the command lines we will execute */
+    if (Debug) {
+	printf ("Executing: ");
+       	CmdPrint (Writer, stdout);
+	printf ("| ");
+       	CmdPrint (Reader, stdout);
+	printf ("\n");
+    }
+
+    /* Call the programs */
+    Status = spawnpipe (Pipe, Writer->Name, Writer->Args, Reader->Name, Reader->Args);
+
+    /* Check the result code */
+    if (Status != 0) {
+	/* One of the programs had an error */
+        remove (Pipe);
+	exit (Status);
+    }
+}
+
+#endif
+
+
+
 static void Link (void)
 /* Link the resulting executable */
 {
@@ -435,8 +484,11 @@ static void Link (void)
 
 
 
-static void Assemble (const char* File)
-/* Assemble the given file */
+static void AssembleFrom (const char* File, CmdDesc* Writer)
+/* Assemble the given file. If Writer is not NULL, the file is a named pipe,
+ * and Writer is the command that creates its contents. The writer and the
+ * assembler are run concurrently in this case.
+ */
 {
     /* Remember the current assembler argument count */
     unsigned ArgCount = CA65.ArgCount;
@@ -445,18 +497,11 @@ static void Assemble (const char* File)
     CmdSetTarget (&CA65, Target);
 
     /* If we won't link, this is the final step. In this case, set the
-     * output name.
+     * output name. Otherwise the object file has already been added to the
+     * linker files by AddObjFile.
      */
     if (DontLink && OutputName) {
 	CmdSetOutput (&CA65, OutputName);
-    } else {
-	/* The object file name will be the name of the source file
-	 * with .s replaced by ".o". Add this file to the list of
-	 * linker files.
-	 */
-	char* ObjName = MakeFilename (File, ".o");
-	CmdAddFile (&LD65, ObjName);
-	xfree (ObjName);
     }
 
     /* Add the file as argument for the assembler */
@@ -466,7 +511,15 @@ static void Assemble (const char* File)
     CmdAddArg (&CA65, 0);
 
     /* Run the assembler */
+#if defined(HAVE_SPAWNPIPE)
+    if (Writer) {
+        ExecPipe (Writer, &CA65, File);
+    } else {
+        ExecProgram (&CA65);
+    }
+#else
     ExecProgram (&CA65);
+#endif
 
     /* Remove the excess arguments */
     CmdDelArgs (&CA65, ArgCount);
@@ -474,6 +527,61 @@ static void Assemble (const char* File)
 
 
 
+static void Assemble (const char* File)
+/* Assemble the given file */
+{
+    AssembleFrom (File, 0);
+}
+
+
+
+static void AddObjFile (const char* File)
+/* Add the object file that is created from the given source file to the list
+ * of linker files. This is done before the file is translated, so the order
+ * of the object files doesn't depend on the order in which parallel jobs
+ * finish.
+ */
+{
+    if (!DontAssemble && !(DontLink && OutputName)) {
+	/* The object file name will be the name of the source file with the
+	 * extension replaced by ".o".
+	 */
+	char* ObjName = MakeFilename (File, ".o");
+	CmdAddFile (&LD65, ObjName);
+	xfree (ObjName);
+    }
+}
+
+
+
+static void ExecAndAssemble (CmdDesc* Cmd, const char* AsmName)
+/* Execute the given command which creates the assembler file AsmName, then
+ * assemble this file and remove it. If requested and possible, the file is
+ * created as a named pipe, and the command and the assembler run
+ * concurrently, so the assembler code never hits the disk.
+ */
+{
+#if defined(HAVE_SPAWNPIPE)
+    if (UsePipe && mkfifo (AsmName, 0600) == 0) {
+        AssembleFrom (AsmName, Cmd);
+    } else {
+        ExecProgram (Cmd);
+        Assemble (AsmName);
+    }
+#else
+    ExecProgram (Cmd);
+    Assemble (AsmName);
+#endif
+
+    /* Remove the temporary file */
+    if (remove (AsmName) < 0) {
+        Warning ("Cannot remove temporary file `%s': %s",
+                 AsmName, strerror (errno));
+    }
+}
+
+
+
 static void Compile (const char* File)
 /* Compile the given file */
 {
@@ -503,23 +611,20 @@ static void Compile (const char* File)
     /* Add a NULL pointer to terminate the argument list */
     CmdAddArg (&CC65, 0);
 
-    /* Run the compiler */
-    ExecProgram (&CC65);
+    /* Run the compiler. If this is not the final step, assemble the
+     * generated file, then remove it.
+     */
+    if (DontAssemble) {
+        ExecProgram (&CC65);
+    } else {
+        ExecAndAssemble (&CC65, AsmName);
+    }
 
     /* Remove the excess arguments */
     CmdDelArgs (&CC65, ArgCount);
 
-    /* If this is not the final step, assemble the generated file, then
-     * remove it
-     */
-    if (!DontAssemble) {
-	Assemble (AsmName);
-	if (remove (AsmName) < 0) {
-	    Warning ("Cannot remove temporary file `%s': %s",
-		     AsmName, strerror (errno));
-	}
-	xfree (AsmName);
-    }
+    /* Free the assembler file name which was allocated from the heap */
+    xfree (AsmName);
 }
 
 
@@ -592,29 +697,239 @@ static void ConvertO65 (const char* File)
     /* Add a NULL pointer to terminate the argument list */
     CmdAddArg (&CO65, 0);
 
-    /* Run the converter */
-    ExecProgram (&CO65);
+    /* Run the converter. If this is not the final step, assemble the
+     * generated file, then remove it.
+     */
+    if (DontAssemble) {
+        ExecProgram (&CO65);
+    } else {
+        ExecAndAssemble (&CO65, AsmName);
+    }
 
     /* Remove the excess arguments */
     CmdDelArgs (&CO65, ArgCount);
 
-    /* If this is not the final step, assemble the generated file, then
-     * remove it
-     */
-    if (!DontAssemble) {
-	Assemble (AsmName);
-	if (remove (AsmName) < 0) {
-	    Warning ("Cannot remove temporary file `%s': %s",
-		     AsmName, strerror (errno));
-	}
-    }
-
     /* Free the assembler file name which was allocated from the heap */
     xfree (AsmName);
 }
 
 
 
+/*****************************************************************************/
+/*                               Parallel jobs                               */
+/*****************************************************************************/
+
+
+
+#if defined(HAVE_JOBS)
+
+/* A translation running in the background */
+typedef struct Job Job;
+struct Job {
+    int         Pid;            /* Process id, zero if terminated */
+    int         Status;         /* Exit code if terminated */
+    int         Token;          /* Jobserver token, -1 if none */
+    FILE*       Out;            /* Buffered stdout of the job */
+    FILE*       Err;            /* Buffered stderr of the job */
+};
+
+/* All jobs in the order of the input files */
+static Collection Jobs          = STATIC_COLLECTION_INITIALIZER;
+static unsigned   JobsRunning   = 0;    /* Count of running jobs */
+static unsigned   JobsReported  = 0;    /* Count of jobs with output printed */
+static int        JobFailed     = 0;    /* True if any job failed */
+static int        JobStatus     = 0;    /* Exit code of first reported error */
+
+
+
+static void CopyOutput (FILE* From, FILE* To)
+/* Copy the buffered output of a job */
+{
+    char   Buf[1024];
+    size_t Count;
+
+    rewind (From);
+    while ((Count = fread (Buf, 1, sizeof (Buf), From)) > 0) {
+        fwrite (Buf, 1, Count, To);
+    }
+    fflush (To);
+}
+
+
+
+static void ReportJobs (void)
+/* Print the output of terminated jobs in the order of the input files. Stop
+ * after the first job with an error, so what is printed doesn't depend on
+ * the order in which the jobs terminate.
+ */
+{
+    while (JobStatus == 0 && JobsReported < CollCount (&Jobs)) {
+
+        Job* J = CollAt (&Jobs, JobsReported);
+        if (J->Pid != 0) {
+            /* Still running */
+            break;
+        }
+
+        CopyOutput (J->Out, stdout);
+        CopyOutput (J->Err, stderr);
+        fclose (J->Out);
+        fclose (J->Err);
+        JobStatus = J->Status;
+        ++JobsReported;
+    }
+}
+
+
+
+static void ReapJob (int Block)
+/* Wait for a job to terminate. If Block is zero, only look for jobs that
+ * have already terminated.
+ */
+{
+    unsigned I;
+    int      Status;
+    int      Pid;
+
+    /* Nothing to wait for if no jobs are running */
+    if (JobsRunning == 0) {
+        return;
+    }
+    Pid = WaitJob (Block, &Status);
+
+    /* Search for the job */
+    for (I = JobsReported; Pid > 0 && I < CollCount (&Jobs); ++I) {
+        Job* J = CollAt (&Jobs, I);
+        if (J->Pid == Pid) {
+
+            /* Mark it as terminated */
+            J->Pid    = 0;
+            J->Status = Status;
+            --JobsRunning;
+            if (Status != 0) {
+                JobFailed = 1;
+            }
+
+            /* Return the jobserver token. If the job didn't have one, it
+             * ran on the token every make child owns implicitly. In this
+             * case, pass this token on to another job, and return that
+             * job's token instead.
+             */
+            if (J->Token < 0) {
+                for (I = JobsReported; I < CollCount (&Jobs); ++I) {
+                    Job* O = CollAt (&Jobs, I);
+                    if (O->Pid != 0 && O->Token >= 0) {
+                        J->Token = O->Token;
+                        O->Token = -1;
+                        break;
+                    }
+                }
+            }
+            if (J->Token >= 0) {
+                PutJobToken (J->Token);
+                J->Token = -1;
+            }
+            break;
+        }
+    }
+
+    /* Print the output of the jobs that are complete */
+    ReportJobs ();
+}
+
+
+
+static void RunJob (void (*Func) (const char*), const char* File)
+/* Translate a file by calling Func. If parallel jobs were requested, this is
+ * done in the background, and the function returns as soon as the job is
+ * started.
+ */
+{
+    Job* J;
+
+    /* Run the function directly if we shouldn't use jobs */
+    if (MaxJobs <= 1) {
+        Func (File);
+        return;
+    }
+
+    /* Create the job */
+    J = xmalloc (sizeof (Job));
+    J->Token = -1;
+
+    /* Wait until we may start another job */
+    while (1) {
+
+        /* Look after jobs that have terminated */
+        ReapJob (0);
+
+        /* Don't start any new jobs after an error */
+        if (JobFailed) {
+            xfree (J);
+            return;
+        }
+
+        if (JobsRunning == 0) {
+            /* We can always run one job */
+            break;
+        } else if (JobsRunning < MaxJobs) {
+            /* We need a token if there's a jobserver */
+            if (JobServerRead < 0 || (J->Token = GetJobToken ()) >= 0) {
+                break;
+            }
+        } else {
+            /* Wait for a job to terminate */
+            ReapJob (1);
+        }
+    }
+
+    /* Start the job with its output going into temporary files */
+    J->Out = tmpfile ();
+    J->Err = tmpfile ();
+    if (J->Out == 0 || J->Err == 0) {
+        Error ("Cannot create temporary file: %s", strerror (errno));
+    }
+    J->Pid = StartJob (Func, File, J->Out, J->Err);
+    CollAppend (&Jobs, J);
+    ++JobsRunning;
+}
+
+
+
+static void FinishJobs (void)
+/* Wait until all jobs have terminated and print their output. Exit if one of
+ * the jobs had an error.
+ */
+{
+    while (JobsRunning > 0) {
+        ReapJob (1);
+    }
+    if (JobFailed) {
+        exit (JobStatus);
+    }
+}
+
+#else
+
+static void RunJob (void (*Func) (const char*), const char* File)
+/* Translate a file by calling Func. Without support for parallel jobs, this
+ * is always done in the foreground.
+ */
+{
+    Func (File);
+}
+
+
+
+static void FinishJobs (void)
+/* Wait until all jobs have terminated. Nothing to do without jobs. */
+{
+}
+
+#endif
+
+
+
 /*****************************************************************************/
 /*		    	       	     Code				     */
 /*****************************************************************************/
@@ -680,6 +995,7 @@ static void Usage (void)
             "  --forget-inc-paths\tForget include search paths (compiler)\n"
             "  --help\t\tHelp (this text)\n"
             "  --include-dir dir\tSet a compiler include directory path\n"
+            "  --jobs n\t\tTranslate up to n files in parallel\n"
             "  --ld-args options\tPass options to the linker\n"
             "  --lib file\t\tLink this library\n"
             "  --lib-path path\tSpecify a library search path\n"
@@ -693,6 +1009,7 @@ static void Usage (void)
             "  --o65-model model\tOverride the o65 model\n"
             "  --obj file\t\tLink this object file\n"
             "  --obj-path path\tSpecify an object file search path\n"
+            "  --pipe\t\tUse pipes instead of temporary files\n"
             "  --register-space b\tSet space available for register variables\n"
             "  --register-vars\tEnable register variables\n"
             "  --rodata-name seg\tSet the name of the RODATA segment\n"
@@ -914,6 +1231,17 @@ static void OptIncludeDir (const char* Opt attribute ((unused)), const char* Arg
 
 
 
+static void OptJobs (const char* Opt, const char* Arg)
+/* Translate up to n files in parallel */
+{
+    char C;
+    if (sscanf (Arg, "%u%c", &MaxJobs, &C) != 1 || MaxJobs == 0) {
+	Error ("Invalid argument for %s: `%s'", Opt, Arg);
+    }
+}
+
+
+
 static void OptLdArgs (const char* Opt attribute ((unused)), const char* Arg)
 /* Pass arguments to the linker */
 {
@@ -1039,6 +1367,15 @@ static void OptObjPath (const char* Opt attribute ((unused)), const char* Arg)
 
 
 
+static void OptPipe (const char* Opt attribute ((unused)),
+                     const char* Arg attribute ((unused)))
+/* Use pipes instead of temporary files */
+{
+    UsePipe = 1;
+}
+
+
+
 static void OptRegisterSpace (const char* Opt attribute ((unused)), const char* Arg)
 /* Handle the --register-space option */
 {
@@ -1178,6 +1515,7 @@ int main (int argc, char* argv [])
        	{ "--forget-inc-paths",	0,     	OptForgetIncPaths       },
 	{ "--help",	     	0,	OptHelp			},
 	{ "--include-dir",   	1,	OptIncludeDir		},
+        { "--jobs",             1,      OptJobs                 },
         { "--ld-args",          1,      OptLdArgs               },
        	{ "--lib",     	       	1,     	OptLib                  },
        	{ "--lib-path",	       	1,     	OptLibPath              },
@@ -1191,6 +1529,7 @@ int main (int argc, char* argv [])
         { "--o65-model",        1,      OptO65Model             },
        	{ "--obj",              1,     	OptObj                  },
        	{ "--obj-path",	       	1,     	OptObjPath              },
+        { "--pipe",             0,      OptPipe                 },
         { "--register-space",   1,      OptRegisterSpace        },
         { "--register-vars",    0,      OptRegisterVars         },
 	{ "--rodata-name",    	1, 	OptRodataName		},
@@ -1220,6 +1559,11 @@ int main (int argc, char* argv [])
     /* Our default target is the C64 instead of "none" */
     Target = TGT_C64;
 
+#if defined(HAVE_JOBS)
+    /* Take job tokens from make if it passed a jobserver to us */
+    InitJobServer ();
+#endif
+
     /* Check the parameters */
     I = 1;
     while (I < ArgCount) {
@@ -1390,13 +1734,15 @@ int main (int argc, char* argv [])
 
 	     	case FILETYPE_C:
 	     	    /* Compile the file */
-	     	    Compile (Arg);
+                    AddObjFile (Arg);
+	     	    RunJob (Compile, Arg);
 	     	    break;
 
 	     	case FILETYPE_ASM:
 	     	    /* Assemble the file */
 	     	    if (!DontAssemble) {
-	     		Assemble (Arg);
+                        AddObjFile (Arg);
+	     		RunJob (Assemble, Arg);
 	     	    }
 	     	    break;
 
@@ -1408,12 +1754,14 @@ int main (int argc, char* argv [])
 
 		case FILETYPE_GR:
 		    /* Add to the resource compiler files */
-		    CompileRes (Arg);
+                    AddObjFile (Arg);
+		    RunJob (CompileRes, Arg);
 		    break;
 
                 case FILETYPE_O65:
                     /* Add the the object file converter files */
-                    ConvertO65 (Arg);
+                    AddObjFile (Arg);
+                    RunJob (ConvertO65, Arg);
                     break;
 
 	     	default:
@@ -1427,6 +1775,9 @@ int main (int argc, char* argv [])
 	++I;
     }
 
+    /* Wait until all files are translated */
+    FinishJobs ();
+
     /* Check if we had any input files */
     if (FirstInput == 0) {
 	Warning ("No input files");
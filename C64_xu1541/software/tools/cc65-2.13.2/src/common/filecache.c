@@ -0,0 +1,319 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                filecache.c                                */
+/*                                                                           */
+/*                     Input files read into memory once                     */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* common */
+#include "filecache.h"
+#include "filemap.h"
+#include "hashstr.h"
+#include "hashtab.h"
+#include "xmalloc.h"
+
+
+
+/*****************************************************************************/
+/*                                 Forwards                                  */
+/*****************************************************************************/
+
+
+
+static unsigned HT_GenHash (const void* Key);
+/* Generate the hash over a key. */
+
+static const void* HT_GetKey (void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the key. */
+
+static HashNode* HT_GetHashNode (void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the hash node */
+
+static int HT_Compare (const void* Key1, const void* Key2);
+/* Compare two keys. The function must return a value less than zero if
+ * Key1 is smaller than Key2, zero if both are equal, and a value greater
+ * than zero if Key1 is greater then Key2.
+ */
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+#if !defined(S_ISREG)
+#  define S_ISREG(M)    (((M) & S_IFMT) == S_IFREG)
+#endif
+
+/* Size of the chunks used when reading files that are not cached */
+#define READ_CHUNK      0x4000
+
+/* An entry in the cache */
+typedef struct FCacheEntry FCacheEntry;
+struct FCacheEntry {
+    CachedFile          File;           /* Contents, must be first */
+    HashNode            Node;           /* Node in the hash table */
+    FileMap*            Map;            /* Mapping of a regular file */
+    char*               Buf;            /* Contents of other files */
+    unsigned            Usage;          /* Number of users */
+    int                 Cached;         /* True if entry is in the cache */
+    char                Name[1];        /* Name of the file, dynamic */
+};
+
+/* Hash table functions */
+static const HashFunctions HashFunc = {
+    HT_GenHash,
+    HT_GetKey,
+    HT_GetHashNode,
+    HT_Compare
+};
+
+/* Cached files, hashed by name */
+static HashTable Cache = STATIC_HASHTABLE_INITIALIZER (31, &HashFunc);
+
+/* Contents of empty files */
+static const char EmptyData[] = "";
+
+
+
+/*****************************************************************************/
+/*                           Hash table functions                            */
+/*****************************************************************************/
+
+
+
+static unsigned HT_GenHash (const void* Key)
+/* Generate the hash over a key. */
+{
+    return HashStr (Key);
+}
+
+
+
+static const void* HT_GetKey (void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the key */
+{
+    return ((FCacheEntry*) Entry)->Name;
+}
+
+
+
+static HashNode* HT_GetHashNode (void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the hash node */
+{
+    return &((FCacheEntry*) Entry)->Node;
+}
+
+
+
+static int HT_Compare (const void* Key1, const void* Key2)
+/* Compare two keys. The function must return a value less than zero if
+ * Key1 is smaller than Key2, zero if both are equal, and a value greater
+ * than zero if Key1 is greater then Key2.
+ */
+{
+    return strcmp (Key1, Key2);
+}
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+static FCacheEntry* NewFCacheEntry (const char* Name, unsigned long MTime)
+/* Create a new cache entry without contents and return it */
+{
+    /* Get the length of the name */
+    unsigned Len = strlen (Name);
+
+    /* Allocate memory */
+    FCacheEntry* E = xmalloc (sizeof (FCacheEntry) + Len);
+
+    /* Initialize the fields */
+    E->File.Data  = EmptyData;
+    E->File.Size  = 0;
+    E->File.MTime = MTime;
+    InitHashNode (&E->Node, E);
+    E->Map        = 0;
+    E->Buf        = 0;
+    E->Usage      = 0;
+    E->Cached     = 0;
+    memcpy (E->Name, Name, Len + 1);
+
+    /* Return the new entry */
+    return E;
+}
+
+
+
+static void FreeFCacheEntry (FCacheEntry* E)
+/* Free a cache entry together with its contents */
+{
+    if (E->Map) {
+        FMapClose (E->Map);
+    }
+    xfree (E->Buf);
+    xfree (E);
+}
+
+
+
+static void Uncache (FCacheEntry* E)
+/* Remove an entry from the cache. It is freed when it's no longer used. */
+{
+    HT_RemoveEntry (&Cache, E);
+    E->Cached = 0;
+    if (E->Usage == 0) {
+        FreeFCacheEntry (E);
+    }
+}
+
+
+
+static int ReadStream (FCacheEntry* E)
+/* Read a file that cannot be mapped, like a pipe, up to the end of file.
+ * Return zero on success, -1 on errors.
+ */
+{
+    unsigned long Size = 0;
+    unsigned long Max  = 0;
+    size_t        Count;
+    int           Err;
+
+    FILE* F = fopen (E->Name, "rb");
+    if (F == 0) {
+        return -1;
+    }
+    do {
+        if (Size == Max) {
+            Max += READ_CHUNK;
+            E->Buf = xrealloc (E->Buf, Max);
+        }
+        Count = fread (E->Buf + Size, 1, Max - Size, F);
+        Size += Count;
+    } while (Count > 0);
+    if (ferror (F)) {
+        Err = errno;
+        fclose (F);
+        errno = Err;
+        return -1;
+    }
+    fclose (F);
+
+    E->File.Data = E->Buf;
+    E->File.Size = Size;
+    return 0;
+}
+
+
+
+const CachedFile* FCacheOpen (const char* Name)
+/* Return the contents of the file with the given name. Regular files are
+ * read only once: If the file was read before, and neither its size nor its
+ * modification time have changed since then, the contents are taken from
+ * the cache. Other files like pipes are read up to the end of file and are
+ * not cached. On errors, the function returns NULL and errno contains the
+ * reason.
+ */
+{
+    struct stat  S;
+    FCacheEntry* E;
+
+    if (stat (Name, &S) != 0) {
+        return 0;
+    }
+
+    /* Look into the cache. Drop the contents if the file has changed. */
+    E = HT_FindEntry (&Cache, Name);
+    if (E) {
+        if (E->File.Size  == (unsigned long) S.st_size &&
+            E->File.MTime == (unsigned long) S.st_mtime) {
+            ++E->Usage;
+            return &E->File;
+        }
+        Uncache (E);
+    }
+
+    E = NewFCacheEntry (Name, (unsigned long) S.st_mtime);
+    if (S_ISREG (S.st_mode)) {
+
+        /* Map the file and add it to the cache */
+        if ((E->Map = FMapOpen (Name)) == 0) {
+            int Err = errno;
+            FreeFCacheEntry (E);
+            errno = Err;
+            return 0;
+        }
+        if (E->Map->Size > 0) {
+            E->File.Data = (const char*) E->Map->Data;
+            E->File.Size = E->Map->Size;
+        }
+        HT_InsertEntry (&Cache, E);
+        E->Cached = 1;
+
+    } else if (ReadStream (E) != 0) {
+        int Err = errno;
+        FreeFCacheEntry (E);
+        errno = Err;
+        return 0;
+    }
+
+    /* Return the new entry */
+    E->Usage = 1;
+    return &E->File;
+}
+
+
+
+void FCacheClose (const CachedFile* F)
+/* Tell the cache that the contents of F are no longer used. Contents of
+ * regular files stay in the cache, all others are freed.
+ */
+{
+    /* The CachedFile is the first member of the entry */
+    FCacheEntry* E = (FCacheEntry*) F;
+
+    if (--E->Usage == 0 && !E->Cached) {
+        FreeFCacheEntry (E);
+    }
+}
+
+
+
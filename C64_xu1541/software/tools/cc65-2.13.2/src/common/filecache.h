@@ -0,0 +1,81 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                filecache.h                                */
+/*                                                                           */
+/*                     Input files read into memory once                     */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef FILECACHE_H
+#define FILECACHE_H
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* The contents of an input file. The data is not terminated by a NUL. */
+typedef struct CachedFile CachedFile;
+struct CachedFile {
+    const char*             Data;       /* Contents of the file */
+    unsigned long           Size;       /* Size of the contents */
+    unsigned long           MTime;      /* Time of last modification */
+};
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+const CachedFile* FCacheOpen (const char* Name);
+/* Return the contents of the file with the given name. Regular files are
+ * read only once: If the file was read before, and neither its size nor its
+ * modification time have changed since then, the contents are taken from
+ * the cache. Other files like pipes are read up to the end of file and are
+ * not cached. On errors, the function returns NULL and errno contains the
+ * reason.
+ */
+
+void FCacheClose (const CachedFile* F);
+/* Tell the cache that the contents of F are no longer used. Contents of
+ * regular files stay in the cache, all others are freed.
+ */
+
+
+
+/* End of filecache.h */
+#endif
+
+
+
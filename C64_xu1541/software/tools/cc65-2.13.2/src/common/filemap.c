@@ -0,0 +1,184 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 filemap.c                                 */
+/*                                                                           */
+/*               Read only access to a file mapped into memory               */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <errno.h>
+#include <stdio.h>
+#if defined(__WATCOMC__) || defined(_MSC_VER) || defined(__MINGW32__) || defined(__DJGPP__)
+/* No mmap available, read the file into memory */
+#else
+#  define HAVE_MMAP
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+/* common */
+#include "filemap.h"
+#include "xmalloc.h"
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+#if defined(HAVE_MMAP)
+
+static int MapFile (FileMap* M, const char* Name)
+/* Map the file into memory. Return zero on success, -1 on errors. */
+{
+    struct stat S;
+    void*       Data;
+    int         Err;
+
+    int FD = open (Name, O_RDONLY);
+    if (FD < 0) {
+        return -1;
+    }
+    if (fstat (FD, &S) != 0) {
+        Err = errno;
+        close (FD);
+        errno = Err;
+        return -1;
+    }
+    M->Size = (unsigned long) S.st_size;
+
+    /* Empty files cannot be mapped, but there's nothing to read anyway */
+    if (M->Size > 0) {
+        Data = mmap (0, M->Size, PROT_READ, MAP_PRIVATE, FD, 0);
+        if (Data == MAP_FAILED) {
+            Err = errno;
+            close (FD);
+            errno = Err;
+            return -1;
+        }
+        M->Data   = Data;
+        M->Mapped = 1;
+    }
+
+    /* The mapping stays valid without the descriptor */
+    close (FD);
+    return 0;
+}
+
+#else
+
+static int MapFile (FileMap* M, const char* Name)
+/* Read the file into memory. Return zero on success, -1 on errors. */
+{
+    unsigned char*  Data;
+    long            Size;
+    int             Err;
+
+    FILE* F = fopen (Name, "rb");
+    if (F == 0) {
+        return -1;
+    }
+    if (fseek (F, 0, SEEK_END) != 0 || (Size = ftell (F)) < 0 ||
+        fseek (F, 0, SEEK_SET) != 0) {
+        Err = errno;
+        fclose (F);
+        errno = Err;
+        return -1;
+    }
+    M->Size = (unsigned long) Size;
+
+    if (M->Size > 0) {
+        Data = xmalloc (M->Size);
+        if (fread (Data, 1, M->Size, F) != M->Size) {
+            Err = ferror (F)? errno : EIO;
+            xfree (Data);
+            fclose (F);
+            errno = Err;
+            return -1;
+        }
+        M->Data = Data;
+    }
+
+    fclose (F);
+    return 0;
+}
+
+#endif
+
+
+
+FileMap* FMapOpen (const char* Name)
+/* Map the file with the given name into memory. On errors, the function
+ * returns NULL and errno contains the reason.
+ */
+{
+    /* Allocate memory */
+    FileMap* M = xmalloc (sizeof (FileMap));
+
+    /* Initialize the fields */
+    M->Data     = 0;
+    M->Size     = 0;
+    M->Pos      = 0;
+    M->Mapped   = 0;
+
+    /* Map the file */
+    if (MapFile (M, Name) != 0) {
+        int Err = errno;
+        xfree (M);
+        errno = Err;
+        return 0;
+    }
+
+    /* Return the new struct */
+    return M;
+}
+
+
+
+void FMapClose (FileMap* M)
+/* Unmap the file and free the FileMap structure. Pointers into the file
+ * contents are invalid afterwards.
+ */
+{
+#if defined(HAVE_MMAP)
+    if (M->Mapped) {
+        munmap ((void*) M->Data, M->Size);
+    }
+#endif
+    if (!M->Mapped) {
+        xfree ((void*) M->Data);
+    }
+    xfree (M);
+}
+
+
+
@@ -0,0 +1,81 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 filemap.h                                 */
+/*                                                                           */
+/*               Read only access to a file mapped into memory               */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef FILEMAP_H
+#define FILEMAP_H
+
+
+
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* A file mapped into memory for reading. If the system has no mmap, the
+ * file is read into memory as a whole, so the contents always stay at the
+ * same address until the file is closed.
+ */
+typedef struct FileMap FileMap;
+struct FileMap {
+    const unsigned char*    Data;       /* Contents of the file */
+    unsigned long           Size;       /* Size of the file */
+    unsigned long           Pos;        /* Current read position */
+    int                     Mapped;     /* True if Data is a memory mapping */
+};
+
+
+
+/*****************************************************************************/
+/*                                   Code                                    */
+/*****************************************************************************/
+
+
+
+FileMap* FMapOpen (const char* Name);
+/* Map the file with the given name into memory. On errors, the function
+ * returns NULL and errno contains the reason.
+ */
+
+void FMapClose (FileMap* M);
+/* Unmap the file and free the FileMap structure. Pointers into the file
+ * contents are invalid afterwards.
+ */
+
+
+
+/* End of filemap.h */
+#endif
+
+
+
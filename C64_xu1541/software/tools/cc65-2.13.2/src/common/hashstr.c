@@ -38,6 +38,18 @@
 
 
 
+/*****************************************************************************/
+/*                                   Data                                    */
+/*****************************************************************************/
+
+
+
+/* Parameters for the 32 bit FNV-1a hash */
+#define FNV_OFFSET      2166136261U
+#define FNV_PRIME       16777619U
+
+
+
 /*****************************************************************************/
 /*     	       	       	       	     Code				     */
 /*****************************************************************************/
@@ -47,12 +59,12 @@
 unsigned HashStr (const char* S)
 /* Return a hash value for the given string */
 {
-    unsigned L, H;
-
-    /* Do the hash */
-    H = L = 0;
+    /* FNV-1a: Mixes every character into all bits of the hash, so the
+     * reduced hash spreads similar names (like generated labels) well.
+     */
+    unsigned H = FNV_OFFSET;
     while (*S) {
-    	H = ((H << 3) ^ ((unsigned char) *S++)) + L++;
+        H = (H ^ (unsigned char) *S++) * FNV_PRIME;
     }
     return H;
 }
@@ -62,12 +74,12 @@ unsigned HashStr (const char* S)
 unsigned HashBuf (const StrBuf* S)
 /* Return a hash value for the given string buffer */
 {
-    unsigned I, L, H;
+    unsigned I;
 
     /* Do the hash */
-    H = L = 0;
+    unsigned H = FNV_OFFSET;
     for (I = 0; I < SB_GetLen (S); ++I) {
-    	H = ((H << 3) ^ ((unsigned char) SB_AtUnchecked (S, I))) + L++;
+        H = (H ^ (unsigned char) SB_AtUnchecked (S, I)) * FNV_PRIME;
     }
     return H;
 }
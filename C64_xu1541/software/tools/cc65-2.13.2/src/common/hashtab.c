@@ -34,7 +34,9 @@
 
 
 /* common */
+#include "check.h"
 #include "hashtab.h"
+#include "print.h"
 #include "xmalloc.h"
 
 
@@ -74,6 +76,40 @@ static void HT_Alloc (HashTable* T)
 
 
 
+static void HT_Grow (HashTable* T)
+/* Grow the table and redistribute the nodes over the new slots. The full
+ * hash is stored in each node, so there's no need to recalculate it.
+ */
+{
+    unsigned    I;
+    unsigned    OldSlots = T->Slots;
+    HashNode**  OldTable = T->Table;
+
+    /* Allocate the new table. Keep the number of slots odd, so the reduced
+     * hash still depends on all bits of the full hash.
+     */
+    T->Slots = OldSlots * 2 + 1;
+    HT_Alloc (T);
+
+    /* Move all nodes into the new table */
+    for (I = 0; I < OldSlots; ++I) {
+        HashNode* N = OldTable[I];
+        while (N) {
+            HashNode* Next = N->Next;
+            unsigned RHash = N->Hash % T->Slots;
+            N->Next = T->Table[RHash];
+            T->Table[RHash] = N;
+            N = Next;
+        }
+    }
+
+    /* Free the old table and remember the resize */
+    xfree (OldTable);
+    ++T->Resizes;
+}
+
+
+
 HashNode* HT_Find (const HashTable* T, const void* Key)
 /* Find the node with the given index */
 {
@@ -160,6 +196,11 @@ void HT_Insert (HashTable* T, HashNode* N)
 
     /* One more entry */
     ++T->Count;
+
+    /* Grow the table if the chains get too long */
+    if (T->Count > T->Slots) {
+        HT_Grow (T);
+    }
 }
 
 
@@ -172,6 +213,36 @@ void HT_InsertEntry (HashTable* T, void* Entry)
 
 
 
+void HT_Remove (HashTable* T, HashNode* N)
+/* Remove a node from the given hash table */
+{
+    /* Search for the node in its chain */
+    HashNode** Q = &T->Table[N->Hash % T->Slots];
+    while (*Q != N) {
+        /* The node must be in the table */
+        PRECONDITION (*Q != 0);
+        Q = &(*Q)->Next;
+    }
+
+    /* Unlink it */
+    *Q = N->Next;
+    N->Next  = 0;
+    N->Owner = 0;
+
+    /* One entry less */
+    --T->Count;
+}
+
+
+
+void HT_RemoveEntry (HashTable* T, void* Entry)
+/* Remove an entry from the given hash table */
+{
+    HT_Remove (T, T->Func->GetHashNode (Entry));
+}
+
+
+
 void HT_Walk (HashTable* T, void (*F) (void* Entry, void* Data), void* Data)
 /* Walk over all nodes of a hash table. For each node, the user supplied
  * function F is called, passing a pointer to the entry, and the data pointer
@@ -204,3 +275,53 @@ void HT_Walk (HashTable* T, void (*F) (void* Entry, void* Data), void* Data)
 
 
 
+void HT_GetStats (const HashTable* T, HashStats* S)
+/* Return statistics about the given hash table */
+{
+    unsigned I;
+    unsigned long Probes = 0;
+
+    S->Slots    = T->Slots;
+    S->Count    = T->Count;
+    S->Used     = 0;
+    S->MaxChain = 0;
+    S->Resizes  = T->Resizes;
+    S->Load     = (double) T->Count / T->Slots;
+
+    /* Walk over the chains. Finding the Nth entry of a chain needs N
+     * compares, so a chain of length L needs L*(L+1)/2 compares to find
+     * all of its entries once.
+     */
+    if (T->Table) {
+        for (I = 0; I < T->Slots; ++I) {
+            unsigned Len = 0;
+            const HashNode* N = T->Table[I];
+            while (N) {
+                ++Len;
+                N = N->Next;
+            }
+            if (Len > 0) {
+                ++S->Used;
+                Probes += (unsigned long) Len * (Len + 1) / 2;
+                if (Len > S->MaxChain) {
+                    S->MaxChain = Len;
+                }
+            }
+        }
+    }
+    S->Probes = T->Count? (double) Probes / T->Count : 0.0;
+}
+
+
+
+void HT_PrintStats (const HashTable* T, const char* Name)
+/* Print statistics about the given hash table in verbose mode */
+{
+    HashStats S;
+    HT_GetStats (T, &S);
+    Print (stdout, 1,
+           "%s: %u entries, %u slots (%u used, %u resizes), "
+           "load %.2f, %.2f probes/hit, longest chain %u\n",
+           Name, S.Count, S.Slots, S.Used, S.Resizes,
+           S.Load, S.Probes, S.MaxChain);
+}
@@ -81,16 +81,31 @@ struct HashFunctions {
      */
 };
 
-/* Hash table */
+/* Hash table. The table grows automatically if the number of entries
+ * exceeds the number of slots, so Slots is just the initial size.
+ */
 typedef struct HashTable HashTable;
 struct HashTable {
     unsigned                    Slots;  /* Number of table slots */
     unsigned                    Count;  /* Number of table entries */
     HashNode**                  Table;  /* Table, dynamically allocated */
     const HashFunctions*        Func;   /* Table functions */
+    unsigned                    Resizes;/* Number of times the table grew */
 };
 
-#define STATIC_HASHTABLE_INITIALIZER(Slots, Func)   { Slots, 0, 0, Func }
+#define STATIC_HASHTABLE_INITIALIZER(Slots, Func)   { Slots, 0, 0, Func, 0 }
+
+/* Hash table statistics as returned by HT_GetStats */
+typedef struct HashStats HashStats;
+struct HashStats {
+    unsigned    Slots;                  /* Number of table slots */
+    unsigned    Count;                  /* Number of table entries */
+    unsigned    Used;                   /* Number of non empty slots */
+    unsigned    MaxChain;               /* Length of the longest chain */
+    unsigned    Resizes;                /* Number of times the table grew */
+    double      Load;                   /* Entries per slot */
+    double      Probes;                 /* Average compares for a hit */
+};
 
 
 
@@ -142,6 +157,7 @@ INLINE HashTable* InitHashTable (HashTable* T, unsigned Slots, const HashFunctio
     T->Count    = 0;
     T->Table    = 0;
     T->Func     = Func;
+    T->Resizes  = 0;
 
     /* Return the initialized table */
     return T;
@@ -152,6 +168,7 @@ INLINE HashTable* InitHashTable (HashTable* T, unsigned Slots, const HashFunctio
     (T)->Count  = 0,                    \
     (T)->Table  = 0,                    \
     (T)->Func   = (Func),               \
+    (T)->Resizes = 0,                   \
     (T)
 #endif
 
@@ -199,12 +216,24 @@ void HT_Insert (HashTable* T, HashNode* N);
 void HT_InsertEntry (HashTable* T, void* Entry);
 /* Insert an entry into the given hash table */
 
+void HT_Remove (HashTable* T, HashNode* N);
+/* Remove a node from the given hash table */
+
+void HT_RemoveEntry (HashTable* T, void* Entry);
+/* Remove an entry from the given hash table */
+
 void HT_Walk (HashTable* T, void (*F) (void* Entry, void* Data), void* Data);
 /* Walk over all nodes of a hash table. For each node, the user supplied
  * function F is called, passing a pointer to the entry, and the data pointer
  * passed to HT_Walk by the caller.
  */
 
+void HT_GetStats (const HashTable* T, HashStats* S);
+/* Return statistics about the given hash table */
+
+void HT_PrintStats (const HashTable* T, const char* Name);
+/* Print statistics about the given hash table in verbose mode */
+
 
 
 /* End of hashtab.h */
@@ -19,6 +19,8 @@ OBJS =	abend.o		\
 	cpu.o           \
 	debugflag.o     \
 	exprdefs.o	\
+	filecache.o     \
+	filemap.o       \
 	filepos.o	\
 	filetype.o      \
 	fname.o		\
@@ -65,6 +65,8 @@ OBJS =	abend.obj	\
         cpu.obj         \
         debugflag.obj   \
 	exprdefs.obj	\
+        filecache.obj   \
+        filemap.obj     \
 	filepos.obj	\
         filetype.obj    \
 	fname.obj	\
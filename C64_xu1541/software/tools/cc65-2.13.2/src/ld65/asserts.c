@@ -65,7 +65,7 @@ static Collection Assertions = STATIC_COLLECTION_INITIALIZER;
 
 
 
-Assertion* ReadAssertion (FILE* F, struct ObjData* O)
+Assertion* ReadAssertion (FileMap* F, struct ObjData* O)
 /* Read an assertion from the given file */
 {
     /* Allocate memory */
@@ -41,6 +41,7 @@
 #include <stdio.h>
 
 /* common */
+#include "filemap.h"
 #include "filepos.h"
 
 
@@ -69,7 +70,7 @@ struct Assertion {
 
 
 
-Assertion* ReadAssertion (FILE* F, struct ObjData* O);
+Assertion* ReadAssertion (FileMap* F, struct ObjData* O);
 /* Read an assertion from the given file */
 
 void CheckAssertions (void);
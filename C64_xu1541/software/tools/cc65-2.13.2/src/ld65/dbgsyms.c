@@ -138,7 +138,7 @@ static void InsertDbgSym (DbgSym* D, long Val)
 
 
 
-DbgSym* ReadDbgSym (FILE* F, ObjData* O)
+DbgSym* ReadDbgSym (FileMap* F, ObjData* O)
 /* Read a debug symbol from a file, insert and return it */
 {
     /* Read the type and address size */
@@ -42,6 +42,7 @@
 
 /* common */
 #include "exprdefs.h"
+#include "filemap.h"
 #include "filepos.h"
 
 /* ld65 */
@@ -76,7 +77,7 @@ struct DbgSym {
 
 
 
-DbgSym* ReadDbgSym (FILE* F, ObjData* Obj);
+DbgSym* ReadDbgSym (FileMap* F, ObjData* Obj);
 /* Read a debug symbol from a file, insert and return it */
 
 long GetDbgSymVal (DbgSym* D);
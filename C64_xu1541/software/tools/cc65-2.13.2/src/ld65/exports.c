@@ -41,7 +41,7 @@
 #include "addrsize.h"
 #include "check.h"
 #include "coll.h"
-#include "hashstr.h"
+#include "hashtab.h"
 #include "symdefs.h"
 #include "xmalloc.h"
 
@@ -63,10 +63,31 @@
 
 
 
-/* Hash table */
-#define HASHTAB_MASK    0x0FFFU
-#define HASHTAB_SIZE   	(HASHTAB_MASK + 1)
-static Export* 	       	HashTab[HASHTAB_SIZE];
+/* Hash table functions */
+static unsigned HT_GenHash (const void* Key);
+/* Generate the hash over a key. */
+
+static const void* HT_GetKey (void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the key */
+
+static HashNode* HT_GetHashNode (void* Entry);
+/* Given a pointer to the user entry data, return a pointer to the hash node */
+
+static int HT_Compare (const void* Key1, const void* Key2);
+/* Compare two keys. */
+
+static const HashFunctions HashFunc = {
+    HT_GenHash,
+    HT_GetKey,
+    HT_GetHashNode,
+    HT_Compare
+};
+
+/* Hash table with all exports, keyed by the name id. The table grows as
+ * needed, so this is just the initial size.
+ */
+#define HASHTAB_SIZE    1023U
+static HashTable        ExpTab = STATIC_HASHTABLE_INITIALIZER (HASHTAB_SIZE, &HashFunc);
 
 /* Import management variables */
 static unsigned	       	ImpCount = 0;	   	/* Import count */
@@ -85,6 +106,50 @@ static Export**	       	ExpPool  = 0;	  	/* Exports array */
 
 
 
+/*****************************************************************************/
+/*                           Hash table functions                            */
+/*****************************************************************************/
+
+
+
+static unsigned HT_GenHash (const void* Key)
+/* Generate the hash over a key. */
+{
+    /* Name ids are handed out sequentially by the string pool, so they are
+     * already evenly distributed over the slots.
+     */
+    return *(const unsigned*) Key;
+}
+
+
+
+static const void* HT_GetKey (void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the index */
+{
+    return &((Export*) Entry)->Name;
+}
+
+
+
+static HashNode* HT_GetHashNode (void* Entry)
+/* Given a pointer to the user entry data, return a pointer to the hash node */
+{
+    return &((Export*) Entry)->Node;
+}
+
+
+
+static int HT_Compare (const void* Key1, const void* Key2)
+/* Compare two keys. The function must return a value less than zero if
+ * Key1 is smaller than Key2, zero if both are equal, and a value greater
+ * than zero if Key1 is greater then Key2.
+ */
+{
+    return (int)*(const unsigned*)Key1 - (int)*(const unsigned*)Key2;
+}
+
+
+
 /*****************************************************************************/
 /*	       			Import handling				     */
 /*****************************************************************************/
@@ -133,7 +198,7 @@ void FreeImport (Import* I)
 
 
 
-Import* ReadImport (FILE* F, ObjData* Obj)
+Import* ReadImport (FileMap* F, ObjData* Obj)
 /* Read an import from a file and return it */
 {
     Import* I;
@@ -219,31 +284,13 @@ void InsertImport (Import* I)
     /* As long as the import is not inserted, V.Name is valid */
     unsigned Name = I->Name;
 
-    /* Create a hash value for the given name */
-    unsigned Hash = (Name & HASHTAB_MASK);
-
-    /* Search through the list in that slot and print matching duplicates */
-    if (HashTab[Hash] == 0) {
-    	/* The slot is empty, we need to insert a dummy export */
-       	E = HashTab[Hash] = NewExport (0, ADDR_SIZE_DEFAULT, Name, 0);
-	++ExpCount;
-    } else {
-    	E = HashTab [Hash];
-    	while (1) {
-    	    if (E->Name == Name) {
-    	  	/* We have an entry, L points to it */
-       	       	break;
-    	    }
-    	    if (E->Next == 0) {
-    	  	/* End of list an entry not found, insert a dummy */
-    	  	E->Next = NewExport (0, ADDR_SIZE_DEFAULT, Name, 0);
-    	  	E = E->Next;   		/* Point to dummy */
-		++ExpCount;    		/* One export more */
-       	  	break;
-    	    } else {
-    	  	E = E->Next;
-    	    }
-    	}
+    /* Search for an export with this name */
+    E = HT_FindEntry (&ExpTab, &Name);
+    if (E == 0) {
+    	/* Not found, we need to insert a dummy export */
+       	E = NewExport (0, ADDR_SIZE_DEFAULT, Name, 0);
+        HT_InsertEntry (&ExpTab, E);
+	++ExpCount;    		/* One export more */
     }
 
     /* Ok, E now points to a valid exports entry for the given import. Insert
@@ -280,7 +327,7 @@ static Export* NewExport (unsigned char Type, unsigned char AddrSize,
 
     /* Initialize the fields */
     E->Name     = Name;
-    E->Next     = 0;
+    InitHashNode (&E->Node, E);
     E->Flags   	= 0;
     E->Obj      = Obj;
     E->ImpCount = 0;
@@ -318,9 +365,7 @@ void InsertExport (Export* E)
 /* Insert an exported identifier and check if it's already in the list */
 {
     Export* L;
-    Export* Last;
     Import* Imp;
-    unsigned Hash;
 
     /* Mark the export as inserted */
     E->Flags |= EXP_INLIST;
@@ -330,65 +375,41 @@ void InsertExport (Export* E)
        	ConDesAddExport (E);
     }
 
-    /* Create a hash value for the given name */
-    Hash = (E->Name & HASHTAB_MASK);
-
-    /* Search through the list in that slot */
-    if (HashTab[Hash] == 0) {
-      	/* The slot is empty */
-      	HashTab[Hash] = E;
+    /* Search for an export with this name */
+    L = HT_FindEntry (&ExpTab, &E->Name);
+    if (L == 0) {
+      	/* Not found */
+        HT_InsertEntry (&ExpTab, E);
 	++ExpCount;
-    } else {
+    } else if (L->Expr == 0) {
 
-      	Last = 0;
-      	L = HashTab[Hash];
-      	do {
-       	    if (L->Name == E->Name) {
-      	       	/* This may be an unresolved external */
-      	       	if (L->Expr == 0) {
-
-      	       	    /* This *is* an unresolved external. Use the actual export
-                     * in E instead of the dummy one in L.
-                     */
-      	       	    E->Next     = L->Next;
-      	       	    E->ImpCount = L->ImpCount;
-      	       	    E->ImpList  = L->ImpList;
-      	      	    if (Last) {
-      	      	       	Last->Next = E;
-      	      	    } else {
-      	      	       	HashTab[Hash] = E;
-      	      	    }
-       	       	    ImpOpen -= E->ImpCount;	/* Decrease open imports now */
-      	      	    xfree (L);
-      	      	    /* We must run through the import list and change the
-      	       	     * export pointer now.
-      	      	     */
-      	      	    Imp = E->ImpList;
-      	      	    while (Imp) {
-      	      	   	Imp->Exp = E;
-      	      	   	Imp = Imp->Next;
-      	      	    }
-      	      	} else {
-      	      	    /* Duplicate entry, ignore it */
-       	      	    Warning ("Duplicate external identifier: `%s'",
-                             GetString (L->Name));
-      	      	}
-      	      	return;
-      	    }
-      	    Last = L;
-      	    L = L->Next;
-
-      	} while (L);
-
-	/* Insert export at end of queue */
-      	Last->Next = E;
-	++ExpCount;
+        /* This is an unresolved external. Use the actual export in E instead
+         * of the dummy one in L.
+         */
+        HT_RemoveEntry (&ExpTab, L);
+        HT_InsertEntry (&ExpTab, E);
+        E->ImpCount = L->ImpCount;
+        E->ImpList  = L->ImpList;
+        ImpOpen -= E->ImpCount;	/* Decrease open imports now */
+        xfree (L);
+        /* We must run through the import list and change the
+         * export pointer now.
+         */
+        Imp = E->ImpList;
+        while (Imp) {
+            Imp->Exp = E;
+            Imp = Imp->Next;
+        }
+
+    } else {
+        /* Duplicate entry, ignore it */
+        Warning ("Duplicate external identifier: `%s'", GetString (L->Name));
     }
 }
 
 
 
-Export* ReadExport (FILE* F, ObjData* O)
+Export* ReadExport (FileMap* F, ObjData* O)
 /* Read an export from a file */
 {
     unsigned      ConDesCount;
@@ -522,19 +543,7 @@ Export* FindExport (unsigned Name)
  * return a pointer to the export.
  */
 {
-    /* Get a pointer to the list with the symbols hash value */
-    Export* L = HashTab[Name & HASHTAB_MASK];
-    while (L) {
-        /* Search through the list in that slot */
-       	if (L->Name == Name) {
-	    /* Entry found */
-	    return L;
-	}
-	L = L->Next;
-    }
-
-    /* Not found */
-    return 0;
+    return HT_FindEntry (&ExpTab, &Name);
 }
 
 
@@ -678,10 +687,20 @@ static int CmpExpName (const void* K1, const void* K2)
 
 
 
+static void AddToExportPool (void* Entry, void* Data)
+/* Add one export to the export pool, Data points to the pool index */
+{
+    unsigned* J = Data;
+    CHECK (*J < ExpCount);
+    ExpPool[(*J)++] = Entry;
+}
+
+
+
 static void CreateExportPool (void)
 /* Create an array with pointer to all exports */
 {
-    unsigned I, J;
+    unsigned J = 0;
 
     /* Allocate memory */
     if (ExpPool) {
@@ -689,15 +708,8 @@ static void CreateExportPool (void)
     }
     ExpPool = xmalloc (ExpCount * sizeof (Export*));
 
-    /* Walk through the list and insert the exports */
-    for (I = 0, J = 0; I < sizeof (HashTab) / sizeof (HashTab [0]); ++I) {
-	Export* E = HashTab[I];
-	while (E) {
-	    CHECK (J < ExpCount);
-       	    ExpPool[J++] = E;
-	    E = E->Next;
-	}
-    }
+    /* Walk through the hash table and insert the exports */
+    HT_Walk (&ExpTab, AddToExportPool, &J);
 
     /* Sort them by name */
     qsort (ExpPool, ExpCount, sizeof (Export*), CmpExpName);
@@ -715,6 +727,45 @@ void CheckExports (void)
 
     /* Check for symbol type mismatches */
     CheckSymTypes ();
+
+    /* Tell the user how well the hash table did */
+    HT_PrintStats (&ExpTab, "Exports");
+}
+
+
+
+/* Visitor data for VisitUnresolved */
+typedef struct UnresolvedVisitor UnresolvedVisitor;
+struct UnresolvedVisitor {
+    ExpVisitFunc    F;                  /* Function to call */
+    void*           Data;               /* Data for the function */
+};
+
+
+
+static void VisitIfUnresolved (void* Entry, void* Data)
+/* Call the visitor in Data if the export is an unresolved one */
+{
+    Export*            E = Entry;
+    UnresolvedVisitor* V = Data;
+    if (E->Expr == 0 && E->ImpCount > 0) {
+        V->F (E->Name, V->Data);
+    }
+}
+
+
+
+void VisitUnresolved (ExpVisitFunc F, void* Data)
+/* Call F for each name that is imported but has no matching export. Contrary
+ * to CheckUnresolvedImports, this may be called while resolving, before the
+ * exports are checked.
+ */
+{
+    /* The export pool may not exist yet, so walk the hash table */
+    UnresolvedVisitor V;
+    V.F    = F;
+    V.Data = Data;
+    HT_Walk (&ExpTab, VisitIfUnresolved, &V);
 }
 
 
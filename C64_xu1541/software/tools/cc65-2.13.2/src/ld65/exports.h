@@ -43,7 +43,9 @@
 /* common */
 #include "cddefs.h"
 #include "exprdefs.h"
+#include "filemap.h"
 #include "filepos.h"
+#include "hashtab.h"
 
 /* ld65 */
 #include "objdata.h"
@@ -75,7 +77,7 @@ struct Import {
 typedef struct Export Export;
 struct Export {
     unsigned            Name;  	       	/* Name */
-    Export*    	       	Next;  		/* Hash table link */
+    HashNode            Node;           /* Hash table node */
     unsigned 		Flags;		/* Generic flags */
     ObjData* 		Obj;		/* Object file that exports the name */
     unsigned 		ImpCount;	/* How many imports for this symbol? */
@@ -97,6 +99,11 @@ struct Export {
  */
 typedef int (*ExpCheckFunc) (unsigned Name, void* Data);
 
+/* Prototype of a function that is called by VisitUnresolved for each symbol
+ * that is imported but not (yet) exported.
+ */
+typedef void (*ExpVisitFunc) (unsigned Name, void* Data);
+
 
 
 /*****************************************************************************/
@@ -111,7 +118,7 @@ void FreeImport (Import* I);
  * aren't referenced).
  */
 
-Import* ReadImport (FILE* F, ObjData* Obj);
+Import* ReadImport (FileMap* F, ObjData* Obj);
 /* Read an import from a file and insert it into the table */
 
 Import* GenImport (const char* Name, unsigned char AddrSize);
@@ -126,7 +133,7 @@ void FreeExport (Export* E);
  * aren't referenced).
  */
 
-Export* ReadExport (FILE* F, ObjData* Obj);
+Export* ReadExport (FileMap* F, ObjData* Obj);
 /* Read an export from a file */
 
 void InsertExport (Export* E);
@@ -166,6 +173,12 @@ void CheckExports (void);
  * mismatches.
  */
 
+void VisitUnresolved (ExpVisitFunc F, void* Data);
+/* Call F for each name that is imported but has no matching export. Contrary
+ * to CheckUnresolvedImports, this may be called while resolving, before the
+ * exports are checked.
+ */
+
 void CheckUnresolvedImports (ExpCheckFunc F, void* Data);
 /* Check if there are any unresolved imports. On unresolved imports, F is
  * called (see the comments on ExpCheckFunc in the data section).
@@ -464,7 +464,7 @@ ExprNode* SectionExpr (Section* Sec, long Offs, ObjData* O)
 
 
 
-ExprNode* ReadExpr (FILE* F, ObjData* O)
+ExprNode* ReadExpr (FileMap* F, ObjData* O)
 /* Read an expression from the given file */
 {
     ExprNode* Expr;
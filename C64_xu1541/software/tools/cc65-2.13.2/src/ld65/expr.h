@@ -40,6 +40,7 @@
 
 /* common */
 #include "exprdefs.h"
+#include "filemap.h"
 
 /* ld65 */
 #include "objdata.h"
@@ -86,7 +87,7 @@ ExprNode* SegmentExpr (Segment* Seg, long Offs, ObjData* O);
 ExprNode* SectionExpr (Section* Sec, long Offs, ObjData* O);
 /* Return an expression tree that encodes an offset into a section */
 
-ExprNode* ReadExpr (FILE* F, ObjData* O);
+ExprNode* ReadExpr (FileMap* F, ObjData* O);
 /* Read an expression from the given file */
 
 int EqualExpr (ExprNode* E1, ExprNode* E2);
@@ -60,7 +60,7 @@ static FileInfo* NewFileInfo (void)
 
 
 
-FileInfo* ReadFileInfo (FILE* F, ObjData* O)
+FileInfo* ReadFileInfo (FileMap* F, ObjData* O)
 /* Read a file info from a file and return it */
 {
     /* Allocate a new FileInfo structure */
@@ -42,6 +42,7 @@
 
 /* common */
 #include "coll.h"
+#include "filemap.h"
 #include "filepos.h"
 
 /* ld65 */
@@ -70,7 +71,7 @@ struct FileInfo {
 
 
 
-FileInfo* ReadFileInfo (FILE* F, ObjData* O);
+FileInfo* ReadFileInfo (FileMap* F, ObjData* O);
 /* Read a file info from a file and return it */
 
 
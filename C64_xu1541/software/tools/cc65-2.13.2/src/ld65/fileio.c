@@ -52,24 +52,21 @@
 
 
 
-void FileSetPos (FILE* F, unsigned long Pos)
+void FileSetPos (FileMap* F, unsigned long Pos)
 /* Seek to the given absolute position, fail on errors */
 {
-    if (fseek (F, Pos, SEEK_SET) != 0) {
- 	Error ("Cannot seek: %s", strerror (errno));
+    if (Pos > F->Size) {
+ 	Error ("Cannot seek: Position %lu is beyond end of file", Pos);
     }
+    F->Pos = Pos;
 }
 
 
 
-unsigned long FileGetPos (FILE* F)
-/* Return the current file position, fail on errors */
+unsigned long FileGetPos (const FileMap* F)
+/* Return the current file position */
 {
-    long Pos = ftell (F);
-    if (Pos < 0) {
-       	Error ("Error in ftell: %s", strerror (errno));
-    }
-    return Pos;
+    return F->Pos;
 }
 
 
@@ -193,19 +190,18 @@ void WriteMult (FILE* F, unsigned char Val, unsigned long Count)
 
 
 
-unsigned Read8 (FILE* F)
+unsigned Read8 (FileMap* F)
 /* Read an 8 bit value from the file */
 {
-    int C = getc (F);
-    if (C == EOF) {
+    if (F->Pos >= F->Size) {
  	Error ("Read error (file corrupt?)");
     }
-    return C;
+    return F->Data[F->Pos++];
 }
 
 
 
-unsigned Read16 (FILE* F)
+unsigned Read16 (FileMap* F)
 /* Read a 16 bit value from the file */
 {
     unsigned Lo = Read8 (F);
@@ -215,7 +211,7 @@ unsigned Read16 (FILE* F)
 
 
 
-unsigned long Read24 (FILE* F)
+unsigned long Read24 (FileMap* F)
 /* Read a 24 bit value from the file */
 {
     unsigned long Lo = Read16 (F);
@@ -225,7 +221,7 @@ unsigned long Read24 (FILE* F)
 
 
 
-unsigned long Read32 (FILE* F)
+unsigned long Read32 (FileMap* F)
 /* Read a 32 bit value from the file */
 {
     unsigned long Lo = Read16 (F);
@@ -235,7 +231,7 @@ unsigned long Read32 (FILE* F)
 
 
 
-long Read32Signed (FILE* F)
+long Read32Signed (FileMap* F)
 /* Read a 32 bit value from the file. Sign extend the value. */
 {
     /* Read a 32 bit value */
@@ -253,7 +249,7 @@ long Read32Signed (FILE* F)
 
 
 
-unsigned long ReadVar (FILE* F)
+unsigned long ReadVar (FileMap* F)
 /* Read a variable size value from the file */
 {
     /* The value was written to the file in 7 bit chunks LSB first. If there
@@ -277,37 +273,31 @@ unsigned long ReadVar (FILE* F)
 
 
 
-unsigned ReadStr (FILE* F)
+unsigned ReadStr (FileMap* F)
 /* Read a string from the file, place it into the global string pool, and
  * return its string id.
  */
 {
-    unsigned    Id;
-    StrBuf      Buf = STATIC_STRBUF_INITIALIZER;
+    StrBuf      Buf;
 
     /* Read the length */
     unsigned Len = ReadVar (F);
 
-    /* Expand the string buffer memory */
-    SB_Realloc (&Buf, Len);
-
-    /* Read the string */
-    ReadData (F, SB_GetBuf (&Buf), Len);
-    Buf.Len = Len;
-
-    /* Insert it into the string pool and remember the id */
-    Id = GetStrBufId (&Buf);
-
-    /* Free the memory buffer */
-    SB_Done (&Buf);
+    /* Let the buffer point to the string in the file. The string pool will
+     * make a copy if it doesn't have the string already.
+     */
+    Buf.Buf       = (char*) MapData (F, Len);
+    Buf.Len       = Len;
+    Buf.Index     = 0;
+    Buf.Allocated = 0;
 
-    /* Return the string id */
-    return Id;
+    /* Insert it into the string pool and return the id */
+    return GetStrBufId (&Buf);
 }
 
 
 
-FilePos* ReadFilePos (FILE* F, FilePos* Pos)
+FilePos* ReadFilePos (FileMap* F, FilePos* Pos)
 /* Read a file position from the file */
 {
     /* Read the data fields */
@@ -319,15 +309,28 @@ FilePos* ReadFilePos (FILE* F, FilePos* Pos)
 
 
 
-void* ReadData (FILE* F, void* Data, unsigned Size)
+void* ReadData (FileMap* F, void* Data, unsigned Size)
 /* Read data from the file */
 {
     /* Explicitly allow reading zero bytes */
     if (Size > 0) {
-	if (fread (Data, 1, Size, F) != Size) {
-	    Error ("Read error (file corrupt?)");
-	}
+	memcpy (Data, MapData (F, Size), Size);
+    }
+    return Data;
+}
+
+
+
+const void* MapData (FileMap* F, unsigned Size)
+/* Return a pointer to the next Size bytes of the file and skip them. The
+ * pointer is valid as long as the file is open.
+ */
+{
+    const unsigned char* Data = F->Data + F->Pos;
+    if (Size > F->Size - F->Pos) {
+	Error ("Read error (file corrupt?)");
     }
+    F->Pos += Size;
     return Data;
 }
 
@@ -41,6 +41,7 @@
 #include <stdio.h>
 
 /* common */
+#include "filemap.h"
 #include "filepos.h"
 
 
@@ -51,11 +52,11 @@
 
 
 
-void FileSetPos (FILE* F, unsigned long Pos);
+void FileSetPos (FileMap* F, unsigned long Pos);
 /* Seek to the given absolute position, fail on errors */
 
-unsigned long FileGetPos (FILE* F);
-/* Return the current file position, fail on errors */
+unsigned long FileGetPos (const FileMap* F);
+/* Return the current file position */
 
 void Write8 (FILE* F, unsigned Val);
 /* Write an 8 bit value to the file */
@@ -84,35 +85,40 @@ void WriteData (FILE* F, const void* Data, unsigned Size);
 void WriteMult (FILE* F, unsigned char Val, unsigned long Count);
 /* Write one byte several times to the file */
 
-unsigned Read8 (FILE* F);
+unsigned Read8 (FileMap* F);
 /* Read an 8 bit value from the file */
 
-unsigned Read16 (FILE* F);
+unsigned Read16 (FileMap* F);
 /* Read a 16 bit value from the file */
 
-unsigned long Read24 (FILE* F);
+unsigned long Read24 (FileMap* F);
 /* Read a 24 bit value from the file */
 
-unsigned long Read32 (FILE* F);
+unsigned long Read32 (FileMap* F);
 /* Read a 32 bit value from the file */
 
-long Read32Signed (FILE* F);
+long Read32Signed (FileMap* F);
 /* Read a 32 bit value from the file. Sign extend the value. */
 
-unsigned long ReadVar (FILE* F);
+unsigned long ReadVar (FileMap* F);
 /* Read a variable size value from the file */
 
-unsigned ReadStr (FILE* F);
+unsigned ReadStr (FileMap* F);
 /* Read a string from the file, place it into the global string pool, and
  * return its string id.
  */
 
-FilePos* ReadFilePos (FILE* F, FilePos* Pos);
+FilePos* ReadFilePos (FileMap* F, FilePos* Pos);
 /* Read a file position from the file */
 
-void* ReadData (FILE* F, void* Data, unsigned Size);
+void* ReadData (FileMap* F, void* Data, unsigned Size);
 /* Read data from the file */
 
+const void* MapData (FileMap* F, unsigned Size);
+/* Return a pointer to the next Size bytes of the file and skip them. The
+ * pointer is valid as long as the file is open.
+ */
+
 
 
 /* End of fileio.h */
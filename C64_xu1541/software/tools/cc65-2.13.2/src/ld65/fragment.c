@@ -55,22 +55,15 @@ Fragment* NewFragment (unsigned char Type, unsigned Size, Section* S)
 {
     Fragment* F;
 
-    /* Calculate the size of the memory block. LitBuf is only needed if the
-     * fragment contains literal data.
-     */
-    unsigned FragSize = sizeof (Fragment) - 1;
-    if (Type == FRAG_LITERAL) {
-        FragSize += Size;
-    }
-
     /* Allocate memory */
-    F = xmalloc (FragSize);
+    F = xmalloc (sizeof (Fragment));
 
     /* Initialize the data */
     F->Next      = 0;
     F->Obj       = 0;
     F->Size      = Size;
     F->Expr      = 0;
+    F->LitBuf    = 0;
     InitFilePos (&F->Pos);
     F->LI        = 0;
     F->Type      = Type;
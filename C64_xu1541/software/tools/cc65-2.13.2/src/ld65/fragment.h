@@ -71,7 +71,7 @@ struct Fragment {
     FilePos  	 	Pos;		/* File position in source */
     struct LineInfo*    LI;             /* Additional line info */
     unsigned char    	Type;  		/* Type of fragment */
-    unsigned char      	LitBuf [1]; 	/* Dynamically alloc'ed literal buffer */
+    const unsigned char* LitBuf;        /* Literal data in the mapped file */
 };
 
 
@@ -35,10 +35,10 @@
 
 #include <stdio.h>
 #include <string.h>
-#include <errno.h>
 
 /* common */
 #include "exprdefs.h"
+#include "filemap.h"
 #include "filepos.h"
 #include "libdefs.h"
 #include "objdefs.h"
@@ -62,15 +62,49 @@
 
 
 
+/* Entry in the export index of a library */
+typedef struct LibIndexEntry LibIndexEntry;
+struct LibIndexEntry {
+    LibIndexEntry*  Next;       /* Hash chain */
+    unsigned        Name;       /* String id of the exported name */
+    unsigned        Mod;        /* Index of the exporting module */
+};
+
 /* Library data structure */
 typedef struct Library Library;
 struct Library {
     Library*    Next;
     unsigned    Name;           /* String id of the name */
-    FILE*       F;              /* Open file stream */
+    FileMap*    F;              /* Mapped library file */
     LibHeader   Header;         /* Library header */
     unsigned    ModCount;       /* Number of modules in the library */
     ObjData**   Modules;        /* Modules */
+    unsigned    Base;           /* Position of the first module while resolving */
+    unsigned    IndexMask;      /* Hash mask for the export index */
+    LibIndexEntry** Index;      /* Export index, hashed by name */
+    LibIndexEntry*  Entries;    /* Memory for the index entries */
+};
+
+/* A heap of module positions, smallest position first */
+typedef struct ModHeap ModHeap;
+struct ModHeap {
+    unsigned    Count;          /* Number of positions in the heap */
+    unsigned*   Items;          /* Positions */
+};
+
+/* State of the resolver. The modules of all open libraries are numbered
+ * consecutively in the order they are searched. Modules are checked in the
+ * same order as a repeated linear search over all libraries would check
+ * them, but only those that export a name that was unresolved when it was
+ * queued are looked at.
+ */
+typedef struct Resolver Resolver;
+struct Resolver {
+    ObjData**       Modules;    /* All modules by position */
+    unsigned char*  Queued;     /* Flag for positions already in a heap */
+    unsigned        Pos;        /* Position of the linear search */
+    ModHeap         Ahead;      /* Positions >= Pos */
+    ModHeap         Behind;     /* Positions < Pos, checked in the next round */
 };
 
 /* List of open libraries */
@@ -87,7 +121,7 @@ static int Grouping = 0;
 
 
 
-static Library* NewLibrary (FILE* F, const char* Name)
+static Library* NewLibrary (FileMap* F, const char* Name)
 /* Create a new Library structure and return it */
 {
     /* Allocate memory */
@@ -99,6 +133,10 @@ static Library* NewLibrary (FILE* F, const char* Name)
     L->F        = F;
     L->ModCount = 0;
     L->Modules  = 0;
+    L->Base     = 0;
+    L->IndexMask = 0;
+    L->Index    = 0;
+    L->Entries  = 0;
 
     /* Return the new struct */
     return L;
@@ -106,16 +144,20 @@ static Library* NewLibrary (FILE* F, const char* Name)
 
 
 
-static void FreeLibrary (Library* L)
-/* Free a library structure */
+static void FreeLibrary (Library* L, int KeepFile)
+/* Free a library structure. If KeepFile is true, the mapped file is kept,
+ * because modules loaded from the library reference its data.
+ */
 {
-    /* Close the library file */
-    if (fclose (L->F) != 0) {
-        Error ("Error closing `%s': %s", GetString (L->Name), strerror (errno));
+    /* Close the library file if it's no longer needed */
+    if (!KeepFile) {
+        FMapClose (L->F);
     }
 
-    /* Free the module index */
+    /* Free the module index and the export index */
     xfree (L->Modules);
+    xfree (L->Index);
+    xfree (L->Entries);
 
     /* Free the library structure */
     xfree (L);
@@ -132,10 +174,11 @@ static void FreeLibrary (Library* L)
 static void LibSeek (Library* L, unsigned long Offs)
 /* Do a seek in the library checking for errors */
 {
-    if (fseek (L->F, Offs, SEEK_SET) != 0) {
-        Error ("Seek error in `%s' (%lu): %s",
-               GetString (L->Name), Offs, strerror (errno));
+    if (Offs > L->F->Size) {
+        Error ("Seek error in `%s' (%lu): Position is beyond end of file",
+               GetString (L->Name), Offs);
     }
+    FileSetPos (L->F, Offs);
 }
 
 
@@ -245,6 +288,135 @@ static void LibReadIndex (Library* L)
 
 
 
+static void LibBuildIndex (Library* L)
+/* Build the index that maps exported names to the modules of the library */
+{
+    unsigned I, J;
+    unsigned Count;
+    unsigned Size;
+    LibIndexEntry* E;
+
+    /* Count the exports */
+    Count = 0;
+    for (I = 0; I < L->ModCount; ++I) {
+        Count += L->Modules[I]->ExportCount;
+    }
+
+    /* Use a power of two for the table size, so we can mask the name */
+    Size = 1;
+    while (Size < Count) {
+        Size <<= 1;
+    }
+    L->IndexMask = Size - 1;
+    L->Index     = xmalloc (Size * sizeof (L->Index[0]));
+    memset (L->Index, 0, Size * sizeof (L->Index[0]));
+    L->Entries   = xmalloc (Count * sizeof (L->Entries[0]));
+
+    /* Insert the exports, last module first, so that the hash chains are
+     * ordered by module.
+     */
+    E = L->Entries;
+    I = L->ModCount;
+    while (I-- > 0) {
+        ObjData* O = L->Modules[I];
+        for (J = 0; J < O->ExportCount; ++J, ++E) {
+            unsigned Hash = O->Exports[J]->Name & L->IndexMask;
+            E->Name = O->Exports[J]->Name;
+            E->Mod  = I;
+            E->Next = L->Index[Hash];
+            L->Index[Hash] = E;
+        }
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                  Resolver                                 */
+/*****************************************************************************/
+
+
+
+static void HeapPush (ModHeap* H, unsigned Pos)
+/* Insert a module position into the heap. The heap must have room for it. */
+{
+    unsigned I = H->Count++;
+    while (I > 0) {
+        unsigned Parent = (I - 1) / 2;
+        if (H->Items[Parent] <= Pos) {
+            break;
+        }
+        H->Items[I] = H->Items[Parent];
+        I = Parent;
+    }
+    H->Items[I] = Pos;
+}
+
+
+
+static unsigned HeapPop (ModHeap* H)
+/* Remove the smallest module position from the heap and return it. The heap
+ * must not be empty.
+ */
+{
+    unsigned Min  = H->Items[0];
+    unsigned Last = H->Items[--H->Count];
+    unsigned I    = 0;
+    while (1) {
+        unsigned Child = 2 * I + 1;
+        if (Child >= H->Count) {
+            break;
+        }
+        if (Child + 1 < H->Count && H->Items[Child+1] < H->Items[Child]) {
+            ++Child;
+        }
+        if (Last <= H->Items[Child]) {
+            break;
+        }
+        H->Items[I] = H->Items[Child];
+        I = Child;
+    }
+    H->Items[I] = Last;
+    return Min;
+}
+
+
+
+static void QueueExporters (unsigned Name, void* Data)
+/* Queue all modules from the open libraries that export Name */
+{
+    Resolver* R = Data;
+    unsigned I;
+
+    for (I = 0; I < CollCount (&OpenLibs); ++I) {
+
+        /* Get the next library */
+        const Library* L = CollConstAt (&OpenLibs, I);
+
+        /* Walk over the hash chain for the name */
+        const LibIndexEntry* E;
+        if (L->Index == 0) {
+            continue;
+        }
+        for (E = L->Index[Name & L->IndexMask]; E; E = E->Next) {
+
+            unsigned Pos;
+            if (E->Name != Name) {
+                continue;
+            }
+
+            /* Queue the module if it's not already queued or added */
+            Pos = L->Base + E->Mod;
+            if (!R->Queued[Pos] && (R->Modules[Pos]->Flags & OBJ_REF) == 0) {
+                R->Queued[Pos] = 1;
+                HeapPush (Pos >= R->Pos? &R->Ahead : &R->Behind, Pos);
+            }
+        }
+    }
+}
+
+
+
 /*****************************************************************************/
 /*  	   	  	       High level stuff				     */
 /*****************************************************************************/
@@ -274,7 +446,7 @@ static void LibCheckExports (ObjData* O)
 
 
 
-static void LibOpen (FILE* F, const char* Name)
+static void LibOpen (FileMap* F, const char* Name)
 /* Open the library for use */
 {
     /* Create a new library structure */
@@ -286,6 +458,9 @@ static void LibOpen (FILE* F, const char* Name)
     /* Seek to the index position and read the index */
     LibReadIndex (L);
 
+    /* Build the index of the exported names */
+    LibBuildIndex (L);
+
     /* Add the library to the list of open libraries */
     CollAppend (&OpenLibs, L);
 }
@@ -296,42 +471,85 @@ static void LibResolve (void)
 /* Resolve all externals from the list of all currently open libraries */
 {
     unsigned I, J;
-    unsigned Additions;
+    unsigned Count;
+    unsigned Loaded;
+    Resolver R;
 
-    /* Walk repeatedly over all open libraries until there's nothing more
-     * to add.
-     */
-    do {
+    /* Number the modules of all open libraries */
+    Count = 0;
+    for (I = 0; I < CollCount (&OpenLibs); ++I) {
+        Library* L = CollAt (&OpenLibs, I);
+        L->Base = Count;
+        Count  += L->ModCount;
+    }
+    R.Modules      = xmalloc (Count * sizeof (R.Modules[0]));
+    R.Queued       = xmalloc (Count);
+    R.Pos          = 0;
+    R.Ahead.Count  = 0;
+    R.Ahead.Items  = xmalloc (Count * sizeof (R.Ahead.Items[0]));
+    R.Behind.Count = 0;
+    R.Behind.Items = xmalloc (Count * sizeof (R.Behind.Items[0]));
+    memset (R.Queued, 0, Count);
+    for (I = 0; I < CollCount (&OpenLibs); ++I) {
+        Library* L = CollAt (&OpenLibs, I);
+        for (J = 0; J < L->ModCount; ++J) {
+            R.Modules[L->Base + J] = L->Modules[J];
+        }
+    }
 
-        Additions = 0;
+    /* Queue all modules that may resolve one of the currently open imports */
+    VisitUnresolved (QueueExporters, &R);
 
-        /* Walk over all libraries */
-        for (I = 0; I < CollCount (&OpenLibs); ++I) {
+    /* Check the queued modules in the order of a linear search. If the end
+     * of the module list is reached, the search starts over with the modules
+     * that were queued behind the current position. We're done if there's
+     * nothing more in the queue.
+     */
+    while (1) {
 
-            /* Get the next library */
-            Library* L = CollAt (&OpenLibs, I);
+        ObjData* O;
+        unsigned Pos;
+
+        if (R.Ahead.Count == 0) {
+            ModHeap Tmp;
+            if (R.Behind.Count == 0) {
+                break;
+            }
+            Tmp      = R.Ahead;
+            R.Ahead  = R.Behind;
+            R.Behind = Tmp;
+        }
 
-            /* Walk through all modules in this library and check for each
-             * module if there are unresolved externals in existing modules
-             * that may be resolved by adding the module.
-             */
-            for (J = 0; J < L->ModCount; ++J) {
+        /* Get the next module */
+        Pos = HeapPop (&R.Ahead);
+        O   = R.Modules[Pos];
+        R.Queued[Pos] = 0;
+        R.Pos = Pos + 1;
 
-                /* Get the next module */
-                ObjData* O = L->Modules[J];
+        /* The module may have been added or the name resolved in between */
+        if (O->Flags & OBJ_REF) {
+            continue;
+        }
+        LibCheckExports (O);
 
-                /* We only need to check this module if it wasn't added before */
-                if ((O->Flags & OBJ_REF) == 0) {
-                    LibCheckExports (O);
-                    if (O->Flags & OBJ_REF) {
-                        /* The routine added the file */
-                        ++Additions;
-                    }
+        /* If the module was added, queue the exporters of its own imports
+         * that are still open.
+         */
+        if (O->Flags & OBJ_REF) {
+            for (J = 0; J < O->ImportCount; ++J) {
+                const Import* Imp = O->Imports[J];
+                if (IsUnresolvedExport (Imp->Exp)) {
+                    QueueExporters (Imp->Exp->Name, &R);
                 }
             }
         }
+    }
 
-    } while (Additions > 0);
+    /* Free the resolver data */
+    xfree (R.Modules);
+    xfree (R.Queued);
+    xfree (R.Ahead.Items);
+    xfree (R.Behind.Items);
 
     /* We do know now which modules must be added, so we can load the data
      * for these modues into memory. Since we're walking over all modules
@@ -345,6 +563,7 @@ static void LibResolve (void)
         /* Walk over all modules in this library and add the files list and
          * sections for all referenced modules.
          */
+        Loaded = 0;
         for (J = 0; J < L->ModCount; ++J) {
 
             /* Get the object data */
@@ -388,6 +607,7 @@ static void LibResolve (void)
 
                 /* Insert the object into the list of all used object files */
                 InsertObjData (O);
+                ++Loaded;
 
             } else {
 
@@ -397,8 +617,10 @@ static void LibResolve (void)
             }
         }
 
-        /* Close the file and delete the library data */
-        FreeLibrary (L);
+        /* Delete the library data. The file is closed if no module was
+         * loaded from it, otherwise the segment data is still needed.
+         */
+        FreeLibrary (L, Loaded > 0);
     }
 
     /* We're done with all open libraries, clear the OpenLibs collection */
@@ -407,7 +629,7 @@ static void LibResolve (void)
 
 
 
-void LibAdd (FILE* F, const char* Name)
+void LibAdd (FileMap* F, const char* Name)
 /* Add files from the library to the list if there are references that could
  * be satisfied.
  */
@@ -38,13 +38,18 @@
 
 
 
+/* common */
+#include "filemap.h"
+
+
+
 /*****************************************************************************/
 /*				     Code				     */
 /*****************************************************************************/
 
 
 
-void LibAdd (FILE* F, const char* Name);
+void LibAdd (FileMap* F, const char* Name);
 /* Add files from the library to the list if there are references that could
  * be satisfied.
  */
@@ -85,7 +85,7 @@ static LineInfo* NewLineInfo (void)
 
 
 
-LineInfo* ReadLineInfo (FILE* F, ObjData* O)
+LineInfo* ReadLineInfo (FileMap* F, ObjData* O)
 /* Read a line info from a file and return it */
 {
     /* Allocate a new LineInfo struct and initialize it */
@@ -152,9 +152,12 @@ static void AddCodeRange (LineInfo* LI, unsigned long Offs, unsigned long Size)
 
 
 void RelocLineInfo (Segment* S)
-/* Relocate the line info for a segment. */
+/* Relocate the line info for a segment. The code ranges use the run
+ * addresses of the segment, so the debug info can be mapped back to the
+ * program without knowing the segment layout.
+ */
 {
-    unsigned long Offs = 0;
+    unsigned long Offs = S->PC;
 
     /* Loop over all sections in this segment */
     Section* Sec = S->SecRoot;
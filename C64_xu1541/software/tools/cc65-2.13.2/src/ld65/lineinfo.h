@@ -40,6 +40,7 @@
 
 /* common */
 #include "coll.h"
+#include "filemap.h"
 #include "filepos.h"
 
 /* ld65 */
@@ -87,7 +88,7 @@ struct LineInfo {
 
 
 
-LineInfo* ReadLineInfo (FILE* F, ObjData* O);
+LineInfo* ReadLineInfo (FileMap* F, ObjData* O);
 /* Read a line info from a file and return it */
 
 void RelocLineInfo (struct Segment* S);
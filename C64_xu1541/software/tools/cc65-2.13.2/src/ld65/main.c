@@ -42,6 +42,7 @@
 #include "addrsize.h"
 #include "chartype.h"
 #include "cmdline.h"
+#include "filemap.h"
 #include "filetype.h"
 #include "libdefs.h"
 #include "objdefs.h"
@@ -164,7 +165,7 @@ static void LinkFile (const char* Name, FILETYPE Type)
 /* Handle one file */
 {
     char*         PathName;
-    FILE*         F;
+    FileMap*      F;
     unsigned long Magic;
 
 
@@ -195,7 +196,7 @@ static void LinkFile (const char* Name, FILETYPE Type)
     }
 
     /* Try to open the file */
-    F = fopen (PathName, "rb");
+    F = FMapOpen (PathName);
     if (F == 0) {
         Error ("Cannot open `%s': %s", PathName, strerror (errno));
     }
@@ -222,7 +223,7 @@ static void LinkFile (const char* Name, FILETYPE Type)
        	    break;
 
        	default:
-	    fclose (F);
+	    FMapClose (F);
 	    Error ("File `%s' has unknown type", PathName);
 
     }
@@ -77,7 +77,7 @@ static unsigned GetModule (const char* Name)
 
 
 
-static void ObjReadHeader (FILE* Obj, ObjHeader* H, const char* Name)
+static void ObjReadHeader (FileMap* Obj, ObjHeader* H, const char* Name)
 /* Read the header of the object file checking the signature */
 {
     H->Version	  = Read16 (Obj);
@@ -110,7 +110,7 @@ static void ObjReadHeader (FILE* Obj, ObjHeader* H, const char* Name)
 
 
 
-void ObjReadFiles (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadFiles (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the files list from a file at the given position */
 {
     unsigned I;
@@ -128,7 +128,7 @@ void ObjReadFiles (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadSections (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadSections (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the section data from a file at the given position */
 {
     unsigned I;
@@ -146,7 +146,7 @@ void ObjReadSections (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadImports (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadImports (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the imports from a file at the given position */
 {
     unsigned I;
@@ -164,7 +164,7 @@ void ObjReadImports (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadExports (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadExports (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the exports from a file at the given position */
 {
     unsigned I;
@@ -182,7 +182,7 @@ void ObjReadExports (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadDbgSyms (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadDbgSyms (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the debug symbols from a file at the given position */
 {
     unsigned I;
@@ -200,7 +200,7 @@ void ObjReadDbgSyms (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadLineInfos (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadLineInfos (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the line infos from a file at the given position */
 {
     unsigned I;
@@ -218,7 +218,7 @@ void ObjReadLineInfos (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadStrPool (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadStrPool (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the string pool from a file at the given position */
 {
     unsigned I;
@@ -236,7 +236,7 @@ void ObjReadStrPool (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadAssertions (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadAssertions (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the assertions from a file at the given offset */
 {
     unsigned I;
@@ -254,7 +254,7 @@ void ObjReadAssertions (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjReadScopes (FILE* F, unsigned long Pos, ObjData* O)
+void ObjReadScopes (FileMap* F, unsigned long Pos, ObjData* O)
 /* Read the scope table from a file at the given offset */
 {
     unsigned I;
@@ -272,7 +272,7 @@ void ObjReadScopes (FILE* F, unsigned long Pos, ObjData* O)
 
 
 
-void ObjAdd (FILE* Obj, const char* Name)
+void ObjAdd (FileMap* Obj, const char* Name)
 /* Add an object file to the module list */
 {
     /* Create a new structure for the object file data */
@@ -320,8 +320,9 @@ void ObjAdd (FILE* Obj, const char* Name)
     /* Mark this object file as needed */
     O->Flags |= OBJ_REF;
 
-    /* Done, close the file (we read it only, so no error check) */
-    fclose (Obj);
+    /* Done. The file is not closed, since the literal data of the segments
+     * still lives in the mapped file.
+     */
 
     /* Insert the imports and exports to the global lists */
     InsertObjGlobals (O);
@@ -41,6 +41,7 @@
 #include <stdio.h>
 
 /* common */
+#include "filemap.h"
 #include "objdefs.h"
 
 /* ld65 */
@@ -54,34 +55,34 @@
 
 
 
-void ObjReadFiles (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadFiles (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the files list from a file at the given position */
 
-void ObjReadSections (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadSections (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the section data from a file at the given position */
 
-void ObjReadImports (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadImports (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the imports from a file at the given position */
 
-void ObjReadExports (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadExports (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the exports from a file at the given position */
 
-void ObjReadDbgSyms (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadDbgSyms (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the debug symbols from a file at the given position */
 
-void ObjReadLineInfos (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadLineInfos (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the line infos from a file at the given position */
 
-void ObjReadStrPool (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadStrPool (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the string pool from a file at the given position */
 
-void ObjReadAssertions (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadAssertions (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the assertions from a file at the given offset */
 
-void ObjReadScopes (FILE* F, unsigned long Pos, ObjData* O);
+void ObjReadScopes (FileMap* F, unsigned long Pos, ObjData* O);
 /* Read the scope table from a file at the given offset */
 
-void ObjAdd (FILE* F, const char* Name);
+void ObjAdd (FileMap* F, const char* Name);
 /* Add an object file to the module list */
 
 
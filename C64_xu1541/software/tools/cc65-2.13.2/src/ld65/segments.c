@@ -193,7 +193,7 @@ Section* NewSection (Segment* Seg, unsigned char Align, unsigned char AddrSize)
 
 
 
-Section* ReadSection (FILE* F, ObjData* O)
+Section* ReadSection (FileMap* F, ObjData* O)
 /* Read a section from a file */
 {
     unsigned      Name;
@@ -248,7 +248,7 @@ Section* ReadSection (FILE* F, ObjData* O)
 
 	    case FRAG_LITERAL:
 	       	Frag = NewFragment (Type, ReadVar (F), Sec);
-		ReadData (F, Frag->LitBuf, Frag->Size);
+		Frag->LitBuf = MapData (F, Frag->Size);
 	       	break;
 
 	    case FRAG_EXPR:
@@ -328,7 +328,7 @@ int IsBSSType (Segment* S)
 	Fragment* F = Sec->FragRoot;
 	while (F) {
 	    if (F->Type == FRAG_LITERAL) {
-		unsigned char* Data = F->LitBuf;
+		const unsigned char* Data = F->LitBuf;
 		unsigned long Count = F->Size;
 		while (Count--) {
 		    if (*Data++ != 0) {
@@ -354,7 +354,7 @@ void SegDump (void)
 {
     unsigned I;
     unsigned long Count;
-    unsigned char* Data;
+    const unsigned char* Data;
 
     Segment* Seg = SegRoot;
     while (Seg) {
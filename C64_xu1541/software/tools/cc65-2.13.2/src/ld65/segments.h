@@ -42,6 +42,7 @@
 
 /* common */
 #include "exprdefs.h"
+#include "filemap.h"
 
 
 
@@ -119,7 +120,7 @@ Segment* GetSegment (unsigned Name, unsigned char AddrSize, const char* ObjName)
 Section* NewSection (Segment* Seg, unsigned char Align, unsigned char AddrSize);
 /* Create a new section for the given segment */
 
-Section* ReadSection (FILE* F, struct ObjData* O);
+Section* ReadSection (FileMap* F, struct ObjData* O);
 /* Read a section from a file */
 
 Segment* SegFind (unsigned Name);
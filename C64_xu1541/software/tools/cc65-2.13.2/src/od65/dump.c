@@ -41,6 +41,7 @@
 #include "cddefs.h"
 #include "coll.h"
 #include "exprdefs.h"
+#include "filemap.h"
 #include "filepos.h"
 #include "objdefs.h"
 #include "optdefs.h"
@@ -120,7 +121,7 @@ static char* TimeToStr (unsigned long Time)
 
 
 
-static void SkipExpr (FILE* F)
+static void SkipExpr (FileMap* F)
 /* Skip an expression from the given file */
 {
     /* Read the node tag and handle NULL nodes */
@@ -200,7 +201,7 @@ static const char* GetExportFlags (unsigned Flags, const unsigned char* ConDes)
 
 
 
-void DumpObjHeader (FILE* F, unsigned long Offset)
+void DumpObjHeader (FileMap* F, unsigned long Offset)
 /* Dump the header of the given object file */
 {
     ObjHeader H;
@@ -256,7 +257,7 @@ void DumpObjHeader (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjOptions (FILE* F, unsigned long Offset)
+void DumpObjOptions (FileMap* F, unsigned long Offset)
 /* Dump the file options */
 {
     ObjHeader  H;
@@ -344,7 +345,7 @@ void DumpObjOptions (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjFiles (FILE* F, unsigned long Offset)
+void DumpObjFiles (FileMap* F, unsigned long Offset)
 /* Dump the source files */
 {
     ObjHeader  H;
@@ -394,7 +395,7 @@ void DumpObjFiles (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjSegments (FILE* F, unsigned long Offset)
+void DumpObjSegments (FileMap* F, unsigned long Offset)
 /* Dump the segments in the object file */
 {
     ObjHeader  H;
@@ -425,7 +426,7 @@ void DumpObjSegments (FILE* F, unsigned long Offset)
 
 	/* Read the data for one segments */
         unsigned long DataSize  = Read32 (F);
-        unsigned long NextSeg   = ftell (F) + DataSize;
+        unsigned long NextSeg   = FileGetPos (F) + DataSize;
        	const char*   Name      = GetString (&StrPool, ReadVar (F));
 	unsigned      Len       = strlen (Name);
 	unsigned long Size      = Read32 (F);
@@ -454,7 +455,7 @@ void DumpObjSegments (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjImports (FILE* F, unsigned long Offset)
+void DumpObjImports (FileMap* F, unsigned long Offset)
 /* Dump the imports in the object file */
 {
     ObjHeader  H;
@@ -505,7 +506,7 @@ void DumpObjImports (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjExports (FILE* F, unsigned long Offset)
+void DumpObjExports (FileMap* F, unsigned long Offset)
 /* Dump the exports in the object file */
 {
     ObjHeader 	H;
@@ -576,7 +577,7 @@ void DumpObjExports (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjDbgSyms (FILE* F, unsigned long Offset)
+void DumpObjDbgSyms (FileMap* F, unsigned long Offset)
 /* Dump the debug symbols from an object file */
 {
     ObjHeader   H;
@@ -649,7 +650,7 @@ void DumpObjDbgSyms (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjLineInfo (FILE* F, unsigned long Offset)
+void DumpObjLineInfo (FileMap* F, unsigned long Offset)
 /* Dump the line info from an object file */
 {
     ObjHeader   H;
@@ -705,7 +706,7 @@ void DumpObjLineInfo (FILE* F, unsigned long Offset)
 
 
 
-void DumpObjSegSize (FILE* F, unsigned long Offset)
+void DumpObjSegSize (FileMap* F, unsigned long Offset)
 /* Dump the sizes of the segment in the object file */
 {
     ObjHeader   H;
@@ -734,7 +735,7 @@ void DumpObjSegSize (FILE* F, unsigned long Offset)
 
        	/* Read the data for one segments */
         unsigned long DataSize = Read32 (F);
-        unsigned long NextSeg  = ftell (F) + DataSize;
+        unsigned long NextSeg  = FileGetPos (F) + DataSize;
 	const char*   Name     = GetString (&StrPool, ReadVar (F));
 	unsigned      Len      = strlen (Name);
 	unsigned long Size     = Read32 (F);
@@ -34,7 +34,6 @@
 
 
 #include <string.h>
-#include <errno.h>
 
 /* common */
 #include "xmalloc.h"
@@ -51,41 +50,37 @@
 
 
 
-void FileSetPos (FILE* F, unsigned long Pos)
+void FileSetPos (FileMap* F, unsigned long Pos)
 /* Seek to the given absolute position, fail on errors */
 {
-    if (fseek (F, Pos, SEEK_SET) != 0) {
- 	Error ("Cannot seek: %s", strerror (errno));
+    if (Pos > F->Size) {
+ 	Error ("Cannot seek: Position %lu is beyond end of file", Pos);
     }
+    F->Pos = Pos;
 }
 
 
 
-unsigned long FileGetPos (FILE* F)
-/* Return the current file position, fail on errors */
+unsigned long FileGetPos (const FileMap* F)
+/* Return the current file position */
 {
-    long Pos = ftell (F);
-    if (Pos < 0) {
-       	Error ("Error in ftell: %s", strerror (errno));
-    }
-    return Pos;
+    return F->Pos;
 }
 
 
 
-unsigned Read8 (FILE* F)
+unsigned Read8 (FileMap* F)
 /* Read an 8 bit value from the file */
 {
-    int C = getc (F);
-    if (C == EOF) {
+    if (F->Pos >= F->Size) {
  	Error ("Read error (file corrupt?)");
     }
-    return C;
+    return F->Data[F->Pos++];
 }
 
 
 
-unsigned Read16 (FILE* F)
+unsigned Read16 (FileMap* F)
 /* Read a 16 bit value from the file */
 {
     unsigned Lo = Read8 (F);
@@ -95,7 +90,7 @@ unsigned Read16 (FILE* F)
 
 
 
-unsigned long Read24 (FILE* F)
+unsigned long Read24 (FileMap* F)
 /* Read a 24 bit value from the file */
 {
     unsigned long Lo = Read16 (F);
@@ -105,7 +100,7 @@ unsigned long Read24 (FILE* F)
 
 
 
-unsigned long Read32 (FILE* F)
+unsigned long Read32 (FileMap* F)
 /* Read a 32 bit value from the file */
 {
     unsigned long Lo = Read16 (F);
@@ -115,7 +110,7 @@ unsigned long Read32 (FILE* F)
 
 
 
-long Read32Signed (FILE* F)
+long Read32Signed (FileMap* F)
 /* Read a 32 bit value from the file. Sign extend the value. */
 {
     /* Read a 32 bit value */
@@ -133,7 +128,7 @@ long Read32Signed (FILE* F)
 
 
 
-unsigned long ReadVar (FILE* F)
+unsigned long ReadVar (FileMap* F)
 /* Read a variable size value from the file */
 {
     /* The value was written to the file in 7 bit chunks LSB first. If there
@@ -157,7 +152,7 @@ unsigned long ReadVar (FILE* F)
 
 
 
-char* ReadStr (FILE* F)
+char* ReadStr (FileMap* F)
 /* Read a string from the file into a malloced area */
 {
     /* Read the length */
@@ -176,7 +171,7 @@ char* ReadStr (FILE* F)
 
 
 
-FilePos* ReadFilePos (FILE* F, FilePos* Pos)
+FilePos* ReadFilePos (FileMap* F, FilePos* Pos)
 /* Read a file position from the file */
 {
     /* Read the data fields */
@@ -188,21 +183,23 @@ FilePos* ReadFilePos (FILE* F, FilePos* Pos)
 
 
 
-void* ReadData (FILE* F, void* Data, unsigned Size)
+void* ReadData (FileMap* F, void* Data, unsigned Size)
 /* Read data from the file */
 {
     /* Accept zero sized reads */
     if (Size > 0) {
-	if (fread (Data, 1, Size, F) != Size) {
+	if (Size > F->Size - F->Pos) {
 	    Error ("Read error (file corrupt?)");
 	}
+	memcpy (Data, F->Data + F->Pos, Size);
+	F->Pos += Size;
     }
     return Data;
 }
 
 
 
-void ReadObjHeader (FILE* F, ObjHeader* H)
+void ReadObjHeader (FileMap* F, ObjHeader* H)
 /* Read an object file header from the file */
 {
     /* Read all fields */
@@ -233,7 +230,7 @@ void ReadObjHeader (FILE* F, ObjHeader* H)
 
 
 
-void ReadStrPool (FILE* F, Collection* C)
+void ReadStrPool (FileMap* F, Collection* C)
 /* Read a string pool from the current position into C. */
 {
     /* The number of strings is the first item */
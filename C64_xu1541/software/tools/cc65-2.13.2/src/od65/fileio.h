@@ -42,6 +42,7 @@
 
 /* common */
 #include "coll.h"
+#include "filemap.h"
 #include "filepos.h"
 #include "objdefs.h"
 
@@ -53,43 +54,43 @@
 
 
 
-void FileSetPos (FILE* F, unsigned long Pos);
+void FileSetPos (FileMap* F, unsigned long Pos);
 /* Seek to the given absolute position, fail on errors */
 
-unsigned long FileGetPos (FILE* F);
-/* Return the current file position, fail on errors */
+unsigned long FileGetPos (const FileMap* F);
+/* Return the current file position */
 
-unsigned Read8 (FILE* F);
+unsigned Read8 (FileMap* F);
 /* Read an 8 bit value from the file */
 
-unsigned Read16 (FILE* F);
+unsigned Read16 (FileMap* F);
 /* Read a 16 bit value from the file */
 
-unsigned long Read24 (FILE* F);
+unsigned long Read24 (FileMap* F);
 /* Read a 24 bit value from the file */
 
-unsigned long Read32 (FILE* F);
+unsigned long Read32 (FileMap* F);
 /* Read a 32 bit value from the file */
 
-long Read32Signed (FILE* F);
+long Read32Signed (FileMap* F);
 /* Read a 32 bit value from the file. Sign extend the value. */
 
-unsigned long ReadVar (FILE* F);
+unsigned long ReadVar (FileMap* F);
 /* Read a variable size value from the file */
 
-char* ReadStr (FILE* F);
+char* ReadStr (FileMap* F);
 /* Read a string from the file into a malloced area */
 
-FilePos* ReadFilePos (FILE* F, FilePos* Pos);
+FilePos* ReadFilePos (FileMap* F, FilePos* Pos);
 /* Read a file position from the file */
 
-void* ReadData (FILE* F, void* Data, unsigned Size);
+void* ReadData (FileMap* F, void* Data, unsigned Size);
 /* Read data from the file */
 
-void ReadObjHeader (FILE* F, ObjHeader* Header);
+void ReadObjHeader (FileMap* F, ObjHeader* Header);
 /* Read an object file header from the file */
 
-void ReadStrPool (FILE* F, Collection* C);
+void ReadStrPool (FileMap* F, Collection* C);
 /* Read a string pool from the current position into C. */
 
 
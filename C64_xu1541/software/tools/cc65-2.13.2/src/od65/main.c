@@ -40,6 +40,7 @@
 
 /* common */
 #include "cmdline.h"
+#include "filemap.h"
 #include "objdefs.h"
 #include "version.h"
 
@@ -213,7 +214,7 @@ static void DumpFile (const char* Name)
     unsigned long Magic;
 
     /* Try to open the file */
-    FILE* F = fopen (Name, "rb");
+    FileMap* F = FMapOpen (Name);
     if (F == 0) {
 	Error ("Cannot open `%s': %s", Name, strerror (errno));
     }
@@ -268,7 +269,7 @@ static void DumpFile (const char* Name)
     }
 
     /* Close the file */
-    fclose (F);
+    FMapClose (F);
 }
 
 
@@ -33,8 +33,10 @@
 
 
 
+#include <stdio.h>
 #include <string.h>
 #include <dlfcn.h>
+#include <pthread.h>
 
 /* common */
 #include "coll.h"
@@ -45,6 +47,7 @@
 /* sim65 */
 #include "cfgdata.h"
 #include "chipdata.h"
+#include "context.h"
 #include "cpucore.h"
 #include "error.h"
 #include "chip.h"
@@ -79,6 +82,9 @@ static int GetCfgNum (void* CfgInfo, const char* Name, long* Val);
  * true. If not found, return false.
  */
 
+static void PutChar (int C);
+/* Output a character to the output stream of the machine */
+
 
 
 /*****************************************************************************/
@@ -93,10 +99,15 @@ static Collection Chips = STATIC_COLLECTION_INITIALIZER;
 /* A collection containing all libraries */
 static Collection ChipLibraries = STATIC_COLLECTION_INITIALIZER;
 
+/* Protects the instance lists of the chips, since machines are created and
+ * freed by several threads.
+ */
+static pthread_mutex_t InstanceLock = PTHREAD_MUTEX_INITIALIZER;
+
 /* SimData instance */
 static const SimData Sim65Data = {
     1, 		    	/* MajorVersion */
-    1, 		    	/* MinorVersion */
+    2, 		    	/* MinorVersion */
     xmalloc,
     xfree,
     Warning,
@@ -108,6 +119,7 @@ static const SimData Sim65Data = {
     Break,
     IRQRequest,
     NMIRequest,
+    PutChar,
 };
 
 
@@ -155,6 +167,15 @@ static int GetCfgNum (void* CfgInfo, const char* Name, long* Val)
 
 
 
+static void PutChar (int C)
+/* Output a character to the output stream of the machine */
+{
+    const Sim65Context* Ctx = GetContext ();
+    putc (C, (Ctx && Ctx->Output)? Ctx->Output : stdout);
+}
+
+
+
 static int CmpChips (void* Data attribute ((unused)),
 		     const void* lhs, const void* rhs)
 /* Compare function for CollSort */
@@ -281,9 +302,12 @@ ChipInstance* NewChipInstance (const char* ChipName, unsigned Addr,
     CI->Addr = Addr;
     CI->Size = Size;
     CI->Data = C->Data->CreateInstance (Addr, Size, Attributes);
+    CI->Orig = 0;
 
     /* Assign the chip instance to the chip */
+    pthread_mutex_lock (&InstanceLock);
     CollAppend (&C->Instances, CI);
+    pthread_mutex_unlock (&InstanceLock);
 
     /* Return the new instance struct */
     return CI;
@@ -301,10 +325,14 @@ ChipInstance* MirrorChipInstance (const ChipInstance* Orig, unsigned Addr)
     CI->C    = Orig->C;
     CI->Addr = Addr;
     CI->Size = Orig->Size;
+    CI->AS   = 0;
     CI->Data = Orig->Data;
+    CI->Orig = Orig;
 
     /* Assign the chip instance to the chip */
+    pthread_mutex_lock (&InstanceLock);
     CollAppend (&CI->C->Instances, CI);
+    pthread_mutex_unlock (&InstanceLock);
 
     /* Return the new instance struct */
     return CI;
@@ -312,6 +340,61 @@ ChipInstance* MirrorChipInstance (const ChipInstance* Orig, unsigned Addr)
 
 
 
+void FreeChipInstance (ChipInstance* CI)
+/* Free a chip instance. The chip data is destroyed if the instance isn't a
+ * mirror, so mirrors must be freed before the instance they're mirroring.
+ */
+{
+    /* Remove the instance from the chip */
+    pthread_mutex_lock (&InstanceLock);
+    CollDeleteItem (&CI->C->Instances, CI);
+    pthread_mutex_unlock (&InstanceLock);
+
+    /* Destroy the chip data if we own it */
+    if (CI->Orig == 0) {
+        CI->C->Data->DestroyInstance (CI->Data);
+    }
+
+    /* Free the instance struct */
+    xfree (CI);
+}
+
+
+
+unsigned char* ChipGetReadPtr (const ChipInstance* CI)
+/* Return a pointer to the chip memory at CI->Addr if the chip allows direct
+ * read access. Return NULL otherwise.
+ */
+{
+    /* Get the chip data */
+    const ChipData* D = CI->C->Data;
+
+    /* Chips before version 1.1 don't have the function */
+    if (D->MinorVersion < 1 || D->GetReadPtr == 0) {
+        return 0;
+    }
+    return D->GetReadPtr (CI->Data);
+}
+
+
+
+unsigned char* ChipGetWritePtr (const ChipInstance* CI)
+/* Return a pointer to the chip memory at CI->Addr if the chip allows direct
+ * write access. Return NULL otherwise.
+ */
+{
+    /* Get the chip data */
+    const ChipData* D = CI->C->Data;
+
+    /* Chips before version 1.1 don't have the function */
+    if (D->MinorVersion < 1 || D->GetWritePtr == 0) {
+        return 0;
+    }
+    return D->GetWritePtr (CI->Data);
+}
+
+
+
 void SortChips (void)
 /* Sort all chips by name. Called after loading */
 {
@@ -67,6 +67,7 @@ struct ChipInstance {
     unsigned                Addr;       /* Start address of range */
     unsigned                Size;       /* Size of range */
     void*                   Data;       /* Chip instance data */
+    const ChipInstance*     Orig;       /* Mirrored instance or NULL */
 };
 
 /* Chip structure */
@@ -99,6 +100,21 @@ ChipInstance* NewChipInstance (const char* ChipName, unsigned Addr,
 ChipInstance* MirrorChipInstance (const ChipInstance* Orig, unsigned Addr);
 /* Generate a chip instance mirror and return it. */
 
+void FreeChipInstance (ChipInstance* CI);
+/* Free a chip instance. The chip data is destroyed if the instance isn't a
+ * mirror, so mirrors must be freed before the instance they're mirroring.
+ */
+
+unsigned char* ChipGetReadPtr (const ChipInstance* CI);
+/* Return a pointer to the chip memory at CI->Addr if the chip allows direct
+ * read access. Return NULL otherwise.
+ */
+
+unsigned char* ChipGetWritePtr (const ChipInstance* CI);
+/* Return a pointer to the chip memory at CI->Addr if the chip allows direct
+ * write access. Return NULL otherwise.
+ */
+
 void SortChips (void);
 /* Sort all chips by name. Called after loading */
 
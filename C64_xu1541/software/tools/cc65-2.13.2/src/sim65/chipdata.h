@@ -48,7 +48,7 @@
 #define CHIPDATA_TYPE_CHIP      0U
 #define CHIPDATA_TYPE_CPU       1U
 #define CHIPDATA_VER_MAJOR      1U
-#define CHIPDATA_VER_MINOR      0U
+#define CHIPDATA_VER_MINOR      1U
 
 /* Forwards */
 struct CfgData;
@@ -70,6 +70,17 @@ struct ChipData {
     void          (*Write) (void* Data, unsigned Offs, unsigned char Val);
     unsigned char (*ReadCtrl) (void* Data, unsigned Offs);
     unsigned char (*Read) (void* Data, unsigned Offs);
+
+    /* -- Exported functions, version 1.1 and above -- */
+    unsigned char* (*GetReadPtr) (void* Data);
+    /* Return a pointer to the chip memory if it may be read directly by the
+     * simulator without calling Read(), otherwise return NULL. May be NULL.
+     */
+    unsigned char* (*GetWritePtr) (void* Data);
+    /* Return a pointer to the chip memory if it may be written directly by
+     * the simulator without calling Write(), otherwise return NULL. May be
+     * NULL.
+     */
 };
 
 
@@ -68,6 +68,12 @@ static unsigned char ReadCtrl (void* Data, unsigned Offs);
 static unsigned char Read (void* Data, unsigned Offs);
 /* Read user data */
 
+static unsigned char* GetReadPtr (void* Data);
+/* Return a pointer to the memory for direct read access */
+
+static unsigned char* GetWritePtr (void* Data);
+/* Return a pointer to the memory for direct write access */
+
 
 
 /*****************************************************************************/
@@ -91,7 +97,9 @@ static const struct ChipData CData[1] = {
         WriteCtrl,
         Write,
         ReadCtrl,
-        Read
+        Read,
+        GetReadPtr,
+        GetWritePtr
     }
 };
 
@@ -262,5 +270,29 @@ static unsigned char Read (void* Data, unsigned Offs)
 }
 
 
+static unsigned char* GetReadPtr (void* Data)
+/* Return a pointer to the memory for direct read access */
+{
+    /* Cast the data pointer */
+    InstanceData* D = (InstanceData*) Data;
+
+    /* Direct access bypasses the attribute checks, the simulator will use it
+     * only if it doesn't run in debug mode.
+     */
+    return D->Mem;
+}
+
+
+
+static unsigned char* GetWritePtr (void* Data)
+/* Return a pointer to the memory for direct write access */
+{
+    /* Cast the data pointer */
+    InstanceData* D = (InstanceData*) Data;
+
+    /* See GetReadPtr */
+    return D->Mem;
+}
+
 
 
@@ -38,6 +38,9 @@
 #include <string.h>
 #include <errno.h>
 
+/* common */
+#include "attrib.h"
+
 /* sim65 */
 #include "chipif.h"
 
@@ -70,6 +73,12 @@ static unsigned char ReadCtrl (void* Data, unsigned Offs);
 static unsigned char Read (void* Data, unsigned Offs);
 /* Read user data */
 
+static unsigned char* GetReadPtr (void* Data);
+/* Return a pointer to the memory for direct read access */
+
+static unsigned char* GetWritePtr (void* Data);
+/* Return a pointer to the memory for direct write access */
+
 
 
 /*****************************************************************************/
@@ -93,7 +102,9 @@ static const struct ChipData CData[1] = {
         WriteCtrl,
         Write,
         ReadCtrl,
-        Read
+        Read,
+        GetReadPtr,
+        GetWritePtr
     }
 };
 
@@ -252,4 +263,24 @@ static unsigned char Read (void* Data, unsigned Offs)
 }
 
 
+static unsigned char* GetReadPtr (void* Data)
+/* Return a pointer to the memory for direct read access */
+{
+    /* Cast the data pointer */
+    InstanceData* D = (InstanceData*) Data;
+
+    /* Reads have no side effects, so the memory may be read directly */
+    return D->Mem;
+}
+
+
+
+static unsigned char* GetWritePtr (void* Data attribute ((unused)))
+/* Return a pointer to the memory for direct write access */
+{
+    /* Writes must go through Write() so they can be flagged */
+    return 0;
+}
+
+
 
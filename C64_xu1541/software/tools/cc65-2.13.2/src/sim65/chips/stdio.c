@@ -89,7 +89,9 @@ static const struct ChipData CData[1] = {
         Write,
         Write,
         Read,
-        Read
+        Read,
+        0,
+        0
     }
 };
 
@@ -155,7 +157,12 @@ static void Write (void* Data attribute ((unused)),
 		   unsigned char Val)
 /* Write user data */
 {
-    putchar (Val);
+    /* Let the simulator route the output if it is able to do so */
+    if (Sim->MinorVersion >= 2) {
+        Sim->PutChar (Val);
+    } else {
+        putchar (Val);
+    }
 }
 
 
@@ -140,7 +140,9 @@ static const struct ChipData CData[] = {
         VicWrite,
         VicWrite,
         VicRead,
-        VicRead
+        VicRead,
+        0,
+        0
     },
     {
         "VIC2-VIDEORAM",        /* Name of the chip */
@@ -155,7 +157,9 @@ static const struct ChipData CData[] = {
         VRamWrite,
         VRamWrite,
         VRamRead,
-        VRamRead
+        VRamRead,
+        0,
+        0
     },
     {
         "VIC2-COLORRAM",        /* Name of the chip */
@@ -170,7 +174,9 @@ static const struct ChipData CData[] = {
         CRamWrite,
         CRamWrite,
         CRamRead,
-        CRamRead
+        CRamRead,
+        0,
+        0
     }
 };
 
@@ -37,6 +37,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 
 /* common */
 #include "check.h"
@@ -57,6 +58,17 @@
 
 
 
+/*****************************************************************************/
+/*     	      	    		     Data		  		     */
+/*****************************************************************************/
+
+
+
+/* The config scanner isn't reentrant, so only one thread may read a config */
+static pthread_mutex_t CfgLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
 /*****************************************************************************/
 /*     	      	    		     Code		  		     */
 /*****************************************************************************/
@@ -149,7 +161,7 @@ static void ParseCPU (void)
 
 
 
-static void ParseMemory (void)
+static void ParseMemory (Sim65Context* Ctx)
 /* Parse a MEMORY section */
 {
     unsigned I;
@@ -264,7 +276,8 @@ static void ParseMemory (void)
         FreeCfgData (D);
 
         /* Assign the chip instance to memory */
-        MemAssignChip (CI, L->Start, Range);
+        CollAppend (&Ctx->Chips, CI);
+        MemAssignChip (Ctx, CI, L->Start, Range);
     }
 
     /* Create the mirrors */
@@ -295,7 +308,7 @@ static void ParseMemory (void)
         /* For simplicity, get the chip instance we're mirroring from the
          * memory, instead of searching for the range in the list.
          */
-        CI = MemGetChip (MirrorAddr);
+        CI = MemGetChip (Ctx, MirrorAddr);
         if (CI == 0) {
             /* We are mirroring an unassigned address */
             Error ("%s(%u): Mirroring an unassigned address",
@@ -317,13 +330,19 @@ static void ParseMemory (void)
         MCI = MirrorChipInstance (CI, L->Start - Offs);
 
         /* Assign the chip instance to memory */
-        MemAssignChip (MCI, L->Start, Range);
+        CollAppend (&Ctx->Chips, MCI);
+        MemAssignChip (Ctx, MCI, L->Start, Range);
+    }
+
+    /* The locations are no longer needed */
+    while (CollCount (&Locations) > 0) {
+        FreeLocation (CollPop (&Locations));
     }
 }
 
 
 
-static void ParseConfig (void)
+static void ParseConfig (Sim65Context* Ctx)
 /* Parse the config file */
 {
     static const IdentTok BlockNames [] = {
@@ -350,7 +369,7 @@ static void ParseConfig (void)
                 break;
 
             case CFGTOK_MEMORY:
-                ParseMemory ();
+                ParseMemory (Ctx);
                 break;
 
 	    default:
@@ -366,19 +385,28 @@ static void ParseConfig (void)
 
 
 
-void CfgRead (void)
-/* Read the configuration */
+void CfgRead (Sim65Context* Ctx, const char* Program)
+/* Read the configuration and create the chips for the given context. Program
+ * is the name of the program file, it replaces %P in the config.
+ */
 {
+    pthread_mutex_lock (&CfgLock);
+
+    /* Set the program name */
+    CfgSetProgram (Program);
+
     /* If we have a config name given, open the file, otherwise we will read
      * from a buffer.
      */
     CfgOpenInput ();
 
     /* Parse the file */
-    ParseConfig ();
+    ParseConfig (Ctx);
 
     /* Close the input file */
     CfgCloseInput ();
+
+    pthread_mutex_unlock (&CfgLock);
 }
 
 
@@ -38,14 +38,21 @@
 
 
 
+/* sim65 */
+#include "context.h"
+
+
+
 /*****************************************************************************/
 /*     	       	       	       	     Code     				     */
 /*****************************************************************************/
 
 
 
-void CfgRead (void);
-/* Read the configuration */
+void CfgRead (Sim65Context* Ctx, const char* Program);
+/* Read the configuration and create the chips for the given context. Program
+ * is the name of the program file, it replaces %P in the config.
+ */
 
 
 
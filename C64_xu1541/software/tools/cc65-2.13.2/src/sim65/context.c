@@ -0,0 +1,178 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 context.c                                 */
+/*                                                                           */
+/*                  Simulator context for the 6502 simulator                 */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <pthread.h>
+
+/* common */
+#include "coll.h"
+#include "xmalloc.h"
+
+/* sim65 */
+#include "chip.h"
+#include "cpucore.h"
+#include "memory.h"
+#include "profile.h"
+#include "context.h"
+
+
+
+/*****************************************************************************/
+/*                                     Data                                  */
+/*****************************************************************************/
+
+
+
+/* Thread specific pointer to the context the thread is running */
+static pthread_key_t    ContextKey;
+static pthread_once_t   ContextKeyOnce = PTHREAD_ONCE_INIT;
+
+
+
+/*****************************************************************************/
+/*                               Helper functions                            */
+/*****************************************************************************/
+
+
+
+static void CreateContextKey (void)
+/* Create the key for the thread specific context pointer */
+{
+    pthread_key_create (&ContextKey, 0);
+}
+
+
+
+/*****************************************************************************/
+/*                                     Code                                  */
+/*****************************************************************************/
+
+
+
+Sim65Context* NewContext (CPUEngineType Engine)
+/* Create a new context for a machine using the given execution engine. The
+ * memory is empty and must be populated by reading a config before the CPU
+ * can be reset.
+ */
+{
+    /* Allocate memory */
+    Sim65Context* Ctx = xmalloc (sizeof (Sim65Context));
+
+    /* Initialize the CPU fields */
+    Ctx->Regs.AC           = 0;
+    Ctx->Regs.XR           = 0;
+    Ctx->Regs.YR           = 0;
+    Ctx->Regs.ZR           = 0;
+    Ctx->Regs.SR           = 0;
+    Ctx->Regs.SP           = 0;
+    Ctx->Regs.PC           = 0;
+    Ctx->Cycles            = 0;
+    Ctx->TotalCycles       = 0;
+    Ctx->HaveNMIRequest    = 0;
+    Ctx->HaveIRQRequest    = 0;
+    Ctx->CPUHalted         = 0;
+    Ctx->CPUEvent          = 0;
+    Ctx->BreakMsg[0]       = '\0';
+    Ctx->Engine            = Engine;
+    Ctx->TraceFile         = 0;
+    Ctx->Output            = 0;
+    Ctx->Profile           = 0;
+
+    /* Initialize the memory fields */
+    Ctx->MemData           = 0;
+    Ctx->MemMap            = 0;
+    Ctx->Chips             = EmptyCollection;
+
+    /* Initialize the block engine fields */
+    Ctx->BlockMap          = 0;
+    Ctx->CodePages         = 0;
+    Ctx->FreeList          = 0;
+    Ctx->BlockAbort        = 0;
+    Ctx->BlocksDecoded     = 0;
+    Ctx->BlocksInvalidated = 0;
+
+    /* Allocate the memory */
+    MemInitContext (Ctx);
+
+    /* Return the new context */
+    return Ctx;
+}
+
+
+
+void FreeContext (Sim65Context* Ctx)
+/* Free a context including all chip instances of the machine */
+{
+    unsigned I;
+
+    /* Free the CPU data */
+    CPUDoneContext (Ctx);
+    FreeProfile (Ctx->Profile);
+
+    /* Free the chip instances. Mirrors are created after the instances they
+     * are mirroring, so walk the list backwards.
+     */
+    I = CollCount (&Ctx->Chips);
+    while (I--) {
+        FreeChipInstance (CollAt (&Ctx->Chips, I));
+    }
+    DoneCollection (&Ctx->Chips);
+
+    /* Free the memory */
+    MemDoneContext (Ctx);
+
+    /* Free the context itself */
+    xfree (Ctx);
+}
+
+
+
+void SetContext (Sim65Context* Ctx)
+/* Set the context the calling thread is running */
+{
+    pthread_once (&ContextKeyOnce, CreateContextKey);
+    pthread_setspecific (ContextKey, Ctx);
+}
+
+
+
+Sim65Context* GetContext (void)
+/* Return the context the calling thread is running. Used for callbacks from
+ * the chips, which don't know about contexts.
+ */
+{
+    pthread_once (&ContextKeyOnce, CreateContextKey);
+    return pthread_getspecific (ContextKey);
+}
+
+
+
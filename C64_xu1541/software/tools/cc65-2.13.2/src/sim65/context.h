@@ -0,0 +1,134 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 context.h                                 */
+/*                                                                           */
+/*                  Simulator context for the 6502 simulator                 */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+
+
+#include <stdio.h>
+
+/* common */
+#include "coll.h"
+
+/* sim65 */
+#include "cpuregs.h"
+
+
+
+/*****************************************************************************/
+/*                                     Data                                  */
+/*****************************************************************************/
+
+
+
+/* Forwards */
+struct ChipInstance;
+struct MemPage;
+struct CodeBlock;
+struct Profile;
+
+/* Execution engines */
+typedef enum CPUEngineType {
+    ENGINE_INTERP,              /* Interpret one instruction at a time */
+    ENGINE_BLOCK                /* Run cached blocks of decoded code */
+} CPUEngineType;
+
+/* The state of one simulated machine. All functions of the CPU core and the
+ * memory subsystem work on such a context, so several machines may be
+ * simulated at the same time, each one by its own thread.
+ */
+typedef struct Sim65Context Sim65Context;
+struct Sim65Context {
+
+    /* CPU */
+    CPURegs                     Regs;           /* Registers */
+    unsigned                    Cycles;         /* Cycles of the last insn */
+    unsigned long               TotalCycles;    /* Total cycles */
+    int                         HaveNMIRequest; /* NMI pending */
+    int                         HaveIRQRequest; /* IRQ pending */
+    int                         CPUHalted;      /* Halted by BRK */
+    int                         CPUEvent;       /* One of the above changed */
+    char                        BreakMsg[1024]; /* Break message */
+    CPUEngineType               Engine;         /* Execution engine */
+    FILE*                       TraceFile;      /* Instruction trace or NULL */
+    FILE*                       Output;         /* Output of the STDIO chip */
+    struct Profile*             Profile;        /* Profile data or NULL */
+
+    /* Memory */
+    const struct ChipInstance** MemData;        /* Chip by address */
+    struct MemPage*             MemMap;         /* Page granular memory map */
+    Collection                  Chips;          /* Chip instances created */
+
+    /* Block engine */
+    struct CodeBlock**          BlockMap;       /* Blocks by start address */
+    unsigned char*              CodePages;      /* Pages containing blocks */
+    struct CodeBlock*           FreeList;       /* Invalidated blocks */
+    int                         BlockAbort;     /* Executing block invalid */
+    unsigned long               BlocksDecoded;
+    unsigned long               BlocksInvalidated;
+};
+
+
+
+/*****************************************************************************/
+/*                                     Code                                  */
+/*****************************************************************************/
+
+
+
+Sim65Context* NewContext (CPUEngineType Engine);
+/* Create a new context for a machine using the given execution engine. The
+ * memory is empty and must be populated by reading a config before the CPU
+ * can be reset.
+ */
+
+void FreeContext (Sim65Context* Ctx);
+/* Free a context including all chip instances of the machine */
+
+void SetContext (Sim65Context* Ctx);
+/* Set the context the calling thread is running */
+
+Sim65Context* GetContext (void);
+/* Return the context the calling thread is running. Used for callbacks from
+ * the chips, which don't know about contexts.
+ */
+
+
+
+/* End of context.h */
+
+#endif
+
+
+
@@ -36,19 +36,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 /* common */
 #include "abend.h"
 #include "attrib.h"
 #include "print.h"
+#include "xmalloc.h"
 #include "xsprintf.h"
 
 /* sim65 */
 #include "cpuregs.h"
+#include "context.h"
 #include "cputype.h"
 #include "error.h"
 #include "global.h"
 #include "memory.h"
+#include "profile.h"
 #include "cpucore.h"
 
 
@@ -59,23 +63,81 @@
 
 
 
-/* Registers */
-CPURegs Regs;
-
-/* Count the total number of cylcles */
-unsigned	Cycles;		/* Cycles per insn */
-unsigned long	TotalCycles;	/* Total cycles */
-
 /* Allow the stack page to be changed */
 static unsigned StackPage = 0x100;
 
-/* CPU flags */
-int HaveNMIRequest = 0;
-int HaveIRQRequest = 0;
-int CPUHalted      = 0;
 
-/* Break message */
-static char BreakMsg[1024];
+
+/*****************************************************************************/
+/*                                 Forwards                                  */
+/*****************************************************************************/
+
+
+
+static void BlockInvalidate (Sim65Context* Ctx, unsigned Page);
+/* Invalidate all blocks overlapping the given page */
+
+
+
+/*****************************************************************************/
+/*                              Memory access                                */
+/*****************************************************************************/
+
+
+
+/* The functions below handle pages with direct memory access inline and
+ * call the memory subsystem (and so the chip) only for other pages.
+ */
+
+
+
+static unsigned char ReadByte (Sim65Context* Ctx, unsigned Addr)
+/* Read a byte from a memory location */
+{
+    const unsigned char* P = Ctx->MemMap[Addr >> MEM_PAGE_SHIFT].ReadPtr;
+    if (P) {
+        return P[Addr & MEM_PAGE_MASK];
+    } else {
+        return MemReadByte (Ctx, Addr);
+    }
+}
+
+
+
+static void WriteByte (Sim65Context* Ctx, unsigned Addr, unsigned char Val)
+/* Write a byte to a memory location */
+{
+    unsigned char* P = Ctx->MemMap[Addr >> MEM_PAGE_SHIFT].WritePtr;
+    if (P) {
+        P[Addr & MEM_PAGE_MASK] = Val;
+    } else {
+        MemWriteByte (Ctx, Addr, Val);
+        if (Ctx->CodePages && Ctx->CodePages[Addr >> MEM_PAGE_SHIFT]) {
+            BlockInvalidate (Ctx, Addr >> MEM_PAGE_SHIFT);
+        }
+    }
+}
+
+
+
+static unsigned ReadWord (Sim65Context* Ctx, unsigned Addr)
+/* Read a word from a memory location */
+{
+    unsigned W = ReadByte (Ctx, Addr++);
+    return (W | (ReadByte (Ctx, Addr) << 8));
+}
+
+
+
+static unsigned ReadZPWord (Sim65Context* Ctx, unsigned char Addr)
+/* Read a word from the zero page. This function differs from ReadWord in that
+ * the read will always be in the zero page, even in case of an address
+ * overflow.
+ */
+{
+    unsigned W = ReadByte (Ctx, Addr++);
+    return (W | (ReadByte (Ctx, Addr) << 8));
+}
 
 
 
@@ -86,24 +148,24 @@ static char BreakMsg[1024];
 
 
 /* Return the flags as a boolean value (0/1) */
-#define GET_CF()        ((Regs.SR & CF) != 0)
-#define GET_ZF()        ((Regs.SR & ZF) != 0)
-#define GET_IF()        ((Regs.SR & IF) != 0)
-#define GET_DF()        ((Regs.SR & DF) != 0)
-#define GET_BF()        ((Regs.SR & BF) != 0)
-#define GET_OF()        ((Regs.SR & OF) != 0)
-#define GET_SF()        ((Regs.SR & SF) != 0)
+#define GET_CF()        ((Ctx->Regs.SR & CF) != 0)
+#define GET_ZF()        ((Ctx->Regs.SR & ZF) != 0)
+#define GET_IF()        ((Ctx->Regs.SR & IF) != 0)
+#define GET_DF()        ((Ctx->Regs.SR & DF) != 0)
+#define GET_BF()        ((Ctx->Regs.SR & BF) != 0)
+#define GET_OF()        ((Ctx->Regs.SR & OF) != 0)
+#define GET_SF()        ((Ctx->Regs.SR & SF) != 0)
 
 /* Set the flags. The parameter is a boolean flag that says if the flag should be
  * set or reset.
  */
-#define SET_CF(f)       do { if (f) { Regs.SR |= CF; } else { Regs.SR &= ~CF; } } while (0)
-#define SET_ZF(f)       do { if (f) { Regs.SR |= ZF; } else { Regs.SR &= ~ZF; } } while (0)
-#define SET_IF(f)       do { if (f) { Regs.SR |= IF; } else { Regs.SR &= ~IF; } } while (0)
-#define SET_DF(f)       do { if (f) { Regs.SR |= DF; } else { Regs.SR &= ~DF; } } while (0)
-#define SET_BF(f)       do { if (f) { Regs.SR |= BF; } else { Regs.SR &= ~BF; } } while (0)
-#define SET_OF(f)       do { if (f) { Regs.SR |= OF; } else { Regs.SR &= ~OF; } } while (0)
-#define SET_SF(f)       do { if (f) { Regs.SR |= SF; } else { Regs.SR &= ~SF; } } while (0)
+#define SET_CF(f)       do { if (f) { Ctx->Regs.SR |= CF; } else { Ctx->Regs.SR &= ~CF; } } while (0)
+#define SET_ZF(f)       do { if (f) { Ctx->Regs.SR |= ZF; } else { Ctx->Regs.SR &= ~ZF; } } while (0)
+#define SET_IF(f)       do { if (f) { Ctx->Regs.SR |= IF; } else { Ctx->Regs.SR &= ~IF; } } while (0)
+#define SET_DF(f)       do { if (f) { Ctx->Regs.SR |= DF; } else { Ctx->Regs.SR &= ~DF; } } while (0)
+#define SET_BF(f)       do { if (f) { Ctx->Regs.SR |= BF; } else { Ctx->Regs.SR &= ~BF; } } while (0)
+#define SET_OF(f)       do { if (f) { Ctx->Regs.SR |= OF; } else { Ctx->Regs.SR &= ~OF; } } while (0)
+#define SET_SF(f)       do { if (f) { Ctx->Regs.SR |= SF; } else { Ctx->Regs.SR &= ~SF; } } while (0)
 
 /* Special test and set macros. The meaning of the parameter depends on the
  * actual flag that should be set or reset.
@@ -113,188 +175,188 @@ static char BreakMsg[1024];
 #define TEST_CF(v)      SET_CF (((v) & 0xFF00) != 0)
 
 /* Program counter halves */
-#define PCL	       	(Regs.PC & 0xFF)
-#define PCH		((Regs.PC >> 8) & 0xFF)
+#define PCL	       	(Ctx->Regs.PC & 0xFF)
+#define PCH		((Ctx->Regs.PC >> 8) & 0xFF)
 
 /* Stack operations */
-#define PUSH(Val)       MemWriteByte (StackPage + Regs.SP--, Val)
-#define POP()           MemReadByte (StackPage + ++Regs.SP)
+#define PUSH(Val)       WriteByte (Ctx, StackPage + Ctx->Regs.SP--, Val)
+#define POP()           ReadByte (Ctx, StackPage + ++Ctx->Regs.SP)
 
 /* Test for page cross */
 #define PAGE_CROSS(addr,offs)   ((((addr) & 0xFF) + offs) >= 0x100)
 
 /* #imm */
-#define AC_OP_IMM(op)                                   \
-    Cycles = 2;                                         \
-    Regs.AC = Regs.AC op MemReadByte (Regs.PC+1);       \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 2
+#define AC_OP_IMM(op)                                               \
+    Ctx->Cycles = 2;                                                \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, Ctx->Regs.PC+1);  \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 2
 
 /* zp */
-#define AC_OP_ZP(op)                                            \
-    Cycles = 3;                                                 \
-    Regs.AC = Regs.AC op MemReadByte (MemReadByte (Regs.PC+1)); \
-    TEST_ZF (Regs.AC);                                          \
-    TEST_SF (Regs.AC);                                          \
-    Regs.PC += 2
+#define AC_OP_ZP(op)                                                \
+    Ctx->Cycles = 3;                                                \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, ReadByte (Ctx, Ctx->Regs.PC+1)); \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 2
 
 /* zp,x */
-#define AC_OP_ZPX(op)                                   \
-    unsigned char ZPAddr;                               \
-    Cycles = 4;                                         \
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;         \
-    Regs.AC = Regs.AC op MemReadByte (ZPAddr);          \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 2
+#define AC_OP_ZPX(op)                                               \
+    unsigned char ZPAddr;                                           \
+    Ctx->Cycles = 4;                                                \
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;         \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, ZPAddr);          \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 2
 
 /* zp,y */
-#define AC_OP_ZPY(op)                                   \
-    unsigned char ZPAddr;                               \
-    Cycles = 4;                                         \
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.YR;         \
-    Regs.AC = Regs.AC op MemReadByte (ZPAddr);          \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 2
+#define AC_OP_ZPY(op)                                               \
+    unsigned char ZPAddr;                                           \
+    Ctx->Cycles = 4;                                                \
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.YR;         \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, ZPAddr);          \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 2
 
 /* abs */
-#define AC_OP_ABS(op)                                   \
-    unsigned Addr;                                      \
-    Cycles = 4;                                         \
-    Addr = MemReadWord (Regs.PC+1);                     \
-    Regs.AC = Regs.AC op MemReadByte (Addr);            \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 3
+#define AC_OP_ABS(op)                                               \
+    unsigned Addr;                                                  \
+    Ctx->Cycles = 4;                                                \
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);                          \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, Addr);            \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 3
 
 /* abs,x */
-#define AC_OP_ABSX(op)                                  \
-    unsigned Addr;                                      \
-    Cycles = 4;                                         \
-    Addr = MemReadWord (Regs.PC+1);                     \
-    if (PAGE_CROSS (Addr, Regs.XR)) {                   \
-        ++Cycles;                                       \
-    }                                                   \
-    Regs.AC = Regs.AC op MemReadByte (Addr + Regs.XR);  \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 3
+#define AC_OP_ABSX(op)                                              \
+    unsigned Addr;                                                  \
+    Ctx->Cycles = 4;                                                \
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);                          \
+    if (PAGE_CROSS (Addr, Ctx->Regs.XR)) {                          \
+        ++Ctx->Cycles;                                              \
+    }                                                               \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, Addr + Ctx->Regs.XR); \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 3
 
 /* abs,y */
-#define AC_OP_ABSY(op)                                  \
-    unsigned Addr;                                      \
-    Cycles = 4;                                         \
-    Addr = MemReadWord (Regs.PC+1);                     \
-    if (PAGE_CROSS (Addr, Regs.YR)) {                   \
-        ++Cycles;                                       \
-    }                                                   \
-    Regs.AC = Regs.AC op MemReadByte (Addr + Regs.YR);  \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 3
+#define AC_OP_ABSY(op)                                              \
+    unsigned Addr;                                                  \
+    Ctx->Cycles = 4;                                                \
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);                          \
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {                          \
+        ++Ctx->Cycles;                                              \
+    }                                                               \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, Addr + Ctx->Regs.YR); \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 3
 
 /* (zp,x) */
-#define AC_OP_ZPXIND(op)                                \
-    unsigned char ZPAddr;                               \
-    unsigned Addr;                                      \
-    Cycles = 6;                                         \
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;         \
-    Addr = MemReadZPWord (ZPAddr);                      \
-    Regs.AC = Regs.AC op MemReadByte (Addr);            \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 2
+#define AC_OP_ZPXIND(op)                                            \
+    unsigned char ZPAddr;                                           \
+    unsigned Addr;                                                  \
+    Ctx->Cycles = 6;                                                \
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;         \
+    Addr = ReadZPWord (Ctx, ZPAddr);                                \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, Addr);            \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 2
 
 /* (zp),y */
-#define AC_OP_ZPINDY(op)                                \
-    unsigned char ZPAddr;                               \
-    unsigned Addr;                                      \
-    Cycles = 5;                                         \
-    ZPAddr = MemReadByte (Regs.PC+1);                   \
-    Addr = MemReadZPWord (ZPAddr) + Regs.YR;            \
-    Regs.AC = Regs.AC op MemReadByte (Addr);            \
-    TEST_ZF (Regs.AC);                                  \
-    TEST_SF (Regs.AC);                                  \
-    Regs.PC += 2
+#define AC_OP_ZPINDY(op)                                            \
+    unsigned char ZPAddr;                                           \
+    unsigned Addr;                                                  \
+    Ctx->Cycles = 5;                                                \
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);                        \
+    Addr = ReadZPWord (Ctx, ZPAddr) + Ctx->Regs.YR;                 \
+    Ctx->Regs.AC = Ctx->Regs.AC op ReadByte (Ctx, Addr);            \
+    TEST_ZF (Ctx->Regs.AC);                                         \
+    TEST_SF (Ctx->Regs.AC);                                         \
+    Ctx->Regs.PC += 2
 
 /* ADC */
-#define ADC(v)                                          \
-    if (GET_DF ()) {                                    \
-        Warning ("Decimal mode not available");         \
-    } else {                                            \
-        unsigned old = Regs.AC;                         \
-        unsigned rhs = (v & 0xFF);                      \
-        Regs.AC += rhs + GET_CF ();                     \
-        TEST_ZF (Regs.AC);                              \
-        TEST_SF (Regs.AC);                              \
-        TEST_CF (Regs.AC);                              \
-        SET_OF (!((old ^ rhs) & 0x80) &&                \
-                ((old ^ Regs.AC) & 0x80));              \
-        Regs.AC &= 0xFF;                                \
+#define ADC(v)                                                      \
+    if (GET_DF ()) {                                                \
+        Warning ("Decimal mode not available");                     \
+    } else {                                                        \
+        unsigned old = Ctx->Regs.AC;                                \
+        unsigned rhs = (v & 0xFF);                                  \
+        Ctx->Regs.AC += rhs + GET_CF ();                            \
+        TEST_ZF (Ctx->Regs.AC);                                     \
+        TEST_SF (Ctx->Regs.AC);                                     \
+        TEST_CF (Ctx->Regs.AC);                                     \
+        SET_OF (!((old ^ rhs) & 0x80) &&                            \
+                ((old ^ Ctx->Regs.AC) & 0x80));                     \
+        Ctx->Regs.AC &= 0xFF;                                       \
     }
 
 /* branches */
-#define BRANCH(cond)                                    \
-    Cycles = 2;                                         \
-    if (cond) {                                         \
-        signed char Offs;                               \
-        unsigned char OldPCH;                           \
-        ++Cycles;                                       \
-        Offs = (signed char) MemReadByte (Regs.PC+1);   \
-        OldPCH = PCH;                                   \
-        Regs.PC += 2 + (int) Offs;                      \
-        if (PCH != OldPCH) {                            \
-            ++Cycles;                                   \
-        }                                               \
-    } else {                                            \
-        Regs.PC += 2;                                   \
+#define BRANCH(cond)                                                \
+    Ctx->Cycles = 2;                                                \
+    if (cond) {                                                     \
+        signed char Offs;                                           \
+        unsigned char OldPCH;                                       \
+        ++Ctx->Cycles;                                              \
+        Offs = (signed char) ReadByte (Ctx, Ctx->Regs.PC+1);        \
+        OldPCH = PCH;                                               \
+        Ctx->Regs.PC += 2 + (int) Offs;                             \
+        if (PCH != OldPCH) {                                        \
+            ++Ctx->Cycles;                                          \
+        }                                                           \
+    } else {                                                        \
+        Ctx->Regs.PC += 2;                                          \
     }
 
 /* compares */
-#define CMP(v1,v2)                                      \
-    {                                                   \
-        unsigned Result = v1 - v2;                      \
-        TEST_ZF (Result & 0xFF);                        \
-        TEST_SF (Result);                               \
-        SET_CF (Result <= 0xFF);                        \
+#define CMP(v1,v2)                                                  \
+    {                                                               \
+        unsigned Result = v1 - v2;                                  \
+        TEST_ZF (Result & 0xFF);                                    \
+        TEST_SF (Result);                                           \
+        SET_CF (Result <= 0xFF);                                    \
     }
 
 
 /* ROL */
-#define ROL(Val)                                        \
-    Val <<= 1;                                          \
-    if (GET_CF ()) {                                    \
-        Val |= 0x01;                                    \
-    }                                                   \
-    TEST_ZF (Val);                                      \
-    TEST_SF (Val);                                      \
+#define ROL(Val)                                                    \
+    Val <<= 1;                                                      \
+    if (GET_CF ()) {                                                \
+        Val |= 0x01;                                                \
+    }                                                               \
+    TEST_ZF (Val);                                                  \
+    TEST_SF (Val);                                                  \
     TEST_CF (Val)
 
 /* ROR */
-#define ROR(Val)                                        \
-    if (GET_CF ()) {                                    \
-        Val |= 0x100;                                   \
-    }                                                   \
-    SET_CF (Val & 0x01);                                \
-    Val >>= 1;                                          \
-    TEST_ZF (Val);                                      \
+#define ROR(Val)                                                    \
+    if (GET_CF ()) {                                                \
+        Val |= 0x100;                                               \
+    }                                                               \
+    SET_CF (Val & 0x01);                                            \
+    Val >>= 1;                                                      \
+    TEST_ZF (Val);                                                  \
     TEST_SF (Val)
 
 /* SBC */
-#define SBC(v)                                          \
-    if (GET_DF ()) {                                    \
-        Warning ("Decimal mode not available");         \
-    } else {                                            \
-        unsigned old = Regs.AC;                         \
-        unsigned rhs = (v & 0xFF);                      \
-        Regs.AC -= rhs - (!GET_CF ());                  \
-        TEST_ZF (Regs.AC);                              \
-        TEST_SF (Regs.AC);                              \
-        SET_CF (Regs.AC <= 0xFF);                       \
-        SET_OF (((old^rhs) & (old^Regs.AC) & 0x80));    \
-        Regs.AC &= 0xFF;                                \
+#define SBC(v)                                                      \
+    if (GET_DF ()) {                                                \
+        Warning ("Decimal mode not available");                     \
+    } else {                                                        \
+        unsigned old = Ctx->Regs.AC;                                \
+        unsigned rhs = (v & 0xFF);                                  \
+        Ctx->Regs.AC -= rhs - (!GET_CF ());                         \
+        TEST_ZF (Ctx->Regs.AC);                                     \
+        TEST_SF (Ctx->Regs.AC);                                     \
+        SET_CF (Ctx->Regs.AC <= 0xFF);                              \
+        SET_OF (((old^rhs) & (old^Ctx->Regs.AC) & 0x80));           \
+        Ctx->Regs.AC &= 0xFF;                                       \
     }
 
 
@@ -305,9 +367,18 @@ static char BreakMsg[1024];
 
 
 
-static void OPC_Illegal (void)
+static void TraceInsn (Sim65Context* Ctx)
+/* Write the CPU state after an instruction to the trace file */
+{
+    fprintf (Ctx->TraceFile, "%10lu %04X A=%02X X=%02X Y=%02X SP=%02X SR=%02X\n",
+             Ctx->TotalCycles, Ctx->Regs.PC, Ctx->Regs.AC, Ctx->Regs.XR, Ctx->Regs.YR, Ctx->Regs.SP, Ctx->Regs.SR);
+}
+
+
+
+static void OPC_Illegal (Sim65Context* Ctx)
 {
-    Warning ("Illegal opcode $%02X at address $%04X\n", MemReadByte (Regs.PC), Regs.PC);
+    Warning ("Illegal opcode $%02X at address $%04X\n", ReadByte (Ctx, Ctx->Regs.PC), Ctx->Regs.PC);
 }
 
 
@@ -318,23 +389,24 @@ static void OPC_Illegal (void)
 
 
 
-static void OPC_6502_00 (void)
+static void OPC_6502_00 (Sim65Context* Ctx)
 /* Opcode $00: BRK */
 {
-    Cycles = 7;
-    Regs.PC += 2;
+    Ctx->Cycles = 7;
+    Ctx->Regs.PC += 2;
     SET_BF (1);
     PUSH (PCH);
     PUSH (PCL);
-    PUSH (Regs.SR);
+    PUSH (Ctx->Regs.SR);
     SET_IF (1);
-    Regs.PC = MemReadWord (0xFFFE);
-    CPUHalted = 1;
+    Ctx->Regs.PC = ReadWord (Ctx, 0xFFFE);
+    Ctx->CPUHalted = 1;
+    Ctx->CPUEvent  = 1;
 }
 
 
 
-static void OPC_6502_01 (void)
+static void OPC_6502_01 (Sim65Context* Ctx)
 /* Opcode $01: ORA (ind,x) */
 {
     AC_OP_ZPXIND (|);
@@ -342,7 +414,7 @@ static void OPC_6502_01 (void)
 
 
 
-static void OPC_6502_05 (void)
+static void OPC_6502_05 (Sim65Context* Ctx)
 /* Opcode $05: ORA zp */
 {
     AC_OP_ZP (|);
@@ -350,34 +422,34 @@ static void OPC_6502_05 (void)
 
 
 
-static void OPC_6502_06 (void)
+static void OPC_6502_06 (Sim65Context* Ctx)
 /* Opcode $06: ASL zp */
 {
     unsigned char ZPAddr;
     unsigned Val;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr) << 1;
-    MemWriteByte (ZPAddr, (unsigned char) Val);
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr) << 1;
+    WriteByte (Ctx, ZPAddr, (unsigned char) Val);
     TEST_ZF (Val & 0xFF);
     TEST_SF (Val);
     SET_CF (Val & 0x100);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_08 (void)
+static void OPC_6502_08 (Sim65Context* Ctx)
 /* Opcode $08: PHP */
 {
-    Cycles = 3;
-    PUSH (Regs.SR & ~BF);
-    Regs.PC += 1;
+    Ctx->Cycles = 3;
+    PUSH (Ctx->Regs.SR & ~BF);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_09 (void)
+static void OPC_6502_09 (Sim65Context* Ctx)
 /* Opcode $09: ORA #imm */
 {
     AC_OP_IMM (|);
@@ -385,21 +457,21 @@ static void OPC_6502_09 (void)
 
 
 
-static void OPC_6502_0A (void)
+static void OPC_6502_0A (Sim65Context* Ctx)
 /* Opcode $0A: ASL a */
 {
-    Cycles = 2;
-    Regs.AC <<= 1;
-    TEST_ZF (Regs.AC & 0xFF);
-    TEST_SF (Regs.AC);
-    SET_CF (Regs.AC & 0x100);
-    Regs.AC &= 0xFF;
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.AC <<= 1;
+    TEST_ZF (Ctx->Regs.AC & 0xFF);
+    TEST_SF (Ctx->Regs.AC);
+    SET_CF (Ctx->Regs.AC & 0x100);
+    Ctx->Regs.AC &= 0xFF;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_0D (void)
+static void OPC_6502_0D (Sim65Context* Ctx)
 /* Opcode $0D: ORA abs */
 {
     AC_OP_ABS (|);
@@ -407,24 +479,24 @@ static void OPC_6502_0D (void)
 
 
 
-static void OPC_6502_0E (void)
+static void OPC_6502_0E (Sim65Context* Ctx)
 /* Opcode $0E: ALS abs */
 {
     unsigned Addr;
     unsigned Val;
-    Cycles = 6;
-    Addr = MemReadWord (Regs.PC+1);
-    Val  = MemReadByte (Addr) << 1;
-    MemWriteByte (Addr, (unsigned char) Val);
+    Ctx->Cycles = 6;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr) << 1;
+    WriteByte (Ctx, Addr, (unsigned char) Val);
     TEST_ZF (Val & 0xFF);
     TEST_SF (Val);
     SET_CF (Val & 0x100);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_10 (void)
+static void OPC_6502_10 (Sim65Context* Ctx)
 /* Opcode $10: BPL */
 {
     BRANCH (!GET_SF ());
@@ -432,7 +504,7 @@ static void OPC_6502_10 (void)
 
 
 
-static void OPC_6502_11 (void)
+static void OPC_6502_11 (Sim65Context* Ctx)
 /* Opcode $11: ORA (zp),y */
 {
     AC_OP_ZPINDY (|);
@@ -440,7 +512,7 @@ static void OPC_6502_11 (void)
 
 
 
-static void OPC_6502_15 (void)
+static void OPC_6502_15 (Sim65Context* Ctx)
 /* Opcode $15: ORA zp,x */
 {
    AC_OP_ZPX (|);
@@ -448,34 +520,34 @@ static void OPC_6502_15 (void)
 
 
 
-static void OPC_6502_16 (void)
+static void OPC_6502_16 (Sim65Context* Ctx)
 /* Opcode $16: ASL zp,x */
 {
     unsigned char ZPAddr;
     unsigned Val;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val    = MemReadByte (ZPAddr) << 1;
-    MemWriteByte (ZPAddr, (unsigned char) Val);
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val    = ReadByte (Ctx, ZPAddr) << 1;
+    WriteByte (Ctx, ZPAddr, (unsigned char) Val);
     TEST_ZF (Val & 0xFF);
     TEST_SF (Val);
     SET_CF (Val & 0x100);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_18 (void)
+static void OPC_6502_18 (Sim65Context* Ctx)
 /* Opcode $18: CLC */
 {
-    Cycles = 2;
+    Ctx->Cycles = 2;
     SET_CF (0);
-    Regs.PC += 1;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_19 (void)
+static void OPC_6502_19 (Sim65Context* Ctx)
 /* Opcode $19: ORA abs,y */
 {
     AC_OP_ABSY (|);
@@ -483,7 +555,7 @@ static void OPC_6502_19 (void)
 
 
 
-static void OPC_6502_1D (void)
+static void OPC_6502_1D (Sim65Context* Ctx)
 /* Opcode $1D: ORA abs,x */
 {
     AC_OP_ABSX (|);
@@ -491,38 +563,38 @@ static void OPC_6502_1D (void)
 
 
 
-static void OPC_6502_1E (void)
+static void OPC_6502_1E (Sim65Context* Ctx)
 /* Opcode $1E: ASL abs,x */
 {
     unsigned Addr;
     unsigned Val;
-    Cycles = 7;
-    Addr = MemReadWord (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (Addr) << 1;
-    MemWriteByte (Addr, (unsigned char) Val);
+    Ctx->Cycles = 7;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, Addr) << 1;
+    WriteByte (Ctx, Addr, (unsigned char) Val);
     TEST_ZF (Val & 0xFF);
     TEST_SF (Val);
     SET_CF (Val & 0x100);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_20 (void)
+static void OPC_6502_20 (Sim65Context* Ctx)
 /* Opcode $20: JSR */
 {
     unsigned Addr;
-    Cycles = 6;
-    Addr   = MemReadWord (Regs.PC+1);
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.PC += 2;
     PUSH (PCH);
     PUSH (PCL);
-    Regs.PC = Addr;
+    Ctx->Regs.PC = Addr;
 }
 
 
 
-static void OPC_6502_21 (void)
+static void OPC_6502_21 (Sim65Context* Ctx)
 /* Opcode $21: AND (zp,x) */
 {
     AC_OP_ZPXIND (&);
@@ -530,23 +602,23 @@ static void OPC_6502_21 (void)
 
 
 
-static void OPC_6502_24 (void)
+static void OPC_6502_24 (Sim65Context* Ctx)
 /* Opcode $24: BIT zp */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr);
     SET_SF (Val & 0x80);
     SET_OF (Val & 0x40);
-    SET_ZF ((Val & Regs.AC) == 0);
-    Regs.PC += 2;
+    SET_ZF ((Val & Ctx->Regs.AC) == 0);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_25 (void)
+static void OPC_6502_25 (Sim65Context* Ctx)
 /* Opcode $25: AND zp */
 {
     AC_OP_ZP (&);
@@ -554,32 +626,32 @@ static void OPC_6502_25 (void)
 
 
 
-static void OPC_6502_26 (void)
+static void OPC_6502_26 (Sim65Context* Ctx)
 /* Opcode $26: ROL zp */
 {
     unsigned char ZPAddr;
     unsigned Val;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr);
     ROL (Val);
-    MemWriteByte (ZPAddr, Val);
-    Regs.PC += 2;
+    WriteByte (Ctx, ZPAddr, Val);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_28 (void)
+static void OPC_6502_28 (Sim65Context* Ctx)
 /* Opcode $28: PLP */
 {
-    Cycles = 4;
-    Regs.SR = (POP () & ~BF);
-    Regs.PC += 1;
+    Ctx->Cycles = 4;
+    Ctx->Regs.SR = (POP () & ~BF);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_29 (void)
+static void OPC_6502_29 (Sim65Context* Ctx)
 /* Opcode $29: AND #imm */
 {
     AC_OP_IMM (&);
@@ -587,34 +659,34 @@ static void OPC_6502_29 (void)
 
 
 
-static void OPC_6502_2A (void)
+static void OPC_6502_2A (Sim65Context* Ctx)
 /* Opcode $2A: ROL a */
 {
-    Cycles = 2;
-    ROL (Regs.AC);
-    Regs.AC &= 0xFF;
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    ROL (Ctx->Regs.AC);
+    Ctx->Regs.AC &= 0xFF;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_2C (void)
+static void OPC_6502_2C (Sim65Context* Ctx)
 /* Opcode $2C: BIT abs */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 4;
-    Addr = MemReadByte (Regs.PC+1);
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 4;
+    Addr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr);
     SET_SF (Val & 0x80);
     SET_OF (Val & 0x40);
-    SET_ZF ((Val & Regs.AC) == 0);
-    Regs.PC += 3;
+    SET_ZF ((Val & Ctx->Regs.AC) == 0);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_2D (void)
+static void OPC_6502_2D (Sim65Context* Ctx)
 /* Opcode $2D: AND abs */
 {
     AC_OP_ABS (&);
@@ -622,22 +694,22 @@ static void OPC_6502_2D (void)
 
 
 
-static void OPC_6502_2E (void)
+static void OPC_6502_2E (Sim65Context* Ctx)
 /* Opcode $2E: ROL abs */
 {
     unsigned Addr;
     unsigned Val;
-    Cycles = 6;
-    Addr = MemReadWord (Regs.PC+1);
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 6;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr);
     ROL (Val);
-    MemWriteByte (Addr, Val);
-    Regs.PC += 3;
+    WriteByte (Ctx, Addr, Val);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_30 (void)
+static void OPC_6502_30 (Sim65Context* Ctx)
 /* Opcode $30: BMI */
 {
     BRANCH (GET_SF ());
@@ -645,7 +717,7 @@ static void OPC_6502_30 (void)
 
 
 
-static void OPC_6502_31 (void)
+static void OPC_6502_31 (Sim65Context* Ctx)
 /* Opcode $31: AND (zp),y */
 {
     AC_OP_ZPINDY (&);
@@ -653,7 +725,7 @@ static void OPC_6502_31 (void)
 
 
 
-static void OPC_6502_35 (void)
+static void OPC_6502_35 (Sim65Context* Ctx)
 /* Opcode $35: AND zp,x */
 {
     AC_OP_ZPX (&);
@@ -661,32 +733,32 @@ static void OPC_6502_35 (void)
 
 
 
-static void OPC_6502_36 (void)
+static void OPC_6502_36 (Sim65Context* Ctx)
 /* Opcode $36: ROL zp,x */
 {
     unsigned char ZPAddr;
     unsigned Val;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val    = ReadByte (Ctx, ZPAddr);
     ROL (Val);
-    MemWriteByte (ZPAddr, Val);
-    Regs.PC += 2;
+    WriteByte (Ctx, ZPAddr, Val);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_38 (void)
+static void OPC_6502_38 (Sim65Context* Ctx)
 /* Opcode $38: SEC */
 {
-    Cycles = 2;
+    Ctx->Cycles = 2;
     SET_CF (1);
-    Regs.PC += 1;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_39 (void)
+static void OPC_6502_39 (Sim65Context* Ctx)
 /* Opcode $39: AND abs,y */
 {
     AC_OP_ABSY (&);
@@ -694,7 +766,7 @@ static void OPC_6502_39 (void)
 
 
 
-static void OPC_6502_3D (void)
+static void OPC_6502_3D (Sim65Context* Ctx)
 /* Opcode $3D: AND abs,x */
 {
     AC_OP_ABSX (&);
@@ -702,33 +774,33 @@ static void OPC_6502_3D (void)
 
 
 
-static void OPC_6502_3E (void)
+static void OPC_6502_3E (Sim65Context* Ctx)
 /* Opcode $3E: ROL abs,x */
 {
     unsigned Addr;
     unsigned Val;
-    Cycles = 7;
-    Addr = MemReadWord (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 7;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, Addr);
     ROL (Val);
-    MemWriteByte (Addr, Val);
-    Regs.PC += 2;
+    WriteByte (Ctx, Addr, Val);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_40 (void)
+static void OPC_6502_40 (Sim65Context* Ctx)
 /* Opcode $40: RTI */
 {
-    Cycles = 6;
-    Regs.SR = POP ();
-    Regs.PC = POP ();                /* PCL */
-    Regs.PC |= (POP () << 8);        /* PCH */
+    Ctx->Cycles = 6;
+    Ctx->Regs.SR = POP ();
+    Ctx->Regs.PC = POP ();                /* PCL */
+    Ctx->Regs.PC |= (POP () << 8);        /* PCH */
 }
 
 
 
-static void OPC_6502_41 (void)
+static void OPC_6502_41 (Sim65Context* Ctx)
 /* Opcode $41: EOR (zp,x) */
 {
     AC_OP_ZPXIND (^);
@@ -736,7 +808,7 @@ static void OPC_6502_41 (void)
 
 
 
-static void OPC_6502_45 (void)
+static void OPC_6502_45 (Sim65Context* Ctx)
 /* Opcode $45: EOR zp */
 {
     AC_OP_ZP (^);
@@ -744,35 +816,35 @@ static void OPC_6502_45 (void)
 
 
 
-static void OPC_6502_46 (void)
+static void OPC_6502_46 (Sim65Context* Ctx)
 /* Opcode $46: LSR zp */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr);
     SET_CF (Val & 0x01);
     Val >>= 1;
-    MemWriteByte (ZPAddr, Val);
+    WriteByte (Ctx, ZPAddr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_48 (void)
+static void OPC_6502_48 (Sim65Context* Ctx)
 /* Opcode $48: PHA */
 {
-    Cycles = 3;
-    PUSH (Regs.AC);
-    Regs.PC += 1;
+    Ctx->Cycles = 3;
+    PUSH (Ctx->Regs.AC);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_49 (void)
+static void OPC_6502_49 (Sim65Context* Ctx)
 /* Opcode $49: EOR #imm */
 {
     AC_OP_IMM (^);
@@ -780,29 +852,29 @@ static void OPC_6502_49 (void)
 
 
 
-static void OPC_6502_4A (void)
+static void OPC_6502_4A (Sim65Context* Ctx)
 /* Opcode $4A: LSR a */
 {
-    Cycles = 2;
-    SET_CF (Regs.AC & 0x01);
-    Regs.AC >>= 1;
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    SET_CF (Ctx->Regs.AC & 0x01);
+    Ctx->Regs.AC >>= 1;
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_4C (void)
+static void OPC_6502_4C (Sim65Context* Ctx)
 /* Opcode $4C: JMP abs */
 {
-    Cycles = 3;
-    Regs.PC = MemReadWord (Regs.PC+1);
+    Ctx->Cycles = 3;
+    Ctx->Regs.PC = ReadWord (Ctx, Ctx->Regs.PC+1);
 }
 
 
 
-static void OPC_6502_4D (void)
+static void OPC_6502_4D (Sim65Context* Ctx)
 /* Opcode $4D: EOR abs */
 {
     AC_OP_ABS (^);
@@ -810,25 +882,25 @@ static void OPC_6502_4D (void)
 
 
 
-static void OPC_6502_4E (void)
+static void OPC_6502_4E (Sim65Context* Ctx)
 /* Opcode $4E: LSR abs */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 6;
-    Addr = MemReadWord (Regs.PC+1);
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 6;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr);
     SET_CF (Val & 0x01);
     Val >>= 1;
-    MemWriteByte (Addr, Val);
+    WriteByte (Ctx, Addr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_50 (void)
+static void OPC_6502_50 (Sim65Context* Ctx)
 /* Opcode $50: BVC */
 {
     BRANCH (!GET_OF ());
@@ -836,7 +908,7 @@ static void OPC_6502_50 (void)
 
 
 
-static void OPC_6502_51 (void)
+static void OPC_6502_51 (Sim65Context* Ctx)
 /* Opcode $51: EOR (zp),y */
 {
     AC_OP_ZPINDY (^);
@@ -844,7 +916,7 @@ static void OPC_6502_51 (void)
 
 
 
-static void OPC_6502_55 (void)
+static void OPC_6502_55 (Sim65Context* Ctx)
 /* Opcode $55: EOR zp,x */
 {
     AC_OP_ZPX (^);
@@ -852,35 +924,35 @@ static void OPC_6502_55 (void)
 
 
 
-static void OPC_6502_56 (void)
+static void OPC_6502_56 (Sim65Context* Ctx)
 /* Opcode $56: LSR zp,x */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val    = ReadByte (Ctx, ZPAddr);
     SET_CF (Val & 0x01);
     Val >>= 1;
-    MemWriteByte (ZPAddr, Val);
+    WriteByte (Ctx, ZPAddr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_58 (void)
+static void OPC_6502_58 (Sim65Context* Ctx)
 /* Opcode $58: CLI */
 {
-    Cycles = 2;
+    Ctx->Cycles = 2;
     SET_IF (0);
-    Regs.PC += 1;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_59 (void)
+static void OPC_6502_59 (Sim65Context* Ctx)
 /* Opcode $59: EOR abs,y */
 {
     AC_OP_ABSY (^);
@@ -888,7 +960,7 @@ static void OPC_6502_59 (void)
 
 
 
-static void OPC_6502_5D (void)
+static void OPC_6502_5D (Sim65Context* Ctx)
 /* Opcode $5D: EOR abs,x */
 {
     AC_OP_ABSX (^);
@@ -896,155 +968,155 @@ static void OPC_6502_5D (void)
 
 
 
-static void OPC_6502_5E (void)
+static void OPC_6502_5E (Sim65Context* Ctx)
 /* Opcode $5E: LSR abs,x */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 7;
-    Addr = MemReadWord (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 7;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, Addr);
     SET_CF (Val & 0x01);
     Val >>= 1;
-    MemWriteByte (Addr, Val);
+    WriteByte (Ctx, Addr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_60 (void)
+static void OPC_6502_60 (Sim65Context* Ctx)
 /* Opcode $60: RTS */
 {
-    Cycles = 6;
-    Regs.PC = POP ();                /* PCL */
-    Regs.PC |= (POP () << 8);        /* PCH */
-    Regs.PC += 1;
+    Ctx->Cycles = 6;
+    Ctx->Regs.PC = POP ();                /* PCL */
+    Ctx->Regs.PC |= (POP () << 8);        /* PCH */
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_61 (void)
+static void OPC_6502_61 (Sim65Context* Ctx)
 /* Opcode $61: ADC (zp,x) */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Addr   = MemReadZPWord (ZPAddr);
-    ADC (MemReadByte (Addr));
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    ADC (ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_65 (void)
+static void OPC_6502_65 (Sim65Context* Ctx)
 /* Opcode $65: ADC zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    ADC (MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    ADC (ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_66 (void)
+static void OPC_6502_66 (Sim65Context* Ctx)
 /* Opcode $66: ROR zp */
 {
     unsigned char ZPAddr;
     unsigned Val;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr);
     ROR (Val);
-    MemWriteByte (ZPAddr, Val);
-    Regs.PC += 2;
+    WriteByte (Ctx, ZPAddr, Val);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_68 (void)
+static void OPC_6502_68 (Sim65Context* Ctx)
 /* Opcode $68: PLA */
 {
-    Cycles = 4;
-    Regs.AC = POP ();
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 1;
+    Ctx->Cycles = 4;
+    Ctx->Regs.AC = POP ();
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_69 (void)
+static void OPC_6502_69 (Sim65Context* Ctx)
 /* Opcode $69: ADC #imm */
 {
-    Cycles = 2;
-    ADC (MemReadByte (Regs.PC+1));
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    ADC (ReadByte (Ctx, Ctx->Regs.PC+1));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_6A (void)
+static void OPC_6502_6A (Sim65Context* Ctx)
 /* Opcode $6A: ROR a */
 {
-    Cycles = 2;
-    ROR (Regs.AC);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    ROR (Ctx->Regs.AC);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_6C (void)
+static void OPC_6502_6C (Sim65Context* Ctx)
 /* Opcode $6C: JMP (ind) */
 {
     unsigned Addr;
-    Cycles = 5;
-    Addr = MemReadWord (Regs.PC+1);
+    Ctx->Cycles = 5;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
     if (CPU == CPU_6502) {
         /* Emulate the 6502 bug */
-        Regs.PC = MemReadByte (Addr);
+        Ctx->Regs.PC = ReadByte (Ctx, Addr);
         Addr = (Addr & 0xFF00) | ((Addr + 1) & 0xFF);
-        Regs.PC |= (MemReadByte (Addr) << 8);
+        Ctx->Regs.PC |= (ReadByte (Ctx, Addr) << 8);
     } else {
         /* 65C02 and above have this bug fixed */
-        Regs.PC = MemReadWord (Addr);
+        Ctx->Regs.PC = ReadWord (Ctx, Addr);
     }
 }
 
 
 
-static void OPC_6502_6D (void)
+static void OPC_6502_6D (Sim65Context* Ctx)
 /* Opcode $6D: ADC abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    ADC (MemReadByte (Addr));
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    ADC (ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_6E (void)
+static void OPC_6502_6E (Sim65Context* Ctx)
 /* Opcode $6E: ROR abs */
 {
     unsigned Addr;
     unsigned Val;
-    Cycles = 6;
-    Addr = MemReadWord (Regs.PC+1);
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 6;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr);
     ROR (Val);
-    MemWriteByte (Addr, Val);
-    Regs.PC += 3;
+    WriteByte (Ctx, Addr, Val);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_70 (void)
+static void OPC_6502_70 (Sim65Context* Ctx)
 /* Opcode $70: BVS */
 {
     BRANCH (GET_OF ());
@@ -1052,216 +1124,216 @@ static void OPC_6502_70 (void)
 
 
 
-static void OPC_6502_71 (void)
+static void OPC_6502_71 (Sim65Context* Ctx)
 /* Opcode $71: ADC (zp),y */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Addr   = MemReadZPWord (ZPAddr);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    ADC (MemReadByte (Addr + Regs.YR));
-    Regs.PC += 2;
+    ADC (ReadByte (Ctx, Addr + Ctx->Regs.YR));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_75 (void)
+static void OPC_6502_75 (Sim65Context* Ctx)
 /* Opcode $75: ADC zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    ADC (MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    ADC (ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_76 (void)
+static void OPC_6502_76 (Sim65Context* Ctx)
 /* Opcode $76: ROR zp,x */
 {
     unsigned char ZPAddr;
     unsigned Val;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val    = MemReadByte (ZPAddr);
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val    = ReadByte (Ctx, ZPAddr);
     ROR (Val);
-    MemWriteByte (ZPAddr, Val);
-    Regs.PC += 2;
+    WriteByte (Ctx, ZPAddr, Val);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_78 (void)
+static void OPC_6502_78 (Sim65Context* Ctx)
 /* Opcode $78: SEI */
 {
-    Cycles = 2;
+    Ctx->Cycles = 2;
     SET_IF (1);
-    Regs.PC += 1;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_79 (void)
+static void OPC_6502_79 (Sim65Context* Ctx)
 /* Opcode $79: ADC abs,y */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    ADC (MemReadByte (Addr + Regs.YR));
-    Regs.PC += 3;
+    ADC (ReadByte (Ctx, Addr + Ctx->Regs.YR));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_7D (void)
+static void OPC_6502_7D (Sim65Context* Ctx)
 /* Opcode $7D: ADC abs,x */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.XR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.XR)) {
+        ++Ctx->Cycles;
     }
-    ADC (MemReadByte (Addr + Regs.XR));
-    Regs.PC += 3;
+    ADC (ReadByte (Ctx, Addr + Ctx->Regs.XR));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_7E (void)
+static void OPC_6502_7E (Sim65Context* Ctx)
 /* Opcode $7E: ROR abs,x */
 {
     unsigned Addr;
     unsigned Val;
-    Cycles = 7;
-    Addr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (Addr);
+    Ctx->Cycles = 7;
+    Addr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, Addr);
     ROR (Val);
-    MemWriteByte (Addr, Val);
-    Regs.PC += 3;
+    WriteByte (Ctx, Addr, Val);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_81 (void)
+static void OPC_6502_81 (Sim65Context* Ctx)
 /* Opcode $81: STA (zp,x) */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Addr   = MemReadZPWord (ZPAddr);
-    MemWriteByte (Addr, Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    WriteByte (Ctx, Addr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_84 (void)
+static void OPC_6502_84 (Sim65Context* Ctx)
 /* Opcode $84: STY zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    MemWriteByte (ZPAddr, Regs.YR);
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    WriteByte (Ctx, ZPAddr, Ctx->Regs.YR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_85 (void)
+static void OPC_6502_85 (Sim65Context* Ctx)
 /* Opcode $85: STA zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    MemWriteByte (ZPAddr, Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    WriteByte (Ctx, ZPAddr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_86 (void)
+static void OPC_6502_86 (Sim65Context* Ctx)
 /* Opcode $86: STX zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    MemWriteByte (ZPAddr, Regs.XR);
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    WriteByte (Ctx, ZPAddr, Ctx->Regs.XR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_88 (void)
+static void OPC_6502_88 (Sim65Context* Ctx)
 /* Opcode $88: DEY */
 {
-    Cycles = 2;
-    Regs.YR = (Regs.YR - 1) & 0xFF;
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.YR = (Ctx->Regs.YR - 1) & 0xFF;
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_8A (void)
+static void OPC_6502_8A (Sim65Context* Ctx)
 /* Opcode $8A: TXA */
 {
-    Cycles = 2;
-    Regs.AC = Regs.XR;
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.AC = Ctx->Regs.XR;
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_8C (void)
+static void OPC_6502_8C (Sim65Context* Ctx)
 /* Opcode $8C: STY abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    MemWriteByte (Addr, Regs.YR);
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    WriteByte (Ctx, Addr, Ctx->Regs.YR);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_8D (void)
+static void OPC_6502_8D (Sim65Context* Ctx)
 /* Opcode $8D: STA abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    MemWriteByte (Addr, Regs.AC);
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    WriteByte (Ctx, Addr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_8E (void)
+static void OPC_6502_8E (Sim65Context* Ctx)
 /* Opcode $8E: STX abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    MemWriteByte (Addr, Regs.XR);
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    WriteByte (Ctx, Addr, Ctx->Regs.XR);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_90 (void)
+static void OPC_6502_90 (Sim65Context* Ctx)
 /* Opcode $90: BCC */
 {
     BRANCH (!GET_CF ());
@@ -1269,263 +1341,263 @@ static void OPC_6502_90 (void)
 
 
 
-static void OPC_6502_91 (void)
+static void OPC_6502_91 (Sim65Context* Ctx)
 /* Opcode $91: sta (zp),y */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Addr   = MemReadZPWord (ZPAddr) + Regs.YR;
-    MemWriteByte (Addr, Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Addr   = ReadZPWord (Ctx, ZPAddr) + Ctx->Regs.YR;
+    WriteByte (Ctx, Addr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_94 (void)
+static void OPC_6502_94 (Sim65Context* Ctx)
 /* Opcode $94: STY zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    MemWriteByte (ZPAddr, Regs.YR);
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    WriteByte (Ctx, ZPAddr, Ctx->Regs.YR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_95 (void)
+static void OPC_6502_95 (Sim65Context* Ctx)
 /* Opcode $95: STA zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    MemWriteByte (ZPAddr, Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    WriteByte (Ctx, ZPAddr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_96 (void)
+static void OPC_6502_96 (Sim65Context* Ctx)
 /* Opcode $96: stx zp,y */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.YR;
-    MemWriteByte (ZPAddr, Regs.XR);
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.YR;
+    WriteByte (Ctx, ZPAddr, Ctx->Regs.XR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_98 (void)
+static void OPC_6502_98 (Sim65Context* Ctx)
 /* Opcode $98: TYA */
 {
-    Cycles = 2;
-    Regs.AC = Regs.YR;
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.AC = Ctx->Regs.YR;
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_99 (void)
+static void OPC_6502_99 (Sim65Context* Ctx)
 /* Opcode $99: STA abs,y */
 {
     unsigned Addr;
-    Cycles = 5;
-    Addr   = MemReadWord (Regs.PC+1) + Regs.YR;
-    MemWriteByte (Addr, Regs.AC);
-    Regs.PC += 3;
+    Ctx->Cycles = 5;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.YR;
+    WriteByte (Ctx, Addr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_9A (void)
+static void OPC_6502_9A (Sim65Context* Ctx)
 /* Opcode $9A: TXS */
 {
-    Cycles = 2;
-    Regs.SP = Regs.XR;
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.SP = Ctx->Regs.XR;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_9D (void)
+static void OPC_6502_9D (Sim65Context* Ctx)
 /* Opcode $9D: STA abs,x */
 {
     unsigned Addr;
-    Cycles = 5;
-    Addr   = MemReadWord (Regs.PC+1) + Regs.XR;
-    MemWriteByte (Addr, Regs.AC);
-    Regs.PC += 3;
+    Ctx->Cycles = 5;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    WriteByte (Ctx, Addr, Ctx->Regs.AC);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_A0 (void)
+static void OPC_6502_A0 (Sim65Context* Ctx)
 /* Opcode $A0: LDY #imm */
 {
-    Cycles = 2;
-    Regs.YR = MemReadByte (Regs.PC+1);
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    Ctx->Regs.YR = ReadByte (Ctx, Ctx->Regs.PC+1);
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_A1 (void)
+static void OPC_6502_A1 (Sim65Context* Ctx)
 /* Opcode $A1: LDA (zp,x) */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Addr = MemReadZPWord (ZPAddr);
-    Regs.AC = MemReadByte (Addr);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Addr = ReadZPWord (Ctx, ZPAddr);
+    Ctx->Regs.AC = ReadByte (Ctx, Addr);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_A2 (void)
+static void OPC_6502_A2 (Sim65Context* Ctx)
 /* Opcode $A2: LDX #imm */
 {
-    Cycles = 2;
-    Regs.XR = MemReadByte (Regs.PC+1);
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    Ctx->Regs.XR = ReadByte (Ctx, Ctx->Regs.PC+1);
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_A4 (void)
+static void OPC_6502_A4 (Sim65Context* Ctx)
 /* Opcode $A4: LDY zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Regs.YR = MemReadByte (ZPAddr);
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.YR = ReadByte (Ctx, ZPAddr);
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_A5 (void)
+static void OPC_6502_A5 (Sim65Context* Ctx)
 /* Opcode $A5: LDA zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Regs.AC = MemReadByte (ZPAddr);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.AC = ReadByte (Ctx, ZPAddr);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_A6 (void)
+static void OPC_6502_A6 (Sim65Context* Ctx)
 /* Opcode $A6: LDX zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Regs.XR = MemReadByte (ZPAddr);
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.XR = ReadByte (Ctx, ZPAddr);
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_A8 (void)
+static void OPC_6502_A8 (Sim65Context* Ctx)
 /* Opcode $A8: TAY */
 {
-    Cycles = 2;
-    Regs.YR = Regs.AC;
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.YR = Ctx->Regs.AC;
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_A9 (void)
+static void OPC_6502_A9 (Sim65Context* Ctx)
 /* Opcode $A9: LDA #imm */
 {
-    Cycles = 2;
-    Regs.AC = MemReadByte (Regs.PC+1);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    Ctx->Regs.AC = ReadByte (Ctx, Ctx->Regs.PC+1);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_AA (void)
+static void OPC_6502_AA (Sim65Context* Ctx)
 /* Opcode $AA: TAX */
 {
-    Cycles = 2;
-    Regs.XR = Regs.AC;
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.XR = Ctx->Regs.AC;
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_AC (void)
+static void OPC_6502_AC (Sim65Context* Ctx)
 /* Opcode $Regs.AC: LDY abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    Regs.YR     = MemReadByte (Addr);
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.YR     = ReadByte (Ctx, Addr);
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_AD (void)
+static void OPC_6502_AD (Sim65Context* Ctx)
 /* Opcode $AD: LDA abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    Regs.AC     = MemReadByte (Addr);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.AC     = ReadByte (Ctx, Addr);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_AE (void)
+static void OPC_6502_AE (Sim65Context* Ctx)
 /* Opcode $AE: LDX abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    Regs.XR     = MemReadByte (Addr);
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Ctx->Regs.XR     = ReadByte (Ctx, Addr);
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_B0 (void)
+static void OPC_6502_B0 (Sim65Context* Ctx)
 /* Opcode $B0: BCS */
 {
     BRANCH (GET_CF ());
@@ -1533,296 +1605,296 @@ static void OPC_6502_B0 (void)
 
 
 
-static void OPC_6502_B1 (void)
+static void OPC_6502_B1 (Sim65Context* Ctx)
 /* Opcode $B1: LDA (zp),y */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Addr   = MemReadZPWord (ZPAddr);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    Regs.AC = MemReadByte (Addr + Regs.YR);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 2;
+    Ctx->Regs.AC = ReadByte (Ctx, Addr + Ctx->Regs.YR);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_B4 (void)
+static void OPC_6502_B4 (Sim65Context* Ctx)
 /* Opcode $B4: LDY zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Regs.YR     = MemReadByte (ZPAddr);
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Ctx->Regs.YR     = ReadByte (Ctx, ZPAddr);
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_B5 (void)
+static void OPC_6502_B5 (Sim65Context* Ctx)
 /* Opcode $B5: LDA zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Regs.AC     = MemReadByte (ZPAddr);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Ctx->Regs.AC     = ReadByte (Ctx, ZPAddr);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_B6 (void)
+static void OPC_6502_B6 (Sim65Context* Ctx)
 /* Opcode $B6: LDX zp,y */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.YR;
-    Regs.XR     = MemReadByte (ZPAddr);
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.YR;
+    Ctx->Regs.XR     = ReadByte (Ctx, ZPAddr);
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_B8 (void)
+static void OPC_6502_B8 (Sim65Context* Ctx)
 /* Opcode $B8: CLV */
 {
-    Cycles = 2;
+    Ctx->Cycles = 2;
     SET_OF (0);
-    Regs.PC += 1;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_B9 (void)
+static void OPC_6502_B9 (Sim65Context* Ctx)
 /* Opcode $B9: LDA abs,y */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    Regs.AC = MemReadByte (Addr + Regs.YR);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 3;
+    Ctx->Regs.AC = ReadByte (Ctx, Addr + Ctx->Regs.YR);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_BA (void)
+static void OPC_6502_BA (Sim65Context* Ctx)
 /* Opcode $BA: TSX */
 {
-    Cycles = 2;
-    Regs.XR = Regs.SP;
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.XR = Ctx->Regs.SP;
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_BC (void)
+static void OPC_6502_BC (Sim65Context* Ctx)
 /* Opcode $BC: LDY abs,x */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.XR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.XR)) {
+        ++Ctx->Cycles;
     }
-    Regs.YR = MemReadByte (Addr + Regs.XR);
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 3;
+    Ctx->Regs.YR = ReadByte (Ctx, Addr + Ctx->Regs.XR);
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_BD (void)
+static void OPC_6502_BD (Sim65Context* Ctx)
 /* Opcode $BD: LDA abs,x */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.XR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.XR)) {
+        ++Ctx->Cycles;
     }
-    Regs.AC = MemReadByte (Addr + Regs.XR);
-    TEST_ZF (Regs.AC);
-    TEST_SF (Regs.AC);
-    Regs.PC += 3;
+    Ctx->Regs.AC = ReadByte (Ctx, Addr + Ctx->Regs.XR);
+    TEST_ZF (Ctx->Regs.AC);
+    TEST_SF (Ctx->Regs.AC);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_BE (void)
+static void OPC_6502_BE (Sim65Context* Ctx)
 /* Opcode $BE: LDX abs,y */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    Regs.XR = MemReadByte (Addr + Regs.YR);
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 3;
+    Ctx->Regs.XR = ReadByte (Ctx, Addr + Ctx->Regs.YR);
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_C0 (void)
+static void OPC_6502_C0 (Sim65Context* Ctx)
 /* Opcode $C0: CPY #imm */
 {
-    Cycles = 2;
-    CMP (Regs.YR, MemReadByte (Regs.PC+1));
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    CMP (Ctx->Regs.YR, ReadByte (Ctx, Ctx->Regs.PC+1));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_C1 (void)
+static void OPC_6502_C1 (Sim65Context* Ctx)
 /* Opcode $C1: CMP (zp,x) */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Addr   = MemReadZPWord (ZPAddr);
-    CMP (Regs.AC, MemReadByte (Addr));
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_C4 (void)
+static void OPC_6502_C4 (Sim65Context* Ctx)
 /* Opcode $C4: CPY zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    CMP (Regs.YR, MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    CMP (Ctx->Regs.YR, ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_C5 (void)
+static void OPC_6502_C5 (Sim65Context* Ctx)
 /* Opcode $C5: CMP zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    CMP (Regs.AC, MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_C6 (void)
+static void OPC_6502_C6 (Sim65Context* Ctx)
 /* Opcode $C6: DEC zp */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr) - 1;
-    MemWriteByte (ZPAddr, Val);
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr) - 1;
+    WriteByte (Ctx, ZPAddr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_C8 (void)
+static void OPC_6502_C8 (Sim65Context* Ctx)
 /* Opcode $C8: INY */
 {
-    Cycles = 2;
-    Regs.YR = (Regs.YR + 1) & 0xFF;
-    TEST_ZF (Regs.YR);
-    TEST_SF (Regs.YR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.YR = (Ctx->Regs.YR + 1) & 0xFF;
+    TEST_ZF (Ctx->Regs.YR);
+    TEST_SF (Ctx->Regs.YR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_C9 (void)
+static void OPC_6502_C9 (Sim65Context* Ctx)
 /* Opcode $C9: CMP #imm */
 {
-    Cycles = 2;
-    CMP (Regs.AC, MemReadByte (Regs.PC+1));
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, Ctx->Regs.PC+1));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_CA (void)
+static void OPC_6502_CA (Sim65Context* Ctx)
 /* Opcode $CA: DEX */
 {
-    Cycles = 2;
-    Regs.XR = (Regs.XR - 1) & 0xFF;
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.XR = (Ctx->Regs.XR - 1) & 0xFF;
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_CC (void)
+static void OPC_6502_CC (Sim65Context* Ctx)
 /* Opcode $CC: CPY abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    CMP (Regs.YR, MemReadByte (Addr));
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    CMP (Ctx->Regs.YR, ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_CD (void)
+static void OPC_6502_CD (Sim65Context* Ctx)
 /* Opcode $CD: CMP abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    CMP (Regs.AC, MemReadByte (Addr));
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_CE (void)
+static void OPC_6502_CE (Sim65Context* Ctx)
 /* Opcode $CE: DEC abs */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 6;
-    Addr = MemReadWord (Regs.PC+1);
-    Val  = MemReadByte (Addr) - 1;
-    MemWriteByte (Addr, Val);
+    Ctx->Cycles = 6;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr) - 1;
+    WriteByte (Ctx, Addr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_D0 (void)
+static void OPC_6502_D0 (Sim65Context* Ctx)
 /* Opcode $D0: BNE */
 {
     BRANCH (!GET_ZF ());
@@ -1830,244 +1902,244 @@ static void OPC_6502_D0 (void)
 
 
 
-static void OPC_6502_D1 (void)
+static void OPC_6502_D1 (Sim65Context* Ctx)
 /* Opcode $D1: CMP (zp),y */
 {
     unsigned ZPAddr;
     unsigned Addr;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Addr   = MemReadWord (ZPAddr);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Addr   = ReadWord (Ctx, ZPAddr);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    CMP (Regs.AC, MemReadByte (Addr + Regs.YR));
-    Regs.PC += 2;
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, Addr + Ctx->Regs.YR));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_D5 (void)
+static void OPC_6502_D5 (Sim65Context* Ctx)
 /* Opcode $D5: CMP zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    CMP (Regs.AC, MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_D6 (void)
+static void OPC_6502_D6 (Sim65Context* Ctx)
 /* Opcode $D6: DEC zp,x */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (ZPAddr) - 1;
-    MemWriteByte (ZPAddr, Val);
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, ZPAddr) - 1;
+    WriteByte (Ctx, ZPAddr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_D8 (void)
+static void OPC_6502_D8 (Sim65Context* Ctx)
 /* Opcode $D8: CLD */
 {
-    Cycles = 2;
+    Ctx->Cycles = 2;
     SET_DF (0);
-    Regs.PC += 1;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_D9 (void)
+static void OPC_6502_D9 (Sim65Context* Ctx)
 /* Opcode $D9: CMP abs,y */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    CMP (Regs.AC, MemReadByte (Addr + Regs.YR));
-    Regs.PC += 3;
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, Addr + Ctx->Regs.YR));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_DD (void)
+static void OPC_6502_DD (Sim65Context* Ctx)
 /* Opcode $DD: CMP abs,x */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.XR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.XR)) {
+        ++Ctx->Cycles;
     }
-    CMP (Regs.AC, MemReadByte (Addr + Regs.XR));
-    Regs.PC += 3;
+    CMP (Ctx->Regs.AC, ReadByte (Ctx, Addr + Ctx->Regs.XR));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_DE (void)
+static void OPC_6502_DE (Sim65Context* Ctx)
 /* Opcode $DE: DEC abs,x */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 7;
-    Addr = MemReadWord (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (Addr) - 1;
-    MemWriteByte (Addr, Val);
+    Ctx->Cycles = 7;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, Addr) - 1;
+    WriteByte (Ctx, Addr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_E0 (void)
+static void OPC_6502_E0 (Sim65Context* Ctx)
 /* Opcode $E0: CPX #imm */
 {
-    Cycles = 2;
-    CMP (Regs.XR, MemReadByte (Regs.PC+1));
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    CMP (Ctx->Regs.XR, ReadByte (Ctx, Ctx->Regs.PC+1));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_E1 (void)
+static void OPC_6502_E1 (Sim65Context* Ctx)
 /* Opcode $E1: SBC (zp,x) */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Addr   = MemReadZPWord (ZPAddr);
-    SBC (MemReadByte (Addr));
-    Regs.PC += 2;
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    SBC (ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_E4 (void)
+static void OPC_6502_E4 (Sim65Context* Ctx)
 /* Opcode $E4: CPX zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    CMP (Regs.XR, MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    CMP (Ctx->Regs.XR, ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_E5 (void)
+static void OPC_6502_E5 (Sim65Context* Ctx)
 /* Opcode $E5: SBC zp */
 {
     unsigned char ZPAddr;
-    Cycles = 3;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    SBC (MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 3;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    SBC (ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_E6 (void)
+static void OPC_6502_E6 (Sim65Context* Ctx)
 /* Opcode $E6: INC zp */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Val    = MemReadByte (ZPAddr) + 1;
-    MemWriteByte (ZPAddr, Val);
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Val    = ReadByte (Ctx, ZPAddr) + 1;
+    WriteByte (Ctx, ZPAddr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_E8 (void)
+static void OPC_6502_E8 (Sim65Context* Ctx)
 /* Opcode $E8: INX */
 {
-    Cycles = 2;
-    Regs.XR = (Regs.XR + 1) & 0xFF;
-    TEST_ZF (Regs.XR);
-    TEST_SF (Regs.XR);
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.XR = (Ctx->Regs.XR + 1) & 0xFF;
+    TEST_ZF (Ctx->Regs.XR);
+    TEST_SF (Ctx->Regs.XR);
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_E9 (void)
+static void OPC_6502_E9 (Sim65Context* Ctx)
 /* Opcode $E9: SBC #imm */
 {
-    Cycles = 2;
-    SBC (MemReadByte (Regs.PC+1));
-    Regs.PC += 2;
+    Ctx->Cycles = 2;
+    SBC (ReadByte (Ctx, Ctx->Regs.PC+1));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_EA (void)
+static void OPC_6502_EA (Sim65Context* Ctx)
 /* Opcode $EA: NOP */
 {
     /* This one is easy... */
-    Cycles = 2;
-    Regs.PC += 1;
+    Ctx->Cycles = 2;
+    Ctx->Regs.PC += 1;
 }
 
 
 
-static void OPC_6502_EC (void)
+static void OPC_6502_EC (Sim65Context* Ctx)
 /* Opcode $EC: CPX abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    CMP (Regs.XR, MemReadByte (Addr));
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    CMP (Ctx->Regs.XR, ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_ED (void)
+static void OPC_6502_ED (Sim65Context* Ctx)
 /* Opcode $ED: SBC abs */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    SBC (MemReadByte (Addr));
-    Regs.PC += 3;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    SBC (ReadByte (Ctx, Addr));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_EE (void)
+static void OPC_6502_EE (Sim65Context* Ctx)
 /* Opcode $EE: INC abs */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 6;
-    Addr = MemReadWord (Regs.PC+1);
-    Val  = MemReadByte (Addr) + 1;
-    MemWriteByte (Addr, Val);
+    Ctx->Cycles = 6;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1);
+    Val  = ReadByte (Ctx, Addr) + 1;
+    WriteByte (Ctx, Addr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_F0 (void)
+static void OPC_6502_F0 (Sim65Context* Ctx)
 /* Opcode $F0: BEQ */
 {
     BRANCH (GET_ZF ());
@@ -2075,52 +2147,52 @@ static void OPC_6502_F0 (void)
 
 
 
-static void OPC_6502_F1 (void)
+static void OPC_6502_F1 (Sim65Context* Ctx)
 /* Opcode $F1: SBC (zp),y */
 {
     unsigned char ZPAddr;
     unsigned Addr;
-    Cycles = 5;
-    ZPAddr = MemReadByte (Regs.PC+1);
-    Addr   = MemReadZPWord (ZPAddr);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 5;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1);
+    Addr   = ReadZPWord (Ctx, ZPAddr);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    SBC (MemReadByte (Addr + Regs.YR));
-    Regs.PC += 2;
+    SBC (ReadByte (Ctx, Addr + Ctx->Regs.YR));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_F5 (void)
+static void OPC_6502_F5 (Sim65Context* Ctx)
 /* Opcode $F5: SBC zp,x */
 {
     unsigned char ZPAddr;
-    Cycles = 4;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    SBC (MemReadByte (ZPAddr));
-    Regs.PC += 2;
+    Ctx->Cycles = 4;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    SBC (ReadByte (Ctx, ZPAddr));
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_F6 (void)
+static void OPC_6502_F6 (Sim65Context* Ctx)
 /* Opcode $F6: INC zp,x */
 {
     unsigned char ZPAddr;
     unsigned char Val;
-    Cycles = 6;
-    ZPAddr = MemReadByte (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (ZPAddr) + 1;
-    MemWriteByte (ZPAddr, Val);
+    Ctx->Cycles = 6;
+    ZPAddr = ReadByte (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, ZPAddr) + 1;
+    WriteByte (Ctx, ZPAddr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 2;
+    Ctx->Regs.PC += 2;
 }
 
 
 
-static void OPC_6502_F8 (void)
+static void OPC_6502_F8 (Sim65Context* Ctx)
 /* Opcode $F8: SED */
 {
     SET_DF (1);
@@ -2128,48 +2200,48 @@ static void OPC_6502_F8 (void)
 
 
 
-static void OPC_6502_F9 (void)
+static void OPC_6502_F9 (Sim65Context* Ctx)
 /* Opcode $F9: SBC abs,y */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.YR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.YR)) {
+        ++Ctx->Cycles;
     }
-    SBC (MemReadByte (Addr + Regs.YR));
-    Regs.PC += 3;
+    SBC (ReadByte (Ctx, Addr + Ctx->Regs.YR));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_FD (void)
+static void OPC_6502_FD (Sim65Context* Ctx)
 /* Opcode $FD: SBC abs,x */
 {
     unsigned Addr;
-    Cycles = 4;
-    Addr   = MemReadWord (Regs.PC+1);
-    if (PAGE_CROSS (Addr, Regs.XR)) {
-        ++Cycles;
+    Ctx->Cycles = 4;
+    Addr   = ReadWord (Ctx, Ctx->Regs.PC+1);
+    if (PAGE_CROSS (Addr, Ctx->Regs.XR)) {
+        ++Ctx->Cycles;
     }
-    SBC (MemReadByte (Addr + Regs.XR));
-    Regs.PC += 3;
+    SBC (ReadByte (Ctx, Addr + Ctx->Regs.XR));
+    Ctx->Regs.PC += 3;
 }
 
 
 
-static void OPC_6502_FE (void)
+static void OPC_6502_FE (Sim65Context* Ctx)
 /* Opcode $FE: INC abs,x */
 {
     unsigned Addr;
     unsigned char Val;
-    Cycles = 7;
-    Addr = MemReadWord (Regs.PC+1) + Regs.XR;
-    Val  = MemReadByte (Addr) + 1;
-    MemWriteByte (Addr, Val);
+    Ctx->Cycles = 7;
+    Addr = ReadWord (Ctx, Ctx->Regs.PC+1) + Ctx->Regs.XR;
+    Val  = ReadByte (Ctx, Addr) + 1;
+    WriteByte (Ctx, Addr, Val);
     TEST_ZF (Val);
     TEST_SF (Val);
-    Regs.PC += 3;
+    Ctx->Regs.PC += 3;
 }
 
 
@@ -2181,7 +2253,7 @@ static void OPC_6502_FE (void)
 
 
 /* Opcode handler table */
-typedef void (*OPCFunc) (void);
+typedef void (*OPCFunc) (Sim65Context* Ctx);
 static OPCFunc OPCTable[256] = {
     OPC_6502_00,
     OPC_6502_01,
@@ -2443,6 +2515,565 @@ static OPCFunc OPCTable[256] = {
 
 
 
+/*****************************************************************************/
+/*                               Block engine                                */
+/*****************************************************************************/
+
+
+
+/* The block engine decodes straight line code into blocks of pre-decoded
+ * instructions. For the most common instructions, operands are fetched and
+ * operand addresses are resolved when the block is decoded, and the handler
+ * is called directly. All other instructions are executed by the handler in
+ * OPCTable, so the interpreter above remains the reference for the behaviour
+ * of each instruction. Pages containing decoded code are write trapped, and
+ * a write into such a page invalidates all blocks overlapping the page.
+ */
+
+
+
+/* Maximum size of a block in bytes and instructions */
+#define BLOCK_MAX_BYTES         64
+#define BLOCK_MAX_INSNS         32
+
+/* Flags for the decode table */
+#define DF_END                  0x01    /* Instruction ends a block */
+
+/* One decoded instruction */
+typedef struct DecodedInsn DecodedInsn;
+typedef void (*DecodedFunc) (Sim65Context* Ctx, const DecodedInsn* I);
+struct DecodedInsn {
+    DecodedFunc         Handler;        /* Decoded handler or NULL */
+    unsigned            PC;             /* Address of the instruction */
+    unsigned            Next;           /* Address of the next instruction */
+    unsigned            Operand;        /* Operand, address or branch target */
+    unsigned            Cycles;         /* Base cycle count */
+    unsigned            TakenCycles;    /* Cycles for a taken branch */
+    unsigned char       OPC;            /* The opcode */
+};
+
+/* A block of decoded instructions */
+typedef struct CodeBlock CodeBlock;
+struct CodeBlock {
+    CodeBlock*          Next;           /* Next block in free list */
+    unsigned            Start;          /* Start address */
+    unsigned            End;            /* Address behind last instruction */
+    unsigned            Count;          /* Number of instructions */
+    DecodedInsn         Insns[1];       /* Instructions, dynamically! */
+};
+
+/* Decode table entry */
+typedef struct DecodeEntry DecodeEntry;
+struct DecodeEntry {
+    DecodedFunc         Handler;        /* Decoded handler or NULL */
+    unsigned char       Cycles;         /* Base cycle count */
+    unsigned char       Flags;          /* DF_xxx flags */
+};
+
+/* Instruction length by opcode */
+static const unsigned char InsnLen[256] = {
+    1, 2, 1, 1, 1, 2, 2, 1, 1, 2, 1, 1, 1, 3, 3, 1,   /* $00 */
+    2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,   /* $10 */
+    3, 2, 1, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1,   /* $20 */
+    2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,   /* $30 */
+    1, 2, 1, 1, 1, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1,   /* $40 */
+    2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,   /* $50 */
+    1, 2, 1, 1, 1, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1,   /* $60 */
+    2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,   /* $70 */
+    1, 2, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 3, 3, 3, 1,   /* $80 */
+    2, 2, 1, 1, 2, 2, 2, 1, 1, 3, 1, 1, 1, 3, 1, 1,   /* $90 */
+    2, 2, 2, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1,   /* $A0 */
+    2, 2, 1, 1, 2, 2, 2, 1, 1, 3, 1, 1, 3, 3, 3, 1,   /* $B0 */
+    2, 2, 1, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1,   /* $C0 */
+    2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,   /* $D0 */
+    2, 2, 1, 1, 2, 2, 2, 1, 1, 2, 1, 1, 3, 3, 3, 1,   /* $E0 */
+    2, 2, 1, 1, 1, 2, 2, 1, 1, 3, 1, 1, 1, 3, 3, 1,   /* $F0 */
+};
+
+/* Decode table, initialized by BlockInit */
+static DecodeEntry DecodeTable[256];
+
+
+
+/* Get the operand value for the addressing modes of decoded instructions.
+ * zp and abs are the same, since the address was resolved when decoding.
+ */
+#define DM_IMM                                                          \
+    Ctx->Cycles = I->Cycles;                                            \
+    Val    = I->Operand
+#define DM_ADDR                                                         \
+    Ctx->Cycles = I->Cycles;                                            \
+    Val    = ReadByte (Ctx, I->Operand)
+#define DM_ZPX                                                          \
+    Ctx->Cycles = I->Cycles;                                            \
+    Val    = ReadByte (Ctx, (unsigned char) (I->Operand + Ctx->Regs.XR))
+#define DM_ZPY                                                          \
+    Ctx->Cycles = I->Cycles;                                            \
+    Val    = ReadByte (Ctx, (unsigned char) (I->Operand + Ctx->Regs.YR))
+#define DM_ABSX                                                         \
+    Ctx->Cycles = I->Cycles + PAGE_CROSS (I->Operand, Ctx->Regs.XR);    \
+    Val    = ReadByte (Ctx, I->Operand + Ctx->Regs.XR)
+#define DM_ABSY                                                         \
+    Ctx->Cycles = I->Cycles + PAGE_CROSS (I->Operand, Ctx->Regs.YR);    \
+    Val    = ReadByte (Ctx, I->Operand + Ctx->Regs.YR)
+
+/* Get the effective address for stores and read-modify-write instructions */
+#define DA_ADDR         Addr = I->Operand
+#define DA_ZPX          Addr = (unsigned char) (I->Operand + Ctx->Regs.XR)
+#define DA_ZPY          Addr = (unsigned char) (I->Operand + Ctx->Regs.YR)
+#define DA_ABSX         Addr = I->Operand + Ctx->Regs.XR
+#define DA_ABSY         Addr = I->Operand + Ctx->Regs.YR
+
+/* Operations on the value */
+#define DO_LOAD(Reg)    Ctx->Regs.Reg = Val; TEST_ZF (Ctx->Regs.Reg); TEST_SF (Ctx->Regs.Reg)
+#define DO_LDA          DO_LOAD (AC)
+#define DO_LDX          DO_LOAD (XR)
+#define DO_LDY          DO_LOAD (YR)
+#define DO_ORA          Val = Ctx->Regs.AC | Val; DO_LOAD (AC)
+#define DO_AND          Val = Ctx->Regs.AC & Val; DO_LOAD (AC)
+#define DO_EOR          Val = Ctx->Regs.AC ^ Val; DO_LOAD (AC)
+#define DO_ADC          ADC (Val)
+#define DO_SBC          SBC (Val)
+#define DO_CMP          CMP (Ctx->Regs.AC, Val)
+#define DO_CPX          CMP (Ctx->Regs.XR, Val)
+#define DO_CPY          CMP (Ctx->Regs.YR, Val)
+
+/* Handler for instructions reading a value */
+#define DI_READ(Op, Mode)                                               \
+    static void DI_##Op##_##Mode (Sim65Context* Ctx, const DecodedInsn* I) \
+    {                                                                   \
+        unsigned Val;                                                   \
+        DM_##Mode;                                                      \
+        DO_##Op;                                                        \
+        Ctx->Regs.PC = I->Next;                                         \
+    }
+
+/* Handler for store instructions */
+#define DI_STORE(Op, Reg, Mode)                                         \
+    static void DI_##Op##_##Mode (Sim65Context* Ctx, const DecodedInsn* I) \
+    {                                                                   \
+        unsigned Addr;                                                  \
+        Ctx->Cycles = I->Cycles;                                        \
+        DA_##Mode;                                                      \
+        WriteByte (Ctx, Addr, Ctx->Regs.Reg);                           \
+        Ctx->Regs.PC = I->Next;                                         \
+    }
+
+/* Handler for INC/DEC */
+#define DI_INCDEC(Op, Delta, Mode)                                      \
+    static void DI_##Op##_##Mode (Sim65Context* Ctx, const DecodedInsn* I) \
+    {                                                                   \
+        unsigned Addr;                                                  \
+        unsigned char Val;                                              \
+        Ctx->Cycles = I->Cycles;                                        \
+        DA_##Mode;                                                      \
+        Val = ReadByte (Ctx, Addr) + Delta;                             \
+        WriteByte (Ctx, Addr, Val);                                     \
+        TEST_ZF (Val);                                                  \
+        TEST_SF (Val);                                                  \
+        Ctx->Regs.PC = I->Next;                                         \
+    }
+
+/* Handler for branches */
+#define DI_BRANCH(Op, Cond)                                             \
+    static void DI_##Op (Sim65Context* Ctx, const DecodedInsn* I)       \
+    {                                                                   \
+        if (Cond) {                                                     \
+            Ctx->Cycles  = I->TakenCycles;                              \
+            Ctx->Regs.PC = I->Operand;                                  \
+        } else {                                                        \
+            Ctx->Cycles  = I->Cycles;                                   \
+            Ctx->Regs.PC = I->Next;                                     \
+        }                                                               \
+    }
+
+
+
+DI_READ (ORA, IMM)      DI_READ (ORA, ADDR)     DI_READ (ORA, ZPX)
+DI_READ (ORA, ABSX)     DI_READ (ORA, ABSY)
+DI_READ (AND, IMM)      DI_READ (AND, ADDR)     DI_READ (AND, ZPX)
+DI_READ (AND, ABSX)     DI_READ (AND, ABSY)
+DI_READ (EOR, IMM)      DI_READ (EOR, ADDR)     DI_READ (EOR, ZPX)
+DI_READ (EOR, ABSX)     DI_READ (EOR, ABSY)
+DI_READ (ADC, IMM)      DI_READ (ADC, ADDR)     DI_READ (ADC, ZPX)
+DI_READ (ADC, ABSX)     DI_READ (ADC, ABSY)
+DI_READ (SBC, IMM)      DI_READ (SBC, ADDR)     DI_READ (SBC, ZPX)
+DI_READ (SBC, ABSX)     DI_READ (SBC, ABSY)
+DI_READ (CMP, IMM)      DI_READ (CMP, ADDR)     DI_READ (CMP, ZPX)
+DI_READ (CMP, ABSX)     DI_READ (CMP, ABSY)
+DI_READ (LDA, IMM)      DI_READ (LDA, ADDR)     DI_READ (LDA, ZPX)
+DI_READ (LDA, ABSX)     DI_READ (LDA, ABSY)
+DI_READ (LDX, IMM)      DI_READ (LDX, ADDR)     DI_READ (LDX, ZPY)
+DI_READ (LDX, ABSY)
+DI_READ (LDY, IMM)      DI_READ (LDY, ADDR)     DI_READ (LDY, ZPX)
+DI_READ (LDY, ABSX)
+DI_READ (CPX, IMM)      DI_READ (CPX, ADDR)
+DI_READ (CPY, IMM)      DI_READ (CPY, ADDR)
+
+DI_STORE (STA, AC, ADDR)        DI_STORE (STA, AC, ZPX)
+DI_STORE (STA, AC, ABSX)        DI_STORE (STA, AC, ABSY)
+DI_STORE (STX, XR, ADDR)        DI_STORE (STX, XR, ZPY)
+DI_STORE (STY, YR, ADDR)        DI_STORE (STY, YR, ZPX)
+
+DI_INCDEC (INC,  1, ADDR)       DI_INCDEC (INC,  1, ZPX)
+DI_INCDEC (DEC, -1, ADDR)       DI_INCDEC (DEC, -1, ZPX)
+
+DI_BRANCH (BPL, !GET_SF ())     DI_BRANCH (BMI, GET_SF ())
+DI_BRANCH (BVC, !GET_OF ())     DI_BRANCH (BVS, GET_OF ())
+DI_BRANCH (BCC, !GET_CF ())     DI_BRANCH (BCS, GET_CF ())
+DI_BRANCH (BNE, !GET_ZF ())     DI_BRANCH (BEQ, GET_ZF ())
+
+
+
+static void DI_JMP (Sim65Context* Ctx, const DecodedInsn* I)
+/* JMP abs */
+{
+    Ctx->Cycles  = I->Cycles;
+    Ctx->Regs.PC = I->Operand;
+}
+
+
+
+static void DI_JSR (Sim65Context* Ctx, const DecodedInsn* I)
+/* JSR abs */
+{
+    Ctx->Cycles  = I->Cycles;
+    Ctx->Regs.PC = I->PC + 2;
+    PUSH (PCH);
+    PUSH (PCL);
+    Ctx->Regs.PC = I->Operand;
+}
+
+
+
+static void SetDecode (unsigned char OPC, DecodedFunc Handler, unsigned BaseCycles)
+/* Set a decode table entry */
+{
+    DecodeTable[OPC].Handler = Handler;
+    DecodeTable[OPC].Cycles  = (unsigned char) BaseCycles;
+}
+
+
+
+static void BlockInit (void)
+/* Initialize the decode table of the block engine */
+{
+    static const unsigned char EndOPCs[] = {
+        0x00, 0x20, 0x40, 0x4C, 0x60, 0x6C
+    };
+    unsigned I;
+
+    /* By default, instructions are executed by the interpreter handler.
+     * Unconditional control transfers and illegal opcodes end a block.
+     */
+    for (I = 0; I < 256; ++I) {
+        DecodeTable[I].Handler = 0;
+        DecodeTable[I].Cycles  = 0;
+        DecodeTable[I].Flags   = (OPCTable[I] == OPC_Illegal)? DF_END : 0;
+    }
+    for (I = 0; I < sizeof (EndOPCs) / sizeof (EndOPCs[0]); ++I) {
+        DecodeTable[EndOPCs[I]].Flags |= DF_END;
+    }
+
+    /* Instructions with decoded handlers */
+    SetDecode (0x09, DI_ORA_IMM,  2);   SetDecode (0x05, DI_ORA_ADDR, 3);
+    SetDecode (0x15, DI_ORA_ZPX,  4);   SetDecode (0x0D, DI_ORA_ADDR, 4);
+    SetDecode (0x1D, DI_ORA_ABSX, 4);   SetDecode (0x19, DI_ORA_ABSY, 4);
+    SetDecode (0x29, DI_AND_IMM,  2);   SetDecode (0x25, DI_AND_ADDR, 3);
+    SetDecode (0x35, DI_AND_ZPX,  4);   SetDecode (0x2D, DI_AND_ADDR, 4);
+    SetDecode (0x3D, DI_AND_ABSX, 4);   SetDecode (0x39, DI_AND_ABSY, 4);
+    SetDecode (0x49, DI_EOR_IMM,  2);   SetDecode (0x45, DI_EOR_ADDR, 3);
+    SetDecode (0x55, DI_EOR_ZPX,  4);   SetDecode (0x4D, DI_EOR_ADDR, 4);
+    SetDecode (0x5D, DI_EOR_ABSX, 4);   SetDecode (0x59, DI_EOR_ABSY, 4);
+    SetDecode (0x69, DI_ADC_IMM,  2);   SetDecode (0x65, DI_ADC_ADDR, 3);
+    SetDecode (0x75, DI_ADC_ZPX,  4);   SetDecode (0x6D, DI_ADC_ADDR, 4);
+    SetDecode (0x7D, DI_ADC_ABSX, 4);   SetDecode (0x79, DI_ADC_ABSY, 4);
+    SetDecode (0xE9, DI_SBC_IMM,  2);   SetDecode (0xE5, DI_SBC_ADDR, 3);
+    SetDecode (0xF5, DI_SBC_ZPX,  4);   SetDecode (0xED, DI_SBC_ADDR, 4);
+    SetDecode (0xFD, DI_SBC_ABSX, 4);   SetDecode (0xF9, DI_SBC_ABSY, 4);
+    SetDecode (0xC9, DI_CMP_IMM,  2);   SetDecode (0xC5, DI_CMP_ADDR, 3);
+    SetDecode (0xD5, DI_CMP_ZPX,  4);   SetDecode (0xCD, DI_CMP_ADDR, 4);
+    SetDecode (0xDD, DI_CMP_ABSX, 4);   SetDecode (0xD9, DI_CMP_ABSY, 4);
+    SetDecode (0xA9, DI_LDA_IMM,  2);   SetDecode (0xA5, DI_LDA_ADDR, 3);
+    SetDecode (0xB5, DI_LDA_ZPX,  4);   SetDecode (0xAD, DI_LDA_ADDR, 4);
+    SetDecode (0xBD, DI_LDA_ABSX, 4);   SetDecode (0xB9, DI_LDA_ABSY, 4);
+    SetDecode (0xA2, DI_LDX_IMM,  2);   SetDecode (0xA6, DI_LDX_ADDR, 3);
+    SetDecode (0xB6, DI_LDX_ZPY,  4);   SetDecode (0xAE, DI_LDX_ADDR, 4);
+    SetDecode (0xBE, DI_LDX_ABSY, 4);
+    SetDecode (0xA0, DI_LDY_IMM,  2);   SetDecode (0xA4, DI_LDY_ADDR, 3);
+    SetDecode (0xB4, DI_LDY_ZPX,  4);   SetDecode (0xAC, DI_LDY_ADDR, 4);
+    SetDecode (0xBC, DI_LDY_ABSX, 4);
+    SetDecode (0xE0, DI_CPX_IMM,  2);   SetDecode (0xE4, DI_CPX_ADDR, 3);
+    SetDecode (0xEC, DI_CPX_ADDR, 4);
+    SetDecode (0xC0, DI_CPY_IMM,  2);   SetDecode (0xC4, DI_CPY_ADDR, 3);
+    SetDecode (0xCC, DI_CPY_ADDR, 4);
+    SetDecode (0x85, DI_STA_ADDR, 3);   SetDecode (0x95, DI_STA_ZPX,  4);
+    SetDecode (0x8D, DI_STA_ADDR, 4);   SetDecode (0x9D, DI_STA_ABSX, 5);
+    SetDecode (0x99, DI_STA_ABSY, 5);
+    SetDecode (0x86, DI_STX_ADDR, 3);   SetDecode (0x96, DI_STX_ZPY,  4);
+    SetDecode (0x8E, DI_STX_ADDR, 4);
+    SetDecode (0x84, DI_STY_ADDR, 3);   SetDecode (0x94, DI_STY_ZPX,  4);
+    SetDecode (0x8C, DI_STY_ADDR, 4);
+    SetDecode (0xE6, DI_INC_ADDR, 5);   SetDecode (0xF6, DI_INC_ZPX,  6);
+    SetDecode (0xEE, DI_INC_ADDR, 6);
+    SetDecode (0xC6, DI_DEC_ADDR, 5);   SetDecode (0xD6, DI_DEC_ZPX,  6);
+    SetDecode (0xCE, DI_DEC_ADDR, 6);
+    SetDecode (0x10, DI_BPL,      2);   SetDecode (0x30, DI_BMI,      2);
+    SetDecode (0x50, DI_BVC,      2);   SetDecode (0x70, DI_BVS,      2);
+    SetDecode (0x90, DI_BCC,      2);   SetDecode (0xB0, DI_BCS,      2);
+    SetDecode (0xD0, DI_BNE,      2);   SetDecode (0xF0, DI_BEQ,      2);
+    SetDecode (0x4C, DI_JMP,      3);   SetDecode (0x20, DI_JSR,      6);
+}
+
+
+
+static void BlockInvalidate (Sim65Context* Ctx, unsigned Page)
+/* Invalidate all blocks overlapping the given page */
+{
+    unsigned PageStart = Page << MEM_PAGE_SHIFT;
+    unsigned PageEnd   = PageStart + MEM_PAGE_SIZE;
+    unsigned Addr      = (PageStart < BLOCK_MAX_BYTES)? 0 : PageStart - BLOCK_MAX_BYTES;
+
+    /* Remove all blocks that overlap the page */
+    while (Addr < PageEnd && Addr < MemSize) {
+        CodeBlock* B = Ctx->BlockMap[Addr];
+        if (B && B->End > PageStart) {
+            Ctx->BlockMap[Addr] = 0;
+            B->Next  = Ctx->FreeList;
+            Ctx->FreeList = B;
+            ++Ctx->BlocksInvalidated;
+        }
+        ++Addr;
+    }
+
+    /* The page doesn't contain code any longer, so allow direct writes. If
+     * the executing block was removed, it must stop after the current
+     * instruction.
+     */
+    Ctx->CodePages[Page] = 0;
+    MemUntrapPage (Ctx, Page);
+    Ctx->BlockAbort = 1;
+}
+
+
+
+static int DecodeByte (Sim65Context* Ctx, unsigned Addr, unsigned char* Val)
+/* Read a byte for the decoder. Return false if the memory at Addr cannot be
+ * read without side effects.
+ */
+{
+    const unsigned char* P;
+    if (Addr >= MemSize) {
+        return 0;
+    }
+    P = Ctx->MemMap[Addr >> MEM_PAGE_SHIFT].ReadPtr;
+    if (P == 0) {
+        return 0;
+    }
+    *Val = P[Addr & MEM_PAGE_MASK];
+    return 1;
+}
+
+
+
+static CodeBlock* BlockDecode (Sim65Context* Ctx, unsigned Start)
+/* Decode a block starting at the given address. Return NULL if the code at
+ * this address cannot be decoded.
+ */
+{
+    DecodedInsn Insns[BLOCK_MAX_INSNS];
+    unsigned    Count = 0;
+    unsigned    PC    = Start;
+    CodeBlock*  B;
+    unsigned    I;
+
+    while (Count < BLOCK_MAX_INSNS) {
+
+        unsigned char OPC, Lo, Hi;
+        unsigned Len;
+        const DecodeEntry* E;
+        DecodedInsn* D;
+
+        /* Read the opcode and operand bytes */
+        if (!DecodeByte (Ctx, PC, &OPC)) {
+            break;
+        }
+        Len = InsnLen[OPC];
+        if (PC + Len - Start > BLOCK_MAX_BYTES) {
+            break;
+        }
+        Lo = Hi = 0;
+        if ((Len > 1 && !DecodeByte (Ctx, PC+1, &Lo)) ||
+            (Len > 2 && !DecodeByte (Ctx, PC+2, &Hi))) {
+            break;
+        }
+
+        /* Fill in the decoded instruction */
+        E = DecodeTable + OPC;
+        D = Insns + Count++;
+        D->Handler     = E->Handler;
+        D->PC          = PC;
+        D->Next        = PC + Len;
+        D->Operand     = (Len == 3)? (Lo | (Hi << 8)) : Lo;
+        D->Cycles      = E->Cycles;
+        D->TakenCycles = 0;
+        D->OPC         = OPC;
+
+        /* Branches have the target address as operand */
+        if ((OPC & 0x1F) == 0x10) {
+            D->Operand     = PC + 2 + (int) (signed char) Lo;
+            D->TakenCycles = 3;
+            if (((D->Operand >> 8) & 0xFF) != ((PC >> 8) & 0xFF)) {
+                ++D->TakenCycles;
+            }
+        }
+
+        /* Next instruction */
+        PC += Len;
+        if (E->Flags & DF_END) {
+            break;
+        }
+    }
+
+    /* Bail out if we could not decode anything */
+    if (Count == 0) {
+        return 0;
+    }
+
+    /* Create the block */
+    B = xmalloc (sizeof (CodeBlock) + (Count - 1) * sizeof (DecodedInsn));
+    B->Next  = 0;
+    B->Start = Start;
+    B->End   = PC;
+    B->Count = Count;
+    memcpy (B->Insns, Insns, Count * sizeof (DecodedInsn));
+
+    /* Remember the block and trap writes to its pages */
+    Ctx->BlockMap[Start] = B;
+    for (I = (Start >> MEM_PAGE_SHIFT); I <= ((PC - 1) >> MEM_PAGE_SHIFT); ++I) {
+        if (!Ctx->CodePages[I]) {
+            Ctx->CodePages[I] = 1;
+            MemTrapPage (Ctx, I);
+        }
+    }
+    ++Ctx->BlocksDecoded;
+
+    /* Return the new block */
+    return B;
+}
+
+
+
+static void BlockFreeInvalidated (Sim65Context* Ctx)
+/* Free all invalidated blocks */
+{
+    while (Ctx->FreeList) {
+        CodeBlock* B = Ctx->FreeList;
+        Ctx->FreeList = B->Next;
+        xfree (B);
+    }
+}
+
+
+
+static void BlockInitContext (Sim65Context* Ctx)
+/* Allocate the block map and the code page flags of a context */
+{
+    unsigned I;
+
+    Ctx->BlockMap  = xmalloc (MemSize * sizeof (Ctx->BlockMap[0]));
+    Ctx->CodePages = xmalloc ((MemSize >> MEM_PAGE_SHIFT) + 1);
+    for (I = 0; I < MemSize; ++I) {
+        Ctx->BlockMap[I] = 0;
+    }
+    memset (Ctx->CodePages, 0, (MemSize >> MEM_PAGE_SHIFT) + 1);
+}
+
+
+
+static void BlockDoneContext (Sim65Context* Ctx)
+/* Free all blocks of a context */
+{
+    unsigned I;
+
+    /* Move all blocks into the free list, then free them */
+    for (I = 0; I < MemSize; ++I) {
+        CodeBlock* B = Ctx->BlockMap[I];
+        if (B) {
+            B->Next = Ctx->FreeList;
+            Ctx->FreeList = B;
+        }
+    }
+    BlockFreeInvalidated (Ctx);
+
+    xfree (Ctx->BlockMap);
+    xfree (Ctx->CodePages);
+    Ctx->BlockMap  = 0;
+    Ctx->CodePages = 0;
+}
+
+
+
+static void BlockRun (Sim65Context* Ctx, unsigned long Limit)
+/* Run blocks until the cycle limit is reached or an event is flagged */
+{
+    while (!Ctx->CPUEvent && Ctx->TotalCycles < Limit) {
+
+        CodeBlock*         B;
+        const DecodedInsn* I;
+        const DecodedInsn* End;
+
+        /* Get rid of blocks invalidated while running the last one */
+        if (Ctx->FreeList) {
+            BlockFreeInvalidated (Ctx);
+        }
+
+        /* Get the block for the current PC, decode it if necessary */
+        B = (Ctx->Regs.PC < MemSize)? Ctx->BlockMap[Ctx->Regs.PC] : 0;
+        if (B == 0 && (Ctx->Regs.PC >= MemSize || (B = BlockDecode (Ctx, Ctx->Regs.PC)) == 0)) {
+            /* Cannot decode code here, use the interpreter */
+            CPURun (Ctx);
+            continue;
+        }
+
+        /* Run the instructions in the block. The block is left if the PC
+         * doesn't match the next instruction (taken branch or an instruction
+         * that changed the PC otherwise), if the block was invalidated, or
+         * something happened that must be handled.
+         */
+        I   = B->Insns;
+        End = I + B->Count;
+        Ctx->BlockAbort = 0;
+        do {
+            if (I->Handler) {
+                I->Handler (Ctx, I);
+            } else {
+                OPCTable[I->OPC] (Ctx);
+            }
+            Ctx->TotalCycles += Ctx->Cycles;
+            if (Ctx->TraceFile) {
+                TraceInsn (Ctx);
+            }
+            if (Ctx->Profile) {
+                ProfileInsn (Ctx, I->PC, I->OPC);
+            }
+        } while (++I < End && Ctx->Regs.PC == I->PC && !Ctx->CPUEvent && !Ctx->BlockAbort);
+    }
+}
+
+
+
+void CPUPrintStats (const Sim65Context* Ctx)
+/* Print execution engine statistics if verbose output is enabled */
+{
+    if (Ctx->Engine == ENGINE_BLOCK) {
+        Print (stderr, 1, "%lu blocks decoded, %lu blocks invalidated\n",
+               Ctx->BlocksDecoded, Ctx->BlocksInvalidated);
+    }
+}
+
+
+
 /*****************************************************************************/
 /*				     Code				     */
 /*****************************************************************************/
@@ -2450,97 +3081,203 @@ static OPCFunc OPCTable[256] = {
 
 
 void CPUInit (void)
-/* Initialize the CPU */
+/* Initialize the CPU core. Must be called once before any context is run. */
+{
+    BlockInit ();
+}
+
+
+
+void CPUInitContext (Sim65Context* Ctx)
+/* Initialize the CPU of a context and reset it. The memory of the context
+ * must be set up, since the reset vector is read.
+ */
 {
-    RESET ();
+    if (Ctx->Engine == ENGINE_BLOCK) {
+        BlockInitContext (Ctx);
+    }
+    RESET (Ctx);
+}
+
+
+
+void CPUDoneContext (Sim65Context* Ctx)
+/* Free the CPU data of a context */
+{
+    if (Ctx->BlockMap) {
+        BlockDoneContext (Ctx);
+    }
 }
 
 
 
 void IRQRequest (void)
-/* Generate an IRQ */
+/* Generate an IRQ for the context of the calling thread */
 {
-    HaveIRQRequest = 1;
+    Sim65Context* Ctx = GetContext ();
+    Ctx->HaveIRQRequest = 1;
+    Ctx->CPUEvent       = 1;
 }
 
 
 
 void NMIRequest (void)
-/* Generate an NMI */
+/* Generate an NMI for the context of the calling thread */
 {
-    HaveNMIRequest = 1;
+    Sim65Context* Ctx = GetContext ();
+    Ctx->HaveNMIRequest = 1;
+    Ctx->CPUEvent       = 1;
 }
 
 
 
-void RESET (void)
+void RESET (Sim65Context* Ctx)
 /* Generate a CPU RESET */
 {
-    CPUHalted = HaveIRQRequest = HaveNMIRequest = 0;
-    Regs.PC = MemReadWord (0xFFFC);
+    Ctx->CPUHalted = Ctx->HaveIRQRequest = Ctx->HaveNMIRequest = 0;
+    Ctx->CPUEvent  = (Ctx->BreakMsg[0] != '\0');
+    Ctx->Regs.PC = ReadWord (Ctx, 0xFFFC);
 }
 
 
 
 void Break (const char* Format, ...)
-/* Stop running and display the given message */
+/* Stop running the context of the calling thread and display the given
+ * message
+ */
 {
 #if 0
+    Sim65Context* Ctx = GetContext ();
     va_list ap;
     va_start (ap, Format);
-    xvsprintf (BreakMsg, sizeof (BreakMsg), Format, ap);
+    xvsprintf (Ctx->BreakMsg, sizeof (Ctx->BreakMsg), Format, ap);
     va_end (ap);
+    Ctx->CPUEvent = 1;
 #endif
 }
 
 
 
-void CPURun (void)
+void CPURun (Sim65Context* Ctx)
 /* Run one CPU instruction */
 {
+    unsigned      PC;
+    unsigned char OPC = 0;
+    int           Interrupt = 0;
+
     /* If the CPU is halted, do nothing */
-    if (CPUHalted) {
+    if (Ctx->CPUHalted) {
         return;
     }
 
+    /* Remember the PC for the profiler */
+    PC = Ctx->Regs.PC;
+
     /* If we have an NMI request, handle it */
-    if (HaveNMIRequest) {
+    if (Ctx->HaveNMIRequest) {
 
-        HaveNMIRequest = 0;
+        Ctx->HaveNMIRequest = 0;
         PUSH (PCH);
         PUSH (PCL);
-        PUSH (Regs.SR);
+        PUSH (Ctx->Regs.SR);
         SET_IF (1);
-        Regs.PC = MemReadWord (0xFFFA);
-        Cycles = 7;
+        Ctx->Regs.PC = ReadWord (Ctx, 0xFFFA);
+        Ctx->Cycles = 7;
+        Interrupt = 1;
 
-    } else if (HaveIRQRequest && GET_IF () == 0) {
+    } else if (Ctx->HaveIRQRequest && GET_IF () == 0) {
 
-        HaveIRQRequest = 0;
+        Ctx->HaveIRQRequest = 0;
         PUSH (PCH);
         PUSH (PCL);
-        PUSH (Regs.SR);
+        PUSH (Ctx->Regs.SR);
         SET_IF (1);
-        Regs.PC = MemReadWord (0xFFFE);
-        Cycles = 7;
+        Ctx->Regs.PC = ReadWord (Ctx, 0xFFFE);
+        Ctx->Cycles = 7;
+        Interrupt = 1;
 
     } else {
 
         /* Normal instruction - read the next opcode */
-        unsigned char OPC = MemReadByte (Regs.PC);
+        OPC = ReadByte (Ctx, PC);
 
         /* Execute it */
-        OPCTable[OPC] ();
+        OPCTable[OPC] (Ctx);
 
     }
 
     /* Count cycles */
-    TotalCycles += Cycles;
+    Ctx->TotalCycles += Ctx->Cycles;
+    if (Ctx->TraceFile) {
+        TraceInsn (Ctx);
+    }
+    if (Ctx->Profile) {
+        if (Interrupt) {
+            ProfileInterrupt (Ctx, PC);
+        } else {
+            ProfileInsn (Ctx, PC, OPC);
+        }
+    }
+
+    if (Ctx->BreakMsg[0]) {
+        printf ("%s\n", Ctx->BreakMsg);
+        Ctx->BreakMsg[0] = '\0';
+    }
+
+    /* A masked IRQ request stays pending, so we will check again after the
+     * next instruction.
+     */
+    Ctx->CPUEvent = Ctx->HaveNMIRequest || Ctx->HaveIRQRequest || Ctx->CPUHalted;
+}
+
 
-    if (BreakMsg[0]) {
-        printf ("%s\n", BreakMsg);
-        BreakMsg[0] = '\0';
+
+unsigned long CPURunCycles (Sim65Context* Ctx, unsigned long Budget)
+/* Run CPU instructions until at least Budget cycles have been used or the
+ * CPU is halted. Return the number of cycles actually used. Interrupts, halt
+ * and break messages are checked only if one of them changed, so the
+ * instructions in between run in a tight loop. Cycles are counted exactly
+ * as in CPURun.
+ */
+{
+    unsigned long Start = Ctx->TotalCycles;
+    unsigned long Limit = Ctx->TotalCycles + Budget;
+
+    while (!Ctx->CPUHalted && Ctx->TotalCycles < Limit) {
+
+        if (Ctx->CPUEvent) {
+
+            /* Something happened, do a single step that handles it */
+            CPURun (Ctx);
+
+        } else if (Ctx->Engine == ENGINE_BLOCK) {
+
+            /* Run decoded blocks */
+            BlockRun (Ctx, Limit);
+
+        } else {
+
+            /* Nothing to check, run instructions until an event is flagged
+             * or the budget is used up.
+             */
+            do {
+                unsigned      PC  = Ctx->Regs.PC;
+                unsigned char OPC = ReadByte (Ctx, PC);
+                OPCTable[OPC] (Ctx);
+                Ctx->TotalCycles += Ctx->Cycles;
+                if (Ctx->TraceFile) {
+                    TraceInsn (Ctx);
+                }
+                if (Ctx->Profile) {
+                    ProfileInsn (Ctx, PC, OPC);
+                }
+            } while (!Ctx->CPUEvent && Ctx->TotalCycles < Limit);
+
+        }
     }
+
+    /* Return the number of cycles used */
+    return Ctx->TotalCycles - Start;
 }
 
 
@@ -2548,7 +3285,7 @@ void CPURun (void)
 #if 0
     if ((++I & 0xFF) == 0)
     printf ("%9lu %06X %02X A=%02X X=%02X Y=%02X %c%c%c%c%c%c%c\n",
-            TotalCycles, Regs.PC, OPC, Regs.AC, Regs.XR, Regs.YR,
+            Ctx->TotalCycles, Ctx->Regs.PC, OPC, Ctx->Regs.AC, Ctx->Regs.XR, Ctx->Regs.YR,
             GET_SF()? 'S' : '-',
             GET_ZF()? 'Z' : '-',
             GET_CF()? 'C' : '-',
@@ -39,18 +39,7 @@
 
 
 /* sim65 */
-#include "cpuregs.h"
-
-
-
-/*****************************************************************************/
-/*  	   			     Data				     */
-/*****************************************************************************/
-
-
-
-/* Registers */
-extern CPURegs Regs;
+#include "context.h"
 
 
 
@@ -61,23 +50,44 @@ extern CPURegs Regs;
 
 
 void CPUInit (void);
-/* Initialize the CPU */
+/* Initialize the CPU core. Must be called once before any context is run. */
+
+void CPUInitContext (Sim65Context* Ctx);
+/* Initialize the CPU of a context and reset it. The memory of the context
+ * must be set up, since the reset vector is read.
+ */
 
-void RESET (void);
+void CPUDoneContext (Sim65Context* Ctx);
+/* Free the CPU data of a context */
+
+void RESET (Sim65Context* Ctx);
 /* Generate a CPU RESET */
 
 void IRQRequest (void);
-/* Generate an IRQ */
+/* Generate an IRQ for the context of the calling thread */
 
 void NMIRequest (void);
-/* Generate an NMI */
+/* Generate an NMI for the context of the calling thread */
 
 void Break (const char* Format, ...);
-/* Stop running and display the given message */
+/* Stop running the context of the calling thread and display the given
+ * message
+ */
 
-void CPURun (void);
+void CPURun (Sim65Context* Ctx);
 /* Run one CPU instruction */
 
+void CPUPrintStats (const Sim65Context* Ctx);
+/* Print execution engine statistics if verbose output is enabled */
+
+unsigned long CPURunCycles (Sim65Context* Ctx, unsigned long Budget);
+/* Run CPU instructions until at least Budget cycles have been used or the
+ * CPU is halted. Return the number of cycles actually used. Interrupts, halt
+ * and break messages are checked only if one of them changed, so the
+ * instructions in between run in a tight loop. Cycles are counted exactly
+ * as in CPURun.
+ */
+
 
 
 /* End of cpucore.h */
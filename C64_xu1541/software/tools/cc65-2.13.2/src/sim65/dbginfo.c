@@ -0,0 +1,403 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 dbginfo.c                                 */
+/*                                                                           */
+/*                       Read the ld65 debug info file                       */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* common */
+#include "strbuf.h"
+#include "xmalloc.h"
+
+/* sim65 */
+#include "error.h"
+#include "dbginfo.h"
+
+
+
+/*****************************************************************************/
+/*                                     Code                                  */
+/*****************************************************************************/
+
+
+
+static int ReadLine (FILE* F, StrBuf* Line)
+/* Read one line from F into Line. Return false at end of file. */
+{
+    int C;
+
+    SB_Clear (Line);
+    while ((C = getc (F)) != EOF && C != '\n') {
+        SB_AppendChar (Line, C);
+    }
+    SB_Terminate (Line);
+    return (C != EOF || SB_GetLen (Line) > 0);
+}
+
+
+
+static const char* ParseName (const char* P, StrBuf* Name)
+/* Parse the quoted name following the keyword. Return a pointer to the
+ * remainder of the line or NULL if there is no name.
+ */
+{
+    /* Skip the keyword and white space */
+    while (*P != '\0' && *P != '"') {
+        ++P;
+    }
+    if (*P++ != '"') {
+        return 0;
+    }
+
+    /* Read the name */
+    SB_Clear (Name);
+    while (*P != '\0' && *P != '"') {
+        SB_AppendChar (Name, *P++);
+    }
+    SB_Terminate (Name);
+    if (*P++ != '"') {
+        return 0;
+    }
+    return P;
+}
+
+
+
+static const char* NextAttr (const char* P, const char** Key, unsigned* KeyLen)
+/* Return a pointer to the value of the next "key=value" pair following P
+ * and return the key in Key/KeyLen. Return NULL if there are no more pairs.
+ */
+{
+    if (*P != ',') {
+        return 0;
+    }
+    *Key = ++P;
+    while (*P != '\0' && *P != '=' && *P != ',') {
+        ++P;
+    }
+    if (*P != '=') {
+        return 0;
+    }
+    *KeyLen = P - *Key;
+    return P + 1;
+}
+
+
+
+static const char* SkipValue (const char* P)
+/* Skip the value of a "key=value" pair */
+{
+    while (*P != '\0' && *P != ',') {
+        ++P;
+    }
+    return P;
+}
+
+
+
+static int KeyIs (const char* Key, unsigned KeyLen, const char* Name)
+/* Return true if Key/KeyLen is the given name */
+{
+    return (strlen (Name) == KeyLen && memcmp (Key, Name, KeyLen) == 0);
+}
+
+
+
+static const char* AddFile (DbgInfo* D, const char* Name)
+/* Return the stored copy of a file name, adding it if necessary */
+{
+    unsigned I;
+    char* F;
+
+    /* Line infos for one file are usually grouped, so search backwards */
+    I = CollCount (&D->Files);
+    while (I-- > 0) {
+        F = CollAtUnchecked (&D->Files, I);
+        if (strcmp (F, Name) == 0) {
+            return F;
+        }
+    }
+
+    /* Not found, add it */
+    F = xstrdup (Name);
+    CollAppend (&D->Files, F);
+    return F;
+}
+
+
+
+static void ParseSym (DbgInfo* D, const char* Name, const char* P)
+/* Parse the attributes of a "sym" line */
+{
+    const char*   Key;
+    unsigned      KeyLen;
+    unsigned long Value = 0;
+    int           IsLabel = 0;
+    unsigned      Len;
+    DbgSym*       S;
+
+    while ((P = NextAttr (P, &Key, &KeyLen)) != 0) {
+        if (KeyIs (Key, KeyLen, "value")) {
+            Value = strtoul (P, 0, 0);
+        } else if (KeyIs (Key, KeyLen, "type")) {
+            IsLabel = (strncmp (P, "label", 5) == 0);
+        }
+        P = SkipValue (P);
+    }
+
+    /* Only labels are useful for mapping addresses back. Cheap locals and
+     * the .size symbols of scopes are ignored.
+     */
+    if (!IsLabel || Name[0] == '@' || Name[0] == '.') {
+        return;
+    }
+
+    Len = strlen (Name);
+    S = xmalloc (sizeof (DbgSym) + Len);
+    S->Value = Value;
+    memcpy (S->Name, Name, Len + 1);
+    CollAppend (&D->Syms, S);
+}
+
+
+
+static void ParseLine (DbgInfo* D, const char* Name, const char* P)
+/* Parse the attributes of a "line" line */
+{
+    const char*    Key;
+    unsigned       KeyLen;
+    unsigned long  Line = 0;
+    const char*    File = AddFile (D, Name);
+    unsigned       First = CollCount (&D->Lines);
+    char*          End;
+    DbgLine*       L;
+
+    while ((P = NextAttr (P, &Key, &KeyLen)) != 0) {
+        if (KeyIs (Key, KeyLen, "line")) {
+            Line = strtoul (P, 0, 0);
+        } else if (KeyIs (Key, KeyLen, "range")) {
+            L = xmalloc (sizeof (DbgLine));
+            L->Start = strtoul (P, &End, 0);
+            L->End   = (*End == '-')? strtoul (End + 1, 0, 0) : L->Start;
+            L->File  = File;
+            CollAppend (&D->Lines, L);
+        }
+        P = SkipValue (P);
+    }
+
+    /* The line number may follow the ranges, so set it now */
+    while (First < CollCount (&D->Lines)) {
+        L = CollAtUnchecked (&D->Lines, First++);
+        L->Line = Line;
+    }
+}
+
+
+
+static int CmpSym (void* Data attribute ((unused)),
+                   const void* Left, const void* Right)
+/* Compare function for sorting symbols */
+{
+    const DbgSym* L = Left;
+    const DbgSym* R = Right;
+    if (L->Value != R->Value) {
+        return (L->Value < R->Value)? -1 : 1;
+    }
+    return strcmp (L->Name, R->Name);
+}
+
+
+
+static int CmpLine (void* Data attribute ((unused)),
+                    const void* Left, const void* Right)
+/* Compare function for sorting line infos */
+{
+    const DbgLine* L = Left;
+    const DbgLine* R = Right;
+    if (L->Start != R->Start) {
+        return (L->Start < R->Start)? -1 : 1;
+    }
+    /* Prefer the smaller range for the same address */
+    if (L->End != R->End) {
+        return (L->End < R->End)? -1 : 1;
+    }
+    return 0;
+}
+
+
+
+DbgInfo* ReadDbgInfo (const char* Name)
+/* Read the debug info file written by ld65 with --dbgfile. Only labels and
+ * line infos are used, everything else is ignored.
+ */
+{
+    StrBuf   Line  = STATIC_STRBUF_INITIALIZER;
+    StrBuf   Ident = STATIC_STRBUF_INITIALIZER;
+    DbgInfo* D;
+    FILE*    F;
+
+    /* Open the file */
+    F = fopen (Name, "r");
+    if (F == 0) {
+        Error ("Cannot open `%s': %s", Name, strerror (errno));
+    }
+
+    /* Create the debug info */
+    D = xmalloc (sizeof (DbgInfo));
+    InitCollection (&D->Syms);
+    InitCollection (&D->Lines);
+    InitCollection (&D->Files);
+
+    /* Read the lines */
+    while (ReadLine (F, &Line)) {
+        const char* L = SB_GetConstBuf (&Line);
+        const char* P = ParseName (L, &Ident);
+        if (P == 0) {
+            continue;
+        }
+        if (strncmp (L, "sym", 3) == 0) {
+            ParseSym (D, SB_GetConstBuf (&Ident), P);
+        } else if (strncmp (L, "line", 4) == 0) {
+            ParseLine (D, SB_GetConstBuf (&Ident), P);
+        }
+    }
+    fclose (F);
+    SB_Done (&Ident);
+    SB_Done (&Line);
+
+    /* Sort symbols and lines by address for lookup */
+    CollSort (&D->Syms, CmpSym, 0);
+    CollSort (&D->Lines, CmpLine, 0);
+
+    /* Return the debug info */
+    return D;
+}
+
+
+
+static void FreeItems (Collection* C)
+/* Free all items of a collection and the collection itself */
+{
+    unsigned I;
+    for (I = 0; I < CollCount (C); ++I) {
+        xfree (CollAtUnchecked (C, I));
+    }
+    DoneCollection (C);
+}
+
+
+
+void FreeDbgInfo (DbgInfo* D)
+/* Free debug info read by ReadDbgInfo */
+{
+    if (D) {
+        FreeItems (&D->Syms);
+        FreeItems (&D->Lines);
+        FreeItems (&D->Files);
+        xfree (D);
+    }
+}
+
+
+
+const DbgSym* DbgFindSym (const DbgInfo* D, unsigned long Addr)
+/* Return the label with the highest address less or equal to Addr. Return
+ * NULL if there is no such label.
+ */
+{
+    int Lo = 0;
+    int Hi = (int) CollCount (&D->Syms) - 1;
+    int Found = -1;
+
+    /* Binary search for the last label at or below Addr */
+    while (Lo <= Hi) {
+        int Cur = (Lo + Hi) / 2;
+        const DbgSym* S = CollConstAt (&D->Syms, Cur);
+        if (S->Value <= Addr) {
+            Found = Cur;
+            Lo = Cur + 1;
+        } else {
+            Hi = Cur - 1;
+        }
+    }
+    if (Found < 0) {
+        return 0;
+    }
+
+    /* If several labels share the address, use the first one by name */
+    while (Found > 0 &&
+           ((const DbgSym*) CollConstAt (&D->Syms, Found - 1))->Value ==
+           ((const DbgSym*) CollConstAt (&D->Syms, Found))->Value) {
+        --Found;
+    }
+    return CollConstAt (&D->Syms, Found);
+}
+
+
+
+const DbgLine* DbgFindLine (const DbgInfo* D, unsigned long Addr)
+/* Return the line info for Addr or NULL if there is none */
+{
+    int Lo = 0;
+    int Hi = (int) CollCount (&D->Lines) - 1;
+    int Found = -1;
+    const DbgLine* L;
+
+    /* Binary search for the last range starting at or below Addr */
+    while (Lo <= Hi) {
+        int Cur = (Lo + Hi) / 2;
+        L = CollConstAt (&D->Lines, Cur);
+        if (L->Start <= Addr) {
+            Found = Cur;
+            Lo = Cur + 1;
+        } else {
+            Hi = Cur - 1;
+        }
+    }
+
+    /* Ranges of different lines may nest (for example a macro expansion
+     * within a source line), so search backwards for one containing Addr.
+     * Only a few entries are checked, since overlaps are short.
+     */
+    for (Lo = Found; Lo >= 0 && Lo > Found - 8; --Lo) {
+        L = CollConstAt (&D->Lines, Lo);
+        if (L->Start <= Addr && L->End >= Addr) {
+            return L;
+        }
+    }
+    return 0;
+}
+
+
+
@@ -0,0 +1,107 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 dbginfo.h                                 */
+/*                                                                           */
+/*                       Read the ld65 debug info file                       */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef DBGINFO_H
+#define DBGINFO_H
+
+
+
+/* common */
+#include "coll.h"
+
+
+
+/*****************************************************************************/
+/*                                     Data                                  */
+/*****************************************************************************/
+
+
+
+/* A label from the debug info */
+typedef struct DbgSym DbgSym;
+struct DbgSym {
+    unsigned long       Value;          /* Address of the label */
+    char                Name[1];        /* Name, dynamically allocated */
+};
+
+/* A line info from the debug info. Line infos with several code ranges are
+ * split into one entry per range.
+ */
+typedef struct DbgLine DbgLine;
+struct DbgLine {
+    unsigned long       Start;          /* First address of the range */
+    unsigned long       End;            /* Last address of the range */
+    unsigned long       Line;           /* Line number */
+    const char*         File;           /* File name */
+};
+
+/* Debug info read from a file */
+typedef struct DbgInfo DbgInfo;
+struct DbgInfo {
+    Collection          Syms;           /* Labels sorted by address */
+    Collection          Lines;          /* Line infos sorted by address */
+    Collection          Files;          /* File names */
+};
+
+
+
+/*****************************************************************************/
+/*                                     Code                                  */
+/*****************************************************************************/
+
+
+
+DbgInfo* ReadDbgInfo (const char* Name);
+/* Read the debug info file written by ld65 with --dbgfile. Only labels and
+ * line infos are used, everything else is ignored.
+ */
+
+void FreeDbgInfo (DbgInfo* D);
+/* Free debug info read by ReadDbgInfo */
+
+const DbgSym* DbgFindSym (const DbgInfo* D, unsigned long Addr);
+/* Return the label with the highest address less or equal to Addr. Return
+ * NULL if there is no such label.
+ */
+
+const DbgLine* DbgFindLine (const DbgInfo* D, unsigned long Addr);
+/* Return the line info for Addr or NULL if there is none */
+
+
+
+/* End of dbginfo.h */
+
+#endif
+
+
+
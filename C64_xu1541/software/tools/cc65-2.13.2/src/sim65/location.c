@@ -81,6 +81,23 @@ Location* NewLocation (unsigned long Start, unsigned long End)
 
 
 
+void FreeLocation (Location* L)
+/* Free a location including all remaining attributes */
+{
+    unsigned I;
+
+    /* Free the attributes */
+    for (I = 0; I < CollCount (&L->Attributes); ++I) {
+        FreeCfgData (CollAtUnchecked (&L->Attributes, I));
+    }
+    DoneCollection (&L->Attributes);
+
+    /* Free the struct */
+    xfree (L);
+}
+
+
+
 static int CmpLocations (void* Data attribute ((unused)),
 		         const void* lhs, const void* rhs)
 /* Compare function for CollSort */
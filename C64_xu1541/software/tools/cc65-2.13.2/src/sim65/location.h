@@ -73,6 +73,9 @@ struct Location {
 Location* NewLocation (unsigned long Start, unsigned long End);
 /* Create a new location, initialize and return it */
 
+void FreeLocation (Location* L);
+/* Free a location including all remaining attributes */
+
 int LocationGetAttr (const Location* L, const char* AttrName);
 /* Find the attribute with the given name and return it. Call Error() if the
  * attribute was not found.
@@ -37,10 +37,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <pthread.h>
 
 /* common */
 #include "abend.h"
@@ -53,15 +55,56 @@
 #include "chip.h"
 #include "chippath.h"
 #include "config.h"
+#include "context.h"
 #include "cpucore.h"
 #include "cputype.h"
+#include "dbginfo.h"
 #include "error.h"
 #include "global.h"
 #include "memory.h"
+#include "profile.h"
 #include "scanner.h"
 
 
 
+/*****************************************************************************/
+/*     	      	    	       	     Data				     */
+/*****************************************************************************/
+
+
+
+/* Number of cycles to run between checks in the main loop */
+#define RUN_BUDGET      1000000UL
+
+/* Cycle limit for programs run with --testdir if --max-cycles isn't given */
+#define TEST_MAX_CYCLES 1000000000UL
+
+/* Options */
+static CPUEngineType    Engine    = ENGINE_INTERP;  /* Execution engine */
+static FILE*            TraceFile = 0;              /* Trace file or NULL */
+static unsigned long    MaxCycles = 0;              /* Cycle limit, 0 = none */
+static unsigned         Jobs      = 0;              /* Threads, 0 = all CPUs */
+static const char*      TestDir   = 0;              /* Test directory */
+static const char*      ProfName  = 0;              /* Profile report file */
+static const char*      DbgName   = 0;              /* ld65 debug info file */
+
+/* One test program run by --testdir */
+typedef struct TestRun TestRun;
+struct TestRun {
+    char*               Name;           /* Name of the program file */
+    int                 Halted;         /* True if stopped by BRK */
+    unsigned            ExitCode;       /* Accumulator when halted */
+    unsigned long       Cycles;         /* Cycles used */
+    FILE*               Output;         /* Output of the program */
+};
+
+/* The list of tests and the next one to run */
+static Collection       Tests    = STATIC_COLLECTION_INITIALIZER;
+static unsigned         NextTest = 0;
+static pthread_mutex_t  TestLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
 /*****************************************************************************/
 /*				     Code				     */
 /*****************************************************************************/
@@ -70,21 +113,29 @@
 
 static void Usage (void)
 {
-    printf ("Usage: %s [options] file\n"
+    printf ("Usage: %s [options] [file]\n"
             "Short options:\n"
             "  -C name\t\tUse simulator config file\n"
             "  -L dir\t\tSet a chip directory search path\n"
             "  -V\t\t\tPrint the simulator version number\n"
             "  -d\t\t\tDebug mode\n"
             "  -h\t\t\tHelp (this text)\n"
+            "  -j n\t\t\tRun n tests in parallel\n"
             "  -v\t\t\tIncrease verbosity\n"
             "\n"
             "Long options:\n"
             "  --chipdir dir\t\tSet a chip directory search path\n"
             "  --config name\t\tUse simulator config file\n"
             "  --cpu type\t\tSet cpu type\n"
+            "  --dbgfile name\tRead labels and lines from ld65 debug info\n"
             "  --debug\t\tDebug mode\n"
+            "  --engine name\t\tSet execution engine (interp, block)\n"
             "  --help\t\tHelp (this text)\n"
+            "  --jobs n\t\tRun n tests in parallel\n"
+            "  --max-cycles n\tStop the program after n cycles\n"
+            "  --profile file\tWrite a profile report to file\n"
+            "  --testdir dir\t\tRun all *.bin programs in dir as tests\n"
+            "  --trace file\t\tWrite an instruction trace to file\n"
             "  --verbose\t\tIncrease verbosity\n"
             "  --version\t\tPrint the simulator version number\n",
             ProgName);
@@ -175,6 +226,14 @@ static void OptConfig (const char* Opt attribute ((unused)), const char* Arg)
 
 
 
+static void OptDbgFile (const char* Opt attribute ((unused)), const char* Arg)
+/* Handle the --dbgfile option */
+{
+    DbgName = Arg;
+}
+
+
+
 static void OptDebug (const char* Opt attribute ((unused)),
 	   	      const char* Arg attribute ((unused)))
 /* Simulator debug mode */
@@ -184,6 +243,20 @@ static void OptDebug (const char* Opt attribute ((unused)),
 
 
 
+static void OptEngine (const char* Opt, const char* Arg)
+/* Handle the --engine option */
+{
+    if (strcmp (Arg, "interp") == 0) {
+        Engine = ENGINE_INTERP;
+    } else if (strcmp (Arg, "block") == 0) {
+        Engine = ENGINE_BLOCK;
+    } else {
+       	AbEnd ("Invalid argument for %s: `%s'", Opt, Arg);
+    }
+}
+
+
+
 static void OptHelp (const char* Opt attribute ((unused)),
 		     const char* Arg attribute ((unused)))
 /* Print usage information and exit */
@@ -194,6 +267,69 @@ static void OptHelp (const char* Opt attribute ((unused)),
 
 
 
+static unsigned long CvtNumber (const char* Opt, const char* Arg)
+/* Convert the numeric argument of an option */
+{
+    unsigned long Val;
+    char          C;
+
+    if (sscanf (Arg, "%lu%c", &Val, &C) != 1) {
+       	AbEnd ("Invalid argument for %s: `%s'", Opt, Arg);
+    }
+    return Val;
+}
+
+
+
+static void OptJobs (const char* Opt, const char* Arg)
+/* Handle the --jobs option */
+{
+    Jobs = (unsigned) CvtNumber (Opt, Arg);
+    if (Jobs == 0) {
+       	AbEnd ("Invalid argument for %s: `%s'", Opt, Arg);
+    }
+}
+
+
+
+static void OptMaxCycles (const char* Opt, const char* Arg)
+/* Handle the --max-cycles option */
+{
+    MaxCycles = CvtNumber (Opt, Arg);
+}
+
+
+
+static void OptProfile (const char* Opt attribute ((unused)), const char* Arg)
+/* Handle the --profile option */
+{
+    ProfName = Arg;
+}
+
+
+
+static void OptTestDir (const char* Opt attribute ((unused)), const char* Arg)
+/* Handle the --testdir option */
+{
+    TestDir = Arg;
+}
+
+
+
+static void OptTrace (const char* Opt, const char* Arg)
+/* Handle the --trace option */
+{
+    if (TraceFile) {
+        AbEnd ("Cannot use %s twice", Opt);
+    }
+    TraceFile = fopen (Arg, "w");
+    if (TraceFile == 0) {
+        AbEnd ("Cannot open `%s': %s", Arg, strerror (errno));
+    }
+}
+
+
+
 static void OptVerbose (const char* Opt attribute ((unused)),
 			const char* Arg attribute ((unused)))
 /* Increase verbosity */
@@ -212,6 +348,231 @@ static void OptVersion (const char* Opt attribute ((unused)),
 
 
 
+static void WriteProfile (Sim65Context* Ctx)
+/* Write the profile report of a context to the --profile file */
+{
+    DbgInfo* D = 0;
+    FILE*    F;
+
+    /* Read the debug info if we have one */
+    if (DbgName) {
+        D = ReadDbgInfo (DbgName);
+    }
+
+    /* Write the report */
+    F = fopen (ProfName, "w");
+    if (F == 0) {
+        Error ("Cannot create `%s': %s", ProfName, strerror (errno));
+    }
+    ProfileReport (Ctx, D, F);
+    if (fclose (F) != 0) {
+        Error ("Error closing `%s': %s", ProfName, strerror (errno));
+    }
+
+    /* Free the debug info */
+    FreeDbgInfo (D);
+}
+
+
+
+static void RunContext (Sim65Context* Ctx, const char* Program)
+/* Read the config for the given program into a context, then run the CPU
+ * until it is halted or the cycle limit is reached. Must be called from the
+ * thread that owns the context.
+ */
+{
+    /* Chip callbacks go to this context */
+    SetContext (Ctx);
+
+    /* Create the chips and reset the CPU */
+    CfgRead (Ctx, Program);
+    CPUInitContext (Ctx);
+
+    /* Run until the CPU is halted */
+    while (!Ctx->CPUHalted &&
+           (MaxCycles == 0 || Ctx->TotalCycles < MaxCycles)) {
+        CPURunCycles (Ctx, RUN_BUDGET);
+    }
+}
+
+
+
+static int CmpTests (void* Data attribute ((unused)),
+                     const void* lhs, const void* rhs)
+/* Compare function for CollSort */
+{
+    return strcmp (((const TestRun*) lhs)->Name, ((const TestRun*) rhs)->Name);
+}
+
+
+
+static void ReadTestDir (const char* Dir)
+/* Add all *.bin files in the given directory to the list of tests */
+{
+    struct dirent* E;
+
+    /* Open the directory */
+    DIR* D = opendir (Dir);
+    if (D == 0) {
+        AbEnd ("Cannot read directory `%s': %s", Dir, strerror (errno));
+    }
+
+    /* Add all programs */
+    while ((E = readdir (D)) != 0) {
+
+        TestRun* T;
+
+	unsigned NameLen = strlen (E->d_name);
+	if (NameLen <= 4 || strcmp (E->d_name + NameLen - 4, ".bin") != 0) {
+	    continue;
+	}
+
+        /* Create the test */
+        T = xmalloc (sizeof (TestRun));
+        T->Name = xmalloc (strlen (Dir) + 1 + NameLen + 1);
+        sprintf (T->Name, "%s/%s", Dir, E->d_name);
+        T->Halted   = 0;
+        T->ExitCode = 0;
+        T->Cycles   = 0;
+        T->Output   = 0;
+        CollAppend (&Tests, T);
+    }
+
+    /* Close the directory */
+    closedir (D);
+
+    /* Run and report the tests in a predictable order */
+    CollSort (&Tests, CmpTests, 0);
+}
+
+
+
+static void* TestWorker (void* Arg attribute ((unused)))
+/* Thread function: Run tests until there are no more left */
+{
+    while (1) {
+
+        TestRun*      T;
+        Sim65Context* Ctx;
+
+        /* Get the next test */
+        pthread_mutex_lock (&TestLock);
+        T = (NextTest < CollCount (&Tests))? CollAt (&Tests, NextTest++) : 0;
+        pthread_mutex_unlock (&TestLock);
+        if (T == 0) {
+            break;
+        }
+
+        /* Run it on a new machine, catching the output in a file */
+        Ctx = NewContext (Engine);
+        Ctx->Output = tmpfile ();
+        if (Ctx->Output == 0) {
+            Error ("Cannot create temporary file: %s", strerror (errno));
+        }
+        RunContext (Ctx, T->Name);
+
+        /* Remember the result */
+        T->Halted   = Ctx->CPUHalted;
+        T->ExitCode = Ctx->Regs.AC;
+        T->Cycles   = Ctx->TotalCycles;
+        T->Output   = Ctx->Output;
+
+        /* Free the machine */
+        SetContext (0);
+        FreeContext (Ctx);
+    }
+
+    return 0;
+}
+
+
+
+static int RunTests (void)
+/* Run all tests in TestDir on a pool of threads and print the results.
+ * Return the number of failed tests.
+ */
+{
+    pthread_t*    Threads;
+    unsigned      I;
+    unsigned      Failed = 0;
+    unsigned long Cycles = 0;
+    time_t        Start;
+    double        Seconds;
+
+    /* Read the list of tests */
+    ReadTestDir (TestDir);
+
+    /* Use one thread per CPU if not given */
+    if (Jobs == 0) {
+        long CPUs = sysconf (_SC_NPROCESSORS_ONLN);
+        Jobs = (CPUs > 0)? (unsigned) CPUs : 1;
+    }
+    if (Jobs > CollCount (&Tests)) {
+        Jobs = CollCount (&Tests);
+    }
+    Print (stderr, 1, "Running %u tests using %u threads\n",
+           CollCount (&Tests), Jobs);
+
+    /* Run the tests */
+    Start   = time (0);
+    Threads = xmalloc (Jobs * sizeof (pthread_t));
+    for (I = 0; I < Jobs; ++I) {
+        if (pthread_create (Threads + I, 0, TestWorker, 0) != 0) {
+            Error ("Cannot create thread");
+        }
+    }
+    for (I = 0; I < Jobs; ++I) {
+        pthread_join (Threads[I], 0);
+    }
+    xfree (Threads);
+    Seconds = difftime (time (0), Start);
+
+    /* Print the results. A test passes if it stopped with a BRK and a zero
+     * accumulator. The output of failed tests is shown, the output of the
+     * others only if verbose output is enabled.
+     */
+    for (I = 0; I < CollCount (&Tests); ++I) {
+
+        int C;
+        const TestRun* T = CollAt (&Tests, I);
+        int Passed = T->Halted && T->ExitCode == 0;
+
+        if (Passed) {
+            printf ("%-40s PASS %12lu cycles\n", T->Name, T->Cycles);
+        } else if (T->Halted) {
+            printf ("%-40s FAIL %12lu cycles (exit code %u)\n",
+                    T->Name, T->Cycles, T->ExitCode);
+            ++Failed;
+        } else {
+            printf ("%-40s FAIL %12lu cycles (cycle limit reached)\n",
+                    T->Name, T->Cycles);
+            ++Failed;
+        }
+        Cycles += T->Cycles;
+
+        if (!Passed || Verbosity > 0) {
+            int Last = '\n';
+            rewind (T->Output);
+            while ((C = getc (T->Output)) != EOF) {
+                putchar (Last = C);
+            }
+            if (Last != '\n') {
+                putchar ('\n');
+            }
+        }
+        fclose (T->Output);
+    }
+
+    /* Print the summary */
+    printf ("%u tests, %u passed, %u failed, %lu cycles in %.0f seconds\n",
+            CollCount (&Tests), CollCount (&Tests) - Failed, Failed,
+            Cycles, Seconds);
+
+    return Failed;
+}
+
+
+
 int main (int argc, char* argv[])
 {
     /* Program long options */
@@ -219,13 +580,24 @@ int main (int argc, char* argv[])
        	{ "--chipdir", 	       	1,     	OptChipDir    	    	},
        	{ "--config",  	       	1,     	OptConfig    	    	},
         { "--cpu",     	       	1, 	OptCPU 	     		},
+        { "--dbgfile",          1,      OptDbgFile              },
        	{ "--debug",           	0,     	OptDebug     		},
+        { "--engine",           1,      OptEngine               },
 	{ "--help", 	 	0, 	OptHelp	     		},
+        { "--jobs",             1,      OptJobs                 },
+        { "--max-cycles",       1,      OptMaxCycles            },
+        { "--profile",          1,      OptProfile              },
+        { "--testdir",          1,      OptTestDir              },
+        { "--trace",            1,      OptTrace                },
 	{ "--verbose",	       	0, 	OptVerbose   	       	},
 	{ "--version",	       	0,	OptVersion   	       	},
     };
 
-    unsigned I;
+    unsigned      I;
+    clock_t       Start;
+    double        Seconds;
+    Sim65Context* Ctx;
+    int           ExitCode;
 
     /* Initialize the output file name */
     const char* InputFile  = 0;
@@ -258,6 +630,10 @@ int main (int argc, char* argv[])
 	       	    OptHelp (Arg, 0);
 		    break;
 
+		case 'j':
+		    OptJobs (Arg, GetArg (&I, 2));
+		    break;
+
 		case 'v':
 		    OptVerbose (Arg, 0);
 		    break;
@@ -298,21 +674,67 @@ int main (int argc, char* argv[])
        	Error ("Simulator configuration missing");
     }
 
-    /* Initialize the simulated CPU memory */
+    /* Initialize the CPU core and the memory subsystem */
     MemInit ();
+    CPUInit ();
 
-    /* Read the config file */
-    CfgRead ();
+    /* Run the tests if requested */
+    if (TestDir) {
+        if (TraceFile) {
+            AbEnd ("Cannot use --trace together with --testdir");
+        }
+        if (ProfName) {
+            AbEnd ("Cannot use --profile together with --testdir");
+        }
+        if (MaxCycles == 0) {
+            MaxCycles = TEST_MAX_CYCLES;
+        }
+        return (RunTests () == 0)? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    CPUInit ();
+    /* Run the program */
+    Ctx = NewContext (Engine);
+    Ctx->TraceFile = TraceFile;
+    if (ProfName) {
+        Ctx->Profile = NewProfile ();
+    }
+    Start = clock ();
+    RunContext (Ctx, InputFile);
+
+    /* Print the simulation speed if requested */
+    Seconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+    Print (stderr, 1, "%lu cycles in %.2f seconds", Ctx->TotalCycles, Seconds);
+    if (Seconds > 0.0) {
+        Print (stderr, 1, " (%.0f cycles/sec)", Ctx->TotalCycles / Seconds);
+    }
+    Print (stderr, 1, "\n");
+    CPUPrintStats (Ctx);
 
-    while (1) {
-        CPURun ();
+    /* Write the profile */
+    if (ProfName) {
+        WriteProfile (Ctx);
+    }
+
+    /* Close the trace file */
+    if (TraceFile && fclose (TraceFile) != 0) {
+        Error ("Error closing trace file: %s", strerror (errno));
     }
 
+    /* The accumulator is the exit code of a program stopped by BRK */
+    if (Ctx->CPUHalted) {
+        ExitCode = Ctx->Regs.AC;
+    } else {
+        Warning ("Cycle limit reached");
+        ExitCode = EXIT_FAILURE;
+    }
+    FreeContext (Ctx);
+
     /* Return an apropriate exit code */
-    return EXIT_SUCCESS;
+    return ExitCode;
 }
 
 
 
+
+
+
@@ -13,9 +13,9 @@ COMMON	= ../common
 #
 CC	= gcc
 CFLAGS 	= -g -O2 -Wall -W -std=c89
-override CFLAGS += -I$(COMMON)
+override CFLAGS += -I$(COMMON) -pthread
 EBIND	= emxbind
-LDFLAGS	=
+LDFLAGS	= -pthread
 
 
 # -----------------------------------------------------------------------------
@@ -27,13 +27,16 @@ OBJS = 	addrspace.o     \
 	chip.o          \
 	chippath.o      \
 	config.o        \
+	context.o       \
 	cpucore.o     	\
 	cputype.o     	\
+	dbginfo.o       \
 	error.o         \
 	global.o      	\
 	location.o      \
 	main.o          \
 	memory.o        \
+	profile.o       \
 	scanner.o       \
 	system.o
 
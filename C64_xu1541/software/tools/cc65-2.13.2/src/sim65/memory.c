@@ -45,6 +45,7 @@
 #include "chip.h"
 #include "cputype.h"
 #include "error.h"
+#include "global.h"
 #include "memory.h"
 
 
@@ -55,9 +56,55 @@
 
 
 
-/* Pointer to our memory */
-static const ChipInstance** MemData = 0;
-unsigned MemSize                    = 0;
+/* Memory size of the CPU */
+unsigned MemSize = 0;
+
+
+
+/*****************************************************************************/
+/*                               Helper functions                            */
+/*****************************************************************************/
+
+
+
+static void MemUpdatePage (Sim65Context* Ctx, unsigned Page)
+/* Update the memory map entry for one page */
+{
+    unsigned      I;
+    unsigned      Addr = Page << MEM_PAGE_SHIFT;
+    MemPage*      P    = Ctx->MemMap + Page;
+
+    /* Get the chip at the start of the page */
+    const ChipInstance* CI = Ctx->MemData[Addr];
+
+    /* Assume the page needs the chip callbacks */
+    P->ReadPtr  = 0;
+    P->WritePtr = 0;
+
+    /* In debug mode, all accesses go through the chips, so they are able to
+     * check them.
+     */
+    if (Debug || CI == 0) {
+        return;
+    }
+
+    /* The complete page must be covered by the same chip instance */
+    for (I = 1; I < MEM_PAGE_SIZE; ++I) {
+        if (Ctx->MemData[Addr+I] != CI) {
+            return;
+        }
+    }
+
+    /* Ask the chip for direct access to its memory */
+    P->ReadPtr  = ChipGetReadPtr (CI);
+    P->WritePtr = ChipGetWritePtr (CI);
+    if (P->ReadPtr) {
+        P->ReadPtr += Addr - CI->Addr;
+    }
+    if (P->WritePtr) {
+        P->WritePtr += Addr - CI->Addr;
+    }
+}
 
 
 
@@ -67,11 +114,11 @@ unsigned MemSize                    = 0;
 
 
 
-void MemWriteByte (unsigned Addr, unsigned char Val)
+void MemWriteByte (Sim65Context* Ctx, unsigned Addr, unsigned char Val)
 /* Write a byte to a memory location */
 {
     /* Get the instance of the chip at this address */
-    const ChipInstance* CI = MemData[Addr];
+    const ChipInstance* CI = Ctx->MemData[Addr];
 
     /* Check if the memory is mapped */
     if (CI == 0) {
@@ -83,11 +130,11 @@ void MemWriteByte (unsigned Addr, unsigned char Val)
 
 
 
-unsigned char MemReadByte (unsigned Addr)
+unsigned char MemReadByte (Sim65Context* Ctx, unsigned Addr)
 /* Read a byte from a memory location */
 {
     /* Get the instance of the chip at this address */
-    const ChipInstance* CI = MemData[Addr];
+    const ChipInstance* CI = Ctx->MemData[Addr];
 
     /* Check if the memory is mapped */
     if (CI == 0) {
@@ -100,50 +147,88 @@ unsigned char MemReadByte (unsigned Addr)
 
 
 
-unsigned MemReadWord (unsigned Addr)
+unsigned MemReadWord (Sim65Context* Ctx, unsigned Addr)
 /* Read a word from a memory location */
 {
-    unsigned W = MemReadByte (Addr++);
-    return (W | (MemReadByte (Addr) << 8));
+    unsigned W = MemReadByte (Ctx, Addr++);
+    return (W | (MemReadByte (Ctx, Addr) << 8));
 }
 
 
 
-unsigned MemReadZPWord (unsigned char Addr)
+unsigned MemReadZPWord (Sim65Context* Ctx, unsigned char Addr)
 /* Read a word from the zero page. This function differs from ReadMemW in that
  * the read will always be in the zero page, even in case of an address
  * overflow.
  */
 {
-    unsigned W = MemReadByte (Addr++);
-    return (W | (MemReadByte (Addr) << 8));
+    unsigned W = MemReadByte (Ctx, Addr++);
+    return (W | (MemReadByte (Ctx, Addr) << 8));
 }
 
 
 
-void MemAssignChip (const ChipInstance* CI, unsigned Addr, unsigned Range)
+void MemAssignChip (Sim65Context* Ctx, const ChipInstance* CI,
+                    unsigned Addr, unsigned Range)
 /* Assign a chip instance to memory locations */
 {
+    unsigned Page;
+    unsigned LastPage;
+
     /* Make sure, the addresses are in a valid range */
     PRECONDITION (Addr + Range <= MemSize);
 
+    /* Nothing to do for an empty range */
+    if (Range == 0) {
+        return;
+    }
+
+    /* Remember the pages touched */
+    Page     = Addr >> MEM_PAGE_SHIFT;
+    LastPage = (Addr + Range - 1) >> MEM_PAGE_SHIFT;
+
     /* Assign the chip instance */
     while (Range--) {
-        CHECK (MemData[Addr] == 0);
-        MemData[Addr++] = CI;
+        CHECK (Ctx->MemData[Addr] == 0);
+        Ctx->MemData[Addr++] = CI;
+    }
+
+    /* Update the memory map for the pages touched */
+    while (Page <= LastPage) {
+        MemUpdatePage (Ctx, Page++);
     }
 }
 
 
 
-const struct ChipInstance* MemGetChip (unsigned Addr)
+const struct ChipInstance* MemGetChip (const Sim65Context* Ctx, unsigned Addr)
 /* Get the chip that is located at the given address (may return NULL). */
 {
     /* Make sure, the address is valid */
     PRECONDITION (Addr < MemSize);
 
     /* Return the chip instance */
-    return MemData[Addr];
+    return Ctx->MemData[Addr];
+}
+
+
+
+void MemTrapPage (Sim65Context* Ctx, unsigned Page)
+/* Disable direct write access for a page, so all writes to the page go
+ * through MemWriteByte.
+ */
+{
+    PRECONDITION (Page < (MemSize >> MEM_PAGE_SHIFT));
+    Ctx->MemMap[Page].WritePtr = 0;
+}
+
+
+
+void MemUntrapPage (Sim65Context* Ctx, unsigned Page)
+/* Reenable direct write access for a page if the chip allows it */
+{
+    PRECONDITION (Page < (MemSize >> MEM_PAGE_SHIFT));
+    MemUpdatePage (Ctx, Page);
 }
 
 
@@ -151,9 +236,7 @@ const struct ChipInstance* MemGetChip (unsigned Addr)
 void MemInit (void)
 /* Initialize the memory subsystem */
 {
-    unsigned I;
-
-    /* Allocate memory depending on the CPU type */
+    /* Determine the memory size depending on the CPU type */
     switch (CPU) {
         case CPU_6502:
         case CPU_65C02:
@@ -162,13 +245,39 @@ void MemInit (void)
         default:
             Internal ("Unexpected CPU type: %d", CPU);
     }
-    MemData = xmalloc (MemSize * sizeof (ChipInstance*));
+}
 
-    /* Clear the memory */
+
+
+void MemInitContext (Sim65Context* Ctx)
+/* Allocate and clear the memory of a context */
+{
+    unsigned I;
+
+    /* Allocate the memory and clear it */
+    Ctx->MemData = xmalloc (MemSize * sizeof (ChipInstance*));
     for (I = 0; I < MemSize; ++I) {
-        MemData[I] = 0;
+        Ctx->MemData[I] = 0;
+    }
+
+    /* Allocate the memory map including the guard page and clear it */
+    Ctx->MemMap = xmalloc (((MemSize >> MEM_PAGE_SHIFT) + 1) * sizeof (MemPage));
+    for (I = 0; I <= (MemSize >> MEM_PAGE_SHIFT); ++I) {
+        Ctx->MemMap[I].ReadPtr  = 0;
+        Ctx->MemMap[I].WritePtr = 0;
     }
 }
 
 
 
+void MemDoneContext (Sim65Context* Ctx)
+/* Free the memory of a context */
+{
+    xfree (Ctx->MemData);
+    xfree (Ctx->MemMap);
+    Ctx->MemData = 0;
+    Ctx->MemMap  = 0;
+}
+
+
+
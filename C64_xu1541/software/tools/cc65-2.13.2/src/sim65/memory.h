@@ -38,6 +38,11 @@
 
 
 
+/* sim65 */
+#include "context.h"
+
+
+
 /*****************************************************************************/
 /*  		    		     Data				     */
 /*****************************************************************************/
@@ -50,6 +55,25 @@ struct ChipInstance;
 /* Memory size of the CPU */
 extern unsigned MemSize;
 
+/* Page granular memory map. Pages that are completely covered by a chip
+ * allowing direct access to its memory point into the chip memory, so the
+ * CPU core can access them without calling the chip. All other pages have
+ * NULL pointers and must be accessed with MemReadByte/MemWriteByte. Each
+ * context has its own map with one more entry than the memory has pages, so
+ * the CPU core may index it with addresses that overflow the memory by less
+ * than a page (for example abs,x addressing near the end of the address
+ * space).
+ */
+#define MEM_PAGE_SHIFT  8
+#define MEM_PAGE_SIZE   (1U << MEM_PAGE_SHIFT)
+#define MEM_PAGE_MASK   (MEM_PAGE_SIZE - 1)
+
+typedef struct MemPage MemPage;
+struct MemPage {
+    unsigned char*      ReadPtr;        /* Direct read access or NULL */
+    unsigned char*      WritePtr;       /* Direct write access or NULL */
+};
+
 
 
 /*****************************************************************************/
@@ -58,30 +82,45 @@ extern unsigned MemSize;
 
 
 
-void MemWriteByte (unsigned Addr, unsigned char Val);
+void MemWriteByte (Sim65Context* Ctx, unsigned Addr, unsigned char Val);
 /* Write a byte to a memory location */
 
-unsigned char MemReadByte (unsigned Addr);
+unsigned char MemReadByte (Sim65Context* Ctx, unsigned Addr);
 /* Read a byte from a memory location */
 
-unsigned MemReadWord (unsigned Addr);
+unsigned MemReadWord (Sim65Context* Ctx, unsigned Addr);
 /* Read a word from a memory location */
 
-unsigned MemReadZPWord (unsigned char Addr);
+unsigned MemReadZPWord (Sim65Context* Ctx, unsigned char Addr);
 /* Read a word from the zero page. This function differs from ReadMemW in that
  * the read will always be in the zero page, even in case of an address
  * overflow.
  */
 
-void MemAssignChip (const struct ChipInstance* CI, unsigned Addr, unsigned Range);
+void MemAssignChip (Sim65Context* Ctx, const struct ChipInstance* CI,
+                    unsigned Addr, unsigned Range);
 /* Assign a chip instance to memory locations */
 
-const struct ChipInstance* MemGetChip (unsigned Addr);
+const struct ChipInstance* MemGetChip (const Sim65Context* Ctx, unsigned Addr);
 /* Get the chip that is located at the given address (may return NULL). */
 
+void MemTrapPage (Sim65Context* Ctx, unsigned Page);
+/* Disable direct write access for a page, so all writes to the page go
+ * through MemWriteByte.
+ */
+
+void MemUntrapPage (Sim65Context* Ctx, unsigned Page);
+/* Reenable direct write access for a page if the chip allows it */
+
 void MemInit (void);
 /* Initialize the memory subsystem */
 
+void MemInitContext (Sim65Context* Ctx);
+/* Allocate and clear the memory of a context */
+
+void MemDoneContext (Sim65Context* Ctx);
+/* Free the memory of a context */
+
 
 
 /* End of memory.h */
@@ -0,0 +1,774 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 profile.c                                 */
+/*                                                                           */
+/*                 Execution profiler for the 6502 simulator                 */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* common */
+#include "xmalloc.h"
+#include "xsprintf.h"
+
+/* sim65 */
+#include "memory.h"
+#include "profile.h"
+
+
+
+/*****************************************************************************/
+/*                                     Data                                  */
+/*****************************************************************************/
+
+
+
+/* Maximum call depth that is tracked */
+#define MAX_FRAMES      256
+
+/* Size of the call edge hash table */
+#define EDGE_HASH_SIZE  1024
+
+/* Maximum number of lines and instructions in the report */
+#define REPORT_LIMIT    100
+
+/* Calls from one function to another */
+typedef struct CallEdge CallEdge;
+struct CallEdge {
+    CallEdge*           Next;           /* Next edge in hash chain */
+    unsigned            Caller;         /* Calling function or call site */
+    unsigned            Callee;         /* Called address */
+    int                 Interrupt;      /* Edge is an interrupt */
+    unsigned long       Calls;          /* Number of calls */
+    unsigned long       Cycles;         /* Inclusive cycles of the callee */
+};
+
+/* An active call */
+typedef struct Frame Frame;
+struct Frame {
+    CallEdge*           Edge;           /* Edge of this call */
+    unsigned            Ret;            /* Expected return address */
+    int                 Recursive;      /* Callee already active */
+    unsigned long       Start;          /* Cycles when called */
+};
+
+/* Profile data of a context */
+struct Profile {
+    unsigned            Size;           /* Size of the arrays */
+    unsigned long*      Count;          /* Executions by address */
+    unsigned long*      Cycles;         /* Cycles by address */
+    unsigned long       IntCycles;      /* Cycles used for interrupt entry */
+    unsigned long       Dropped;        /* Calls not tracked (stack full) */
+    unsigned            Depth;          /* Number of active calls */
+    Frame               Frames[MAX_FRAMES];
+    unsigned            EdgeCount;      /* Number of call edges */
+    CallEdge*           Edges[EDGE_HASH_SIZE];
+};
+
+/* Summary of a function used for the report */
+typedef struct FuncInfo FuncInfo;
+struct FuncInfo {
+    unsigned            Addr;           /* Entry address */
+    const char*         Name;           /* Label or NULL */
+    unsigned long       Insns;          /* Instructions executed */
+    unsigned long       Cycles;         /* Cycles used, excluding callees */
+    unsigned long       Calls;          /* Number of calls */
+    unsigned long       Incl;           /* Cycles used including callees */
+};
+
+/* Summary of a source line used for the report */
+typedef struct LineSum LineSum;
+struct LineSum {
+    const char*         File;           /* File name */
+    unsigned long       Line;           /* Line number */
+    unsigned long       Insns;          /* Instructions executed */
+    unsigned long       Cycles;         /* Cycles used */
+};
+
+
+
+/*****************************************************************************/
+/*                              Call tracking                                */
+/*****************************************************************************/
+
+
+
+static CallEdge* GetEdge (Profile* P, unsigned Caller, unsigned Callee,
+                          int Interrupt)
+/* Return the edge for a call, creating it if necessary */
+{
+    unsigned  Hash = (Caller * 31 + Callee) % EDGE_HASH_SIZE;
+    CallEdge* E    = P->Edges[Hash];
+
+    while (E) {
+        if (E->Caller == Caller && E->Callee == Callee) {
+            return E;
+        }
+        E = E->Next;
+    }
+
+    /* Not found, create a new edge */
+    E = xmalloc (sizeof (CallEdge));
+    E->Caller    = Caller;
+    E->Callee    = Callee;
+    E->Interrupt = Interrupt;
+    E->Calls     = 0;
+    E->Cycles    = 0;
+    E->Next      = P->Edges[Hash];
+    P->Edges[Hash] = E;
+    ++P->EdgeCount;
+    return E;
+}
+
+
+
+static void PushFrame (Profile* P, unsigned Site, unsigned Callee,
+                       unsigned Ret, unsigned long Start, int Interrupt)
+/* Enter a function or interrupt handler called from address Site */
+{
+    unsigned  Caller;
+    CallEdge* E;
+    Frame*    F;
+    unsigned  I;
+
+    /* The caller is the function entered by the innermost active call. If
+     * there is none, use the call site, which is mapped to a function when
+     * writing the report.
+     */
+    Caller = P->Depth? P->Frames[P->Depth-1].Edge->Callee : Site;
+
+    /* Count the call */
+    E = GetEdge (P, Caller, Callee, Interrupt);
+    ++E->Calls;
+
+    /* Remember the call, so the time spent can be accounted on return */
+    if (P->Depth >= MAX_FRAMES) {
+        ++P->Dropped;
+        return;
+    }
+    F = &P->Frames[P->Depth++];
+    F->Edge      = E;
+    F->Ret       = Ret;
+    F->Start     = Start;
+    F->Recursive = 0;
+
+    /* The cycles of recursive calls are already contained in the outermost
+     * one, so don't count them twice.
+     */
+    for (I = 0; I < P->Depth - 1; ++I) {
+        if (P->Frames[I].Edge->Callee == Callee) {
+            F->Recursive = 1;
+            break;
+        }
+    }
+}
+
+
+
+static void PopFrames (Profile* P, unsigned Depth, unsigned long Now)
+/* Leave all active calls down to the given depth */
+{
+    while (P->Depth > Depth) {
+        const Frame* F = &P->Frames[--P->Depth];
+        if (!F->Recursive) {
+            F->Edge->Cycles += Now - F->Start;
+        }
+    }
+}
+
+
+
+static void ReturnTo (Profile* P, unsigned PC, unsigned long Now)
+/* Handle a return to PC. Code that manipulates the stack may skip levels,
+ * so the innermost call returning to PC is searched, and all calls above
+ * are left. Returns that don't match any call (for example RTS used as an
+ * indirect jump) are ignored.
+ */
+{
+    unsigned I = P->Depth;
+    while (I > 0) {
+        --I;
+        if (P->Frames[I].Ret == PC) {
+            PopFrames (P, I, Now);
+            return;
+        }
+    }
+}
+
+
+
+/*****************************************************************************/
+/*                                  Report                                   */
+/*****************************************************************************/
+
+
+
+static int CmpFuncAddr (const void* Left, const void* Right)
+/* Compare functions by address */
+{
+    const FuncInfo* L = Left;
+    const FuncInfo* R = Right;
+    return (L->Addr < R->Addr)? -1 : (L->Addr > R->Addr);
+}
+
+
+
+static int CmpFuncCycles (const void* Left, const void* Right)
+/* Compare functions by self cycles, descending */
+{
+    const FuncInfo* L = Left;
+    const FuncInfo* R = Right;
+    if (L->Cycles != R->Cycles) {
+        return (L->Cycles > R->Cycles)? -1 : 1;
+    }
+    return CmpFuncAddr (Left, Right);
+}
+
+
+
+static int CmpLinePos (const void* Left, const void* Right)
+/* Compare line summaries by file and line */
+{
+    const LineSum* L = Left;
+    const LineSum* R = Right;
+    int Res = strcmp (L->File, R->File);
+    if (Res == 0 && L->Line != R->Line) {
+        Res = (L->Line < R->Line)? -1 : 1;
+    }
+    return Res;
+}
+
+
+
+static int CmpLineCycles (const void* Left, const void* Right)
+/* Compare line summaries by cycles, descending */
+{
+    const LineSum* L = Left;
+    const LineSum* R = Right;
+    if (L->Cycles != R->Cycles) {
+        return (L->Cycles > R->Cycles)? -1 : 1;
+    }
+    return CmpLinePos (Left, Right);
+}
+
+
+
+static int CmpEdgeAddr (const void* Left, const void* Right)
+/* Compare call edges by caller and callee */
+{
+    const CallEdge* L = Left;
+    const CallEdge* R = Right;
+    if (L->Caller != R->Caller) {
+        return (L->Caller < R->Caller)? -1 : 1;
+    }
+    return (L->Callee < R->Callee)? -1 : (L->Callee > R->Callee);
+}
+
+
+
+static int CmpEdgeCycles (const void* Left, const void* Right)
+/* Compare call edges by inclusive cycles, descending */
+{
+    const CallEdge* L = Left;
+    const CallEdge* R = Right;
+    if (L->Cycles != R->Cycles) {
+        return (L->Cycles > R->Cycles)? -1 : 1;
+    }
+    if (L->Calls != R->Calls) {
+        return (L->Calls > R->Calls)? -1 : 1;
+    }
+    return CmpEdgeAddr (Left, Right);
+}
+
+
+
+static FuncInfo* FindFunc (FuncInfo* Funcs, unsigned Count, unsigned Addr)
+/* Return the function containing Addr. Funcs must be sorted by address and
+ * start at address zero.
+ */
+{
+    unsigned Lo = 0;
+    unsigned Hi = Count;
+    while (Hi - Lo > 1) {
+        unsigned Cur = (Lo + Hi) / 2;
+        if (Funcs[Cur].Addr <= Addr) {
+            Lo = Cur;
+        } else {
+            Hi = Cur;
+        }
+    }
+    return Funcs + Lo;
+}
+
+
+
+static const char* AddrName (char* Buf, size_t Size, FuncInfo* Funcs,
+                             unsigned Count, unsigned Addr)
+/* Format an address as "label+offset" if possible */
+{
+    const FuncInfo* F = FindFunc (Funcs, Count, Addr);
+    if (F->Name == 0 && (F->Addr == Addr || F == Funcs)) {
+        xsprintf (Buf, Size, "$%04X", Addr);
+    } else if (F->Name == 0) {
+        xsprintf (Buf, Size, "$%04X+%u", F->Addr, Addr - F->Addr);
+    } else if (F->Addr == Addr) {
+        xsprintf (Buf, Size, "%s", F->Name);
+    } else {
+        xsprintf (Buf, Size, "%s+%u", F->Name, Addr - F->Addr);
+    }
+    return Buf;
+}
+
+
+
+static double Percent (unsigned long Part, unsigned long Total)
+/* Return Part as percentage of Total */
+{
+    return Total? (100.0 * Part) / Total : 0.0;
+}
+
+
+
+static CallEdge* CollectEdges (const Profile* P)
+/* Return an array with copies of all call edges */
+{
+    CallEdge* Edges = xmalloc ((P->EdgeCount + 1) * sizeof (CallEdge));
+    unsigned  N     = 0;
+    unsigned  I;
+
+    for (I = 0; I < EDGE_HASH_SIZE; ++I) {
+        const CallEdge* E = P->Edges[I];
+        while (E) {
+            Edges[N++] = *E;
+            E = E->Next;
+        }
+    }
+    return Edges;
+}
+
+
+
+static unsigned MergeEdges (CallEdge* Edges, unsigned N,
+                            FuncInfo* Funcs, unsigned Count)
+/* Replace call sites by the functions containing them and merge the edges
+ * that are the same afterwards. Return the new number of edges.
+ */
+{
+    unsigned I, J;
+
+    if (N == 0) {
+        return 0;
+    }
+
+    /* Map the callers. Addresses outside of any known function are kept. */
+    for (I = 0; I < N; ++I) {
+        const FuncInfo* F = FindFunc (Funcs, Count, Edges[I].Caller);
+        if (F->Name || F != Funcs) {
+            Edges[I].Caller = F->Addr;
+        }
+    }
+
+    /* Merge duplicates */
+    qsort (Edges, N, sizeof (CallEdge), CmpEdgeAddr);
+    J = 0;
+    for (I = 1; I < N; ++I) {
+        if (CmpEdgeAddr (Edges + I, Edges + J) == 0) {
+            Edges[J].Calls  += Edges[I].Calls;
+            Edges[J].Cycles += Edges[I].Cycles;
+        } else {
+            Edges[++J] = Edges[I];
+        }
+    }
+    return J + 1;
+}
+
+
+
+static FuncInfo* CollectFuncs (const Profile* P, const DbgInfo* D,
+                               const CallEdge* Edges, unsigned* Count)
+/* Build the function table sorted by address. The labels from the debug
+ * info are used if available, the call targets otherwise. The first entry
+ * always starts at address zero and collects code outside of any function.
+ */
+{
+    FuncInfo* Funcs;
+    unsigned  Max;
+    unsigned  N = 0;
+    unsigned  I;
+
+    Max   = (D? CollCount (&D->Syms) : P->EdgeCount) + 1;
+    Funcs = xmalloc (Max * sizeof (FuncInfo));
+    memset (Funcs, 0, Max * sizeof (FuncInfo));
+
+    if (D) {
+        /* Symbols are sorted, use the first one of several at an address */
+        for (I = 0; I < CollCount (&D->Syms); ++I) {
+            const DbgSym* S = CollConstAt (&D->Syms, I);
+            if (N == 0 || Funcs[N-1].Addr != S->Value) {
+                Funcs[N].Addr = S->Value;
+                Funcs[N].Name = S->Name;
+                ++N;
+            }
+        }
+    } else {
+        for (I = 0; I < P->EdgeCount; ++I) {
+            Funcs[N++].Addr = Edges[I].Callee;
+        }
+        qsort (Funcs, N, sizeof (FuncInfo), CmpFuncAddr);
+        if (N > 0) {
+            /* Remove duplicates */
+            unsigned J = 0;
+            for (I = 1; I < N; ++I) {
+                if (Funcs[I].Addr != Funcs[J].Addr) {
+                    Funcs[++J] = Funcs[I];
+                }
+            }
+            N = J + 1;
+        }
+    }
+
+    /* Make sure there is an entry at address zero */
+    if (N == 0 || Funcs[0].Addr != 0) {
+        memmove (Funcs + 1, Funcs, N * sizeof (FuncInfo));
+        memset (Funcs, 0, sizeof (FuncInfo));
+        ++N;
+    }
+
+    /* Add the execution counts */
+    for (I = 0; I < P->Size; ++I) {
+        if (P->Count[I]) {
+            FuncInfo* F = FindFunc (Funcs, N, I);
+            F->Insns  += P->Count[I];
+            F->Cycles += P->Cycles[I];
+        }
+    }
+
+    /* Add the calls */
+    for (I = 0; I < P->EdgeCount; ++I) {
+        FuncInfo* F = FindFunc (Funcs, N, Edges[I].Callee);
+        F->Calls += Edges[I].Calls;
+        F->Incl  += Edges[I].Cycles;
+    }
+
+    /* Return the table */
+    *Count = N;
+    return Funcs;
+}
+
+
+
+static void ReportLines (const Profile* P, const DbgInfo* D,
+                         unsigned long Total, FILE* F)
+/* Print the source lines using the most cycles */
+{
+    LineSum* Lines = xmalloc (P->Size * sizeof (LineSum));
+    unsigned  N     = 0;
+    unsigned  I, J;
+
+    /* Collect the line of each address executed */
+    for (I = 0; I < P->Size; ++I) {
+        if (P->Count[I]) {
+            const DbgLine* L = DbgFindLine (D, I);
+            if (L) {
+                Lines[N].File   = L->File;
+                Lines[N].Line   = L->Line;
+                Lines[N].Insns  = P->Count[I];
+                Lines[N].Cycles = P->Cycles[I];
+                ++N;
+            }
+        }
+    }
+
+    /* Merge entries for the same line */
+    if (N > 0) {
+        qsort (Lines, N, sizeof (LineSum), CmpLinePos);
+        J = 0;
+        for (I = 1; I < N; ++I) {
+            if (CmpLinePos (Lines + I, Lines + J) == 0) {
+                Lines[J].Insns  += Lines[I].Insns;
+                Lines[J].Cycles += Lines[I].Cycles;
+            } else {
+                Lines[++J] = Lines[I];
+            }
+        }
+        N = J + 1;
+        qsort (Lines, N, sizeof (LineSum), CmpLineCycles);
+    }
+
+    /* Print them */
+    fprintf (F, "\nSource lines by cycles:\n\n"
+                "      Cycles       %%         Insns  File(Line)\n");
+    for (I = 0; I < N && I < REPORT_LIMIT; ++I) {
+        fprintf (F, "%12lu  %6.2f  %12lu  %s(%lu)\n",
+                 Lines[I].Cycles, Percent (Lines[I].Cycles, Total),
+                 Lines[I].Insns, Lines[I].File, Lines[I].Line);
+    }
+
+    xfree (Lines);
+}
+
+
+
+static void ReportInsns (const Profile* P, FuncInfo* Funcs, unsigned Count,
+                         unsigned long Total, FILE* F)
+/* Print the instructions using the most cycles */
+{
+    unsigned* Addrs = xmalloc (REPORT_LIMIT * sizeof (unsigned));
+    unsigned  N     = 0;
+    unsigned  I, J;
+    char      Buf[256];
+
+    /* Keep the addresses with the most cycles using insertion sort, which
+     * is fast enough for the small number of entries.
+     */
+    for (I = 0; I < P->Size; ++I) {
+        if (P->Count[I] == 0) {
+            continue;
+        }
+        if (N == REPORT_LIMIT) {
+            if (P->Cycles[I] <= P->Cycles[Addrs[N-1]]) {
+                continue;
+            }
+            --N;
+        }
+        J = N++;
+        while (J > 0 && P->Cycles[Addrs[J-1]] < P->Cycles[I]) {
+            Addrs[J] = Addrs[J-1];
+            --J;
+        }
+        Addrs[J] = I;
+    }
+
+    /* The average number of cycles shows page crossing penalties and taken
+     * branches.
+     */
+    fprintf (F, "\nInstructions by cycles:\n\n"
+                "      Cycles       %%         Count  Cyc/Insn  Address  Label\n");
+    for (I = 0; I < N; ++I) {
+        unsigned A = Addrs[I];
+        fprintf (F, "%12lu  %6.2f  %12lu  %8.2f  $%04X    %s\n",
+                 P->Cycles[A], Percent (P->Cycles[A], Total), P->Count[A],
+                 (double) P->Cycles[A] / P->Count[A], A,
+                 AddrName (Buf, sizeof (Buf), Funcs, Count, A));
+    }
+
+    xfree (Addrs);
+}
+
+
+
+/*****************************************************************************/
+/*                                     Code                                  */
+/*****************************************************************************/
+
+
+
+Profile* NewProfile (void)
+/* Create new, empty profile data */
+{
+    /* Allocate memory */
+    Profile* P = xmalloc (sizeof (Profile));
+
+    /* Initialize the fields */
+    P->Size      = MemSize;
+    P->Count     = xmalloc (MemSize * sizeof (unsigned long));
+    P->Cycles    = xmalloc (MemSize * sizeof (unsigned long));
+    P->IntCycles = 0;
+    P->Dropped   = 0;
+    P->Depth     = 0;
+    P->EdgeCount = 0;
+    memset (P->Count, 0, MemSize * sizeof (unsigned long));
+    memset (P->Cycles, 0, MemSize * sizeof (unsigned long));
+    memset (P->Edges, 0, sizeof (P->Edges));
+
+    /* Return the new struct */
+    return P;
+}
+
+
+
+void FreeProfile (Profile* P)
+/* Free profile data */
+{
+    unsigned I;
+
+    if (P == 0) {
+        return;
+    }
+    for (I = 0; I < EDGE_HASH_SIZE; ++I) {
+        CallEdge* E = P->Edges[I];
+        while (E) {
+            CallEdge* Next = E->Next;
+            xfree (E);
+            E = Next;
+        }
+    }
+    xfree (P->Count);
+    xfree (P->Cycles);
+    xfree (P);
+}
+
+
+
+void ProfileInsn (Sim65Context* Ctx, unsigned PC, unsigned char OPC)
+/* Account for an instruction with the given opcode that was executed at PC.
+ * Must be called after the instruction, so Ctx->Cycles contains the cycles
+ * used including any page crossing penalties. JSR/RTS and RTI are used to
+ * track calls and interrupt handlers.
+ */
+{
+    Profile* P = Ctx->Profile;
+
+    if (PC < P->Size) {
+        ++P->Count[PC];
+        P->Cycles[PC] += Ctx->Cycles;
+    }
+
+    switch (OPC) {
+
+        case 0x20:
+            /* JSR pushes the address of its last byte */
+            PushFrame (P, PC, Ctx->Regs.PC, PC + 3, Ctx->TotalCycles, 0);
+            break;
+
+        case 0x40:
+        case 0x60:
+            /* RTI and RTS */
+            ReturnTo (P, Ctx->Regs.PC, Ctx->TotalCycles);
+            break;
+
+    }
+}
+
+
+
+void ProfileInterrupt (Sim65Context* Ctx, unsigned RetPC)
+/* Account for an interrupt that was taken while the CPU was at RetPC. Must
+ * be called after the CPU has loaded the vector.
+ */
+{
+    Profile* P = Ctx->Profile;
+
+    /* The cycles of the interrupt sequence belong to the handler */
+    P->IntCycles += Ctx->Cycles;
+    PushFrame (P, RetPC, Ctx->Regs.PC, RetPC, Ctx->TotalCycles - Ctx->Cycles, 1);
+}
+
+
+
+void ProfileReport (Sim65Context* Ctx, const DbgInfo* D, FILE* F)
+/* Write the profile of a context to F. If D is not NULL, addresses are
+ * mapped to labels and source lines, otherwise call targets are used as
+ * function names.
+ */
+{
+    Profile*       P = Ctx->Profile;
+    CallEdge*      Edges;
+    unsigned       EdgeCount;
+    FuncInfo*      Funcs;
+    unsigned       Count;
+    unsigned long  Insns;
+    unsigned long  Total;
+    unsigned       I;
+    char           Buf1[256];
+    char           Buf2[256];
+
+    /* Account for calls still active, so main and friends show up */
+    PopFrames (P, 0, Ctx->TotalCycles);
+
+    /* Get the totals */
+    Insns = 0;
+    Total = P->IntCycles;
+    for (I = 0; I < P->Size; ++I) {
+        Insns += P->Count[I];
+        Total += P->Cycles[I];
+    }
+
+    /* Build the tables */
+    Edges = CollectEdges (P);
+    Funcs = CollectFuncs (P, D, Edges, &Count);
+
+    /* Summary */
+    fprintf (F, "%lu cycles, %lu instructions, %lu cycles in interrupt entry\n",
+             Total, Insns, P->IntCycles);
+    if (P->Dropped) {
+        fprintf (F, "%lu calls not tracked because of call depth\n",
+                 P->Dropped);
+    }
+
+    /* Functions */
+    qsort (Funcs, Count, sizeof (FuncInfo), CmpFuncCycles);
+    fprintf (F, "\nFunctions by self cycles:\n\n"
+                "      Cycles       %%         Insns       Calls   Incl.Cycles       %%  Function\n");
+    for (I = 0; I < Count; ++I) {
+        const FuncInfo* Func = Funcs + I;
+        if (Func->Insns == 0 && Func->Calls == 0) {
+            continue;
+        }
+        if (Func->Name) {
+            xsprintf (Buf1, sizeof (Buf1), "%s", Func->Name);
+        } else if (Func->Addr == 0 && Func->Calls == 0) {
+            xsprintf (Buf1, sizeof (Buf1), "<other>");
+        } else {
+            xsprintf (Buf1, sizeof (Buf1), "$%04X", Func->Addr);
+        }
+        fprintf (F, "%12lu  %6.2f  %12lu  %10lu  %12lu  %6.2f  %s\n",
+                 Func->Cycles, Percent (Func->Cycles, Total), Func->Insns,
+                 Func->Calls, Func->Incl, Percent (Func->Incl, Total), Buf1);
+    }
+    qsort (Funcs, Count, sizeof (FuncInfo), CmpFuncAddr);
+
+    /* Source lines */
+    if (D && CollCount (&D->Lines) > 0) {
+        ReportLines (P, D, Total, F);
+    }
+
+    /* Instructions */
+    ReportInsns (P, Funcs, Count, Total, F);
+
+    /* Call graph */
+    EdgeCount = MergeEdges (Edges, P->EdgeCount, Funcs, Count);
+    qsort (Edges, EdgeCount, sizeof (CallEdge), CmpEdgeCycles);
+    fprintf (F, "\nCall graph by inclusive cycles:\n\n"
+                "       Calls   Incl.Cycles       %%  Caller -> Callee\n");
+    for (I = 0; I < EdgeCount; ++I) {
+        const CallEdge* E = Edges + I;
+        fprintf (F, "%12lu  %12lu  %6.2f  %s -> %s%s\n",
+                 E->Calls, E->Cycles, Percent (E->Cycles, Total),
+                 AddrName (Buf1, sizeof (Buf1), Funcs, Count, E->Caller),
+                 AddrName (Buf2, sizeof (Buf2), Funcs, Count, E->Callee),
+                 E->Interrupt? " (interrupt)" : "");
+    }
+
+    /* Cleanup */
+    xfree (Funcs);
+    xfree (Edges);
+}
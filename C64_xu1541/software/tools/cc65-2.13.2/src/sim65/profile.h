@@ -0,0 +1,95 @@
+/*****************************************************************************/
+/*                                                                           */
+/*                                 profile.h                                 */
+/*                                                                           */
+/*                 Execution profiler for the 6502 simulator                 */
+/*                                                                           */
+/*                                                                           */
+/*                                                                           */
+/* (C) 2026,     agent                                                       */
+/* EMail:        agent@local                                                 */
+/*                                                                           */
+/*                                                                           */
+/* This software is provided 'as-is', without any expressed or implied       */
+/* warranty.  In no event will the authors be held liable for any damages    */
+/* arising from the use of this software.                                    */
+/*                                                                           */
+/* Permission is granted to anyone to use this software for any purpose,     */
+/* including commercial applications, and to alter it and redistribute it    */
+/* freely, subject to the following restrictions:                            */
+/*                                                                           */
+/* 1. The origin of this software must not be misrepresented; you must not   */
+/*    claim that you wrote the original software. If you use this software   */
+/*    in a product, an acknowledgment in the product documentation would be  */
+/*    appreciated but is not required.                                       */
+/* 2. Altered source versions must be plainly marked as such, and must not   */
+/*    be misrepresented as being the original software.                      */
+/* 3. This notice may not be removed or altered from any source              */
+/*    distribution.                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+
+
+#include <stdio.h>
+
+/* sim65 */
+#include "context.h"
+#include "dbginfo.h"
+
+
+
+/*****************************************************************************/
+/*                                     Data                                  */
+/*****************************************************************************/
+
+
+
+/* Opaque profile data */
+typedef struct Profile Profile;
+
+
+
+/*****************************************************************************/
+/*                                     Code                                  */
+/*****************************************************************************/
+
+
+
+Profile* NewProfile (void);
+/* Create new, empty profile data */
+
+void FreeProfile (Profile* P);
+/* Free profile data */
+
+void ProfileInsn (Sim65Context* Ctx, unsigned PC, unsigned char OPC);
+/* Account for an instruction with the given opcode that was executed at PC.
+ * Must be called after the instruction, so Ctx->Cycles contains the cycles
+ * used including any page crossing penalties. JSR/RTS and RTI are used to
+ * track calls and interrupt handlers.
+ */
+
+void ProfileInterrupt (Sim65Context* Ctx, unsigned RetPC);
+/* Account for an interrupt that was taken while the CPU was at RetPC. Must
+ * be called after the CPU has loaded the vector.
+ */
+
+void ProfileReport (Sim65Context* Ctx, const DbgInfo* D, FILE* F);
+/* Write the profile of a context to F. If D is not NULL, addresses are
+ * mapped to labels and source lines, otherwise call targets are used as
+ * function names.
+ */
+
+
+
+/* End of profile.h */
+
+#endif
+
+
+
@@ -68,6 +68,9 @@ unsigned        	CfgErrorCol;
 static const char*     	CfgName		= 0;
 static const char*      CfgBuf 		= 0;
 
+/* Name of the program file, replaces %P */
+static const char*      CfgProgram      = 0;
+
 /* Other input stuff */
 static int     	       	C      	     	= ' ';
 static unsigned	       	InputLine    	= 1;
@@ -278,6 +281,26 @@ Again:
 	    CfgTok = CFGTOK_STRCON;
 	    break;
 
+        case '%':
+	    NextChar ();
+	    switch (C) {
+
+	        case 'P':
+		    NextChar ();
+		    if (CfgProgram) {
+		        strncpy (CfgSVal, CfgProgram, CFG_MAX_IDENT_LEN);
+		    	CfgSVal [CFG_MAX_IDENT_LEN] = '\0';
+		    } else {
+		    	CfgSVal [0] = '\0';
+		    }
+		    CfgTok = CFGTOK_STRCON;
+     		    break;
+
+	        default:
+	            CfgError ("Invalid format specification");
+	    }
+	    break;
+
         case '#':
 	    /* Comment */
 	    while (C != '\n' && C != EOF) {
@@ -473,6 +496,14 @@ const char* CfgGetName (void)
 
 
 
+void CfgSetProgram (const char* Name)
+/* Set the name of the program file used for %P */
+{
+    CfgProgram = Name;
+}
+
+
+
 void CfgSetBuf (const char* Buf)
 /* Set a memory buffer for the config */
 {
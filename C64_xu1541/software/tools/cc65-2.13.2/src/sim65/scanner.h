@@ -160,6 +160,9 @@ void CfgSetName (const char* Name);
 const char* CfgGetName (void);
 /* Get the name of the config file */
 
+void CfgSetProgram (const char* Name);
+/* Set the name of the program file used for %P */
+
 void CfgSetBuf (const char* Buf);
 /* Set a memory buffer for the config */
 
@@ -98,7 +98,10 @@ struct SimData {
     void (*NMI) (void);
     /* Issue an nmi request */
 
-    
+    /* -- Version 1.2 and above -- */
+
+    void (*PutChar) (int C);
+    /* Output a character to the output stream of the machine */
 
 };
 
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Assembly time benchmark for macro expansion. Generates a source file with
+# CALLS macro invocations. The macros use parameters, local symbols, nested
+# macro calls, .REPEAT blocks with a counter and a define style macro, so
+# every source line expands to many lines of code. Shows the time needed and
+# the throughput in source lines per second. If a second assembler is given,
+# the file is assembled with it, too, and the linked outputs are compared.
+#
+# Usage: macrobench.sh [bindir [ca65]]
+#
+
+BINDIR=${1:-../../src}
+REFAS=$2
+CALLS=${CALLS:-40000}
+TMP=${TMPDIR:-/tmp}/ca65-macrobench.$$
+RC=0
+
+now () {
+    date +%s.%N
+}
+
+assemble () {
+    # assemble assembler name
+    S=$(now)
+    $1 -o $TMP/$2.o $TMP/bench.s || exit 1
+    E=$(now)
+    echo "$2: $(echo "$S $E $LINES" | awk '{ printf "%.3f s, %d lines/s", $2 - $1, $3 / ($2 - $1) }')"
+    $BINDIR/ld65/ld65 -C macrobench.cfg -o $TMP/$2.bin $TMP/$2.o || exit 1
+}
+
+mkdir -p $TMP || exit 1
+awk -v CALLS=$CALLS 'BEGIN {
+    print "        .macro  poke    addr, val"
+    print "        lda     #val"
+    print "        sta     addr"
+    print "        .endmacro"
+    print "        .macro  add16   dst, src"
+    print "        .local  nocarry"
+    print "        clc"
+    print "        lda     dst"
+    print "        adc     src"
+    print "        sta     dst"
+    print "        bcc     nocarry"
+    print "        inc     dst+1"
+    print "nocarry:"
+    print "        .endmacro"
+    print "        .macro  fill    addr, val, count"
+    print "        .repeat count, i"
+    print "        poke    addr+i, val+i"
+    print "        .endrep"
+    print "        .endmacro"
+    print "        .define LOBYTE(val) <(val)"
+    print "        .bss"
+    print "buf:    .res    256"
+    print "        .code"
+    for (I = 0; I < CALLS; I += 2) {
+        printf "        add16   buf+%d, #LOBYTE %d\n", I % 128, I
+        printf "        fill    buf+%d, %d, 8\n", I % 64, I % 100
+    }
+}' > $TMP/bench.s
+LINES=$(wc -l < $TMP/bench.s)
+echo "$LINES lines, $CALLS macro calls"
+assemble $BINDIR/ca65/ca65 ca65
+if [ -n "$REFAS" ]; then
+    assemble $REFAS ref
+    if cmp -s $TMP/ca65.bin $TMP/ref.bin; then
+        echo "output identical"
+    else
+        echo "output differs"
+        RC=1
+    fi
+fi
+rm -rf $TMP
+exit $RC
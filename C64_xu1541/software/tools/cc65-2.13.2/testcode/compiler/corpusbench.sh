@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# Compile time benchmark for real code. Compiles all C files of the samples
+# and libsrc directories with the options given in OPTS and shows the time
+# needed. Files that cannot be compiled for the target in TARGET are counted
+# and skipped. If a second compiler is given, the files are compiled with it,
+# too, and the generated code is compared.
+#
+# Usage: corpusbench.sh [bindir [cc65]]
+#
+
+BINDIR=${1:-../../src}
+REFCC=$2
+TOP=${TOP:-../..}
+TARGET=${TARGET:-c64}
+OPTS=${OPTS:--Oirs}
+TMP=${TMPDIR:-/tmp}/cc65-corpusbench.$$
+RC=0
+
+now () {
+    date +%s.%N
+}
+
+compile () {
+    # compile compiler name
+    mkdir -p $TMP/$2 || exit 1
+    FAILED=0
+    S=$(now)
+    I=0
+    for F in $FILES; do
+        $1 -t $TARGET $OPTS -I $TOP/include -I $(dirname $F) \
+           -o $TMP/$2/$I.s $F 2>/dev/null || FAILED=$((FAILED + 1))
+        I=$((I + 1))
+    done
+    E=$(now)
+    echo "$2: $(echo "$S $E" | awk '{ printf "%.3f", $2 - $1 }') s," \
+         "$I files, $FAILED failed"
+}
+
+FILES=$(find $TOP/samples $TOP/libsrc -name '*.c' | sort)
+compile $BINDIR/cc65/cc65 cc65
+if [ -n "$REFCC" ]; then
+    compile $REFCC ref
+    if diff -r -q $TMP/cc65 $TMP/ref >/dev/null; then
+        echo "output identical"
+    else
+        echo "output differs"
+        RC=1
+    fi
+fi
+rm -rf $TMP
+exit $RC
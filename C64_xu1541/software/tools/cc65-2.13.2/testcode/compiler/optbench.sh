@@ -0,0 +1,114 @@
+#!/bin/sh
+#
+# Compile time benchmark for the optimizer. Generates a C file with FUNCS
+# random functions of STMTS statements each, using SEED for the random
+# numbers, and compiles it with the options given in OPTS. Large functions
+# with many branches and loops make the optimizer ask for the registers used
+# by the code behind an instruction very often. If a second compiler is
+# given, the file is compiled with it, too, and the sizes of the generated
+# code are shown for both.
+#
+# Usage: optbench.sh [bindir [cc65]]
+#
+
+BINDIR=${1:-../../src}
+REFCC=$2
+FUNCS=${FUNCS:-4}
+STMTS=${STMTS:-12}
+SEED=${SEED:-1}
+OPTS=${OPTS:--O}
+TMP=${TMPDIR:-/tmp}/cc65-optbench.$$
+
+now () {
+    date +%s.%N
+}
+
+compile () {
+    # compile compiler name
+    S=$(now)
+    $1 -t c64 $OPTS -o $TMP/$2.s $TMP/bench.c 2>/dev/null || exit 1
+    E=$(now)
+    echo "$2: $(echo "$S $E" | awk '{ printf "%.3f", $2 - $1 }') s," \
+         "$(grep -c '^	[a-z]' $TMP/$2.s) instructions"
+}
+
+mkdir -p $TMP || exit 1
+echo "generating $FUNCS functions with $STMTS statements, seed $SEED"
+awk -v SEED=$SEED -v FUNCS=$FUNCS -v STMTS=$STMTS '
+    function r(n) { return int(rand() * n) }
+    function var() { return V[1 + r(NV)] }
+    function expr(d,   o) {
+        if (d > 2 || r(3) == 0) {
+            o = r(4)
+            if (o == 0) return r(300)
+            if (o == 1) return "a[" r(16) "]"
+            if (o == 2) return "g" r(4) "()"
+            return var()
+        }
+        o = r(10)
+        if (o < 4) return "(" expr(d+1) " " OP[1 + r(NOP)] " " expr(d+1) ")"
+        if (o < 5) return "(" expr(d+1) " " DIV[1 + r(2)] " (" expr(d+1) " | 1))"
+        if (o < 6) return "(" expr(d+1) " " SH[1 + r(2)] " " (1 + r(7)) ")"
+        if (o < 8) return "(" expr(d+1) " " CMP[1 + r(6)] " " expr(d+1) ")"
+        if (o < 9) return "(-" expr(d+1) ")"
+        return "(" expr(d+1) " ? " expr(d+1) " : " expr(d+1) ")"
+    }
+    function stmt(d, ind,   o, v, n, i) {
+        o = (d > 3) ? r(4) : r(10)
+        if (o < 3) { printf "%s%s %s %s;\n", ind, var(), AS[1 + r(NAS)], expr(0); return }
+        if (o == 3) { printf "%sa[%s & 15] = %s;\n", ind, var(), expr(0); return }
+        if (o == 4) {
+            printf "%sif (%s) {\n", ind, expr(0); block(d+1, ind "    ")
+            if (r(2)) { printf "%s} else {\n", ind; block(d+1, ind "    ") }
+            printf "%s}\n", ind; return
+        }
+        if (o == 5) {
+            v = "i" d
+            printf "%sfor (%s = 0; %s < %d; ++%s) {\n", ind, v, v, 1 + r(20), v
+            block(d+1, ind "    "); printf "%s}\n", ind; return
+        }
+        if (o == 6) {
+            printf "%swhile (%s) {\n", ind, expr(0); block(d+1, ind "    ")
+            printf "%s    if (%s) break;\n%s}\n", ind, expr(0), ind; return
+        }
+        if (o == 7) {
+            printf "%sswitch (%s) {\n", ind, var(); n = 2 + r(5)
+            for (i = 0; i < n; ++i) {
+                printf "%s    case %d:\n", ind, i * 3; block(d+1, ind "        ")
+                if (r(3)) printf "%s        break;\n", ind
+            }
+            printf "%s    default: %s = %s;\n%s}\n", ind, var(), expr(0), ind; return
+        }
+        if (o == 8) { printf "%sif (%s) return %s;\n", ind, expr(0), expr(0); return }
+        printf "%sf%d (%s, %s);\n", ind, r(4), expr(0), expr(0)
+    }
+    function block(d, ind,   n, i) {
+        n = 1 + r(4)
+        for (i = 0; i < n; ++i) stmt(d, ind)
+    }
+    BEGIN {
+        srand(SEED)
+        NOP = split("+ - * & | ^", OP, " ")
+        split("/ %", DIV, " ")
+        split("<< >>", SH, " ")
+        split("== != < > <= >=", CMP, " ")
+        NAS = split("= += -= &= |= ^=", AS, " ")
+        printf "extern int g0 (void), g1 (void), g2 (void), g3 (void);\n"
+        printf "extern void f0 (int, int), f1 (int, int), f2 (int, int), f3 (int, int);\n"
+        printf "extern int a[16];\n"
+        for (f = 0; f < FUNCS; ++f) {
+            printf "\n%s fn%d (int p0, int p1)\n{\n", (f % 3 == 0) ? "long" : (f % 3 == 1) ? "int" : "unsigned char", f
+            printf "    register int r0 = p0;\n    int i0, i1, i2, i3;\n"
+            printf "    unsigned char c0 = p1, c1 = 0;\n    long l0 = p0, l1 = 1;\n    unsigned u0 = p1;\n"
+            NV = split("p0 p1 r0 c0 c1 l0 l1 u0 i0 i1", V, " ")
+            for (s = 0; s < STMTS; ++s) stmt(0, "    ")
+            printf "    return %s;\n}\n", expr(0)
+        }
+    }
+' > $TMP/bench.c || exit 1
+
+compile $BINDIR/cc65/cc65 cc65
+if [ -n "$REFCC" ]; then
+    compile $REFCC ref
+fi
+rm -rf $TMP
@@ -0,0 +1,98 @@
+#!/bin/sh
+#
+# Link time benchmark for the library resolver and the object file reader.
+# Builds MODULES modules and puts them into LIBS libraries. The modules form
+# chains of DEPTH modules, each one importing the symbol of its predecessor,
+# so a linear search over the libraries needs DEPTH passes to pull in a whole
+# chain. Each module has DATA times 16 bytes of literal data. Two programs
+# are linked against the libraries: "all" needs every chain, "one" needs just
+# the last one. If a second linker is given, both programs are linked with
+# it, too, and the outputs are compared.
+#
+# Usage: libbench.sh [bindir [ld65]]
+#
+
+BINDIR=${1:-../../src}
+REFLD=$2
+MODULES=${MODULES:-5000}
+DEPTH=${DEPTH:-100}
+LIBS=${LIBS:-1}
+DATA=${DATA:-0}
+TMP=${TMPDIR:-/tmp}/ld65-libbench.$$
+RC=0
+
+now () {
+    date +%s.%N
+}
+
+link () {
+    # link linker name
+    S=$(now)
+    $1 -C libbench.cfg -o $TMP/$2.$3.bin $TMP/$2.o $LIBFILES || exit 1
+    E=$(now)
+    echo "$2 ($3): $(echo "$S $E" | awk '{ printf "%.3f", $2 - $1 }') s"
+}
+
+mkdir -p $TMP/mod || exit 1
+echo "building $LIBS libraries with $MODULES modules, chain depth $DEPTH"
+I=0
+while [ $I -lt $MODULES ]; do
+    {
+        echo "        .export s$I"
+        if [ $((I % DEPTH)) -ne 0 ]; then
+            echo "        .import s$((I - 1))"
+            echo "s$I:    jsr s$((I - 1))"
+        else
+            echo "s$I:"
+        fi
+        echo "        rts"
+        echo "        .segment \"DATA\""
+        echo "        .repeat $DATA"
+        echo "        .byte   \"0123456789abcdef\""
+        echo "        .endrep"
+    } > $TMP/mod/m$I.s
+    $BINDIR/ca65/ca65 -o $TMP/mod/m$I.o $TMP/mod/m$I.s || exit 1
+    echo $TMP/mod/m$I.o >> $TMP/mod/list$((I * LIBS / MODULES))
+    I=$((I + 1))
+done
+S=$(now)
+I=0
+LIBFILES=
+while [ $I -lt $LIBS ]; do
+    xargs $BINDIR/ar65/ar65 a $TMP/bench$I.lib < $TMP/mod/list$I 2>/dev/null || exit 1
+    LIBFILES="$LIBFILES $TMP/bench$I.lib"
+    I=$((I + 1))
+done
+E=$(now)
+echo "ar65: $(echo "$S $E" | awk '{ printf "%.3f", $2 - $1 }') s"
+if [ $LIBS -gt 1 ]; then
+    LIBFILES="--start-group $LIBFILES --end-group"
+fi
+
+# "all" imports the last symbol of every chain, "one" only the last one
+I=$((DEPTH - 1))
+: > $TMP/all.s
+while [ $I -lt $MODULES ]; do
+    echo "        .import s$I" >> $TMP/all.s
+    echo "        jsr s$I" >> $TMP/all.s
+    I=$((I + DEPTH))
+done
+printf "        .import s%d\n        jsr s%d\n" $((I - DEPTH)) $((I - DEPTH)) > $TMP/one.s
+for P in all one; do
+    $BINDIR/ca65/ca65 -o $TMP/$P.o $TMP/$P.s || exit 1
+done
+
+for P in all one; do
+    link $BINDIR/ld65/ld65 $P ld65
+    if [ -n "$REFLD" ]; then
+        link $REFLD $P ref
+        if cmp -s $TMP/$P.ld65.bin $TMP/$P.ref.bin; then
+            echo "$P: output identical"
+        else
+            echo "$P: output differs"
+            RC=1
+        fi
+    fi
+done
+rm -rf $TMP
+exit $RC
@@ -0,0 +1,84 @@
+;
+; Simulator speed benchmark for sim65.
+;
+; Build and run with
+;
+;       ca65 bench.s
+;       ld65 -C bench.cfg -o bench.bin bench.o
+;       sim65 -v -C sim65.cfg -L <chipdir> bench.bin
+;
+; sim65 prints the number of simulated cycles per second when the program
+; stops with a BRK. Running it with -d forces all memory accesses through the
+; chip plugins and may be used for comparison.
+;
+
+        .setcpu         "6502"
+
+COUNT   =       $10             ; Loop counter (3 bytes)
+SUM     =       $13             ; Running sum
+STDOUT  =       $D000           ; STDIO chip
+
+        .segment        "CODE"
+
+.proc   reset
+
+        ldx     #$FF
+        txs
+        lda     #0
+        sta     COUNT
+        sta     COUNT+1
+        sta     COUNT+2
+        sta     SUM
+
+; Fill a page of RAM, then repeatedly add it up using several addressing
+; modes.
+
+        tax
+@L1:    txa
+        sta     $0200,x
+        inx
+        bne     @L1
+
+@L2:    ldy     #0
+@L3:    lda     SUM
+        clc
+        adc     $0200,y
+        sta     SUM
+        lda     $0200,y
+        eor     #$55
+        sta     $0300,y
+        iny
+        bne     @L3
+
+        inc     COUNT
+        bne     @L2
+        inc     COUNT+1
+        lda     COUNT+1
+        cmp     #$40
+        bne     @L2
+
+; Print a message and stop
+
+        ldx     #0
+@L4:    lda     msg,x
+        beq     @L5
+        sta     STDOUT
+        inx
+        bne     @L4
+@L5:    brk
+
+.endproc
+
+.proc   irq
+        rti
+.endproc
+
+        .segment        "RODATA"
+
+msg:    .byte   "Done", 10, 0
+
+        .segment        "VECTORS"
+
+        .word   irq
+        .word   reset
+        .word   irq
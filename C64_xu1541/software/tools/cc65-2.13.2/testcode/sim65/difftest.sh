@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# Differential test for the sim65 execution engines. Runs each test program
+# with the interpreter and with the block engine and compares the output and
+# the total cycle count. For the programs in TRACE, the instruction traces
+# including the cycle counts are compared, too. For the programs in PROFILE,
+# the profile reports are compared. Finally, all programs are run in parallel
+# with --testdir.
+#
+# Usage: difftest.sh [bindir [chipdir]]
+#
+
+BINDIR=${1:-../../src}
+CHIPDIR=${2:-$BINDIR/sim65/chips}
+TESTS="bench smc prof"
+TRACE="smc"
+PROFILE="prof"
+TMP=${TMPDIR:-/tmp}/sim65-difftest.$$
+RC=0
+
+mkdir -p $TMP || exit 1
+for T in $TESTS; do
+    $BINDIR/ca65/ca65 -g -o $TMP/$T.o $T.s || exit 1
+    $BINDIR/ld65/ld65 -C bench.cfg --dbgfile $TMP/$T.dbg \
+        -o $TMP/$T.bin $TMP/$T.o || exit 1
+    for E in interp block; do
+        OPTS="-v --engine $E"
+        case " $TRACE " in
+            *" $T "*)   OPTS="$OPTS --trace $TMP/$T.$E.trace";;
+        esac
+        case " $PROFILE " in
+            *" $T "*)   OPTS="$OPTS --profile $TMP/$T.$E.prof --dbgfile $TMP/$T.dbg";;
+        esac
+        $BINDIR/sim65/sim65 -C sim65.cfg -L $CHIPDIR $OPTS $TMP/$T.bin \
+            > $TMP/$T.$E.out 2> $TMP/$T.$E.log || exit 1
+        grep " cycles in " $TMP/$T.$E.log | cut -d' ' -f1 >> $TMP/$T.$E.out
+        touch $TMP/$T.$E.trace $TMP/$T.$E.prof
+    done
+    if cmp -s $TMP/$T.interp.out $TMP/$T.block.out &&
+       cmp -s $TMP/$T.interp.trace $TMP/$T.block.trace &&
+       cmp -s $TMP/$T.interp.prof $TMP/$T.block.prof; then
+        echo "$T: ok ($(tail -1 $TMP/$T.interp.out) cycles)"
+    else
+        echo "$T: FAILED"
+        RC=1
+    fi
+done
+for E in interp block; do
+    if $BINDIR/sim65/sim65 -C sim65.cfg -L $CHIPDIR --engine $E \
+        --testdir $TMP > $TMP/testdir.out; then
+        echo "testdir ($E): ok"
+    else
+        cat $TMP/testdir.out
+        echo "testdir ($E): FAILED"
+        RC=1
+    fi
+done
+rm -rf $TMP
+exit $RC
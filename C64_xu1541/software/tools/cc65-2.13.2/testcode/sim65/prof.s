@@ -0,0 +1,111 @@
+;
+; Test program for the sim65 profiler. It contains nested and recursive
+; subroutine calls, indexed accesses crossing a page boundary and line infos
+; for a fictional C source, like cc65 -g emits them. See difftest.sh.
+;
+; Build and run with
+;
+;       ca65 -g prof.s
+;       ld65 -C bench.cfg --dbgfile prof.dbg -o prof.bin prof.o
+;       sim65 -C sim65.cfg -L <chipdir> --profile prof.txt --dbgfile prof.dbg prof.bin
+;
+
+        .setcpu         "6502"
+
+CNT     =       $20             ; Loop counter
+SUM     =       $21             ; Checksum (2 bytes)
+DEPTH   =       $23             ; Recursion depth
+DATA    =       $02F0           ; Data crossing a page
+
+        .dbg    file, "prof.c", 0, 0
+
+        .segment        "CODE"
+
+.proc   reset
+
+        ldx     #$FF
+        txs
+        cld
+        lda     #0
+        sta     SUM
+        sta     SUM+1
+
+        .dbg    line, "prof.c", 10
+        lda     #100
+        sta     CNT
+@L1:    jsr     outer
+        .dbg    line, "prof.c", 11
+        dec     CNT
+        bne     @L1
+
+        .dbg    line, "prof.c", 12
+        lda     #8
+        sta     DEPTH
+        jsr     recurse
+
+; Exit code
+
+        .dbg    line
+        lda     #0
+        brk
+
+.endproc
+
+; Calls sum twice
+
+.proc   outer
+
+        .dbg    line, "prof.c", 20
+        ldx     #$00
+        jsr     sum
+        .dbg    line, "prof.c", 21
+        ldx     #$08
+        jsr     sum
+        .dbg    line
+        rts
+
+.endproc
+
+; Add 32 bytes starting at DATA+X. The accesses cross a page boundary for
+; X = 8, which costs an extra cycle per access.
+
+.proc   sum
+
+        .dbg    line, "prof.c", 30
+        ldy     #32
+@L1:    lda     DATA,x
+        clc
+        adc     SUM
+        sta     SUM
+        bcc     @L2
+        inc     SUM+1
+@L2:    inx
+        dey
+        bne     @L1
+        .dbg    line
+        rts
+
+.endproc
+
+; Recurse DEPTH levels
+
+.proc   recurse
+
+        .dbg    line, "prof.c", 40
+        dec     DEPTH
+        beq     @L1
+        jsr     recurse
+        .dbg    line
+@L1:    rts
+
+.endproc
+
+.proc   irq
+        rti
+.endproc
+
+        .segment        "VECTORS"
+
+        .word   irq
+        .word   reset
+        .word   irq
@@ -0,0 +1,152 @@
+;
+; Test program for the sim65 execution engines. It uses self modifying code,
+; code copied to RAM, page crossing branches and indexed accesses and most
+; addressing modes. See difftest.sh.
+;
+
+        .setcpu         "6502"
+
+PTR     =       $20             ; Zero page pointer
+CNT     =       $22             ; Loop counter
+SUM     =       $23             ; Checksum (2 bytes)
+STDOUT  =       $D000           ; STDIO chip
+RAMCODE =       $04F0           ; Code copied to RAM, crosses a page
+
+        .segment        "CODE"
+
+.proc   reset
+
+        ldx     #$FF
+        txs
+        cld
+        lda     #0
+        sta     SUM
+        sta     SUM+1
+
+; Copy the RAM code, it crosses a page boundary
+
+        ldx     #ramend-ramcode-1
+@L1:    lda     ramcode,x
+        sta     RAMCODE,x
+        dex
+        bpl     @L1
+
+; Run the RAM code with different immediate operands patched into it. The
+; patched instruction is in the same block as the store that patches it.
+
+        lda     #64
+        sta     CNT
+@L2:    lda     CNT
+        sta     RAMCODE + (patch - ramcode) + 1
+        jsr     RAMCODE
+        dec     CNT
+        bne     @L2
+
+; Walk a pointer over two pages using (zp),y with page crossings
+
+        lda     #<$02F0
+        sta     PTR
+        lda     #>$02F0
+        sta     PTR+1
+        ldy     #0
+@L3:    tya
+        sta     (PTR),y
+        eor     #$A5
+        clc
+        adc     (PTR),y
+        jsr     addsum
+        iny
+        bne     @L3
+
+; Indexed accesses crossing a page, compares and SBC
+
+        ldx     #$20
+@L4:    lda     $02F0,x
+        sec
+        sbc     $0300,x
+        cmp     #$80
+        bcc     @L5
+        eor     #$FF
+@L5:    jsr     addsum
+        dex
+        bne     @L4
+
+; Indirect jump through a patched vector
+
+        lda     #<target
+        sta     PTR
+        lda     #>target
+        sta     PTR+1
+        jmp     (PTR)
+
+done:   lda     SUM
+        jsr     hexout
+        lda     SUM+1
+        jsr     hexout
+        lda     #10
+        sta     STDOUT
+        lda     #0              ; Exit code
+        brk
+
+.endproc
+
+.proc   target
+        ldx     #0
+@L1:    lda     msg,x
+        beq     @L2
+        sta     STDOUT
+        inx
+        bne     @L1
+@L2:    jmp     reset::done
+.endproc
+
+.proc   addsum
+        clc
+        adc     SUM
+        sta     SUM
+        bcc     @L1
+        inc     SUM+1
+@L1:    rts
+.endproc
+
+.proc   hexout
+        pha
+        lsr     a
+        lsr     a
+        lsr     a
+        lsr     a
+        jsr     @L1
+        pla
+        and     #$0F
+@L1:    tax
+        lda     hexdigits,x
+        sta     STDOUT
+        rts
+.endproc
+
+; Code that is copied to RAM
+
+ramcode:
+        ldx     #8
+rloop:  lda     SUM
+patch:  adc     #$00            ; Operand is patched
+        sta     SUM
+        dex
+        bne     rloop
+        rts
+ramend:
+
+.proc   irq
+        rti
+.endproc
+
+        .segment        "RODATA"
+
+msg:            .byte   "Checksum: ", 0
+hexdigits:      .byte   "0123456789ABCDEF"
+
+        .segment        "VECTORS"
+
+        .word   irq
+        .word   reset
+        .word   irq
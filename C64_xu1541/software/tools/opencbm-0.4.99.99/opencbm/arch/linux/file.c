@@ -9,6 +9,9 @@
 
 #include "arch.h"
 
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 
@@ -44,3 +47,112 @@ int arch_filesize(const char *Filename, off_t *Filesize)
 
     return ret;
 }
+
+
+/*! the state of a memory mapped file */
+struct arch_filemap_s
+{
+    int fd;        /*!< the file descriptor of the mapped file */
+    void *data;    /*!< the mapped data, NULL if the size is 0 */
+    size_t size;   /*!< the size of the mapping */
+    int writable;  /*!< the file is mapped read/write */
+};
+
+/*! \brief Map a file into memory
+
+ \param Filename
+   Name of the file to map.
+
+ \param Mode
+   ARCH_FILEMAP_READ maps an existing file read only.
+   ARCH_FILEMAP_WRITE maps an existing file read/write, and
+   ARCH_FILEMAP_CREATE creates the file (or truncates an existing
+   one) first. For both writable modes, the file is resized to
+   Size bytes, new bytes read as 0.
+
+ \param Size
+   The number of bytes to map, starting at the beginning of the file.
+
+ \param Data
+   Pointer to a location which will be set to the mapped data.
+
+ \return
+   The mapping, or NULL if an error occurred.
+*/
+
+arch_filemap_t *arch_filemap_open(const char *Filename, int Mode, off_t Size, unsigned char **Data)
+{
+    arch_filemap_t *map;
+    int flags;
+
+    map = malloc(sizeof(*map));
+    if (map == NULL)
+        return NULL;
+
+    map->writable = Mode != ARCH_FILEMAP_READ;
+    map->size = (size_t) Size;
+    map->data = NULL;
+
+    switch (Mode)
+    {
+    case ARCH_FILEMAP_WRITE:  flags = O_RDWR; break;
+    case ARCH_FILEMAP_CREATE: flags = O_RDWR | O_CREAT | O_TRUNC; break;
+    default:                  flags = O_RDONLY; break;
+    }
+
+    map->fd = open(Filename, flags, 0666);
+    if (map->fd < 0)
+    {
+        free(map);
+        return NULL;
+    }
+
+    if ((map->writable && ftruncate(map->fd, Size) != 0) ||
+        (Size > 0 && (map->data = mmap(NULL, map->size,
+                 map->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                 MAP_SHARED, map->fd, 0)) == MAP_FAILED))
+    {
+        close(map->fd);
+        free(map);
+        return NULL;
+    }
+
+    *Data = map->data;
+    return map;
+}
+
+/*! \brief Unmap a file mapped with arch_filemap_open()
+
+ All changes are written back to the file.
+
+ \param Map
+   The mapping to close.
+
+ \param Size
+   The final size of the file. This is ignored for
+   read only mappings.
+
+ \return
+   0 on success, everything else denotes an error.
+*/
+
+int arch_filemap_close(arch_filemap_t *Map, off_t Size)
+{
+    int ret = 0;
+
+    if (Map->data)
+    {
+        if (Map->writable && msync(Map->data, Map->size, MS_SYNC) != 0)
+            ret = 1;
+        munmap(Map->data, Map->size);
+    }
+
+    if (Map->writable && ftruncate(Map->fd, Size) != 0)
+        ret = 1;
+
+    if (close(Map->fd) != 0)
+        ret = 1;
+
+    free(Map);
+    return ret;
+}
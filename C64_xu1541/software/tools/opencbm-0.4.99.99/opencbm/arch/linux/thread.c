@@ -0,0 +1,166 @@
+/*
+ *      This program is free software; you can redistribute it and/or
+ *      modify it under the terms of the GNU General Public License
+ *      as published by the Free Software Foundation; either version
+ *      2 of the License, or (at your option) any later version.
+ *
+*/
+
+/*! ************************************************************** 
+** \file arch/linux/thread.c \n
+** \n
+** \brief Helper functions for threads, semaphores and timing
+**
+****************************************************************/
+
+#include "arch.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+struct arch_thread_s
+{
+    pthread_t thread;
+    arch_thread_func func;
+    void *context;
+};
+
+/* POSIX semaphores are not available on all supported systems
+ * (MacOS X), thus, build them from a mutex and a condition.
+ */
+struct arch_sem_s
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    unsigned int count;
+};
+
+struct arch_mutex_s
+{
+    pthread_mutex_t mutex;
+};
+
+/* serialises the creation of mutexes on their first use */
+static pthread_mutex_t mutex_create_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *
+thread_start(void *arg)
+{
+    arch_thread_t *thread = arg;
+
+    thread->func(thread->context);
+    return NULL;
+}
+
+arch_thread_t *
+arch_thread_create(arch_thread_func func, void *context)
+{
+    arch_thread_t *thread = malloc(sizeof(*thread));
+
+    if (thread)
+    {
+        thread->func = func;
+        thread->context = context;
+
+        if (pthread_create(&thread->thread, NULL, thread_start, thread) != 0)
+        {
+            free(thread);
+            thread = NULL;
+        }
+    }
+    return thread;
+}
+
+void
+arch_thread_join(arch_thread_t *thread)
+{
+    pthread_join(thread->thread, NULL);
+    free(thread);
+}
+
+arch_sem_t *
+arch_sem_create(unsigned int count)
+{
+    arch_sem_t *sem = malloc(sizeof(*sem));
+
+    if (sem)
+    {
+        pthread_mutex_init(&sem->mutex, NULL);
+        pthread_cond_init(&sem->cond, NULL);
+        sem->count = count;
+    }
+    return sem;
+}
+
+void
+arch_sem_wait(arch_sem_t *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0)
+    {
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    }
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void
+arch_sem_post(arch_sem_t *sem)
+{
+    pthread_mutex_lock(&sem->mutex);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void
+arch_sem_destroy(arch_sem_t *sem)
+{
+    if (sem)
+    {
+        pthread_cond_destroy(&sem->cond);
+        pthread_mutex_destroy(&sem->mutex);
+        free(sem);
+    }
+}
+
+void
+arch_mutex_lock(arch_mutex_t **mutex)
+{
+    arch_mutex_t *m;
+
+    /* the pointer itself is only read under the lock, too: without
+     * memory barriers, another thread could see it before the mutex
+     * it points to is initialised */
+    pthread_mutex_lock(&mutex_create_lock);
+    m = *mutex;
+    if (m == NULL)
+    {
+        m = malloc(sizeof(*m));
+        if (m == NULL)
+        {
+            /* no way to report this, and no way to go on safely */
+            abort();
+        }
+        pthread_mutex_init(&m->mutex, NULL);
+        *mutex = m;
+    }
+    pthread_mutex_unlock(&mutex_create_lock);
+    pthread_mutex_lock(&m->mutex);
+}
+
+void
+arch_mutex_unlock(arch_mutex_t *mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+unsigned long
+arch_ticks_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (unsigned long) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
@@ -12,6 +12,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "arch.h"
 
@@ -50,3 +51,135 @@ int arch_filesize(const char *Filename, off_t *Filesize)
 
     return ret;
 }
+
+
+/*! the state of a memory mapped file */
+struct arch_filemap_s
+{
+    HANDLE File;          /*!< the handle of the mapped file */
+    HANDLE Mapping;       /*!< the file mapping object, NULL if the size is 0 */
+    void *Data;           /*!< the mapped view, NULL if the size is 0 */
+    int Writable;         /*!< the file is mapped read/write */
+};
+
+/* set the size of the file */
+static BOOL filemap_setsize(HANDLE File, off_t Size)
+{
+    return SetFilePointer(File, (LONG) Size, NULL, FILE_BEGIN) != (DWORD) -1
+        && SetEndOfFile(File);
+}
+
+/*! \brief Map a file into memory
+
+ \param Filename
+   Name of the file to map.
+
+ \param Mode
+   ARCH_FILEMAP_READ maps an existing file read only.
+   ARCH_FILEMAP_WRITE maps an existing file read/write, and
+   ARCH_FILEMAP_CREATE creates the file (or truncates an existing
+   one) first. For both writable modes, the file is resized to
+   Size bytes, new bytes read as 0.
+
+ \param Size
+   The number of bytes to map, starting at the beginning of the file.
+
+ \param Data
+   Pointer to a location which will be set to the mapped data.
+
+ \return
+   The mapping, or NULL if an error occurred.
+*/
+
+arch_filemap_t *arch_filemap_open(const char *Filename, int Mode, off_t Size, unsigned char **Data)
+{
+    arch_filemap_t *map;
+
+    map = malloc(sizeof(*map));
+    if (map == NULL)
+        return NULL;
+
+    map->Writable = Mode != ARCH_FILEMAP_READ;
+    map->Mapping = NULL;
+    map->Data = NULL;
+
+    map->File = CreateFile(Filename,
+        map->Writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+        FILE_SHARE_READ, NULL,
+        Mode == ARCH_FILEMAP_CREATE ? CREATE_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (map->File == INVALID_HANDLE_VALUE)
+    {
+        free(map);
+        return NULL;
+    }
+
+    if (map->Writable && !filemap_setsize(map->File, Size))
+    {
+        CloseHandle(map->File);
+        free(map);
+        return NULL;
+    }
+
+    if (Size > 0)
+    {
+        map->Mapping = CreateFileMapping(map->File, NULL,
+            map->Writable ? PAGE_READWRITE : PAGE_READONLY, 0, (DWORD) Size, NULL);
+
+        if (map->Mapping != NULL)
+        {
+            map->Data = MapViewOfFile(map->Mapping,
+                map->Writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (SIZE_T) Size);
+        }
+
+        if (map->Data == NULL)
+        {
+            if (map->Mapping != NULL)
+                CloseHandle(map->Mapping);
+            CloseHandle(map->File);
+            free(map);
+            return NULL;
+        }
+    }
+
+    *Data = map->Data;
+    return map;
+}
+
+/*! \brief Unmap a file mapped with arch_filemap_open()
+
+ All changes are written back to the file.
+
+ \param Map
+   The mapping to close.
+
+ \param Size
+   The final size of the file. This is ignored for
+   read only mappings.
+
+ \return
+   0 on success, everything else denotes an error.
+*/
+
+int arch_filemap_close(arch_filemap_t *Map, off_t Size)
+{
+    int ret = 0;
+
+    if (Map->Data)
+    {
+        if (Map->Writable && !FlushViewOfFile(Map->Data, 0))
+            ret = 1;
+        UnmapViewOfFile(Map->Data);
+        CloseHandle(Map->Mapping);
+    }
+
+    if (Map->Writable && !filemap_setsize(Map->File, Size))
+        ret = 1;
+
+    if (!CloseHandle(Map->File))
+        ret = 1;
+
+    free(Map);
+    return ret;
+}
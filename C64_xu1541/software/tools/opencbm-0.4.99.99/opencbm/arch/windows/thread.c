@@ -0,0 +1,153 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version
+ *  2 of the License, or (at your option) any later version.
+ *
+ */
+
+/*! ************************************************************** 
+** \file arch/windows/thread.c \n
+** \n
+** \brief Helper functions for threads, semaphores and timing
+**
+****************************************************************/
+
+#include <windows.h>
+
+#include <stdlib.h>
+
+#include "arch.h"
+
+struct arch_thread_s
+{
+    HANDLE thread;
+    arch_thread_func func;
+    void *context;
+};
+
+struct arch_sem_s
+{
+    HANDLE semaphore;
+};
+
+struct arch_mutex_s
+{
+    CRITICAL_SECTION section;
+};
+
+static DWORD WINAPI
+thread_start(LPVOID arg)
+{
+    arch_thread_t *thread = arg;
+
+    thread->func(thread->context);
+    return 0;
+}
+
+arch_thread_t *
+arch_thread_create(arch_thread_func func, void *context)
+{
+    arch_thread_t *thread = malloc(sizeof(*thread));
+
+    if (thread)
+    {
+        DWORD threadId;
+
+        thread->func = func;
+        thread->context = context;
+        thread->thread = CreateThread(NULL, 0, thread_start, thread, 0, &threadId);
+
+        if (thread->thread == NULL)
+        {
+            free(thread);
+            thread = NULL;
+        }
+    }
+    return thread;
+}
+
+void
+arch_thread_join(arch_thread_t *thread)
+{
+    WaitForSingleObject(thread->thread, INFINITE);
+    CloseHandle(thread->thread);
+    free(thread);
+}
+
+arch_sem_t *
+arch_sem_create(unsigned int count)
+{
+    arch_sem_t *sem = malloc(sizeof(*sem));
+
+    if (sem)
+    {
+        sem->semaphore = CreateSemaphore(NULL, count, 0x7fffffff, NULL);
+
+        if (sem->semaphore == NULL)
+        {
+            free(sem);
+            sem = NULL;
+        }
+    }
+    return sem;
+}
+
+void
+arch_sem_wait(arch_sem_t *sem)
+{
+    WaitForSingleObject(sem->semaphore, INFINITE);
+}
+
+void
+arch_sem_post(arch_sem_t *sem)
+{
+    ReleaseSemaphore(sem->semaphore, 1, NULL);
+}
+
+void
+arch_sem_destroy(arch_sem_t *sem)
+{
+    if (sem)
+    {
+        CloseHandle(sem->semaphore);
+        free(sem);
+    }
+}
+
+void
+arch_mutex_lock(arch_mutex_t **mutex)
+{
+    arch_mutex_t *m = *mutex;
+
+    if (m == NULL)
+    {
+        /* create one; if another thread was faster, use its mutex */
+        m = malloc(sizeof(*m));
+        if (m == NULL)
+        {
+            /* no way to report this, and no way to go on safely */
+            abort();
+        }
+        InitializeCriticalSection(&m->section);
+        if (InterlockedCompareExchangePointer((PVOID *)mutex, m, NULL) != NULL)
+        {
+            DeleteCriticalSection(&m->section);
+            free(m);
+            m = *mutex;
+        }
+    }
+    EnterCriticalSection(&m->section);
+}
+
+void
+arch_mutex_unlock(arch_mutex_t *mutex)
+{
+    LeaveCriticalSection(&mutex->section);
+}
+
+unsigned long
+arch_ticks_ms(void)
+{
+    return GetTickCount();
+}
@@ -28,6 +28,40 @@ static int no_progress = 0;
 /* other globals */
 static CBM_FILE fd_cbm;
 
+/* serializes the output of the copies of a drive farm */
+static arch_mutex_t *output_mutex;
+
+/* maximum number of adapters used with --farm */
+#define MAX_FARM_JOBS 32
+
+/* one copy of a drive farm, every one has an adapter of its own */
+typedef struct
+{
+    char *adapter;              /* plugin:port */
+    char *image;                /* the image to read or write */
+    d64copy_settings settings;
+    int drive;
+    int reading;                /* drive->PC */
+    CBM_FILE fd;
+    int is_open;
+    int blocks;                 /* blocks copied, < 0 on error */
+    unsigned long elapsed_ms;
+    int last_track;             /* progress output */
+    char trackmap[MAX_SECTORS+1];
+} farm_job;
+
+static farm_job *farm_jobs;
+static int farm_count;
+
+/*
+ * destinations of a disk read, TARGET first, and the last progress
+ * reported for them
+ */
+static d64copy_sink sinks[D64COPY_MAX_SINKS];
+static int sink_count = 1;
+static d64copy_sink_status sink_result[D64COPY_MAX_SINKS];
+static const char *checksum_file;
+
 
 static int is_cbm(char *name)
 {
@@ -79,7 +113,9 @@ static void help()
 "\n"
 "                            INTERLEAVE is ignored when reading with warp mode;\n"
 "                            if data transfer is very slow, increasing this\n"
-"                            value may help.\n"
+"                            value may help.\n""                            `auto' times the first tracks and picks the\n"
+"                            interleave and the first sector of each track\n"
+"                            from that; use -v to see the choices.\n"
 "\n"
 "  -w, --warp                enable warp mode; this is not possible if\n"
 "                            TRANSFER is set to `original'\n"
@@ -111,6 +147,26 @@ static void help()
 "  -2, --two-sided           two-sided disk transfer (.d71): Requires 1571.\n"
 "                            Warp mode is not available for .d71 images.\n"
 "\n"
+"  -P, --pipeline            read the drive in a separate thread while the\n"
+"                            image is being written (drive->PC only)\n"
+"\n"
+"  -o, --copy-to=IMAGE       also write the disk to IMAGE, it is read only\n"
+"                            once (drive->PC only, can be repeated)\n"
+"\n"
+"  -c, --checksum[=FILE]     print CRC32, MD5 and SHA-1 of the image; with\n"
+"                            FILE, also write those of every block to FILE\n"
+"                            (drive->PC only)\n"
+"\n"
+"  -C, --compare=IMAGE       compare the disk with the reference IMAGE while\n"
+"                            reading it (drive->PC only)\n"
+"\n"
+"  -F, --farm=ADAPTERS       copy with several adapters at the same time, one\n"
+"                            thread each. ADAPTERS is a comma separated list\n"
+"                            of plugin:port, or of plugins alone, meaning all\n"
+"                            of their devices which are connected. When\n"
+"                            reading, `%%d' in TARGET is replaced by the port,\n"
+"                            or `-port' is inserted before the extension.\n"
+"\n"
 );
 }
 
@@ -133,11 +189,13 @@ static void my_message_cb(int severity, const char *format, ...)
 
     if(verbosity >= severity)
     {
+        arch_mutex_lock(&output_mutex);
         fprintf(stderr, "[%s] ", severities[severity]);
         va_start(args, format);
         vfprintf(stderr, format, args);
         va_end(args);
         fprintf(stderr, "\n");
+        arch_mutex_unlock(output_mutex);
     }
 }
 
@@ -145,14 +203,26 @@ static int my_status_cb(d64copy_status status)
 {
     static char trackmap[MAX_SECTORS+1];
     static int last_track;
+    static int width;
     char *s;
     char *d;
+    int i;
 
     static const char bs2char[] =
     {
         ' ', '.', '-', '?', '*'
     };
 
+    static const char *sink_names[] =
+    {
+        "img", "sum", "cmp"
+    };
+
+    for(i = 0; i < status.sink_count; i++)
+    {
+        sink_result[i] = status.sinks[i];
+    }
+
     if(status.track == 0)
     {
         last_track = 0;
@@ -168,7 +238,8 @@ static int my_status_cb(d64copy_status status)
     {
         if(last_track)
         {
-            printf("\r%2d: %-24s               \n", last_track, trackmap);
+            printf("\r%2d: %-24s%*s\n", last_track, trackmap,
+                   width > 28 ? width - 28 : 0, "");
         }
 
         for(s = status.bam[status.track-1], d = trackmap; *s; s++, d++)
@@ -183,15 +254,113 @@ static int my_status_cb(d64copy_status status)
         bs2char[(status.read_result || 
                  status.write_result) ? bs_error : bs_copied];
 
-    printf("\r%2d: %-24s%3d%%  %4d/%d", status.track, trackmap,
-           100 * status.sectors_processed / status.total_sectors,
-           status.sectors_processed, status.total_sectors);
+    width = printf("\r%2d: %-24s%3d%%  %4d/%d", status.track, trackmap,
+                   100 * status.sectors_processed / status.total_sectors,
+                   status.sectors_processed, status.total_sectors) - 1;
+
+    /* progress of each destination when reading into several */
+    for(i = 0; status.sink_count > 1 && i < status.sink_count; i++)
+    {
+        width += printf("  %s %d", sink_names[sinks[i].type], status.sinks[i].blocks);
+        if(status.sinks[i].errors)
+        {
+            width += printf("/%d!", status.sinks[i].errors);
+        }
+    }
 
     fflush(stdout);
     return 0;
 }
 
 
+static void print_hex(FILE *f, const unsigned char *data, int len)
+{
+    while(len--)
+    {
+        fprintf(f, "%02x", *data++);
+    }
+}
+
+/*
+ * print the checksums of the image read, and those of each block to
+ * checksum_file if given
+ */
+static int write_checksums(const d64copy_checksums *sums, const char *image)
+{
+    FILE *f;
+    int tr, se;
+
+    printf("CRC32  %08lx  %s\n", sums->image.crc32, image);
+    printf("MD5    ");
+    print_hex(stdout, sums->image.md5, sizeof(sums->image.md5));
+    printf("  %s\nSHA-1  ", image);
+    print_hex(stdout, sums->image.sha1, sizeof(sums->image.sha1));
+    printf("  %s\n", image);
+
+    if(checksum_file == NULL)
+    {
+        return 0;
+    }
+
+    f = fopen(checksum_file, "w");
+    if(f == NULL)
+    {
+        arch_error(0, arch_get_errno(), "%s", checksum_file);
+        return 1;
+    }
+
+    fprintf(f, "# track sector status crc32 md5 sha1\n");
+    for(tr = 1; tr <= sums->tracks; tr++)
+    {
+        for(se = 0; se < MAX_SECTORS; se++)
+        {
+            if(sums->status[tr-1][se])
+            {
+                fprintf(f, "%2d %2d %d %08lx ", tr, se, sums->status[tr-1][se],
+                        sums->block[tr-1][se].crc32);
+                print_hex(f, sums->block[tr-1][se].md5, sizeof(sums->block[tr-1][se].md5));
+                fprintf(f, " ");
+                print_hex(f, sums->block[tr-1][se].sha1, sizeof(sums->block[tr-1][se].sha1));
+                fprintf(f, "\n");
+            }
+        }
+    }
+    return fclose(f) != 0;
+}
+
+/*
+ * tell what became of the destinations of a disk read
+ */
+static int sink_results(void)
+{
+    int i, rv = 0;
+
+    for(i = 0; i < sink_count; i++)
+    {
+        switch(sinks[i].type)
+        {
+            case sk_image:
+                if(sink_result[i].errors)
+                {
+                    my_message_cb(sev_warning, "%d blocks not written to %s",
+                                  sink_result[i].errors, sinks[i].image);
+                }
+                break;
+            case sk_checksum:
+                rv |= write_checksums(sinks[i].checksums, sinks[0].image);
+                break;
+            case sk_compare:
+                my_message_cb(sink_result[i].errors ? sev_warning : sev_info,
+                              "%d of %d blocks differ from %s or were not read",
+                              sink_result[i].errors, sink_result[i].blocks,
+                              sinks[i].image);
+                rv |= sink_result[i].errors != 0;
+                break;
+        }
+    }
+    return rv;
+}
+
 static void ARCH_SIGNALDECL reset(int dummy)
 {
     CBM_FILE fd_cbm_local;
@@ -209,11 +378,323 @@ static void ARCH_SIGNALDECL reset(int dummy)
     printDebugLibD64Counters(my_message_cb);
 #endif
     d64copy_cleanup();
-    cbm_reset(fd_cbm_local);
-    cbm_driver_close(fd_cbm_local);
+    if(farm_jobs)
+    {
+        int i;
+
+        for(i = 0; i < farm_count; i++)
+        {
+            if(farm_jobs[i].is_open)
+            {
+                cbm_reset(farm_jobs[i].fd);
+                cbm_driver_close(farm_jobs[i].fd);
+            }
+        }
+    }
+    else
+    {
+        cbm_reset(fd_cbm_local);
+        cbm_driver_close(fd_cbm_local);
+    }
     exit(1);
 }
 
+/*
+ * print the sector map of the last track of one copy of a drive farm
+ */
+static void farm_print_track(farm_job *job, int percent)
+{
+    const char *s;
+    int errors;
+
+    if(job->last_track == 0 || no_progress)
+    {
+        return;
+    }
+
+    for(errors = 0, s = job->trackmap; *s; s++)
+    {
+        errors += (*s == '?');
+    }
+    arch_mutex_lock(&output_mutex);
+    printf("%-16s %2d: %-24s%3d%%%s\n", job->adapter, job->last_track,
+           job->trackmap, percent, errors ? "  errors" : "");
+    fflush(stdout);
+    arch_mutex_unlock(output_mutex);
+}
+
+/*
+ * progress of the copies of a drive farm: one line per track and adapter
+ */
+static int farm_status_cb(d64copy_status status)
+{
+    farm_job *job = NULL;
+    char *s;
+    char *d;
+    int i;
+
+    for(i = 0; i < farm_count; i++)
+    {
+        if(status.settings == &farm_jobs[i].settings)
+        {
+            job = &farm_jobs[i];
+        }
+    }
+
+    if(job == NULL || status.track == 0)
+    {
+        return 0;
+    }
+
+    if(job->last_track != status.track)
+    {
+        farm_print_track(job, 100 * status.sectors_processed / status.total_sectors);
+
+        for(s = status.bam[status.track-1], d = job->trackmap; *s; s++, d++)
+        {
+            *d = *s == bs_must_copy ? '-' : *s == bs_copied ? '*' : '.';
+        }
+        *d = '\0';
+        job->last_track = status.track;
+    }
+
+    job->trackmap[status.sector] =
+        (status.read_result || status.write_result) ? '?' : '*';
+
+    return 0;
+}
+
+/*
+ * the name of the image of one copy when reading: `%d' in the target
+ * is replaced by the port, else `-port' is inserted before the extension
+ */
+static char *farm_image_name(const char *target, unsigned int port)
+{
+    char number[16];
+    const char *ext;
+    const char *percent;
+    char *head;
+    char *name;
+
+    sprintf(number, "%u", port);
+
+    percent = strstr(target, "%d");
+    if(percent)
+    {
+        head = cbmlibmisc_strndup(target, percent - target);
+        name = cbmlibmisc_strcat(head, number);
+        cbmlibmisc_strfree(head);
+        head = name;
+        name = cbmlibmisc_strcat(head, percent + 2);
+        cbmlibmisc_strfree(head);
+        return name;
+    }
+
+    ext = strrchr(target, '.');
+    if(ext == NULL || strpbrk(ext, "/\\") != NULL)
+    {
+        ext = target + strlen(target);
+    }
+    head = cbmlibmisc_strndup(target, ext - target);
+    name = cbmlibmisc_strcat(head, "-");
+    cbmlibmisc_strfree(head);
+    head = name;
+    name = cbmlibmisc_strcat(head, number);
+    cbmlibmisc_strfree(head);
+    head = name;
+    name = cbmlibmisc_strcat(head, ext);
+    cbmlibmisc_strfree(head);
+    return name;
+}
+
+/*
+ * add the copy with one adapter to the farm
+ */
+static int farm_add(const char *plugin, unsigned int port,
+                    const d64copy_settings *settings,
+                    int drive, int reading, const char *image)
+{
+    farm_job *job;
+    char number[16];
+    char *adapter;
+
+    if(farm_count >= MAX_FARM_JOBS)
+    {
+        my_message_cb(sev_fatal, "more than %d adapters", MAX_FARM_JOBS);
+        return 1;
+    }
+
+    sprintf(number, ":%u", port);
+    adapter = cbmlibmisc_strcat(plugin, number);
+
+    job = &farm_jobs[farm_count++];
+    memset(job, 0, sizeof(*job));
+    job->adapter = adapter;
+    job->image = reading ? farm_image_name(image, port) : cbmlibmisc_strdup(image);
+    job->settings = *settings;
+    job->drive = drive;
+    job->reading = reading;
+
+    return adapter == NULL || job->image == NULL;
+}
+
+/*
+ * parse the ADAPTERS of --farm, entries without a port stand for all
+ * the devices of that plugin
+ */
+static int farm_setup(const char *farm, const d64copy_settings *settings,
+                      int drive, int reading, const char *image)
+{
+    char *list = cbmlibmisc_strdup(farm);
+    char *entry;
+    char *colon;
+    unsigned int ports[MAX_FARM_JOBS];
+    int i, n;
+    int rv = 0;
+
+    farm_jobs = calloc(MAX_FARM_JOBS, sizeof(farm_job));
+    if(list == NULL || farm_jobs == NULL)
+    {
+        cbmlibmisc_strfree(list);
+        return 1;
+    }
+
+    for(entry = strtok(list, ","); entry && rv == 0; entry = strtok(NULL, ","))
+    {
+        colon = strchr(entry, ':');
+        if(colon)
+        {
+            *colon = '\0';
+            rv = farm_add(entry, atoi(colon + 1), settings, drive, reading, image);
+            continue;
+        }
+
+        n = cbm_driver_enumerate_ex(entry, ports, MAX_FARM_JOBS);
+        if(n <= 0)
+        {
+            my_message_cb(sev_fatal, "no devices found for %s", entry);
+            rv = 1;
+        }
+        for(i = 0; i < n && i < MAX_FARM_JOBS && rv == 0; i++)
+        {
+            rv = farm_add(entry, ports[i], settings, drive, reading, image);
+        }
+    }
+
+    cbmlibmisc_strfree(list);
+    return rv;
+}
+
+static void farm_worker(void *context)
+{
+    farm_job *job = context;
+    unsigned long start_ms;
+
+    job->blocks = -1;
+
+    if(cbm_driver_open_ex(&job->fd, job->adapter) != 0)
+    {
+        my_message_cb(sev_fatal, "%s: cannot open adapter", job->adapter);
+        return;
+    }
+    job->is_open = 1;
+
+    job->settings.transfer_mode =
+        d64copy_check_auto_transfer_mode(job->fd,
+            job->settings.transfer_mode, job->drive);
+
+    start_ms = arch_ticks_ms();
+
+    if(job->reading)
+    {
+        job->blocks = d64copy_read_image(job->fd, &job->settings, job->drive,
+                job->image, my_message_cb, farm_status_cb);
+    }
+    else
+    {
+        job->blocks = d64copy_write_image(job->fd, &job->settings, job->image,
+                job->drive, my_message_cb, farm_status_cb);
+    }
+
+    job->elapsed_ms = arch_ticks_ms() - start_ms;
+
+    if(job->blocks >= 0)
+    {
+        farm_print_track(job, 100);
+    }
+
+    job->is_open = 0;
+    cbm_driver_close(job->fd);
+}
+
+/*
+ * copy with all adapters of the farm at the same time. returns 0 if all
+ * copies succeeded.
+ */
+static int farm_copy(void)
+{
+    arch_thread_t *threads[MAX_FARM_JOBS];
+    farm_job *job;
+    int i, rv = 0;
+
+    for(i = 0; i < farm_count; i++)
+    {
+        my_message_cb(sev_info, "%s: %s", farm_jobs[i].adapter, farm_jobs[i].image);
+        threads[i] = arch_thread_create(farm_worker, &farm_jobs[i]);
+        if(threads[i] == NULL)
+        {
+            my_message_cb(sev_warning, "%s: could not start thread, copying now",
+                          farm_jobs[i].adapter);
+            farm_worker(&farm_jobs[i]);
+        }
+    }
+
+    for(i = 0; i < farm_count; i++)
+    {
+        if(threads[i])
+        {
+            arch_thread_join(threads[i]);
+        }
+    }
+
+    printf("\n");
+    for(i = 0; i < farm_count; i++)
+    {
+        job = &farm_jobs[i];
+        if(job->blocks < 0)
+        {
+            printf("%-16s %s: failed\n", job->adapter, job->image);
+            rv = 1;
+        }
+        else if(job->elapsed_ms > 0)
+        {
+            printf("%-16s %s: %d blocks copied in %.1f seconds (%.1f blocks/s)\n",
+                   job->adapter, job->image, job->blocks,
+                   job->elapsed_ms / 1000.0, job->blocks * 1000.0 / job->elapsed_ms);
+        }
+        else
+        {
+            printf("%-16s %s: %d blocks copied\n",
+                   job->adapter, job->image, job->blocks);
+        }
+    }
+    return rv;
+}
+
+static void farm_free(void)
+{
+    int i;
+
+    for(i = 0; i < farm_count; i++)
+    {
+        cbmlibmisc_strfree(farm_jobs[i].adapter);
+        cbmlibmisc_strfree(farm_jobs[i].image);
+    }
+    free(farm_jobs);
+    farm_jobs = NULL;
+    farm_count = 0;
+}
+
 int ARCH_MAINDECL main(int argc, char *argv[])
 {
     d64copy_settings *settings = d64copy_get_default_settings();
@@ -222,10 +703,14 @@ int ARCH_MAINDECL main(int argc, char *argv[])
     char *src_arg;
     char *dst_arg;
     char *adapter = NULL;
+    char *farm = NULL;
 
     int  option;
     int  rv = 1;
     int  l;
+    int  i;
+    unsigned long start_ms;
+    unsigned long elapsed_ms;
 
     int src_is_cbm;
     int dst_is_cbm;
@@ -250,10 +735,15 @@ int ARCH_MAINDECL main(int argc, char *argv[])
         { "retry-count", required_argument, NULL, 'r' },
         { "two-sided"  , no_argument      , NULL, '2' },
         { "error-map"  , required_argument, NULL, 'E' },
+        { "pipeline"   , no_argument      , NULL, 'P' },
+        { "farm"       , required_argument, NULL, 'F' },
+        { "copy-to"    , required_argument, NULL, 'o' },
+        { "checksum"   , optional_argument, NULL, 'c' },
+        { "compare"    , required_argument, NULL, 'C' },
         { NULL         , 0                , NULL, 0   }
     };
 
-    const char shortopts[] ="hVwqbBt:i:s:e:d:r:2vnE:@:";
+    const char shortopts[] ="hVwqbBt:i:s:e:d:r:2vnE:@:PF:o:c::C:";
 
     while((option = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1)
     {
@@ -271,7 +761,14 @@ int ARCH_MAINDECL main(int argc, char *argv[])
                       break;
             case 'n': no_progress = 1;
                       break;
-            case 'i': settings->interleave = arch_atoc(optarg);
+            case 'i': if(arch_strcasecmp(optarg, "auto") == 0)
+                      {
+                          settings->auto_interleave = 1;
+                      }
+                      else
+                      {
+                          settings->interleave = arch_atoc(optarg);
+                      }
                       break;
             case 's': settings->start_track = atoi(optarg);
                       break;
@@ -305,6 +802,38 @@ int ARCH_MAINDECL main(int argc, char *argv[])
                       break;
             case '2': settings->two_sided = 1;
                       break;
+            case 'P': settings->pipeline = 1;
+                      break;
+            case 'F': farm = optarg;
+                      break;
+            case 'o':
+            case 'c':
+            case 'C': if(sink_count >= D64COPY_MAX_SINKS)
+                      {
+                          my_message_cb(sev_fatal, "too many destinations");
+                          return 1;
+                      }
+                      if(option == 'c')
+                      {
+                          for(i = 1; i < sink_count; i++)
+                          {
+                              if(sinks[i].type == sk_checksum)
+                              {
+                                  my_message_cb(sev_fatal, "--checksum/-c given more than once.");
+                                  hint(argv[0]);
+                                  return 1;
+                              }
+                          }
+                          sinks[sink_count].type = sk_checksum;
+                          checksum_file = optarg;
+                      }
+                      else
+                      {
+                          sinks[sink_count].type = option == 'o' ? sk_image : sk_compare;
+                          sinks[sink_count].image = optarg;
+                      }
+                      sink_count++;
+                      break;
             case 'E': l = strlen(optarg);
                       if(strncmp(optarg, "always", l) == 0)
                       {
@@ -377,6 +906,48 @@ int ARCH_MAINDECL main(int argc, char *argv[])
         return 1;
     }
 
+    if(sink_count > 1 && (farm || !src_is_cbm))
+    {
+        my_message_cb(sev_fatal, "--copy-to, --checksum and --compare are only "
+                                 "possible when reading a single drive");
+        return 1;
+    }
+
+    sinks[0].type = sk_image;
+    sinks[0].image = dst_arg;
+    for(i = 1; i < sink_count; i++)
+    {
+        if(sinks[i].type == sk_checksum)
+        {
+            sinks[i].checksums = malloc(sizeof(d64copy_checksums));
+            if(sinks[i].checksums == NULL)
+            {
+                my_message_cb(sev_fatal, "no memory for checksums");
+                return 1;
+            }
+        }
+    }
+
+    if(farm)
+    {
+        if(adapter)
+        {
+            my_message_cb(sev_fatal, "--farm and --adapter cannot be used together");
+            return 1;
+        }
+
+        rv = farm_setup(farm, settings, atoi(src_is_cbm ? src_arg : dst_arg),
+                        src_is_cbm, src_is_cbm ? dst_arg : src_arg);
+        if(rv == 0)
+        {
+            arch_set_ctrlbreak_handler(reset);
+            rv = farm_copy();
+        }
+        farm_free();
+        free(settings);
+        return rv;
+    }
+
     if(cbm_driver_open_ex(&fd_cbm, adapter) == 0)
     {
         /*
@@ -392,7 +963,14 @@ int ARCH_MAINDECL main(int argc, char *argv[])
 
         arch_set_ctrlbreak_handler(reset);
 
-        if(src_is_cbm)
+        start_ms = arch_ticks_ms();
+
+        if(src_is_cbm && sink_count > 1)
+        {
+            rv = d64copy_read_sinks(fd_cbm, settings, atoi(src_arg),
+                    sinks, sink_count, my_message_cb, my_status_cb);
+        }
+        else if(src_is_cbm)
         {
             rv = d64copy_read_image(fd_cbm, settings, atoi(src_arg), dst_arg,
                     my_message_cb, my_status_cb);
@@ -405,11 +983,27 @@ int ARCH_MAINDECL main(int argc, char *argv[])
 
         if(!no_progress && rv >= 0)
         {
-            printf("\n%d blocks copied.\n", rv);
+            elapsed_ms = arch_ticks_ms() - start_ms;
+            if(elapsed_ms > 0)
+            {
+                printf("\n%d blocks copied in %.1f seconds (%.1f blocks/s).\n",
+                       rv, elapsed_ms / 1000.0, rv * 1000.0 / elapsed_ms);
+            }
+            else
+            {
+                printf("\n%d blocks copied.\n", rv);
+            }
         }
 
         cbm_driver_close(fd_cbm);
-        rv = 0;
+        if(rv >= 0 && sink_count > 1)
+        {
+            rv = sink_results();
+        }
+        else
+        {
+            rv = 0;
+        }
     }
     else
     {
@@ -418,6 +1012,10 @@ int ARCH_MAINDECL main(int argc, char *argv[])
 
     cbmlibmisc_strfree(adapter);
     free(settings);
+    for(i = 1; i < sink_count; i++)
+    {
+        free(sinks[i].checksums);
+    }
     
     return rv;
 }
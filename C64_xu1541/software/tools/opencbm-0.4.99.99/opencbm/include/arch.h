@@ -111,6 +111,14 @@ typedef bool BOOL;
 
 int arch_filesize(const char *Filename, off_t *Filesize);
 
+/* memory mapped files, used for disk images */
+typedef struct arch_filemap_s arch_filemap_t;
+#define ARCH_FILEMAP_READ   0 /* existing file, read only */
+#define ARCH_FILEMAP_WRITE  1 /* existing file, resized to the mapped size */
+#define ARCH_FILEMAP_CREATE 2 /* new or truncated file of the mapped size */
+extern arch_filemap_t *arch_filemap_open(const char *Filename, int Mode, off_t Size, unsigned char **Data);
+extern int arch_filemap_close(arch_filemap_t *Map, off_t Size);
+
 #define arch_strdup(_x) ARCH_CBM_LINUX_WIN(strdup(_x), _strdup(_x))
 
 #define arch_fileno(_x) ARCH_CBM_LINUX_WIN(fileno(_x), _fileno(_x))
@@ -129,4 +137,26 @@ int arch_filesize(const char *Filename, off_t *Filesize);
 typedef void (ARCH_SIGNALDECL *ARCH_CTRLBREAK_HANDLER)(int dummy);
 extern void arch_set_ctrlbreak_handler(ARCH_CTRLBREAK_HANDLER Handler);
 
+/* threads, semaphores and mutexes, used for pipelined and parallel transfers */
+typedef struct arch_thread_s arch_thread_t;
+typedef struct arch_sem_s arch_sem_t;
+typedef struct arch_mutex_s arch_mutex_t;
+typedef void (*arch_thread_func)(void *context);
+
+extern arch_thread_t *arch_thread_create(arch_thread_func func, void *context);
+extern void arch_thread_join(arch_thread_t *thread);
+
+extern arch_sem_t *arch_sem_create(unsigned int count);
+extern void arch_sem_wait(arch_sem_t *sem);
+extern void arch_sem_post(arch_sem_t *sem);
+extern void arch_sem_destroy(arch_sem_t *sem);
+
+/* a mutex is created on its first lock, thus, a static "arch_mutex_t *"
+ * initialised to NULL is all that is needed. It is never destroyed. */
+extern void arch_mutex_lock(arch_mutex_t **mutex);
+extern void arch_mutex_unlock(arch_mutex_t *mutex);
+
+/* milliseconds since some arbitrary point in time, for measuring durations */
+extern unsigned long arch_ticks_ms(void);
+
 #endif /* #ifndef CBM_ARCH_H */
@@ -57,8 +57,51 @@ typedef struct
     enum cbm_device_type_e drive_type;
     d64copy_bam_mode bam_mode;
     d64copy_error_mode error_mode;
+    int pipeline;       /* read the drive in a thread of its own */
+    int auto_interleave; /* tune interleave and skew from sector timing */
 } d64copy_settings;
 
+/*
+ *  destinations of d64copy_read_sinks(), every block read is passed
+ *  to all of them
+ */
+typedef enum
+{
+    sk_image,           /* write a .d64/.d71 image file        */
+    sk_checksum,        /* checksums of every block and image  */
+    sk_compare          /* compare with a reference image file */
+} d64copy_sink_type;
+
+#define D64COPY_MAX_SINKS 8
+
+typedef struct
+{
+    unsigned long crc32;
+    unsigned char md5[16];
+    unsigned char sha1[20];
+} d64copy_checksum;
+
+typedef struct
+{
+    int tracks;                 /* of the image the checksums are for */
+    d64copy_checksum image;     /* all blocks, the ones not read are zero */
+    d64copy_checksum block[MAX_TRACKS][MAX_SECTORS];
+    char status[MAX_TRACKS][MAX_SECTORS]; /* 0: not read, 1: ok, else error */
+} d64copy_checksums;
+
+typedef struct
+{
+    d64copy_sink_type type;
+    const char *image;              /* sk_image, sk_compare: file name */
+    d64copy_checksums *checksums;   /* sk_checksum: filled in while copying */
+} d64copy_sink;
+
+typedef struct
+{
+    int blocks;         /* blocks passed to the sink */
+    int errors;         /* not written; sk_compare: not read or different */
+} d64copy_sink_status;
+
 typedef struct
 {
     int track;
@@ -69,6 +112,8 @@ typedef struct
     int total_sectors;
     d64copy_settings *settings;
     char bam[MAX_TRACKS][MAX_SECTORS+1];
+    int sink_count;     /* only with d64copy_read_sinks() */
+    d64copy_sink_status sinks[D64COPY_MAX_SINKS];
 } d64copy_status;
 
 typedef enum
@@ -128,6 +173,18 @@ extern int d64copy_read_image(CBM_FILE cbm_fd,
                               d64copy_message_cb msg_cb,
                               d64copy_status_cb status_cb);
 
+/*
+ * read a disk once and pass every block to all sinks, e.g. two image
+ * files, the checksums and a compare with a reference image
+ */
+extern int d64copy_read_sinks(CBM_FILE cbm_fd,
+                              d64copy_settings *settings,
+                              int src_drive,
+                              const d64copy_sink *sinks,
+                              int sink_count,
+                              d64copy_message_cb msg_cb,
+                              d64copy_status_cb status_cb);
+
 extern int d64copy_write_image(CBM_FILE cbm_fd,
                                d64copy_settings *settings,
                                const char *src_image,
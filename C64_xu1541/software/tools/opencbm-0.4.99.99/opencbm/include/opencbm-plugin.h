@@ -41,6 +41,25 @@ typedef void CBMAPIDECL opencbm_plugin_uninit_t(void);
 */
 typedef const char * CBMAPIDECL opencbm_plugin_get_driver_name_t(const char * const Port);
 
+/*! \brief Enumerate the devices this plugin can open
+
+ \param Ports
+   Pointer to an array which gets the port numbers of the devices
+   that are present, that is, the numbers that can be given as
+   port to opencbm_plugin_driver_open().
+
+ \param Count
+   The number of elements in Ports.
+
+ \return
+   The number of devices found, which might be more than Count;
+   only the first Count are stored. -1 on error.
+
+ \remark
+   This function is optional.
+*/
+typedef int CBMAPIDECL opencbm_plugin_enumerate_t(unsigned int *Ports, unsigned int Count);
+
 /*! \brief @@@@@ \todo document
 
  \param HandleDevice
@@ -306,6 +325,23 @@ typedef int CBMAPIDECL opencbm_plugin_parallel_burst_read_track_t(CBM_FILE Handl
 */
 typedef int CBMAPIDECL opencbm_plugin_parallel_burst_read_track_var_t(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int Length);
 
+/*! \brief Read a complete track, decoded to sectors by the adapter
+
+ \param HandleDevice
+   A CBM_FILE which contains the file handle of the driver.
+
+ \param Buffer
+   Pointer to a buffer which will hold the sector records.
+
+ \param Length
+   The number of raw track bytes to read, also the length of the Buffer.
+
+ \return
+   The number of bytes read, a multiple of CBM_GCR_SECTOR_SIZE; -1 if
+   the adapter does not support it.
+*/
+typedef int CBMAPIDECL opencbm_plugin_parallel_burst_read_track_gcr_t(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int Length);
+
 /*! \brief @@@@@ \todo document
 
  \param HandleDevice
@@ -376,6 +412,36 @@ typedef int CBMAPIDECL opencbm_plugin_s1_read_n_t (CBM_FILE HandleDevice,
 */
 typedef int CBMAPIDECL opencbm_plugin_s1_write_n_t(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size);
 
+/*! \brief run request/response transfers with the OpenCBM backend with protocol serial-1
+
+ Each record consists of writing a request of wrSize bytes and reading
+ a response of rdSize bytes. A backend may overlap the transfers of
+ consecutive records.
+
+ \param HandleDevice  
+   Pointer to a CBM_FILE which will contain the file handle of the OpenCBM backend
+
+ \param wrData
+    Pointer to count requests of wrSize bytes each
+
+ \param wrSize
+    The size of one request, may be 0
+
+ \param rdData
+    Pointer to a buffer which will contain count responses of rdSize bytes each
+
+ \param rdSize
+    The size of one response
+
+ \param count
+    The number of request/response records
+
+ \return
+    The number of records transferred completely.
+    If there is a fatal error, returns -1.
+*/
+typedef int CBMAPIDECL opencbm_plugin_s1_write_read_n_t(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count);
+
 /*! \brief read a block of data from the OpenCBM backend with protocol serial-2
 
  \param HandleDevice  
@@ -410,6 +476,36 @@ typedef int CBMAPIDECL opencbm_plugin_s2_read_n_t (CBM_FILE HandleDevice,
 */
 typedef int CBMAPIDECL opencbm_plugin_s2_write_n_t(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size);
 
+/*! \brief run request/response transfers with the OpenCBM backend with protocol serial-2
+
+ Each record consists of writing a request of wrSize bytes and reading
+ a response of rdSize bytes. A backend may overlap the transfers of
+ consecutive records.
+
+ \param HandleDevice  
+   Pointer to a CBM_FILE which will contain the file handle of the OpenCBM backend
+
+ \param wrData
+    Pointer to count requests of wrSize bytes each
+
+ \param wrSize
+    The size of one request, may be 0
+
+ \param rdData
+    Pointer to a buffer which will contain count responses of rdSize bytes each
+
+ \param rdSize
+    The size of one response
+
+ \param count
+    The number of request/response records
+
+ \return
+    The number of records transferred completely.
+    If there is a fatal error, returns -1.
+*/
+typedef int CBMAPIDECL opencbm_plugin_s2_write_read_n_t(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count);
+
 /*! \brief read a block of data from the OpenCBM backend with protocol parallel/d64copy
 
  \param HandleDevice  
@@ -478,6 +574,36 @@ typedef int CBMAPIDECL opencbm_plugin_pp_dc_read_n_t (CBM_FILE HandleDevice,
 */
 typedef int CBMAPIDECL opencbm_plugin_pp_dc_write_n_t(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size);
 
+/*! \brief run request/response transfers with the OpenCBM backend with protocol parallel/d64copy
+
+ Each record consists of writing a request of wrSize bytes and reading
+ a response of rdSize bytes. A backend may overlap the transfers of
+ consecutive records.
+
+ \param HandleDevice  
+   Pointer to a CBM_FILE which will contain the file handle of the OpenCBM backend
+
+ \param wrData
+    Pointer to count requests of wrSize bytes each
+
+ \param wrSize
+    The size of one request, may be 0
+
+ \param rdData
+    Pointer to a buffer which will contain count responses of rdSize bytes each
+
+ \param rdSize
+    The size of one response
+
+ \param count
+    The number of request/response records
+
+ \return
+    The number of records transferred completely.
+    If there is a fatal error, returns -1.
+*/
+typedef int CBMAPIDECL opencbm_plugin_pp_dc_write_read_n_t(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count);
+
 /*! \brief read a block of data from the OpenCBM backend with protocol parallel/cbmcopy
 
  \param HandleDevice  
@@ -545,6 +671,7 @@ struct opencbm_plugin_s {
     opencbm_plugin_uninit_t                     * opencbm_plugin_uninit;                     /*!< pointer to a opencbm_plugin_uninit() function */
 
     opencbm_plugin_get_driver_name_t            * opencbm_plugin_get_driver_name;            /*!< pointer to a opencbm_plugin_get_driver_name_t() function */
+    opencbm_plugin_enumerate_t                  * opencbm_plugin_enumerate;                  /*!< pointer to a opencbm_plugin_enumerate_t() function */
     opencbm_plugin_driver_open_t                * opencbm_plugin_driver_open;                /*!< pointer to a opencbm_plugin_driver_open_t() function */
     opencbm_plugin_driver_close_t               * opencbm_plugin_driver_close;               /*!< pointer to a opencbm_plugin_driver_close_t() function */
     opencbm_plugin_lock_t                       * opencbm_plugin_lock;                       /*!< pointer to a opencbm_plugin_lock_t() function */
@@ -575,6 +702,7 @@ struct opencbm_plugin_s {
     opencbm_plugin_parallel_burst_read_track_t  * opencbm_plugin_parallel_burst_read_track;  /*!< pointer to a opencbm_plugin_parallel_burst_read_track_t() function */
     opencbm_plugin_parallel_burst_write_track_t * opencbm_plugin_parallel_burst_write_track; /*!< pointer to a opencbm_plugin_parallel_burst_write_track_t() function */
     opencbm_plugin_parallel_burst_read_track_var_t * opencbm_plugin_parallel_burst_read_track_var;  /*!< pointer to a opencbm_plugin_parallel_burst_read_track_var_t() function */
+    opencbm_plugin_parallel_burst_read_track_gcr_t * opencbm_plugin_parallel_burst_read_track_gcr;  /*!< pointer to a opencbm_plugin_parallel_burst_read_track_gcr_t() function */
 
     opencbm_plugin_iec_dbg_read_t               * opencbm_plugin_iec_dbg_read;               /*!< pointer to a opencbm_plugin_iec_dbg_read_t() function */
     opencbm_plugin_iec_dbg_write_t              * opencbm_plugin_iec_dbg_write;              /*!< pointer to a opencbm_plugin_iec_dbg_write_t() function */
@@ -75,9 +75,9 @@ extern void vdd_usleep(CBM_FILE f, unsigned int howlong);
   /* we have linux or Mac */
 
 /*
- * remove this include once the CBM_FILE intptr_t declaration
- * below is changed back to int after the plugin/driver handle
- * mapping was implemented
+ * CBM_FILE is an intptr_t, as the USB plugins hand out a pointer
+ * to the state of the device as handle. libopencbm maps the handles
+ * to the plugins they have been opened with.
  */
 #include <stdint.h>
 
@@ -140,6 +140,7 @@ enum cbm_cable_type_e
 EXTERN int CBMAPIDECL cbm_driver_open(CBM_FILE *f, int port);
 EXTERN int CBMAPIDECL cbm_driver_open_ex(CBM_FILE *f, char * adapter);
 EXTERN void CBMAPIDECL cbm_driver_close(CBM_FILE f);
+EXTERN int CBMAPIDECL cbm_driver_enumerate_ex(char * adapter, unsigned int *ports, unsigned int count);
 EXTERN void CBMAPIDECL cbm_lock(CBM_FILE f);
 EXTERN void CBMAPIDECL cbm_unlock(CBM_FILE f);
 
@@ -216,8 +217,25 @@ EXTERN int CBMAPIDECL cbm_parallel_burst_read_n(CBM_FILE HandleDevice, unsigned
 EXTERN int CBMAPIDECL cbm_parallel_burst_write_n(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int Length);
 EXTERN int CBMAPIDECL  cbm_parallel_burst_read_track(CBM_FILE f, unsigned char *buffer, unsigned int length);
 EXTERN int CBMAPIDECL  cbm_parallel_burst_read_track_var(CBM_FILE f, unsigned char *buffer, unsigned int length);
+EXTERN int CBMAPIDECL  cbm_parallel_burst_read_track_gcr(CBM_FILE f, unsigned char *buffer, unsigned int length);
 EXTERN int CBMAPIDECL cbm_parallel_burst_write_track(CBM_FILE f, unsigned char *buffer, unsigned int length);
 
+
+/* records returned by cbm_parallel_burst_read_track_gcr(), one per sector */
+
+#define CBM_GCR_TRACK            0   /*!< track number from the sector header */
+#define CBM_GCR_SECTOR           1   /*!< sector number from the sector header */
+#define CBM_GCR_ID2              2   /*!< second disk ID byte from the sector header */
+#define CBM_GCR_ID1              3   /*!< first disk ID byte from the sector header */
+#define CBM_GCR_DATA             4   /*!< the 256 data bytes of the sector */
+#define CBM_GCR_STATUS         260   /*!< status, a .d64 error code (see below) */
+#define CBM_GCR_SECTOR_SIZE    261   /*!< size of a record */
+
+#define CBM_GCR_OK               1   /*!< no error */
+#define CBM_GCR_DATA_CHECKSUM    5   /*!< "23" checksum error in data block */
+#define CBM_GCR_DECODE_ERROR     6   /*!< "24" invalid GCR code in data block */
+#define CBM_GCR_HEADER_CHECKSUM  9   /*!< "27" checksum error in header */
+
 /* parallel burst functions end */
 
 /* functions specifically for srq nibbler */
@@ -251,6 +269,7 @@ EXTERN int CBMAPIDECL cbm_tap_break(CBM_FILE f);
 
 /* get function address of the plugin */
 EXTERN void * CBMAPIDECL cbm_get_plugin_function_address(const char * Functionname);
+EXTERN void * CBMAPIDECL cbm_get_plugin_function_address_ex(CBM_FILE f, const char * Functionname);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,357 @@
+/*
+ *	This program is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License
+ *	as published by the Free Software Foundation; either version
+ *	2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Check the table driven GCR codec of libd64copy (libd64copy/gcr.c)
+ * against the scalar gcr_5_to_4_decode() and gcr_4_to_5_encode() of
+ * lib/gcr_4b5b.c, which d64copy used before:
+ *  - every 10 bit code, legal or not, at every byte position of a block
+ *    decodes as with the scalar code, with the same return value
+ *  - every byte value at every block position encodes as with the scalar
+ *    code and decodes back
+ *  - synthetic tracks decode with gcr_decode_track() at every rotation,
+ *    a sector with a bad checksum gets the job code the scalar decoder
+ *    gives
+ * Then both are timed. Built by gcrcodec.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gcr.h"
+
+#define GCR_BLOCK_LENGTH 325    /* 65 groups of 5 GCR bytes */
+#define BENCH_BLOCKS 200000
+#define MAX_SECTORS 21
+
+/* gcr_decode() as it was, one gcr_5_to_4_decode() call per group */
+static int
+scalar_decode(const unsigned char *gcr, unsigned char *decoded)
+{
+    unsigned char chkref[4], chksum = 0;
+    int i, j;
+
+    gcr_5_to_4_decode(gcr, chkref, 5, sizeof(chkref));
+    gcr += 5;
+
+    if (chkref[0] != 0x07)
+        return 4;
+
+    for (j = 1; j < 4; j++, decoded++) {
+        *decoded = chkref[j];
+        chksum ^= chkref[j];
+    }
+
+    for (i = 1; i < BLOCKSIZE / 4; i++) {
+        gcr_5_to_4_decode(gcr, decoded, 5, 4);
+        gcr += 5;
+        for (j = 0; j < 4; j++, decoded++)
+            chksum ^= *decoded;
+    }
+
+    gcr_5_to_4_decode(gcr, chkref, 5, 4);
+    *decoded = chkref[0];
+    chksum ^= chkref[0];
+
+    return (chkref[1] != chksum) ? 5 : 0;
+}
+
+/* gcr_encode() as it was, one gcr_4_to_5_encode() call per group */
+static int
+scalar_encode(const unsigned char *block, unsigned char *encoded)
+{
+    unsigned char chkref[4] = { 0x07, 0, 0, 0 };
+    int i, j;
+
+    for (j = 1; j < 4; j++, block++)
+        chkref[j] = *block;
+    gcr_4_to_5_encode(chkref, encoded, sizeof(chkref), 5);
+    encoded += 5;
+
+    chkref[1] ^= (chkref[2] ^ chkref[3]);
+
+    for (i = 1; i < BLOCKSIZE / 4; i++) {
+        gcr_4_to_5_encode(block, encoded, 4, 5);
+        encoded += 5;
+        for (j = 0; j < 4; j++, block++)
+            chkref[1] ^= *block;
+    }
+
+    chkref[0] = *block;
+    chkref[1] ^= *block;
+    chkref[2] = chkref[3] = 0;
+
+    gcr_4_to_5_encode(chkref, encoded, 4, 5);
+
+    return 0;
+}
+
+static unsigned long random_state = 1;
+
+static unsigned char
+random_byte(void)
+{
+    random_state = (random_state * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return (unsigned char)(random_state >> 16);
+}
+
+static void
+random_block(unsigned char *block)
+{
+    int i;
+
+    for (i = 0; i < BLOCKSIZE; i++)
+        block[i] = random_byte();
+}
+
+/* put a 10 bit code into the bits of byte position pos of a GCR block */
+static void
+put_code(unsigned char *gcr, int pos, unsigned int code)
+{
+    int bit = pos * 10, i;
+
+    for (i = 0; i < 10; i++, bit++) {
+        if (code & (0x200 >> i))
+            gcr[bit / 8] |= 0x80 >> (bit % 8);
+        else
+            gcr[bit / 8] &= ~(0x80 >> (bit % 8));
+    }
+}
+
+/* decode all 10 bit codes at all 260 byte positions of a block */
+static int
+check_decode(void)
+{
+    unsigned char block[BLOCKSIZE], gcr[GCR_BLOCK_LENGTH];
+    unsigned char want[BLOCKSIZE], got[BLOCKSIZE];
+    unsigned int code;
+    int pos, rv_want, rv_got, errors = 0;
+
+    for (pos = 0; pos < GCR_BLOCK_LENGTH * 8 / 10; pos++) {
+        random_block(block);
+        scalar_encode(block, gcr);
+        for (code = 0; code < 1024; code++) {
+            put_code(gcr, pos, code);
+            memset(want, 0xa5, sizeof(want));
+            memset(got, 0xa5, sizeof(got));
+            rv_want = scalar_decode(gcr, want);
+            rv_got = gcr_decode(gcr, got);
+            if (rv_want != rv_got || memcmp(want, got, BLOCKSIZE) != 0) {
+                if (errors++ < 10)
+                    printf("decode: code %03x at %d: %d, expected %d\n",
+                        code, pos, rv_got, rv_want);
+            }
+        }
+    }
+    return errors;
+}
+
+/* encode all byte values at all block positions and decode them back */
+static int
+check_encode(void)
+{
+    unsigned char block[BLOCKSIZE], decoded[BLOCKSIZE];
+    unsigned char want[GCR_BLOCK_LENGTH], got[GCR_BLOCK_LENGTH];
+    int pos, value, rv, errors = 0;
+
+    for (pos = 0; pos < BLOCKSIZE; pos++) {
+        random_block(block);
+        for (value = 0; value < 256; value++) {
+            block[pos] = (unsigned char)value;
+            scalar_encode(block, want);
+            gcr_encode(block, got);
+            rv = gcr_decode(got, decoded);
+            if (memcmp(want, got, sizeof(got)) != 0 || rv != 0 ||
+                memcmp(block, decoded, BLOCKSIZE) != 0) {
+                if (errors++ < 10)
+                    printf("encode: %02x at %d: %s\n", value, pos,
+                        rv ? "no round trip" : "differs");
+            }
+        }
+    }
+    return errors;
+}
+
+static const unsigned char sectors_per_track[] = {
+    21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21,
+    19, 19, 19, 19, 19, 19, 19,
+    18, 18, 18, 18, 18, 18,
+    17, 17, 17, 17, 17
+};
+
+#define SYNC_LENGTH     5
+#define HEADER_GAP      9
+#define SECTOR_GAP      8
+#define SECTOR_LENGTH   (SYNC_LENGTH + 10 + HEADER_GAP + \
+                         SYNC_LENGTH + GCR_BLOCK_LENGTH + SECTOR_GAP)
+#define MAX_TRACK_LENGTH (MAX_SECTORS * SECTOR_LENGTH)
+
+/*
+ * Write a track as the drive formats it, sector bad_sector with a bad
+ * data checksum. The blocks are kept for the check.
+ */
+static size_t
+make_track(int track, int bad_sector, unsigned char *raw,
+    unsigned char *blocks)
+{
+    unsigned char header[8];
+    int sectors = sectors_per_track[track - 1], se;
+    size_t len = 0;
+
+    for (se = 0; se < sectors; se++) {
+        unsigned char *block = blocks + se * BLOCKSIZE;
+
+        memset(raw + len, 0xff, SYNC_LENGTH);
+        len += SYNC_LENGTH;
+        header[0] = 0x08;
+        header[2] = (unsigned char)se;
+        header[3] = (unsigned char)track;
+        header[4] = 0x41;
+        header[5] = 0x42;
+        header[1] = header[2] ^ header[3] ^ header[4] ^ header[5];
+        header[6] = header[7] = 0x0f;
+        gcr_4_to_5_encode(header, raw + len, 4, 5);
+        gcr_4_to_5_encode(header + 4, raw + len + 5, 4, 5);
+        len += 10;
+        memset(raw + len, 0x55, HEADER_GAP);
+        len += HEADER_GAP;
+
+        memset(raw + len, 0xff, SYNC_LENGTH);
+        len += SYNC_LENGTH;
+        random_block(block);
+        scalar_encode(block, raw + len);
+        if (se == bad_sector) {
+            /* flip one data byte, but keep its GCR code legal */
+            block[100] ^= 0x01;
+            gcr_encode(block, raw + len + GCR_BLOCK_LENGTH);
+            memcpy(raw + len + 125, raw + len + GCR_BLOCK_LENGTH + 125, 5);
+            block[100] ^= 0x01;
+        }
+        len += GCR_BLOCK_LENGTH;
+        memset(raw + len, 0x55, SECTOR_GAP);
+        len += SECTOR_GAP;
+    }
+    return len;
+}
+
+/* decode a track at all rotations, check against the scalar decoder */
+static int
+check_track(int track, int bad_sector)
+{
+    static unsigned char raw[MAX_TRACK_LENGTH + GCR_BLOCK_LENGTH];
+    static unsigned char rotated[MAX_TRACK_LENGTH];
+    unsigned char blocks[MAX_SECTORS * BLOCKSIZE];
+    unsigned char want[MAX_SECTORS * BLOCKSIZE];
+    unsigned char got[MAX_SECTORS * BLOCKSIZE];
+    int results[MAX_SECTORS], want_rv[MAX_SECTORS];
+    int sectors = sectors_per_track[track - 1], se, n, good, errors = 0;
+    size_t len, rot;
+
+    len = make_track(track, bad_sector, raw, blocks);
+    good = 0;
+    for (se = 0; se < sectors; se++) {
+        want_rv[se] = scalar_decode(raw + se * SECTOR_LENGTH +
+            SYNC_LENGTH + 10 + HEADER_GAP + SYNC_LENGTH,
+            want + se * BLOCKSIZE);
+        if (want_rv[se] == 0) {
+            good++;
+            if (memcmp(want + se * BLOCKSIZE, blocks + se * BLOCKSIZE,
+                BLOCKSIZE) != 0)
+                errors++;
+        }
+    }
+
+    for (rot = 0; rot < len; rot++) {
+        memcpy(rotated, raw + rot, len - rot);
+        memcpy(rotated + len - rot, raw, rot);
+        memset(got, 0, sizeof(got));
+        n = gcr_decode_track(rotated, len, track, sectors, got, results);
+        for (se = 0; se < sectors; se++) {
+            if (results[se] != want_rv[se] || (want_rv[se] == 0 &&
+                memcmp(got + se * BLOCKSIZE, want + se * BLOCKSIZE,
+                BLOCKSIZE) != 0))
+                break;
+        }
+        if (n != good || se < sectors) {
+            if (errors++ < 10)
+                printf("track %d, rotation %lu: sector %d: %d, expected %d\n",
+                    track, (unsigned long)rot, se,
+                    se < sectors ? results[se] : n,
+                    se < sectors ? want_rv[se] : good);
+        }
+    }
+    return errors;
+}
+
+static double
+mb_per_s(clock_t start, long bytes)
+{
+    double s = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    return s > 0 ? bytes / s / 1e6 : 0;
+}
+
+/* time the scalar and the table driven code on the same blocks */
+static void
+benchmark(void)
+{
+    static unsigned char gcr[16][GCR_BLOCK_LENGTH];
+    unsigned char block[16][BLOCKSIZE], out[BLOCKSIZE];
+    volatile int sink = 0;
+    clock_t start;
+    long i, bytes = (long)BENCH_BLOCKS * BLOCKSIZE;
+    double scalar, table;
+
+    for (i = 0; i < 16; i++) {
+        random_block(block[i]);
+        gcr_encode(block[i], gcr[i]);
+    }
+
+    start = clock();
+    for (i = 0; i < BENCH_BLOCKS; i++)
+        sink += scalar_decode(gcr[i & 15], out);
+    scalar = mb_per_s(start, bytes);
+    start = clock();
+    for (i = 0; i < BENCH_BLOCKS; i++)
+        sink += gcr_decode(gcr[i & 15], out);
+    table = mb_per_s(start, bytes);
+    printf("decode: scalar %.0f MB/s, table %.0f MB/s\n", scalar, table);
+
+    start = clock();
+    for (i = 0; i < BENCH_BLOCKS; i++)
+        sink += scalar_encode(block[i & 15], gcr[i & 15]);
+    scalar = mb_per_s(start, bytes);
+    start = clock();
+    for (i = 0; i < BENCH_BLOCKS; i++)
+        sink += gcr_encode(block[i & 15], gcr[i & 15]);
+    table = mb_per_s(start, bytes);
+    printf("encode: scalar %.0f MB/s, table %.0f MB/s\n", scalar, table);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int decode_errors, encode_errors, track_errors = 0;
+
+    decode_errors = check_decode();
+    printf("decode: %d mismatches\n", decode_errors);
+    encode_errors = check_encode();
+    printf("encode: %d mismatches\n", encode_errors);
+
+    track_errors += check_track(1, -1);
+    track_errors += check_track(18, 7);
+    track_errors += check_track(25, 0);
+    track_errors += check_track(35, 16);
+    printf("tracks: %d mismatches\n", track_errors);
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0)
+        benchmark();
+
+    return decode_errors + encode_errors + track_errors != 0;
+}
@@ -0,0 +1,38 @@
+#!/bin/bash
+#
+# Build the GCR codec of libd64copy for the host together with the
+# scalar one of lib/gcr_4b5b.c and check that they agree on all inputs.
+# With -b, both are timed afterwards.
+#
+# set -x
+
+function error_info {
+	echo "gcrcodec.sh [-b]" 1>&2
+	echo  1>&2
+	echo "-b:          run the micro-benchmark after the check" 1>&2
+	exit 1
+	}
+
+if [ $# -gt 1 ] || { [ $# -eq 1 ] && [ "$1" != "-b" ]; }
+then
+	error_info
+fi
+
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+OPENCBMDIR=$TESTDIR/../..
+CC=${CC:-cc}
+
+BUILDDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$BUILDDIR"' EXIT
+
+$CC -Wall -O2 -I"$OPENCBMDIR/include" -I"$OPENCBMDIR/include/LINUX" \
+	-I"$OPENCBMDIR/libd64copy" -o "$BUILDDIR/gcrcodec" \
+	"$TESTDIR/gcrcodec.c" "$OPENCBMDIR/libd64copy/gcr.c" \
+	"$OPENCBMDIR/lib/gcr_4b5b.c" || exit 1
+
+if ! "$BUILDDIR/gcrcodec" "$@"
+then
+	echo "gcrcodec: FAILED" 1>&2
+	exit 1
+fi
+echo "gcrcodec: ok"
@@ -0,0 +1,186 @@
+/*
+ *	This program is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License
+ *	as published by the Free Software Foundation; either version
+ *	2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Run the GCR decoder of the xum1541 firmware (xum1541/gcr.c) on the
+ * tracks of a .nib or .g64 image and list the sector records it returns
+ * for XUM1541_NIB_GCR. If a .d64 is given, the data of the sectors read
+ * ok is compared against it. Built by gcrdecode.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xum1541.h"
+#include "gcr.h"
+
+/* as much as nibtools reads per track, about 1.3 revolutions */
+#define NIB_TRACK_LENGTH 0x2000
+
+static unsigned char record_buffer[NIB_TRACK_LENGTH];
+static unsigned int record_length;
+
+int8_t
+usbSendByte(uint8_t data)
+{
+    if (record_length >= sizeof(record_buffer))
+        return -1;
+    record_buffer[record_length++] = data;
+    return 0;
+}
+
+static const unsigned char sectors_per_track[] = {
+    21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21,
+    19, 19, 19, 19, 19, 19, 19,
+    18, 18, 18, 18, 18, 18,
+    17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17
+};
+
+static unsigned char *d64;
+static long d64_size;
+
+static long
+d64_offset(unsigned int track, unsigned int sector)
+{
+    long offset = 0;
+    unsigned int t;
+
+    if (track < 1 || track > sizeof(sectors_per_track) ||
+        sector >= sectors_per_track[track - 1])
+        return -1;
+    for (t = 1; t < track; t++)
+        offset += sectors_per_track[t - 1];
+    offset = (offset + sector) * 256;
+    return offset + 256 <= d64_size ? offset : -1;
+}
+
+static unsigned char *
+read_file(const char *name, long *size)
+{
+    FILE *f;
+    unsigned char *buffer;
+
+    f = fopen(name, "rb");
+    if (f == NULL) {
+        perror(name);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    rewind(f);
+    buffer = malloc(*size);
+    if (buffer == NULL || fread(buffer, 1, *size, f) != (size_t)*size) {
+        fprintf(stderr, "%s: cannot read\n", name);
+        free(buffer);
+        buffer = NULL;
+    }
+    fclose(f);
+    return buffer;
+}
+
+/* decode one track, list the records, return the number of mismatches */
+static int
+decode_track(unsigned int track, const unsigned char *raw, unsigned int len)
+{
+    unsigned int i;
+    int mismatches = 0;
+
+    record_length = 0;
+    gcr_decode_init(NIB_TRACK_LENGTH);
+    for (i = 0; i < NIB_TRACK_LENGTH; i++) {
+        if (gcr_decode_byte(raw[i % len]) != 0) {
+            printf("%2u: output overflow\n", track);
+            return 1;
+        }
+    }
+
+    if (record_length % XUM_GCR_SECTOR_SIZE != 0) {
+        printf("%2u: %u bytes are no whole records\n", track, record_length);
+        return 1;
+    }
+
+    for (i = 0; i < record_length; i += XUM_GCR_SECTOR_SIZE) {
+        const unsigned char *rec = record_buffer + i;
+        long offset;
+
+        printf("%2u: %2u/%2u %02x%02x %u", track,
+            rec[XUM_GCR_TRACK], rec[XUM_GCR_SECTOR],
+            rec[XUM_GCR_ID1], rec[XUM_GCR_ID2], rec[XUM_GCR_STATUS]);
+
+        if (d64 != NULL && rec[XUM_GCR_STATUS] == XUM_GCR_OK) {
+            offset = d64_offset(rec[XUM_GCR_TRACK], rec[XUM_GCR_SECTOR]);
+            if (offset >= 0 &&
+                memcmp(rec + XUM_GCR_DATA, d64 + offset, 256) != 0) {
+                printf(" data differs");
+                mismatches++;
+            }
+        }
+        printf("\n");
+    }
+    return mismatches;
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned char *image;
+    long size;
+    unsigned int i, track;
+    int mismatches = 0;
+
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <image.nib|image.g64> [<reference.d64>]\n",
+            argv[0]);
+        return 2;
+    }
+
+    image = read_file(argv[1], &size);
+    if (image == NULL)
+        return 2;
+    if (argc > 2 && (d64 = read_file(argv[2], &d64_size)) == NULL)
+        return 2;
+
+    if (size >= 0x100 && memcmp(image, "MNIB-1541-RAW", 13) == 0) {
+        /* header with (halftrack, density) pairs, then the tracks */
+        for (i = 0; 0x10 + 2 * i < 0x100 && image[0x10 + 2 * i] != 0; i++) {
+            long offset = 0x100 + (long)i * NIB_TRACK_LENGTH;
+
+            if (offset + NIB_TRACK_LENGTH > size)
+                break;
+            track = image[0x10 + 2 * i];
+            if (track & 1)
+                continue;
+            mismatches += decode_track(track / 2, image + offset,
+                NIB_TRACK_LENGTH);
+        }
+    } else if (size >= 12 && memcmp(image, "GCR-1541", 8) == 0) {
+        /* offset table of the halftracks, each with its length first */
+        for (i = 0; i < image[9] && 12 + 4 * i + 4 <= (unsigned long)size;
+            i++) {
+            const unsigned char *p = image + 12 + 4 * i;
+            unsigned long offset, len;
+
+            offset = p[0] | p[1] << 8 | (unsigned long)p[2] << 16 |
+                (unsigned long)p[3] << 24;
+            if (offset == 0 || (i & 1) || offset + 2 > (unsigned long)size)
+                continue;
+            len = image[offset] | image[offset + 1] << 8;
+            if (len == 0 || offset + 2 + len > (unsigned long)size)
+                continue;
+            /* one revolution only, so read it around as the drive does */
+            mismatches += decode_track(i / 2 + 1, image + offset + 2, len);
+        }
+    } else {
+        fprintf(stderr, "%s: neither a .nib nor a .g64 image\n", argv[1]);
+        return 2;
+    }
+
+    free(image);
+    free(d64);
+    return mismatches != 0;
+}
@@ -0,0 +1,60 @@
+#!/bin/bash
+#
+# Build the GCR decoder of the xum1541 firmware for the host and run it
+# on captured tracks. Without parameters, errored41.nib is checked
+# against the expected records in errored41.gcr, one line per record:
+# track read, track/sector and ids from the header, status. See
+# errored41.txt for the errors on the tracks.
+#
+# set -x
+
+function error_info {
+	echo "gcrdecode.sh [<image.nib|image.g64> [<reference.d64>]]" 1>&2
+	echo  1>&2
+	echo "image:       tracks to decode, the records are listed" 1>&2
+	echo "reference:   compare the data of the sectors read ok" 1>&2
+	exit 1
+	}
+
+if [ $# -gt 2 ]
+then
+	error_info
+fi
+
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+XUMDIR=$TESTDIR/../../../xum1541
+CC=${CC:-cc}
+
+BUILDDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$BUILDDIR"' EXIT
+
+# The firmware headers need the AVR toolchain, so stand in for xum1541.h.
+cp "$XUMDIR/gcr.c" "$XUMDIR/gcr.h" "$XUMDIR/xum1541_types.h" "$BUILDDIR" || exit 1
+cat > "$BUILDDIR/xum1541.h" <<EOF
+#include <stdint.h>
+#include <stdbool.h>
+#include "xum1541_types.h"
+int8_t usbSendByte(uint8_t data);
+EOF
+
+$CC -Wall -O2 -I"$BUILDDIR" -o "$BUILDDIR/gcrdecode" \
+	"$TESTDIR/gcrdecode.c" "$BUILDDIR/gcr.c" || exit 1
+
+if [ $# -gt 0 ]
+then
+	"$BUILDDIR/gcrdecode" "$@"
+	exit $?
+fi
+
+"$BUILDDIR/gcrdecode" "$TESTDIR/errored41.nib" > "$BUILDDIR/errored41.gcr"
+RESULT=$?
+if ! diff -u "$TESTDIR/errored41.gcr" "$BUILDDIR/errored41.gcr"
+then
+	RESULT=1
+fi
+if [ $RESULT -ne 0 ]
+then
+	echo "gcrdecode: FAILED" 1>&2
+	exit 1
+fi
+echo "gcrdecode: ok"
@@ -0,0 +1,318 @@
+/*
+ *	This program is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License
+ *	as published by the Free Software Foundation; either version
+ *	2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Run usbSendByte() and usbIoDone() of the xum1541 firmware
+ * (xum1541/commands.c) against a model of the double banked IN endpoint
+ * and a host which collects the packets with gaps in between. A track is
+ * sent at the pace of the drive, and the cycles the byte loop is held up
+ * are counted. The data must reach the host complete and in order, the
+ * sender may only wait once both banks and the SRAM ring are full, and
+ * an abort must return with both banks pending. Built by usbring.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xum1541.h"
+
+#define CPU_MHZ         16
+#define US(x)           ((unsigned long)(x) * CPU_MHZ)
+#define MS(x)           US((x) * 1000UL)
+#define CALL_CYCLES     4       /* one endpoint register access */
+#define LOOP_CYCLES     24      /* the byte loop around usbSendByte() */
+#define PACKET_CYCLES   US(20)  /* the host takes a packet */
+#define TRACK_LENGTH    0x2000  /* a nib track read */
+#define BYTE_CYCLES     US(30)  /* a byte from the drive */
+#define HANG_CYCLES     MS(1000)
+
+volatile bool doDeviceReset;
+
+/* the IN endpoint: the bank being filled and the banks for the host */
+static uint8_t bank[XUM_ENDPOINT_BULK_SIZE];
+static uint16_t fill;
+static uint8_t pending[2][XUM_ENDPOINT_BULK_SIZE];
+static uint16_t pendingLength[2];
+static unsigned long pendingSince[2];
+static int pendingCount;
+static int writeErrors;
+
+/* the host */
+static unsigned long now, hostFree, gapStart, gapLength, gapPeriod;
+static unsigned long abortAt, hangAt;
+static uint8_t received[TRACK_LENGTH];
+static unsigned int receivedLength;
+
+/* the first time from t on the host is not away */
+static unsigned long
+host_time(unsigned long t)
+{
+    unsigned long ofs;
+
+    if (gapLength == 0 || t < gapStart)
+        return t;
+    ofs = (t - gapStart) % gapPeriod;
+    return ofs < gapLength ? t + gapLength - ofs : t;
+}
+
+/* the host collects the packets which are due by now */
+static void
+host_run(void)
+{
+    unsigned long t;
+
+    while (pendingCount != 0) {
+        t = pendingSince[0] > hostFree ? pendingSince[0] : hostFree;
+        t = host_time(t);
+        if (t > now)
+            break;
+        if (receivedLength + pendingLength[0] <= sizeof(received)) {
+            memcpy(received + receivedLength, pending[0], pendingLength[0]);
+            receivedLength += pendingLength[0];
+        }
+        pendingCount--;
+        memmove(pending[0], pending[1], pendingLength[1]);
+        pendingLength[0] = pendingLength[1];
+        pendingSince[0] = pendingSince[1];
+        hostFree = t + PACKET_CYCLES;
+    }
+}
+
+static void
+tick(void)
+{
+    now += CALL_CYCLES;
+    host_run();
+    if (abortAt != 0 && now >= abortAt)
+        doDeviceReset = true;
+    if (now >= hangAt) {
+        printf("hangs at %lu us\n", now / CPU_MHZ);
+        exit(1);
+    }
+}
+
+void
+Endpoint_SelectEndpoint(uint8_t ep)
+{
+}
+
+bool
+Endpoint_IsReadWriteAllowed(void)
+{
+    tick();
+    return pendingCount < 2 && fill < XUM_ENDPOINT_BULK_SIZE;
+}
+
+void
+Endpoint_Write_Byte(uint8_t data)
+{
+    tick();
+    if (pendingCount == 2 || fill == XUM_ENDPOINT_BULK_SIZE) {
+        writeErrors++;
+        return;
+    }
+    bank[fill++] = data;
+}
+
+void
+Endpoint_ClearIN(void)
+{
+    tick();
+    if (pendingCount == 2)
+        return;
+    memcpy(pending[pendingCount], bank, fill);
+    pendingLength[pendingCount] = fill;
+    pendingSince[pendingCount] = now;
+    pendingCount++;
+    fill = 0;
+}
+
+uint16_t
+Endpoint_BytesInEndpoint(void)
+{
+    tick();
+    return fill;
+}
+
+uint8_t
+Endpoint_Read_Byte(void)
+{
+    return 0;
+}
+
+void
+Endpoint_ClearOUT(void)
+{
+}
+
+uint8_t
+Endpoint_Discard_Stream(uint16_t len, uint8_t (*callback)(void))
+{
+    return 0;
+}
+
+uint8_t
+AbortOnReset(void)
+{
+    return doDeviceReset;
+}
+
+struct run {
+    unsigned long stall;        /* cycles the byte loop was held up */
+    unsigned int late;          /* bytes after the next one was due */
+    int firstStall;             /* the first byte held up, or -1 */
+    unsigned int sent;
+};
+
+/* send a track at the pace of the drive */
+static void
+send_track(struct run *r)
+{
+    unsigned long ready, start, behind, wasBehind = 0;
+    unsigned int i;
+
+    memset(r, 0, sizeof(*r));
+    r->firstStall = -1;
+    fill = 0;
+    pendingCount = 0;
+    receivedLength = 0;
+    writeErrors = 0;
+    doDeviceReset = false;
+    now = hostFree = 0;
+    hangAt = HANG_CYCLES;
+
+    usbInitIo(TRACK_LENGTH, ENDPOINT_DIR_IN);
+    start = now;
+    for (i = 0; i < TRACK_LENGTH; i++) {
+        ready = start + i * BYTE_CYCLES;
+        if (now < ready)
+            now = ready;
+        behind = now - ready;
+        if (behind > wasBehind) {
+            r->stall += behind - wasBehind;
+            if (r->firstStall < 0)
+                r->firstStall = i;
+        }
+        if (behind > BYTE_CYCLES)
+            r->late++;
+        wasBehind = behind;
+        now += LOOP_CYCLES;
+        if (usbSendByte((uint8_t)(i * 5 + (i >> 8))) != 0)
+            break;
+        r->sent++;
+    }
+    usbIoDone();
+
+    // Let the host collect what was handed to it.
+    hangAt = now + HANG_CYCLES;
+    while (pendingCount != 0)
+        tick();
+}
+
+/* the host got the first n bytes sent, in order */
+static int
+check_data(const char *name, unsigned int n)
+{
+    unsigned int i;
+
+    if (writeErrors != 0) {
+        printf("%s: %d writes to a full endpoint\n", name, writeErrors);
+        return 1;
+    }
+    if (receivedLength != n) {
+        printf("%s: host got %u of %u bytes\n", name, receivedLength, n);
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        if (received[i] != (uint8_t)(i * 5 + (i >> 8))) {
+            printf("%s: byte %u out of order\n", name, i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* the host is away gap ms every period ms */
+static int
+check_gaps(unsigned long gap, unsigned long period)
+{
+    struct run r;
+    char name[32];
+
+    sprintf(name, "gap %lu/%lu ms", gap, period);
+    gapStart = MS(1);
+    gapLength = MS(gap);
+    gapPeriod = MS(period);
+    abortAt = 0;
+    send_track(&r);
+    printf("%s: %u late bytes, %lu stall cycles\n", name, r.late, r.stall);
+    return check_data(name, TRACK_LENGTH);
+}
+
+/*
+ * With the host away from the start, the sender must fill both banks and
+ * the ring before it waits, and it must go on in order afterwards. The
+ * ring holds one byte less than its size, the byte after the one which
+ * finds it full is the first one behind.
+ */
+static int
+check_ring_full(void)
+{
+    struct run r;
+    int expect = 2 * XUM_ENDPOINT_BULK_SIZE + XUM_USB_RING_SIZE;
+
+    gapStart = 0;
+    gapLength = MS(20);
+    gapPeriod = MS(1000);
+    abortAt = 0;
+    send_track(&r);
+    printf("ring full: behind from byte %d, %lu stall cycles\n",
+        r.firstStall, r.stall);
+    if (r.firstStall != expect) {
+        printf("ring full: expected to be behind from byte %d\n", expect);
+        return 1;
+    }
+    return check_data("ring full", TRACK_LENGTH);
+}
+
+/* an abort while both banks and the ring are full must return */
+static int
+check_abort(void)
+{
+    struct run r;
+
+    gapStart = 0;
+    gapLength = MS(1000);
+    gapPeriod = MS(2000);
+    abortAt = MS(50);
+    send_track(&r);
+    printf("abort: returned after %u bytes\n", r.sent);
+    if (r.sent >= TRACK_LENGTH || writeErrors != 0) {
+        printf("abort: not stopped\n");
+        return 1;
+    }
+    // The banks already handed to the host arrive, the ring is dropped.
+    return check_data("abort", 2 * XUM_ENDPOINT_BULK_SIZE);
+}
+
+int
+main(void)
+{
+    int errors = 0;
+
+    printf("endpoint %d bytes, ring %d bytes\n", XUM_ENDPOINT_BULK_SIZE,
+        XUM_USB_RING_SIZE);
+    errors += check_gaps(0, 1);
+    errors += check_gaps(2, 8);
+    errors += check_gaps(3, 16);
+    errors += check_gaps(5, 16);
+    errors += check_ring_full();
+    errors += check_abort();
+
+    return errors != 0;
+}
@@ -0,0 +1,81 @@
+#!/bin/bash
+#
+# Build the USB send path of the xum1541 firmware (usbSendByte() and
+# usbIoDone() in commands.c) for the host, with the LUFA endpoint
+# functions modelled in usbring.c. A nib track is sent to a host which
+# collects the packets with gaps in between, for the 32 byte endpoint of
+# the AT90USB162 and the 64 byte one of the AT90USB1287. The cycles the
+# byte loop is held up are listed per track.
+#
+# set -x
+
+if [ $# -gt 0 ]
+then
+	echo "usbring.sh" 1>&2
+	exit 1
+fi
+
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+XUMDIR=$TESTDIR/../../../xum1541
+CC=${CC:-cc}
+
+BUILDDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$BUILDDIR"' EXIT
+
+# The firmware headers need the AVR toolchain and LUFA, so stand in for
+# them in xum1541.h and keep the firmware's own definitions.
+cp "$XUMDIR/commands.c" "$XUMDIR/gcr.h" "$XUMDIR/xum1541_types.h" \
+	"$BUILDDIR" || exit 1
+cat > "$BUILDDIR/xum1541.h" <<EOT
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "xum1541_types.h"
+
+#define ENDPOINT_DIR_IN         0x80
+#define ENDPOINT_DIR_OUT        0x00
+void Endpoint_SelectEndpoint(uint8_t ep);
+bool Endpoint_IsReadWriteAllowed(void);
+void Endpoint_Write_Byte(uint8_t data);
+uint8_t Endpoint_Read_Byte(void);
+void Endpoint_ClearIN(void);
+void Endpoint_ClearOUT(void);
+uint16_t Endpoint_BytesInEndpoint(void);
+uint8_t Endpoint_Discard_Stream(uint16_t len, uint8_t (*callback)(void));
+void Endpoint_ClearSETUP(void);
+bool Endpoint_IsINReady(void);
+void USB_ShutDown(void);
+
+#define IO_DATA                 0x01
+#define DELAY_MS(x)
+#define wdt_disable()
+#define cli()
+void cpu_bootloader_start(void);
+void board_init_iec(void);
+void board_set_status(uint8_t status);
+void iec_release(uint8_t line);
+uint8_t iec_pp_read(void);
+void iec_pp_write(uint8_t data);
+EOT
+sed -n '/^#ifdef DEBUG$/,/^#endif \/\/ _XUM1541_H/p' "$XUMDIR/xum1541.h" |
+	sed '$d' >> "$BUILDDIR/xum1541.h"
+
+# Only the USB functions are linked, the rest of commands.c is dropped.
+RESULT=0
+for CPU in "" -D__AVR_AT90USB1287__
+do
+	$CC -Wall -O2 $CPU -ffunction-sections -Wl,--gc-sections \
+		-I"$BUILDDIR" -o "$BUILDDIR/usbring" \
+		"$TESTDIR/usbring.c" "$BUILDDIR/commands.c" || exit 1
+	if ! "$BUILDDIR/usbring"
+	then
+		RESULT=1
+	fi
+done
+
+if [ $RESULT -ne 0 ]
+then
+	echo "usbring: FAILED" 1>&2
+	exit 1
+fi
+echo "usbring: ok"
@@ -0,0 +1,413 @@
+/*
+ *	This program is free software; you can redistribute it and/or
+ *	modify it under the terms of the GNU General Public License
+ *	as published by the Free Software Foundation; either version
+ *	2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Run the transfers of the xum1541 plugin (lib/plugin/xum1541/xum1541.c)
+ * against a libusb table which stands in for the adapter, and count the
+ * USB transfers per record. The adapter is modelled the way the firmware
+ * works: it takes a command block, then the data of a write, or sends
+ * the response of a read. While it is sending to the host, its OUT
+ * endpoint has room for one more transfer only; a second one, or a read
+ * the adapter has nothing to send for, would hang on real hardware and
+ * fails here, as does an odd length for the parallel protocol, which the
+ * adapter moves 2 bytes at a time. The write_block() of libd64copy/pp.c
+ * is run on top, to check that it sends what the drive expects. Built by
+ * xum1541loop.sh.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opencbm.h"
+#include "opencbm-plugin.h"
+#include "d64copy_int.h"
+#include "dynlibusb.h"
+#include "xum1541.h"
+
+#define MAX_RECORDS 32
+#define MAX_REQUEST (2 + 2 + GCRBUFSIZE)
+#define MAX_RESPONSE (1 + 256)
+
+/* the adapter */
+static enum { IDLE, WAIT_DATA, SENDING } state;
+static unsigned char bank[XUM_CMDBUF_SIZE + MAX_REQUEST];
+static int bank_length;             /* 0: OUT endpoint empty */
+static unsigned char mode;          /* of the current command */
+static int size;                    /* of the current command */
+static unsigned char request[MAX_REQUEST];
+static int request_length;
+static unsigned char last_write[MAX_REQUEST];   /* the data of a write */
+static int last_write_length;
+static unsigned char response[MAX_RESPONSE];
+static int response_length, response_pos;
+static int records;                 /* responses sent */
+static int short_record;            /* this response is one byte short */
+
+static int transfers;               /* bulk transfers of the host */
+static int hangs;                   /* transfers which would not return */
+
+/* the response the adapter sends for a request */
+static unsigned char
+response_byte(int record, const unsigned char *req, int req_length, int i)
+{
+    if (req_length == 0)
+        return (unsigned char)(record * 7 + i);
+    return (unsigned char)(req[i % req_length] ^ (record + i));
+}
+
+/* let the adapter go on until it has to wait for the host */
+static void
+adapter_run(void)
+{
+    int i;
+
+    for (;;) {
+        if (state == SENDING) {
+            if (response_pos < response_length)
+                return;
+            state = IDLE;
+        }
+        if (bank_length == 0)
+            return;
+
+        if (state == IDLE) {
+            if (bank_length != XUM_CMDBUF_SIZE ||
+                (bank[0] != XUM1541_READ && bank[0] != XUM1541_WRITE)) {
+                printf("adapter: bad command block\n");
+                hangs++;
+                bank_length = 0;
+                return;
+            }
+            mode = bank[1];
+            size = bank[2] | bank[3] << 8;
+            if (mode == XUM1541_PP && size % 2) {
+                printf("adapter: odd length %d for the 2 byte loop\n", size);
+                hangs++;
+            }
+            if (bank[0] == XUM1541_WRITE) {
+                state = WAIT_DATA;
+            } else {
+                response_length = size;
+                if (records == short_record)
+                    response_length--;
+                for (i = 0; i < response_length && i < MAX_RESPONSE; i++)
+                    response[i] = response_byte(records, request,
+                        request_length, i);
+                response_pos = 0;
+                records++;
+                request_length = 0;
+                state = SENDING;
+            }
+        } else {
+            if (bank_length != size || size > MAX_REQUEST) {
+                printf("adapter: %d data bytes for a write of %d\n",
+                    bank_length, size);
+                hangs++;
+            }
+            memcpy(request, bank, bank_length);
+            request_length = bank_length;
+            memcpy(last_write, bank, bank_length);
+            last_write_length = bank_length;
+            state = IDLE;
+        }
+        bank_length = 0;
+    }
+}
+
+static int
+mock_bulk_write(usb_dev_handle *dev, int ep, const char *bytes, int length,
+    int timeout)
+{
+    transfers++;
+    adapter_run();
+    if (bank_length != 0 || length > (int)sizeof(bank)) {
+        printf("host: write of %d bytes while the OUT endpoint is full\n",
+            length);
+        hangs++;
+        return -1;
+    }
+    memcpy(bank, bytes, length);
+    bank_length = length;
+    adapter_run();
+    return length;
+}
+
+static int
+mock_bulk_read(usb_dev_handle *dev, int ep, char *bytes, int length,
+    int timeout)
+{
+    int n;
+
+    transfers++;
+    adapter_run();
+    if (state != SENDING) {
+        printf("host: read of %d bytes with no response coming\n", length);
+        hangs++;
+        return -1;
+    }
+    n = response_length - response_pos;
+    if (n > length)
+        n = length;
+    memcpy(bytes, response + response_pos, n);
+    response_pos += n;
+    adapter_run();
+    return n;
+}
+
+static char *
+mock_strerror(void)
+{
+    return "mock error";
+}
+
+usb_dll_t usb;
+
+static void
+reset(int short_at)
+{
+    state = IDLE;
+    bank_length = 0;
+    request_length = 0;
+    last_write_length = 0;
+    records = 0;
+    short_record = short_at;
+    transfers = 0;
+    hangs = 0;
+}
+
+/* the adapter has nothing left over */
+static int
+adapter_done(void)
+{
+    adapter_run();
+    return state == IDLE && bank_length == 0;
+}
+
+static struct xum1541_usb_handle handle;
+
+/*
+ * count records with wrSize and rdSize bytes, transfers_per_record are
+ * expected; the last of them is one byte short if short_at is not -1
+ */
+static int
+check_batch(const char *name, unsigned char proto, int wrSize, int rdSize,
+    int count, int short_at, int transfers_per_record)
+{
+    static unsigned char wr[MAX_RECORDS * MAX_REQUEST];
+    static unsigned char rd[MAX_RECORDS * MAX_RESPONSE];
+    int i, j, ret, expect, executed, errors = 0;
+
+    for (i = 0; i < count * wrSize; i++)
+        wr[i] = (unsigned char)(i * 13 + 5);
+    memset(rd, 0, sizeof(rd));
+
+    reset(short_at);
+    ret = xum1541_write_read_n(&handle, proto, wr, wrSize, rd, rdSize, count);
+
+    /* after a short response, the record already queued is finished */
+    expect = short_at < 0 ? count : short_at;
+    executed = short_at < 0 ? count :
+        (short_at + 2 < count ? short_at + 2 : count);
+    if (ret != expect || records != executed) {
+        printf("%s: %d records done, %d run, expected %d and %d\n", name,
+            ret, records, expect, executed);
+        errors++;
+    }
+    for (i = 0; i < expect; i++) {
+        for (j = 0; j < rdSize; j++) {
+            if (rd[i * rdSize + j] !=
+                response_byte(i, wr + i * wrSize, wrSize, j)) {
+                printf("%s: record %d differs at %d\n", name, i, j);
+                errors++;
+                break;
+            }
+        }
+    }
+    if (hangs || !adapter_done()) {
+        printf("%s: the transfers would hang\n", name);
+        errors++;
+    }
+    if (transfers != executed * transfers_per_record) {
+        printf("%s: %d transfers for %d records, expected %d each\n", name,
+            transfers, executed, transfers_per_record);
+        errors++;
+    }
+    printf("%s: %d records, %d transfers\n", name, executed, transfers);
+    return errors;
+}
+
+/* the s1 read_block of libd64copy without xum1541_write_read_n() */
+static int
+check_single_block(void)
+{
+    unsigned char tr = 18, se = 1, status, block[256];
+    int errors = 0;
+
+    reset(-1);
+    if (xum1541_write(&handle, XUM1541_S1, &tr, 1) != 1 ||
+        xum1541_write(&handle, XUM1541_S1, &se, 1) != 1 ||
+        xum1541_read(&handle, XUM1541_S1, &status, 1) != 1 ||
+        xum1541_read(&handle, XUM1541_S1, block, sizeof(block)) !=
+        sizeof(block) || hangs || !adapter_done()) {
+        printf("single: transfer failed\n");
+        errors++;
+    }
+    printf("single: 1 block, %d transfers\n", transfers);
+    if (transfers != 8)
+        errors++;
+    return errors;
+}
+
+/* what libd64copy/pp.c needs besides the plugin */
+static int CBMAPIDECL
+pp_dc_write_read_n(CBM_FILE HandleDevice, const unsigned char *wrData,
+    unsigned int wrSize, unsigned char *rdData, unsigned int rdSize,
+    unsigned int count)
+{
+    return xum1541_write_read_n(&handle, XUM1541_PP, wrData, wrSize,
+        rdData, rdSize, count);
+}
+
+void * CBMAPIDECL
+cbm_get_plugin_function_address_ex(CBM_FILE f, const char *Functionname)
+{
+    if (strcmp(Functionname, "opencbm_plugin_pp_dc_write_read_n") == 0)
+        return pp_dc_write_read_n;
+    return NULL;
+}
+
+unsigned char CBMAPIDECL cbm_pp_read(CBM_FILE f) { return 0; }
+void CBMAPIDECL cbm_pp_write(CBM_FILE f, unsigned char c) { }
+int CBMAPIDECL cbm_iec_get(CBM_FILE f, int line) { return 0; }
+void CBMAPIDECL cbm_iec_set(CBM_FILE f, int line) { }
+void CBMAPIDECL cbm_iec_release(CBM_FILE f, int line) { }
+int CBMAPIDECL cbm_iec_wait(CBM_FILE f, int line, int state) { return 0; }
+int CBMAPIDECL cbm_upload(CBM_FILE f, unsigned char dev, int adr,
+    const void *prog, size_t size) { return (int)size; }
+int d64copy_sector_count(int two_sided, int track) { return 0; }
+int d64copy_track_request(unsigned char *request, unsigned char tr,
+    const unsigned char *sectors, int count) { return 0; }
+
+static int
+pp_start(CBM_FILE fd, unsigned char drive)
+{
+    return 0;
+}
+
+/*
+ * write_block() of the pp transfer with size bytes: the adapter must get
+ * the stream the drive gets without the plugin function, the track, the
+ * sector and the data, with the first data byte sent twice for an odd
+ * size, in 4 transfers. A warp write has GCRBUFSIZE - 1 bytes.
+ */
+static int
+check_pp_write(const char *name, int size)
+{
+    extern transfer_funcs d64copy_pp_transfer;
+    unsigned char blk[GCRBUFSIZE], want[MAX_REQUEST];
+    d64copy_settings settings;
+    void *state;
+    int i, j, n, status, errors = 0;
+
+    memset(&settings, 0, sizeof(settings));
+    settings.drive_type = cbm_dt_cbm1541;
+    state = calloc(1, d64copy_pp_transfer.state_size);
+    d64copy_pp_transfer.open_disk(state, 0, &settings, (void *)8, 1,
+        pp_start, NULL);
+
+    for (i = 0; i < size; i++)
+        blk[i] = (unsigned char)(i * 11 + 3);
+    n = 0;
+    want[n++] = 18;
+    want[n++] = 5;
+    j = 0;
+    if (size % 2) {
+        memcpy(want + n, blk, 2);
+        n += 2;
+        j = 1;
+    }
+    memcpy(want + n, blk + j, size - j);
+    n += size - j;
+
+    reset(-1);
+    status = d64copy_pp_transfer.write_block(state, 18, 5, blk, size, 1);
+    if (last_write_length % 2) {
+        printf("%s: odd transfer length %d\n", name, last_write_length);
+        errors++;
+    }
+    if (last_write_length != n || memcmp(last_write, want, n) != 0) {
+        printf("%s: %d bytes sent, expected %d of the legacy stream\n", name,
+            last_write_length, n);
+        errors++;
+    }
+    if (status != response_byte(0, want, n, 1)) {
+        printf("%s: status %d\n", name, status);
+        errors++;
+    }
+    if (hangs || !adapter_done()) {
+        printf("%s: the transfers would hang\n", name);
+        errors++;
+    }
+    if (transfers != 4) {
+        printf("%s: %d transfers, expected 4\n", name, transfers);
+        errors++;
+    }
+    printf("%s: %d bytes, %d transfers\n", name, last_write_length, transfers);
+    free(state);
+    return errors;
+}
+
+/* requests the plugin must turn down without a transfer */
+static int
+check_rejected(void)
+{
+    unsigned char buf[4];
+    int errors = 0;
+
+    reset(-1);
+    if (xum1541_write_read_n(&handle, XUM1541_CBM, buf, 2, buf, 1, 1) >= 0)
+        errors++;
+    if (xum1541_write_read_n(&handle, XUM1541_S1, buf, 2, buf, 0, 1) >= 0)
+        errors++;
+    if (xum1541_write_read_n(&handle, XUM1541_S1, buf, XUM_MAX_XFER_SIZE + 1,
+        buf, 1, 1) >= 0)
+        errors++;
+    if (xum1541_write_read_n(&handle, XUM1541_TAP, buf, 2, buf, 1, 1) >= 0)
+        errors++;
+    if (errors || transfers != 0)
+        printf("rejected: %d accepted, %d transfers\n", errors, transfers);
+    return errors || transfers != 0;
+}
+
+int
+main(void)
+{
+    int errors = 0;
+
+    usb.bulk_write = mock_bulk_write;
+    usb.bulk_read = mock_bulk_read;
+    usb.strerror = mock_strerror;
+    handle.devh = NULL;
+    handle.DeviceDriveMode = DeviceDriveMode_Disk;
+
+    errors += check_single_block();
+    /* read_block: track and sector, status and block */
+    errors += check_batch("read", XUM1541_S1, 2, 1 + 256, 1, -1, 4);
+    errors += check_batch("track", XUM1541_S2, 2, 1 + 256, 21, -1, 4);
+    /* write_block: track, sector and GCR data, status */
+    errors += check_batch("write", XUM1541_PP, 2 + 326, 2, 17, -1, 4);
+    /* read_gcr_block: sector number and status */
+    errors += check_batch("gcr", XUM1541_S1, 0, 2, 19, -1, 2);
+    errors += check_batch("short", XUM1541_S1, 2, 1 + 256, 10, 5, 4);
+    errors += check_batch("last", XUM1541_NIB, 2, 1 + 256, 10, 9, 4);
+    errors += check_pp_write("pp block", BLOCKSIZE);
+    errors += check_pp_write("pp warp", GCRBUFSIZE - 1);
+    errors += check_rejected();
+
+    return errors != 0;
+}
@@ -0,0 +1,76 @@
+#!/bin/bash
+#
+# Build the transfer code of the xum1541 plugin for the host against a
+# libusb table which models the adapter, and check the USB transfers
+# xum1541_write_read_n() makes: the records come back right, nothing
+# would hang on the adapter's single OUT endpoint, and a block takes 4
+# transfers instead of the 8 of separate reads and writes. The pp transfer
+# of libd64copy is built in as well, for its use of the plugin.
+#
+# set -x
+
+if [ $# -gt 0 ]
+then
+	echo "xum1541loop.sh" 1>&2
+	exit 1
+fi
+
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+OPENCBMDIR=$TESTDIR/../..
+XUMDIR=$OPENCBMDIR/../xum1541
+CC=${CC:-cc}
+
+BUILDDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$BUILDDIR"' EXIT
+
+# libusb-0.1 need not be installed, so stand in for the part of usb.h
+# the plugin uses.
+cat > "$BUILDDIR/usb.h" <<EOT
+#ifndef USB_H
+#define USB_H
+
+#define USB_ENDPOINT_IN         0x80
+#define USB_ENDPOINT_OUT        0x00
+#define USB_TYPE_CLASS          (0x01 << 5)
+#define USB_RECIP_ENDPOINT      0x02
+#define USB_REQ_CLEAR_FEATURE   0x01
+#define USB_REQ_GET_DESCRIPTOR  0x06
+#define USB_DT_STRING           0x03
+
+typedef struct usb_dev_handle usb_dev_handle;
+
+struct usb_device_descriptor {
+    unsigned short idVendor, idProduct, bcdDevice;
+    unsigned char iProduct, iSerialNumber;
+};
+
+struct usb_device {
+    struct usb_device *next;
+    char filename[1];
+    struct usb_device_descriptor descriptor;
+};
+
+struct usb_bus {
+    struct usb_bus *next;
+    char dirname[1];
+    struct usb_device *devices;
+};
+
+#endif
+EOT
+
+$CC -Wall -O2 -I"$BUILDDIR" -I"$OPENCBMDIR/include" \
+	-I"$OPENCBMDIR/include/LINUX" -I"$OPENCBMDIR/libmisc" \
+	-I"$OPENCBMDIR/lib/plugin/xum1541" -I"$OPENCBMDIR/libd64copy" \
+	-I"$XUMDIR" -Wno-misleading-indentation \
+	-o "$BUILDDIR/xum1541loop" "$TESTDIR/xum1541loop.c" \
+	"$OPENCBMDIR/lib/plugin/xum1541/xum1541.c" \
+	"$OPENCBMDIR/libd64copy/pp.c" "$OPENCBMDIR/libmisc/statedebug.c" \
+	"$OPENCBMDIR/arch/linux/thread.c" -lpthread || exit 1
+
+if ! "$BUILDDIR/xum1541loop"
+then
+	echo "xum1541loop: FAILED" 1>&2
+	exit 1
+fi
+echo "xum1541loop: ok"
@@ -29,6 +29,7 @@
 #endif
 
 EXTERN opencbm_plugin_get_driver_name_t            opencbm_plugin_get_driver_name;
+EXTERN opencbm_plugin_enumerate_t                  opencbm_plugin_enumerate;
 EXTERN opencbm_plugin_driver_open_t                opencbm_plugin_driver_open;
 EXTERN opencbm_plugin_driver_close_t               opencbm_plugin_driver_close;
 EXTERN opencbm_plugin_lock_t                       opencbm_plugin_lock;
@@ -60,6 +61,7 @@ EXTERN opencbm_plugin_parallel_burst_read_n_t      opencbm_plugin_parallel_burst
 EXTERN opencbm_plugin_parallel_burst_write_n_t     opencbm_plugin_parallel_burst_write_n;
 EXTERN opencbm_plugin_parallel_burst_read_track_t  opencbm_plugin_parallel_burst_read_track;
 EXTERN opencbm_plugin_parallel_burst_read_track_var_t opencbm_plugin_parallel_burst_read_track_var;
+EXTERN opencbm_plugin_parallel_burst_read_track_gcr_t opencbm_plugin_parallel_burst_read_track_gcr;
 EXTERN opencbm_plugin_parallel_burst_write_track_t opencbm_plugin_parallel_burst_write_track;
 EXTERN opencbm_plugin_parallel_burst_read_t        opencbm_plugin_srq_burst_read;
 EXTERN opencbm_plugin_parallel_burst_write_t       opencbm_plugin_srq_burst_write;
@@ -84,10 +86,13 @@ EXTERN opencbm_plugin_tap_break_t                  opencbm_plugin_tap_break;
 
 EXTERN opencbm_plugin_s1_read_n_t                  opencbm_plugin_s1_read_n;
 EXTERN opencbm_plugin_s1_write_n_t                 opencbm_plugin_s1_write_n;
+EXTERN opencbm_plugin_s1_write_read_n_t            opencbm_plugin_s1_write_read_n;
 EXTERN opencbm_plugin_s2_read_n_t                  opencbm_plugin_s2_read_n;
 EXTERN opencbm_plugin_s2_write_n_t                 opencbm_plugin_s2_write_n;
+EXTERN opencbm_plugin_s2_write_read_n_t            opencbm_plugin_s2_write_read_n;
 EXTERN opencbm_plugin_pp_dc_read_n_t               opencbm_plugin_pp_dc_read_n;
 EXTERN opencbm_plugin_pp_dc_write_n_t              opencbm_plugin_pp_dc_write_n;
+EXTERN opencbm_plugin_pp_dc_write_read_n_t         opencbm_plugin_pp_dc_write_read_n;
 EXTERN opencbm_plugin_pp_cc_read_n_t               opencbm_plugin_pp_cc_read_n;
 EXTERN opencbm_plugin_pp_cc_write_n_t              opencbm_plugin_pp_cc_write_n;
 
@@ -112,17 +112,39 @@ int plugin_set_inactive(const char PluginName[])
 }
 
 
-/*! \brief @@@@@ \todo document */
+/*! \brief a loaded plugin, shared by all handles opened with it */
 struct plugin_information_s {
-    SHARED_OBJECT_HANDLE Library; /*!< \brief @@@@@ \todo document */
-    opencbm_plugin_t     Plugin;  /*!< \brief @@@@@ \todo document */
+    struct plugin_information_s *Next; /*!< \brief the next loaded plugin */
+    char *               Name;     /*!< \brief the name of the plugin in the configuration */
+    unsigned int         RefCount; /*!< \brief the number of users of this plugin */
+    SHARED_OBJECT_HANDLE Library;  /*!< \brief @@@@@ \todo document */
+    opencbm_plugin_t     Plugin;   /*!< \brief @@@@@ \todo document */
 };
 
 /*! \brief @@@@@ \todo document */
 typedef struct plugin_information_s plugin_information_t;
 
-static
-struct plugin_information_s Plugin_information = { 0 };
+/*! \brief the plugin a CBM_FILE has been opened with */
+struct handle_information_s {
+    struct handle_information_s *Next; /*!< \brief the next open handle */
+    CBM_FILE              HandleDevice; /*!< \brief the handle, as returned by the plugin */
+    plugin_information_t *Plugin;       /*!< \brief the plugin which opened the handle */
+};
+
+/*! \brief the plugin a CBM_FILE has been opened with */
+typedef struct handle_information_s handle_information_t;
+
+/*! \brief the loaded plugins */
+static plugin_information_t *Plugin_list = NULL;
+
+/*! \brief the open handles */
+static handle_information_t *Handle_list = NULL;
+
+/*! \brief protects Plugin_list and Handle_list */
+static arch_mutex_t *Plugin_mutex = NULL;
+
+/*! \brief used for handles if no plugin is loaded at all */
+static plugin_information_t No_plugin = { 0 };
 
 struct plugin_read_pointer
 {
@@ -171,6 +193,7 @@ static struct plugin_read_pointer plugin_pointer_to_read_optional[] =
 {
     PLUGIN_POINTER_DEF(opencbm_plugin_init),
     PLUGIN_POINTER_DEF(opencbm_plugin_uninit),
+    PLUGIN_POINTER_DEF(opencbm_plugin_enumerate),
 	PLUGIN_POINTER_DEF(opencbm_plugin_lock),
 	PLUGIN_POINTER_DEF(opencbm_plugin_unlock),
 	PLUGIN_POINTER_DEF(opencbm_plugin_iec_set),
@@ -179,6 +202,7 @@ static struct plugin_read_pointer plugin_pointer_to_read_optional[] =
 	PLUGIN_POINTER_DEF(opencbm_plugin_parallel_burst_write),
 	PLUGIN_POINTER_DEF(opencbm_plugin_parallel_burst_read_track),
 	PLUGIN_POINTER_DEF(opencbm_plugin_parallel_burst_write_track),
+	PLUGIN_POINTER_DEF(opencbm_plugin_parallel_burst_read_track_gcr),
 	PLUGIN_POINTER_DEF(opencbm_plugin_pp_read),
 	PLUGIN_POINTER_DEF(opencbm_plugin_pp_write),
     PLUGIN_POINTER_END()
@@ -341,7 +365,7 @@ read_plugin_pointer_groups(
 }
 
 static int
-initialize_plugin_pointer(plugin_information_t *Plugin_information, const char * const Adapter)
+get_plugin_location(const char * const Adapter, char ** PluginName, char ** PluginLocation)
 {
     int error = 1;
 
@@ -418,21 +442,50 @@ initialize_plugin_pointer(plugin_information_t *Plugin_information, const char *
         }
         DBG_PRINT((DBG_PREFIX "Using plugin at '%s'", plugin_location ? plugin_location : "(none)"));
 
+        if (plugin_name == NULL || plugin_location == NULL) {
+            break;
+        }
+
+        error = 0;
+
+    } while (0);
+
+    if (error) {
+        cbmlibmisc_strfree(plugin_name);
+        cbmlibmisc_strfree(plugin_location);
+        plugin_name = NULL;
+        plugin_location = NULL;
+    }
+
+    *PluginName = plugin_name;
+    *PluginLocation = plugin_location;
+
+    cbmlibmisc_strfree(configurationFilename);
+
+    return error;
+}
+
+static int
+initialize_plugin_pointer(plugin_information_t *Plugin_information, const char * const PluginLocation)
+{
+    int error = 1;
+
+    do {
         memset(&Plugin_information->Plugin, 0, sizeof(Plugin_information->Plugin));
 
-        Plugin_information->Library = plugin_load(plugin_location);
+        Plugin_information->Library = plugin_load(PluginLocation);
 
         DBG_PRINT((DBG_PREFIX "plugin_load() returned %p", Plugin_information->Library));
 
         if (!Plugin_information->Library) {
-            DBG_ERROR((DBG_PREFIX "Could not open plugin driver at '%s'.\n", plugin_location));
+            DBG_ERROR((DBG_PREFIX "Could not open plugin driver at '%s'.\n", PluginLocation));
             break;
         }
 
         error = read_plugin_pointer_groups(Plugin_information, read_pointer_group);
         if (error) {
             DBG_ERROR((DBG_PREFIX "The entry points of plugin %s do not validate correctly.\n",
-                                  plugin_location));
+                                  PluginLocation));
             break;
         }
 
@@ -440,7 +493,7 @@ initialize_plugin_pointer(plugin_information_t *Plugin_information, const char *
             error = Plugin_information->Plugin.opencbm_plugin_init();
             if (error) {
                 DBG_ERROR((DBG_PREFIX "Plugin %s fails to initialize itself.\n",
-                            plugin_location));
+                            PluginLocation));
                 if (Plugin_information->Plugin.opencbm_plugin_uninit) {
                     Plugin_information->Plugin.opencbm_plugin_uninit();
                 }
@@ -450,49 +503,149 @@ initialize_plugin_pointer(plugin_information_t *Plugin_information, const char *
 
     } while (0);
 
-    cbmlibmisc_strfree(plugin_name);
-    cbmlibmisc_strfree(plugin_location);
-    cbmlibmisc_strfree(configurationFilename);
-
     return error;
 }
 
 static void
-uninitialize_plugin(void)
+uninitialize_plugin(plugin_information_t *Plugin_information)
 {
-    if (Plugin_information.Library != NULL)
+    if (Plugin_information->Library != NULL)
     {
-        if (Plugin_information.Plugin.opencbm_plugin_uninit) {
-            Plugin_information.Plugin.opencbm_plugin_uninit();
+        if (Plugin_information->Plugin.opencbm_plugin_uninit) {
+            Plugin_information->Plugin.opencbm_plugin_uninit();
         }
 
-        plugin_unload(Plugin_information.Library);
+        plugin_unload(Plugin_information->Library);
 
-        Plugin_information.Library = NULL;
+        Plugin_information->Library = NULL;
     }
 }
 
-static int
-initialize_plugin(const char * const Adapter)
+/*! \brief Get a plugin, load it if it is not loaded yet
+
+ Every plugin is loaded only once, and shared by all handles
+ that are opened with it. The plugin is unloaded when the last
+ user calls release_plugin().
+
+ \param Adapter
+   The name of the plugin, or NULL for the default plugin.
+
+ \return
+   Pointer to the plugin information, or NULL on error.
+*/
+static plugin_information_t *
+acquire_plugin(const char * const Adapter)
 {
-    /* if library is already opened and initialized correctly then 
-       this function returns OK */
-    int error = 0;
+    plugin_information_t *plugin = NULL;
+    char * plugin_name = NULL;
+    char * plugin_location = NULL;
 
-    /* init pointers if library was not yet opened */
-    if (Plugin_information.Library == NULL)
-    {
-        /* if pointer init failed then close library and make Library NULL */
-        error = initialize_plugin_pointer(&Plugin_information, Adapter);
-        if(error != 0)
-        {
-            uninitialize_plugin();
+    arch_mutex_lock(&Plugin_mutex);
+
+    do {
+        if (get_plugin_location(Adapter, &plugin_name, &plugin_location)) {
+            break;
+        }
+
+        for (plugin = Plugin_list; plugin != NULL; plugin = plugin->Next) {
+            if (strcmp(plugin->Name, plugin_name) == 0) {
+                break;
+            }
         }
+
+        if (plugin == NULL) {
+            plugin = calloc(1, sizeof(*plugin));
+            if (plugin == NULL) {
+                break;
+            }
+
+            /* if pointer init failed then close library and forget it */
+            if (initialize_plugin_pointer(plugin, plugin_location) != 0) {
+                uninitialize_plugin(plugin);
+                free(plugin);
+                plugin = NULL;
+                break;
+            }
+
+            plugin->Name = plugin_name;
+            plugin_name = NULL;
+            plugin->Next = Plugin_list;
+            Plugin_list = plugin;
+        }
+
+        ++plugin->RefCount;
+
+    } while (0);
+
+    arch_mutex_unlock(Plugin_mutex);
+
+    cbmlibmisc_strfree(plugin_name);
+    cbmlibmisc_strfree(plugin_location);
+
+    return plugin;
+}
+
+/*! \brief Release a plugin obtained by acquire_plugin()
+
+ \param Plugin_information
+   The plugin to release. It is unloaded if it has no more users.
+*/
+static void
+release_plugin(plugin_information_t *Plugin_information)
+{
+    plugin_information_t **pprev;
+
+    arch_mutex_lock(&Plugin_mutex);
+
+    if (--Plugin_information->RefCount == 0) {
+        for (pprev = &Plugin_list; *pprev != NULL; pprev = &(*pprev)->Next) {
+            if (*pprev == Plugin_information) {
+                *pprev = Plugin_information->Next;
+                break;
+            }
+        }
+        uninitialize_plugin(Plugin_information);
+        cbmlibmisc_strfree(Plugin_information->Name);
+        free(Plugin_information);
     }
 
-    return error;
+    arch_mutex_unlock(Plugin_mutex);
+}
+
+/*! \brief Get the plugin a handle has been opened with
+
+ \param HandleDevice
+   A CBM_FILE which contains the file handle of the driver.
+
+ \return
+   Pointer to the plugin information. If HandleDevice is not
+   known, this is the plugin loaded last, so applications that
+   pass a handle of their own to a single plugin go on working.
+*/
+static plugin_information_t *
+handle_plugin(CBM_FILE HandleDevice)
+{
+    handle_information_t *handle;
+    plugin_information_t *plugin;
+
+    arch_mutex_lock(&Plugin_mutex);
+
+    plugin = Plugin_list;
+    for (handle = Handle_list; handle != NULL; handle = handle->Next) {
+        if (handle->HandleDevice == HandleDevice) {
+            plugin = handle->Plugin;
+            break;
+        }
+    }
+
+    arch_mutex_unlock(Plugin_mutex);
+
+    return plugin != NULL ? plugin : &No_plugin;
 }
 
+/*! \brief The functions of the plugin a handle has been opened with */
+#define PLUGIN(_handle) (handle_plugin(_handle)->Plugin)
+
 // #define DBG_DUMP_RAW_READ
 // #define DBG_DUMP_RAW_WRITE
 
@@ -588,7 +741,7 @@ cbm_get_driver_name_ex(char * Adapter)
     char *adapter_stripped = NULL;
     char *port = NULL;
 
-    int error;
+    plugin_information_t *plugin;
 
     FUNC_ENTER();
 
@@ -608,10 +761,10 @@ cbm_get_driver_name_ex(char * Adapter)
             Adapter, adapter_stripped, port));
     }
 
-    error = initialize_plugin(adapter_stripped);
+    plugin = acquire_plugin(adapter_stripped);
 
-    if (error == 0) {
-        ret = Plugin_information.Plugin.opencbm_plugin_get_driver_name(port);
+    if (plugin != NULL) {
+        ret = plugin->Plugin.opencbm_plugin_get_driver_name(port);
     }
     else {
         ret = "NO PLUGIN DRIVER!";
@@ -619,6 +772,10 @@ cbm_get_driver_name_ex(char * Adapter)
 
     buffer = cbmlibmisc_strdup(ret);
 
+    if (plugin != NULL) {
+        release_plugin(plugin);
+    }
+
     cbmlibmisc_strfree(adapter_stripped);
     cbmlibmisc_strfree(port);
 
@@ -682,9 +839,11 @@ cbm_get_driver_name(int PortNumber)
 int CBMAPIDECL 
 cbm_driver_open_ex(CBM_FILE *HandleDevice, char * Adapter)
 {
-    int error;
+    int error = 1;
     char * port = NULL;
     char * adapter_stripped = NULL;
+    plugin_information_t *plugin;
+    handle_information_t *handle;
 
     FUNC_ENTER();
 
@@ -698,12 +857,31 @@ cbm_driver_open_ex(CBM_FILE *HandleDevice, char * Adapter)
             Adapter, adapter_stripped, port));
     }
 
-    error = initialize_plugin(adapter_stripped);
+    plugin = acquire_plugin(adapter_stripped);
 
     cbmlibmisc_strfree(adapter_stripped);
 
+    handle = malloc(sizeof(*handle));
+
+    if (plugin != NULL && handle != NULL) {
+        error = plugin->Plugin.opencbm_plugin_driver_open(HandleDevice, port);
+    }
+
     if (error == 0) {
-        error = Plugin_information.Plugin.opencbm_plugin_driver_open(HandleDevice, port);
+        /* remember the plugin, all other calls with this handle go to it */
+        handle->HandleDevice = *HandleDevice;
+        handle->Plugin = plugin;
+
+        arch_mutex_lock(&Plugin_mutex);
+        handle->Next = Handle_list;
+        Handle_list = handle;
+        arch_mutex_unlock(Plugin_mutex);
+    }
+    else {
+        free(handle);
+        if (plugin != NULL) {
+            release_plugin(plugin);
+        }
     }
 
     cbmlibmisc_strfree(port);
@@ -750,6 +928,53 @@ cbm_driver_open(CBM_FILE *HandleDevice, int PortNumber)
     FUNC_LEAVE_INT(cbm_driver_open_ex(HandleDevice, number));
 }
 
+/*! \brief Enumerate the devices of an adapter
+
+ This function finds out which devices of an adapter are present,
+ for example, the serial numbers of all xum1541 attached to the PC.
+
+ \param Adapter
+   The name of the adapter to be used, without a port. NULL means
+   the default adapter.
+
+ \param Ports
+   Pointer to an array which gets the ports of the devices found.
+   Each of them can be given as port to cbm_driver_open_ex(), that
+   is, as "adapter:port".
+
+ \param Count
+   The number of elements in Ports.
+
+ \return
+   The number of devices found, which might be more than Count;
+   only the first Count are stored. -1 if the adapter cannot
+   enumerate its devices.
+
+ \remark
+   Each of the devices can be opened with a handle of its own, and
+   the handles can be used in parallel from different threads.
+*/
+
+int CBMAPIDECL
+cbm_driver_enumerate_ex(char * Adapter, unsigned int *Ports, unsigned int Count)
+{
+    plugin_information_t *plugin;
+    int ret = -1;
+
+    FUNC_ENTER();
+
+    plugin = acquire_plugin(Adapter);
+
+    if (plugin != NULL) {
+        if (plugin->Plugin.opencbm_plugin_enumerate) {
+            ret = plugin->Plugin.opencbm_plugin_enumerate(Ports, Count);
+        }
+        release_plugin(plugin);
+    }
+
+    FUNC_LEAVE_INT(ret);
+}
+
 /*! \brief Closes the driver
 
  Closes the driver, which has be opened with cbm_driver_open() before.
@@ -767,11 +992,28 @@ cbm_driver_open(CBM_FILE *HandleDevice, int PortNumber)
 void CBMAPIDECL
 cbm_driver_close(CBM_FILE HandleDevice)
 {
+    handle_information_t **pprev;
+    handle_information_t *handle = NULL;
+
     FUNC_ENTER();
 
-    Plugin_information.Plugin.opencbm_plugin_driver_close(HandleDevice);
+    arch_mutex_lock(&Plugin_mutex);
+
+    for (pprev = &Handle_list; *pprev != NULL; pprev = &(*pprev)->Next) {
+        if ((*pprev)->HandleDevice == HandleDevice) {
+            handle = *pprev;
+            *pprev = handle->Next;
+            break;
+        }
+    }
+
+    arch_mutex_unlock(Plugin_mutex);
 
-    uninitialize_plugin();
+    if (handle != NULL) {
+        handle->Plugin->Plugin.opencbm_plugin_driver_close(HandleDevice);
+        release_plugin(handle->Plugin);
+        free(handle);
+    }
 
     FUNC_LEAVE();
 }
@@ -805,8 +1047,8 @@ cbm_lock(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_lock)
-        Plugin_information.Plugin.opencbm_plugin_lock(HandleDevice);
+    if (PLUGIN(HandleDevice).opencbm_plugin_lock)
+        PLUGIN(HandleDevice).opencbm_plugin_lock(HandleDevice);
 
     FUNC_LEAVE();
 }
@@ -833,8 +1075,8 @@ cbm_unlock(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_unlock)
-        Plugin_information.Plugin.opencbm_plugin_unlock(HandleDevice);
+    if (PLUGIN(HandleDevice).opencbm_plugin_unlock)
+        PLUGIN(HandleDevice).opencbm_plugin_unlock(HandleDevice);
 
     FUNC_LEAVE();
 }
@@ -875,7 +1117,7 @@ cbm_raw_write(CBM_FILE HandleDevice, const void *Buffer, size_t Count)
     DBG_MEMDUMP("cbm_raw_write", Buffer, Count);
 #endif
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_raw_write(HandleDevice,Buffer, Count));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_raw_write(HandleDevice,Buffer, Count));
 }
 
 
@@ -909,7 +1151,7 @@ cbm_raw_read(CBM_FILE HandleDevice, void *Buffer, size_t Count)
 
     FUNC_ENTER();
 
-    bytesRead = Plugin_information.Plugin.opencbm_plugin_raw_read(HandleDevice, Buffer, Count);
+    bytesRead = PLUGIN(HandleDevice).opencbm_plugin_raw_read(HandleDevice, Buffer, Count);
 
 #ifdef DBG_DUMP_RAW_READ
     DBG_MEMDUMP("cbm_raw_read", Buffer, bytesRead);
@@ -946,7 +1188,7 @@ cbm_listen(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char Sec
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_listen(HandleDevice, DeviceAddress, SecondaryAddress));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_listen(HandleDevice, DeviceAddress, SecondaryAddress));
 }
 
 /*! \brief Send a TALK on the IEC serial bus
@@ -977,7 +1219,7 @@ cbm_talk(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char Secon
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_talk(HandleDevice, DeviceAddress, SecondaryAddress));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_talk(HandleDevice, DeviceAddress, SecondaryAddress));
 }
 
 /*! \brief Open a file on the IEC serial bus
@@ -1016,7 +1258,7 @@ cbm_open(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char Secon
 
     FUNC_ENTER();
 
-    returnValue = Plugin_information.Plugin.opencbm_plugin_open(HandleDevice, DeviceAddress, SecondaryAddress);
+    returnValue = PLUGIN(HandleDevice).opencbm_plugin_open(HandleDevice, DeviceAddress, SecondaryAddress);
 
     if (returnValue == 0)
     {
@@ -1073,7 +1315,7 @@ cbm_close(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char Seco
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_close(HandleDevice, DeviceAddress, SecondaryAddress));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_close(HandleDevice, DeviceAddress, SecondaryAddress));
 }
 
 /*! \brief Send an UNLISTEN on the IEC serial bus
@@ -1101,7 +1343,7 @@ cbm_unlisten(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_unlisten(HandleDevice));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_unlisten(HandleDevice));
 }
 
 /*! \brief Send an UNTALK on the IEC serial bus
@@ -1129,7 +1371,7 @@ cbm_untalk(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_untalk(HandleDevice));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_untalk(HandleDevice));
 }
 
 
@@ -1158,7 +1400,7 @@ cbm_get_eoi(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_get_eoi(HandleDevice));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_get_eoi(HandleDevice));
 }
 
 /*! \brief Reset the EOI flag
@@ -1181,7 +1423,7 @@ cbm_clear_eoi(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_clear_eoi(HandleDevice));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_clear_eoi(HandleDevice));
 }
 
 /*! \brief RESET all devices
@@ -1210,7 +1452,7 @@ cbm_reset(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_reset(HandleDevice));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_reset(HandleDevice));
 }
 
 
@@ -1247,8 +1489,8 @@ cbm_pp_read(CBM_FILE HandleDevice)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_pp_read)
-        ret = Plugin_information.Plugin.opencbm_plugin_pp_read(HandleDevice);
+    if (PLUGIN(HandleDevice).opencbm_plugin_pp_read)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_pp_read(HandleDevice);
 
     FUNC_LEAVE_UCHAR(ret);
 }
@@ -1283,8 +1525,8 @@ cbm_pp_write(CBM_FILE HandleDevice, unsigned char Byte)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_pp_write)
-        Plugin_information.Plugin.opencbm_plugin_pp_write(HandleDevice, Byte);
+    if (PLUGIN(HandleDevice).opencbm_plugin_pp_write)
+        PLUGIN(HandleDevice).opencbm_plugin_pp_write(HandleDevice, Byte);
 
     FUNC_LEAVE();
 }
@@ -1315,7 +1557,7 @@ cbm_iec_poll(CBM_FILE HandleDevice)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_iec_poll(HandleDevice));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_iec_poll(HandleDevice));
 }
 
 
@@ -1342,10 +1584,10 @@ cbm_iec_set(CBM_FILE HandleDevice, int Line)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_iec_set)
-        Plugin_information.Plugin.opencbm_plugin_iec_set(HandleDevice, Line);
+    if (PLUGIN(HandleDevice).opencbm_plugin_iec_set)
+        PLUGIN(HandleDevice).opencbm_plugin_iec_set(HandleDevice, Line);
     else
-        Plugin_information.Plugin.opencbm_plugin_iec_setrelease(HandleDevice, Line, 0);
+        PLUGIN(HandleDevice).opencbm_plugin_iec_setrelease(HandleDevice, Line, 0);
 
     FUNC_LEAVE();
 }
@@ -1373,10 +1615,10 @@ cbm_iec_release(CBM_FILE HandleDevice, int Line)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_iec_release)
-        Plugin_information.Plugin.opencbm_plugin_iec_release(HandleDevice, Line);
+    if (PLUGIN(HandleDevice).opencbm_plugin_iec_release)
+        PLUGIN(HandleDevice).opencbm_plugin_iec_release(HandleDevice, Line);
     else
-        Plugin_information.Plugin.opencbm_plugin_iec_setrelease(HandleDevice, 0, Line);
+        PLUGIN(HandleDevice).opencbm_plugin_iec_setrelease(HandleDevice, 0, Line);
 
     FUNC_LEAVE();
 }
@@ -1413,7 +1655,7 @@ cbm_iec_setrelease(CBM_FILE HandleDevice, int Set, int Release)
 {
     FUNC_ENTER();
 
-    Plugin_information.Plugin.opencbm_plugin_iec_setrelease(HandleDevice, Set, Release);
+    PLUGIN(HandleDevice).opencbm_plugin_iec_setrelease(HandleDevice, Set, Release);
 
     FUNC_LEAVE();
 }
@@ -1449,7 +1691,7 @@ cbm_iec_wait(CBM_FILE HandleDevice, int Line, int State)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT(Plugin_information.Plugin.opencbm_plugin_iec_wait(HandleDevice, Line, State));
+    FUNC_LEAVE_INT(PLUGIN(HandleDevice).opencbm_plugin_iec_wait(HandleDevice, Line, State));
 }
 
 /*! \brief Get the (logical) state of a line on the IEC serial bus
@@ -1478,7 +1720,7 @@ cbm_iec_get(CBM_FILE HandleDevice, int Line)
 {
     FUNC_ENTER();
 
-    FUNC_LEAVE_INT((Plugin_information.Plugin.opencbm_plugin_iec_poll(HandleDevice)&Line) != 0 ? 1 : 0);
+    FUNC_LEAVE_INT((PLUGIN(HandleDevice).opencbm_plugin_iec_poll(HandleDevice)&Line) != 0 ? 1 : 0);
 }
 
 
@@ -1638,8 +1880,8 @@ cbm_parallel_burst_read(CBM_FILE HandleDevice)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_read)
-        ret = Plugin_information.Plugin.opencbm_plugin_parallel_burst_read(HandleDevice);
+    if (PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read(HandleDevice);
 
     FUNC_LEAVE_UCHAR(ret);
 }
@@ -1666,8 +1908,8 @@ cbm_parallel_burst_write(CBM_FILE HandleDevice, unsigned char Value)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_write)
-        Plugin_information.Plugin.opencbm_plugin_parallel_burst_write(HandleDevice, Value);
+    if (PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_write)
+        PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_write(HandleDevice, Value);
 
     FUNC_LEAVE();
 }
@@ -1676,18 +1918,18 @@ int CBMAPIDECL
 cbm_parallel_burst_read_n(CBM_FILE HandleDevice, unsigned char *Buffer,
     unsigned int Length)
 {
+    opencbm_plugin_t *plugin = &PLUGIN(HandleDevice);
     unsigned int i;
     int rv;
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_read_n) {
-        rv = Plugin_information.Plugin.opencbm_plugin_parallel_burst_read_n(
+    if (plugin->opencbm_plugin_parallel_burst_read_n) {
+        rv = plugin->opencbm_plugin_parallel_burst_read_n(
             HandleDevice, Buffer, Length);
     } else {
         for (i = 0; i < Length; i++) {
-            Buffer[i] = Plugin_information.Plugin
-                .opencbm_plugin_parallel_burst_read(HandleDevice);
+            Buffer[i] = plugin->opencbm_plugin_parallel_burst_read(HandleDevice);
         }
         rv = Length;
     }
@@ -1699,18 +1941,18 @@ int CBMAPIDECL
 cbm_parallel_burst_write_n(CBM_FILE HandleDevice, unsigned char *Buffer,
     unsigned int Length)
 {
+    opencbm_plugin_t *plugin = &PLUGIN(HandleDevice);
     unsigned int i;
     int rv;
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_write_n) {
-        rv = Plugin_information.Plugin.opencbm_plugin_parallel_burst_write_n(
+    if (plugin->opencbm_plugin_parallel_burst_write_n) {
+        rv = plugin->opencbm_plugin_parallel_burst_write_n(
             HandleDevice, Buffer, Length);
     } else {
         for (i = 0; i < Length; i++) {
-            Plugin_information.Plugin.opencbm_plugin_parallel_burst_write(
-                HandleDevice, Buffer[i]);
+            plugin->opencbm_plugin_parallel_burst_write(HandleDevice, Buffer[i]);
         }
         rv = Length;
     }
@@ -1749,8 +1991,8 @@ cbm_parallel_burst_read_track(CBM_FILE HandleDevice, unsigned char *Buffer, unsi
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_read_track)
-        ret = Plugin_information.Plugin.opencbm_plugin_parallel_burst_read_track(HandleDevice, Buffer, Length);
+    if (PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read_track)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read_track(HandleDevice, Buffer, Length);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -1783,8 +2025,53 @@ cbm_parallel_burst_read_track_var(CBM_FILE HandleDevice, unsigned char *Buffer,
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_read_track)
-        ret = Plugin_information.Plugin.opencbm_plugin_parallel_burst_read_track_var(HandleDevice, Buffer, Length);
+    if (PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read_track)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read_track_var(HandleDevice, Buffer, Length);
+
+    FUNC_LEAVE_INT(ret);
+}
+
+/*! \brief PARBURST: Read a complete track, decoded to sectors
+
+ This function is a helper function for parallel burst:
+ It reads a complete track from the disk like
+ cbm_parallel_burst_read_track(), but the adapter decodes the GCR
+ data and only returns the sectors it found. For each one, there is
+ a record of CBM_GCR_SECTOR_SIZE bytes with the fields of the sector
+ header, the data, and the status (CBM_GCR_OK or an error code).
+ A sector that was read ok is returned only once; sectors that were
+ not found at all have no record.
+
+ \param HandleDevice
+   A CBM_FILE which contains the file handle of the driver.
+
+ \param Buffer
+   Pointer to a buffer which will hold the sector records.
+
+ \param Length
+   The number of raw track bytes to read from the drive, which is
+   also the length of the Buffer.
+
+ \return
+   The number of bytes read, a multiple of CBM_GCR_SECTOR_SIZE.
+
+ If cbm_driver_open() did not succeed, it is illegal to 
+ call this function.
+
+ Note that a plugin is not required to implement this function.
+ If this function is not implemented, or the adapter cannot decode
+ GCR data, it will return -1; use cbm_parallel_burst_read_track() then.
+*/
+
+int CBMAPIDECL
+cbm_parallel_burst_read_track_gcr(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int Length)
+{
+    int ret = -1;
+
+    FUNC_ENTER();
+
+    if (PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read_track_gcr)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_read_track_gcr(HandleDevice, Buffer, Length);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -1820,8 +2107,8 @@ cbm_parallel_burst_write_track(CBM_FILE HandleDevice, unsigned char *Buffer, uns
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_parallel_burst_write_track)
-        ret = Plugin_information.Plugin.opencbm_plugin_parallel_burst_write_track(HandleDevice, Buffer, Length);
+    if (PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_write_track)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_parallel_burst_write_track(HandleDevice, Buffer, Length);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -1850,8 +2137,8 @@ cbm_srq_burst_read(CBM_FILE HandleDevice)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_srq_burst_read)
-        ret = Plugin_information.Plugin.opencbm_plugin_srq_burst_read(HandleDevice);
+    if (PLUGIN(HandleDevice).opencbm_plugin_srq_burst_read)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_srq_burst_read(HandleDevice);
 
     FUNC_LEAVE_UCHAR(ret);
 }
@@ -1878,8 +2165,8 @@ cbm_srq_burst_write(CBM_FILE HandleDevice, unsigned char Value)
 {
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_srq_burst_write)
-        Plugin_information.Plugin.opencbm_plugin_srq_burst_write(HandleDevice, Value);
+    if (PLUGIN(HandleDevice).opencbm_plugin_srq_burst_write)
+        PLUGIN(HandleDevice).opencbm_plugin_srq_burst_write(HandleDevice, Value);
 
     FUNC_LEAVE();
 }
@@ -1888,18 +2175,18 @@ int CBMAPIDECL
 cbm_srq_burst_read_n(CBM_FILE HandleDevice, unsigned char *Buffer,
     unsigned int Length)
 {
+    opencbm_plugin_t *plugin = &PLUGIN(HandleDevice);
     unsigned int i;
     int rv;
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_srq_burst_read_n) {
-        rv = Plugin_information.Plugin.opencbm_plugin_srq_burst_read_n(
+    if (plugin->opencbm_plugin_srq_burst_read_n) {
+        rv = plugin->opencbm_plugin_srq_burst_read_n(
             HandleDevice, Buffer, Length);
     } else {
         for (i = 0; i < Length; i++) {
-            Buffer[i] = Plugin_information.Plugin
-                .opencbm_plugin_srq_burst_read(HandleDevice);
+            Buffer[i] = plugin->opencbm_plugin_srq_burst_read(HandleDevice);
         }
         rv = Length;
     }
@@ -1911,18 +2198,18 @@ int CBMAPIDECL
 cbm_srq_burst_write_n(CBM_FILE HandleDevice, unsigned char *Buffer,
     unsigned int Length)
 {
+    opencbm_plugin_t *plugin = &PLUGIN(HandleDevice);
     unsigned int i;
     int rv;
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_srq_burst_write_n) {
-        rv = Plugin_information.Plugin.opencbm_plugin_srq_burst_write_n(
+    if (plugin->opencbm_plugin_srq_burst_write_n) {
+        rv = plugin->opencbm_plugin_srq_burst_write_n(
             HandleDevice, Buffer, Length);
     } else {
         for (i = 0; i < Length; i++) {
-            Plugin_information.Plugin.opencbm_plugin_srq_burst_write(
-                HandleDevice, Buffer[i]);
+            plugin->opencbm_plugin_srq_burst_write(HandleDevice, Buffer[i]);
         }
         rv = Length;
     }
@@ -1961,8 +2248,8 @@ cbm_srq_burst_read_track(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_srq_burst_read_track)
-        ret = Plugin_information.Plugin.opencbm_plugin_srq_burst_read_track(HandleDevice, Buffer, Length);
+    if (PLUGIN(HandleDevice).opencbm_plugin_srq_burst_read_track)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_srq_burst_read_track(HandleDevice, Buffer, Length);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -1998,8 +2285,8 @@ cbm_srq_burst_write_track(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_srq_burst_write_track)
-        ret = Plugin_information.Plugin.opencbm_plugin_srq_burst_write_track(HandleDevice, Buffer, Length);
+    if (PLUGIN(HandleDevice).opencbm_plugin_srq_burst_write_track)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_srq_burst_write_track(HandleDevice, Buffer, Length);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2028,8 +2315,8 @@ cbm_tap_prepare_capture(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_prepare_capture)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_prepare_capture(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_prepare_capture)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_prepare_capture(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2058,8 +2345,8 @@ cbm_tap_prepare_write(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_prepare_write)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_prepare_write(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_prepare_write)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_prepare_write(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2088,8 +2375,8 @@ cbm_tap_get_sense(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_get_sense)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_get_sense(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_get_sense)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_get_sense(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2118,8 +2405,8 @@ cbm_tap_wait_for_stop_sense(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_wait_for_stop_sense)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_wait_for_stop_sense(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_wait_for_stop_sense)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_wait_for_stop_sense(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2148,8 +2435,8 @@ cbm_tap_wait_for_play_sense(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_wait_for_play_sense)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_wait_for_play_sense(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_wait_for_play_sense)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_wait_for_play_sense(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2178,8 +2465,8 @@ cbm_tap_motor_on(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_motor_on)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_motor_on(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_motor_on)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_motor_on(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2208,8 +2495,8 @@ cbm_tap_motor_off(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_motor_off)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_motor_off(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_motor_off)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_motor_off(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2250,8 +2537,8 @@ cbm_tap_start_capture(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_start_capture)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_start_capture(HandleDevice, Buffer, Buffer_Length, Status, BytesRead);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_start_capture)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_start_capture(HandleDevice, Buffer, Buffer_Length, Status, BytesRead);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2292,8 +2579,8 @@ cbm_tap_start_write(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int L
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_start_write)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_start_write(HandleDevice, Buffer, Length, Status, BytesWritten);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_start_write)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_start_write(HandleDevice, Buffer, Length, Status, BytesWritten);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2323,8 +2610,8 @@ cbm_tap_get_ver(CBM_FILE HandleDevice, int *Status)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_get_ver)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_get_ver(HandleDevice, Status);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_get_ver)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_get_ver(HandleDevice, Status);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2337,8 +2624,8 @@ cbm_tap_break(CBM_FILE HandleDevice)
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_break)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_break(HandleDevice);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_break)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_break(HandleDevice);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2380,8 +2667,8 @@ cbm_tap_download_config(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned i
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_download_config)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_download_config(HandleDevice, Buffer, Buffer_Length, Status, BytesRead);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_download_config)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_download_config(HandleDevice, Buffer, Buffer_Length, Status, BytesRead);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2422,8 +2709,8 @@ cbm_tap_upload_config(CBM_FILE HandleDevice, unsigned char *Buffer, unsigned int
 
     FUNC_ENTER();
 
-    if (Plugin_information.Plugin.opencbm_plugin_tap_upload_config)
-        ret = Plugin_information.Plugin.opencbm_plugin_tap_upload_config(HandleDevice, Buffer, Length, Status, BytesWritten);
+    if (PLUGIN(HandleDevice).opencbm_plugin_tap_upload_config)
+        ret = PLUGIN(HandleDevice).opencbm_plugin_tap_upload_config(HandleDevice, Buffer, Length, Status, BytesWritten);
 
     FUNC_LEAVE_INT(ret);
 }
@@ -2449,11 +2736,54 @@ void * CBMAPIDECL
 cbm_get_plugin_function_address(const char * Functionname)
 {
     void * pointer = NULL;
+    plugin_information_t *plugin;
 
     FUNC_ENTER();
 
-    if (Plugin_information.Library)
-        pointer = plugin_get_address(Plugin_information.Library, Functionname);
+    arch_mutex_lock(&Plugin_mutex);
+    plugin = Plugin_list;
+    arch_mutex_unlock(Plugin_mutex);
+
+    if (plugin != NULL && plugin->Library)
+        pointer = plugin_get_address(plugin->Library, Functionname);
+
+    FUNC_LEAVE_PTR(pointer, void*);
+}
+
+/*! \brief Get the function pointer for a function in the plugin of a handle
+
+ This function gets the function pointer for a function which 
+ resides in the plugin HandleDevice has been opened with.
+
+ \param HandleDevice
+   A CBM_FILE which contains the file handle of the driver.
+
+ \param Functionname
+   The name of the function of which to get the address
+
+ \return
+   Pointer to the function if successfull; 0 if not.
+
+ If cbm_driver_open() did not succeed, it is illegal to 
+ call this function.
+
+ \remark
+   Use this function instead of cbm_get_plugin_function_address()
+   if more than one handle might be open.
+*/
+
+void * CBMAPIDECL
+cbm_get_plugin_function_address_ex(CBM_FILE HandleDevice, const char * Functionname)
+{
+    void * pointer = NULL;
+    plugin_information_t *plugin;
+
+    FUNC_ENTER();
+
+    plugin = handle_plugin(HandleDevice);
+
+    if (plugin->Library)
+        pointer = plugin_get_address(plugin->Library, Functionname);
 
     FUNC_LEAVE_PTR(pointer, void*);
 }
@@ -2488,8 +2818,8 @@ cbm_iec_dbg_read(CBM_FILE HandleDevice)
 
     FUNC_ENTER();
 
-    if ( Plugin_information.Plugin.opencbm_plugin_iec_dbg_read ) {
-        returnValue = Plugin_information.Plugin.opencbm_plugin_iec_dbg_read(HandleDevice);
+    if ( PLUGIN(HandleDevice).opencbm_plugin_iec_dbg_read ) {
+        returnValue = PLUGIN(HandleDevice).opencbm_plugin_iec_dbg_read(HandleDevice);
     }
 
     FUNC_LEAVE_INT(returnValue);
@@ -2531,8 +2861,8 @@ cbm_iec_dbg_write(CBM_FILE HandleDevice, unsigned char Value)
 
     FUNC_ENTER();
 
-    if ( Plugin_information.Plugin.opencbm_plugin_iec_dbg_write ) {
-        returnValue = Plugin_information.Plugin.opencbm_plugin_iec_dbg_write(HandleDevice, Value);
+    if ( PLUGIN(HandleDevice).opencbm_plugin_iec_dbg_write ) {
+        returnValue = PLUGIN(HandleDevice).opencbm_plugin_iec_dbg_write(HandleDevice, Value);
     }
 
     FUNC_LEAVE_INT(returnValue);
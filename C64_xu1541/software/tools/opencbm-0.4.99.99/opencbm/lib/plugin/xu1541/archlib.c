@@ -72,6 +72,26 @@ opencbm_plugin_get_driver_name(const char * const Port)
     return "libusb/xu1541"; 
 }
 
+/*! \brief Enumerate the xu1541 devices
+
+ Get the port numbers of all xu1541 devices which are connected.
+
+ \param Ports
+   Pointer to an array which gets the port numbers.
+
+ \param Count
+   The number of elements in Ports.
+
+ \return
+   The number of devices found, which might be more than Count.
+*/
+
+int CBMAPIDECL
+opencbm_plugin_enumerate(unsigned int *Ports, unsigned int Count)
+{
+    return xu1541_enumerate(Ports, Count);
+}
+
 /*! \brief Opens the driver
 
  This function Opens the driver.
@@ -95,9 +115,13 @@ opencbm_plugin_get_driver_name(const char * const Port)
 int CBMAPIDECL
 opencbm_plugin_driver_open(CBM_FILE *HandleDevice, const char * const Port)
 {
-    UNREFERENCED_PARAMETER(Port);
+    int portNumber = 0;
+
+    if(Port != NULL) {
+        portNumber = strtoul(Port, NULL, 10);
+    }
 
-    return xu1541_init();
+    return xu1541_init((usb_dev_handle **)HandleDevice, portNumber);
 }
 
 /*! \brief Closes the driver
@@ -117,7 +141,7 @@ opencbm_plugin_driver_open(CBM_FILE *HandleDevice, const char * const Port)
 void CBMAPIDECL
 opencbm_plugin_driver_close(CBM_FILE HandleDevice)
 {
-    xu1541_close();
+    xu1541_close((usb_dev_handle *)HandleDevice);
 }
 
 
@@ -199,7 +223,7 @@ opencbm_plugin_unlock(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_raw_write(CBM_FILE HandleDevice, const void *Buffer, size_t Count)
 {
-    return xu1541_write(Buffer, Count);
+    return xu1541_write((usb_dev_handle *)HandleDevice, Buffer, Count);
 }
 
 /*! \brief Read data from the IEC serial bus
@@ -228,7 +252,7 @@ opencbm_plugin_raw_write(CBM_FILE HandleDevice, const void *Buffer, size_t Count
 int CBMAPIDECL
 opencbm_plugin_raw_read(CBM_FILE HandleDevice, void *Buffer, size_t Count)
 {
-    return xu1541_read(Buffer, Count);
+    return xu1541_read((usb_dev_handle *)HandleDevice, Buffer, Count);
 }
 
 
@@ -259,7 +283,7 @@ opencbm_plugin_raw_read(CBM_FILE HandleDevice, void *Buffer, size_t Count)
 int CBMAPIDECL
 opencbm_plugin_listen(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char SecondaryAddress)
 {
-    return xu1541_ioctl(XU1541_LISTEN, DeviceAddress, SecondaryAddress);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_LISTEN, DeviceAddress, SecondaryAddress);
 }
 
 /*! \brief Send a TALK on the IEC serial bus
@@ -288,7 +312,7 @@ opencbm_plugin_listen(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsign
 int CBMAPIDECL
 opencbm_plugin_talk(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char SecondaryAddress)
 {
-    return xu1541_ioctl(XU1541_TALK, DeviceAddress, SecondaryAddress);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_TALK, DeviceAddress, SecondaryAddress);
 }
 
 /*! \brief Open a file on the IEC serial bus
@@ -315,7 +339,7 @@ opencbm_plugin_talk(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned
 int CBMAPIDECL
 opencbm_plugin_open(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char SecondaryAddress)
 {
-    return xu1541_ioctl(XU1541_OPEN, DeviceAddress, SecondaryAddress);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_OPEN, DeviceAddress, SecondaryAddress);
 }
 
 /*! \brief Close a file on the IEC serial bus
@@ -342,7 +366,7 @@ opencbm_plugin_open(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned
 int CBMAPIDECL
 opencbm_plugin_close(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned char SecondaryAddress)
 {
-    return xu1541_ioctl(XU1541_CLOSE, DeviceAddress, SecondaryAddress);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_CLOSE, DeviceAddress, SecondaryAddress);
 }
 
 /*! \brief Send an UNLISTEN on the IEC serial bus
@@ -368,7 +392,7 @@ opencbm_plugin_close(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigne
 int CBMAPIDECL
 opencbm_plugin_unlisten(CBM_FILE HandleDevice)
 {
-    return xu1541_ioctl(XU1541_UNLISTEN, 0, 0);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_UNLISTEN, 0, 0);
 }
 
 /*! \brief Send an UNTALK on the IEC serial bus
@@ -394,7 +418,7 @@ opencbm_plugin_unlisten(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_untalk(CBM_FILE HandleDevice)
 {
-    return xu1541_ioctl(XU1541_UNTALK, 0, 0);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_UNTALK, 0, 0);
 }
 
 
@@ -421,7 +445,7 @@ opencbm_plugin_untalk(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_get_eoi(CBM_FILE HandleDevice)
 {
-    return xu1541_ioctl(XU1541_GET_EOI, 0, 0);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_GET_EOI, 0, 0);
 }
 
 /*! \brief Reset the EOI flag
@@ -442,7 +466,7 @@ opencbm_plugin_get_eoi(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_clear_eoi(CBM_FILE HandleDevice)
 {
-    return xu1541_ioctl(XU1541_CLEAR_EOI, 0, 0);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_CLEAR_EOI, 0, 0);
 }
 
 /*! \brief RESET all devices
@@ -469,7 +493,7 @@ opencbm_plugin_clear_eoi(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_reset(CBM_FILE HandleDevice)
 {
-    return xu1541_ioctl(XU1541_RESET, 0, 0);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_RESET, 0, 0);
 }
 
 
@@ -500,7 +524,7 @@ opencbm_plugin_reset(CBM_FILE HandleDevice)
 unsigned char CBMAPIDECL
 opencbm_plugin_pp_read(CBM_FILE HandleDevice)
 {
-    return (unsigned char) xu1541_ioctl(XU1541_PP_READ, 0, 0);
+    return (unsigned char) xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_PP_READ, 0, 0);
 }
 
 /*! \brief Write a byte to a XP1541/XP1571 cable
@@ -529,7 +553,7 @@ opencbm_plugin_pp_read(CBM_FILE HandleDevice)
 void CBMAPIDECL
 opencbm_plugin_pp_write(CBM_FILE HandleDevice, unsigned char Byte)
 {
-    xu1541_ioctl(XU1541_PP_WRITE, Byte, 0);
+    xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_PP_WRITE, Byte, 0);
 }
 
 /*! \brief Read status of all bus lines.
@@ -556,7 +580,7 @@ opencbm_plugin_pp_write(CBM_FILE HandleDevice, unsigned char Byte)
 int CBMAPIDECL
 opencbm_plugin_iec_poll(CBM_FILE HandleDevice)
 {
-    return xu1541_ioctl(XU1541_IEC_POLL, 0, 0);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_IEC_POLL, 0, 0);
 }
 
 
@@ -581,7 +605,7 @@ opencbm_plugin_iec_poll(CBM_FILE HandleDevice)
 void CBMAPIDECL
 opencbm_plugin_iec_set(CBM_FILE HandleDevice, int Line)
 {
-    xu1541_ioctl(XU1541_IEC_SETRELEASE, Line, 0);
+    xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_IEC_SETRELEASE, Line, 0);
 }
 
 /*! \brief Deactivate a line on the IEC serial bus
@@ -605,7 +629,7 @@ opencbm_plugin_iec_set(CBM_FILE HandleDevice, int Line)
 void CBMAPIDECL
 opencbm_plugin_iec_release(CBM_FILE HandleDevice, int Line)
 {
-    xu1541_ioctl(XU1541_IEC_SETRELEASE, 0, Line);
+    xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_IEC_SETRELEASE, 0, Line);
 }
 
 /*! \brief Activate and deactive a line on the IEC serial bus
@@ -638,7 +662,7 @@ opencbm_plugin_iec_release(CBM_FILE HandleDevice, int Line)
 void CBMAPIDECL
 opencbm_plugin_iec_setrelease(CBM_FILE HandleDevice, int Set, int Release)
 {
-    xu1541_ioctl(XU1541_IEC_SETRELEASE, Set, Release);
+    xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_IEC_SETRELEASE, Set, Release);
 }
 
 /*! \brief Wait for a line to have a specific state
@@ -670,6 +694,6 @@ opencbm_plugin_iec_setrelease(CBM_FILE HandleDevice, int Set, int Release)
 int CBMAPIDECL
 opencbm_plugin_iec_wait(CBM_FILE HandleDevice, int Line, int State)
 {
-    return xu1541_ioctl(XU1541_IEC_WAIT, Line, State);
+    return xu1541_ioctl((usb_dev_handle *)HandleDevice, XU1541_IEC_WAIT, Line, State);
 }
 
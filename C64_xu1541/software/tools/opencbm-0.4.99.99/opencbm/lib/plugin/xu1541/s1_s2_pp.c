@@ -66,7 +66,7 @@
 int CBMAPIDECL
 opencbm_plugin_s1_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xu1541_special_read(XU1541_S1, data, size); 
+    return xu1541_special_read((usb_dev_handle *)HandleDevice, XU1541_S1, data, size); 
 }
 
 /*! \brief Write data with serial1 protocol
@@ -86,7 +86,7 @@ opencbm_plugin_s1_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned in
 int CBMAPIDECL
 opencbm_plugin_s1_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xu1541_special_write(XU1541_S1, data, size); 
+    return xu1541_special_write((usb_dev_handle *)HandleDevice, XU1541_S1, data, size); 
 }
 
 /*! \brief Read data with serial2 protocol
@@ -106,7 +106,7 @@ opencbm_plugin_s1_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsi
 int CBMAPIDECL
 opencbm_plugin_s2_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xu1541_special_read(XU1541_S2, data, size); 
+    return xu1541_special_read((usb_dev_handle *)HandleDevice, XU1541_S2, data, size); 
 }
 
 /*! \brief Write data with serial2 protocol
@@ -126,7 +126,7 @@ opencbm_plugin_s2_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned in
 int CBMAPIDECL
 opencbm_plugin_s2_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xu1541_special_write(XU1541_S2, data, size); 
+    return xu1541_special_write((usb_dev_handle *)HandleDevice, XU1541_S2, data, size); 
 }
 
 /*! \brief Read data with parallel protocol (d64copy)
@@ -146,7 +146,7 @@ opencbm_plugin_s2_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsi
 int CBMAPIDECL
 opencbm_plugin_pp_dc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xu1541_special_read(XU1541_PP, data, size); 
+    return xu1541_special_read((usb_dev_handle *)HandleDevice, XU1541_PP, data, size); 
 }
 
 /*! \brief Write data with parallel protocol (d64copy)
@@ -166,7 +166,7 @@ opencbm_plugin_pp_dc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned
 int CBMAPIDECL
 opencbm_plugin_pp_dc_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xu1541_special_write(XU1541_PP, data, size); 
+    return xu1541_special_write((usb_dev_handle *)HandleDevice, XU1541_PP, data, size); 
 }
 
 /*! \brief Read data with parallel protocol (cbmcopy)
@@ -186,7 +186,7 @@ opencbm_plugin_pp_dc_write_n(CBM_FILE HandleDevice, const unsigned char *data, u
 int CBMAPIDECL
 opencbm_plugin_pp_cc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xu1541_special_read(XU1541_P2, data, size); 
+    return xu1541_special_read((usb_dev_handle *)HandleDevice, XU1541_P2, data, size); 
 }
 
 /*! \brief Write data with parallel protocol (cbmcopy)
@@ -206,5 +206,5 @@ opencbm_plugin_pp_cc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned
 int CBMAPIDECL
 opencbm_plugin_pp_cc_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xu1541_special_write(XU1541_P2, data, size); 
+    return xu1541_special_write((usb_dev_handle *)HandleDevice, XU1541_P2, data, size); 
 }
@@ -31,7 +31,7 @@
 #include "xu1541.h"
 
 static int debug_level = -10000; /*!< \internal \brief the debugging level for debugging output */
-static usb_dev_handle *xu1541_handle = NULL; /*!< \internal \brief handle to the xu1541 device */
+static arch_mutex_t *usb_scan_mutex; /*!< \internal \brief serializes scanning the (global) libusb device list */
 
 /*! \brief timeout value, used mainly after errors \todo What is the exact purpose of this? */
 #define TIMEOUT_DELAY  25000   // 25ms
@@ -111,84 +111,127 @@ static int  usbGetStringAscii(usb_dev_handle *dev, int index, int langid,
     return i-1;
 }
 
+/*! \internal \brief Rescan the USB busses
+
+ Must be called with usb_scan_mutex held.
+*/
+static void xu1541_scan_busses(void)
+{
+  xu1541_dbg(0, "Scanning usb ...");
+
+  usb.init();
+  
+  usb.find_busses();
+  usb.find_devices();
+
+  /* usb_find_devices sets errno if some devices don't reply 100% correct. */
+  /* make lib ignore this as this has nothing to do with our device */
+  errno = 0;
+}
+
+/*! \internal \brief Open a USB device if it is a xu1541
+
+ \param bus
+   The bus the device is on.
+
+ \param dev
+   The device to check.
+
+ \return
+   The handle of the opened device, or NULL if it is no usable xu1541.
+*/
+static usb_dev_handle *xu1541_probe(struct usb_bus *bus, struct usb_device *dev)
+{
+  usb_dev_handle *handle;
+  char    string[256];
+  int     len;
+
+  xu1541_dbg(1, "Device %04x:%04x at %s", 
+	     dev->descriptor.idVendor, dev->descriptor.idProduct,
+	     dev->filename);
+
+  if((dev->descriptor.idVendor != XU1541_VID) ||
+     (dev->descriptor.idProduct != XU1541_PID))
+    return NULL;
+
+  xu1541_dbg(0, "Found xu1541 device on bus %s device %s.",
+	     bus->dirname, dev->filename);
+
+  /* open device */
+  if(!(handle = usb.open(dev))) {
+    fprintf(stderr, "Error: Cannot open USB device: %s\n",
+	    usb.strerror());
+    return NULL;
+  }
+	
+  /* get device name and make sure the name is "xu1541" meaning */
+  /* that the device is not in boot loader mode */
+  len = usbGetStringAscii(handle, dev->descriptor.iProduct, 
+			  0x0409, string, sizeof(string));
+  if(len < 0){
+    fprintf(stderr, "warning: cannot query product "
+	    "name for device: %s\n", usb.strerror());
+    usb.close(handle);
+    return NULL;
+  }
+
+  /* make sure the name matches what we expect */
+  if(strcmp(string, "xu1541") != 0) {
+    fprintf(stderr, "Error: Found xu1541 in unexpected state,"
+	    " please make sure device is _not_ in bootloader mode!\n");
+    usb.close(handle);
+    return NULL;
+  }
+
+  return handle;
+}
+
 /*! \brief initialise the xu1541 device
 
   This function tries to find and identify the xu1541 device.
 
+  \param HandleXu1541
+    Pointer to a usb_dev_handle pointer which gets the handle of the device.
+
+  \param PortNumber
+    The number of the device to use, counting all xu1541 which are
+    connected in the order of the USB busses, starting with 0.
+
   \return
     0 on success, -1 on error.
 
   \remark
-    On success, xu1541_handle contains a valid handle to the xu1541 device.
+    On success, *HandleXu1541 contains a valid handle to the xu1541 device.
     In this case, the device configuration has been set and the interface
-    been claimed.
-
-  \bug
-    On some error types, this function might return error, but might
-    has opened the xu1541_handle. In this case, the handle is leaked, as
-    xu1541_close() is not to be called.
+    been claimed. On error, the device has been closed again.
 */
 /* try to find a xu1541 cable */
-int xu1541_init(void) {
+int xu1541_init(usb_dev_handle **HandleXu1541, int PortNumber) {
   struct usb_bus      *bus;
   struct usb_device   *dev;
+  usb_dev_handle      *xu1541_handle = NULL;
   unsigned char ret[4];
   int len;
 
-  xu1541_dbg(0, "Scanning usb ...");
+  *HandleXu1541 = NULL;
 
-  usb.init();
-  
-  usb.find_busses();
-  usb.find_devices();
-
-  /* usb_find_devices sets errno if some devices don't reply 100% correct. */
-  /* make lib ignore this as this has nothing to do with our device */
-  errno = 0;
+  arch_mutex_lock(&usb_scan_mutex);
+  xu1541_scan_busses();
 
   for(bus = usb.get_busses(); !xu1541_handle && bus; bus = bus->next) {
     xu1541_dbg(1, "Scanning bus %s", bus->dirname);
 
     for(dev = bus->devices; !xu1541_handle && dev; dev = dev->next) {
-      xu1541_dbg(1, "Device %04x:%04x at %s", 
-		 dev->descriptor.idVendor, dev->descriptor.idProduct,
-		 dev->filename);
-
-      if((dev->descriptor.idVendor == XU1541_VID) &&
-         (dev->descriptor.idProduct == XU1541_PID)) {
-	char    string[256];
-	int     len;
-	
-        xu1541_dbg(0, "Found xu1541 device on bus %s device %s.",
-               bus->dirname, dev->filename);
+      xu1541_handle = xu1541_probe(bus, dev);
 
-        /* open device */
-        if(!(xu1541_handle = usb.open(dev)))
-          fprintf(stderr, "Error: Cannot open USB device: %s\n",
-                  usb.strerror());
-	
-	/* get device name and make sure the name is "xu1541" meaning */
-	/* that the device is not in boot loader mode */
-	len = usbGetStringAscii(xu1541_handle, dev->descriptor.iProduct, 
-				0x0409, string, sizeof(string));
-	if(len < 0){
-	  fprintf(stderr, "warning: cannot query product "
-		  "name for device: %s\n", usb.strerror());
-	  if(xu1541_handle) usb.close(xu1541_handle);
-	  xu1541_handle = NULL;
-	}
-
-	/* make sure the name matches what we expect */
-	if(strcmp(string, "xu1541") != 0) {
-	  fprintf(stderr, "Error: Found xu1541 in unexpected state,"
-		  " please make sure device is _not_ in bootloader mode!\n");
-	  
-	  if(xu1541_handle) usb.close(xu1541_handle);
-	  xu1541_handle = NULL;
-	}
+      /* skip the xu1541 which come before the one asked for */
+      if(xu1541_handle && PortNumber-- > 0) {
+	usb.close(xu1541_handle);
+	xu1541_handle = NULL;
       }
     }
   }
+  arch_mutex_unlock(usb_scan_mutex);
 
   if(!xu1541_handle) {
       fprintf(stderr, "ERROR: No xu1541 device found\n");
@@ -197,12 +240,14 @@ int xu1541_init(void) {
 
   if (usb.set_configuration(xu1541_handle, 1) != 0) {
       fprintf(stderr, "USB error: %s\n", usb.strerror());
+      usb.close(xu1541_handle);
       return -1;
   }
       
   /* Get exclusive access to interface 0. */
   if (usb.claim_interface(xu1541_handle, 0) != 0) {
       fprintf(stderr, "USB error: %s\n", usb.strerror());
+      usb.close(xu1541_handle);
       return -1;
   }
 
@@ -214,11 +259,13 @@ int xu1541_init(void) {
   if(len < 0) {
     fprintf(stderr, "USB request for XU1541 info failed: %s!\n", 
 	    usb.strerror());
+    xu1541_close(xu1541_handle);
     return -1;
   }
 
   if(len != sizeof(ret)) {
     fprintf(stderr, "Unexpected number of bytes (%d) returned\n", len);
+    xu1541_close(xu1541_handle);
     return -1;
   }
 
@@ -229,18 +276,23 @@ int xu1541_init(void) {
 	    ret[0], ret[1]);
     fprintf(stderr, "but this version of opencbm requires at least "
 	    "version x.08\n");
+    xu1541_close(xu1541_handle);
     return -1;
   }
 
+  *HandleXu1541 = xu1541_handle;
   return 0;
 }
 
 /*! \brief close the xu1541 device
 
+ \param xu1541_handle
+    The handle of the xu1541 device.
+
  \remark
     This function releases the interface and closes the xu1541 handle.
 */
-void xu1541_close(void)
+void xu1541_close(usb_dev_handle *xu1541_handle)
 {
     xu1541_dbg(0, "Closing USB link");
 
@@ -250,8 +302,52 @@ void xu1541_close(void)
     usb.close(xu1541_handle);
 }
 
+/*! \brief enumerate the xu1541 devices
+
+ \param Ports
+    Pointer to an array which gets the port numbers of the devices.
+
+ \param Count
+    The number of elements in Ports.
+
+ \return
+    The number of xu1541 found; only the first Count are stored.
+
+ \remark
+    The xu1541 has no serial number, so the devices are just numbered
+    in the order they are found, which is what xu1541_init() expects.
+*/
+int xu1541_enumerate(unsigned int *Ports, unsigned int Count)
+{
+  struct usb_bus      *bus;
+  struct usb_device   *dev;
+  usb_dev_handle      *handle;
+  unsigned int found = 0;
+
+  arch_mutex_lock(&usb_scan_mutex);
+  xu1541_scan_busses();
+
+  for(bus = usb.get_busses(); bus; bus = bus->next) {
+    for(dev = bus->devices; dev; dev = dev->next) {
+      if((handle = xu1541_probe(bus, dev)) == NULL)
+	continue;
+      usb.close(handle);
+
+      if(found < Count)
+	Ports[found] = found;
+      found++;
+    }
+  }
+  arch_mutex_unlock(usb_scan_mutex);
+
+  return found;
+}
+
 /*! \brief perform an ioctl on the xu1541
 
+ \param xu1541_handle
+   The handle of the xu1541 device.
+
  \param cmd
    The IOCTL number
 
@@ -267,7 +363,7 @@ void xu1541_close(void)
  \todo
    Rework for cleaner structure. Currently, this is a mess!
 */
-int xu1541_ioctl(unsigned int cmd, unsigned int addr, unsigned int secaddr)
+int xu1541_ioctl(usb_dev_handle *xu1541_handle, unsigned int cmd, unsigned int addr, unsigned int secaddr)
 {
   int nBytes;
   char ret[4];
@@ -367,6 +463,9 @@ int xu1541_ioctl(unsigned int cmd, unsigned int addr, unsigned int secaddr)
 
 /*! \brief write data to the xu1541 device
 
+ \param xu1541_handle
+    The handle of the xu1541 device.
+
  \param data
     Pointer to buffer which contains the data to be written to the xu1541
 
@@ -376,7 +475,7 @@ int xu1541_ioctl(unsigned int cmd, unsigned int addr, unsigned int secaddr)
  \return
     The number of bytes written
 */
-int xu1541_write(const unsigned char *data, size_t len) 
+int xu1541_write(usb_dev_handle *xu1541_handle, const unsigned char *data, size_t len) 
 {
     int bytesWritten = 0;
 
@@ -449,6 +548,9 @@ int xu1541_write(const unsigned char *data, size_t len)
 
 /*! \brief read data from the xu1541 device
 
+ \param xu1541_handle
+    The handle of the xu1541 device.
+
  \param data
     Pointer to a buffer which will contain the data read from the xu1541
 
@@ -458,7 +560,7 @@ int xu1541_write(const unsigned char *data, size_t len)
  \return
     The number of bytes read
 */
-int xu1541_read(unsigned char *data, size_t len) 
+int xu1541_read(usb_dev_handle *xu1541_handle, unsigned char *data, size_t len) 
 {
     int bytesRead = 0;
     
@@ -568,6 +670,9 @@ int xu1541_read(unsigned char *data, size_t len)
  \todo
     What is so special?
 
+ \param xu1541_handle
+    The handle of the xu1541 device.
+
  \param mode
     \todo ???
 
@@ -585,7 +690,7 @@ int xu1541_read(unsigned char *data, size_t len)
      that we can just handle them in the device at the same time as the USB
      transfers.
 */
-int xu1541_special_write(int mode, const unsigned char *data, size_t size) 
+int xu1541_special_write(usb_dev_handle *xu1541_handle, int mode, const unsigned char *data, size_t size) 
 {
     int bytesWritten = 0;
 
@@ -621,6 +726,9 @@ int xu1541_special_write(int mode, const unsigned char *data, size_t size)
  \todo
     What is so special?
 
+ \param xu1541_handle
+    The handle of the xu1541 device.
+
  \param mode
     \todo ???
 
@@ -633,7 +741,7 @@ int xu1541_special_write(int mode, const unsigned char *data, size_t size)
  \return
     The number of bytes read
 */
-int xu1541_special_read(int mode, unsigned char *data, size_t size) 
+int xu1541_special_read(usb_dev_handle *xu1541_handle, int mode, unsigned char *data, size_t size) 
 {
     int bytesRead = 0;
 
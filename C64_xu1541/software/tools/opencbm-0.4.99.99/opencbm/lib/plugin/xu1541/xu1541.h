@@ -20,15 +20,21 @@
 #define XU1541_VID  0x0403
 #define XU1541_PID  0xc632
 
+/*
+ * The CBM_FILE of this plugin is the usb_dev_handle of the device,
+ * so several xu1541 can be used at the same time.
+ */
+
 /* calls required for standard io */
-extern int xu1541_init(void);
-extern void xu1541_close(void);
-extern int xu1541_ioctl(unsigned int cmd, unsigned int addr, unsigned int secaddr);
-extern int xu1541_write(const unsigned char *data, size_t len);
-extern int xu1541_read(unsigned char *data, size_t len);
+extern int xu1541_init(usb_dev_handle **HandleXu1541, int PortNumber);
+extern void xu1541_close(usb_dev_handle *xu1541_handle);
+extern int xu1541_enumerate(unsigned int *Ports, unsigned int Count);
+extern int xu1541_ioctl(usb_dev_handle *xu1541_handle, unsigned int cmd, unsigned int addr, unsigned int secaddr);
+extern int xu1541_write(usb_dev_handle *xu1541_handle, const unsigned char *data, size_t len);
+extern int xu1541_read(usb_dev_handle *xu1541_handle, unsigned char *data, size_t len);
 
 /* calls for speeder supported modes */
-extern int xu1541_special_write(int mode, const unsigned char *data, size_t size);
-extern int xu1541_special_read(int mode, unsigned char *data, size_t size);
+extern int xu1541_special_write(usb_dev_handle *xu1541_handle, int mode, const unsigned char *data, size_t size);
+extern int xu1541_special_read(usb_dev_handle *xu1541_handle, int mode, unsigned char *data, size_t size);
 
 #endif // XU1541_H
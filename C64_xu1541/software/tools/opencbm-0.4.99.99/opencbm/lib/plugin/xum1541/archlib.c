@@ -80,6 +80,27 @@ opencbm_plugin_get_driver_name(const char * const Port)
     return xum1541_device_path(portNumber);
 }
 
+/*! \brief Enumerate the xum1541 devices
+
+ Get the port numbers of all xum1541 devices which are connected.
+
+ \param Ports
+   Pointer to an array which gets the port numbers, that is, the
+   serial numbers of the devices.
+
+ \param Count
+   The number of elements in Ports.
+
+ \return
+   The number of devices found, which might be more than Count.
+*/
+
+int CBMAPIDECL
+opencbm_plugin_enumerate(unsigned int *Ports, unsigned int Count)
+{
+    return xum1541_enumerate_serials(Ports, Count);
+}
+
 /*! \brief Opens the driver
 
  This function Opens the driver.
@@ -109,7 +130,7 @@ opencbm_plugin_driver_open(CBM_FILE *HandleDevice, const char * const Port)
         portNumber = strtoul(Port, NULL, 10);
     }
 
-    return xum1541_init((usb_dev_handle **)HandleDevice, portNumber);
+    return xum1541_init((struct xum1541_usb_handle **)HandleDevice, portNumber);
 }
 
 /*! \brief Closes the driver
@@ -129,7 +150,7 @@ opencbm_plugin_driver_open(CBM_FILE *HandleDevice, const char * const Port)
 void CBMAPIDECL
 opencbm_plugin_driver_close(CBM_FILE HandleDevice)
 {
-    xum1541_close((usb_dev_handle *)HandleDevice);
+    xum1541_close((struct xum1541_usb_handle *)HandleDevice);
 }
 
 
@@ -211,7 +232,7 @@ opencbm_plugin_unlock(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_raw_write(CBM_FILE HandleDevice, const void *Buffer, size_t Count)
 {
-    return xum1541_write((usb_dev_handle *)HandleDevice, XUM1541_CBM, Buffer, Count);
+    return xum1541_write((struct xum1541_usb_handle *)HandleDevice, XUM1541_CBM, Buffer, Count);
 }
 
 /*! \brief Read data from the IEC serial bus
@@ -240,7 +261,7 @@ opencbm_plugin_raw_write(CBM_FILE HandleDevice, const void *Buffer, size_t Count
 int CBMAPIDECL
 opencbm_plugin_raw_read(CBM_FILE HandleDevice, void *Buffer, size_t Count)
 {
-    return xum1541_read((usb_dev_handle *)HandleDevice, XUM1541_CBM, Buffer, Count);
+    return xum1541_read((struct xum1541_usb_handle *)HandleDevice, XUM1541_CBM, Buffer, Count);
 }
 
 
@@ -276,7 +297,7 @@ opencbm_plugin_listen(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsign
     proto = XUM1541_CBM | XUM_WRITE_ATN;
     dataBuf[0] = 0x20 | DeviceAddress;
     dataBuf[1] = 0x60 | SecondaryAddress;
-    return !xum1541_write((usb_dev_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
+    return !xum1541_write((struct xum1541_usb_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
 }
 
 /*! \brief Send a TALK on the IEC serial bus
@@ -310,7 +331,7 @@ opencbm_plugin_talk(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned
     proto = XUM1541_CBM | XUM_WRITE_ATN | XUM_WRITE_TALK;
     dataBuf[0] = 0x40 | DeviceAddress;
     dataBuf[1] = 0x60 | SecondaryAddress;
-    return !xum1541_write((usb_dev_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
+    return !xum1541_write((struct xum1541_usb_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
 }
 
 /*! \brief Open a file on the IEC serial bus
@@ -342,7 +363,7 @@ opencbm_plugin_open(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigned
     proto = XUM1541_CBM | XUM_WRITE_ATN;
     dataBuf[0] = 0x20 | DeviceAddress;
     dataBuf[1] = 0xf0 | SecondaryAddress;
-    return !xum1541_write((usb_dev_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
+    return !xum1541_write((struct xum1541_usb_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
 }
 
 /*! \brief Close a file on the IEC serial bus
@@ -374,7 +395,7 @@ opencbm_plugin_close(CBM_FILE HandleDevice, unsigned char DeviceAddress, unsigne
     proto = XUM1541_CBM | XUM_WRITE_ATN;
     dataBuf[0] = 0x20 | DeviceAddress;
     dataBuf[1] = 0xe0 | SecondaryAddress;
-    return !xum1541_write((usb_dev_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
+    return !xum1541_write((struct xum1541_usb_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
 }
 
 /*! \brief Send an UNLISTEN on the IEC serial bus
@@ -404,7 +425,7 @@ opencbm_plugin_unlisten(CBM_FILE HandleDevice)
 
     proto = XUM1541_CBM | XUM_WRITE_ATN;
     dataBuf[0] = 0x3f;
-    return !xum1541_write((usb_dev_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
+    return !xum1541_write((struct xum1541_usb_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
 }
 
 /*! \brief Send an UNTALK on the IEC serial bus
@@ -434,7 +455,7 @@ opencbm_plugin_untalk(CBM_FILE HandleDevice)
 
     proto = XUM1541_CBM | XUM_WRITE_ATN;
     dataBuf[0] = 0x5f;
-    return !xum1541_write((usb_dev_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
+    return !xum1541_write((struct xum1541_usb_handle *)HandleDevice, proto, dataBuf, sizeof(dataBuf));
 }
 
 
@@ -461,7 +482,7 @@ opencbm_plugin_untalk(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_get_eoi(CBM_FILE HandleDevice)
 {
-    return xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_GET_EOI, 0, 0);
+    return xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_GET_EOI, 0, 0);
 }
 
 /*! \brief Reset the EOI flag
@@ -482,7 +503,7 @@ opencbm_plugin_get_eoi(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_clear_eoi(CBM_FILE HandleDevice)
 {
-    return xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_CLEAR_EOI, 0, 0);
+    return xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_CLEAR_EOI, 0, 0);
 }
 
 /*! \brief RESET all devices
@@ -509,7 +530,7 @@ opencbm_plugin_clear_eoi(CBM_FILE HandleDevice)
 int CBMAPIDECL
 opencbm_plugin_reset(CBM_FILE HandleDevice)
 {
-    return xum1541_control_msg((usb_dev_handle *)HandleDevice, XUM1541_RESET);
+    return xum1541_control_msg((struct xum1541_usb_handle *)HandleDevice, XUM1541_RESET);
 }
 
 
@@ -540,7 +561,7 @@ opencbm_plugin_reset(CBM_FILE HandleDevice)
 unsigned char CBMAPIDECL
 opencbm_plugin_pp_read(CBM_FILE HandleDevice)
 {
-    return (unsigned char) xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_PP_READ, 0, 0);
+    return (unsigned char) xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_PP_READ, 0, 0);
 }
 
 /*! \brief Write a byte to a XP1541/XP1571 cable
@@ -569,7 +590,7 @@ opencbm_plugin_pp_read(CBM_FILE HandleDevice)
 void CBMAPIDECL
 opencbm_plugin_pp_write(CBM_FILE HandleDevice, unsigned char Byte)
 {
-    xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_PP_WRITE, Byte, 0);
+    xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_PP_WRITE, Byte, 0);
 }
 
 /*! \brief Read status of all bus lines.
@@ -596,7 +617,7 @@ opencbm_plugin_pp_write(CBM_FILE HandleDevice, unsigned char Byte)
 int CBMAPIDECL
 opencbm_plugin_iec_poll(CBM_FILE HandleDevice)
 {
-    return xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_IEC_POLL, 0, 0);
+    return xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_IEC_POLL, 0, 0);
 }
 
 
@@ -621,7 +642,7 @@ opencbm_plugin_iec_poll(CBM_FILE HandleDevice)
 void CBMAPIDECL
 opencbm_plugin_iec_set(CBM_FILE HandleDevice, int Line)
 {
-    xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_IEC_SETRELEASE, Line, 0);
+    xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_IEC_SETRELEASE, Line, 0);
 }
 
 /*! \brief Deactivate a line on the IEC serial bus
@@ -645,7 +666,7 @@ opencbm_plugin_iec_set(CBM_FILE HandleDevice, int Line)
 void CBMAPIDECL
 opencbm_plugin_iec_release(CBM_FILE HandleDevice, int Line)
 {
-    xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_IEC_SETRELEASE, 0, Line);
+    xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_IEC_SETRELEASE, 0, Line);
 }
 
 /*! \brief Activate and deactive a line on the IEC serial bus
@@ -678,7 +699,7 @@ opencbm_plugin_iec_release(CBM_FILE HandleDevice, int Line)
 void CBMAPIDECL
 opencbm_plugin_iec_setrelease(CBM_FILE HandleDevice, int Set, int Release)
 {
-    xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_IEC_SETRELEASE, Set, Release);
+    xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_IEC_SETRELEASE, Set, Release);
 }
 
 /*! \brief Wait for a line to have a specific state
@@ -710,7 +731,7 @@ opencbm_plugin_iec_setrelease(CBM_FILE HandleDevice, int Set, int Release)
 int CBMAPIDECL
 opencbm_plugin_iec_wait(CBM_FILE HandleDevice, int Line, int State)
 {
-    return xum1541_ioctl((usb_dev_handle *)HandleDevice, XUM1541_IEC_WAIT, Line, State);
+    return xum1541_ioctl((struct xum1541_usb_handle *)HandleDevice, XUM1541_IEC_WAIT, Line, State);
 }
 
 /*! \brief Sends a command to the xum1541 device
@@ -730,5 +751,5 @@ opencbm_plugin_iec_wait(CBM_FILE HandleDevice, int Line, int State)
 int CBMAPIDECL
 xum1541_plugin_control_msg(CBM_FILE HandleDevice, unsigned int cmd)
 {
-    return xum1541_control_msg((usb_dev_handle *)HandleDevice, cmd);
+    return xum1541_control_msg((struct xum1541_usb_handle *)HandleDevice, cmd);
 }
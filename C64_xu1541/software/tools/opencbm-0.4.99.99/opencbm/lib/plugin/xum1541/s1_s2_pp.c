@@ -69,7 +69,7 @@
 int CBMAPIDECL
 opencbm_plugin_s1_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xum1541_read((usb_dev_handle *)HandleDevice, XUM1541_S1, data, size);
+    return xum1541_read((struct xum1541_usb_handle *)HandleDevice, XUM1541_S1, data, size);
 }
 
 /*! \brief Write data with serial1 protocol
@@ -90,7 +90,37 @@ opencbm_plugin_s1_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned in
 int CBMAPIDECL
 opencbm_plugin_s1_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xum1541_write((usb_dev_handle *)HandleDevice, XUM1541_S1, data, size);
+    return xum1541_write((struct xum1541_usb_handle *)HandleDevice, XUM1541_S1, data, size);
+}
+
+/*! \brief Run request/response transfers with serial1 protocol
+
+  \param HandleDevice
+    A CBM_FILE which contains the file handle of the driver.
+
+  \param wrData
+    Pointer to count requests of wrSize bytes each.
+
+  \param wrSize
+    The size of one request, may be 0.
+
+  \param rdData
+    Pointer to the buffer which will hold count responses of rdSize bytes each.
+
+  \param rdSize
+    The size of one response.
+
+  \param count
+    The number of request/response records.
+
+  \return
+    The number of records transferred completely. If there is a
+    fatal error, returns -1.
+*/
+int CBMAPIDECL
+opencbm_plugin_s1_write_read_n(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count)
+{
+    return xum1541_write_read_n((struct xum1541_usb_handle *)HandleDevice, XUM1541_S1, wrData, wrSize, rdData, rdSize, count);
 }
 
 /*! \brief Read data with serial2 protocol
@@ -111,7 +141,7 @@ opencbm_plugin_s1_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsi
 int CBMAPIDECL
 opencbm_plugin_s2_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xum1541_read((usb_dev_handle *)HandleDevice, XUM1541_S2, data, size);
+    return xum1541_read((struct xum1541_usb_handle *)HandleDevice, XUM1541_S2, data, size);
 }
 
 /*! \brief Write data with serial2 protocol
@@ -132,7 +162,37 @@ opencbm_plugin_s2_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned in
 int CBMAPIDECL
 opencbm_plugin_s2_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xum1541_write((usb_dev_handle *)HandleDevice, XUM1541_S2, data, size);
+    return xum1541_write((struct xum1541_usb_handle *)HandleDevice, XUM1541_S2, data, size);
+}
+
+/*! \brief Run request/response transfers with serial2 protocol
+
+  \param HandleDevice
+    A CBM_FILE which contains the file handle of the driver.
+
+  \param wrData
+    Pointer to count requests of wrSize bytes each.
+
+  \param wrSize
+    The size of one request, may be 0.
+
+  \param rdData
+    Pointer to the buffer which will hold count responses of rdSize bytes each.
+
+  \param rdSize
+    The size of one response.
+
+  \param count
+    The number of request/response records.
+
+  \return
+    The number of records transferred completely. If there is a
+    fatal error, returns -1.
+*/
+int CBMAPIDECL
+opencbm_plugin_s2_write_read_n(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count)
+{
+    return xum1541_write_read_n((struct xum1541_usb_handle *)HandleDevice, XUM1541_S2, wrData, wrSize, rdData, rdSize, count);
 }
 
 /*! \brief Read data with parallel protocol (d64copy)
@@ -153,7 +213,7 @@ opencbm_plugin_s2_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsi
 int CBMAPIDECL
 opencbm_plugin_pp_dc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xum1541_read((usb_dev_handle *)HandleDevice, XUM1541_PP, data, size);
+    return xum1541_read((struct xum1541_usb_handle *)HandleDevice, XUM1541_PP, data, size);
 }
 
 /*! \brief Write data with parallel protocol (d64copy)
@@ -174,7 +234,37 @@ opencbm_plugin_pp_dc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned
 int CBMAPIDECL
 opencbm_plugin_pp_dc_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xum1541_write((usb_dev_handle *)HandleDevice, XUM1541_PP, data, size);
+    return xum1541_write((struct xum1541_usb_handle *)HandleDevice, XUM1541_PP, data, size);
+}
+
+/*! \brief Run request/response transfers with parallel protocol (d64copy) protocol
+
+  \param HandleDevice
+    A CBM_FILE which contains the file handle of the driver.
+
+  \param wrData
+    Pointer to count requests of wrSize bytes each.
+
+  \param wrSize
+    The size of one request, may be 0.
+
+  \param rdData
+    Pointer to the buffer which will hold count responses of rdSize bytes each.
+
+  \param rdSize
+    The size of one response.
+
+  \param count
+    The number of request/response records.
+
+  \return
+    The number of records transferred completely. If there is a
+    fatal error, returns -1.
+*/
+int CBMAPIDECL
+opencbm_plugin_pp_dc_write_read_n(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count)
+{
+    return xum1541_write_read_n((struct xum1541_usb_handle *)HandleDevice, XUM1541_PP, wrData, wrSize, rdData, rdSize, count);
 }
 
 /*! \brief Read data with parallel protocol (cbmcopy)
@@ -195,7 +285,7 @@ opencbm_plugin_pp_dc_write_n(CBM_FILE HandleDevice, const unsigned char *data, u
 int CBMAPIDECL
 opencbm_plugin_pp_cc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xum1541_read((usb_dev_handle *)HandleDevice, XUM1541_P2, data, size);
+    return xum1541_read((struct xum1541_usb_handle *)HandleDevice, XUM1541_P2, data, size);
 }
 
 /*! \brief Write data with parallel protocol (cbmcopy)
@@ -216,7 +306,7 @@ opencbm_plugin_pp_cc_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned
 int CBMAPIDECL
 opencbm_plugin_pp_cc_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xum1541_write((usb_dev_handle *)HandleDevice, XUM1541_P2, data, size);
+    return xum1541_write((struct xum1541_usb_handle *)HandleDevice, XUM1541_P2, data, size);
 }
 
 /*! \brief Read data with burst nibbler protocol (cbmcopy)
@@ -237,7 +327,7 @@ opencbm_plugin_pp_cc_write_n(CBM_FILE HandleDevice, const unsigned char *data, u
 int CBMAPIDECL
 opencbm_plugin_nib_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned int size)
 {
-    return xum1541_read((usb_dev_handle *)HandleDevice, XUM1541_NIB, data, size);
+    return xum1541_read((struct xum1541_usb_handle *)HandleDevice, XUM1541_NIB, data, size);
 }
 
 /*! \brief Write data with burst nibbler protocol (cbmcopy)
@@ -258,5 +348,35 @@ opencbm_plugin_nib_read_n(CBM_FILE HandleDevice, unsigned char *data, unsigned i
 int CBMAPIDECL
 opencbm_plugin_nib_write_n(CBM_FILE HandleDevice, const unsigned char *data, unsigned int size)
 {
-    return xum1541_write((usb_dev_handle *)HandleDevice, XUM1541_NIB, data, size);
+    return xum1541_write((struct xum1541_usb_handle *)HandleDevice, XUM1541_NIB, data, size);
+}
+
+/*! \brief Run request/response transfers with burst nibbler protocol
+
+  \param HandleDevice
+    A CBM_FILE which contains the file handle of the driver.
+
+  \param wrData
+    Pointer to count requests of wrSize bytes each.
+
+  \param wrSize
+    The size of one request, may be 0.
+
+  \param rdData
+    Pointer to the buffer which will hold count responses of rdSize bytes each.
+
+  \param rdSize
+    The size of one response.
+
+  \param count
+    The number of request/response records.
+
+  \return
+    The number of records transferred completely. If there is a
+    fatal error, returns -1.
+*/
+int CBMAPIDECL
+opencbm_plugin_nib_write_read_n(CBM_FILE HandleDevice, const unsigned char *wrData, unsigned int wrSize, unsigned char *rdData, unsigned int rdSize, unsigned int count)
+{
+    return xum1541_write_read_n((struct xum1541_usb_handle *)HandleDevice, XUM1541_NIB, wrData, wrSize, rdData, rdSize, count);
 }
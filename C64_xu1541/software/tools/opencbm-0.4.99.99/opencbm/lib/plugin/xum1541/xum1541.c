@@ -43,7 +43,12 @@
 
 static int debug_level = -1; /*!< \internal \brief the debugging level for debugging output */
 
-unsigned char DeviceDriveMode; // Temporary disk/tape mode hack until usb device handle context is there.
+/*
+ * libusb keeps the list of busses and devices in global variables.
+ * Scanning it is serialized, so several devices can be opened from
+ * different threads at the same time.
+ */
+static arch_mutex_t *usb_scan_mutex;
 
 /*! \internal \brief Output debugging information for the xum1541
 
@@ -128,100 +133,130 @@ usbGetStringAscii(usb_dev_handle *dev, int index, int langid,
 
 // Cleanup after a failure
 static void
-xum1541_cleanup(usb_dev_handle **HandleXum1541, char *msg, ...)
+xum1541_cleanup(usb_dev_handle **devh, char *msg, ...)
 {
     va_list args;
 
     if (msg != NULL) {
         va_start(args, msg);
-        fprintf(stderr, msg, args);
+        vfprintf(stderr, msg, args);
         va_end(args);
     }
-    if (*HandleXum1541 != NULL)
-        usb.close(*HandleXum1541);
-    *HandleXum1541 = NULL;
+    if (*devh != NULL)
+        usb.close(*devh);
+    *devh = NULL;
 }
 
-// USB bus enumeration
+// Rescan the USB busses. Must be called with usb_scan_mutex held.
 static void
-xum1541_enumerate(usb_dev_handle **HandleXum1541, int PortNumber)
+xum1541_scan_busses(void)
+{
+    xum1541_dbg(0, "scanning usb ...");
+
+    usb.init();
+    usb.find_busses();
+    usb.find_devices();
+
+    /* usb.find_devices sets errno if some devices don't reply 100% correct. */
+    /* make lib ignore this as this has nothing to do with our device */
+    errno = 0;
+}
+
+/*
+ * Open a USB device and check if it is an xum1541.
+ *
+ * Returns the serial number of the device, 0 if it has none, and leaves
+ * *devh open. Returns -1 with *devh being NULL if the device is no
+ * xum1541, or if NeedSerial is set and the serial number cannot be read.
+ */
+static int
+xum1541_probe(struct usb_bus *bus, struct usb_device *dev,
+    usb_dev_handle **devh, int NeedSerial)
 {
     static char xumProduct[] = "xum1541"; // Start of USB product string id
     static int prodLen = sizeof(xumProduct) - 1;
+    char string[256];
+    int len, serialnum;
+
+    *devh = NULL;
+
+    xum1541_dbg(1, "device %04x:%04x at %s",
+        dev->descriptor.idVendor, dev->descriptor.idProduct,
+        dev->filename);
+
+    // First, find our vendor and product id
+    if (dev->descriptor.idVendor != XUM1541_VID ||
+        dev->descriptor.idProduct != XUM1541_PID)
+        return -1;
+
+    xum1541_dbg(0, "found xu/xum1541 version %04x on bus %s, device %s",
+        dev->descriptor.bcdDevice, bus->dirname, dev->filename);
+    if ((*devh = usb.open(dev)) == NULL) {
+        fprintf(stderr, "error: Cannot open USB device: %s\n",
+            usb.strerror());
+        return -1;
+    }
+
+    // Get device product name and try to match against "xum1541".
+    // If no match, it could be an xum1541 so don't report an error.
+    len = usbGetStringAscii(*devh, dev->descriptor.iProduct,
+        0x0409, string, sizeof(string) - 1);
+    if (len < 0) {
+        xum1541_cleanup(devh,
+            "error: cannot query product name: %s\n", usb.strerror());
+        return -1;
+    }
+    string[len] = '\0';
+    if (len < prodLen || strstr(string, xumProduct) == NULL) {
+        xum1541_cleanup(devh, NULL);
+        return -1;
+    }
+    xum1541_dbg(0, "xum1541 name: %s", string);
+
+    len = usbGetStringAscii(*devh,
+        dev->descriptor.iSerialNumber, 0x0409,
+        string, sizeof(string) - 1);
+    if (len < 0 && NeedSerial) {
+        xum1541_cleanup(devh,
+            "error: cannot query serial number: %s\n",
+            usb.strerror());
+        return -1;
+    }
+    serialnum = 0;
+    if (len > 0 && len <=3 ) {
+        string[len] = '\0';
+        serialnum = atoi(string);
+    }
+    return serialnum;
+}
+
+// USB bus enumeration
+static void
+xum1541_enumerate(usb_dev_handle **devh, int PortNumber)
+{
     struct usb_bus *bus;
     struct usb_device *dev, *preferredDefaultHandle;
-    char string[256];
-    int len, serialnum, leastserial;
+    int serialnum, leastserial;
 
     if (PortNumber < 0 || PortNumber > MAX_ALLOWED_XUM1541_SERIALNUM) {
         // Normalise the Portnumber for invalid values
         PortNumber = 0;
     }
 
-    xum1541_dbg(0, "scanning usb ...");
-
-    usb.init();
-    usb.find_busses();
-    usb.find_devices();
-
-    /* usb.find_devices sets errno if some devices don't reply 100% correct. */
-    /* make lib ignore this as this has nothing to do with our device */
-    errno = 0;
+    arch_mutex_lock(&usb_scan_mutex);
+    xum1541_scan_busses();
 
-    *HandleXum1541 = NULL;
+    *devh = NULL;
     preferredDefaultHandle = NULL;
     leastserial = MAX_ALLOWED_XUM1541_SERIALNUM + 1;
-    for (bus = usb.get_busses(); !*HandleXum1541 && bus; bus = bus->next) {
+    for (bus = usb.get_busses(); !*devh && bus; bus = bus->next) {
         xum1541_dbg(1, "scanning bus %s", bus->dirname);
-        for (dev = bus->devices; !*HandleXum1541 && dev; dev = dev->next) {
-            xum1541_dbg(1, "device %04x:%04x at %s",
-                dev->descriptor.idVendor, dev->descriptor.idProduct,
-                dev->filename);
-
-            // First, find our vendor and product id
-            if (dev->descriptor.idVendor != XUM1541_VID ||
-                dev->descriptor.idProduct != XUM1541_PID)
+        for (dev = bus->devices; !*devh && dev; dev = dev->next) {
+            // we need the serial number, when PortNumber is not 0
+            serialnum = xum1541_probe(bus, dev, devh, PortNumber != 0);
+            if (serialnum < 0)
                 continue;
 
-            xum1541_dbg(0, "found xu/xum1541 version %04x on bus %s, device %s",
-                dev->descriptor.bcdDevice, bus->dirname, dev->filename);
-            if ((*HandleXum1541 = usb.open(dev)) == NULL) {
-                fprintf(stderr, "error: Cannot open USB device: %s\n",
-                    usb.strerror());
-                continue;
-            }
-
-            // Get device product name and try to match against "xum1541".
-            // If no match, it could be an xum1541 so don't report an error.
-            len = usbGetStringAscii(*HandleXum1541, dev->descriptor.iProduct,
-                0x0409, string, sizeof(string) - 1);
-            if (len < 0) {
-                xum1541_cleanup(HandleXum1541,
-                    "error: cannot query product name: %s\n", usb.strerror());
-                continue;
-            }
-            string[len] = '\0';
-            if (len < prodLen || strstr(string, xumProduct) == NULL) {
-                xum1541_cleanup(HandleXum1541, NULL);
-                continue;
-            }
-            xum1541_dbg(0, "xum1541 name: %s", string);
-
-            len = usbGetStringAscii(*HandleXum1541,
-                dev->descriptor.iSerialNumber, 0x0409,
-                string, sizeof(string) - 1);
-            if (len < 0 && PortNumber != 0){
-                // we need the serial number, when PortNumber is not 0
-                xum1541_cleanup(HandleXum1541,
-                    "error: cannot query serial number: %s\n",
-                    usb.strerror());
-                continue;
-            }
-            serialnum = 0;
-            if (len > 0 && len <=3 ) {
-                string[len] = '\0';
-                serialnum = atoi(string);
-            }
             if (PortNumber != serialnum) {
                 // keep in mind the handle, if the device's
                 // serial number is less than previous ones
@@ -229,22 +264,65 @@ xum1541_enumerate(usb_dev_handle **HandleXum1541, int PortNumber)
                     leastserial = serialnum;
                     preferredDefaultHandle = dev;
                 }
-                xum1541_cleanup(HandleXum1541, NULL);
+                xum1541_cleanup(devh, NULL);
                 continue;
             }
 
             xum1541_dbg(0, "xum1541 serial number: %3u", serialnum);
-            return;
         }
     }
     // if no default device was found because only specific devices were present,
     // determine the default device from the specific ones and open it
-    if(preferredDefaultHandle != NULL) {
-        if ((*HandleXum1541 = usb.open(preferredDefaultHandle)) == NULL) {
+    if(*devh == NULL && preferredDefaultHandle != NULL) {
+        if ((*devh = usb.open(preferredDefaultHandle)) == NULL) {
             fprintf(stderr, "error: Cannot reopen USB device: %s\n",
                 usb.strerror());
         }
     }
+    arch_mutex_unlock(usb_scan_mutex);
+}
+
+/*! \brief Enumerate the xum1541 devices which are present
+
+  \param Serials
+   Pointer to an array which gets the serial numbers of the devices.
+
+  \param Count
+   The number of elements in Serials.
+
+  \return
+    The number of devices found; only the first Count of them are stored.
+
+  \remark
+    Devices without a serial number are reported as 0. This is also the
+    port number which opens the device with the least serial number.
+*/
+int
+xum1541_enumerate_serials(unsigned int *Serials, unsigned int Count)
+{
+    struct usb_bus *bus;
+    struct usb_device *dev;
+    usb_dev_handle *devh;
+    int serialnum, found = 0;
+
+    arch_mutex_lock(&usb_scan_mutex);
+    xum1541_scan_busses();
+
+    for (bus = usb.get_busses(); bus; bus = bus->next) {
+        for (dev = bus->devices; dev; dev = dev->next) {
+            serialnum = xum1541_probe(bus, dev, &devh, 0);
+            if (serialnum < 0)
+                continue;
+            xum1541_cleanup(&devh, NULL);
+
+            if ((unsigned int) found < Count)
+                Serials[found] = serialnum;
+            found++;
+        }
+    }
+    arch_mutex_unlock(usb_scan_mutex);
+
+    return found;
 }
 
 // Check for a firmware version compatible with this plugin
@@ -274,28 +352,22 @@ xum1541_check_version(int version)
    The device's serial number to search for also. It is not considered, if set to 0.
 
   \return
-    0 on success, -1 on error. On error, the handle is cleaned up if it
-    was already active.
-
-  \remark
-    On success, xum1541_handle contains a valid handle to the xum1541 device.
-    In this case, the device configuration has been set and the interface
-    been claimed. xum1541_close() should be called when the user is done
-    with it.
+    The libusb path of the device. The device is not kept open.
 */
 const char *
 xum1541_device_path(int PortNumber)
 {
 #define PREFIX_OFFSET   (sizeof("libusb/xum1541:") - 1)
-    usb_dev_handle *HandleXum1541;
+    usb_dev_handle *devh;
     static char dev_path[PREFIX_OFFSET + LIBUSB_PATH_MAX] = "libusb/xum1541:";
 
     dev_path[PREFIX_OFFSET + 1] = '\0';
-    xum1541_enumerate(&HandleXum1541, PortNumber);
+    xum1541_enumerate(&devh, PortNumber);
 
-    if (HandleXum1541 != NULL) {
-        strcpy(dev_path, (usb.device(HandleXum1541))->filename);
-        xum1541_close(HandleXum1541);
+    if (devh != NULL) {
+        strcpy(dev_path, (usb.device(devh))->filename);
+        // The interface has not been claimed, so do not shut down the device
+        xum1541_cleanup(&devh, NULL);
     } else {
         fprintf(stderr, "error: no xum1541 device found\n");
     }
@@ -355,7 +427,7 @@ xum1541_clear_halt(usb_dev_handle *handle)
   This function tries to find and identify the xum1541 device.
 
   \param HandleXum1541
-   Pointer to a XUM1541_HANDLE which will contain the file handle of the USB device.
+   Pointer to a xum1541_usb_handle pointer which gets the state of the USB device.
 
   \param PortNumber
    The device's serial number to search for also. It is not considered, if set to 0.
@@ -365,30 +437,39 @@ xum1541_clear_halt(usb_dev_handle *handle)
     was already active.
 
   \remark
-    On success, xum1541_handle contains a valid handle to the xum1541 device.
+    On success, *HandleXum1541 points to the state of the xum1541 device.
     In this case, the device configuration has been set and the interface
     been claimed. xum1541_close() should be called when the user is done
     with it.
 */
 int
-xum1541_init(usb_dev_handle **HandleXum1541, int PortNumber)
+xum1541_init(struct xum1541_usb_handle **HandleXum1541, int PortNumber)
 {
+    struct xum1541_usb_handle *uh;
     unsigned char devInfo[XUM_DEVINFO_SIZE], devStatus;
     int len;
 
-    // Place after "xum1541_usb_handle" allocation:
-    /*uh->*/DeviceDriveMode = DeviceDriveMode_Uninit;
+    *HandleXum1541 = NULL;
 
-    xum1541_enumerate(HandleXum1541, PortNumber);
+    uh = malloc(sizeof(*uh));
+    if (uh == NULL) {
+        fprintf(stderr, "error: out of memory\n");
+        return -1;
+    }
+    uh->DeviceDriveMode = DeviceDriveMode_Uninit;
 
-    if (*HandleXum1541 == NULL) {
+    xum1541_enumerate(&uh->devh, PortNumber);
+
+    if (uh->devh == NULL) {
         fprintf(stderr, "error: no xum1541 device found\n");
+        free(uh);
         return -1;
     }
 
     // Select first and only device configuration.
-    if (usb.set_configuration(*HandleXum1541, 1) != 0) {
-        xum1541_cleanup(HandleXum1541, "USB error: %s\n", usb.strerror());
+    if (usb.set_configuration(uh->devh, 1) != 0) {
+        xum1541_cleanup(&uh->devh, "USB error: %s\n", usb.strerror());
+        free(uh);
         return -1;
     }
 
@@ -397,23 +478,24 @@ xum1541_init(usb_dev_handle **HandleXum1541, int PortNumber)
      * After this point, do cleanup using xum1541_close() instead of
      * xum1541_cleanup().
      */
-    if (usb.claim_interface(*HandleXum1541, 0) != 0) {
-        xum1541_cleanup(HandleXum1541, "USB error: %s\n", usb.strerror());
+    if (usb.claim_interface(uh->devh, 0) != 0) {
+        xum1541_cleanup(&uh->devh, "USB error: %s\n", usb.strerror());
+        free(uh);
         return -1;
     }
 
     // Check the basic device info message for firmware version
     memset(devInfo, 0, sizeof(devInfo));
-    len = usb.control_msg(*HandleXum1541, USB_TYPE_CLASS | USB_ENDPOINT_IN,
+    len = usb.control_msg(uh->devh, USB_TYPE_CLASS | USB_ENDPOINT_IN,
         XUM1541_INIT, 0, 0, (char*)devInfo, sizeof(devInfo), USB_TIMEOUT);
     if (len < 2) {
         fprintf(stderr, "USB request for XUM1541 info failed: %s\n",
             usb.strerror());
-        xum1541_close(*HandleXum1541);
+        xum1541_close(uh);
         return -1;
     }
     if (xum1541_check_version(devInfo[0]) != 0) {
-        xum1541_close(*HandleXum1541);
+        xum1541_close(uh);
         return -1;
     }
     if (len >= 4) {
@@ -421,13 +503,15 @@ xum1541_init(usb_dev_handle **HandleXum1541, int PortNumber)
             devInfo[1], devInfo[2]);
     }
 
+    uh->Capabilities = devInfo[1];
+
     // Check for the xum1541's current status. (Not the drive.)
     devStatus = devInfo[2];
     if ((devStatus & XUM1541_DOING_RESET) != 0) {
         fprintf(stderr, "previous command was interrupted, resetting\n");
         // Clear the stalls on both endpoints
-        if (xum1541_clear_halt(*HandleXum1541) < 0) {
-            xum1541_close(*HandleXum1541);
+        if (xum1541_clear_halt(uh->devh) < 0) {
+            xum1541_close(uh);
             return -1;
         }
     }
@@ -437,57 +521,61 @@ xum1541_init(usb_dev_handle **HandleXum1541, int PortNumber)
 	{
 		if (devInfo[2] & XUM1541_TAPE_PRESENT)
 		{
-			/*uh->*/DeviceDriveMode = DeviceDriveMode_Tape;
+			uh->DeviceDriveMode = DeviceDriveMode_Tape;
             xum1541_dbg(1, "[xum1541_init] Tape supported, tape mode entered.");
 		}
 		else
 		{
-			/*uh->*/DeviceDriveMode = DeviceDriveMode_Disk;
+			uh->DeviceDriveMode = DeviceDriveMode_Disk;
             xum1541_dbg(1, "[xum1541_init] Tape supported, disk mode entered.");
 		}
 	}
 	else
 	{
-		DeviceDriveMode = (unsigned char) DeviceDriveMode_NoTapeSupport;
+		uh->DeviceDriveMode = DeviceDriveMode_NoTapeSupport;
         xum1541_dbg(1, "[xum1541_init] No tape support.");
 	}
 
+    *HandleXum1541 = uh;
     return 0;
 }
 /*! \brief close the xum1541 device
 
  \param HandleXum1541
-   Pointer to a XUM1541_HANDLE which will contain the file handle of the USB device.
+   The xum1541_usb_handle of the USB device.
 
  \remark
-    This function releases the interface and closes the xum1541 handle.
+    This function releases the interface, closes the xum1541 handle
+    and frees its state.
 */
 void
-xum1541_close(usb_dev_handle *HandleXum1541)
+xum1541_close(struct xum1541_usb_handle *HandleXum1541)
 {
     int ret;
 
     xum1541_dbg(0, "Closing USB link");
 
-    ret = usb.control_msg(HandleXum1541, USB_TYPE_CLASS | USB_ENDPOINT_OUT,
+    ret = usb.control_msg(HandleXum1541->devh, USB_TYPE_CLASS | USB_ENDPOINT_OUT,
         XUM1541_SHUTDOWN, 0, 0, NULL, 0, 1000);
     if (ret < 0) {
         fprintf(stderr,
             "USB request for XUM1541 close failed, continuing: %s\n",
             usb.strerror());
     }
-    if (usb.release_interface(HandleXum1541, 0) != 0)
+    if (usb.release_interface(HandleXum1541->devh, 0) != 0)
         fprintf(stderr, "USB release intf error: %s\n", usb.strerror());
 
-    if (usb.close(HandleXum1541) != 0)
+    if (usb.close(HandleXum1541->devh) != 0)
         fprintf(stderr, "USB close error: %s\n", usb.strerror());
+
+    free(HandleXum1541);
 }
 
 /*! \brief  Handle synchronous USB control messages, e.g. for RESET.
     xum1541_ioctl() is used for bulk messages.
 
  \param HandleXum1541
-   A XUM1541_HANDLE which contains the file handle of the USB device.
+   The xum1541_usb_handle of the USB device.
 
  \param cmd
    The command to run.
@@ -496,13 +584,13 @@ xum1541_close(usb_dev_handle *HandleXum1541)
    Returns the value the USB device sent back.
 */
 int
-xum1541_control_msg(usb_dev_handle *HandleXum1541, unsigned int cmd)
+xum1541_control_msg(struct xum1541_usb_handle *HandleXum1541, unsigned int cmd)
 {
     int nBytes;
 
     xum1541_dbg(1, "control msg %d", cmd);
 
-    nBytes = usb.control_msg(HandleXum1541, USB_TYPE_CLASS | USB_ENDPOINT_OUT,
+    nBytes = usb.control_msg(HandleXum1541->devh, USB_TYPE_CLASS | USB_ENDPOINT_OUT,
         cmd, 0, 0, NULL, 0, USB_TIMEOUT);
     if (nBytes < 0) {
         fprintf(stderr, "USB error in xum1541_control_msg: %s\n",
@@ -514,7 +602,7 @@ xum1541_control_msg(usb_dev_handle *HandleXum1541, unsigned int cmd)
 }
 
 static int
-xum1541_wait_status(usb_dev_handle *HandleXum1541)
+xum1541_wait_status(struct xum1541_usb_handle *HandleXum1541)
 {
     int nBytes, deviceBusy, ret;
     unsigned char statusBuf[XUM_STATUSBUF_SIZE];
@@ -522,7 +610,7 @@ xum1541_wait_status(usb_dev_handle *HandleXum1541)
     xum1541_dbg(2, "xum1541_wait_status checking for status");
     deviceBusy = 1;
     while (deviceBusy) {
-        nBytes = usb.bulk_read(HandleXum1541,
+        nBytes = usb.bulk_read(HandleXum1541->devh,
             XUM_BULK_IN_ENDPOINT | USB_ENDPOINT_IN,
             (char*)statusBuf, XUM_STATUSBUF_SIZE, LIBUSB_NO_TIMEOUT);
         if (nBytes == XUM_STATUSBUF_SIZE) {
@@ -558,11 +646,69 @@ xum1541_wait_status(usb_dev_handle *HandleXum1541)
     return ret;
 }
 
+/*
+ * Send the command block for a read or write with the given protocol.
+ * Returns the result of the bulk transfer, < 0 on error.
+ */
+static int
+xum1541_send_cmd(struct xum1541_usb_handle *HandleXum1541, unsigned char cmd,
+    unsigned char mode, size_t size)
+{
+    unsigned char cmdBuf[XUM_CMDBUF_SIZE];
+
+    cmdBuf[0] = cmd;
+    cmdBuf[1] = mode;
+    cmdBuf[2] = size & 0xff;
+    cmdBuf[3] = (size >> 8) & 0xff;
+    return usb.bulk_write(HandleXum1541->devh,
+        XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT,
+        (char *)cmdBuf, sizeof(cmdBuf), LIBUSB_NO_TIMEOUT);
+}
+
+/*
+ * Read the data of a read command, in chunks of at most XUM_MAX_XFER_SIZE.
+ * Returns the number of bytes read, or -1 on a USB error.
+ */
+static int
+xum1541_read_data(struct xum1541_usb_handle *HandleXum1541, unsigned char *data, size_t size)
+{
+    int rd;
+    size_t bytesRead, bytes2read;
+
+    bytesRead = 0;
+    while (bytesRead < size) {
+        bytes2read = size - bytesRead;
+        if (bytes2read > XUM_MAX_XFER_SIZE)
+            bytes2read = XUM_MAX_XFER_SIZE;
+        rd = usb.bulk_read(HandleXum1541->devh,
+            XUM_BULK_IN_ENDPOINT | USB_ENDPOINT_IN,
+            (char *)data, bytes2read, LIBUSB_NO_TIMEOUT);
+        if (rd < 0) {
+            fprintf(stderr, "USB error in read data(%p, %d): %s\n",
+               data, (int)size, usb.strerror());
+            return -1;
+        } else if (rd > 0)
+            xum1541_dbg(2, "read %d bytes", rd);
+
+        data += rd;
+        bytesRead += rd;
+
+        /*
+         * If we read less than we requested (or 0), the transfer is done
+         * even if we had more data to read still.
+         */
+        if (rd < (int)bytes2read)
+            break;
+    }
+
+    return bytesRead;
+}
+
 // Macro to enforce disk/tape mode.
 // Checks if xum1541_ioctl/xum1541_read/xum1541_write command is allowed in currently set disk/tape mode.
 #define RefuseToWorkInWrongMode \
     {                                                                                                    \
-        if (/*uh->*/DeviceDriveMode == DeviceDriveMode_Uninit)                                               \
+        if (HandleXum1541->DeviceDriveMode == DeviceDriveMode_Uninit)                                               \
         {                                                                                                \
             xum1541_dbg(1, "[RefuseToWorkInWrongMode] cmd blocked - No disk or tape mode set.");         \
             return XUM1541_Error_NoDiskTapeMode;                                                         \
@@ -570,13 +716,13 @@ xum1541_wait_status(usb_dev_handle *HandleXum1541)
                                                                                                          \
         if (isTapeCmd)                                                                                   \
         {                                                                                                \
-            if (/*uh->*/DeviceDriveMode == DeviceDriveMode_NoTapeSupport)                                \
+            if (HandleXum1541->DeviceDriveMode == DeviceDriveMode_NoTapeSupport)                                \
             {                                                                                            \
                 xum1541_dbg(1, "[RefuseToWorkInWrongMode] cmd blocked - Firmware has no tape support."); \
                 return XUM1541_Error_NoTapeSupport;                                                      \
             }                                                                                            \
                                                                                                          \
-            if (/*uh->*/DeviceDriveMode == DeviceDriveMode_Disk)                                             \
+            if (HandleXum1541->DeviceDriveMode == DeviceDriveMode_Disk)                                             \
             {                                                                                            \
                 xum1541_dbg(1, "[RefuseToWorkInWrongMode] cmd blocked - Tape cmd in disk mode.");        \
                 return XUM1541_Error_TapeCmdInDiskMode;                                                  \
@@ -584,7 +730,7 @@ xum1541_wait_status(usb_dev_handle *HandleXum1541)
         }                                                                                                \
         else /*isDiskCmd*/                                                                               \
         {                                                                                                \
-            if (/*uh->*/DeviceDriveMode == DeviceDriveMode_Tape)                                             \
+            if (HandleXum1541->DeviceDriveMode == DeviceDriveMode_Tape)                                             \
             {                                                                                            \
                 xum1541_dbg(1, "[RefuseToWorkInWrongMode] cmd blocked - Disk cmd in tape mode.");        \
                 return XUM1541_Error_DiskCmdInTapeMode;                                                  \
@@ -596,7 +742,7 @@ xum1541_wait_status(usb_dev_handle *HandleXum1541)
     read/write or special device management commands such as INIT and RESET.
 
  \param HandleXum1541
-   A XUM1541_HANDLE which contains the file handle of the USB device.
+   The xum1541_usb_handle of the USB device.
 
  \param cmd
    The command to run.
@@ -613,7 +759,7 @@ xum1541_wait_status(usb_dev_handle *HandleXum1541)
    info from the device such as the active IEC lines.
 */
 int
-xum1541_ioctl(usb_dev_handle *HandleXum1541, unsigned int cmd, unsigned int addr, unsigned int secaddr)
+xum1541_ioctl(struct xum1541_usb_handle *HandleXum1541, unsigned int cmd, unsigned int addr, unsigned int secaddr)
 {
     int nBytes, ret;
     unsigned char cmdBuf[XUM_CMDBUF_SIZE];
@@ -629,7 +775,7 @@ xum1541_ioctl(usb_dev_handle *HandleXum1541, unsigned int cmd, unsigned int addr
     cmdBuf[3] = 0;
 
     // Send the 4-byte command block
-    nBytes = usb.bulk_write(HandleXum1541,
+    nBytes = usb.bulk_write(HandleXum1541->devh,
         XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT,
         (char *)cmdBuf, sizeof(cmdBuf), LIBUSB_NO_TIMEOUT);
     if (nBytes < 0) {
@@ -647,13 +793,13 @@ xum1541_ioctl(usb_dev_handle *HandleXum1541, unsigned int cmd, unsigned int addr
 /*! \brief Send tape operations abort command to the xum1541 device
 
  \param HandleXum1541
-   A XUM1541_HANDLE which contains the file handle of the USB device.
+   The xum1541_usb_handle of the USB device.
 
  \return
    Returns the value the USB device sent back.
 */
 int
-xum1541_tap_break(usb_dev_handle *HandleXum1541)
+xum1541_tap_break(struct xum1541_usb_handle *HandleXum1541)
 {
     BOOL isTapeCmd = TRUE;
     RefuseToWorkInWrongMode; // Check if command allowed in current disk/tape mode.
@@ -666,7 +812,7 @@ xum1541_tap_break(usb_dev_handle *HandleXum1541)
 /*! \brief Write data to the xum1541 device
 
  \param HandleXum1541
-   A XUM1541_HANDLE which contains the file handle of the USB device.
+   The xum1541_usb_handle of the USB device.
 
  \param mode
     Drive protocol to use to read the data from the device (e.g,
@@ -683,7 +829,7 @@ xum1541_tap_break(usb_dev_handle *HandleXum1541)
     fatal error, returns -1.
 */
 int
-xum1541_write(usb_dev_handle *HandleXum1541, unsigned char modeFlags, const unsigned char *data, size_t size)
+xum1541_write(struct xum1541_usb_handle *HandleXum1541, unsigned char modeFlags, const unsigned char *data, size_t size)
 {
     int wr, mode, ret;
     size_t bytesWritten, bytes2write;
@@ -701,7 +847,7 @@ xum1541_write(usb_dev_handle *HandleXum1541, unsigned char modeFlags, const unsi
     cmdBuf[1] = modeFlags;
     cmdBuf[2] = size & 0xff;
     cmdBuf[3] = (size >> 8) & 0xff;
-    wr = usb.bulk_write(HandleXum1541,
+    wr = usb.bulk_write(HandleXum1541->devh,
         XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT,
         (char *)cmdBuf, sizeof(cmdBuf), LIBUSB_NO_TIMEOUT);
     if (wr < 0) {
@@ -715,15 +861,15 @@ xum1541_write(usb_dev_handle *HandleXum1541, unsigned char modeFlags, const unsi
         bytes2write = size - bytesWritten;
         if (bytes2write > XUM_MAX_XFER_SIZE)
             bytes2write = XUM_MAX_XFER_SIZE;
-        wr = usb.bulk_write(HandleXum1541,
+        wr = usb.bulk_write(HandleXum1541->devh,
             XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT,
             (char *)data, bytes2write, LIBUSB_NO_TIMEOUT);
         if (wr < 0) {
             if (isTapeCmd)
             {
-                if (usb.resetep(HandleXum1541, XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT) < 0)
+                if (usb.resetep(HandleXum1541->devh, XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT) < 0)
                     fprintf(stderr, "USB reset ep request failed for out ep (tape stall): %s\n", usb.strerror());
-                if (usb.control_msg(HandleXum1541, USB_RECIP_ENDPOINT, USB_REQ_CLEAR_FEATURE, 0, XUM_BULK_OUT_ENDPOINT, NULL, 0, USB_TIMEOUT) < 0)
+                if (usb.control_msg(HandleXum1541->devh, USB_RECIP_ENDPOINT, USB_REQ_CLEAR_FEATURE, 0, XUM_BULK_OUT_ENDPOINT, NULL, 0, USB_TIMEOUT) < 0)
                     fprintf(stderr, "USB error in xum1541_control_msg (tape stall): %s\n", usb.strerror());
                 return bytesWritten;
             }
@@ -772,7 +918,7 @@ xum1541_write(usb_dev_handle *HandleXum1541, unsigned char modeFlags, const unsi
 */
 
 int
-xum1541_write_ext(usb_dev_handle *HandleXum1541, unsigned char modeFlags, const unsigned char *data, size_t size, int *Status, int *BytesWritten)
+xum1541_write_ext(struct xum1541_usb_handle *HandleXum1541, unsigned char modeFlags, const unsigned char *data, size_t size, int *Status, int *BytesWritten)
 {
     xum1541_dbg(1, "[xum1541_write_ext]");
     *BytesWritten = xum1541_write(HandleXum1541, modeFlags, data, size);
@@ -798,7 +944,7 @@ xum1541_write_ext(usb_dev_handle *HandleXum1541, unsigned char modeFlags, const
 */
 
 int
-xum1541_read_ext(usb_dev_handle *HandleXum1541, unsigned char mode, unsigned char *data, size_t size, int *Status, int *BytesRead)
+xum1541_read_ext(struct xum1541_usb_handle *HandleXum1541, unsigned char mode, unsigned char *data, size_t size, int *Status, int *BytesRead)
 {
     xum1541_dbg(1, "[xum1541_read_ext]");
     *BytesRead = xum1541_read(HandleXum1541, mode, data, size);
@@ -813,7 +959,7 @@ xum1541_read_ext(usb_dev_handle *HandleXum1541, unsigned char mode, unsigned cha
 /*! \brief Read data from the xum1541 device
 
  \param HandleXum1541
-   A XUM1541_HANDLE which contains the file handle of the USB device.
+   The xum1541_usb_handle of the USB device.
 
  \param mode
     Drive protocol to use to read the data from the device (e.g,
@@ -830,11 +976,9 @@ xum1541_read_ext(usb_dev_handle *HandleXum1541, unsigned char mode, unsigned cha
     fatal error, returns -1.
 */
 int
-xum1541_read(usb_dev_handle *HandleXum1541, unsigned char mode, unsigned char *data, size_t size)
+xum1541_read(struct xum1541_usb_handle *HandleXum1541, unsigned char mode, unsigned char *data, size_t size)
 {
     int rd;
-    size_t bytesRead, bytes2read;
-    unsigned char cmdBuf[XUM_CMDBUF_SIZE];
     BOOL isTapeCmd = ((mode == XUM1541_TAP) || (mode == XUM1541_TAP_CONFIG));
 
     xum1541_dbg(1, "read %d %d bytes to address %p",
@@ -843,46 +987,128 @@ xum1541_read(usb_dev_handle *HandleXum1541, unsigned char mode, unsigned char *d
     RefuseToWorkInWrongMode; // Check if command allowed in current disk/tape mode.
 
     // Send the read command
-    cmdBuf[0] = XUM1541_READ;
-    cmdBuf[1] = mode;
-    cmdBuf[2] = size & 0xff;
-    cmdBuf[3] = (size >> 8) & 0xff;
-    rd = usb.bulk_write(HandleXum1541,
-        XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT,
-        (char *)cmdBuf, sizeof(cmdBuf), LIBUSB_NO_TIMEOUT);
-    if (rd < 0) {
+    if (xum1541_send_cmd(HandleXum1541, XUM1541_READ, mode, size) < 0) {
         fprintf(stderr, "USB error in read cmd: %s\n",
             usb.strerror());
         return -1;
     }
 
     // Read the actual data now that it's ready.
-    bytesRead = 0;
-    while (bytesRead < size) {
-        bytes2read = size - bytesRead;
-        if (bytes2read > XUM_MAX_XFER_SIZE)
-            bytes2read = XUM_MAX_XFER_SIZE;
-        rd = usb.bulk_read(HandleXum1541,
-            XUM_BULK_IN_ENDPOINT | USB_ENDPOINT_IN,
-            (char *)data, bytes2read, LIBUSB_NO_TIMEOUT);
-        if (rd < 0) {
-            fprintf(stderr, "USB error in read data(%p, %d): %s\n",
-               data, (int)size, usb.strerror());
+    rd = xum1541_read_data(HandleXum1541, data, size);
+    if (rd >= 0)
+        xum1541_dbg(2, "read done, got %d bytes", rd);
+    return rd;
+}
+
+/*! \brief Run a batch of request/response transfers on the xum1541 device
+
+ Every record is made up of a write of wrSize bytes (the request, e.g.
+ track and sector) followed by a read of rdSize bytes (the response,
+ e.g. status and block data), both with the given protocol.
+
+ The transfers are pipelined: the command block of the next record is
+ sent while the adapter is still busy with the current one, so it can
+ go on without waiting for the host. Only a single command block is
+ queued ahead; the adapter's OUT endpoint has room for exactly one
+ packet while it is sending data to the host.
+
+ \param HandleXum1541
+   The xum1541_usb_handle of the USB device.
+
+ \param mode
+    Drive protocol to use (e.g, XUM1541_S1). The CBM and tape protocols
+    are not allowed here.
+
+ \param wrData
+    Pointer to count requests of wrSize bytes each.
+
+ \param wrSize
+    The size of one request, may be 0 for batched reads.
+
+ \param rdData
+    Pointer to a buffer for count responses of rdSize bytes each.
+
+ \param rdSize
+    The size of one response.
+
+ \param count
+    The number of records.
+
+ \return
+    The number of records transferred completely. If a response was
+    short, it is the index of that record. If there is a fatal error,
+    returns -1.
+*/
+int
+xum1541_write_read_n(struct xum1541_usb_handle *HandleXum1541, unsigned char mode,
+    const unsigned char *wrData, size_t wrSize,
+    unsigned char *rdData, size_t rdSize, unsigned int count)
+{
+    unsigned int i, done;
+    int rd, queued;
+    BOOL isTapeCmd = ((mode == XUM1541_TAP) || (mode == XUM1541_TAP_CONFIG));
+
+    xum1541_dbg(1, "write/read %d %d records of %d/%d bytes",
+        mode, count, wrSize, rdSize);
+
+    RefuseToWorkInWrongMode; // Check if command allowed in current disk/tape mode.
+
+    if (isTapeCmd || XUM_RW_PROTO(mode) == XUM1541_CBM ||
+        wrSize > XUM_MAX_XFER_SIZE || rdSize == 0 || rdSize > XUM_MAX_XFER_SIZE) {
+        xum1541_dbg(1, "write/read not possible for this protocol or size");
+        return -1;
+    }
+
+    done = count;
+    queued = 0;
+    for (i = 0; i < count; i++) {
+        // The first command block of this record might already be queued
+        if (wrSize != 0) {
+            if ((!queued && xum1541_send_cmd(HandleXum1541, XUM1541_WRITE, mode, wrSize) < 0) ||
+                usb.bulk_write(HandleXum1541->devh, XUM_BULK_OUT_ENDPOINT | USB_ENDPOINT_OUT,
+                    (char *)wrData, wrSize, LIBUSB_NO_TIMEOUT) != (int)wrSize ||
+                xum1541_send_cmd(HandleXum1541, XUM1541_READ, mode, rdSize) < 0) {
+                fprintf(stderr, "USB error in write/read request: %s\n",
+                    usb.strerror());
+                return -1;
+            }
+        } else if (!queued &&
+            xum1541_send_cmd(HandleXum1541, XUM1541_READ, mode, rdSize) < 0) {
+            fprintf(stderr, "USB error in write/read cmd: %s\n",
+                usb.strerror());
             return -1;
-        } else if (rd > 0)
-            xum1541_dbg(2, "read %d bytes", rd);
+        }
 
-        data += rd;
-        bytesRead += rd;
+        // Queue the first command block of the next record
+        queued = 0;
+        if (i + 1 < count && done == count) {
+            if (xum1541_send_cmd(HandleXum1541,
+                wrSize != 0 ? XUM1541_WRITE : XUM1541_READ, mode,
+                wrSize != 0 ? wrSize : rdSize) < 0) {
+                fprintf(stderr, "USB error in write/read cmd: %s\n",
+                    usb.strerror());
+                return -1;
+            }
+            queued = 1;
+        }
+
+        rd = xum1541_read_data(HandleXum1541, rdData, rdSize);
+        if (rd < 0)
+            return -1;
+
+        wrData += wrSize;
+        rdData += rdSize;
 
         /*
-         * If we read less than we requested (or 0), the transfer is done
-         * even if we had more data to read still.
+         * After a short response, only finish the record which has
+         * already been started on the adapter, then stop.
          */
-        if (rd < (int)bytes2read)
+        if (rd < (int)rdSize && done == count)
+            done = i;
+        if (done != count && !queued)
             break;
     }
 
-    xum1541_dbg(2, "read done, got %d bytes", bytesRead);
-    return bytesRead;
+    xum1541_dbg(2, "write/read done, %d records", done);
+    return done;
 }
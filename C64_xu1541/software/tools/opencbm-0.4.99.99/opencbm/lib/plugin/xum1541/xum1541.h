@@ -24,7 +24,18 @@
 #define __CTASSERT(x, y)    typedef char __assert ## y[(x) ? 1 : -1]
 #endif
 
-CTASSERT(sizeof(CBM_FILE) >= sizeof(usb_dev_handle *));
+/*
+ * The state of one xum1541 device. A pointer to it is the CBM_FILE
+ * of this plugin, so every device opened has its own state, and
+ * several devices can be driven from different threads.
+ */
+struct xum1541_usb_handle {
+    usb_dev_handle *devh;   // libusb handle of the device
+    int DeviceDriveMode;    // Disk/tape mode, see DeviceDriveMode_xxx below
+    int Capabilities;       // XUM1541_CAP_xxx reported by the firmware
+};
+
+CTASSERT(sizeof(CBM_FILE) >= sizeof(struct xum1541_usb_handle *));
 
 /*
  * Make our control transfer timeout 10% later than the device itself
@@ -47,22 +58,28 @@ CTASSERT(sizeof(CBM_FILE) >= sizeof(usb_dev_handle *));
 #define DeviceDriveMode_Tape            2 // Tape drive mode (only communication to tape drive allowed)
 
 const char *xum1541_device_path(int PortNumber);
-int xum1541_init(usb_dev_handle **HandleXum1541, int PortNumber);
-void xum1541_close(usb_dev_handle *HandleXum1541);
-int xum1541_control_msg(usb_dev_handle *HandleXum1541, unsigned int cmd);
-int xum1541_ioctl(usb_dev_handle *HandleXum1541, unsigned int cmd,
+int xum1541_enumerate_serials(unsigned int *Serials, unsigned int Count);
+int xum1541_init(struct xum1541_usb_handle **HandleXum1541, int PortNumber);
+void xum1541_close(struct xum1541_usb_handle *HandleXum1541);
+int xum1541_control_msg(struct xum1541_usb_handle *HandleXum1541, unsigned int cmd);
+int xum1541_ioctl(struct xum1541_usb_handle *HandleXum1541, unsigned int cmd,
     unsigned int addr, unsigned int secaddr);
 
 // Read/write data in normal CBM and speeder protocol modes
-int xum1541_write(usb_dev_handle *HandleXum1541, unsigned char mode,
+int xum1541_write(struct xum1541_usb_handle *HandleXum1541, unsigned char mode,
     const unsigned char *data, size_t size);
-int xum1541_write_ext(usb_dev_handle *HandleXum1541, unsigned char mode,
+int xum1541_write_ext(struct xum1541_usb_handle *HandleXum1541, unsigned char mode,
     const unsigned char *data, size_t size, int *Status, int *BytesWritten);
-int xum1541_read(usb_dev_handle *HandleXum1541, unsigned char mode,
+int xum1541_read(struct xum1541_usb_handle *HandleXum1541, unsigned char mode,
     unsigned char *data, size_t size);
-int xum1541_read_ext(usb_dev_handle *HandleXum1541, unsigned char mode,
+int xum1541_read_ext(struct xum1541_usb_handle *HandleXum1541, unsigned char mode,
     unsigned char *data, size_t size, int *Status, int *BytesRead);
 
-int xum1541_tap_break(usb_dev_handle *HandleXum1541);
+// Pipelined request/response transfers in speeder protocol modes
+int xum1541_write_read_n(struct xum1541_usb_handle *HandleXum1541, unsigned char mode,
+    const unsigned char *wrData, size_t wrSize,
+    unsigned char *rdData, size_t rdSize, unsigned int count);
+
+int xum1541_tap_break(struct xum1541_usb_handle *HandleXum1541);
 
 #endif // XUM1541_H
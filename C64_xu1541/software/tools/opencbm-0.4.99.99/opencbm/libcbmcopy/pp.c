@@ -253,9 +253,9 @@ static int upload_turbo(CBM_FILE fd, unsigned char drive,
     const struct drive_prog *p;
     int dt;
 
-    opencbm_plugin_pp_cc_read_n = cbm_get_plugin_function_address("opencbm_plugin_pp_cc_read_n");
+    opencbm_plugin_pp_cc_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_pp_cc_read_n");
 
-    opencbm_plugin_pp_cc_write_n = cbm_get_plugin_function_address("opencbm_plugin_pp_cc_write_n");
+    opencbm_plugin_pp_cc_write_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_pp_cc_write_n");
     
     switch(drive_type)
     {
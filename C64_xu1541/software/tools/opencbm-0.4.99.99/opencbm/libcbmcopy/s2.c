@@ -269,9 +269,9 @@ static int upload_turbo(CBM_FILE fd, unsigned char drive,
     const struct drive_prog *p;
     int dt;
 
-    opencbm_plugin_s2_read_n = cbm_get_plugin_function_address("opencbm_plugin_s2_read_n");
+    opencbm_plugin_s2_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s2_read_n");
 
-    opencbm_plugin_s2_write_n = cbm_get_plugin_function_address("opencbm_plugin_s2_write_n");
+    opencbm_plugin_s2_write_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s2_write_n");
 
     dt = (drive_type == cbm_dt_cbm1581);
     p = &drive_progs[dt * 2 + (write != 0)];
@@ -85,10 +85,22 @@ LIB32=link.exe -lib
 # PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
 # Begin Source File
 
+SOURCE=..\checksum.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\compare.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\d64copy.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\fanout.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\fs.c
 # End Source File
 # Begin Source File
@@ -257,6 +269,10 @@ InputName=s2
 # End Source File
 # Begin Source File
 
+SOURCE=..\tracklist.i65
+# End Source File
+# Begin Source File
+
 SOURCE=..\turboread1541.a65
 
 !IF  "$(CFG)" == "libd64copy - Win32 Release"
@@ -0,0 +1,293 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version
+ *  2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Destination of a copy which keeps the image in memory and computes
+ * CRC32, MD5 and SHA-1 of every block and, when closed, of the image.
+ */
+
+#include "d64copy_int.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* the state of one transfer */
+typedef struct
+{
+    d64copy_checksums *sums;
+    int two_sided;
+    int block_count;
+    unsigned char *image;
+} transfer_state;
+
+#define ROL32(x,n) ((((x) << (n)) | (((x) & 0xffffffffUL) >> (32 - (n)))) & 0xffffffffUL)
+
+static unsigned long get_le32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static unsigned long get_be32(const unsigned char *p)
+{
+    return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static unsigned long crc32(const unsigned char *data, size_t len)
+{
+    unsigned long crc = 0xffffffffUL;
+    int i;
+
+    while(len--)
+    {
+        crc ^= *data++;
+        for(i = 0; i < 8; i++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320UL : 0);
+        }
+    }
+    return crc ^ 0xffffffffUL;
+}
+
+static void md5_block(unsigned long *h, const unsigned char *block)
+{
+    static const unsigned long k[64] =
+    {
+        0xd76aa478UL, 0xe8c7b756UL, 0x242070dbUL, 0xc1bdceeeUL,
+        0xf57c0fafUL, 0x4787c62aUL, 0xa8304613UL, 0xfd469501UL,
+        0x698098d8UL, 0x8b44f7afUL, 0xffff5bb1UL, 0x895cd7beUL,
+        0x6b901122UL, 0xfd987193UL, 0xa679438eUL, 0x49b40821UL,
+        0xf61e2562UL, 0xc040b340UL, 0x265e5a51UL, 0xe9b6c7aaUL,
+        0xd62f105dUL, 0x02441453UL, 0xd8a1e681UL, 0xe7d3fbc8UL,
+        0x21e1cde6UL, 0xc33707d6UL, 0xf4d50d87UL, 0x455a14edUL,
+        0xa9e3e905UL, 0xfcefa3f8UL, 0x676f02d9UL, 0x8d2a4c8aUL,
+        0xfffa3942UL, 0x8771f681UL, 0x6d9d6122UL, 0xfde5380cUL,
+        0xa4beea44UL, 0x4bdecfa9UL, 0xf6bb4b60UL, 0xbebfbc70UL,
+        0x289b7ec6UL, 0xeaa127faUL, 0xd4ef3085UL, 0x04881d05UL,
+        0xd9d4d039UL, 0xe6db99e5UL, 0x1fa27cf8UL, 0xc4ac5665UL,
+        0xf4292244UL, 0x432aff97UL, 0xab9423a7UL, 0xfc93a039UL,
+        0x655b59c3UL, 0x8f0ccc92UL, 0xffeff47dUL, 0x85845dd1UL,
+        0x6fa87e4fUL, 0xfe2ce6e0UL, 0xa3014314UL, 0x4e0811a1UL,
+        0xf7537e82UL, 0xbd3af235UL, 0x2ad7d2bbUL, 0xeb86d391UL
+    };
+    static const unsigned char r[16] =
+    {
+        7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21
+    };
+    unsigned long w[16], a, b, c, d, f, t;
+    int i, g;
+
+    for(i = 0; i < 16; i++)
+    {
+        w[i] = get_le32(block + 4 * i);
+    }
+
+    a = h[0]; b = h[1]; c = h[2]; d = h[3];
+    for(i = 0; i < 64; i++)
+    {
+        switch(i / 16)
+        {
+            case 0:  f = (b & c) | (~b & d); g = i;              break;
+            case 1:  f = (d & b) | (~d & c); g = (5 * i + 1) % 16; break;
+            case 2:  f = b ^ c ^ d;          g = (3 * i + 5) % 16; break;
+            default: f = c ^ (b | ~d);       g = (7 * i) % 16;     break;
+        }
+        t = d;
+        d = c;
+        c = b;
+        b = (b + ROL32((a + f + k[i] + w[g]) & 0xffffffffUL,
+                       r[(i / 16) * 4 + i % 4])) & 0xffffffffUL;
+        a = t;
+    }
+    h[0] = (h[0] + a) & 0xffffffffUL;
+    h[1] = (h[1] + b) & 0xffffffffUL;
+    h[2] = (h[2] + c) & 0xffffffffUL;
+    h[3] = (h[3] + d) & 0xffffffffUL;
+}
+
+static void sha1_block(unsigned long *h, const unsigned char *block)
+{
+    unsigned long w[80], a, b, c, d, e, f, k, t;
+    int i;
+
+    for(i = 0; i < 16; i++)
+    {
+        w[i] = get_be32(block + 4 * i);
+    }
+    for(; i < 80; i++)
+    {
+        w[i] = ROL32(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+    }
+
+    a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+    for(i = 0; i < 80; i++)
+    {
+        switch(i / 20)
+        {
+            case 0:  f = (b & c) | (~b & d);          k = 0x5a827999UL; break;
+            case 1:  f = b ^ c ^ d;                   k = 0x6ed9eba1UL; break;
+            case 2:  f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdcUL; break;
+            default: f = b ^ c ^ d;                   k = 0xca62c1d6UL; break;
+        }
+        t = (ROL32(a, 5) + (f & 0xffffffffUL) + e + k + w[i]) & 0xffffffffUL;
+        e = d;
+        d = c;
+        c = ROL32(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] = (h[0] + a) & 0xffffffffUL;
+    h[1] = (h[1] + b) & 0xffffffffUL;
+    h[2] = (h[2] + c) & 0xffffffffUL;
+    h[3] = (h[3] + d) & 0xffffffffUL;
+    h[4] = (h[4] + e) & 0xffffffffUL;
+}
+
+/*
+ * run the 64 byte blocks of data through MD5 or SHA-1, with the padding
+ * and the bit count at the end; the two only differ in the byte order
+ */
+static void digest(void (*block_func)(unsigned long*,const unsigned char*),
+                   unsigned long *h, int words, int big_endian,
+                   const unsigned char *data, size_t len, unsigned char *out)
+{
+    unsigned char tail[128];
+    size_t rest = len % 64;
+    size_t tail_len = rest < 56 ? 64 : 128;
+    unsigned long bits[2];
+    size_t i;
+    int j;
+
+    for(i = 0; i + 64 <= len; i += 64)
+    {
+        block_func(h, data + i);
+    }
+
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, data + i, rest);
+    tail[rest] = 0x80;
+    bits[0] = ((unsigned long)len << 3) & 0xffffffffUL;
+    bits[1] = (unsigned long)len >> 29;
+    for(j = 0; j < 8; j++)
+    {
+        tail[big_endian ? tail_len - 1 - j : tail_len - 8 + j] =
+            (unsigned char)(bits[j / 4] >> (8 * (j % 4)));
+    }
+    block_func(h, tail);
+    if(tail_len > 64)
+    {
+        block_func(h, tail + 64);
+    }
+
+    for(j = 0; j < 4 * words; j++)
+    {
+        out[j] = (unsigned char)(h[j / 4] >> (big_endian ? 24 - 8 * (j % 4) : 8 * (j % 4)));
+    }
+}
+
+static void checksum(d64copy_checksum *sum, const unsigned char *data, size_t len)
+{
+    unsigned long md5[4] = { 0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL };
+    unsigned long sha1[5] = { 0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL,
+                              0xc3d2e1f0UL };
+
+    sum->crc32 = crc32(data, len);
+    digest(md5_block, md5, 4, 0, data, len, sum->md5);
+    digest(sha1_block, sha1, 5, 1, data, len, sum->sha1);
+}
+
+static int block_offset(transfer_state *st, int tr, int se)
+{
+    int sectors = 0, i;
+    for(i = 1; i < tr; i++)
+    {
+        sectors += d64copy_sector_count(st->two_sided, i);
+    }
+    return (sectors + se) * BLOCKSIZE;
+}
+
+static int read_block(void *state, unsigned char tr, unsigned char se, unsigned char *block)
+{
+    return 1;
+}
+
+static int write_block(void *state, unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
+{
+    transfer_state *st = state;
+    int ofs;
+
+    ofs = block_offset(st, tr, se);
+    if(st->image == NULL || size != BLOCKSIZE || se >= MAX_SECTORS ||
+       ofs + BLOCKSIZE > st->block_count * BLOCKSIZE)
+    {
+        return 1;
+    }
+
+    memcpy(st->image + ofs, blk, BLOCKSIZE);
+    checksum(&st->sums->block[tr-1][se], blk, BLOCKSIZE);
+    st->sums->status[tr-1][se] = (char) ((read_status == 0) ? 1 : read_status);
+    return 0;
+}
+
+static int open_disk(void *state, CBM_FILE fd, d64copy_settings *settings,
+                     const void *arg, int for_writing,
+                     turbo_start start, d64copy_message_cb message_cb)
+{
+    transfer_state *st = state;
+    int tr;
+
+    if(!for_writing)
+    {
+        message_cb(0, "checksums can only be a destination");
+        return 1;
+    }
+
+    /* the same size as the image file written by the fs transfer */
+    if(settings->two_sided)
+    {
+        tr = D71_TRACKS;
+    }
+    else if(settings->end_track <= STD_TRACKS)
+    {
+        tr = STD_TRACKS;
+    }
+    else if(settings->end_track <= EXT_TRACKS)
+    {
+        tr = EXT_TRACKS;
+    }
+    else
+    {
+        tr = TOT_TRACKS;
+    }
+
+    st->sums = (d64copy_checksums *) arg;
+    st->two_sided = settings->two_sided;
+    st->block_count = block_offset(st, tr + 1, 0) / BLOCKSIZE;
+    st->image = calloc(st->block_count, BLOCKSIZE);
+    if(st->image == NULL)
+    {
+        message_cb(0, "no memory for checksums");
+        return 1;
+    }
+
+    memset(st->sums, 0, sizeof(*st->sums));
+    st->sums->tracks = tr;
+    return 0;
+}
+
+static void close_disk(void *state)
+{
+    transfer_state *st = state;
+
+    if(st->image)
+    {
+        checksum(&st->sums->image, st->image, st->block_count * BLOCKSIZE);
+        free(st->image);
+        st->image = NULL;
+    }
+}
+
+DECLARE_TRANSFER_FUNCS(checksum_transfer, 0, 0);
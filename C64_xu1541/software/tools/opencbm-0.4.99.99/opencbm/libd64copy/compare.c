@@ -0,0 +1,110 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version
+ *  2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Destination of a copy which compares the blocks with a reference
+ * image instead of writing them. The reference is read with the fs
+ * transfer.
+ */
+
+#include "d64copy_int.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+extern transfer_funcs d64copy_fs_transfer;
+
+/* the state of one transfer */
+typedef struct
+{
+    /* a copy, opening the reference must not change the end track */
+    d64copy_settings settings;
+    void *ref_state;
+    const char *name;
+    d64copy_message_cb message_cb;
+} transfer_state;
+
+static int read_block(void *state, unsigned char tr, unsigned char se, unsigned char *block)
+{
+    transfer_state *st = state;
+
+    return d64copy_fs_transfer.read_block(st->ref_state, tr, se, block);
+}
+
+/*
+ * returns non-zero if the block could not be compared or differs
+ */
+static int write_block(void *state, unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
+{
+    transfer_state *st = state;
+    unsigned char ref[BLOCKSIZE];
+
+    if(st->ref_state == NULL || size != BLOCKSIZE || read_status)
+    {
+        return 1;
+    }
+
+    if(read_block(st, tr, se, ref))
+    {
+        st->message_cb(1, "%02x/%02x: not in %s", tr, se, st->name);
+        return 1;
+    }
+
+    if(memcmp(ref, blk, BLOCKSIZE) != 0)
+    {
+        st->message_cb(1, "%02x/%02x differs from %s", tr, se, st->name);
+        return 1;
+    }
+    return 0;
+}
+
+static int open_disk(void *state, CBM_FILE fd, d64copy_settings *settings,
+                     const void *arg, int for_writing,
+                     turbo_start start, d64copy_message_cb message_cb)
+{
+    transfer_state *st = state;
+
+    if(!for_writing)
+    {
+        message_cb(0, "a compare can only be a destination");
+        return 1;
+    }
+
+    st->settings = *settings;
+    st->settings.end_track = -1;
+    st->name = (const char *) arg;
+    st->message_cb = message_cb;
+    st->ref_state = calloc(1, d64copy_fs_transfer.state_size);
+    if(st->ref_state == NULL)
+    {
+        message_cb(0, "no memory for transfer");
+        return 1;
+    }
+
+    if(d64copy_fs_transfer.open_disk(st->ref_state, fd, &st->settings, arg, 0,
+                                     start, message_cb) != 0)
+    {
+        free(st->ref_state);
+        st->ref_state = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+static void close_disk(void *state)
+{
+    transfer_state *st = state;
+
+    if(st->ref_state)
+    {
+        d64copy_fs_transfer.close_disk(st->ref_state);
+        free(st->ref_state);
+        st->ref_state = NULL;
+    }
+}
+
+DECLARE_TRANSFER_FUNCS(compare_transfer, 0, 0);
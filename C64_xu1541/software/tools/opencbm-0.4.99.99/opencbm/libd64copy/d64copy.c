@@ -99,10 +99,63 @@ static const int warp_write_interleave[] = { -1, 0, 6, 12, 4, -1 };
 
 
 /*
- * Variables to make sure writing a block is an atomary process
+ * State of the adaptive interleave, see tuner_begin_track()
  */
-static int atom_mustcleanup = 0;
-static const transfer_funcs *atom_dst;
+typedef struct
+{
+    int active;
+    int interleave;         /* of the current track, also if not tuning */
+    double rotation;        /* time of one revolution, in ms */
+    double rotation_sum;    /* sum and number of the measured revolutions */
+    int rotation_count;
+    double good;            /* shortest time per sector without misses */
+    double bad;             /* longest time per sector with misses */
+    double ready;           /* time from the end of a track until the next
+                               one can be read, < 0: unknown */
+    double offset;          /* angle between neighbouring tracks, < 0: unknown */
+
+    /* the current track */
+    int sectors;
+    int start;              /* the sector to start with */
+    unsigned long begin;    /* when the last track was done */
+    unsigned long ticks;    /* when the last sector was done */
+    int last;               /* last sector done in this pass, -1: none */
+    int first;              /* the next sector is the first on the track */
+    int count;              /* sectors done */
+    int missed;             /* revolutions missed */
+
+    /* the last track, for the skew */
+    int prev_sectors;
+    int prev_last;
+
+    int tracks;
+    double revolutions;
+} interleave_tuner;
+
+/*
+ * The state of one copy. Each call of d64copy_read_image() or
+ * d64copy_write_image() has its own, so several copies can run at the
+ * same time in different threads, each one with its own CBM_FILE.
+ */
+typedef struct copy_context_s
+{
+    struct copy_context_s *next;    /* in the list of copies to clean up */
+    d64copy_settings *settings;
+    const transfer_funcs *src;
+    const transfer_funcs *dst;
+    void *src_state;
+    void *dst_state;
+    d64copy_message_cb message_cb;
+    d64copy_status_cb status_cb;
+    interleave_tuner tuner;
+} copy_context;
+
+/*
+ * Copies which write to the file system, to make sure writing a block
+ * is an atomary process even if d64copy_cleanup() is called
+ */
+static copy_context *cleanup_list = NULL;
+static arch_mutex_t *cleanup_mutex = NULL;
 
 
 #ifdef LIBD64COPY_DEBUG
@@ -121,92 +174,1222 @@ static const transfer_funcs *atom_dst;
     }
 #endif
 
-static int send_turbo(CBM_FILE fd, unsigned char drv, int write, int warp, int drv_type)
-{
-    const struct drive_prog *prog;
+static int send_turbo(CBM_FILE fd, unsigned char drv, int write, int warp, int drv_type)
+{
+    const struct drive_prog *prog;
+
+    prog = &drive_progs[drv_type * 4 + warp * 2 + write];
+
+    SETSTATEDEBUG((void)0);
+    return cbm_upload(fd, drv, 0x500, prog->prog, prog->size);
+}
+
+extern transfer_funcs d64copy_fs_transfer,
+                      d64copy_fanout_transfer,
+                      d64copy_std_transfer,
+                      d64copy_pp_transfer,
+                      d64copy_s1_transfer,
+                      d64copy_s2_transfer;
+
+int d64copy_sector_count(int two_sided, int track)
+{
+    if(two_sided)
+    {
+        if(track >= 1 && track <= D71_TRACKS)
+        {
+            return d71_sector_map[track];
+        }
+    }
+    else
+    {
+        if(track >= 1 && track <= TOT_TRACKS)
+        {
+            return d64_sector_map[track];
+        }
+    }
+    return -1;
+}
+
+d64copy_settings *d64copy_get_default_settings(void)
+{
+    d64copy_settings *settings;
+
+    settings = malloc(sizeof(d64copy_settings));
+
+    if(NULL != settings)
+    {
+        settings->warp        = -1;
+        settings->retries     = 0;
+        settings->bam_mode    = bm_ignore;
+        settings->interleave  = -1; /* set later on */
+        settings->start_track = 1;
+        settings->end_track   = -1; /* set later on */
+        settings->drive_type  = cbm_dt_unknown; /* auto detect later on */
+        settings->two_sided   = 0;
+        settings->error_mode  = em_on_error;
+        settings->pipeline    = 0;
+        settings->auto_interleave = 0;
+    }
+    return settings;
+}
+
+
+static int start_turbo(CBM_FILE fd, unsigned char drive)
+{
+    SETSTATEDEBUG((void)0);
+    return cbm_exec_command(fd, drive, "U4:", 3);
+}
+
+
+/*
+ * build a track request for the turbo routines: the track with bit 7 set,
+ * the number of sectors and the sectors themselves, padded to an even
+ * length as the drive receives them in pairs. returns its length.
+ */
+int d64copy_track_request(unsigned char *request, unsigned char tr,
+                          const unsigned char *sectors, int count)
+{
+    int size;
+
+    request[0] = tr | 0x80;
+    request[1] = (unsigned char) count;
+    memcpy(request + 2, sectors, count);
+    size = 2 + count;
+    if(size % 2)
+    {
+        request[size++] = 0;
+    }
+    return size;
+}
+
+
+/*
+ * put the sectors of a track which still have to be copied into the
+ * order they are visited with the given interleave, beginning at start.
+ * returns their number.
+ */
+static int track_order(const char *trackmap, int sectors, int scnt,
+                       int interleave, int start, unsigned char *order)
+{
+    char taken[MAX_SECTORS];
+    int se, n, needed;
+
+    needed = 0;
+    for(se = 0; se < sectors; se++)
+    {
+        taken[se] = 0;
+        if(NEED_SECTOR(trackmap[se]))
+        {
+            needed++;
+        }
+    }
+    if(scnt > needed)
+    {
+        scnt = needed;
+    }
+
+    se = start;
+    for(n = 0; n < scnt; n++)
+    {
+        while(!NEED_SECTOR(trackmap[se]) || taken[se])
+        {
+            if(++se >= sectors) se = 0;
+        }
+        taken[se] = 1;
+        order[n] = (unsigned char) se;
+        se = (se + interleave) % sectors;
+    }
+    return n;
+}
+
+
+/*
+ * Adaptive interleave (settings->auto_interleave)
+ *
+ * The time between two sectors read from a track is a whole number of
+ * sector slots, the time one sector needs to pass the head: their distance
+ * on the track, and another revolution every time the host was not ready
+ * when the sector came by. Thus, the time a sector is done tells if it was
+ * missed, and how long a revolution takes.
+ *
+ * The interleave gives the host the time of that many slots per sector.
+ * The tuner remembers the longest time per sector which was too short and
+ * the shortest one which was long enough, and bisects between them on the
+ * first tracks. Later tracks get the interleave for that time with their
+ * number of sectors. If a track misses more revolutions than the next
+ * larger interleave would cost, the tuning starts over from there.
+ *
+ * The skew is the sector to start the next track with: the one which comes
+ * by when the drive is ready after stepping. As the tracks are formatted one
+ * after the other, the angle between the sectors of neighbouring tracks is
+ * about the same on all of the disk.
+ */
+
+/* 300 rpm */
+#define ROTATION_MS 200.0
+/* allow for some more time to step to the next track */
+#define STEP_MS 20.0
+
+/* the fraction of a revolution, 0 <= x < 1 */
+static double revolution_fraction(double x)
+{
+    x -= (double)(long)x;
+    return x < 0 ? x + 1 : x;
+}
+
+static void tuner_init(interleave_tuner *tuner, int interleave)
+{
+    memset(tuner, 0, sizeof(*tuner));
+    tuner->active = 1;
+    tuner->interleave = interleave;
+    tuner->rotation = ROTATION_MS;
+    tuner->offset = -1;
+    tuner->ready = -1;
+    tuner->prev_last = -1;
+    tuner->begin = tuner->ticks = arch_ticks_ms();
+}
+
+/*
+ * pick the interleave and the first sector of a track
+ */
+static void tuner_begin_track(copy_context *ctx, int sectors)
+{
+    interleave_tuner *tuner = &ctx->tuner;
+    double slot = tuner->rotation / sectors;
+    double angle;
+    int interleave = tuner->interleave;
+    int lo, hi, max;
+
+    if(!tuner->active)
+    {
+        return;
+    }
+
+    /* the shortest interleave not known to be too short */
+    lo = (int)(tuner->bad / slot + 0.01) + 1;
+    if(tuner->good > 0)
+    {
+        /* the shortest interleave known to be long enough */
+        hi = (int)(tuner->good / slot + 0.99);
+        interleave = hi > lo ? (lo + hi) / 2 : hi;
+    }
+    else if(tuner->bad > 0)
+    {
+        /* nothing long enough so far, grow fast */
+        interleave = 2 * lo - 1;
+    }
+
+    max = sectors - 1 < 17 ? sectors - 1 : 17;
+    if(interleave > max) interleave = max;
+    if(interleave < 1) interleave = 1;
+    tuner->interleave = interleave;
+
+    if(tuner->ready < 0)
+    {
+        tuner->ready = interleave * slot + STEP_MS;
+    }
+
+    /*
+     * start with the sector which comes by when we are ready: the last
+     * one of the previous track was done at the end of its slot
+     */
+    tuner->start = 0;
+    if(tuner->offset >= 0 && tuner->prev_last >= 0)
+    {
+        angle = (double)(tuner->prev_last + 1) / tuner->prev_sectors +
+                tuner->offset + tuner->ready / tuner->rotation;
+        tuner->start = (int)(revolution_fraction(angle) * sectors + 0.999);
+        tuner->start %= sectors;
+    }
+
+    tuner->sectors = sectors;
+    tuner->last = -1;
+    tuner->first = 1;
+    tuner->count = 0;
+    tuner->missed = 0;
+}
+
+/*
+ * start another pass over the current track
+ */
+static void tuner_pass(copy_context *ctx)
+{
+    ctx->tuner.last = -1;
+}
+
+/*
+ * a sector of the current track is done
+ */
+static void tuner_sector(copy_context *ctx, int se)
+{
+    interleave_tuner *tuner = &ctx->tuner;
+    unsigned long now;
+    double dt, slot, rotation, angle;
+    int n, distance, missed;
+
+    if(!tuner->active)
+    {
+        return;
+    }
+
+    now = arch_ticks_ms();
+    dt = (double)(now - tuner->ticks);
+    n = tuner->sectors;
+    slot = tuner->rotation / n;
+
+    if(tuner->first && tuner->prev_last >= 0)
+    {
+        /*
+         * If we started where we should have, but waited for more than
+         * half a revolution, we were not ready yet. If the sector was
+         * there before we thought we were ready, we are faster.
+         */
+        if(tuner->offset >= 0 && dt > tuner->ready + tuner->rotation / 2)
+        {
+            tuner->ready += slot;
+        }
+        else if(dt - slot < tuner->ready)
+        {
+            tuner->ready = dt > slot ? dt - slot : 0;
+        }
+
+        /* the angle between the tracks, from where this sector ended */
+        angle = (double)(se + 1) / n - dt / tuner->rotation -
+                (double)(tuner->prev_last + 1) / tuner->prev_sectors;
+        tuner->offset = revolution_fraction(angle);
+    }
+    else if(tuner->last >= 0)
+    {
+        distance = (se - tuner->last + n) % n;
+        if(distance == 0)
+        {
+            distance = n;
+        }
+        missed = (int)((dt / slot - distance) / n + 0.5);
+        if(missed < 0)
+        {
+            missed = 0;
+        }
+        tuner->missed += missed;
+
+        /* each pair of sectors also gives the time of a revolution */
+        rotation = dt * n / (distance + missed * n);
+        if(rotation > ROTATION_MS * 0.85 && rotation < ROTATION_MS * 1.15)
+        {
+            tuner->rotation_sum += rotation;
+            tuner->rotation_count++;
+            if(tuner->rotation_count >= 4)
+            {
+                tuner->rotation = tuner->rotation_sum / tuner->rotation_count;
+            }
+        }
+    }
+
+    tuner->first = 0;
+    tuner->last = se;
+    tuner->ticks = now;
+    tuner->count++;
+}
+
+/*
+ * the sectors of the current track were transferred in one go, in the
+ * given order, beginning at the given time
+ */
+static void tuner_whole_track(copy_context *ctx, const unsigned char *order,
+                              int count, unsigned long begin)
+{
+    interleave_tuner *tuner = &ctx->tuner;
+    double slots;
+    int i, n, distance, missed;
+
+    if(!tuner->active || count == 0)
+    {
+        return;
+    }
+
+    /*
+     * The drive waits for the first sector for half a revolution on
+     * average, and then goes the distance to each further sector.
+     */
+    n = tuner->sectors;
+    tuner->ticks = arch_ticks_ms();
+    slots = (tuner->ticks - begin) * n / tuner->rotation - n / 2.0;
+    for(i = 1; i < count; i++)
+    {
+        distance = (order[i] - order[i-1] + n) % n;
+        slots -= distance ? distance : n;
+    }
+    missed = (int)(slots / n + 0.5);
+    if(missed > 0)
+    {
+        tuner->missed += missed;
+    }
+    tuner->first = 0;
+    tuner->last = order[count - 1];
+    tuner->count += count;
+}
+
+/*
+ * the current track is done, learn from it and report
+ */
+static void tuner_end_track(copy_context *ctx, int tr)
+{
+    interleave_tuner *tuner = &ctx->tuner;
+    int interleave = tuner->interleave;
+    double per_sector, revolutions;
+    int skew;
+
+    if(!tuner->active || tuner->count == 0)
+    {
+        return;
+    }
+
+    /*
+     * A missed revolution costs as much as one more interleave does, so
+     * the interleave was too short if this track missed more than one.
+     */
+    per_sector = interleave * tuner->rotation / tuner->sectors;
+    if(tuner->count > 1)
+    {
+        if(tuner->missed > 1)
+        {
+            if(per_sector > tuner->bad)
+            {
+                tuner->bad = per_sector;
+            }
+            if(tuner->good <= tuner->bad)
+            {
+                tuner->good = 0;
+            }
+        }
+        else
+        {
+            if(tuner->good == 0 || per_sector < tuner->good)
+            {
+                tuner->good = per_sector;
+            }
+            if(tuner->bad >= tuner->good)
+            {
+                tuner->bad = 0;
+            }
+        }
+    }
+
+    revolutions = (tuner->ticks - tuner->begin) / tuner->rotation;
+    tuner->tracks++;
+    tuner->revolutions += revolutions;
+
+    skew = tuner->prev_last >= 0 ?
+        (tuner->start - tuner->prev_last + tuner->sectors) % tuner->sectors : 0;
+    ctx->message_cb(2, "track %d: interleave %d, skew %d, "
+                       "%.1f revolutions, %d missed",
+                    tr, interleave, skew, revolutions, tuner->missed);
+
+    tuner->prev_sectors = tuner->sectors;
+    tuner->prev_last = tuner->last;
+    tuner->begin = tuner->ticks;
+}
+
+/*
+ * report the result of the tuning after the copy
+ */
+static void tuner_done(copy_context *ctx)
+{
+    interleave_tuner *tuner = &ctx->tuner;
+
+    if(tuner->active && tuner->tracks > 0)
+    {
+        ctx->message_cb(2, "auto interleave: %.0f rpm, "
+                           "%.2f revolutions per track",
+                        60000.0 / tuner->rotation,
+                        tuner->revolutions / tuner->tracks);
+    }
+}
+
+
+/*
+ * report the progress, with that of each sink when copying to several
+ */
+static void report_status(copy_context *ctx, d64copy_status *status)
+{
+    if(ctx->dst == &d64copy_fanout_transfer)
+    {
+        d64copy_fanout_status(ctx->dst_state, status);
+    }
+    ctx->status_cb(*status);
+}
+
+
+/*
+ * book a copied sector: mark it in the trackmap and report it. returns
+ * 1 if the sector has to be retried.
+ */
+static int sector_done(copy_context *ctx,
+                       d64copy_status *status, char *trackmap,
+                       unsigned char tr, unsigned char se,
+                       int retry_count, int *cnt)
+{
+    int error = 1;
+
+    if(status->read_result)
+    {
+        /* read error */
+        trackmap[se] = bs_error;
+        if(retry_count == 0)
+        {
+            status->sectors_processed++;
+            /* FIXME: shall we get rid of this? */
+            ctx->message_cb( 1, "read error: %02x/%02x: %d",
+                             tr, se, status->read_result );
+        }
+    }
+    else
+    {
+        /* successfull read */
+        if(status->write_result)
+        {
+            /* write error */
+            trackmap[se] = bs_error;
+            if(retry_count == 0)
+            {
+                status->sectors_processed++;
+                /* FIXME: shall we get rid of this? */
+                ctx->message_cb(1, "write error: %02x/%02x: %d",
+                                tr, se, status->write_result);
+            }
+        }
+        else
+        {
+            /* successfull read and write, mark sector */
+            trackmap[se] = bs_copied;
+            (*cnt)++;
+            status->sectors_processed++;
+            error = 0;
+        }
+    }
+
+    status->track = tr;
+    status->sector= se;
+
+    report_status(ctx, status);
+
+    return error;
+}
+
+
+/*
+ * copy the sectors of a track still to be copied in one go, with a
+ * track transfer on the drive side. returns the number of errors.
+ */
+static int copy_whole_track(copy_context *ctx,
+                            d64copy_status *status, unsigned char tr,
+                            char *trackmap, int sectors, int scnt,
+                            int retry_count, int *cnt)
+{
+    const transfer_funcs *src = ctx->src;
+    const transfer_funcs *dst = ctx->dst;
+    unsigned char order[MAX_SECTORS];
+    unsigned char blocks[MAX_SECTORS * BLOCKSIZE];
+    int read_results[MAX_SECTORS];
+    int write_results[MAX_SECTORS];
+    int i, n, errors;
+    unsigned long begin;
+
+    n = track_order(trackmap, sectors, scnt, ctx->tuner.interleave,
+                    ctx->tuner.start, order);
+    begin = arch_ticks_ms();
+
+    SETSTATEDEBUG(DebugBlockCount+=n);
+    if(src->read_track)
+    {
+        if(src->read_track(ctx->src_state, tr, order, n, blocks, read_results))
+        {
+            for(i = 0; i < n; i++)
+            {
+                read_results[i] = -1;
+            }
+        }
+    }
+    else
+    {
+        for(i = 0; i < n; i++)
+        {
+            read_results[i] = src->read_block(ctx->src_state, tr, order[i],
+                                              blocks + i * BLOCKSIZE);
+        }
+    }
+
+    SETSTATEDEBUG(DebugBlockCount+=n);
+    if(dst->write_track)
+    {
+        if(dst->write_track(ctx->dst_state, tr, order, n, blocks, write_results))
+        {
+            for(i = 0; i < n; i++)
+            {
+                write_results[i] = -1;
+            }
+        }
+    }
+    else
+    {
+        for(i = 0; i < n; i++)
+        {
+            write_results[i] = dst->write_block(ctx->dst_state, tr, order[i],
+                                                blocks + i * BLOCKSIZE,
+                                                BLOCKSIZE, read_results[i]);
+        }
+    }
+    SETSTATEDEBUG((void)0);
+    tuner_whole_track(ctx, order, n, begin);
+
+    errors = 0;
+    for(i = 0; i < n; i++)
+    {
+        status->read_result = read_results[i];
+        status->write_result = write_results[i];
+        errors += sector_done(ctx, status, trackmap, tr, order[i],
+                              retry_count, cnt);
+    }
+    return errors;
+}
+
+
+/*
+ * copy all tracks, one block after the other
+ */
+static int copy_tracks(copy_context *ctx,
+                       d64copy_status status, const char *sector_map,
+                       int max_tracks)
+{
+    d64copy_settings *settings = ctx->settings;
+    const transfer_funcs *src = ctx->src;
+    const transfer_funcs *dst = ctx->dst;
+    unsigned char tr;
+    unsigned char se = 0;
+    int cnt = 0;
+    unsigned char scnt;
+    unsigned char errors;
+    int retry_count;
+    int resend_trackmap;
+    char trackmap[MAX_SECTORS+1];
+    unsigned char block[BLOCKSIZE];
+    unsigned char gcr[GCRBUFSIZE];
+
+    SETSTATEDEBUG(DebugBlockCount=0);
+    for(tr = 1; tr <= max_tracks; tr++)
+    {
+        if(tr >= settings->start_track && tr <= settings->end_track)
+        {
+            scnt = sector_map[tr];
+            memcpy(trackmap, status.bam[tr-1], scnt);
+            if(settings->bam_mode != bm_ignore)
+            {
+                for(se = 0; se < sector_map[tr]; se++)
+                {
+                    if(trackmap[se] != bs_must_copy)
+                    {
+                        scnt--;
+                    }
+                }
+            }
+
+            tuner_begin_track(ctx, sector_map[tr]);
+            retry_count = settings->retries;
+            do
+            {
+                errors = resend_trackmap = 0;
+                tuner_pass(ctx);
+                if(scnt && settings->warp && src->is_cbm_drive)
+                {
+                    SETSTATEDEBUG((void)0);
+                    src->send_track_map(ctx->src_state, tr, trackmap, scnt);
+                }
+                else if(scnt && !settings->warp &&
+                        (src->read_track || dst->write_track))
+                {
+                    errors = copy_whole_track(ctx, &status,
+                                              tr, trackmap, sector_map[tr],
+                                              scnt, retry_count, &cnt);
+                    scnt = 0;
+                }
+                else
+                {
+                    se = (unsigned char) ctx->tuner.start;
+                }
+                while(scnt && !resend_trackmap)
+                {
+                    if(settings->warp && src->is_cbm_drive)
+                    {
+                        SETSTATEDEBUG((void)0);
+                        status.read_result = src->read_gcr_block(ctx->src_state, &se, gcr);
+                        if(status.read_result == 0)
+                        {
+                            SETSTATEDEBUG((void)0);
+                            status.read_result = gcr_decode(gcr, block);
+                        }
+                        else
+                        {
+                            /* mark all sectors not received so far */
+                            /* ugly */
+                            errors = 0;
+                            for(scnt = 0; scnt < sector_map[tr]; scnt++)
+                            {
+                                if(NEED_SECTOR(trackmap[scnt]) && scnt != se)
+                                {
+                                    trackmap[scnt] = bs_error;
+                                    errors++;
+                                }
+                            }
+                            resend_trackmap = 1;
+                        }
+                    }
+                    else
+                    {
+                        while(!NEED_SECTOR(trackmap[se]))
+                        {
+                            if(++se >= sector_map[tr]) se = 0;
+                        }
+                        SETSTATEDEBUG(DebugBlockCount++);
+                        status.read_result = src->read_block(ctx->src_state, tr, se, block);
+                    }
+
+                    if(settings->warp && dst->is_cbm_drive)
+                    {
+                        SETSTATEDEBUG((void)0);
+                        gcr_encode(block, gcr);
+                        SETSTATEDEBUG(DebugBlockCount++);
+                        status.write_result = 
+                            dst->write_block(ctx->dst_state, tr, se, gcr, GCRBUFSIZE-1,
+                                             status.read_result);
+                    }
+                    else
+                    {
+                        SETSTATEDEBUG(DebugBlockCount++);
+                        status.write_result = 
+                            dst->write_block(ctx->dst_state, tr, se, block, BLOCKSIZE,
+                                             status.read_result);
+                    }
+                    SETSTATEDEBUG((void)0);
+
+                    /* remaining sectors on this track */
+                    if(!resend_trackmap)
+                    {
+                        scnt--;
+                    }
+
+                    errors += sector_done(ctx, &status, trackmap, tr, se,
+                                          retry_count, &cnt);
+                    tuner_sector(ctx, se);
+
+                    if(dst->is_cbm_drive || !settings->warp)
+                    {
+                        se += (unsigned char) ctx->tuner.interleave;
+                        if(se >= sector_map[tr]) se -= sector_map[tr];
+                    }
+                }
+                if(errors > 0 && settings->retries >= 0)
+                {
+                    retry_count--;
+                    scnt = errors;
+                }
+            }
+            while(retry_count >= 0 && errors > 0);
+            tuner_end_track(ctx, tr);
+            if(errors)
+            {
+                ctx->message_cb(1, "giving up...");
+            }
+        }
+        if(settings->two_sided)
+        {
+            if(tr <= STD_TRACKS)
+            {
+                if(tr + STD_TRACKS <= D71_TRACKS)
+                {
+                    tr += (STD_TRACKS - 1);
+                }
+            }
+            else if(tr != D71_TRACKS)
+            {
+                tr -= STD_TRACKS;
+            }
+        }
+    }
+    SETSTATEDEBUG(DebugBlockCount=-1);
+
+    return cnt;
+}
+
+
+/*
+ * Pipelined copy from a drive into an image.
+ *
+ * The reader thread talks to the drive and puts the raw (GCR or decoded)
+ * sectors into a bounded queue. The calling thread takes them out of the
+ * queue, decodes GCR data, writes the image and reports the status. Thus,
+ * the drive keeps streaming while the host decodes and writes.
+ *
+ * The reader owns the trackmap of the current track and does the retries.
+ * Decode and write errors are only known to the writer, so at the end of
+ * every pass over a track, the reader waits until the writer has processed
+ * all queued sectors and reported the sectors that failed.
+ */
+
+/* number of sectors buffered between the reader and the writer */
+#define PIPELINE_DEPTH (2 * MAX_SECTORS)
+
+typedef enum
+{
+    pi_sector,          /* a sector read from the drive */
+    pi_end_of_pass,     /* all sectors of this pass have been queued */
+    pi_done             /* all tracks have been read */
+} pipeline_item_type;
+
+typedef struct
+{
+    pipeline_item_type type;
+    unsigned char tr;
+    unsigned char se;
+    int read_result;
+    int is_gcr;         /* data must be decoded */
+    int last_try;       /* no retries left for this sector */
+    unsigned char data[GCRBUFSIZE];
+} pipeline_item;
+
+typedef struct
+{
+    copy_context *ctx;
+    const char *sector_map;
+    int max_tracks;
+    char (*bam)[MAX_SECTORS+1];
+
+    pipeline_item items[PIPELINE_DEPTH];
+    unsigned int head;  /* next item to be filled by the reader */
+    unsigned int tail;  /* next item to be processed by the writer */
+    arch_sem_t *free_items;
+    arch_sem_t *used_items;
+    arch_sem_t *pass_done;
+
+    /* sectors that failed in the writer in the current pass */
+    char failed[MAX_SECTORS];
+} pipeline;
+
+static pipeline_item *pipeline_get_free(pipeline *pl)
+{
+    arch_sem_wait(pl->free_items);
+    return &pl->items[pl->head];
+}
+
+static void pipeline_put(pipeline *pl)
+{
+    pl->head = (pl->head + 1) % PIPELINE_DEPTH;
+    arch_sem_post(pl->used_items);
+}
+
+static void pipeline_put_marker(pipeline *pl, pipeline_item_type type)
+{
+    pipeline_item *item = pipeline_get_free(pl);
+
+    item->type = type;
+    pipeline_put(pl);
+}
+
+static void pipeline_reader(void *context)
+{
+    pipeline *pl = context;
+    copy_context *ctx = pl->ctx;
+    d64copy_settings *settings = ctx->settings;
+    const transfer_funcs *src = ctx->src;
+    const char *sector_map = pl->sector_map;
+    pipeline_item *item;
+    unsigned char tr;
+    unsigned char se = 0;
+    unsigned char scnt;
+    unsigned char errors;
+    int retry_count;
+    int resend_trackmap;
+    char trackmap[MAX_SECTORS+1];
+    unsigned char order[MAX_SECTORS];
+    unsigned char blocks[MAX_SECTORS * BLOCKSIZE];
+    int results[MAX_SECTORS];
+    int i, n;
+    unsigned long begin;
+
+    SETSTATEDEBUG(DebugBlockCount=0);
+    for(tr = 1; tr <= pl->max_tracks; tr++)
+    {
+        if(tr >= settings->start_track && tr <= settings->end_track)
+        {
+            scnt = sector_map[tr];
+            memcpy(trackmap, pl->bam[tr-1], scnt);
+            if(settings->bam_mode != bm_ignore)
+            {
+                for(se = 0; se < sector_map[tr]; se++)
+                {
+                    if(trackmap[se] != bs_must_copy)
+                    {
+                        scnt--;
+                    }
+                }
+            }
+
+            tuner_begin_track(ctx, sector_map[tr]);
+            retry_count = settings->retries;
+            do
+            {
+                errors = resend_trackmap = 0;
+                tuner_pass(ctx);
+                if(scnt && settings->warp)
+                {
+                    SETSTATEDEBUG((void)0);
+                    src->send_track_map(ctx->src_state, tr, trackmap, scnt);
+                }
+                else if(scnt && src->read_track)
+                {
+                    /* all sectors of the track in one transfer */
+                    n = track_order(trackmap, sector_map[tr], scnt,
+                                    ctx->tuner.interleave, ctx->tuner.start,
+                                    order);
+                    SETSTATEDEBUG(DebugBlockCount+=n);
+                    begin = arch_ticks_ms();
+                    if(src->read_track(ctx->src_state, tr, order, n, blocks, results))
+                    {
+                        for(i = 0; i < n; i++)
+                        {
+                            results[i] = -1;
+                        }
+                    }
+                    SETSTATEDEBUG((void)0);
+                    tuner_whole_track(ctx, order, n, begin);
+
+                    for(i = 0; i < n; i++)
+                    {
+                        item = pipeline_get_free(pl);
+                        item->type = pi_sector;
+                        item->is_gcr = 0;
+                        item->last_try = (retry_count == 0);
+                        item->tr = tr;
+                        item->se = order[i];
+                        item->read_result = results[i];
+                        memcpy(item->data, blocks + i * BLOCKSIZE, BLOCKSIZE);
+
+                        if(item->read_result)
+                        {
+                            trackmap[order[i]] = bs_error;
+                            errors++;
+                        }
+                        else
+                        {
+                            trackmap[order[i]] = bs_copied;
+                        }
+
+                        pipeline_put(pl);
+                    }
+                    scnt = 0;
+                }
+                else
+                {
+                    se = (unsigned char) ctx->tuner.start;
+                }
+                while(scnt && !resend_trackmap)
+                {
+                    item = pipeline_get_free(pl);
+                    item->type = pi_sector;
+                    item->is_gcr = settings->warp;
+                    item->last_try = (retry_count == 0);
+
+                    if(settings->warp)
+                    {
+                        SETSTATEDEBUG((void)0);
+                        item->read_result = src->read_gcr_block(ctx->src_state, &se, item->data);
+                        if(item->read_result)
+                        {
+                            /* mark all sectors not received so far */
+                            errors = 0;
+                            for(scnt = 0; scnt < sector_map[tr]; scnt++)
+                            {
+                                if(NEED_SECTOR(trackmap[scnt]) && scnt != se)
+                                {
+                                    trackmap[scnt] = bs_error;
+                                    errors++;
+                                }
+                            }
+                            resend_trackmap = 1;
+                        }
+                    }
+                    else
+                    {
+                        while(!NEED_SECTOR(trackmap[se]))
+                        {
+                            if(++se >= sector_map[tr]) se = 0;
+                        }
+                        SETSTATEDEBUG(DebugBlockCount++);
+                        item->read_result = src->read_block(ctx->src_state, tr, se, item->data);
+                    }
+                    SETSTATEDEBUG((void)0);
+
+                    item->tr = tr;
+                    item->se = se;
+
+                    /*
+                     * Sectors read successfully are marked as copied for
+                     * now; if decoding or writing fails, the writer reports
+                     * them at the end of the pass.
+                     */
+                    if(item->read_result)
+                    {
+                        trackmap[se] = bs_error;
+                        errors++;
+                    }
+                    else
+                    {
+                        trackmap[se] = bs_copied;
+                    }
+
+                    tuner_sector(ctx, se);
+                    pipeline_put(pl);
+
+                    /* remaining sectors on this track */
+                    if(!resend_trackmap)
+                    {
+                        scnt--;
+                    }
+
+                    if(!settings->warp)
+                    {
+                        se += (unsigned char) ctx->tuner.interleave;
+                        if(se >= sector_map[tr]) se -= sector_map[tr];
+                    }
+                }
+
+                /* wait for the writer, and collect its errors */
+                pipeline_put_marker(pl, pi_end_of_pass);
+                arch_sem_wait(pl->pass_done);
+                for(se = 0; se < sector_map[tr]; se++)
+                {
+                    if(pl->failed[se])
+                    {
+                        pl->failed[se] = 0;
+                        trackmap[se] = bs_error;
+                        errors++;
+                    }
+                }
+
+                if(errors > 0 && settings->retries >= 0)
+                {
+                    retry_count--;
+                    scnt = errors;
+                }
+            }
+            while(retry_count >= 0 && errors > 0);
+            tuner_end_track(ctx, tr);
+            if(errors)
+            {
+                ctx->message_cb(1, "giving up...");
+            }
+        }
+        if(settings->two_sided)
+        {
+            if(tr <= STD_TRACKS)
+            {
+                if(tr + STD_TRACKS <= D71_TRACKS)
+                {
+                    tr += (STD_TRACKS - 1);
+                }
+            }
+            else if(tr != D71_TRACKS)
+            {
+                tr -= STD_TRACKS;
+            }
+        }
+    }
+    SETSTATEDEBUG(DebugBlockCount=-1);
+
+    pipeline_put_marker(pl, pi_done);
+}
+
+static int copy_tracks_pipelined(copy_context *ctx,
+                                 d64copy_status status,
+                                 const char *sector_map, int max_tracks)
+{
+    pipeline *pl;
+    pipeline_item *item;
+    arch_thread_t *reader;
+    unsigned char block[BLOCKSIZE];
+    const unsigned char *data;
+    int cnt = 0;
+    int decode_error;
+
+    pl = calloc(1, sizeof(*pl));
+    if(pl == NULL)
+    {
+        ctx->message_cb(0, "no memory for pipelined transfer");
+        return -1;
+    }
+
+    pl->ctx = ctx;
+    pl->sector_map = sector_map;
+    pl->max_tracks = max_tracks;
+    pl->bam = status.bam;
+    pl->free_items = arch_sem_create(PIPELINE_DEPTH);
+    pl->used_items = arch_sem_create(0);
+    pl->pass_done = arch_sem_create(0);
+
+    reader = NULL;
+    if(pl->free_items && pl->used_items && pl->pass_done)
+    {
+        reader = arch_thread_create(pipeline_reader, pl);
+    }
+
+    if(reader == NULL)
+    {
+        /* no threads available, do it the simple way */
+        ctx->message_cb(1, "could not start reader thread, not pipelining");
+        cnt = copy_tracks(ctx, status, sector_map, max_tracks);
+    }
+    else
+    {
+        for(;;)
+        {
+            arch_sem_wait(pl->used_items);
+            item = &pl->items[pl->tail];
+
+            if(item->type == pi_done)
+            {
+                break;
+            }
+            else if(item->type == pi_end_of_pass)
+            {
+                pl->tail = (pl->tail + 1) % PIPELINE_DEPTH;
+                arch_sem_post(pl->free_items);
+                arch_sem_post(pl->pass_done);
+                continue;
+            }
+
+            status.read_result = item->read_result;
+            decode_error = 0;
+            data = item->data;
+            if(item->is_gcr)
+            {
+                if(status.read_result == 0)
+                {
+                    status.read_result = gcr_decode(item->data, block);
+                    decode_error = (status.read_result != 0);
+                }
+                data = block;
+            }
+
+            status.write_result =
+                ctx->dst->write_block(ctx->dst_state, item->tr, item->se,
+                                      data, BLOCKSIZE, status.read_result);
+
+            if(status.read_result)
+            {
+                /* read error, the reader already knows about it, unless
+                 * it was detected while decoding */
+                if(decode_error)
+                {
+                    pl->failed[item->se] = 1;
+                }
+                if(item->last_try)
+                {
+                    status.sectors_processed++;
+                    ctx->message_cb(1, "read error: %02x/%02x: %d",
+                                    item->tr, item->se, status.read_result);
+                }
+            }
+            else if(status.write_result)
+            {
+                /* write error */
+                pl->failed[item->se] = 1;
+                if(item->last_try)
+                {
+                    status.sectors_processed++;
+                    ctx->message_cb(1, "write error: %02x/%02x: %d",
+                                    item->tr, item->se, status.write_result);
+                }
+            }
+            else
+            {
+                /* successfull read and write */
+                cnt++;
+                status.sectors_processed++;
+            }
+
+            status.track = item->tr;
+            status.sector = item->se;
+
+            pl->tail = (pl->tail + 1) % PIPELINE_DEPTH;
+            arch_sem_post(pl->free_items);
+
+            report_status(ctx, &status);
+        }
+
+        arch_thread_join(reader);
+    }
 
-    prog = &drive_progs[drv_type * 4 + warp * 2 + write];
+    arch_sem_destroy(pl->pass_done);
+    arch_sem_destroy(pl->used_items);
+    arch_sem_destroy(pl->free_items);
+    free(pl);
 
-    SETSTATEDEBUG((void)0);
-    return cbm_upload(fd, drv, 0x500, prog->prog, prog->size);
+    return cnt;
 }
 
-extern transfer_funcs d64copy_fs_transfer,
-                      d64copy_std_transfer,
-                      d64copy_pp_transfer,
-                      d64copy_s1_transfer,
-                      d64copy_s2_transfer;
-
-static d64copy_message_cb message_cb;
-static d64copy_status_cb status_cb;
 
-int d64copy_sector_count(int two_sided, int track)
+/*
+ * register a copy which writes to the file system, so d64copy_cleanup()
+ * can close it
+ */
+static void register_cleanup(copy_context *ctx)
 {
-    if(two_sided)
-    {
-        if(track >= 1 && track <= D71_TRACKS)
-        {
-            return d71_sector_map[track];
-        }
-    }
-    else
-    {
-        if(track >= 1 && track <= TOT_TRACKS)
-        {
-            return d64_sector_map[track];
-        }
-    }
-    return -1;
+    arch_mutex_lock(&cleanup_mutex);
+    ctx->next = cleanup_list;
+    cleanup_list = ctx;
+    arch_mutex_unlock(cleanup_mutex);
 }
 
-d64copy_settings *d64copy_get_default_settings(void)
+/*
+ * remove a copy from the cleanup list. returns 0 if d64copy_cleanup()
+ * has already closed it.
+ */
+static int unregister_cleanup(copy_context *ctx)
 {
-    d64copy_settings *settings;
-
-    settings = malloc(sizeof(d64copy_settings));
+    copy_context **pp;
+    int found = 0;
 
-    if(NULL != settings)
+    arch_mutex_lock(&cleanup_mutex);
+    for(pp = &cleanup_list; *pp; pp = &(*pp)->next)
     {
-        settings->warp        = -1;
-        settings->retries     = 0;
-        settings->bam_mode    = bm_ignore;
-        settings->interleave  = -1; /* set later on */
-        settings->start_track = 1;
-        settings->end_track   = -1; /* set later on */
-        settings->drive_type  = cbm_dt_unknown; /* auto detect later on */
-        settings->two_sided   = 0;
-        settings->error_mode  = em_on_error;
+        if(*pp == ctx)
+        {
+            *pp = ctx->next;
+            found = 1;
+            break;
+        }
     }
-    return settings;
-}
-
-
-static int start_turbo(CBM_FILE fd, unsigned char drive)
-{
-    SETSTATEDEBUG((void)0);
-    return cbm_exec_command(fd, drive, "U4:", 3);
+    arch_mutex_unlock(cleanup_mutex);
+    return found;
 }
 
-
-static int copy_disk(CBM_FILE fd_cbm, d64copy_settings *settings,
-              const transfer_funcs *src, const void *src_arg,
-              const transfer_funcs *dst, const void *dst_arg, unsigned char cbm_drive)
+static int copy_disk(CBM_FILE fd_cbm, copy_context *ctx,
+              const void *src_arg, const void *dst_arg, unsigned char cbm_drive)
 {
+    d64copy_settings *settings = ctx->settings;
+    const transfer_funcs *src = ctx->src;
+    const transfer_funcs *dst = ctx->dst;
+    d64copy_message_cb message_cb = ctx->message_cb;
     unsigned char tr = 0;
     unsigned char se = 0;
     int st;
     int cnt  = 0;
     unsigned char scnt = 0;
-    unsigned char errors;
-    int retry_count;
-    int resend_trackmap;
     int max_tracks;
     char trackmap[MAX_SECTORS+1];
     char buf[40];
     unsigned const char *bam_ptr;
     unsigned char bam[BLOCKSIZE];
     unsigned char bam2[BLOCKSIZE];
-    unsigned char block[BLOCKSIZE];
     unsigned char gcr[GCRBUFSIZE];
     const transfer_funcs *cbm_transf = NULL;
     d64copy_status status;
@@ -334,6 +1517,21 @@ static int copy_disk(CBM_FILE fd_cbm, d64copy_settings *settings,
 
     settings->warp = settings->warp ? 1 : 0;
 
+    /* the copy loops take the interleave from the tuner, which changes it
+     * per track if it is active; the settings stay as they are */
+    ctx->tuner.interleave = settings->interleave;
+    if(settings->auto_interleave)
+    {
+        if(settings->warp && src->is_cbm_drive)
+        {
+            message_cb(1, "automatic interleave ignored when reading in warp mode");
+        }
+        else
+        {
+            tuner_init(&ctx->tuner, settings->interleave);
+        }
+    }
+
     if(cbm_transf->needs_turbo)
     {
         SETSTATEDEBUG((void)0);
@@ -342,7 +1540,7 @@ static int copy_disk(CBM_FILE fd_cbm, d64copy_settings *settings,
     }
 
     SETSTATEDEBUG((void)0);
-    if(src->open_disk(fd_cbm, settings, src_arg, 0,
+    if(src->open_disk(ctx->src_state, fd_cbm, settings, src_arg, 0,
                       start_turbo, message_cb) == 0)
     {
         if(settings->end_track == -1)
@@ -351,12 +1549,16 @@ static int copy_disk(CBM_FILE fd_cbm, d64copy_settings *settings,
                 settings->two_sided ? D71_TRACKS : STD_TRACKS;
         }
         SETSTATEDEBUG((void)0);
-        if(dst->open_disk(fd_cbm, settings, dst_arg, 1,
+        if(dst->open_disk(ctx->dst_state, fd_cbm, settings, dst_arg, 1,
                           start_turbo, message_cb) != 0)
         {
             message_cb(0, "can't open destination");
             return -1;
         }
+        if(!dst->is_cbm_drive)
+        {
+            register_cleanup(ctx);
+        }
     }
     else
     {
@@ -374,20 +1576,20 @@ static int copy_disk(CBM_FILE fd_cbm, d64copy_settings *settings,
             trackmap[0] = bs_must_copy;
             scnt = 1;
             SETSTATEDEBUG((void)0);
-            src->send_track_map(18, trackmap, scnt);
+            src->send_track_map(ctx->src_state, 18, trackmap, scnt);
             SETSTATEDEBUG(DebugBlockCount=0);
-            st = src->read_gcr_block(&se, gcr);
+            st = src->read_gcr_block(ctx->src_state, &se, gcr);
             SETSTATEDEBUG(DebugBlockCount=-1);
             if(st == 0) st = gcr_decode(gcr, bam);
         }
         else
         {
             SETSTATEDEBUG(DebugBlockCount=0);
-            st = src->read_block(18, 0, bam);
+            st = src->read_block(ctx->src_state, 18, 0, bam);
             if(settings->two_sided && (st == 0))
             {
                 SETSTATEDEBUG(DebugBlockCount=1);
-                st = src->read_block(53, 0, bam2);
+                st = src->read_block(ctx->src_state, 53, 0, bam2);
             }
             SETSTATEDEBUG(DebugBlockCount=-1);
         }
@@ -441,183 +1643,31 @@ static int copy_disk(CBM_FILE fd_cbm, d64copy_settings *settings,
 
     status.settings = settings;
 
-    status_cb(status);
+    report_status(ctx, &status);
 
     message_cb(2, "copying tracks %d-%d (%d sectors)",
             settings->start_track, settings->end_track, status.total_sectors);
 
-    SETSTATEDEBUG(DebugBlockCount=0);
-    for(tr = 1; tr <= max_tracks; tr++)
+    if(settings->pipeline && src->is_cbm_drive && !dst->is_cbm_drive)
     {
-        if(tr >= settings->start_track && tr <= settings->end_track)
-        {
-            scnt = sector_map[tr];
-            memcpy(trackmap, status.bam[tr-1], scnt);
-            if(settings->bam_mode != bm_ignore)
-            {
-                for(se = 0; se < sector_map[tr]; se++)
-                {
-                    if(trackmap[se] != bs_must_copy)
-                    {
-                        scnt--;
-                    }
-                }
-            }
-
-            retry_count = settings->retries;
-            do
-            {
-                errors = resend_trackmap = 0;
-                if(scnt && settings->warp && src->is_cbm_drive)
-                {
-                    SETSTATEDEBUG((void)0);
-                    src->send_track_map(tr, trackmap, scnt);
-                }
-                else
-                {
-                    se = 0;
-                }
-                while(scnt && !resend_trackmap)
-                {
-                    if(settings->warp && src->is_cbm_drive)
-                    {
-                        SETSTATEDEBUG((void)0);
-                        status.read_result = src->read_gcr_block(&se, gcr);
-                        if(status.read_result == 0)
-                        {
-                            SETSTATEDEBUG((void)0);
-                            status.read_result = gcr_decode(gcr, block);
-                        }
-                        else
-                        {
-                            /* mark all sectors not received so far */
-                            /* ugly */
-                            errors = 0;
-                            for(scnt = 0; scnt < sector_map[tr]; scnt++)
-                            {
-                                if(NEED_SECTOR(trackmap[scnt]) && scnt != se)
-                                {
-                                    trackmap[scnt] = bs_error;
-                                    errors++;
-                                }
-                            }
-                            resend_trackmap = 1;
-                        }
-                    }
-                    else
-                    {
-                        while(!NEED_SECTOR(trackmap[se]))
-                        {
-                            if(++se >= sector_map[tr]) se = 0;
-                        }
-                        SETSTATEDEBUG(DebugBlockCount++);
-                        status.read_result = src->read_block(tr, se, block);
-                    }
-
-                    if(settings->warp && dst->is_cbm_drive)
-                    {
-                        SETSTATEDEBUG((void)0);
-                        gcr_encode(block, gcr);
-                        SETSTATEDEBUG(DebugBlockCount++);
-                        status.write_result = 
-                            dst->write_block(tr, se, gcr, GCRBUFSIZE-1,
-                                             status.read_result);
-                    }
-                    else
-                    {
-                        SETSTATEDEBUG(DebugBlockCount++);
-                        status.write_result = 
-                            dst->write_block(tr, se, block, BLOCKSIZE,
-                                             status.read_result);
-                    }
-                    SETSTATEDEBUG((void)0);
-
-                    if(status.read_result)
-                    {
-                        /* read error */
-                        trackmap[se] = bs_error;
-                        errors++;
-                        if(retry_count == 0)
-                        {
-                            status.sectors_processed++;
-                            /* FIXME: shall we get rid of this? */
-                            message_cb( 1, "read error: %02x/%02x: %d",
-                                        tr, se, status.read_result );
-                        }
-                    }
-                    else
-                    {
-                        /* successfull read */
-                        if(status.write_result)
-                        {
-                            /* write error */
-                            trackmap[se] = bs_error;
-                            errors++;
-                            if(retry_count == 0)
-                            {
-                                status.sectors_processed++;
-                                /* FIXME: shall we get rid of this? */
-                                message_cb(1, "write error: %02x/%02x: %d",
-                                           tr, se, status.write_result);
-                            }
-                        }
-                        else
-                        {
-                            /* successfull read and write, mark sector */
-                            trackmap[se] = bs_copied;
-                            cnt++;
-                            status.sectors_processed++;
-                        }
-                    }
-                    /* remaining sectors on this track */
-                    if(!resend_trackmap)
-                    {
-                        scnt--;
-                    }
-
-                    status.track = tr;
-                    status.sector= se;
-
-                    status_cb(status);
-
-                    if(dst->is_cbm_drive || !settings->warp)
-                    {
-                        se += (unsigned char) settings->interleave;
-                        if(se >= sector_map[tr]) se -= sector_map[tr];
-                    }
-                }
-                if(errors > 0 && settings->retries >= 0)
-                {
-                    retry_count--;
-                    scnt = errors;
-                }
-            }
-            while(retry_count >= 0 && errors > 0);
-            if(errors)
-            {
-                message_cb(1, "giving up...");
-            }
-        }
-        if(settings->two_sided)
+        cnt = copy_tracks_pipelined(ctx, status, sector_map, max_tracks);
+    }
+    else
+    {
+        if(settings->pipeline)
         {
-            if(tr <= STD_TRACKS)
-            {
-                if(tr + STD_TRACKS <= D71_TRACKS)
-                {
-                    tr += (STD_TRACKS - 1);
-                }
-            }
-            else if(tr != D71_TRACKS)
-            {
-                tr -= STD_TRACKS;
-            }
+            message_cb(2, "pipelined transfer is only used for reading, ignored");
         }
+        cnt = copy_tracks(ctx, status, sector_map, max_tracks);
     }
-    SETSTATEDEBUG(DebugBlockCount=-1);
+    tuner_done(ctx);
 
-    dst->close_disk();
+    if(dst->is_cbm_drive || unregister_cleanup(ctx))
+    {
+        dst->close_disk(ctx->dst_state);
+    }
     SETSTATEDEBUG((void)0);
-    src->close_disk();
+    src->close_disk(ctx->src_state);
 
     SETSTATEDEBUG((void)0);
     return cnt;
@@ -781,6 +1831,38 @@ int d64copy_check_auto_transfer_mode(CBM_FILE cbm_fd, int auto_transfermode, int
     return transfermode;
 }
 
+/*
+ * set up the context of a copy, with the states of both transfers
+ */
+static int init_context(copy_context *ctx, d64copy_settings *settings,
+                        const transfer_funcs *src, const transfer_funcs *dst,
+                        d64copy_message_cb msg_cb, d64copy_status_cb stat_cb)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->settings = settings;
+    ctx->src = src;
+    ctx->dst = dst;
+    ctx->message_cb = msg_cb;
+    ctx->status_cb = stat_cb;
+
+    ctx->src_state = calloc(1, src->state_size);
+    ctx->dst_state = calloc(1, dst->state_size);
+    if(ctx->src_state == NULL || ctx->dst_state == NULL)
+    {
+        free(ctx->src_state);
+        free(ctx->dst_state);
+        msg_cb(0, "no memory for transfer");
+        return -1;
+    }
+    return 0;
+}
+
+static void free_context(copy_context *ctx)
+{
+    free(ctx->src_state);
+    free(ctx->dst_state);
+}
+
 int d64copy_read_image(CBM_FILE cbm_fd,
                        d64copy_settings *settings,
                        int src_drive,
@@ -788,24 +1870,50 @@ int d64copy_read_image(CBM_FILE cbm_fd,
                        d64copy_message_cb msg_cb,
                        d64copy_status_cb stat_cb)
 {
-    const transfer_funcs *src;
-    const transfer_funcs *dst;
+    copy_context ctx;
     int ret;
 
-    message_cb = msg_cb;
-    status_cb = stat_cb;
+    if(init_context(&ctx, settings, transfers[settings->transfer_mode].trf,
+                    &d64copy_fs_transfer, msg_cb, stat_cb))
+    {
+        return -1;
+    }
+
+    SETSTATEDEBUG((void)0);
+    ret = copy_disk(cbm_fd, &ctx,
+            (void*)(ULONG_PTR)src_drive, (void*)dst_image, (unsigned char) src_drive);
+
+    free_context(&ctx);
+
+    return ret;
+}
+
+int d64copy_read_sinks(CBM_FILE cbm_fd,
+                       d64copy_settings *settings,
+                       int src_drive,
+                       const d64copy_sink *sinks,
+                       int sink_count,
+                       d64copy_message_cb msg_cb,
+                       d64copy_status_cb stat_cb)
+{
+    copy_context ctx;
+    fanout_sinks fs;
+    int ret;
 
-    src = transfers[settings->transfer_mode].trf;
-    dst = &d64copy_fs_transfer;
+    if(init_context(&ctx, settings, transfers[settings->transfer_mode].trf,
+                    &d64copy_fanout_transfer, msg_cb, stat_cb))
+    {
+        return -1;
+    }
 
-    atom_dst = dst;
-    atom_mustcleanup = 1;
+    fs.sinks = sinks;
+    fs.count = sink_count;
 
     SETSTATEDEBUG((void)0);
-    ret = copy_disk(cbm_fd, settings,
-            src, (void*)(ULONG_PTR)src_drive, dst, (void*)dst_image, (unsigned char) src_drive);
+    ret = copy_disk(cbm_fd, &ctx,
+            (void*)(ULONG_PTR)src_drive, &fs, (unsigned char) src_drive);
 
-    atom_mustcleanup = 0;
+    free_context(&ctx);
 
     return ret;
 }
@@ -817,29 +1925,37 @@ int d64copy_write_image(CBM_FILE cbm_fd,
                         d64copy_message_cb msg_cb,
                         d64copy_status_cb stat_cb)
 {
-    const transfer_funcs *src;
-    const transfer_funcs *dst;
-
-    message_cb = msg_cb;
-    status_cb = stat_cb;
+    copy_context ctx;
+    int ret;
 
-    src = &d64copy_fs_transfer;
-    dst = transfers[settings->transfer_mode].trf;
+    if(init_context(&ctx, settings, &d64copy_fs_transfer,
+                    transfers[settings->transfer_mode].trf, msg_cb, stat_cb))
+    {
+        return -1;
+    }
 
     SETSTATEDEBUG((void)0);
-    return copy_disk(cbm_fd, settings,
-            src, (void*)src_image, dst, (void*)(ULONG_PTR)dst_drive, (unsigned char) dst_drive);
+    ret = copy_disk(cbm_fd, &ctx,
+            (void*)src_image, (void*)(ULONG_PTR)dst_drive, (unsigned char) dst_drive);
+
+    free_context(&ctx);
+
+    return ret;
 }
 
 void d64copy_cleanup(void)
 {
+    copy_context *ctx;
+
     /* if we were interrupted writing to the fs, make sure to
      * write anything that has already been started
      */
 
-    if (atom_mustcleanup)
+    arch_mutex_lock(&cleanup_mutex);
+    while((ctx = cleanup_list) != NULL)
     {
-        atom_dst->close_disk();
-        atom_mustcleanup = 0;
+        cleanup_list = ctx->next;
+        ctx->dst->close_disk(ctx->dst_state);
     }
+    arch_mutex_unlock(cleanup_mutex);
 }
@@ -40,18 +40,29 @@
 
 typedef int(*turbo_start)(CBM_FILE,unsigned char);
 
+/*
+ * A transfer keeps its state in a block of state_size bytes which the
+ * caller allocates (zeroed) for every copy and passes to all functions.
+ * Thus, several copies can run at the same time.
+ */
 typedef struct {
-    int  (*open_disk)(CBM_FILE,d64copy_settings*,const void*,int,
+    int  (*open_disk)(void*,CBM_FILE,d64copy_settings*,const void*,int,
                       turbo_start,d64copy_message_cb);
-    int  (*read_block)(unsigned char,unsigned char,unsigned char*);
-    int  (*write_block)(unsigned char,unsigned char,const unsigned char*,int,int);
-    void (*close_disk)(void);
+    int  (*read_block)(void*,unsigned char,unsigned char,unsigned char*);
+    int  (*write_block)(void*,unsigned char,unsigned char,const unsigned char*,int,int);
+    void (*close_disk)(void*);
     int  is_cbm_drive;
     int  needs_turbo;
-    int  (*send_track_map)(unsigned char,const char*,unsigned char);
-    int  (*read_gcr_block)(unsigned char*,unsigned char*);
+    int  (*send_track_map)(void*,unsigned char,const char*,unsigned char);
+    int  (*read_gcr_block)(void*,unsigned char*,unsigned char*);
+    int  (*read_track)(void*,unsigned char,const unsigned char*,int,
+                       unsigned char*,int*);
+    int  (*write_track)(void*,unsigned char,const unsigned char*,int,
+                        const unsigned char*,int*);
+    size_t state_size;
 } transfer_funcs;
 
+/* the transfer modules call their state type transfer_state */
 #define DECLARE_TRANSFER_FUNCS(x,c,t) \
     transfer_funcs d64copy_ ## x = {open_disk, \
                         read_block, \
@@ -60,7 +71,10 @@ typedef struct {
                         c, \
                         t, \
                         NULL, \
-                        NULL}
+                        NULL, \
+                        NULL, \
+                        NULL, \
+                        sizeof(transfer_state)}
 
 #define DECLARE_TRANSFER_FUNCS_EX(x,c,t) \
     transfer_funcs d64copy_ ## x = {open_disk, \
@@ -70,6 +84,24 @@ typedef struct {
                         c, \
                         t, \
                         send_track_map, \
-                        read_gcr_block}
+                        read_gcr_block, \
+                        read_track, \
+                        write_track, \
+                        sizeof(transfer_state)}
+
+/* maximum size of a track request, see d64copy_track_request() */
+#define TRACK_REQUEST_SIZE (2 + MAX_SECTORS + 1)
+
+extern int d64copy_track_request(unsigned char *request, unsigned char tr,
+                                 const unsigned char *sectors, int count);
+
+/* the argument of d64copy_fanout_transfer.open_disk() */
+typedef struct {
+    const d64copy_sink *sinks;
+    int count;
+} fanout_sinks;
+
+/* fill in the progress of the sinks of a fanout transfer */
+extern void d64copy_fanout_status(void *state, d64copy_status *status);
 
 #endif
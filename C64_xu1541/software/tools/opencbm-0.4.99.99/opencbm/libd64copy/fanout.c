@@ -0,0 +1,204 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version
+ *  2 of the License, or (at your option) any later version.
+ */
+
+/*
+ * Destination of a copy which passes every block on to several sinks,
+ * so a disk has to be read only once for all of them.
+ */
+
+#include "d64copy_int.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+extern transfer_funcs d64copy_fs_transfer,
+                      d64copy_checksum_transfer,
+                      d64copy_compare_transfer;
+
+/* what a sink made of the last copy of a block */
+#define SINK_NONE   0
+#define SINK_OK     1
+#define SINK_FAILED 2
+
+typedef struct
+{
+    d64copy_sink_type type;
+    const transfer_funcs *trf;
+    void *state;
+    char result[MAX_TRACKS][MAX_SECTORS];
+    d64copy_sink_status status;
+} sink_state;
+
+/* the state of one transfer */
+typedef struct
+{
+    int count;
+    sink_state sinks[D64COPY_MAX_SINKS];
+} transfer_state;
+
+static int read_block(void *state, unsigned char tr, unsigned char se, unsigned char *block)
+{
+    return 1;
+}
+
+/*
+ * returns non-zero if an image or the checksums could not be written,
+ * a block which differs from a reference is no reason to read it again
+ */
+static int write_block(void *state, unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
+{
+    transfer_state *st = state;
+    sink_state *sk;
+    int i, ret = 0, r;
+    char result;
+
+    if(tr < 1 || tr > MAX_TRACKS || se >= MAX_SECTORS)
+    {
+        return 1;
+    }
+
+    for(i = 0; i < st->count; i++)
+    {
+        sk = &st->sinks[i];
+        r = sk->trf->write_block(sk->state, tr, se, blk, size, read_status);
+        if(r && sk->type != sk_compare)
+        {
+            ret = r;
+        }
+
+        /* a block is written again if it is retried, count it once */
+        result = r ? SINK_FAILED : SINK_OK;
+        if(sk->result[tr-1][se] != result)
+        {
+            if(sk->result[tr-1][se] == SINK_NONE)
+            {
+                sk->status.blocks++;
+            }
+            else if(sk->result[tr-1][se] == SINK_FAILED)
+            {
+                sk->status.errors--;
+            }
+            if(result == SINK_FAILED)
+            {
+                sk->status.errors++;
+            }
+            sk->result[tr-1][se] = result;
+        }
+    }
+    return ret;
+}
+
+static void close_disk(void *state)
+{
+    transfer_state *st = state;
+    int i;
+
+    for(i = 0; i < D64COPY_MAX_SINKS; i++)
+    {
+        if(st->sinks[i].state)
+        {
+            st->sinks[i].trf->close_disk(st->sinks[i].state);
+            free(st->sinks[i].state);
+            st->sinks[i].state = NULL;
+        }
+    }
+    st->count = 0;
+}
+
+static int open_disk(void *state, CBM_FILE fd, d64copy_settings *settings,
+                     const void *arg, int for_writing,
+                     turbo_start start, d64copy_message_cb message_cb)
+{
+    transfer_state *st = state;
+    const fanout_sinks *fs = arg;
+    const d64copy_sink *sink;
+    sink_state *sk;
+    const void *sink_arg;
+    int i, pass;
+
+    if(!for_writing || fs->count < 1 || fs->count > D64COPY_MAX_SINKS)
+    {
+        message_cb(0, "invalid number of destinations: %d", fs->count);
+        return 1;
+    }
+
+    /*
+     * open the image files last, so they are not created in vain if
+     * e.g. the reference image is missing
+     */
+    memset(st, 0, sizeof(*st));
+    for(pass = 0; pass < 2; pass++)
+    {
+        for(i = 0; i < fs->count; i++)
+        {
+            sink = &fs->sinks[i];
+            sk = &st->sinks[i];
+            if((sink->type == sk_image) != pass)
+            {
+                continue;
+            }
+            sk->type = sink->type;
+            switch(sink->type)
+            {
+                case sk_image:
+                    sk->trf = &d64copy_fs_transfer;
+                    sink_arg = sink->image;
+                    break;
+                case sk_checksum:
+                    sk->trf = &d64copy_checksum_transfer;
+                    sink_arg = sink->checksums;
+                    break;
+                case sk_compare:
+                    sk->trf = &d64copy_compare_transfer;
+                    sink_arg = sink->image;
+                    break;
+                default:
+                    sk->trf = NULL;
+                    sink_arg = NULL;
+                    break;
+            }
+            if(sk->trf == NULL || sink_arg == NULL)
+            {
+                message_cb(0, "invalid destination %d", i + 1);
+                close_disk(st);
+                return 1;
+            }
+
+            sk->state = calloc(1, sk->trf->state_size);
+            if(sk->state == NULL)
+            {
+                message_cb(0, "no memory for transfer");
+                close_disk(st);
+                return 1;
+            }
+            if(sk->trf->open_disk(sk->state, fd, settings, sink_arg, 1,
+                                  start, message_cb) != 0)
+            {
+                free(sk->state);
+                sk->state = NULL;
+                close_disk(st);
+                return 1;
+            }
+        }
+    }
+    st->count = fs->count;
+    return 0;
+}
+
+void d64copy_fanout_status(void *state, d64copy_status *status)
+{
+    transfer_state *st = state;
+    int i;
+
+    status->sink_count = st->count;
+    for(i = 0; i < st->count; i++)
+    {
+        status->sinks[i] = st->sinks[i].status;
+    }
+}
+
+DECLARE_TRANSFER_FUNCS(fanout_transfer, 0, 0);
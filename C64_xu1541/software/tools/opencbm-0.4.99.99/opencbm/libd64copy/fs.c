@@ -15,85 +15,101 @@
 
 #include "arch.h"
 
-static d64copy_settings *fs_settings;
-
-static FILE *the_file;
-static char *error_map;
-static int block_count;
+/* the state of one transfer */
+typedef struct
+{
+    d64copy_settings *fs_settings;
 
-/* always use maximum size for error map */
-#define ERROR_MAP_LENGTH D71_BLOCKS
+    /*
+     * The image is mapped into memory as a whole. When writing, the mapping
+     * always includes room for the error map behind the blocks; the file is
+     * cut back to the blocks alone in close_disk() if there are no errors.
+     */
+    arch_filemap_t *the_map;
+    unsigned char *image;
+    char *error_map;
+    int block_count;
 
-static int block_offset(int tr, int se)
+    /*
+     * Variables to make sure writing the block is an atomary process
+     */
+    int atom_execute;
+    unsigned char atom_tr;
+    unsigned char atom_se;
+    const unsigned char *atom_blk;
+    int atom_size;
+    int atom_read_status;
+} transfer_state;
+
+static int block_offset(transfer_state *st, int tr, int se)
 {
     int sectors = 0, i;
     for(i = 1; i < tr; i++)
     {
-        sectors += d64copy_sector_count(fs_settings->two_sided, i);
+        sectors += d64copy_sector_count(st->fs_settings->two_sided, i);
     }
     return (sectors + se) * BLOCKSIZE;
 }
 
-static int read_block(unsigned char tr, unsigned char se, unsigned char *block)
+static int read_block(void *state, unsigned char tr, unsigned char se, unsigned char *block)
 {
-    if(fseek(the_file, block_offset(tr, se), SEEK_SET) == 0)
+    transfer_state *st = state;
+    int ofs = block_offset(st, tr, se);
+
+    if(ofs >= 0 && ofs + BLOCKSIZE <= st->block_count * BLOCKSIZE)
     {
-        return fread(block, BLOCKSIZE, 1, the_file) != 1;
+        memcpy(block, st->image + ofs, BLOCKSIZE);
+        return 0;
     }
     return 1;
 }
 
-/*
- * Variables to make sure writing the block is an atomary process
- */
-static int atom_execute = 0;
-static unsigned char atom_tr;
-static unsigned char atom_se;
-static const unsigned char *atom_blk;
-static int atom_size;
-static int atom_read_status;
-
-static int write_block(unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
+static int write_block(void *state, unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
 {
+    transfer_state *st = state;
     long ofs;
     int ret;
 
-    atom_tr = tr;
-    atom_se = se;
-    atom_blk = blk;
-    atom_size = size;
-    atom_read_status = read_status;
+    st->atom_tr = tr;
+    st->atom_se = se;
+    st->atom_blk = blk;
+    st->atom_size = size;
+    st->atom_read_status = read_status;
 
-    atom_execute = 1;
+    st->atom_execute = 1;
 
-    ofs = block_offset(tr, se);
-    if(fseek(the_file, ofs, SEEK_SET) == 0)
+    ofs = block_offset(st, tr, se);
+    if(ofs >= 0 && ofs + size <= st->block_count * BLOCKSIZE)
     {
-        error_map[ofs / BLOCKSIZE] = (char) ((read_status == 0) ? 1 : read_status);
-        ret = fwrite(blk, size, 1, the_file) != 1;
+        st->error_map[ofs / BLOCKSIZE] = (char) ((read_status == 0) ? 1 : read_status);
+        memcpy(st->image + ofs, blk, size);
+        ret = 0;
     }
     else
     {
         ret = 1;
     }
 
-    atom_execute = 0;
+    st->atom_execute = 0;
 
     return ret;
 }
 
-static int open_disk(CBM_FILE fd, d64copy_settings *settings,
+static int open_disk(void *state, CBM_FILE fd, d64copy_settings *settings,
                      const void *arg, int for_writing,
                      turbo_start start, d64copy_message_cb message_cb)
 {
+    transfer_state *st = state;
     off_t filesize;
     int stat_ok, is_image, error_info;
     int tr = 0;
+    int old_block_count;
     char *name = (char*)arg;
 
-    the_file = NULL;
-    fs_settings = settings;
-    block_count = 0;
+    st->the_map = NULL;
+    st->error_map = NULL;
+    st->fs_settings = settings;
+    st->block_count = 0;
 
     stat_ok = arch_filesize(name, &filesize) == 0;
     is_image = error_info = 0;
@@ -103,30 +119,30 @@ static int open_disk(CBM_FILE fd, d64copy_settings *settings,
         if(filesize == D71_BLOCKS * BLOCKSIZE)
         {
             is_image = 1;
-            block_count = D71_BLOCKS;
+            st->block_count = D71_BLOCKS;
             tr = D71_TRACKS;
         }
         else if(filesize == D71_BLOCKS * (BLOCKSIZE + 1))
         {
             is_image = 1;
             error_info = 1;
-            block_count = D71_BLOCKS;
+            st->block_count = D71_BLOCKS;
             tr = D71_TRACKS;
         }
         else
         {
-            block_count = STD_BLOCKS;
+            st->block_count = STD_BLOCKS;
             for( tr = STD_TRACKS; !is_image && tr <= TOT_TRACKS; )
             {
-                is_image = filesize == block_count * BLOCKSIZE;
+                is_image = filesize == st->block_count * BLOCKSIZE;
                 if(!is_image)
                 {
                     error_info = is_image =
-                        filesize == block_count * (BLOCKSIZE + 1);
+                        filesize == st->block_count * (BLOCKSIZE + 1);
                 }
                 if(!is_image)
                 {
-                    block_count += d64copy_sector_count( 0, tr++ );
+                    st->block_count += d64copy_sector_count( 0, tr++ );
                 }
             }
             if( is_image && tr != STD_TRACKS )
@@ -142,8 +158,9 @@ static int open_disk(CBM_FILE fd, d64copy_settings *settings,
         {
             if(is_image)
             {
-                the_file = fopen(name, "rb");
-                if(the_file == NULL)
+                st->the_map = arch_filemap_open(name, ARCH_FILEMAP_READ,
+                                                filesize, &st->image);
+                if(st->the_map == NULL)
                 {
                     message_cb(0, "could not open %s", name);
                 }
@@ -174,106 +191,94 @@ static int open_disk(CBM_FILE fd, d64copy_settings *settings,
     }
     else
     {
-        the_file = fopen(name, is_image ? "r+b" : "wb");
-        if(the_file)
+        /* check whether we must resize or create an image file */
+        int new_tr;
+        if(settings->two_sided)
         {
-            /* check whether we must resize or create an image file */
-            int new_tr;
-            if(settings->two_sided)
-            {
-                new_tr = D71_TRACKS;
-            }
-            else if(settings->end_track <= STD_TRACKS)
-            {
-                new_tr = STD_TRACKS;
-            }
-            else if(settings->end_track <= EXT_TRACKS)
-            {
-                new_tr = EXT_TRACKS;
-            }
-            else
-            {
-                new_tr = TOT_TRACKS;
-            }
+            new_tr = D71_TRACKS;
+        }
+        else if(settings->end_track <= STD_TRACKS)
+        {
+            new_tr = STD_TRACKS;
+        }
+        else if(settings->end_track <= EXT_TRACKS)
+        {
+            new_tr = EXT_TRACKS;
+        }
+        else
+        {
+            new_tr = TOT_TRACKS;
+        }
 
-            /* always use maximum size for error map */
-            error_map = calloc(ERROR_MAP_LENGTH, 1);
-            if(!error_map)
+        old_block_count = st->block_count;
+        if(new_tr > tr)
+        {
+            /* grow image */
+            while(tr < new_tr)
             {
-                message_cb(0, "no memory for error map");
-                fclose(the_file);
-                if(!is_image)
-                {
-                    arch_unlink(name);
-                }
-                return 1;
+                st->block_count += d64copy_sector_count(settings->two_sided, ++tr);
             }
 
-            if(is_image)
+            message_cb(1, "growing image file to %d blocks", st->block_count);
+        }
+
+        /* map the blocks plus the error map */
+        st->the_map = arch_filemap_open(name,
+                                        is_image ? ARCH_FILEMAP_WRITE : ARCH_FILEMAP_CREATE,
+                                        st->block_count * (BLOCKSIZE + 1), &st->image);
+        if(st->the_map)
+        {
+            st->error_map = (char *) st->image + st->block_count * BLOCKSIZE;
+
+            if(st->block_count != old_block_count)
             {
+                /* move an existing error map behind the new blocks,
+                 * the new blocks and their error bytes start out empty */
                 if(error_info)
                 {
-                    if(fseek(the_file, block_count * BLOCKSIZE, SEEK_SET) != 0 ||
-                       fread(error_map, block_count, 1, the_file) != 1)
-                    {
-                        message_cb(0, "%s: could not read error map", name);
-                        fclose(the_file);
-                        return 1;
-                    }
-                }
-                if(fseek(the_file, block_count * BLOCKSIZE, SEEK_SET) != 0)
-                {
-                    message_cb(0, "%s: could not seek to end of file", name);
-                    fclose(the_file);
-                    return 1;
+                    memmove(st->error_map, st->image + old_block_count * BLOCKSIZE,
+                            old_block_count);
                 }
+                memset(st->image + old_block_count * BLOCKSIZE, 0,
+                       (st->block_count - old_block_count) * BLOCKSIZE);
+                memset(st->error_map + old_block_count, 0,
+                       st->block_count - old_block_count);
             }
-
-            if(new_tr > tr)
+            else if(!error_info)
             {
-                /* grow image */
-                while(tr < new_tr)
-                {
-                    block_count += d64copy_sector_count(settings->two_sided, ++tr);
-                }
-
-                message_cb(1, "growing image file to %d blocks", block_count);
-
-                if (arch_ftruncate(arch_fileno(the_file), block_count * BLOCKSIZE) != 0)
-                {
-                    message_cb(0, "%s: could not extend image file", name);
-                    fclose(the_file);
-                    if(!is_image)
-                        arch_unlink(name);
-                    return 1;
-                }
+                memset(st->error_map, 0, st->block_count);
             }
         }
         else
         {
             message_cb(0, "could not open %s", name);
+            if(!is_image)
+            {
+                arch_unlink(name);
+            }
         }
     }
-    return the_file == NULL;
+    return st->the_map == NULL;
 }
 
-static void close_disk(void)
+static void close_disk(void *state)
 {
+    transfer_state *st = state;
     int i, has_errors = 0;
 
     /* if writing the block was interrupted, make sure it is
      * redone before closing the disk 
      */
 
-    if (the_file && atom_execute)
+    if (st->the_map && st->error_map && st->atom_execute)
     {
-        atom_execute = 0;
-        write_block(atom_tr, atom_se, atom_blk, atom_size, atom_read_status);
+        st->atom_execute = 0;
+        write_block(st, st->atom_tr, st->atom_se, st->atom_blk, st->atom_size, st->atom_read_status);
     }
 
-    if (fs_settings)
+    if (st->fs_settings)
     {
-        switch(fs_settings->error_mode)
+        switch(st->fs_settings->error_mode)
         {
             case em_always:
                 has_errors = 1;
@@ -282,41 +287,25 @@ static void close_disk(void)
                 has_errors = 0;
                 break;
             default:
-                if(error_map)
+                if(st->error_map)
                 {
-                    for(i = 0; !has_errors && i < block_count; i++)
+                    for(i = 0; !has_errors && i < st->block_count; i++)
                     {
-                        has_errors = error_map[i] != 1;
+                        has_errors = st->error_map[i] != 1;
                     }
                 }
                 break;
         }
     }
 
-    if(the_file)
-    {
-        if(has_errors)
-        {
-            if(fseek(the_file, block_count * BLOCKSIZE, SEEK_SET) == 0)
-            {
-                fwrite(error_map, block_count, 1, the_file);
-            }
-        } 
-        else
-        {
-            arch_ftruncate(arch_fileno(the_file), block_count * BLOCKSIZE);
-        }
-    }
-
-    if(error_map)
-    {
-        free(error_map);
-        error_map = NULL;
-    }
-    if(the_file)
+    if(st->the_map)
     {
-        fclose(the_file);
-        the_file = NULL;
+        /* the error map is already in place, only cut it off if not wanted */
+        arch_filemap_close(st->the_map, has_errors ?
+                           st->block_count * (BLOCKSIZE + 1) : st->block_count * BLOCKSIZE);
+        st->the_map = NULL;
+        st->image = NULL;
+        st->error_map = NULL;
     }
 }
 
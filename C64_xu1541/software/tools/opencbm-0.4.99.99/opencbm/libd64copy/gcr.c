@@ -9,17 +9,155 @@
 
 #include "gcr.h"
 
+/*
+ * The codec works on 10 bit units: every plain byte is encoded into two
+ * 5 bit GCR nybbles, so 4 plain bytes become exactly 5 GCR bytes. Both
+ * directions are done with a single table lookup per byte.
+ *
+ * gcr_decode_tab[] is indexed with the 10 GCR bits of one byte. Illegal
+ * GCR nybbles decode to 0x0f, the same result gcr_5_to_4_decode() gives,
+ * so images are bit-identical to the ones produced before.
+ * gcr_encode_tab[] holds the 10 GCR bits of every byte value.
+ *
+ * Both tables are generated from the 5 bit tables in lib/gcr_4b5b.c.
+ */
+static const unsigned char gcr_decode_tab[1024] =
+{
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0x8f, 0x8f, 0x8f, 0x8f, 0x8f, 0x8f, 0x8f, 0x8f, 0x8f, 0x88, 0x80, 0x81, 0x8f, 0x8c, 0x84, 0x85,
+    0x8f, 0x8f, 0x82, 0x83, 0x8f, 0x8f, 0x86, 0x87, 0x8f, 0x89, 0x8a, 0x8b, 0x8f, 0x8d, 0x8e, 0x8f,
+    0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x08, 0x00, 0x01, 0x0f, 0x0c, 0x04, 0x05,
+    0x0f, 0x0f, 0x02, 0x03, 0x0f, 0x0f, 0x06, 0x07, 0x0f, 0x09, 0x0a, 0x0b, 0x0f, 0x0d, 0x0e, 0x0f,
+    0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x18, 0x10, 0x11, 0x1f, 0x1c, 0x14, 0x15,
+    0x1f, 0x1f, 0x12, 0x13, 0x1f, 0x1f, 0x16, 0x17, 0x1f, 0x19, 0x1a, 0x1b, 0x1f, 0x1d, 0x1e, 0x1f,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xcf, 0xcf, 0xcf, 0xcf, 0xcf, 0xcf, 0xcf, 0xcf, 0xcf, 0xc8, 0xc0, 0xc1, 0xcf, 0xcc, 0xc4, 0xc5,
+    0xcf, 0xcf, 0xc2, 0xc3, 0xcf, 0xcf, 0xc6, 0xc7, 0xcf, 0xc9, 0xca, 0xcb, 0xcf, 0xcd, 0xce, 0xcf,
+    0x4f, 0x4f, 0x4f, 0x4f, 0x4f, 0x4f, 0x4f, 0x4f, 0x4f, 0x48, 0x40, 0x41, 0x4f, 0x4c, 0x44, 0x45,
+    0x4f, 0x4f, 0x42, 0x43, 0x4f, 0x4f, 0x46, 0x47, 0x4f, 0x49, 0x4a, 0x4b, 0x4f, 0x4d, 0x4e, 0x4f,
+    0x5f, 0x5f, 0x5f, 0x5f, 0x5f, 0x5f, 0x5f, 0x5f, 0x5f, 0x58, 0x50, 0x51, 0x5f, 0x5c, 0x54, 0x55,
+    0x5f, 0x5f, 0x52, 0x53, 0x5f, 0x5f, 0x56, 0x57, 0x5f, 0x59, 0x5a, 0x5b, 0x5f, 0x5d, 0x5e, 0x5f,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0x2f, 0x2f, 0x2f, 0x2f, 0x2f, 0x2f, 0x2f, 0x2f, 0x2f, 0x28, 0x20, 0x21, 0x2f, 0x2c, 0x24, 0x25,
+    0x2f, 0x2f, 0x22, 0x23, 0x2f, 0x2f, 0x26, 0x27, 0x2f, 0x29, 0x2a, 0x2b, 0x2f, 0x2d, 0x2e, 0x2f,
+    0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x3f, 0x38, 0x30, 0x31, 0x3f, 0x3c, 0x34, 0x35,
+    0x3f, 0x3f, 0x32, 0x33, 0x3f, 0x3f, 0x36, 0x37, 0x3f, 0x39, 0x3a, 0x3b, 0x3f, 0x3d, 0x3e, 0x3f,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0x6f, 0x6f, 0x6f, 0x6f, 0x6f, 0x6f, 0x6f, 0x6f, 0x6f, 0x68, 0x60, 0x61, 0x6f, 0x6c, 0x64, 0x65,
+    0x6f, 0x6f, 0x62, 0x63, 0x6f, 0x6f, 0x66, 0x67, 0x6f, 0x69, 0x6a, 0x6b, 0x6f, 0x6d, 0x6e, 0x6f,
+    0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x78, 0x70, 0x71, 0x7f, 0x7c, 0x74, 0x75,
+    0x7f, 0x7f, 0x72, 0x73, 0x7f, 0x7f, 0x76, 0x77, 0x7f, 0x79, 0x7a, 0x7b, 0x7f, 0x7d, 0x7e, 0x7f,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x98, 0x90, 0x91, 0x9f, 0x9c, 0x94, 0x95,
+    0x9f, 0x9f, 0x92, 0x93, 0x9f, 0x9f, 0x96, 0x97, 0x9f, 0x99, 0x9a, 0x9b, 0x9f, 0x9d, 0x9e, 0x9f,
+    0xaf, 0xaf, 0xaf, 0xaf, 0xaf, 0xaf, 0xaf, 0xaf, 0xaf, 0xa8, 0xa0, 0xa1, 0xaf, 0xac, 0xa4, 0xa5,
+    0xaf, 0xaf, 0xa2, 0xa3, 0xaf, 0xaf, 0xa6, 0xa7, 0xaf, 0xa9, 0xaa, 0xab, 0xaf, 0xad, 0xae, 0xaf,
+    0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xb8, 0xb0, 0xb1, 0xbf, 0xbc, 0xb4, 0xb5,
+    0xbf, 0xbf, 0xb2, 0xb3, 0xbf, 0xbf, 0xb6, 0xb7, 0xbf, 0xb9, 0xba, 0xbb, 0xbf, 0xbd, 0xbe, 0xbf,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff,
+    0xdf, 0xdf, 0xdf, 0xdf, 0xdf, 0xdf, 0xdf, 0xdf, 0xdf, 0xd8, 0xd0, 0xd1, 0xdf, 0xdc, 0xd4, 0xd5,
+    0xdf, 0xdf, 0xd2, 0xd3, 0xdf, 0xdf, 0xd6, 0xd7, 0xdf, 0xd9, 0xda, 0xdb, 0xdf, 0xdd, 0xde, 0xdf,
+    0xef, 0xef, 0xef, 0xef, 0xef, 0xef, 0xef, 0xef, 0xef, 0xe8, 0xe0, 0xe1, 0xef, 0xec, 0xe4, 0xe5,
+    0xef, 0xef, 0xe2, 0xe3, 0xef, 0xef, 0xe6, 0xe7, 0xef, 0xe9, 0xea, 0xeb, 0xef, 0xed, 0xee, 0xef,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf8, 0xf0, 0xf1, 0xff, 0xfc, 0xf4, 0xf5,
+    0xff, 0xff, 0xf2, 0xf3, 0xff, 0xff, 0xf6, 0xf7, 0xff, 0xf9, 0xfa, 0xfb, 0xff, 0xfd, 0xfe, 0xff
+};
+
+static const unsigned short gcr_encode_tab[256] =
+{
+    0x14a, 0x14b, 0x152, 0x153, 0x14e, 0x14f, 0x156, 0x157,
+    0x149, 0x159, 0x15a, 0x15b, 0x14d, 0x15d, 0x15e, 0x155,
+    0x16a, 0x16b, 0x172, 0x173, 0x16e, 0x16f, 0x176, 0x177,
+    0x169, 0x179, 0x17a, 0x17b, 0x16d, 0x17d, 0x17e, 0x175,
+    0x24a, 0x24b, 0x252, 0x253, 0x24e, 0x24f, 0x256, 0x257,
+    0x249, 0x259, 0x25a, 0x25b, 0x24d, 0x25d, 0x25e, 0x255,
+    0x26a, 0x26b, 0x272, 0x273, 0x26e, 0x26f, 0x276, 0x277,
+    0x269, 0x279, 0x27a, 0x27b, 0x26d, 0x27d, 0x27e, 0x275,
+    0x1ca, 0x1cb, 0x1d2, 0x1d3, 0x1ce, 0x1cf, 0x1d6, 0x1d7,
+    0x1c9, 0x1d9, 0x1da, 0x1db, 0x1cd, 0x1dd, 0x1de, 0x1d5,
+    0x1ea, 0x1eb, 0x1f2, 0x1f3, 0x1ee, 0x1ef, 0x1f6, 0x1f7,
+    0x1e9, 0x1f9, 0x1fa, 0x1fb, 0x1ed, 0x1fd, 0x1fe, 0x1f5,
+    0x2ca, 0x2cb, 0x2d2, 0x2d3, 0x2ce, 0x2cf, 0x2d6, 0x2d7,
+    0x2c9, 0x2d9, 0x2da, 0x2db, 0x2cd, 0x2dd, 0x2de, 0x2d5,
+    0x2ea, 0x2eb, 0x2f2, 0x2f3, 0x2ee, 0x2ef, 0x2f6, 0x2f7,
+    0x2e9, 0x2f9, 0x2fa, 0x2fb, 0x2ed, 0x2fd, 0x2fe, 0x2f5,
+    0x12a, 0x12b, 0x132, 0x133, 0x12e, 0x12f, 0x136, 0x137,
+    0x129, 0x139, 0x13a, 0x13b, 0x12d, 0x13d, 0x13e, 0x135,
+    0x32a, 0x32b, 0x332, 0x333, 0x32e, 0x32f, 0x336, 0x337,
+    0x329, 0x339, 0x33a, 0x33b, 0x32d, 0x33d, 0x33e, 0x335,
+    0x34a, 0x34b, 0x352, 0x353, 0x34e, 0x34f, 0x356, 0x357,
+    0x349, 0x359, 0x35a, 0x35b, 0x34d, 0x35d, 0x35e, 0x355,
+    0x36a, 0x36b, 0x372, 0x373, 0x36e, 0x36f, 0x376, 0x377,
+    0x369, 0x379, 0x37a, 0x37b, 0x36d, 0x37d, 0x37e, 0x375,
+    0x1aa, 0x1ab, 0x1b2, 0x1b3, 0x1ae, 0x1af, 0x1b6, 0x1b7,
+    0x1a9, 0x1b9, 0x1ba, 0x1bb, 0x1ad, 0x1bd, 0x1be, 0x1b5,
+    0x3aa, 0x3ab, 0x3b2, 0x3b3, 0x3ae, 0x3af, 0x3b6, 0x3b7,
+    0x3a9, 0x3b9, 0x3ba, 0x3bb, 0x3ad, 0x3bd, 0x3be, 0x3b5,
+    0x3ca, 0x3cb, 0x3d2, 0x3d3, 0x3ce, 0x3cf, 0x3d6, 0x3d7,
+    0x3c9, 0x3d9, 0x3da, 0x3db, 0x3cd, 0x3dd, 0x3de, 0x3d5,
+    0x2aa, 0x2ab, 0x2b2, 0x2b3, 0x2ae, 0x2af, 0x2b6, 0x2b7,
+    0x2a9, 0x2b9, 0x2ba, 0x2bb, 0x2ad, 0x2bd, 0x2be, 0x2b5
+};
+
+
+/* decode one group of 5 GCR bytes, returns the XOR of the 4 result bytes */
+static unsigned char gcr_decode_group(const unsigned char *gcr, unsigned char *decoded)
+{
+    decoded[0] = gcr_decode_tab[ (gcr[0] << 2)         | (gcr[1] >> 6)];
+    decoded[1] = gcr_decode_tab[((gcr[1] & 0x3f) << 4) | (gcr[2] >> 4)];
+    decoded[2] = gcr_decode_tab[((gcr[2] & 0x0f) << 6) | (gcr[3] >> 2)];
+    decoded[3] = gcr_decode_tab[((gcr[3] & 0x03) << 8) |  gcr[4]];
+
+    return decoded[0] ^ decoded[1] ^ decoded[2] ^ decoded[3];
+}
+
+/* encode 4 plain bytes into one group of 5 GCR bytes */
+static void gcr_encode_group(const unsigned char *block, unsigned char *encoded)
+{
+    unsigned int w0 = gcr_encode_tab[block[0]];
+    unsigned int w1 = gcr_encode_tab[block[1]];
+    unsigned int w2 = gcr_encode_tab[block[2]];
+    unsigned int w3 = gcr_encode_tab[block[3]];
+
+    encoded[0] = (unsigned char) (w0 >> 2);
+    encoded[1] = (unsigned char)((w0 << 6) | (w1 >> 4));
+    encoded[2] = (unsigned char)((w1 << 4) | (w2 >> 6));
+    encoded[3] = (unsigned char)((w2 << 2) | (w3 >> 8));
+    encoded[4] = (unsigned char)  w3;
+}
+
 int gcr_decode(unsigned const char *gcr, unsigned char *decoded)
 {
-    unsigned char chkref[4], chksum = 0;
-    int i,j;
+    unsigned char chkref[4], chksum;
+    int i;
 
-    /* FIXME:
-     * Let's introduce buffer length specifiers and sanity checks,
-     * so the the following assumptions of length specifications
-     * of 4 and 5 become true.
-     */
-    gcr_5_to_4_decode(gcr, chkref, 5, sizeof(chkref));
+    chksum = gcr_decode_group(gcr, chkref);
     gcr += 5;
 
     if(chkref[0] != 0x07)
@@ -28,25 +166,19 @@ int gcr_decode(unsigned const char *gcr, unsigned char *decoded)
     }
 
         /* move over the remaining three bytes */
-    for(j = 1; j < 4; j++, decoded++)
-    {
-        *decoded = chkref[j];
-        chksum  ^= chkref[j];
-    }
+    decoded[0] = chkref[1];
+    decoded[1] = chkref[2];
+    decoded[2] = chkref[3];
+    decoded += 3;
+    chksum  ^= 0x07;
 
-        /* main block processing loop */
-    for(i = 1; i < BLOCKSIZE/4; i++)
+        /* main block processing loop, checksum is built on the fly */
+    for(i = 1; i < BLOCKSIZE/4; i++, gcr += 5, decoded += 4)
     {
-        gcr_5_to_4_decode(gcr, decoded, 5, 4);
-        gcr += 5;
-
-        for(j = 0; j < 4; j++, decoded++)
-        {
-            chksum ^= *decoded;
-        }
+        chksum ^= gcr_decode_group(gcr, decoded);
     }
 
-    gcr_5_to_4_decode(gcr, chkref, 5, 4);
+    gcr_decode_group(gcr, chkref);
         /* move over the remaining last byte */
     *decoded = chkref[0];
     chksum  ^= chkref[0];
@@ -56,51 +188,152 @@ int gcr_decode(unsigned const char *gcr, unsigned char *decoded)
 
 int gcr_encode(unsigned const char *block, unsigned char *encoded)
 {
-
-    unsigned char chkref[4] = { 0x07, 0, 0, 0};
-    int i,j;
-
-    /* FIXME:
-     * Let's introduce buffer length specifiers and sanity checks,
-     * so the the following assumptions of length specifications
-     * of 4 and 5 become true.
-     */
+    unsigned char chkref[4];
+    unsigned char chksum;
+    int i;
 
         /* start with encoding the data block
          * identifier and the first three bytes
          */
-    for(j = 1; j < 4; j++, block++)
-    {
-        chkref[j] = *block;
-    }
-       gcr_4_to_5_encode(chkref, encoded, sizeof(chkref), 5);
-       encoded += 5;
+    chkref[0] = 0x07;
+    chkref[1] = block[0];
+    chkref[2] = block[1];
+    chkref[3] = block[2];
+    gcr_encode_group(chkref, encoded);
+    encoded += 5;
 
-        /* add the three bytes into one checksum */
-    chkref[1] ^= (chkref[2] ^ chkref[3]);
+    chksum = block[0] ^ block[1] ^ block[2];
+    block += 3;
 
         /* main block processing loop */
-    for(i = 1; i < BLOCKSIZE/4; i++)
+    for(i = 1; i < BLOCKSIZE/4; i++, block += 4, encoded += 5)
     {
-        gcr_4_to_5_encode(block, encoded, 4, 5);
-        encoded += 5;
-
-        for(j = 0; j < 4; j++, block++)
-        {
-                /* directly encode the checksum */
-            chkref[1] ^= *block;
-        }
+        gcr_encode_group(block, encoded);
+        chksum ^= block[0] ^ block[1] ^ block[2] ^ block[3];
     }
 
-        /* move over the remaining last byte */
-    chkref[0]  = *block;
-        /* add the last byte to the checksum */
-    chkref[1] ^= *block;
+        /* move over the remaining last byte and the checksum */
+    chkref[0] = *block;
+    chkref[1] = chksum ^ *block;
 
     /* clear trailing unused bytes, not necessary but somehow nicer */
     chkref[2] = chkref[3] = 0;
 
-    gcr_4_to_5_encode(chkref, encoded, 4, 5);
+    gcr_encode_group(chkref, encoded);
 
     return 0;
 }
+
+int gcr_decode_header(const unsigned char *gcr, unsigned char *header)
+{
+    gcr_decode_group(gcr, header);
+    gcr_decode_group(gcr + 5, header + 4);
+
+    if(header[0] != 0x08)
+    {
+        return 2;
+    }
+
+    return ((header[1] ^ header[2] ^ header[3] ^ header[4] ^ header[5]) != 0)
+           ? 9 : 0;
+}
+
+/* copy n bytes starting at pos from the circular track buffer */
+static void gcr_fetch(const unsigned char *gcr, size_t length, size_t pos,
+                      unsigned char *dest, size_t n)
+{
+    while(n--)
+    {
+        *dest++ = gcr[pos++ % length];
+    }
+}
+
+int gcr_decode_track(const unsigned char *gcr, size_t length, int track,
+                     int sectors, unsigned char *blocks, int *results)
+{
+    unsigned char buf[GCRBUFSIZE];
+    unsigned char header[8];
+    size_t pos, end;
+    int se;
+    int sector = -1;
+    int found_sync = 0;
+    int decoded = 0;
+    int rv;
+
+    for(se = 0; se < sectors; se++)
+    {
+        results[se] = 2;
+    }
+
+    if(length < GCRBUFSIZE)
+    {
+        return 0;
+    }
+
+    /*
+     * A block starts with the first byte after a sync mark. As with the
+     * drive's byte-ready signal, the track is expected to be byte aligned
+     * to its sync marks. Two $ff bytes are taken as sync, GCR data never
+     * contains more than 8 1-bits in a row. The buffer is treated as
+     * circular and scanned a bit beyond its end, so a read of a single
+     * revolution also gets the block which wraps around.
+     */
+    for(end = 2 * length + GCRBUFSIZE, pos = length; pos < end; pos++)
+    {
+        if(gcr[pos % length] == 0xff ||
+           gcr[(pos - 1) % length] != 0xff ||
+           gcr[(pos - 2) % length] != 0xff)
+        {
+            continue;
+        }
+        found_sync = 1;
+
+        gcr_fetch(gcr, length, pos, buf, 10);
+        rv = gcr_decode_header(buf, header);
+        if(rv != 2)
+        {
+            sector = -1;
+            if(header[3] == track && header[2] < sectors)
+            {
+                sector = header[2];
+                if(results[sector] == 2 || results[sector] == 9)
+                {
+                    results[sector] = rv ? 9 : 4;
+                }
+                if(rv)
+                {
+                    sector = -1;
+                }
+            }
+            pos += 9;
+            continue;
+        }
+
+        if(sector < 0 || results[sector] == 0)
+        {
+            /* data block without (valid) header, or already done */
+            sector = -1;
+            continue;
+        }
+
+        gcr_fetch(gcr, length, pos, buf, GCRBUFSIZE);
+        rv = gcr_decode(buf, blocks + sector * BLOCKSIZE);
+        if(rv == 0 || results[sector] == 4)
+        {
+            results[sector] = rv;
+            if(rv == 0) decoded++;
+        }
+        sector = -1;
+        pos += GCRBUFSIZE - 2;
+    }
+
+    if(!found_sync)
+    {
+        for(se = 0; se < sectors; se++)
+        {
+            results[se] = 3;
+        }
+    }
+
+    return decoded;
+}
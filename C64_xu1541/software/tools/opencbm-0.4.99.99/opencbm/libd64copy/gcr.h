@@ -23,6 +23,17 @@ extern "C" {
 extern int gcr_decode(const unsigned char *gcr,   unsigned char *decoded);
 extern int gcr_encode(const unsigned char *block, unsigned char *encoded);
 
+/* decode the 10 GCR bytes of a block header into 8 bytes (id, checksum,
+ * sector, track, id2, id1, 0x0f, 0x0f); returns 0, 2 (no header) or
+ * 9 (header checksum error) */
+extern int gcr_decode_header(const unsigned char *gcr, unsigned char *header);
+
+/* decode all sectors of a raw GCR track read from the drive; results[]
+ * gets the job code for every sector, the number of good sectors is
+ * returned */
+extern int gcr_decode_track(const unsigned char *gcr, size_t length, int track,
+                            int sectors, unsigned char *blocks, int *results);
+
 #ifdef __cplusplus
 }
 #endif
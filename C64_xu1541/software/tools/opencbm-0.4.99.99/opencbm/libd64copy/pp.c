@@ -12,22 +12,27 @@
 #include "d64copy_int.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "arch.h"
 
 #include "opencbm-plugin.h"
 
-static opencbm_plugin_pp_dc_read_n_t * opencbm_plugin_pp_dc_read_n = NULL;
-
-static opencbm_plugin_pp_dc_write_n_t * opencbm_plugin_pp_dc_write_n = NULL;
-
 enum pp_direction_e
 {
     PP_READ, PP_WRITE
 };
 
-static CBM_FILE fd_cbm;
-static int two_sided;
+/* the state of one transfer */
+typedef struct
+{
+    CBM_FILE fd_cbm;
+    int two_sided;
+    enum pp_direction_e direction;
+    opencbm_plugin_pp_dc_read_n_t * opencbm_plugin_pp_dc_read_n;
+    opencbm_plugin_pp_dc_write_n_t * opencbm_plugin_pp_dc_write_n;
+    opencbm_plugin_pp_dc_write_read_n_t * opencbm_plugin_pp_dc_write_read_n;
+} transfer_state;
 
 static const unsigned char pp1541_drive_prog[] = {
 #include "pp1541.inc"
@@ -37,20 +42,20 @@ static const unsigned char pp1571_drive_prog[] = {
 #include "pp1571.inc"
 };
 
-static void pp_check_direction(enum pp_direction_e dir)
+static void pp_check_direction(transfer_state *st, enum pp_direction_e dir)
 {
-    static enum pp_direction_e direction = PP_READ;
-    if(direction != dir)
+    if(st->direction != dir)
     {
         arch_usleep(100);
-        direction = dir;
+        st->direction = dir;
     }
 }
 
-static int pp_write(CBM_FILE fd, char c1, char c2)
+static int pp_write(transfer_state *st, char c1, char c2)
 {
+    CBM_FILE fd = st->fd_cbm;
                                                                         SETSTATEDEBUG((void)0);
-    pp_check_direction(PP_WRITE);
+    pp_check_direction(st, PP_WRITE);
                                                                         SETSTATEDEBUG((void)0);
 #ifndef USE_CBM_IEC_WAIT
     while(!cbm_iec_get(fd, IEC_DATA));
@@ -78,24 +83,25 @@ static int pp_write(CBM_FILE fd, char c1, char c2)
 }
 
 /* write_n redirects USB writes to the external reader if required */
-static void write_n(const unsigned char *data, int size) 
+static void write_n(transfer_state *st, const unsigned char *data, int size) 
 {
     int i;
 
-    if (opencbm_plugin_pp_dc_write_n)
+    if (st->opencbm_plugin_pp_dc_write_n)
     {
-        opencbm_plugin_pp_dc_write_n(fd_cbm, data, size);
+        st->opencbm_plugin_pp_dc_write_n(st->fd_cbm, data, size);
         return;
     }
 
     for(i=0;i<size/2;i++,data+=2)
-	pp_write(fd_cbm, data[0], data[1]);
+	pp_write(st, data[0], data[1]);
 }
 
-static int pp_read(CBM_FILE fd, unsigned char *c1, unsigned char *c2)
+static int pp_read(transfer_state *st, unsigned char *c1, unsigned char *c2)
 {
+    CBM_FILE fd = st->fd_cbm;
                                                                         SETSTATEDEBUG((void)0);
-    pp_check_direction(PP_READ);
+    pp_check_direction(st, PP_READ);
                                                                         SETSTATEDEBUG((void)0);
 #ifndef USE_CBM_IEC_WAIT
     while(!cbm_iec_get(fd, IEC_DATA));
@@ -123,59 +129,101 @@ static int pp_read(CBM_FILE fd, unsigned char *c1, unsigned char *c2)
 }
 
 /* read_n redirects USB reads to the external reader if required */
-static void read_n(unsigned char *data, int size) 
+static void read_n(transfer_state *st, unsigned char *data, int size) 
 {
     int i;
 
-    if (opencbm_plugin_pp_dc_read_n)
+    if (st->opencbm_plugin_pp_dc_read_n)
     {
-        opencbm_plugin_pp_dc_read_n(fd_cbm, data, size);
+        st->opencbm_plugin_pp_dc_read_n(st->fd_cbm, data, size);
         return;
     }
 
     for(i=0;i<size/2;i++,data+=2)
-	pp_read(fd_cbm, data, data+1);
+	pp_read(st, data, data+1);
 }
 
-static int read_block(unsigned char tr, unsigned char se, unsigned char *block)
+static int read_block(void *state, unsigned char tr, unsigned char se, unsigned char *block)
 {
+    transfer_state *st = state;
     unsigned char status[2];
                                                                         SETSTATEDEBUG((void)0);
+    if (st->opencbm_plugin_pp_dc_write_read_n)
+    {
+        /* send the request and fetch status and block in one exchange;
+         * the adapter waits for the drive, so no delay is needed here */
+        unsigned char request[2];
+        unsigned char response[2 + BLOCKSIZE];
+
+        request[0] = tr; request[1] = se;
+        if (st->opencbm_plugin_pp_dc_write_read_n(st->fd_cbm, request, 2, response, sizeof(response), 1) != 1)
+        {
+            return -1;
+        }
+        memcpy(block, response + 2, BLOCKSIZE);
+        return response[1];
+    }
+
 
     status[0] = tr; status[1] = se;
-    write_n(status, 2);
+    write_n(st, status, 2);
 
 #ifndef USE_CBM_IEC_WAIT    
     arch_usleep(20000);
 #endif
                                                                         SETSTATEDEBUG((void)0);
-    read_n(status, 2);
+    read_n(st, status, 2);
 
                                                                         SETSTATEDEBUG(DebugByteCount=0);
-    read_n(block, BLOCKSIZE);
+    read_n(st, block, BLOCKSIZE);
                                                                         SETSTATEDEBUG(DebugByteCount=-1);
 
                                                                         SETSTATEDEBUG((void)0);
     return status[1];
 }
 
-static int write_block(unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
+static int write_block(void *state, unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
 {
+    transfer_state *st = state;
     int i = 0;
     unsigned char status[2];
 
                                                                         SETSTATEDEBUG((void)0);
+    if (st->opencbm_plugin_pp_dc_write_read_n && size <= GCRBUFSIZE)
+    {
+        /* send the request and the data as one transfer, fetch the status */
+        unsigned char request[2 + 2 + GCRBUFSIZE];
+        unsigned char response[2];
+        int n;
+
+        request[0] = tr; request[1] = se;
+        /* send first byte twice if length is odd, as below */
+        n = 2;
+        if(size % 2) {
+            request[n++] = blk[0];
+            request[n++] = blk[1];
+            i = 1;
+        }
+        memcpy(request + n, blk + i, size - i);
+        n += size - i;
+        if (st->opencbm_plugin_pp_dc_write_read_n(st->fd_cbm, request, n, response, sizeof(response), 1) != 1)
+        {
+            return -1;
+        }
+        return response[1];
+    }
+
     status[0] = tr; status[1] = se;
-    write_n(status, 2);
+    write_n(st, status, 2);
 
                                                                         SETSTATEDEBUG((void)0);
     /* send first byte twice if length is odd */
     if(size % 2) {
-        write_n(blk, 2);
+        write_n(st, blk, 2);
         i = 1;
     }
                                                                         SETSTATEDEBUG(DebugByteCount=0);
-    write_n(blk+i, size-i);
+    write_n(st, blk+i, size-i);
 
                                                                         SETSTATEDEBUG(DebugByteCount=-1);
 #ifndef USE_CBM_IEC_WAIT    
@@ -185,26 +233,30 @@ static int write_block(unsigned char tr, unsigned char se, const unsigned char *
 #endif
 
                                                                         SETSTATEDEBUG((void)0);
-    read_n(status, 2);
+    read_n(st, status, 2);
 
                                                                         SETSTATEDEBUG((void)0);
     return status[1];
 }
 
-static int open_disk(CBM_FILE fd, d64copy_settings *settings,
+static int open_disk(void *state, CBM_FILE fd, d64copy_settings *settings,
                      const void *arg, int for_writing,
                      turbo_start start, d64copy_message_cb message_cb)
 {
+    transfer_state *st = state;
     unsigned char d = (unsigned char)(ULONG_PTR)arg;
     const unsigned char *drive_prog;
     int prog_size;
 
-    fd_cbm    = fd;
-    two_sided = settings->two_sided;
+    st->fd_cbm    = fd;
+    st->two_sided = settings->two_sided;
+    st->direction = PP_READ;
 
-    opencbm_plugin_pp_dc_read_n = cbm_get_plugin_function_address("opencbm_plugin_pp_dc_read_n");
+    st->opencbm_plugin_pp_dc_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_pp_dc_read_n");
 
-    opencbm_plugin_pp_dc_write_n = cbm_get_plugin_function_address("opencbm_plugin_pp_dc_write_n");
+    st->opencbm_plugin_pp_dc_write_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_pp_dc_write_n");
+
+    st->opencbm_plugin_pp_dc_write_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_pp_dc_write_read_n");
 
     if(settings->drive_type != cbm_dt_cbm1541)
     {
@@ -219,46 +271,44 @@ static int open_disk(CBM_FILE fd, d64copy_settings *settings,
 
                                                                         SETSTATEDEBUG((void)0);
     /* make sure the XP1541 portion of the cable is in input mode */
-    cbm_pp_read(fd_cbm);
+    cbm_pp_read(st->fd_cbm);
 
                                                                         SETSTATEDEBUG((void)0);
-    cbm_upload(fd_cbm, d, 0x700, drive_prog, prog_size);
+    cbm_upload(st->fd_cbm, d, 0x700, drive_prog, prog_size);
                                                                         SETSTATEDEBUG((void)0);
     start(fd, d);
                                                                         SETSTATEDEBUG((void)0);
-    pp_check_direction(PP_READ);
+    pp_check_direction(st, PP_READ);
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_set(fd_cbm, IEC_CLOCK);
+    cbm_iec_set(st->fd_cbm, IEC_CLOCK);
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_wait(fd_cbm, IEC_DATA, 1);
+    cbm_iec_wait(st->fd_cbm, IEC_DATA, 1);
                                                                         SETSTATEDEBUG((void)0);
     return 0;
 }
 
-static void close_disk(void)
+static void close_disk(void *state)
 {
+    transfer_state *st = state;
                                                                         SETSTATEDEBUG((void)0);
-    pp_write(fd_cbm, 0, 0);
+    pp_write(st, 0, 0);
     arch_usleep(100);
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_wait(fd_cbm, IEC_DATA, 0);
+    cbm_iec_wait(st->fd_cbm, IEC_DATA, 0);
 
     /* make sure the XP1541 portion of the cable is in input mode */
                                                                         SETSTATEDEBUG((void)0);
-    cbm_pp_read(fd_cbm);
+    cbm_pp_read(st->fd_cbm);
                                                                         SETSTATEDEBUG((void)0);
-
-    opencbm_plugin_pp_dc_read_n = NULL;
-
-    opencbm_plugin_pp_dc_write_n = NULL;
 }
 
-static int send_track_map(unsigned char tr, const char *trackmap, unsigned char count)
+static int send_track_map(void *state, unsigned char tr, const char *trackmap, unsigned char count)
 {
+    transfer_state *st = state;
     int i, size;
     unsigned char *data;
 
-    size = d64copy_sector_count(two_sided, tr);
+    size = d64copy_sector_count(st->two_sided, tr);
     data = malloc(2+2*size);
 
     data[0] = tr;
@@ -268,29 +318,109 @@ static int send_track_map(unsigned char tr, const char *trackmap, unsigned char
     for(i = 0; i < size; i++)
 	data[2+2*i] = data[2+2*i+1] = !NEED_SECTOR(trackmap[i]);
     
-    write_n(data, 2*size+2);
+    write_n(st, data, 2*size+2);
     free(data);
                                                                         SETSTATEDEBUG((void)0);
     return 0;
 }
 
-static int read_gcr_block(unsigned char *se, unsigned char *gcrbuf)
+static int read_gcr_block(void *state, unsigned char *se, unsigned char *gcrbuf)
 {
+    transfer_state *st = state;
     unsigned char s[2];
                                                                         SETSTATEDEBUG((void)0);
-    read_n(s, 2);
+    read_n(st, s, 2);
     *se = s[1];
                                                                         SETSTATEDEBUG((void)0);
-    read_n(s, 2);
+    read_n(st, s, 2);
 
     if(s[1]) {
         return s[1];
     }
                                                                         SETSTATEDEBUG(DebugByteCount=0);
-    read_n(gcrbuf, GCRBUFSIZE);
+    read_n(st, gcrbuf, GCRBUFSIZE);
+                                                                        SETSTATEDEBUG(DebugByteCount=-1);
+
+                                                                        SETSTATEDEBUG((void)0);
+    return 0;
+}
+
+static int read_track(void *state, unsigned char tr, const unsigned char *sectors, int count, unsigned char *blocks, int *results)
+{
+    transfer_state *st = state;
+    unsigned char request[TRACK_REQUEST_SIZE];
+    unsigned char response[MAX_SECTORS * (2 + BLOCKSIZE)];
+    int i, size;
+
+    if(count < 1 || count > MAX_SECTORS) {
+        return 1;
+    }
+
+    /* the drive sends status and data of all sectors in a row */
+    size = d64copy_track_request(request, tr, sectors, count);
+                                                                        SETSTATEDEBUG((void)0);
+    if (st->opencbm_plugin_pp_dc_write_read_n)
+    {
+        if (st->opencbm_plugin_pp_dc_write_read_n(st->fd_cbm, request, size, response, count * (2 + BLOCKSIZE), 1) != 1)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        write_n(st, request, size);
+#ifndef USE_CBM_IEC_WAIT
+        arch_usleep(20000);
+#endif
+                                                                        SETSTATEDEBUG(DebugByteCount=0);
+        read_n(st, response, count * (2 + BLOCKSIZE));
                                                                         SETSTATEDEBUG(DebugByteCount=-1);
+    }
+
+    for(i = 0; i < count; i++) {
+        results[i] = response[i * (2 + BLOCKSIZE) + 1];
+        memcpy(blocks + i * BLOCKSIZE, response + i * (2 + BLOCKSIZE) + 2, BLOCKSIZE);
+    }
+    return 0;
+}
 
+static int write_track(void *state, unsigned char tr, const unsigned char *sectors, int count, const unsigned char *blocks, int *results)
+{
+    transfer_state *st = state;
+    unsigned char request[TRACK_REQUEST_SIZE + MAX_SECTORS * BLOCKSIZE];
+    unsigned char response[MAX_SECTORS * 2];
+    int i, size;
+
+    if(count < 1 || count > MAX_SECTORS) {
+        return 1;
+    }
+
+    /* the drive receives all blocks, and reports their states at the end */
+    size = d64copy_track_request(request, tr, sectors, count);
+    memcpy(request + size, blocks, count * BLOCKSIZE);
+    size += count * BLOCKSIZE;
                                                                         SETSTATEDEBUG((void)0);
+    if (st->opencbm_plugin_pp_dc_write_read_n)
+    {
+        if (st->opencbm_plugin_pp_dc_write_read_n(st->fd_cbm, request, size, response, count * 2, 1) != 1)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+                                                                        SETSTATEDEBUG(DebugByteCount=0);
+        write_n(st, request, size);
+                                                                        SETSTATEDEBUG(DebugByteCount=-1);
+#ifndef USE_CBM_IEC_WAIT
+        arch_usleep(20000);
+#endif
+        read_n(st, response, count * 2);
+    }
+
+    for(i = 0; i < count; i++) {
+        results[i] = response[i * 2 + 1];
+    }
     return 0;
 }
 
@@ -12,21 +12,25 @@
 #include "d64copy_int.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "arch.h"
 
 #include "opencbm-plugin.h"
 
-static opencbm_plugin_s2_read_n_t * opencbm_plugin_s2_read_n = NULL;
-
-static opencbm_plugin_s2_write_n_t * opencbm_plugin_s2_write_n = NULL;
-
 static const unsigned char s2_drive_prog[] = {
 #include "s2.inc"
 };
 
-static CBM_FILE fd_cbm;
-static int two_sided;
+/* the state of one transfer */
+typedef struct
+{
+    CBM_FILE fd_cbm;
+    int two_sided;
+    opencbm_plugin_s2_read_n_t * opencbm_plugin_s2_read_n;
+    opencbm_plugin_s2_write_n_t * opencbm_plugin_s2_write_n;
+    opencbm_plugin_s2_write_read_n_t * opencbm_plugin_s2_write_read_n;
+} transfer_state;
 
 static int s2_read_byte(CBM_FILE fd, unsigned char *c)
 {
@@ -90,18 +94,18 @@ static int s2_write_byte_nohs(CBM_FILE fd, unsigned char c)
 }
 
 /* read_n redirects USB reads to the external reader if required */
-static void read_n(unsigned char *data, int size) 
+static void read_n(transfer_state *st, unsigned char *data, int size) 
 {
     int i;
 
-    if (opencbm_plugin_s2_read_n)
+    if (st->opencbm_plugin_s2_read_n)
     {
-        opencbm_plugin_s2_read_n(fd_cbm, data, size);
+        st->opencbm_plugin_s2_read_n(st->fd_cbm, data, size);
         return;
     }
 
     for(i=0;i<size;i++)
-	s2_read_byte(fd_cbm, data++);
+	s2_read_byte(st->fd_cbm, data++);
 }
 
 static int s2_write_byte(CBM_FILE fd, unsigned char c)
@@ -121,49 +125,85 @@ static int s2_write_byte(CBM_FILE fd, unsigned char c)
 }
 
 /* write_n redirects USB writes to the external reader if required */
-static void write_n(const unsigned char *data, int size) 
+static void write_n(transfer_state *st, const unsigned char *data, int size) 
 {
     int i;
 
-    if (opencbm_plugin_s2_write_n)
+    if (st->opencbm_plugin_s2_write_n)
     {
-        opencbm_plugin_s2_write_n(fd_cbm, data, size);
+        st->opencbm_plugin_s2_write_n(st->fd_cbm, data, size);
         return;
     }
 
     for(i=0;i<size;i++)
-	s2_write_byte(fd_cbm, *data++);
+	s2_write_byte(st->fd_cbm, *data++);
 }
 
-static int read_block(unsigned char tr, unsigned char se, unsigned char *block)
+static int read_block(void *state, unsigned char tr, unsigned char se, unsigned char *block)
 {
+    transfer_state *st = state;
     unsigned char status;
 
+    if (st->opencbm_plugin_s2_write_read_n)
+    {
+        /* send the request and fetch status and block in one exchange;
+         * the adapter waits for the drive, so no delay is needed here */
+        unsigned char request[2];
+        unsigned char response[1 + BLOCKSIZE];
+
+        request[0] = tr; request[1] = se;
+        if (st->opencbm_plugin_s2_write_read_n(st->fd_cbm, request, 2, response, sizeof(response), 1) != 1)
+        {
+            return -1;
+        }
+        memcpy(block, response + 1, BLOCKSIZE);
+        return response[0];
+    }
+
                                                                         SETSTATEDEBUG((void)0);
-    write_n(&tr, 1);
+    write_n(st, &tr, 1);
                                                                         SETSTATEDEBUG((void)0);
-    write_n(&se, 1);
+    write_n(st, &se, 1);
 #ifndef USE_CBM_IEC_WAIT
     arch_usleep(20000);
 #endif
                                                                         SETSTATEDEBUG((void)0);
-    read_n(&status, 1);
+    read_n(st, &status, 1);
                                                                         SETSTATEDEBUG(DebugByteCount=0);
-    read_n(block, BLOCKSIZE);
+    read_n(st, block, BLOCKSIZE);
                                                                         SETSTATEDEBUG(DebugByteCount=-1);
 
     return status;
 }
 
-static int write_block(unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
+static int write_block(void *state, unsigned char tr, unsigned char se, const unsigned char *blk, int size, int read_status)
 {
+    transfer_state *st = state;
     unsigned char status;
+
+    if (st->opencbm_plugin_s2_write_read_n && size <= GCRBUFSIZE)
+    {
+        /* send the request and the data as one transfer, fetch the status */
+        unsigned char request[2 + GCRBUFSIZE];
+        unsigned char response[1];
+        int n;
+
+        request[0] = tr; request[1] = se;
+        memcpy(request + 2, blk, size);
+        n = 2 + size;
+        if (st->opencbm_plugin_s2_write_read_n(st->fd_cbm, request, n, response, sizeof(response), 1) != 1)
+        {
+            return -1;
+        }
+        return response[0];
+    }
+
                                                                         SETSTATEDEBUG((void)0);
-    write_n(&tr, 1);
+    write_n(st, &tr, 1);
                                                                         SETSTATEDEBUG((void)0);
-    write_n(&se, 1);
+    write_n(st, &se, 1);
                                                                         SETSTATEDEBUG(DebugByteCount=0);
-    write_n(blk, size);
+    write_n(st, blk, size);
                                                                         SETSTATEDEBUG(DebugByteCount=-1);
 #ifndef USE_CBM_IEC_WAIT
     if(size == BLOCKSIZE) {
@@ -171,68 +211,69 @@ static int write_block(unsigned char tr, unsigned char se, const unsigned char *
     }
 #endif
                                                                         SETSTATEDEBUG((void)0);
-    read_n(&status, 1);
+    read_n(st, &status, 1);
                                                                         SETSTATEDEBUG((void)0);
     return status;
 }
 
-static int open_disk(CBM_FILE fd, d64copy_settings *settings,
+static int open_disk(void *state, CBM_FILE fd, d64copy_settings *settings,
                      const void *arg, int for_writing,
                      turbo_start start, d64copy_message_cb message_cb)
 {
+    transfer_state *st = state;
     unsigned char d = (unsigned char)(ULONG_PTR)arg;
 
-    fd_cbm = fd;
-    two_sided = settings->two_sided;
+    st->fd_cbm = fd;
+    st->two_sided = settings->two_sided;
 
-    opencbm_plugin_s2_read_n = cbm_get_plugin_function_address("opencbm_plugin_s2_read_n");
+    st->opencbm_plugin_s2_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s2_read_n");
 
-    opencbm_plugin_s2_write_n = cbm_get_plugin_function_address("opencbm_plugin_s2_write_n");
+    st->opencbm_plugin_s2_write_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s2_write_n");
+
+    st->opencbm_plugin_s2_write_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s2_write_read_n");
 
                                                                         SETSTATEDEBUG((void)0);
-    cbm_upload(fd_cbm, d, 0x700, s2_drive_prog, sizeof(s2_drive_prog));
+    cbm_upload(st->fd_cbm, d, 0x700, s2_drive_prog, sizeof(s2_drive_prog));
                                                                         SETSTATEDEBUG((void)0);
     start(fd, d);
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_release(fd_cbm, IEC_CLOCK);
+    cbm_iec_release(st->fd_cbm, IEC_CLOCK);
                                                                         SETSTATEDEBUG((void)0);
-    while(!cbm_iec_get(fd_cbm, IEC_CLOCK));
+    while(!cbm_iec_get(st->fd_cbm, IEC_CLOCK));
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_set(fd_cbm, IEC_ATN);
+    cbm_iec_set(st->fd_cbm, IEC_ATN);
     arch_usleep(20000);
     
                                                                         SETSTATEDEBUG((void)0);
     return 0;
 }
 
-static void close_disk(void)
+static void close_disk(void *state)
 {
+    transfer_state *st = state;
                                                                         SETSTATEDEBUG((void)0);
-    s2_write_byte(fd_cbm, 0);
+    s2_write_byte(st->fd_cbm, 0);
                                                                         SETSTATEDEBUG((void)0);
-    s2_write_byte_nohs(fd_cbm, 0);
+    s2_write_byte_nohs(st->fd_cbm, 0);
     arch_usleep(100);
                                                                         SETSTATEDEBUG(DebugBitCount=-1);
-    cbm_iec_release(fd_cbm, IEC_DATA);
+    cbm_iec_release(st->fd_cbm, IEC_DATA);
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_release(fd_cbm, IEC_ATN);
+    cbm_iec_release(st->fd_cbm, IEC_ATN);
                                                                         SETSTATEDEBUG((void)0);
-    cbm_iec_set(fd_cbm, IEC_CLOCK);
+    cbm_iec_set(st->fd_cbm, IEC_CLOCK);
                                                                         SETSTATEDEBUG((void)0);
-
-    opencbm_plugin_s2_read_n = NULL;
-
-    opencbm_plugin_s2_write_n = NULL;
 }
 
-static int send_track_map(unsigned char tr, const char *trackmap, unsigned char count)
+static int send_track_map(void *state, unsigned char tr, const char *trackmap, unsigned char count)
 {
+    transfer_state *st = state;
     int i;
     int size;
     unsigned char *data;
 
                                                                         SETSTATEDEBUG((void)0);
-    size = d64copy_sector_count(two_sided, tr);
+    size = d64copy_sector_count(st->two_sided, tr);
     data = malloc(2+size);
 
     data[0] = tr;
@@ -242,29 +283,109 @@ static int send_track_map(unsigned char tr, const char *trackmap, unsigned char
     for(i = 0; i < size; i++)
 	data[2+i] = !NEED_SECTOR(trackmap[i]);
     
-    write_n(data, size+2);
+    write_n(st, data, size+2);
     free(data);
                                                                         SETSTATEDEBUG((void)0);
     return 0;
 }
 
-static int read_gcr_block(unsigned char *se, unsigned char *gcrbuf)
+static int read_gcr_block(void *state, unsigned char *se, unsigned char *gcrbuf)
 {
-    unsigned char s;
+    transfer_state *st = state;
+    unsigned char s[2];
 
                                                                         SETSTATEDEBUG((void)0);
-    read_n(&s, 1);
-    *se = s;
+    /* sector number and status in one go */
+    read_n(st, s, 2);
+    *se = s[0];
                                                                         SETSTATEDEBUG((void)0);
-    read_n(&s, 1);
 
-    if(s) {
-        return s;
+    if(s[1]) {
+        return s[1];
     }
                                                                         SETSTATEDEBUG(DebugByteCount=0);
-    read_n(gcrbuf, GCRBUFSIZE);									
+    read_n(st, gcrbuf, GCRBUFSIZE);									
                                                                         SETSTATEDEBUG(DebugByteCount=-1);
     return 0;
 }
 
+static int read_track(void *state, unsigned char tr, const unsigned char *sectors, int count, unsigned char *blocks, int *results)
+{
+    transfer_state *st = state;
+    unsigned char request[TRACK_REQUEST_SIZE];
+    unsigned char response[MAX_SECTORS * (1 + BLOCKSIZE)];
+    int i, size;
+
+    if(count < 1 || count > MAX_SECTORS) {
+        return 1;
+    }
+
+    /* the drive sends status and data of all sectors in a row */
+    size = d64copy_track_request(request, tr, sectors, count);
+                                                                        SETSTATEDEBUG((void)0);
+    if (st->opencbm_plugin_s2_write_read_n)
+    {
+        if (st->opencbm_plugin_s2_write_read_n(st->fd_cbm, request, size, response, count * (1 + BLOCKSIZE), 1) != 1)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        write_n(st, request, size);
+#ifndef USE_CBM_IEC_WAIT
+        arch_usleep(20000);
+#endif
+                                                                        SETSTATEDEBUG(DebugByteCount=0);
+        read_n(st, response, count * (1 + BLOCKSIZE));
+                                                                        SETSTATEDEBUG(DebugByteCount=-1);
+    }
+
+    for(i = 0; i < count; i++) {
+        results[i] = response[i * (1 + BLOCKSIZE)];
+        memcpy(blocks + i * BLOCKSIZE, response + i * (1 + BLOCKSIZE) + 1, BLOCKSIZE);
+    }
+    return 0;
+}
+
+static int write_track(void *state, unsigned char tr, const unsigned char *sectors, int count, const unsigned char *blocks, int *results)
+{
+    transfer_state *st = state;
+    unsigned char request[TRACK_REQUEST_SIZE + MAX_SECTORS * BLOCKSIZE];
+    unsigned char response[MAX_SECTORS * 1];
+    int i, size;
+
+    if(count < 1 || count > MAX_SECTORS) {
+        return 1;
+    }
+
+    /* the drive receives all blocks, and reports their states at the end */
+    size = d64copy_track_request(request, tr, sectors, count);
+    memcpy(request + size, blocks, count * BLOCKSIZE);
+    size += count * BLOCKSIZE;
+                                                                        SETSTATEDEBUG((void)0);
+    if (st->opencbm_plugin_s2_write_read_n)
+    {
+        if (st->opencbm_plugin_s2_write_read_n(st->fd_cbm, request, size, response, count * 1, 1) != 1)
+        {
+            return 1;
+        }
+    }
+    else
+    {
+                                                                        SETSTATEDEBUG(DebugByteCount=0);
+        write_n(st, request, size);
+                                                                        SETSTATEDEBUG(DebugByteCount=-1);
+#ifndef USE_CBM_IEC_WAIT
+        arch_usleep(20000);
+#endif
+        read_n(st, response, count * 1);
+    }
+
+    for(i = 0; i < count; i++) {
+        results[i] = response[i];
+    }
+    return 0;
+}
+
 DECLARE_TRANSFER_FUNCS_EX(s2_transfer, 1, 1);
@@ -18,7 +18,13 @@
 
 static imgcopy_settings *fs_settings;
 
-static FILE *the_file;
+/*
+ * The image is mapped into memory as a whole. When writing, the mapping
+ * always includes room for the error map behind the blocks; the file is
+ * cut back to the blocks alone in close_disk() if there are no errors.
+ */
+static arch_filemap_t *the_map;
+static unsigned char *image;
 static char *error_map;
 static int block_count;
 
@@ -40,9 +46,12 @@ static int block_offset(int tr, int se)
 
 static int read_block(unsigned char tr, unsigned char se, unsigned char *block)
 {
-    if(fseek(the_file, block_offset(tr, se), SEEK_SET) == 0)
+    int ofs = block_offset(tr, se);
+
+    if(ofs >= 0 && ofs + BLOCKSIZE <= block_count * BLOCKSIZE)
     {
-        return fread(block, BLOCKSIZE, 1, the_file) != 1;
+        memcpy(block, image + ofs, BLOCKSIZE);
+        return 0;
     }
     return 1;
 }
@@ -71,10 +80,11 @@ static int write_block(unsigned char tr, unsigned char se, const unsigned char *
     atom_execute = 1;
 
     ofs = block_offset(tr, se);
-    if(fseek(the_file, ofs, SEEK_SET) == 0)
+    if(ofs >= 0 && ofs + size <= block_count * BLOCKSIZE)
     {
         error_map[ofs / BLOCKSIZE] = (char) ((read_status == 0) ? 1 : read_status);
-        ret = fwrite(blk, size, 1, the_file) != 1;
+        memcpy(image + ofs, blk, size);
+        ret = 0;
     }
     else
     {
@@ -97,7 +107,8 @@ static int open_disk(CBM_FILE fd, imgcopy_settings *settings,
 
     //printf("open imagefile ...\n");
 
-    the_file = NULL;
+    the_map = NULL;
+    error_map = NULL;
     fs_settings = settings;
     //block_count = 0;
 
@@ -151,8 +162,9 @@ static int open_disk(CBM_FILE fd, imgcopy_settings *settings,
         {
             if(is_image)
             {
-                the_file = fopen(name, "rb");
-                if(the_file == NULL)
+                the_map = arch_filemap_open(name, ARCH_FILEMAP_READ,
+                                            filesize, &image);
+                if(the_map == NULL)
                 {
                     message_cb(0, "could not open %s", name);
                 }
@@ -183,69 +195,35 @@ static int open_disk(CBM_FILE fd, imgcopy_settings *settings,
     }
     else
     {
-        the_file = fopen(name, is_image ? "r+b" : "wb");
-        if(the_file)
+        if(!stat_ok)
         {
-            /* check whether we must resize or create an image file */
-            int new_tr;
-
-            new_tr = settings->max_tracks;
-
-            /* always use maximum size for error map */
-            error_map = calloc(block_count, 1);
-            if(!error_map)
-            {
-                message_cb(0, "no memory for error map");
-                fclose(the_file);
-                if(!is_image)
-                {
-                    arch_unlink(name);
-                }
-                return 1;
-            }
-
-            if(is_image)
-            {
-                if(error_info)
-                {
-                    if(fseek(the_file, block_count * BLOCKSIZE, SEEK_SET) != 0 ||
-                       fread(error_map, block_count, 1, the_file) != 1)
-                    {
-                        message_cb(0, "%s: could not read error map", name);
-                        fclose(the_file);
-                        return 1;
-                    }
-                }
-                if(fseek(the_file, block_count * BLOCKSIZE, SEEK_SET) != 0)
-                {
-                    message_cb(0, "%s: could not seek to end of file", name);
-                    fclose(the_file);
-                    return 1;
-                }
-            }
+            /* grow image */
+            message_cb(1, "growing image file to %d blocks", block_count);
+        }
 
-            if(new_tr > tr)
+        /* map the blocks plus the error map, a new file starts out empty */
+        the_map = arch_filemap_open(name,
+                                    is_image ? ARCH_FILEMAP_WRITE : ARCH_FILEMAP_CREATE,
+                                    block_count * (BLOCKSIZE + 1), &image);
+        if(the_map)
+        {
+            error_map = (char *) image + block_count * BLOCKSIZE;
+            if(!error_info)
             {
-                /* grow image */
-                message_cb(1, "growing image file to %d blocks", block_count);
-
-                if (arch_ftruncate(arch_fileno(the_file), block_count * BLOCKSIZE) != 0)
-                {
-                    message_cb(0, "%s: could not extend image file", name);
-                    fclose(the_file);
-                    if(!is_image)
-                        arch_unlink(name);
-                    return 1;
-                }
+                memset(error_map, 0, block_count);
             }
         }
         else
         {
             message_cb(0, "could not open %s", name);
+            if(!is_image)
+            {
+                arch_unlink(name);
+            }
         }
     }
     message_cb(2, "open imagefile ok. %s", name);
-    return the_file == NULL;
+    return the_map == NULL;
 }
 
 static void close_disk(void)
@@ -256,7 +234,7 @@ static void close_disk(void)
      * redone before closing the disk 
      */
 
-    if (the_file && atom_execute)
+    if (the_map && error_map && atom_execute)
     {
         atom_execute = 0;
         write_block(atom_tr, atom_se, atom_blk, atom_size, atom_read_status);
@@ -284,31 +262,15 @@ static void close_disk(void)
         }
     }
 
-    if(the_file)
+    if(the_map)
     {
-        if(has_errors)
-        {
-            if(fseek(the_file, block_count * BLOCKSIZE, SEEK_SET) == 0)
-            {
-                fwrite(error_map, block_count, 1, the_file);
-            }
-        } 
-        else
-        {
-            arch_ftruncate(arch_fileno(the_file), block_count * BLOCKSIZE);
-        }
-    }
-
-    if(error_map)
-    {
-        free(error_map);
+        /* the error map is already in place, only cut it off if not wanted */
+        arch_filemap_close(the_map, has_errors ?
+                           block_count * (BLOCKSIZE + 1) : block_count * BLOCKSIZE);
+        the_map = NULL;
+        image = NULL;
         error_map = NULL;
     }
-    if(the_file)
-    {
-        fclose(the_file);
-        the_file = NULL;
-    }
 }
 
 DECLARE_TRANSFER_FUNCS(fs_transfer, 0, 0);
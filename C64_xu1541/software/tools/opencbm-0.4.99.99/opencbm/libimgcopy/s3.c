@@ -139,8 +139,8 @@ static int open_disk(CBM_FILE fd, imgcopy_settings *settings,
     fd_cbm = fd;
     two_sided = settings->two_sided;
 
-    opencbm_plugin_s3_read_n = cbm_get_plugin_function_address("opencbm_plugin_s3_read_n");
-    opencbm_plugin_s3_write_n = cbm_get_plugin_function_address("opencbm_plugin_s3_write_n");
+    opencbm_plugin_s3_read_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s3_read_n");
+    opencbm_plugin_s3_write_n = cbm_get_plugin_function_address_ex(fd, "opencbm_plugin_s3_write_n");
 
     switch(settings->drive_type)
     {
@@ -8,6 +8,7 @@
  * 2 of the License, or (at your option) any later version.
  */
 #include "xum1541.h"
+#include "gcr.h"
 
 /*
  * Basic inline IO functions where each byte is processed as it is
@@ -23,6 +24,21 @@ typedef void (*Write2Fn_t)(uint8_t *data);
 static uint16_t usbDataLen;
 static uint8_t usbDataDir = XUM_DATA_DIR_NONE;
 
+/*
+ * Bytes for the host that arrived while both IN endpoint banks were full.
+ * The drive side keeps running while the host collects the packets, the
+ * bytes are moved into the endpoint as soon as a bank is free again.
+ * Head == tail means the ring is empty.
+ */
+#define USB_RING_MASK   (XUM_USB_RING_SIZE - 1)
+static uint8_t usbRing[XUM_USB_RING_SIZE];
+static uint8_t usbRingHead, usbRingTail;
+
+#ifdef DEBUG
+// Number of polls waiting for a free bank with a full ring, per transfer
+static uint16_t usbStallCount;
+#endif
+
 // Are we in the middle of a command sequence (XUM1541_INIT .. SHUTDOWN)?
 #define XUM1541_CMD_IN_PROGRESS 0x80
 static uint8_t cmdSeqInProgress;
@@ -99,6 +115,10 @@ usbInitIo(uint16_t len, uint8_t dir)
 
     usbDataLen = len;
     usbDataDir = dir;
+    usbRingHead = usbRingTail = 0;
+#ifdef DEBUG
+    usbStallCount = 0;
+#endif
 
     /*
      * Wait until endpoint is ready before continuing. It is critical
@@ -110,11 +130,37 @@ usbInitIo(uint16_t len, uint8_t dir)
         ;
 }
 
+/*
+ * Move bytes from the ring into the IN endpoint while there is a free bank,
+ * but at most max of them, so the drive side is not held up for long.
+ * A full bank is handed to the host right away without waiting for it.
+ */
+static inline void
+usbRingDrain(uint8_t max)
+{
+    while (usbRingTail != usbRingHead && max-- != 0 &&
+        Endpoint_IsReadWriteAllowed()) {
+        Endpoint_Write_Byte(usbRing[usbRingTail]);
+        usbRingTail = (usbRingTail + 1) & USB_RING_MASK;
+        if (!Endpoint_IsReadWriteAllowed())
+            Endpoint_ClearIN();
+    }
+}
+
 void
 usbIoDone(void)
 {
     // Finalize any outstanding transactions
     if (usbDataDir == ENDPOINT_DIR_IN) {
+        // Hand the rest of the ring to the host, unless we are aborting.
+        while (usbRingTail != usbRingHead && !doDeviceReset)
+            usbRingDrain(XUM_USB_RING_SIZE);
+        usbRingHead = usbRingTail = 0;
+#ifdef DEBUG
+        if (usbStallCount != 0)
+            DEBUGF(DBG_INFO, "stall %u\n", usbStallCount);
+#endif
+
         /*
          * If the transfer left an incomplete endpoint (mod endpoint size)
          * or possibly never transferred any data (error or timeout case),
@@ -157,16 +203,32 @@ usbSendByte(uint8_t data)
     }
 #endif
 
-    // Write data back to the host buffer for USB transfer
-    Endpoint_Write_Byte(data);
-    usbDataLen--;
+    /*
+     * Write data back to the host buffer for USB transfer. If the endpoint
+     * is now full, flush the block to the host. With both banks in use,
+     * we don't wait for the host but queue the byte in the ring instead.
+     * Only once the ring is full, too, there's nothing left but to wait.
+     */
+    if (usbRingHead == usbRingTail && Endpoint_IsReadWriteAllowed()) {
+        Endpoint_Write_Byte(data);
+        if (!Endpoint_IsReadWriteAllowed())
+            Endpoint_ClearIN();
+    } else {
+        uint8_t next = (usbRingHead + 1) & USB_RING_MASK;
 
-    // If the endpoint is now full, flush the block to the host
-    if (!Endpoint_IsReadWriteAllowed()) {
-        Endpoint_ClearIN();
-        while (!Endpoint_IsReadWriteAllowed() && !doDeviceReset)
-            ;
+        while (next == usbRingTail && !doDeviceReset) {
+            usbRingDrain(1);
+#ifdef DEBUG
+            usbStallCount++;
+#endif
+        }
+        usbRing[usbRingHead] = data;
+        usbRingHead = next;
+
+        // Drain faster than we fill so the ring empties again.
+        usbRingDrain(2);
     }
+    usbDataLen--;
 
     // Check if the current command is being aborted by the host
     if (doDeviceReset) {
@@ -274,8 +336,13 @@ ioWrite2Loop(Write2Fn_t writeFn, uint16_t len)
     return 0;
 }
 
+/*
+ * Read a track with the nibbler protocol. If decodeGcr is set, the raw
+ * bytes go through the GCR decoder and only the sectors found are sent
+ * to the host (see XUM1541_NIB_GCR).
+ */
 static uint8_t
-ioReadNibLoop(uint16_t len, bool earlyExit)
+ioReadNibLoop(uint16_t len, bool earlyExit, bool decodeGcr)
 {
     uint16_t i;
     uint8_t data;
@@ -286,6 +353,8 @@ ioReadNibLoop(uint16_t len, bool earlyExit)
 
     suppressNibCmd = false;
     usbInitIo(len, ENDPOINT_DIR_IN);
+    if (decodeGcr)
+        gcr_decode_init(len);
     iec_release(IO_DATA);
 
     /*
@@ -305,8 +374,11 @@ ioReadNibLoop(uint16_t len, bool earlyExit)
             return -1;
         }
 
-        // Send the byte via USB
-        if (usbSendByte(data) != 0)
+        // Send the byte via USB, or what it completed of a sector
+        if (decodeGcr) {
+            if (gcr_decode_byte(data) != 0)
+                break;
+        } else if (usbSendByte(data) != 0)
             break;
 
         // If requested, terminate early on seeing a special marker.
@@ -703,7 +775,11 @@ usbHandleBulk(uint8_t *request, uint8_t *status)
         case XUM1541_NIB:
             nibEarlyExit = (len & XUM1541_NIB_READ_VAR);
             len &= ~XUM1541_NIB_READ_VAR;
-            ioReadNibLoop(len, nibEarlyExit);
+            ioReadNibLoop(len, nibEarlyExit, false);
+            ret = 0;
+            break;
+        case XUM1541_NIB_GCR:
+            ioReadNibLoop(len, false, true);
             ret = 0;
             break;
         case XUM1541_NIB_COMMAND:
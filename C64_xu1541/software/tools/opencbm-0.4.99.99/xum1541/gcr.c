@@ -0,0 +1,259 @@
+/*
+ * GCR decoder for nibbler track reads
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+#include "xum1541.h"
+#include "gcr.h"
+
+/*
+ * Decode the raw bytes of a track as they come in from the drive and
+ * send a record (see XUM1541_NIB_GCR) for each sector found to the host.
+ * The raw stream is byte-aligned after each SYNC, as the 1541 reads it.
+ *
+ * The drive does not wait for us, so the work is spread evenly: every raw
+ * byte completes at most one decoded byte, which is sent right away. This
+ * also means there is no need to buffer a whole sector in our small SRAM.
+ */
+
+// The 5-bit GCR codes and their nybbles, 0xff for invalid codes
+static const uint8_t gcrDecode[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x08, 0x00, 0x01, 0xff, 0x0c, 0x04, 0x05,
+    0xff, 0xff, 0x02, 0x03, 0xff, 0x0f, 0x06, 0x07,
+    0xff, 0x09, 0x0a, 0x0b, 0xff, 0x0d, 0x0e, 0xff,
+};
+
+// First GCR byte after SYNC of a header (0x08) and of a data block (0x07)
+#define GCR_HEADER_START    0x52
+#define GCR_DATA_START      0x55
+
+/*
+ * Raw bytes of a data block still to come after its first decoded byte,
+ * up to the checksum: 258 bytes (0x07, data, checksum) take 323 raw bytes,
+ * 2 of which have been read by then.
+ */
+#define GCR_DATA_REST       (((XUM_GCR_STATUS - XUM_GCR_DATA + 2) * 10 + 7) / 8 - 2)
+
+enum {
+    GCR_SEARCH,     // waiting for the next SYNC
+    GCR_SYNC,       // in a SYNC, the next byte tells what follows
+    GCR_HEADER,     // decoding a sector header
+    GCR_DATA,       // decoding a data block
+};
+
+static uint8_t gcrState;
+static uint8_t gcrPhase;        // position in the current 5-byte group
+static uint8_t gcrCarry;        // bits of the next code from the last byte
+static uint8_t gcrHigh;         // decoded high nybble of the next byte
+static uint8_t gcrInvalid;      // an invalid code was seen in this block
+static uint16_t gcrPos;         // index of the next decoded byte in block
+static uint8_t gcrXor;          // running checksum
+
+// The last header seen, valid until its data block was decoded
+static bool gcrHaveHeader;
+static uint8_t gcrHeader[4];    // track, sector, id2, id1 like the record
+static uint8_t gcrHeaderStatus;
+
+// Sectors already sent without error, they are not sent again
+static uint32_t gcrSectorsOk;
+
+// Raw bytes still to come and output bytes the host still takes
+static uint16_t gcrRawLeft, gcrOutLeft;
+
+void
+gcr_decode_init(uint16_t len)
+{
+    // The drive starts sending right after a SYNC.
+    gcrState = GCR_SYNC;
+    gcrHaveHeader = false;
+    gcrSectorsOk = 0;
+    gcrRawLeft = gcrOutLeft = len;
+}
+
+// Decode a 5-bit code, remember if it was invalid
+static inline uint8_t
+gcr_nybble(uint8_t code)
+{
+    uint8_t n = gcrDecode[code];
+
+    gcrInvalid |= n;
+    return n & 0x0f;
+}
+
+// Start decoding a header or data block with its first raw byte
+static inline void
+gcr_start(uint8_t state, uint8_t data)
+{
+    gcrState = state;
+    gcrPhase = 1;
+    gcrPos = 0;
+    gcrXor = 0;
+    gcrInvalid = 0;
+    gcrHigh = gcr_nybble(data >> 3);
+    gcrCarry = data & 7;
+}
+
+// Handle a decoded header byte
+static void
+gcr_header_byte(uint8_t data)
+{
+    switch (gcrPos) {
+    case 0:
+        if (data != 0x08)
+            gcrState = GCR_SEARCH;
+        break;
+    case 1:
+        gcrXor = data;
+        break;
+    case 2:
+        gcrHeader[XUM_GCR_SECTOR] = data;
+        break;
+    case 3:
+        gcrHeader[XUM_GCR_TRACK] = data;
+        break;
+    case 4:
+        gcrHeader[XUM_GCR_ID2] = data;
+        break;
+    case 5:
+        // The fillers that follow do not matter.
+        gcrHeader[XUM_GCR_ID1] = data;
+        gcrXor ^= gcrHeader[0] ^ gcrHeader[1] ^ gcrHeader[2] ^ data;
+        if (gcrXor != 0 || (gcrInvalid & 0xf0) != 0)
+            gcrHeaderStatus = XUM_GCR_HEADER_CHECKSUM;
+        else
+            gcrHeaderStatus = XUM_GCR_OK;
+
+        // Skip the data block if we sent this sector ok already.
+        gcrHaveHeader = gcrHeaderStatus != XUM_GCR_OK ||
+            gcrHeader[XUM_GCR_SECTOR] >= 32 ||
+            (gcrSectorsOk & (1UL << gcrHeader[XUM_GCR_SECTOR])) == 0;
+        gcrState = GCR_SEARCH;
+        break;
+    }
+}
+
+// Handle a decoded data block byte, return non-zero if sending failed
+static int8_t
+gcr_data_byte(uint8_t data)
+{
+    uint8_t i, status;
+
+    if (gcrPos == 0) {
+        /*
+         * Only start a record if the whole block is still to come from
+         * the drive and the host has room for it. Otherwise, it could
+         * not be completed.
+         */
+        if (data != 0x07 || gcrRawLeft < GCR_DATA_REST ||
+            gcrOutLeft < XUM_GCR_SECTOR_SIZE) {
+            gcrState = GCR_SEARCH;
+            return 0;
+        }
+        gcrOutLeft -= XUM_GCR_SECTOR_SIZE;
+        for (i = 0; i < XUM_GCR_DATA; i++) {
+            if (usbSendByte(gcrHeader[i]) != 0)
+                return -1;
+        }
+        return 0;
+    }
+
+    if (gcrPos <= XUM_GCR_STATUS - XUM_GCR_DATA) {
+        gcrXor ^= data;
+        return usbSendByte(data);
+    }
+
+    // Checksum byte, the block is complete. Ignore the two off bytes.
+    if (gcrHeaderStatus != XUM_GCR_OK)
+        status = gcrHeaderStatus;
+    else if ((gcrInvalid & 0xf0) != 0)
+        status = XUM_GCR_DECODE_ERROR;
+    else if (gcrXor != data)
+        status = XUM_GCR_DATA_CHECKSUM;
+    else
+        status = XUM_GCR_OK;
+    if (status == XUM_GCR_OK && gcrHeader[XUM_GCR_SECTOR] < 32)
+        gcrSectorsOk |= 1UL << gcrHeader[XUM_GCR_SECTOR];
+
+    gcrState = GCR_SEARCH;
+    return usbSendByte(status);
+}
+
+/*
+ * Process one raw byte from the drive. Returns non-zero if sending to the
+ * host failed, e.g. because the command was aborted.
+ */
+int8_t
+gcr_decode_byte(uint8_t data)
+{
+    uint8_t decoded;
+
+    gcrRawLeft--;
+
+    switch (gcrState) {
+    case GCR_SEARCH:
+        if (data == 0xff)
+            gcrState = GCR_SYNC;
+        return 0;
+    case GCR_SYNC:
+        if (data == 0xff)
+            return 0;
+        if (data == GCR_HEADER_START)
+            gcr_start(GCR_HEADER, data);
+        else if (data == GCR_DATA_START && gcrHaveHeader) {
+            // Each header is good for one data block only.
+            gcrHaveHeader = false;
+            gcr_start(GCR_DATA, data);
+        } else
+            gcrState = GCR_SEARCH;
+        return 0;
+    }
+
+    /*
+     * A 5-byte group holds 8 codes, i.e. 4 decoded bytes. The first raw
+     * byte only has the high nybble of the first decoded byte, each of
+     * the others completes one. gcrHigh holds a high nybble decoded from
+     * an earlier raw byte.
+     */
+    switch (gcrPhase) {
+    case 0:
+        gcrHigh = gcr_nybble(data >> 3);
+        gcrCarry = data & 7;
+        gcrPhase = 1;
+        return 0;
+    case 1:
+        decoded = (gcrHigh << 4) | gcr_nybble((gcrCarry << 2) | (data >> 6));
+        gcrHigh = gcr_nybble((data >> 1) & 0x1f);
+        gcrCarry = data & 1;
+        break;
+    case 2:
+        decoded = (gcrHigh << 4) | gcr_nybble((gcrCarry << 4) | (data >> 4));
+        gcrCarry = data & 0x0f;
+        break;
+    case 3:
+        decoded = gcr_nybble((gcrCarry << 1) | (data >> 7)) << 4;
+        decoded |= gcr_nybble((data >> 2) & 0x1f);
+        gcrCarry = data & 3;
+        break;
+    default:
+        decoded = gcr_nybble((gcrCarry << 3) | (data >> 5)) << 4;
+        decoded |= gcr_nybble(data & 0x1f);
+        break;
+    }
+    if (++gcrPhase == 5)
+        gcrPhase = 0;
+
+    if (gcrState == GCR_HEADER) {
+        gcr_header_byte(decoded);
+        gcrPos++;
+        return 0;
+    }
+
+    if (gcr_data_byte(decoded) != 0)
+        return -1;
+    gcrPos++;
+    return 0;
+}
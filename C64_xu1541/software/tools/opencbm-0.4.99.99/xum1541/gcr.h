@@ -0,0 +1,20 @@
+/*
+ * GCR decoder for nibbler track reads
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+#ifndef _GCR_H
+#define _GCR_H
+
+/*
+ * The decoder only needs usbSendByte() and the record layout from
+ * xum1541_types.h, so it can be built for the host as well and tested
+ * against captured tracks (see opencbm/internal/testsuite).
+ */
+void gcr_decode_init(uint16_t len);
+int8_t gcr_decode_byte(uint8_t data);
+
+#endif // _GCR_H
@@ -69,6 +69,14 @@
 #define XUM_ENDPOINT_BULK_SIZE  32
 #endif
 
+/*
+ * SRAM buffer for data to the host while both banks of the IN endpoint
+ * are still waiting to be collected. Two more packets are enough to ride
+ * out the usual host latency without using too much of the small SRAM
+ * of the AT90USB162. Must be a power of 2 and at most 128.
+ */
+#define XUM_USB_RING_SIZE       (2 * XUM_ENDPOINT_BULK_SIZE)
+
 // Status levels to notify the user (e.g. LEDS)
 #define STATUS_INIT             0
 #define STATUS_CONNECTING       1
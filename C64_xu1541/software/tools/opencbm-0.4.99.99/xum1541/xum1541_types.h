@@ -44,9 +44,11 @@
 #else
 #define XUM1541_CAP_TAP             0
 #endif
+#define XUM1541_CAP_NIB_GCR         0x20 // nibbler reads decoded to sectors
 
 #define XUM1541_CAPABILITIES        (XUM1541_CAP_CBM |      \
                                      XUM1541_CAP_NIB |      \
+                                     XUM1541_CAP_NIB_GCR |  \
                                      XUM1541_CAP_TAP |      \
                                      XUM1541_CAP_IEEE488)
 
@@ -147,6 +149,7 @@
 #define XUM1541_NIB_SRQ_COMMAND     (9 << 4) // Serial commands
 #define XUM1541_TAP                (10 << 4) // tape read/write
 #define XUM1541_TAP_CONFIG         (11 << 4) // tape send/receive configuration
+#define XUM1541_NIB_GCR            (12 << 4) // nibbler read, decoded sectors
 
 // Flags for use with write and XUM1541_CBM protocol
 #define XUM_WRITE_TALK              (1 << 0)
@@ -155,4 +158,25 @@
 // Request an early exit from nib read via burst_read_track_var()
 #define XUM1541_NIB_READ_VAR        0x8000
 
+/*
+ * XUM1541_NIB_GCR reads the given number of raw track bytes like
+ * XUM1541_NIB, but returns one record per sector found instead: the
+ * header fields, the 256 data bytes and a status. The status uses the
+ * error codes of .d64 images. Sectors that are not found (no header or
+ * no data block) have no record. A sector with errors can be returned
+ * again on the next revolution, one that was read ok is not.
+ */
+#define XUM_GCR_TRACK               0
+#define XUM_GCR_SECTOR              1
+#define XUM_GCR_ID2                 2
+#define XUM_GCR_ID1                 3
+#define XUM_GCR_DATA                4
+#define XUM_GCR_STATUS              (XUM_GCR_DATA + 256)
+#define XUM_GCR_SECTOR_SIZE         (XUM_GCR_STATUS + 1)
+
+#define XUM_GCR_OK                  1 // no error
+#define XUM_GCR_DATA_CHECKSUM       5 // "23" checksum error in data block
+#define XUM_GCR_DECODE_ERROR        6 // "24" invalid GCR code in data block
+#define XUM_GCR_HEADER_CHECKSUM     9 // "27" checksum error in header
+
 #endif // _XUM1541_TYPES_H